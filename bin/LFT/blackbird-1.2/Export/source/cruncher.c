@@ -6,10 +6,15 @@
 
 #include <err.h>
 #include <getopt.h>
+#include <pthread.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#endif
 
 #define MAXTLEN 32
 #define MAXSYNC 128
@@ -18,6 +23,12 @@
 #define NINS 48
 #define NFX 48
 
+#define MAXCOPY 10
+#define MAXOFFSET 256
+#define HASHBITS 12
+#define MAXJOBS 6
+#define CACHEMAGIC "BBP1"
+
 struct ext_symbols {
 	uint16_t		seg_play;
 	uint16_t		seg_init;
@@ -100,6 +111,8 @@ struct piece {
 struct decodestate {
 	struct bytebuf		rledata;
 	struct piece		*paths;
+	int			npaths;
+	int			cached;
 	int			rpos, wpos;
 	uint8_t			timer;
 	int			bytes;	// just for the stats
@@ -127,6 +140,10 @@ struct syncpoint syncpoint[MAXSYNC + 1];
 struct stream stream[MAXSYNC];
 int songlen, songloopflag, songloop;
 int verbose = 0;
+int bruteforce = 0;
+int njobs = MAXJOBS;
+char *cachedir = 0;
+pthread_mutex_t cachelock = PTHREAD_MUTEX_INITIALIZER;
 int nsyncpoint, nstream;
 struct bytebuf filtertbl, fxtbl, wavetbl;
 #define FILEORG (0x61e0 - 2)
@@ -364,15 +381,188 @@ void build_voice(struct bytebuf *bb, struct bytebuf *tempobb, int vnum, int star
 	flushpending(bb, &pendnote, &pendwait);
 }
 
-void find_paths(struct decodestate *ds) {
-	int pos, len, offset, bestoffset, bestlength;
-	int transp, gottransp, besttransp, cycles;
-	unsigned int cost, bestcost;
+// Returns how many bytes from pos on can be produced by copying from
+// pos - offset, with the transpose that this takes in *transpp. The copy
+// is limited by the transpose range and by the 229 cycles the playroutine
+// can spend on one copy.
+int match_length(struct bytebuf *rle, int pos, int offset, int *transpp) {
+	int len, transp = 0, gottransp = 0, cycles = 0;
 	uint8_t old, new;
 
-	ds->paths = realloc(ds->paths, (ds->rledata.pos + 1) * sizeof(struct piece));
+	for(len = 0; len < MAXCOPY && pos + len < rle->pos; len++) {
+		old = rle->buf[pos - offset + len];
+		new = rle->buf[pos + len];
+		if(old & 0x80) {
+			if(old != new) break;
+			cycles += 21;
+			if(cycles > 229) break;
+		} else if(new & 0x80) {
+			break;
+		} else if(gottransp) {
+			old += transp * 2;
+			if(old != new) break;
+			cycles += 24;
+			if(cycles > 229) break;
+		} else if((new & 1) == (old & 1)) {
+			transp = (new - old) / 2;
+			if(transp < -15 || transp > 15) break;
+			cycles += 24;
+			if(cycles > 229) break;
+			gottransp = 1;
+		} else {
+			break;
+		}
+	}
+
+	*transpp = transp;
+	return len;
+}
+
+// Hash of the first three bytes at buf, with notes taken relative to the
+// first note among them. Every copy of three bytes or more starts at a
+// position with the same key, whatever its transpose.
+unsigned int match_hash(uint8_t *buf) {
+	uint32_t key = 0;
+	int i, first = -1;
+
+	for(i = 0; i < 3; i++) {
+		key <<= 9;
+		if(buf[i] & 0x80) {
+			key |= 0x100 | buf[i];
+		} else if(first < 0) {
+			first = buf[i];
+			key |= first & 1;
+		} else {
+			key |= (buf[i] - first) & 0xff;
+		}
+	}
+
+	return (key * 2654435761u) >> (32 - HASHBITS);
+}
+
+// The paths of a voice only depend on its RLE data, so they are kept in
+// cachedir under an FNV-1a hash of it. The file holds the RLE data too, to
+// rule out collisions, followed by six bytes per piece.
+void cache_name(char *name, int size, struct bytebuf *rle) {
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	int i;
+
+	for(i = 0; i < rle->pos; i++) {
+		hash ^= rle->buf[i];
+		hash *= 0x100000001b3ULL;
+	}
+	snprintf(name, size, "%s/%016llx.bbp", cachedir, (unsigned long long) hash);
+}
+
+int load_paths(struct decodestate *ds) {
+	char name[1024];
+	uint8_t head[8], *data;
+	int i, n = ds->rledata.pos, ok = 0;
+	FILE *f;
+
+	cache_name(name, sizeof(name), &ds->rledata);
+	f = fopen(name, "rb");
+	if(!f) return 0;
+	if(fread(head, 1, 8, f) == 8
+	&& !memcmp(head, CACHEMAGIC, 4)
+	&& (head[4] | (head[5] << 8) | (head[6] << 16) | (head[7] << 24)) == n) {
+		// Out of memory is a cache miss, the paths are found again
+		data = malloc(n * 7);
+		if(data
+		&& fread(data, 1, n * 7, f) == n * 7
+		&& fgetc(f) == EOF
+		&& !memcmp(data, ds->rledata.buf, n)) {
+			for(i = 0; i < n; i++) {
+				uint8_t *p = data + n + i * 6;
+
+				ds->paths[i].cost = p[0] | (p[1] << 8);
+				ds->paths[i].offset = p[2] | (p[3] << 8);
+				ds->paths[i].length = p[4];
+				ds->paths[i].transp = (int8_t) p[5];
+			}
+			ok = 1;
+		}
+		free(data);
+	}
+	fclose(f);
+
+	return ok;
+}
+
+void store_paths(struct decodestate *ds) {
+	char name[1024], tmpname[1024 + 4];
+	uint8_t *data;
+	int i, n = ds->rledata.pos;
+	FILE *f;
+
+	data = malloc(8 + n * 7);
+	if(!data) return;
+	memcpy(data, CACHEMAGIC, 4);
+	data[4] = n & 0xff;
+	data[5] = (n >> 8) & 0xff;
+	data[6] = (n >> 16) & 0xff;
+	data[7] = (n >> 24) & 0xff;
+	memcpy(data + 8, ds->rledata.buf, n);
+	for(i = 0; i < n; i++) {
+		uint8_t *p = data + 8 + n + i * 6;
+
+		p[0] = ds->paths[i].cost & 0xff;
+		p[1] = ds->paths[i].cost >> 8;
+		p[2] = ds->paths[i].offset & 0xff;
+		p[3] = ds->paths[i].offset >> 8;
+		p[4] = ds->paths[i].length;
+		p[5] = ds->paths[i].transp;
+	}
+
+	// Write to a temporary file and rename it, so that an interrupted
+	// run never leaves half a file behind. Voices with the same data
+	// share a name, hence the lock.
+	cache_name(name, sizeof(name), &ds->rledata);
+	snprintf(tmpname, sizeof(tmpname), "%s.tmp", name);
+	pthread_mutex_lock(&cachelock);
+	f = fopen(tmpname, "wb");
+	if(f) {
+		i = fwrite(data, 1, 8 + n * 7, f) == 8 + n * 7;
+		if(fclose(f)) i = 0;
+		remove(name);
+		if(!i || rename(tmpname, name)) remove(tmpname);
+	}
+	pthread_mutex_unlock(&cachelock);
+	free(data);
+}
+
+void find_paths(struct decodestate *ds) {
+	int pos, len, offset, bestoffset, bestlength;
+	int transp, besttransp, prev;
+	int head[1 << HASHBITS], *chain = 0;
+	unsigned int h, cost, bestcost;
+
+	if(ds->rledata.pos + 1 > ds->npaths) {
+		ds->npaths = ds->rledata.pos + 1;
+		ds->paths = realloc(ds->paths, ds->npaths * sizeof(struct piece));
+		if(!ds->paths) errx(1, "Out of memory (paths, voice %d)", ds->vnum);
+	}
 	ds->paths[ds->rledata.pos].cost = 0;
 	ds->paths[ds->rledata.pos].length = 0;
+
+	ds->cached = cachedir && ds->rledata.pos && load_paths(ds);
+	if(ds->cached) return;
+
+	// Chain every position to the previous one with the same hash, so
+	// that only offsets that can give a copy of three bytes or more are
+	// tried. They come up in order of increasing offset, like in the
+	// brute-force search, and the result is the same.
+	if(!bruteforce && ds->rledata.pos >= 3) {
+		chain = malloc((ds->rledata.pos - 2) * sizeof(int));
+		if(!chain) errx(1, "Out of memory (hash chain, voice %d)", ds->vnum);
+		for(pos = 0; pos < (1 << HASHBITS); pos++) head[pos] = -1;
+		for(pos = 0; pos + 3 <= ds->rledata.pos; pos++) {
+			h = match_hash(ds->rledata.buf + pos);
+			chain[pos] = head[h];
+			head[h] = pos;
+		}
+	}
+
 	for(pos = ds->rledata.pos - 1; pos >= 0; pos--) {
 		bestoffset = 0;
 		bestlength = 1;
@@ -385,34 +575,14 @@ void find_paths(struct decodestate *ds) {
 				bestlength = len;
 			}
 		}
-		for(offset = 1; offset <= 256 && pos - offset >= 0; offset++) {
-			gottransp = 0;
-			transp = 0;
-			cycles = 0;
-			for(len = 0; len < 10 && pos + len < ds->rledata.pos; len++) {
-				old = ds->rledata.buf[pos - offset + len];
-				new = ds->rledata.buf[pos + len];
-				if(old & 0x80) {
-					if(old != new) break;
-					cycles += 21;
-					if(cycles > 229) break;
-				} else if(new & 0x80) {
-					break;
-				} else if(gottransp) {
-					old += transp * 2;
-					if(old != new) break;
-					cycles += 24;
-					if(cycles > 229) break;
-				} else if((new & 1) == (old & 1)) {
-					transp = (new - old) / 2;
-					if(transp < -15 || transp > 15) break;
-					cycles += 24;
-					if(cycles > 229) break;
-					gottransp = 1;
-				} else {
-					break;
-				}
-			}
+		if(bruteforce) {
+			prev = pos - 1;
+		} else {
+			prev = (pos + 3 <= ds->rledata.pos)? chain[pos] : -1;
+		}
+		while(prev >= 0 && pos - prev <= MAXOFFSET) {
+			offset = pos - prev;
+			len = match_length(&ds->rledata, pos, offset, &transp);
 			if(len >= 3) {
 				cost = 2 + ds->paths[pos + len].cost;
 				if(cost < bestcost) {
@@ -422,6 +592,7 @@ void find_paths(struct decodestate *ds) {
 					besttransp = transp;
 				}
 			}
+			prev = bruteforce? prev - 1 : chain[prev];
 		}
 		ds->paths[pos].offset = bestoffset;
 		ds->paths[pos].length = bestlength;
@@ -429,9 +600,58 @@ void find_paths(struct decodestate *ds) {
 		ds->paths[pos].cost = bestcost;
 	}
 
+	free(chain);
+
+	if(cachedir && ds->rledata.pos) store_paths(ds);
+
 	//fprintf(stderr, "%d\n", ds->paths[0].cost);
 }
 
+struct pathjob {
+	struct decodestate	*ds;
+	int			n, first, step;
+};
+
+void *find_paths_job(void *arg) {
+	struct pathjob *job = arg;
+	int i;
+
+	for(i = job->first; i < job->n; i += job->step) {
+		find_paths(&job->ds[i]);
+	}
+
+	return 0;
+}
+
+// The voices are crunched independently of each other, so their paths are
+// found on up to njobs threads. The main thread takes a share as well.
+void find_all_paths(struct decodestate *ds, int n) {
+	pthread_t thread[MAXJOBS];
+	struct pathjob job[MAXJOBS];
+	int i, nthread = (njobs < n)? njobs : n;
+
+	for(i = 0; i < MAXJOBS; i++) {
+		job[i].ds = ds;
+		job[i].n = n;
+		job[i].first = i;
+		job[i].step = nthread;
+	}
+	for(i = 1; i < nthread; i++) {
+		if(pthread_create(&thread[i], 0, find_paths_job, &job[i])) {
+			errx(1, "Unable to create thread");
+		}
+	}
+	find_paths_job(&job[0]);
+	for(i = 1; i < nthread; i++) {
+		pthread_join(thread[i], 0);
+	}
+
+	if(verbose >= 1 && cachedir) {
+		for(i = nthread = 0; i < n; i++) nthread += ds[i].cached;
+		fprintf(stderr, "Paths for %d of %d voices found in cache\n", nthread, n);
+	}
+}
+
 void crunch_some(struct decodestate *ds, struct bytebuf *bb) {
 	int len, i;
 	struct piece *p;
@@ -707,6 +927,11 @@ static void usage(char *prgname) {
 	fprintf(stderr, "  -V --version     Display version information.\n");
 	fprintf(stderr, "\n");
 	fprintf(stderr, "  -v --verbose     Be verbose. Can be specified multiple times.\n");
+	fprintf(stderr, "  -c --cache       Keep crunched voices in this directory, to reuse them when\n");
+	fprintf(stderr, "                   they come up again.\n");
+	fprintf(stderr, "  -j --jobs        Number of voices crunched in parallel. Default: 6\n");
+	fprintf(stderr, "  -B --bruteforce  Try every offset when looking for copies. Same output,\n");
+	fprintf(stderr, "                   only slower; for checking the default search.\n");
 	fprintf(stderr, "\n");
 	fprintf(stderr, "  -o --output      Output filename. Default: a.sid / a.prg\n");
 	fprintf(stderr, "  -t --format      Output format (sid, prg, dist). Default: sid\n");
@@ -753,13 +978,16 @@ int main(int argc, char **argv) {
 		{"unpack", 1, 0, 'u'},
 		{"init", 1, 0, 'i'},
 		{"syncfile", 1, 0, '@'},
+		{"cache", 1, 0, 'c'},
+		{"jobs", 1, 0, 'j'},
+		{"bruteforce", 0, 0, 'B'},
 		{0, 0, 0, 0}
 	};
 	int h, i, j, opt, pos, sz, target, nins = 0, ins_restart[2], nfx = 0, tempopos;
 	uint8_t waveform;
 	uint8_t insref[NINS], fxref[NFX], data[256];
-	struct bytebuf tempodata, streambb[MAXSYNC + 1];
-	struct decodestate vdecode[3];
+	struct bytebuf tempodata, reptempodata, streambb[MAXSYNC + 1];
+	struct decodestate vdecode[6];
 	int currstream;
 	char *prgname = argv[0];
 	char *outname = 0;
@@ -778,7 +1006,7 @@ int main(int argc, char **argv) {
 	struct bytebuf savedrle[2];
 
 	do {
-		opt = getopt_long(argc, argv, "?hVvo:t:a:z:s:NOf:b:r:u:i:@:", longopts, 0);
+		opt = getopt_long(argc, argv, "?hVvo:t:a:z:s:NOf:b:r:u:i:@:c:j:B", longopts, 0);
 		switch(opt) {
 			case 0:
 			case '?':
@@ -847,6 +1075,16 @@ int main(int argc, char **argv) {
 			case '@':
 				loadsyncfile(optarg);
 				break;
+			case 'c':
+				cachedir = strdup(optarg);
+				break;
+			case 'j':
+				njobs = strtol(optarg, 0, 16);
+				if(njobs < 1 || njobs > MAXJOBS) errx(1, "Parameter out of range");
+				break;
+			case 'B':
+				bruteforce = 1;
+				break;
 			default:
 				if(opt >= 0) errx(1, "Unimplemented option '%c'", opt);
 				break;
@@ -855,6 +1093,22 @@ int main(int argc, char **argv) {
 
 	if(optind != argc - 1) usage(prgname);
 
+	if(cachedir) {
+		struct stat st;
+
+		if(stat(cachedir, &st)) {
+#ifdef _WIN32
+			_mkdir(cachedir);
+#else
+			mkdir(cachedir, 0777);
+#endif
+		}
+		if(stat(cachedir, &st) || !S_ISDIR(st.st_mode)) {
+			fprintf(stderr, "Warning: Unable to create cache directory %s, not caching\n", cachedir);
+			cachedir = 0;
+		}
+	}
+
 	loadfile(argv[optind]);
 
 	switch(format) {
@@ -1084,18 +1338,19 @@ int main(int argc, char **argv) {
 		syncpoint[nsyncpoint].flags = SPF_LOOP;
 		nsyncpoint++;
 
-		memset(&tempodata, 0, sizeof(struct bytebuf));
-		tempopos = 0;
+		// The repeating part goes in vdecode[3..5], the part before it in
+		// vdecode[0..2], so that all six get their paths in one go.
+		memset(&reptempodata, 0, sizeof(struct bytebuf));
 		for(i = 0; i < 3; i++) {
-			memset(&vdecode[i], 0, sizeof(struct decodestate));
-			vdecode[i].vnum = i;
-			build_voice(&vdecode[i].rledata, &tempodata, i, songloop, songlen, repeatptr);
+			memset(&vdecode[3 + i], 0, sizeof(struct decodestate));
+			vdecode[3 + i].vnum = i;
+			build_voice(&vdecode[3 + i].rledata, &reptempodata, i, songloop, songlen, repeatptr);
 			if(i < 2) {
-				if(!vdecode[i].rledata.pos) {
-					putbyte(&vdecode[i].rledata, 0xc0);
+				if(!vdecode[3 + i].rledata.pos) {
+					putbyte(&vdecode[3 + i].rledata, 0xc0);
 				}
 				for(j = 0; j < 7; j++) {
-					putbyte(&vdecode[i].rledata, vdecode[i].rledata.buf[j % vdecode[i].rledata.pos]);
+					putbyte(&vdecode[3 + i].rledata, vdecode[3 + i].rledata.buf[j % vdecode[3 + i].rledata.pos]);
 				}
 			}
 		}
@@ -1103,23 +1358,14 @@ int main(int argc, char **argv) {
 		memset(&savedrle, 0, sizeof(savedrle));
 		for(i = 0; i < 2; i++) {
 			for(j = 0; j < 7; j++) {
-				putbyte(&savedrle[i], vdecode[i].rledata.buf[j % vdecode[i].rledata.pos]);
+				putbyte(&savedrle[i], vdecode[3 + i].rledata.buf[j % vdecode[3 + i].rledata.pos]);
 			}
 		}
 
-		for(i = 0; i < 3; i++) {
-			find_paths(&vdecode[i]);
-			vdecode[i].rpos = 0;
-			vdecode[i].wpos = i < 2? 7 : 0;
-		}
-		currstream = 2;
-		crunch_streams(vdecode, streambb, &tempodata, &currstream, &tempopos);
-		if(currstream != 3) errx(1, "Internal error (1)");
-
 		memset(&tempodata, 0, sizeof(struct bytebuf));
-		tempopos = 0;
 		for(i = 0; i < 3; i++) {
-			vdecode[i].rledata.pos = 0;
+			memset(&vdecode[i], 0, sizeof(struct decodestate));
+			vdecode[i].vnum = i;
 			build_voice(&vdecode[i].rledata, &tempodata, i, 0, songloop, 0);
 			if(i < 2) {
 				for(j = 0; j < savedrle[i].pos; j++) {
@@ -1127,11 +1373,24 @@ int main(int argc, char **argv) {
 				}
 			}
 		}
+
+		find_all_paths(vdecode, 6);
+
+		for(i = 0; i < 3; i++) {
+			vdecode[3 + i].rpos = 0;
+			vdecode[3 + i].wpos = i < 2? 7 : 0;
+		}
+		tempopos = 0;
+		currstream = 2;
+		crunch_streams(vdecode + 3, streambb, &reptempodata, &currstream, &tempopos);
+		if(currstream != 3) errx(1, "Internal error (1)");
+
 		for(i = 0; i < 3; i++) {
-			find_paths(&vdecode[i]);
 			vdecode[i].rpos = 0;
 			vdecode[i].wpos = 0;
+			vdecode[i].bytes = vdecode[3 + i].bytes;
 		}
+		tempopos = 0;
 		currstream = 0;
 		crunch_some(&vdecode[1], &streambb[currstream]);
 		crunch_some(&vdecode[0], &streambb[currstream]);
@@ -1164,8 +1423,8 @@ int main(int argc, char **argv) {
 				putbyte(&vdecode[i].rledata, 0xc0);	// will be copied many times for padding
 			}
 		}
+		find_all_paths(vdecode, 3);
 		for(i = 0; i < 3; i++) {
-			find_paths(&vdecode[i]);
 			vdecode[i].rpos = 0;
 			vdecode[i].wpos = 0;
 		}
@@ -0,0 +1,307 @@
+"""Benchmark the native tools on a fixed corpus and compare with a baseline.
+
+Usage:  py -3 pyscript/bench_native.py [options]
+
+  --only core,siddump,...   Benchmarks to run (default: all)
+  --tool NAME=PATH          Binary for a benchmark, e.g. --tool p2s=Release/p2s
+  --corpus DIR              SID files for core, siddump and p2s (default: SID/)
+  --sf2 FILE                SF2 file for sf2pack and sf2export (default: test.sf2)
+  --song FILE               Blackbird song for the cruncher (default: bb.backpack)
+  --repeat N                Runs per benchmark, the best one counts (default: 3)
+  -o FILE                   Write the results as JSON
+  --baseline FILE           Compare with earlier results; exit 1 on a regression
+  --threshold PCT           Allowed slowdown against the baseline (default: 10)
+
+Benchmarks and what they report:
+
+  core       tools/sidbench.exe: 6502 instructions/s and frames/s of play calls
+  siddump    tools/siddump.exe end to end (process, init, 60 s dump) per tune
+  sf2pack    tools/sf2pack/sf2pack.exe packs/s of the SF2 file
+  sf2export  tools/sf2export/sf2export.exe exports/s of the SF2 file
+  p2s        tools/prg2sid p2s -dir identifications/s, on the corpus as PRGs
+  cruncher   Blackbird birdcruncher, RLE bytes crunched/s
+
+A benchmark whose binary is missing or doesn't run is skipped and listed as
+such. The Makefiles' `make bench` targets run their own part of this.
+"""
+import json
+import os
+import platform
+import re
+import subprocess
+import sys
+import tempfile
+import time
+from pathlib import Path
+
+ROOT = Path(__file__).resolve().parent.parent
+EXE = '.exe' if os.name == 'nt' else ''
+
+DEFAULT_TOOLS = {
+    'core': ROOT / 'tools' / 'sidbench.exe',
+    'siddump': ROOT / 'tools' / 'siddump.exe',
+    'sf2pack': ROOT / 'tools' / 'sf2pack' / 'sf2pack.exe',
+    'sf2export': ROOT / 'tools' / 'sf2export' / 'sf2export.exe',
+    'p2s': ROOT / 'tools' / 'prg2sid' / 'Release' / ('p2s' + EXE),
+    'cruncher': (ROOT / 'bin' / 'LFT' / 'blackbird-1.2' / 'Export' / 'win32' / 'birdcruncher.exe'
+                 if os.name == 'nt' else
+                 ROOT / 'bin' / 'LFT' / 'blackbird-1.2' / 'Export' / 'source' / 'birdcruncher'),
+}
+DEFAULT_CORPUS = ROOT / 'SID'
+DEFAULT_SF2 = ROOT / 'test.sf2'
+DEFAULT_SONG = ROOT / 'bin' / 'LFT' / 'blackbird-1.2' / 'Export' / 'dist-example' / 'bb.backpack'
+
+# Metric name -> (unit, True if higher is better)
+METRICS = {
+    'core.instructions_per_sec': ('instr/s', True),
+    'core.frames_per_sec': ('frames/s', True),
+    'siddump.seconds_per_tune': ('s', False),
+    'sf2pack.packs_per_sec': ('packs/s', True),
+    'sf2export.exports_per_sec': ('exports/s', True),
+    'p2s.identifications_per_sec': ('files/s', True),
+    'cruncher.bytes_per_sec': ('bytes/s', True),
+}
+
+SF2_RUNS = 20
+CRUNCH_RUNS = 10
+
+
+class BenchError(Exception):
+    """A benchmark could not run; the message says why."""
+
+
+def _run(cmd, cwd=None):
+    """Run a command, returning (seconds, stdout). Raises BenchError on failure."""
+    start = time.perf_counter()
+    try:
+        result = subprocess.run([str(c) for c in cmd], cwd=cwd, capture_output=True, text=True,
+                                errors='replace', timeout=600)
+    except OSError as e:
+        raise BenchError(f'{cmd[0]}: {e}')
+    except subprocess.TimeoutExpired:
+        raise BenchError(f'{cmd[0]}: timed out')
+    seconds = time.perf_counter() - start
+    if result.returncode != 0:
+        message = (result.stderr or result.stdout).strip().splitlines()
+        raise BenchError(f'{Path(cmd[0]).name} exited with {result.returncode}'
+                         + (f': {message[-1]}' if message else ''))
+    return seconds, result.stdout + result.stderr
+
+
+def _sid_files(corpus):
+    files = sorted(p for p in Path(corpus).iterdir() if p.suffix.lower() == '.sid')
+    if not files:
+        raise BenchError(f'no SID files in {corpus}')
+    return files
+
+
+def bench_core(tool, opts):
+    best = None
+    for _ in range(opts['repeat']):
+        _, out = _run([tool, opts['corpus'], '-json'])
+        result = json.loads(out[out.index('{'):])
+        if best is None or result['seconds'] < best['seconds']:
+            best = result
+    return {'core.instructions_per_sec': best['instructions_per_sec'],
+            'core.frames_per_sec': best['frames_per_sec']}, {
+        'tunes': best['tunes'], 'frames': best['frames'], 'instructions': best['instructions']}
+
+
+def bench_siddump(tool, opts):
+    per_tune = {}
+    with tempfile.TemporaryDirectory() as tmp:
+        for sid in _sid_files(opts['corpus']):
+            out = Path(tmp) / 'dump.txt'
+            times = []
+            for _ in range(opts['repeat']):
+                start = time.perf_counter()
+                with open(out, 'w') as f:
+                    try:
+                        code = subprocess.call([str(tool), str(sid), '-t60'], stdout=f,
+                                               stderr=subprocess.DEVNULL)
+                    except OSError as e:
+                        raise BenchError(f'{tool}: {e}')
+                times.append(time.perf_counter() - start)
+                if code != 0:
+                    break
+            if code == 0:
+                per_tune[sid.name] = min(times)
+    if not per_tune:
+        raise BenchError('siddump failed on every tune')
+    return {'siddump.seconds_per_tune': sum(per_tune.values()) / len(per_tune)}, {
+        'tunes': len(per_tune), 'per_tune': per_tune}
+
+
+def _bench_sf2(tool, opts, metric):
+    if not Path(opts['sf2']).exists():
+        raise BenchError(f'{opts["sf2"]} not found')
+    best = None
+    with tempfile.TemporaryDirectory() as tmp:
+        for _ in range(opts['repeat']):
+            start = time.perf_counter()
+            for _ in range(SF2_RUNS):
+                _run([tool, opts['sf2'], Path(tmp) / 'out.sid'])
+            seconds = time.perf_counter() - start
+            best = seconds if best is None else min(best, seconds)
+    return {metric: SF2_RUNS / best}, {'runs': SF2_RUNS}
+
+
+def bench_sf2pack(tool, opts):
+    return _bench_sf2(tool, opts, 'sf2pack.packs_per_sec')
+
+
+def bench_sf2export(tool, opts):
+    return _bench_sf2(tool, opts, 'sf2export.exports_per_sec')
+
+
+def bench_p2s(tool, opts):
+    """p2s takes PRGs: the payload of every corpus SID, with its load address."""
+    with tempfile.TemporaryDirectory() as tmp:
+        count = 0
+        for sid in _sid_files(opts['corpus']):
+            data = sid.read_bytes()
+            if len(data) < 0x7c or data[:4] not in (b'PSID', b'RSID'):
+                continue
+            offset = int.from_bytes(data[6:8], 'big')
+            load = int.from_bytes(data[8:10], 'big')
+            payload = data[offset:] if load == 0 else load.to_bytes(2, 'little') + data[offset:]
+            (Path(tmp) / (sid.stem + '.prg')).write_bytes(payload)
+            count += 1
+        if not count:
+            raise BenchError(f'no PSID/RSID files in {opts["corpus"]}')
+        best = None
+        for _ in range(opts['repeat']):
+            seconds, _ = _run([tool, '-dir', tmp, '1'])
+            best = seconds if best is None else min(best, seconds)
+    return {'p2s.identifications_per_sec': count / best}, {'files': count}
+
+
+def parse_cruncher_bytes(text):
+    """RLE bytes of all voices from birdcruncher -v ('Voice 1 packed 6655 -> 3087 (46%)')."""
+    return sum(int(m) for m in re.findall(r'^Voice \d+ packed (\d+) ->', text, re.M))
+
+
+def bench_cruncher(tool, opts):
+    if not Path(opts['song']).exists():
+        raise BenchError(f'{opts["song"]} not found')
+    best = None
+    with tempfile.TemporaryDirectory() as tmp:
+        for _ in range(opts['repeat']):
+            start = time.perf_counter()
+            for _ in range(CRUNCH_RUNS):
+                _, out = _run([tool, '-v', '-o', Path(tmp) / 'out.sid', opts['song']])
+            seconds = time.perf_counter() - start
+            best = seconds if best is None else min(best, seconds)
+    size = parse_cruncher_bytes(out)
+    if not size:
+        raise BenchError('no voice sizes in the cruncher output')
+    return {'cruncher.bytes_per_sec': size * CRUNCH_RUNS / best}, {'rle_bytes': size}
+
+
+BENCHMARKS = {
+    'core': bench_core,
+    'siddump': bench_siddump,
+    'sf2pack': bench_sf2pack,
+    'sf2export': bench_sf2export,
+    'p2s': bench_p2s,
+    'cruncher': bench_cruncher,
+}
+
+
+def run_benchmarks(names, tools, opts, log=print):
+    """Run the named benchmarks. Returns the results document."""
+    results = {'version': 1,
+               'time': time.strftime('%Y-%m-%dT%H:%M:%S'),
+               'host': {'platform': platform.platform(), 'machine': platform.machine(),
+                        'cpus': os.cpu_count()},
+               'metrics': {}, 'details': {}, 'skipped': {}}
+    for name in names:
+        tool = Path(tools[name])
+        if not tool.exists():
+            results['skipped'][name] = f'{tool} not found'
+            log(f'{name:10s} skipped: {tool} not found')
+            continue
+        try:
+            metrics, details = BENCHMARKS[name](tool, opts)
+        except BenchError as e:
+            results['skipped'][name] = str(e)
+            log(f'{name:10s} skipped: {e}')
+            continue
+        results['metrics'].update(metrics)
+        results['details'][name] = details
+        for metric, value in metrics.items():
+            log(f'{metric:30s} {value:16.6g} {METRICS[metric][0]}')
+    return results
+
+
+def compare(current, baseline, threshold):
+    """Compare two results documents metric by metric.
+
+    Returns a list of (metric, baseline, current, change_percent, status) with
+    status 'regression', 'improved' or 'ok'. change_percent is positive when
+    the current run is better, whichever direction that is for the metric.
+    """
+    rows = []
+    for metric, base in sorted(baseline.get('metrics', {}).items()):
+        value = current.get('metrics', {}).get(metric)
+        if value is None or not base or metric not in METRICS:
+            continue
+        higher_better = METRICS[metric][1]
+        change = (value - base) / base * 100.0
+        if not higher_better:
+            change = -change
+        if change < -threshold:
+            status = 'regression'
+        elif change > threshold:
+            status = 'improved'
+        else:
+            status = 'ok'
+        rows.append((metric, base, value, change, status))
+    return rows
+
+
+def main(argv):
+    import argparse
+
+    parser = argparse.ArgumentParser(description='Benchmark the native tools.')
+    parser.add_argument('--only', default=','.join(BENCHMARKS))
+    parser.add_argument('--tool', action='append', default=[])
+    parser.add_argument('--corpus', default=str(DEFAULT_CORPUS))
+    parser.add_argument('--sf2', default=str(DEFAULT_SF2))
+    parser.add_argument('--song', default=str(DEFAULT_SONG))
+    parser.add_argument('--repeat', type=int, default=3)
+    parser.add_argument('-o', '--output')
+    parser.add_argument('--baseline')
+    parser.add_argument('--threshold', type=float, default=10.0)
+    args = parser.parse_args(argv)
+
+    names = [n.strip() for n in args.only.split(',') if n.strip()]
+    for name in names:
+        if name not in BENCHMARKS:
+            parser.error(f'unknown benchmark {name!r} (have: {", ".join(BENCHMARKS)})')
+    tools = dict(DEFAULT_TOOLS)
+    for spec in args.tool:
+        name, _, path = spec.partition('=')
+        if name not in BENCHMARKS or not path:
+            parser.error(f'--tool wants NAME=PATH, got {spec!r}')
+        tools[name] = Path(path).resolve()
+    opts = {'corpus': Path(args.corpus).resolve(), 'sf2': Path(args.sf2).resolve(),
+            'song': Path(args.song).resolve(), 'repeat': max(1, args.repeat)}
+
+    results = run_benchmarks(names, tools, opts)
+    if args.output:
+        Path(args.output).write_text(json.dumps(results, indent=2) + '\n')
+
+    if not args.baseline:
+        return 0
+    baseline = json.loads(Path(args.baseline).read_text())
+    rows = compare(results, baseline, args.threshold)
+    print(f'\nAgainst {args.baseline} (threshold {args.threshold:g}%):')
+    for metric, base, value, change, status in rows:
+        flag = {'regression': 'REGRESSION', 'improved': 'improved', 'ok': ''}[status]
+        print(f'{metric:30s} {base:14.6g} -> {value:14.6g} {change:+7.1f}%  {flag}')
+    return 1 if any(row[4] == 'regression' for row in rows) else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv[1:]))
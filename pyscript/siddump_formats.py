@@ -0,0 +1,85 @@
+"""Shared fixtures for the siddump binary output tests.
+
+The layouts are defined in tools/dumpformat.h. The format tests run a siddump
+built by `make` in tools/ on a tune from SID/ and check the readers against
+what it really writes, and skip when siddump isn't built for this platform.
+pack() builds a file by hand for what a real run can't show, such as an event
+stream written by a tool that was killed before it patched in the counts.
+"""
+import struct
+import subprocess
+from pathlib import Path
+
+import pytest
+
+ROOT = Path(__file__).resolve().parent.parent
+SIDDUMP = ROOT / 'tools' / 'siddump.exe'
+SID_FILE = ROOT / 'SID' / 'Hubbard_Rob' / 'Commando.sid'
+
+# Header and record layouts, by magic
+HEADERS = {
+    b'SDMP': '<4sHHHHHHHHIII',
+    b'STRC': '<4sHHHHHHIIII',
+    b'SWRS': '<4sHHHHIIIII',
+    b'SCOV': '<4sHHIIHHIII',
+    b'SNEV': '<4sHHHHIIIHHI',
+}
+RECORDS = {
+    b'SDMP': '<I25s3x',
+    b'STRC': '<IHHBBxx',
+    b'SWRS': '<IBBxx',
+    b'SNEV': '<IBBBBHHHxx',
+}
+
+
+def _siddump_runs():
+    try:
+        return subprocess.run([str(SIDDUMP)], capture_output=True, timeout=10).returncode == 1
+    except (OSError, subprocess.TimeoutExpired):
+        return False
+
+
+needs_siddump = pytest.mark.skipif(not _siddump_runs(),
+                                   reason='tools/siddump.exe not built for this platform')
+
+
+def run_siddump(*options, seconds=2, sid_file=SID_FILE) -> bytes:
+    """stdout of siddump on sid_file, which must succeed."""
+    result = subprocess.run([str(SIDDUMP), str(sid_file), f'-t{seconds}', *options],
+                            capture_output=True, timeout=60)
+    assert result.returncode == 0, result.stderr.decode(errors='replace')
+    return result.stdout
+
+
+def siddump_file(tmp_path, option, *options, seconds=2) -> bytes:
+    """Contents of the file siddump writes for `option` (e.g. '-notes')."""
+    path = tmp_path / 'siddump.out'
+    run_siddump(f'{option}={path}', *options, seconds=seconds)
+    return path.read_bytes()
+
+
+def pack(header, records=()) -> bytes:
+    """A file from its header fields (magic first) and record tuples."""
+    magic = header[0]
+    data = struct.pack(HEADERS[magic], *header)
+    for record in records:
+        data += struct.pack(RECORDS[magic], *record)
+    return data
+
+
+def set_header_field(data: bytes, index: int, value: int) -> bytes:
+    """data with header field `index` (0 = magic) replaced, as a count left unpatched."""
+    layout = HEADERS[data[:4]]
+    fields = list(struct.unpack_from(layout, data, 0))
+    fields[index] = value
+    return struct.pack(layout, *fields) + data[struct.calcsize(layout):]
+
+
+def psid_addresses(sid_file=SID_FILE):
+    """(load, init, play) from a PSID header, the load address from the data if 0."""
+    data = Path(sid_file).read_bytes()
+    load, init, play = struct.unpack_from('>HHH', data, 8)
+    if load == 0:
+        offset = struct.unpack_from('>H', data, 6)[0]
+        load = data[offset] | (data[offset + 1] << 8)
+    return load, init, play
@@ -0,0 +1,44 @@
+"""Print a siddump -tracebin memory access trace as text.
+
+Usage:  py -3 pyscript/siddump_trace_decode.py <file.trc> [frame_start [frame_end]]
+
+One line per access:  F0012 PC:10A1 R [18F3]=80   (frame INIT = initroutine)
+"""
+import os
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+from sidm2.siddump import read_binary_trace, TRACE_WRITE, TRACE_INIT_FRAME
+
+
+def format_record(record):
+    frame, pc, address, value, flags = record
+    frame_text = 'INIT ' if frame == TRACE_INIT_FRAME else f'F{frame:04d}'
+    kind = 'W' if flags & TRACE_WRITE else 'R'
+    return f'{frame_text} PC:{pc:04X} {kind} [{address:04X}]={value:02X}'
+
+
+def main(argv):
+    if not argv:
+        print(__doc__)
+        return 1
+    trace = read_binary_trace(argv[0])
+    if trace is None:
+        print(f'{argv[0]}: not a siddump binary trace')
+        return 1
+    frame_start = int(argv[1]) if len(argv) > 1 else None
+    frame_end = int(argv[2]) if len(argv) > 2 else frame_start
+
+    print(f'Window ${trace["window_start"]:04X}-${trace["window_end"]:04X}, '
+          f'subtune {trace["subtune"]}, {len(trace["records"])} accesses')
+    for record in trace['records']:
+        frame = record[0]
+        if frame_start is not None:
+            if frame == TRACE_INIT_FRAME or not frame_start <= frame <= frame_end:
+                continue
+        print(format_record(record))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv[1:]))
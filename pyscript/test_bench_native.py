@@ -0,0 +1,82 @@
+"""Tests for the native benchmark harness (pyscript/bench_native.py).
+
+The sidbench test needs tools/sidbench.exe, built by `make` in tools/, and is
+skipped without it.
+"""
+import json
+import os
+import sys
+from pathlib import Path
+
+import pytest
+
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+from pyscript.bench_native import (DEFAULT_TOOLS, compare, main, parse_cruncher_bytes,
+                                   run_benchmarks)
+
+ROOT = Path(__file__).resolve().parent.parent
+SIDBENCH = DEFAULT_TOOLS['core']
+STINSEN = ROOT / 'tools' / 'Stinsens_Last_Night_of_89.sid'
+
+
+def _results(**metrics):
+    return {'metrics': metrics}
+
+
+def test_compare_flags_slowdowns_either_direction():
+    baseline = _results(**{'core.instructions_per_sec': 100e6, 'siddump.seconds_per_tune': 0.5,
+                           'p2s.identifications_per_sec': 1000.0})
+    current = _results(**{'core.instructions_per_sec': 80e6, 'siddump.seconds_per_tune': 0.4,
+                          'p2s.identifications_per_sec': 1050.0})
+    rows = {row[0]: row for row in compare(current, baseline, 10)}
+    assert rows['core.instructions_per_sec'][4] == 'regression'
+    assert rows['core.instructions_per_sec'][3] == pytest.approx(-20)
+    # Lower is better for times: 0.5 s -> 0.4 s is 20% better
+    assert rows['siddump.seconds_per_tune'][4] == 'improved'
+    assert rows['siddump.seconds_per_tune'][3] == pytest.approx(20)
+    assert rows['p2s.identifications_per_sec'][4] == 'ok'
+
+
+def test_compare_skips_metrics_not_in_both():
+    baseline = _results(**{'sf2pack.packs_per_sec': 400.0, 'unknown.metric': 1.0})
+    assert compare(_results(), baseline, 10) == []
+    assert compare(_results(**{'unknown.metric': 0.1}), baseline, 10) == []
+
+
+def test_parse_cruncher_bytes():
+    text = ('Filter 12, wave 40, fx 3, total 55\n'
+            'Voice 1 packed 6655 -> 3087 (46%)\n'
+            'Voice 2 packed 4043 -> 2019 (49%)\n'
+            'Voice 3 packed 3435 -> 2237 (65%)\n')
+    assert parse_cruncher_bytes(text) == 6655 + 4043 + 3435
+    assert parse_cruncher_bytes('') == 0
+
+
+def test_missing_tool_is_skipped(tmp_path):
+    tools = {'sf2pack': tmp_path / 'nothing.exe'}
+    results = run_benchmarks(['sf2pack'], tools, {'repeat': 1}, log=lambda line: None)
+    assert results['metrics'] == {}
+    assert 'not found' in results['skipped']['sf2pack']
+
+
+def test_baseline_regression_sets_exit_code(tmp_path):
+    baseline = tmp_path / 'base.json'
+    baseline.write_text(json.dumps(_results(**{'sf2pack.packs_per_sec': 1e12})))
+    # Nothing runs (the tool is missing), so nothing can regress
+    assert main(['--only', 'sf2pack', '--tool', f'sf2pack={tmp_path / "none"}',
+                 '--baseline', str(baseline)]) == 0
+
+
+@pytest.mark.skipif(not SIDBENCH.exists(), reason='tools/sidbench.exe not built')
+def test_core_benchmark(tmp_path):
+    corpus = tmp_path / 'corpus'
+    corpus.mkdir()
+    (corpus / 'tune.sid').write_bytes(STINSEN.read_bytes())
+    out = tmp_path / 'results.json'
+    assert main(['--only', 'core', '--corpus', str(corpus), '--repeat', '1', '-o', str(out)]) == 0
+    results = json.loads(out.read_text())
+    assert results['details']['core']['tunes'] == 1
+    assert results['details']['core']['frames'] == 3000
+    assert results['metrics']['core.instructions_per_sec'] > 0
+    assert main(['--only', 'core', '--corpus', str(corpus), '--repeat', '1',
+                 '--baseline', str(out), '--threshold', '1000']) == 0
@@ -0,0 +1,124 @@
+"""Tests for the native tool service clients (sidm2/native_service.py).
+
+The client is tested against a stand-in server written in Python. The
+siddump test needs a siddump built by `make` in tools/ that runs here and is
+skipped otherwise.
+"""
+import os
+import subprocess
+import sys
+from pathlib import Path
+
+import pytest
+
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+from sidm2.native_service import (DEFAULT_SIDDUMP, NativeService, NativeServiceError,
+                                  SiddumpService)
+
+ROOT = Path(__file__).resolve().parent.parent
+STINSEN = ROOT / 'tools' / 'Stinsens_Last_Night_of_89.sid'
+
+FAKE_SERVER = '''
+import json, sys
+for line in sys.stdin:
+    req = json.loads(line)
+    if req['cmd'] == 'quit':
+        print(json.dumps({'id': req['id'], 'ok': True}), flush=True)
+        break
+    if req['cmd'] == 'frames':
+        reply = {'id': req['id'], 'ok': True, 'frame': req.get('frame', 0),
+                 'regs': ['%02x' % n * 25 for n in range(req['count'])],
+                 'cycles': [1000 + n for n in range(req['count'])]}
+    elif req['cmd'] == 'crash':
+        sys.exit(3)
+    else:
+        reply = {'id': req['id'], 'ok': False, 'error': 'Unknown cmd ' + req['cmd']}
+    print(json.dumps(reply), flush=True)
+'''
+
+
+def _siddump_runs():
+    try:
+        return subprocess.run([str(DEFAULT_SIDDUMP)], capture_output=True, timeout=10).returncode == 1
+    except (OSError, subprocess.TimeoutExpired):
+        return False
+
+
+def _fake_server(tmp_path):
+    script = tmp_path / 'server.py'
+    script.write_text(FAKE_SERVER)
+    return [sys.executable, str(script)]
+
+
+def test_frames_reply_is_decoded(tmp_path):
+    fake_server = _fake_server(tmp_path)
+    service = SiddumpService.__new__(SiddumpService)
+    NativeService.__init__(service, fake_server)
+    with service:
+        regs, cycles = service.frames(3, frame=100)
+        assert regs == [bytes([n]) * 25 for n in range(3)]
+        assert cycles == [1000, 1001, 1002]
+
+
+def test_error_reply_raises(tmp_path):
+    fake_server = _fake_server(tmp_path)
+    with NativeService(fake_server) as service:
+        with pytest.raises(NativeServiceError, match='Unknown cmd seek'):
+            service.request('seek', frame=3)
+        # The channel stays usable after an error
+        assert service.request('frames', count=1)['cycles'] == [1000]
+
+
+def test_dead_service_raises(tmp_path):
+    fake_server = _fake_server(tmp_path)
+    with NativeService(fake_server) as service:
+        with pytest.raises(NativeServiceError, match='exited'):
+            service.request('crash')
+
+
+@pytest.mark.skipif(not _siddump_runs(), reason='tools/siddump.exe not built for this platform')
+def test_siddump_seek_matches_straight_playback():
+    with SiddumpService() as service:
+        info = service.load(STINSEN)
+        assert info['playaddress'] == 0x1006
+        straight, _ = service.frames(600)
+        # Back to an earlier frame, through a checkpoint
+        regs, cycles = service.frames(20, frame=510)
+        assert regs == straight[510:530]
+        assert all(cycles)
+        assert service.load(STINSEN)['cached'] is True
+        assert service.peek(0xd418) == straight[529][24:25]
+
+
+@pytest.mark.skipif(not _siddump_runs(), reason='tools/siddump.exe not built for this platform')
+def test_siddump_replies_are_valid_json():
+    import json
+    lines = ['{"id": ab"c, "cmd": "quit"}',            # Not a JSON value: parse error
+             '{"id": 01, "cmd": "quit"}',
+             '{"id": [1], "cmd": "quit"}',
+             '{"id": 7, "cmd": "a\\tb\\rc\\u0001"}',  # Control characters echoed escaped
+             '{"id": -2.5e1, "cmd": "quit"}']
+    result = subprocess.run([str(DEFAULT_SIDDUMP), '-serve'], input='\n'.join(lines) + '\n',
+                            capture_output=True, text=True, timeout=10)
+    replies = [json.loads(line) for line in result.stdout.splitlines()]
+    assert replies[:3] == [{'ok': False, 'error': 'Malformed request'}] * 3
+    assert replies[3] == {'id': 7, 'ok': False, 'error': 'Unknown cmd a\tb\rc\x01'}
+    assert replies[4] == {'id': -25.0, 'ok': True}
+
+
+@pytest.mark.skipif(not _siddump_runs(), reason='tools/siddump.exe not built for this platform')
+def test_siddump_rejects_bad_fields():
+    with SiddumpService() as service:
+        songs = service.load(STINSEN)['songs']
+        with pytest.raises(NativeServiceError, match=f'subtune must be 0-{songs - 1}'):
+            service.load(STINSEN, subtune=songs)
+        with pytest.raises(NativeServiceError, match='subtune must not be negative'):
+            service.load(STINSEN, subtune=-5)
+        with pytest.raises(NativeServiceError, match='frame must be an integer'):
+            service.frames(1, frame=1.5)
+        with pytest.raises(NativeServiceError, match='frame must be an integer'):
+            service.request('seek', frame=True)
+        with pytest.raises(NativeServiceError, match='frame must be 0-30000'):
+            service.seek(30001)
+        # Nothing above moved the play position
+        assert service.frames(1)[0] == service.frames(1, frame=0)[0]
@@ -0,0 +1,66 @@
+"""Tests for the sidcompare path of the accuracy check (sidm2/accuracy.py).
+
+Two tiny PSIDs are played by tools/sidcompare: the play call counts up
+$D400, and the divergent tune also copies the count to $D401 from the
+eleventh call on. The tests skip when sidcompare isn't built by `make` in
+tools/ for this platform.
+"""
+import os
+import struct
+import subprocess
+import sys
+
+import pytest
+
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+from sidm2.accuracy import SIDCOMPARE_EXE, calculate_accuracy_from_sids, compare_with_sidcompare
+
+# init: RTS; play: INC $D400 (then the divergent part), RTS
+COUNTER = bytes([0x60, 0xEE, 0x00, 0xD4, 0x60])
+# play: INC $D400, LDA $D400, CMP #11, BCC +3, STA $D401, RTS
+DIVERGENT = bytes([0x60, 0xEE, 0x00, 0xD4, 0xAD, 0x00, 0xD4, 0xC9, 0x0B, 0x90, 0x03,
+                   0x8D, 0x01, 0xD4, 0x60])
+
+
+def _sidcompare_runs():
+    try:
+        return subprocess.run([str(SIDCOMPARE_EXE)], capture_output=True, timeout=10).returncode == 2
+    except (OSError, subprocess.TimeoutExpired):
+        return False
+
+
+needs_sidcompare = pytest.mark.skipif(not _sidcompare_runs(),
+                                      reason='tools/sidcompare.exe not built for this platform')
+
+
+def _psid(path, code):
+    # Header v2: load $1000 (from the header), init $1000, play $1001, one song
+    header = struct.pack('>4sHHHHHHHI', b'PSID', 2, 0x7C, 0x1000, 0x1000, 0x1001, 1, 1, 0)
+    path.write_bytes(header.ljust(0x7C, b'\0') + code)
+    return str(path)
+
+
+@needs_sidcompare
+def test_identical_tunes(tmp_path):
+    a = _psid(tmp_path / 'a.sid', COUNTER)
+    b = _psid(tmp_path / 'b.sid', COUNTER)
+    result = compare_with_sidcompare(a, b, duration=1)
+    assert result['frames'] == 50
+    assert result['first_diff'] == -1
+    assert result['register_mismatches'] == [0] * 25
+    assert result['frame_accuracy'] == result['overall_accuracy'] == 100.0
+
+
+@needs_sidcompare
+def test_divergent_tunes(tmp_path):
+    a = _psid(tmp_path / 'a.sid', COUNTER)
+    b = _psid(tmp_path / 'b.sid', DIVERGENT)
+    result = calculate_accuracy_from_sids(a, b, duration=1)
+    # Call 11 (frame 10) is the first to write $D401
+    assert result['first_diff'] == 10
+    assert result['register_mismatches'] == [0, 40] + [0] * 23
+    assert result['frame_accuracy'] == 20.0
+    assert result['voice_accuracy']['voice1'] == {'frequency': 20.0, 'waveform': 100.0}
+    assert result['register_accuracy']['Voice1_FreqHi'] == 20.0
+    assert result['register_accuracy']['Voice1_FreqLo'] == 100.0
+    assert result['filter_accuracy'] == 100.0
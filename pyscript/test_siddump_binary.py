@@ -0,0 +1,83 @@
+"""Tests for the siddump -b binary frame dump reader.
+
+Checked against a real dump (pyscript/siddump_formats.py): a 32-byte "SDMP"
+header followed by one 32-byte record per frame (uint32 cycles, 25 raw
+$D400-$D418 bytes, 3 pad), see tools/dumpformat.h.
+"""
+import os
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+from sidm2.siddump import read_binary_dump, is_binary_dump
+from sidm2.accuracy import SIDRegisterCapture
+from pyscript.siddump_formats import (needs_siddump, run_siddump, set_header_field,
+                                      psid_addresses)
+
+
+@needs_siddump
+def test_header_matches_the_sid_file():
+    dump = read_binary_dump(run_siddump('-b'))
+    load, init, play = psid_addresses()
+    assert (dump['load_address'], dump['init_address']) == (load, init)
+    if play:
+        assert dump['play_address'] == play
+    assert dump['subtune'] == 0
+    assert dump['first_frame'] == 0
+    assert len(dump['frames']) == 100
+    assert all(cycles > 0 and len(regs) == 25 for cycles, regs in dump['frames'])
+
+
+@needs_siddump
+def test_registers_match_the_text_table():
+    regs = read_binary_dump(run_siddump('-b'))['frames'][0][1]
+    # Frame 0 of the table shows every value
+    row = next(line for line in run_siddump().decode().splitlines() if line.startswith('|     0 |'))
+    columns = row.split('|')
+    for voice in range(3):
+        fields = columns[voice + 2].split()
+        base = voice * 7
+        assert int(fields[0], 16) == regs[base] | (regs[base + 1] << 8)
+        assert int(fields[-3], 16) == regs[base + 4]
+        assert int(fields[-2], 16) == (regs[base + 5] << 8) | regs[base + 6]
+        assert int(fields[-1], 16) == (regs[base + 2] | (regs[base + 3] << 8)) & 0xFFF
+    assert int(columns[5].split()[0], 16) == (regs[0x15] << 5) | (regs[0x16] << 8)
+
+
+@needs_siddump
+def test_first_frame_skips_ahead():
+    full = read_binary_dump(run_siddump('-b', seconds=3))
+    dump = read_binary_dump(run_siddump('-b', '-f25'))
+    assert dump['first_frame'] == 25
+    assert dump['frames'] == full['frames'][25:125]
+
+
+@needs_siddump
+def test_truncated_dump_uses_file_size():
+    data = run_siddump('-b')
+    # Three records left, the header still says 100
+    assert len(read_binary_dump(data[:32 + 3 * 32])['frames']) == 3
+    assert len(read_binary_dump(set_header_field(data, 10, 1000))['frames']) == 100
+
+
+@needs_siddump
+def test_rejects_text_dump():
+    text = run_siddump()
+    assert not is_binary_dump(text)
+    assert read_binary_dump(text) is None
+
+
+@needs_siddump
+def test_capture_reports_changed_registers(tmp_path):
+    data = run_siddump('-b')
+    frames = [regs for _, regs in read_binary_dump(data)['frames']]
+    path = tmp_path / 'tune.sdb'
+    path.write_bytes(data)
+
+    capture = SIDRegisterCapture()
+    assert capture.capture_from_file(str(path))
+    assert capture.stats['total_frames'] == 100
+    assert len(capture.frames[0]) == 25
+    for index in range(1, 100):
+        changed = {reg: frames[index][reg] for reg in range(25)
+                   if frames[index][reg] != frames[index - 1][reg]}
+        assert capture.frames[index] == changed
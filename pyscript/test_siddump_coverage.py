@@ -0,0 +1,108 @@
+"""Tests for the siddump -coverage bitmap reader and the coverage table finder.
+
+Checked against real coverage (pyscript/siddump_formats.py): a 32-byte "SCOV"
+header, 65536 uint32 first-touch frames, then snapshots of two uint32 frames
+and three 8 KB bitmaps (exec, read, write), see tools/dumpformat.h.
+"""
+import os
+import struct
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+from sidm2.siddump import (read_coverage, read_binary_trace, coverage_addresses,
+                           COVERAGE_NEVER, COVERAGE_INIT_FRAME, TRACE_READ, TRACE_INIT_FRAME)
+from sidm2.disasm_table_finder import find_tables_in_coverage
+from pyscript.siddump_formats import (needs_siddump, run_siddump, set_header_field, pack,
+                                      psid_addresses)
+
+SNAPSHOT_SIZE = 8 + 3 * 8192
+
+
+def _coverage_and_trace(tmp_path):
+    coverage_path = tmp_path / 'tune.scov'
+    trace_path = tmp_path / 'tune.strc'
+    run_siddump(f'-coverage={coverage_path}', '-coverageinterval=50', f'-tracebin={trace_path}')
+    return coverage_path.read_bytes(), read_binary_trace(trace_path.read_bytes())['records']
+
+
+@needs_siddump
+def test_snapshots_cover_init_and_each_interval(tmp_path):
+    coverage = read_coverage(_coverage_and_trace(tmp_path)[0])
+    assert coverage['subtune'] == 0
+    assert coverage['interval'] == 50
+    assert [(s['first_frame'], s['last_frame']) for s in coverage['snapshots']] == [
+        (COVERAGE_INIT_FRAME, COVERAGE_INIT_FRAME), (0, 49), (50, 99)]
+    _, init, play = psid_addresses()
+    init_snapshot, *play_snapshots = coverage['snapshots']
+    assert init in coverage_addresses(init_snapshot['exec'])
+    if play:
+        assert all(play in coverage_addresses(s['exec']) for s in play_snapshots)
+
+
+@needs_siddump
+def test_reads_writes_and_first_touch_match_the_trace(tmp_path):
+    data, records = _coverage_and_trace(tmp_path)
+    coverage = read_coverage(data)
+    for snapshot in coverage['snapshots']:
+        first, last = snapshot['first_frame'], snapshot['last_frame']
+        if first == COVERAGE_INIT_FRAME:
+            accesses = [r for r in records if r[0] == TRACE_INIT_FRAME]
+        else:
+            accesses = [r for r in records if first <= r[0] <= last]
+        assert coverage_addresses(snapshot['read']) == sorted(
+            {address for _, _, address, _, flags in accesses if flags == TRACE_READ})
+        assert coverage_addresses(snapshot['write']) == sorted(
+            {address for _, _, address, _, flags in accesses if flags != TRACE_READ})
+
+    # Executing an address touches it too, so first touch can be earlier
+    # than the first traced data access, never later
+    first_touch = coverage['first_touch']
+    for frame, _, address, _, _ in records:
+        if frame == TRACE_INIT_FRAME:
+            assert first_touch[address] == COVERAGE_INIT_FRAME
+        else:
+            assert first_touch[address] == COVERAGE_INIT_FRAME or first_touch[address] <= frame
+
+
+@needs_siddump
+def test_unpatched_count_uses_file_size(tmp_path):
+    data = _coverage_and_trace(tmp_path)[0]
+    assert len(read_coverage(set_header_field(data, 7, 0))['snapshots']) == 3
+    assert len(read_coverage(set_header_field(data, 7, 9))['snapshots']) == 3
+    assert len(read_coverage(data[:-SNAPSHOT_SIZE])['snapshots']) == 2
+
+
+@needs_siddump
+def test_rejects_other_formats():
+    assert read_coverage(run_siddump('-b')) is None
+    assert read_coverage(b'SCOV' + bytes(28)) is None
+
+
+def _bitmap(addresses):
+    bitmap = bytearray(8192)
+    for address in addresses:
+        bitmap[address >> 3] |= 1 << (address & 7)
+    return bytes(bitmap)
+
+
+def _make_coverage(snapshots):
+    """snapshots: (first_frame, last_frame, exec, read, write) address lists"""
+    data = pack((b'SCOV', 1, 32, SNAPSHOT_SIZE, 10, 1, 0, len(snapshots), 32 + 0x10000 * 4, 0))
+    data += struct.pack('<65536I', *([COVERAGE_NEVER] * 0x10000))
+    for first, last, exec_, read, write in snapshots:
+        data += struct.pack('<II', first, last) + _bitmap(exec_) + _bitmap(read) + _bitmap(write)
+    return data
+
+
+def test_tables_are_read_only_data():
+    code = list(range(0x1000, 0x1040))
+    table = list(range(0x1900, 0x1910))
+    variables = [0x1a00, 0x1a01]
+    coverage = read_coverage(_make_coverage(
+        [(COVERAGE_INIT_FRAME, COVERAGE_INIT_FRAME, [], [0x3000], []),
+         (0, 9, code, code[:4] + table + variables + [0x00fb, 0x01f0, 0xd41b], variables + [0x01f0]),
+         (10, 19, code, [0x1920], [])]))
+    tables = find_tables_in_coverage(coverage, max_gap=32)
+    # Code, written variables, zero page, stack, I/O and init-only reads are left out
+    assert list(tables.values()) == [(0x1900, 0x1920, 0x21)]
+    assert (0x3000, 0x3000, 1) in find_tables_in_coverage(coverage, include_init=True).values()
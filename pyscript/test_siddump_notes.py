@@ -0,0 +1,83 @@
+"""Tests for the siddump -notes note event reader.
+
+Checked against real events (pyscript/siddump_formats.py): a 32-byte "SNEV"
+header followed by one 16-byte record per event (uint32 frame, voice, type,
+note, wave, uint16 freq, adsr, pulse, 2 pad), see tools/dumpformat.h.
+"""
+import os
+import re
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+from sidm2.siddump import read_note_events, NOTE_KEYON, NOTE_CHANGE, NOTE_KEYOFF
+from sidm2.note_utils import extract_notes_from_siddump
+from sidm2.siddump_extractor import voices_from_note_events
+from pyscript.siddump_formats import (needs_siddump, run_siddump, set_header_field, pack)
+
+
+def _events_and_text(tmp_path, *options):
+    path = tmp_path / 'tune.snev'
+    text = run_siddump(f'-notes={path}', *options).decode()
+    return read_note_events(path.read_bytes()), text
+
+
+@needs_siddump
+def test_header_matches_the_dump(tmp_path):
+    stream, text = _events_and_text(tmp_path, '-f25', '-c1f00', '-d30')
+    assert stream['subtune'] == 0
+    assert stream['first_frame'] == 25
+    assert stream['frame_count'] == 100
+    middle_c = re.search(r'Middle C frequency is \$([0-9A-F]{4})', text).group(1)
+    assert stream['middle_c'] == int(middle_c, 16)
+    assert all(event[0] < 100 and event[1] < 3 for event in stream['events'])
+    assert {event[2] for event in stream['events']} <= {NOTE_KEYON, NOTE_CHANGE, NOTE_KEYOFF}
+
+
+@needs_siddump
+def test_notes_by_frame_match_the_text_table(tmp_path):
+    # Key ons and parenthesized note changes, as the table rows show them
+    for options in ((), ('-o8',), ('-f25', '-c1f00', '-d30')):
+        stream, text = _events_and_text(tmp_path, *options)
+        assert extract_notes_from_siddump(stream) == extract_notes_from_siddump(text), options
+
+
+@needs_siddump
+def test_binary_dump_gives_the_same_events(tmp_path):
+    with_text = tmp_path / 'text.snev'
+    with_binary = tmp_path / 'binary.snev'
+    run_siddump(f'-notes={with_text}')
+    run_siddump('-b', f'-notes={with_binary}')
+    assert with_text.read_bytes() == with_binary.read_bytes()
+
+
+@needs_siddump
+def test_unpatched_count_uses_file_size(tmp_path):
+    path = tmp_path / 'tune.snev'
+    run_siddump(f'-notes={path}')
+    data = path.read_bytes()
+    count = len(read_note_events(data)['events'])
+    assert len(read_note_events(set_header_field(data, 7, 0))['events']) == count
+    assert len(read_note_events(set_header_field(data, 7, count + 50))['events']) == count
+    assert len(read_note_events(data[:32 + 5 * 16])['events']) == 5
+
+
+@needs_siddump
+def test_rejects_other_formats():
+    assert read_note_events(run_siddump('-b')) is None
+    assert read_note_events(b'SNEV') is None
+
+
+def test_voices_keep_the_gate_off():
+    # Voice 0 keys on C-4 at frame 0, slides to D-4 (no key on) at 2 and keys off at 3;
+    # voice 2 keys on A-4 at frame 1
+    events = [(0, 0, NOTE_KEYON, 48, 0x41, 0x1167, 0x0A0F, 0x800),
+              (1, 2, NOTE_KEYON, 57, 0x11, 0x1D45, 0x00F0, 0x000),
+              (2, 0, NOTE_CHANGE, 50, 0x41, 0x1389, 0x0A0F, 0x800),
+              (3, 0, NOTE_KEYOFF, 50, 0x40, 0x1389, 0x0A0F, 0x800)]
+    data = pack((b'SNEV', 1, 32, 16, 0, 0, 4, len(events), 0x1167, 0, 0), events)
+    voices = voices_from_note_events(read_note_events(data))
+    assert [event['note'] for event in voices[0]] == ['C-4', 'D-4', '...']
+    assert voices[0][2]['wave'] == 0x40
+    assert voices[0][0]['adsr'] == 0x0A0F and voices[0][0]['pulse'] == 0x800
+    assert voices[1] == []
+    assert voices[2][0]['frame'] == 1 and voices[2][0]['freq'] == 0x1D45
@@ -0,0 +1,74 @@
+"""Tests for the siddump -sidwrites register write stream reader.
+
+Checked against a real stream (pyscript/siddump_formats.py): a 32-byte "SWRS"
+header followed by one 8-byte record per SID register write (uint32 cycle,
+register, value, 2 pad), see tools/dumpformat.h.
+"""
+import os
+import subprocess
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+from sidm2.siddump import read_binary_dump, read_sid_writes, sid_writes_to_frames
+from pyscript.siddump_formats import (SIDDUMP, SID_FILE, needs_siddump, run_siddump,
+                                      siddump_file, set_header_field, pack)
+
+PERIOD = 19656
+
+
+@needs_siddump
+def test_header_and_writes(tmp_path):
+    stream = read_sid_writes(siddump_file(tmp_path, '-sidwrites'))
+    assert stream['subtune'] == 0
+    assert stream['frame_period'] == PERIOD
+    assert stream['clock_rate'] == 985248
+    assert stream['frame_count'] == 100
+    cycles = [cycle for cycle, _, _ in stream['writes']]
+    assert cycles == sorted(cycles)
+    assert all(reg <= 0x18 for _, reg, _ in stream['writes'])
+
+
+@needs_siddump
+def test_frames_match_the_binary_dump(tmp_path):
+    frames = sid_writes_to_frames(read_sid_writes(siddump_file(tmp_path, '-sidwrites')))
+    assert frames == [regs for _, regs in read_binary_dump(run_siddump('-b'))['frames']]
+
+
+@needs_siddump
+def test_unpatched_count_uses_file_size(tmp_path):
+    data = siddump_file(tmp_path, '-sidwrites')
+    count = len(read_sid_writes(data)['writes'])
+    assert len(read_sid_writes(set_header_field(data, 8, 0))['writes']) == count
+    assert len(read_sid_writes(set_header_field(data, 8, count + 50))['writes']) == count
+    assert len(read_sid_writes(data[:32 + 5 * 8])['writes']) == 5
+
+
+@needs_siddump
+def test_runs_past_the_cycle_range_are_refused(tmp_path):
+    # 218000 frames fit the 32-bit stamps, -f counts towards them
+    path = tmp_path / 'tune.swrs'
+    result = subprocess.run([str(SIDDUMP), str(SID_FILE), '-t4360', '-f1', f'-sidwrites={path}'],
+                            capture_output=True, text=True, timeout=60)
+    assert result.returncode == 1
+    assert 'only reach frame 218000' in result.stdout
+    assert not path.exists()
+
+
+@needs_siddump
+def test_rejects_other_formats():
+    assert read_sid_writes(run_siddump('-b')) is None
+    assert read_sid_writes(b'SWRS') is None
+
+
+def test_frames_keep_intra_frame_writes_in_their_frame():
+    # Init sets the volume; frame 0 gates voice 1 on and off again within the
+    # call, which a once-per-frame sample only sees as the final value
+    writes = [(40, 0x18, 0x0f),
+              (PERIOD + 10, 0x04, 0x41), (PERIOD + 900, 0x04, 0x40),
+              (2 * PERIOD + 50, 0x01, 0x1c), (3 * PERIOD + 5, 0x00, 0xd6)]
+    data = pack((b'SWRS', 1, 32, 8, 2, PERIOD, 985248, 3, len(writes), 0), writes)
+    frames = sid_writes_to_frames(read_sid_writes(data))
+    assert len(frames) == 3
+    assert frames[0][0x18] == 0x0f and frames[0][0x04] == 0x40
+    assert frames[1][0x01] == 0x1c and frames[1][0x00] == 0
+    assert frames[2][0x00] == 0xd6
@@ -0,0 +1,67 @@
+"""Tests for the siddump -tracebin memory access trace reader.
+
+Checked against a real trace (pyscript/siddump_formats.py): a 32-byte "STRC"
+header followed by one 12-byte record per access (uint32 frame, uint16 pc,
+uint16 address, value, flags, 2 pad), see tools/dumpformat.h.
+"""
+import os
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+from sidm2.siddump import (read_binary_dump, read_binary_trace, TRACE_READ, TRACE_WRITE,
+                           TRACE_INIT_FRAME)
+from pyscript.siddump_trace_decode import format_record
+from pyscript.siddump_formats import (needs_siddump, run_siddump, siddump_file,
+                                      set_header_field)
+
+
+@needs_siddump
+def test_window_and_frames_are_honoured(tmp_path):
+    trace = read_binary_trace(siddump_file(tmp_path, '-tracebin', '-tracerange=D400-D418',
+                                           '-traceframes=0-9'))
+    assert (trace['window_start'], trace['window_end']) == (0xD400, 0xD418)
+    assert (trace['first_frame'], trace['last_frame']) == (0, 9)
+    assert trace['subtune'] == 0
+    records = trace['records']
+    assert records and records[0][0] == TRACE_INIT_FRAME
+    assert all(0xD400 <= address <= 0xD418 for _, _, address, _, _ in records)
+    assert {frame for frame, *_ in records} <= {TRACE_INIT_FRAME, *range(10)}
+    assert all(flags in (TRACE_READ, TRACE_WRITE) for *_, flags in records)
+
+
+@needs_siddump
+def test_sid_writes_replay_into_the_binary_dump(tmp_path):
+    # Memory starts out zero, so the traced writes alone give $D400-$D418
+    # after every play call
+    records = read_binary_trace(siddump_file(tmp_path, '-tracebin'))['records']
+    frames = [regs for _, regs in read_binary_dump(run_siddump('-b'))['frames']]
+    assert records[0][0] == TRACE_INIT_FRAME
+    regs = bytearray(25)
+    i = 0
+    for frame, expected in enumerate(frames):
+        while i < len(records) and (records[i][0] == TRACE_INIT_FRAME or records[i][0] <= frame):
+            _, _, address, value, flags = records[i]
+            if flags == TRACE_WRITE and 0xD400 <= address <= 0xD418:
+                regs[address - 0xD400] = value
+            i += 1
+        assert bytes(regs) == expected, f'frame {frame}'
+
+
+@needs_siddump
+def test_unpatched_count_uses_file_size(tmp_path):
+    data = siddump_file(tmp_path, '-tracebin', '-traceframes=0-3')
+    count = len(read_binary_trace(data)['records'])
+    assert len(read_binary_trace(set_header_field(data, 9, 0))['records']) == count
+    assert len(read_binary_trace(set_header_field(data, 9, count + 50))['records']) == count
+    assert len(read_binary_trace(data[:32 + 5 * 12])['records']) == 5
+
+
+@needs_siddump
+def test_rejects_other_formats():
+    assert read_binary_trace(run_siddump('-b')) is None
+    assert read_binary_trace(b'STRC') is None
+
+
+def test_format_record():
+    assert format_record((12, 0x10a1, 0x18f3, 0x80, TRACE_READ)) == 'F0012 PC:10A1 R [18F3]=80'
+    assert format_record((TRACE_INIT_FRAME, 0x1000, 0x1800, 0, TRACE_WRITE)) == 'INIT  PC:1000 W [1800]=00'
@@ -0,0 +1,86 @@
+"""Tests for the native player signature scanner (tools/sidid/).
+
+The scanner tests need tools/sidid/sidid.exe, built by `make` in tools/sidid,
+and are skipped without it.
+"""
+import os
+import subprocess
+import sys
+from pathlib import Path
+
+import pytest
+
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+from sidm2.enhanced_player_detection import EnhancedPlayerDetector, parse_sidid_output
+
+ROOT = Path(__file__).resolve().parent.parent
+SIDID = ROOT / 'tools' / 'sidid' / 'sidid.exe'
+STINSEN = ROOT / 'tools' / 'Stinsens_Last_Night_of_89.sid'
+
+needs_scanner = pytest.mark.skipif(not SIDID.exists(), reason='tools/sidid/sidid.exe not built')
+
+
+def _scan(tmp_path, cfg, data, *args):
+    (tmp_path / 'test.cfg').write_text(cfg)
+    (tmp_path / 'test.bin').write_bytes(bytes(data))
+    result = subprocess.run([str(SIDID), '-n', '-c', str(tmp_path / 'test.cfg')] + list(args) +
+                            [str(tmp_path / 'test.bin')], capture_output=True, text=True)
+    return result.returncode, parse_sidid_output(result.stdout).get(str(tmp_path / 'test.bin'))
+
+
+def test_parse_output():
+    text = ('a.sid\tLaxity_NewPlayer_V21\n'
+            'b.sid\t*Unidentified*\n'
+            'c.sid\tRob_Hubbard\t(Rob_Hubbard_Digi)\n'
+            'd.sid\t*Error* Cannot open file: d.sid\n')
+    assert parse_sidid_output(text) == {'a.sid': ['Laxity_NewPlayer_V21'],
+                                        'b.sid': [],
+                                        'c.sid': ['Rob_Hubbard', '(Rob_Hubbard_Digi)']}
+
+
+def test_no_scanner_gives_no_results():
+    detector = EnhancedPlayerDetector()
+    detector.sidid_exe = None
+    assert detector.identify_signatures([STINSEN]) == {}
+
+
+@needs_scanner
+def test_wildcards_and_sequences(tmp_path):
+    cfg = 'Seq\nA9 ?? 8D && 60\n'
+    assert _scan(tmp_path, cfg, [0, 0xA9, 5, 0x8D, 1, 2, 0x60]) == (0, ['Seq'])
+    # The group after AND has to come after the one before
+    assert _scan(tmp_path, cfg, [0x60, 0xA9, 5, 0x8D]) == (0, [])
+    assert _scan(tmp_path, cfg, [0xA9, 5, 0x8E, 0x60]) == (0, [])
+
+
+@needs_scanner
+def test_multi_line_definition(tmp_path):
+    cfg = 'Multi\n01 02\n03 04 END\n05 06\n'
+    assert _scan(tmp_path, cfg, [1, 2, 3, 4]) == (0, ['Multi'])
+    assert _scan(tmp_path, cfg, [1, 2, 9, 3, 4]) == (0, [])
+    assert _scan(tmp_path, cfg, [5, 6]) == (0, ['Multi'])
+
+
+@needs_scanner
+def test_index_round_trip(tmp_path):
+    cfg = 'One\n11 22 33\n\nTwo\n44 ?? 66\n'
+    index = str(tmp_path / 'test.idx')
+    data = [0x44, 0, 0x66, 0x11, 0x22, 0x33]
+    assert _scan(tmp_path, cfg, data, '-i', index) == (0, ['One', 'Two'])
+    assert os.path.exists(index)
+    assert _scan(tmp_path, cfg, data, '-i', index) == (0, ['One', 'Two'])
+    # A changed signature file doesn't use the old index
+    assert _scan(tmp_path, 'Three\n44 00 66\n', data, '-i', index) == (0, ['Three'])
+
+
+@needs_scanner
+def test_bad_signature_file(tmp_path):
+    code, _ = _scan(tmp_path, 'Bad\n11 AND\n', [0x11])
+    assert code == 1
+
+
+@needs_scanner
+def test_identifies_repo_tune():
+    detector = EnhancedPlayerDetector()
+    detector.sidid_exe = str(SIDID)
+    assert detector.identify_signatures([STINSEN]) == {str(STINSEN): ['SidFactory_II/Laxity']}
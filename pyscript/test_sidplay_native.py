@@ -0,0 +1,122 @@
+"""Tests for the in-process native SID player (sidm2/sidplay_native.py).
+
+The playback tests need tools/libsidplay.so (sidplay.dll), built by `make` in
+tools/, and are skipped without it; comparing with the text table also needs a
+tools/siddump.exe that runs here.
+"""
+import os
+import subprocess
+import sys
+
+import pytest
+
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
+from sidm2 import sidplay_native
+from sidm2.siddump import summarize_register_frames, summarize_siddump_text
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+SID_FILE = os.path.join(ROOT, 'SID', 'Hubbard_Rob', 'Commando.sid')
+
+SIDDUMP = os.path.join(ROOT, 'tools', 'siddump.exe')
+
+needs_library = pytest.mark.skipif(not sidplay_native.is_available(),
+                                   reason=str(sidplay_native.unavailable_reason()))
+
+
+def _siddump_text(sid_file, seconds):
+    try:
+        result = subprocess.run([SIDDUMP, sid_file, f'-t{seconds}'], capture_output=True,
+                                text=True, timeout=60)
+    except (OSError, subprocess.TimeoutExpired):
+        return None
+    return result.stdout if result.returncode == 0 else None
+
+
+def _frame(**regs):
+    frame = bytearray(25)
+    for offset, value in regs.items():
+        frame[int(offset[1:], 16)] = value
+    return bytes(frame)
+
+
+def test_summary_from_register_frames():
+    frames = [_frame(r04=0x41, r05=0x09, r06=0xA0, r02=0x00, r03=0x08),
+              _frame(r0B=0x21, r0C=0x0F, r0D=0x00),   # hard restart, not an instrument
+              _frame(r12=0x81, r13=0x00, r14=0xF9)]
+    summary = summarize_register_frames(frames)
+    assert sorted(summary['adsr_values']) == [(0x00, 0xF9), (0x09, 0xA0)]
+    assert sorted(summary['waveforms']) == [0x21, 0x41, 0x81]
+    assert summary['pulse_range'] == (0x800, 0x800)
+    assert [i['ad'] for i in summary['instruments']] == [0x00, 0x09]
+
+
+def test_text_summary_reads_every_voice():
+    # Pulse, waveform and ADSR from all three columns, not just the last one
+    table = (
+        "| Frame | Freq Note/Abs WF ADSR Pul | Freq Note/Abs WF ADSR Pul | Freq Note/Abs WF ADSR Pul | FCut RC Typ V |\n"
+        "+-------+---------------------------+---------------------------+---------------------------+---------------+\n"
+        "|     0 | 1167  C-4 B0  41 09A0 800 | 0000  ... ..  00 0000 000 | 0000  ... ..  00 0000 000 | 0000 00 Off F |\n"
+        "|     1 | ....  ... ..  .. .... 810 | 1D45  A-4 B9  21 0F00 ... | 2000  C-5 BC  81 00F9 ... | .... .. ... . |\n")
+    frames = [_frame(r00=0x67, r01=0x11, r02=0x00, r03=0x08, r04=0x41, r05=0x09, r06=0xA0, r18=0x0F),
+              _frame(r00=0x67, r01=0x11, r02=0x10, r03=0x08, r04=0x41, r05=0x09, r06=0xA0,
+                     r07=0x45, r08=0x1D, r0B=0x21, r0C=0x0F,
+                     r0E=0x00, r0F=0x20, r12=0x81, r14=0xF9, r18=0x0F)]
+    summary = summarize_siddump_text(table)
+    assert sorted(summary['adsr_values']) == [(0x00, 0xF9), (0x09, 0xA0)]
+    assert sorted(summary['waveforms']) == [0x21, 0x41, 0x81]
+    assert summary['pulse_range'] == (0x800, 0x810)
+    native = summarize_register_frames(frames)
+    assert sorted(native['adsr_values']) == sorted(summary['adsr_values'])
+    assert sorted(native['waveforms']) == sorted(summary['waveforms'])
+    assert native['pulse_range'] == summary['pulse_range']
+
+
+@needs_library
+def test_text_and_native_summaries_agree():
+    text = _siddump_text(SID_FILE, 30)
+    if text is None:
+        pytest.skip('tools/siddump.exe not built for this platform')
+    native = summarize_register_frames(sidplay_native.capture_frames(SID_FILE, 30 * 50))
+    from_text = summarize_siddump_text(text)
+    assert sorted(from_text['adsr_values']) == sorted(native['adsr_values'])
+    assert sorted(from_text['waveforms']) == sorted(native['waveforms'])
+    assert from_text['pulse_range'] == native['pulse_range']
+
+
+def test_missing_file_raises():
+    if not sidplay_native.is_available():
+        pytest.skip(str(sidplay_native.unavailable_reason()))
+    with pytest.raises(sidplay_native.NativeSIDError):
+        sidplay_native.NativeSIDPlayer(os.path.join(ROOT, 'no_such_file.sid'))
+
+
+@needs_library
+def test_run_is_deterministic_and_sized():
+    with sidplay_native.NativeSIDPlayer(SID_FILE) as player:
+        info = player.info()
+        assert info['songs'] >= 1
+        player.init(0)
+        regs, cycles = player.run(100)
+        assert len(regs) == 100 * sidplay_native.NUM_REGS
+        assert len(cycles) == 100 and all(c > 0 for c in cycles)
+        assert player.info()['frame'] == 100
+
+        player.init(0)
+        again, _ = player.run(100)
+        assert again == regs
+
+
+@needs_library
+def test_peek_reads_loaded_image_and_sid_registers():
+    with sidplay_native.NativeSIDPlayer(SID_FILE) as player:
+        info = player.info()
+        with open(SID_FILE, 'rb') as f:
+            data = f.read()
+        offset = (data[6] << 8) | data[7]
+        if (data[8] << 8 | data[9]) == 0:
+            offset += 2
+        assert player.peek(info['load_address'], 16) == data[offset:offset + 16]
+
+        player.init(0)
+        regs, _ = player.run(10)
+        assert player.peek(0xD400, 25) == bytes(regs[-25:])
@@ -7,6 +7,9 @@ Can work with:
 - Pre-generated siddump output files (for pipeline integration)
 - Live SID files (runs siddump automatically)
 
+SID pairs, and pairs of siddump -b binary dumps, go through the native
+tools/sidcompare when it is built, and through the Python diff otherwise.
+
 Version: 1.4.1 (baseline)
 Date: 2025-12-12
 
@@ -27,11 +30,40 @@ Usage:
 
 from pathlib import Path
 from typing import Dict, List, Tuple, Optional
+import json
 import subprocess
 import logging
 
 logger = logging.getLogger(__name__)
 
+TOOLS_DIR = Path(__file__).resolve().parent.parent / 'tools'
+SIDCOMPARE_EXE = TOOLS_DIR / 'sidcompare.exe'
+
+# Weights of the overall accuracy
+FRAME_WEIGHT = 0.4
+VOICE_WEIGHT = 0.3
+REGISTER_WEIGHT = 0.2
+FILTER_WEIGHT = 0.1
+
+
+def overall_accuracy(results: Dict) -> float:
+    """Weighted overall accuracy of a compare() result."""
+    voice_scores = [
+        (v['frequency'] + v['waveform']) / 2
+        for v in results['voice_accuracy'].values()
+    ]
+    avg_voice = sum(voice_scores) / len(voice_scores) if voice_scores else 0
+
+    reg_scores = list(results['register_accuracy'].values())
+    avg_register = sum(reg_scores) / len(reg_scores) if reg_scores else 0
+
+    return (
+        results['frame_accuracy'] * FRAME_WEIGHT +
+        avg_voice * VOICE_WEIGHT +
+        avg_register * REGISTER_WEIGHT +
+        results['filter_accuracy'] * FILTER_WEIGHT
+    )
+
 
 class SIDRegisterCapture:
     """Captures SID register writes frame by frame.
@@ -87,7 +119,7 @@ class SIDRegisterCapture:
         """Capture from existing siddump file.
 
         Args:
-            dump_path: Path to .dump file
+            dump_path: Path to .dump file (text table or siddump -b binary)
 
         Returns:
             True if successful
@@ -97,7 +129,11 @@ class SIDRegisterCapture:
             if not dump_file.exists():
                 return False
 
-            siddump_text = dump_file.read_text(encoding='utf-8', errors='ignore')
+            data = dump_file.read_bytes()
+            if data[:4] == b'SDMP':
+                return self._load_binary_dump(data)
+
+            siddump_text = data.decode('utf-8', errors='ignore')
             self._parse_siddump_output(siddump_text)
             return True
         except Exception:
@@ -189,6 +225,35 @@ class SIDRegisterCapture:
                 )
                 return False
 
+    def _load_binary_dump(self, data: bytes) -> bool:
+        """Load a siddump -b binary dump.
+
+        Produces the same frame dicts as the text parser: the first frame holds
+        every register, later frames only the registers that changed.
+        """
+        from sidm2.siddump import read_binary_dump
+
+        dump = read_binary_dump(data)
+        if dump is None:
+            return False
+
+        previous = None
+        for index, (cycles, regs) in enumerate(dump['frames']):
+            frame_num = dump['first_frame'] + index
+            frame_data = {reg: regs[reg] for reg in range(0x19)
+                          if previous is None or regs[reg] != previous[reg]}
+            previous = regs
+
+            self.frames.append(frame_data)
+            self.stats['total_frames'] += 1
+            for reg, value in frame_data.items():
+                self.register_history[reg].append({
+                    'frame': frame_num,
+                    'value': value
+                })
+                self.stats['total_writes'] += 1
+        return True
+
     def _parse_siddump_output(self, output: str):
         """Parse siddump table format into frame data."""
         for line in output.split('\n'):
@@ -377,28 +442,7 @@ class SIDComparator:
         if orig_filter:
             results['filter_accuracy'] = (filter_matches / len(orig_filter) * 100)
 
-        # Overall accuracy (weighted)
-        frame_weight = 0.4
-        voice_weight = 0.3
-        register_weight = 0.2
-        filter_weight = 0.1
-
-        voice_scores = [
-            (v['frequency'] + v['waveform']) / 2
-            for v in results['voice_accuracy'].values()
-        ]
-        avg_voice = sum(voice_scores) / len(voice_scores) if voice_scores else 0
-
-        reg_scores = list(results['register_accuracy'].values())
-        avg_register = sum(reg_scores) / len(reg_scores) if reg_scores else 0
-
-        results['overall_accuracy'] = (
-            results['frame_accuracy'] * frame_weight +
-            avg_voice * voice_weight +
-            avg_register * register_weight +
-            results['filter_accuracy'] * filter_weight
-        )
-
+        results['overall_accuracy'] = overall_accuracy(results)
         return results
 
     def _frames_match(self, frame1: Dict, frame2: Dict) -> bool:
@@ -455,6 +499,79 @@ class SIDComparator:
         return filters
 
 
+def accuracy_from_sidcompare(stats: Dict) -> Dict:
+    """compare() style metrics from `sidcompare -json` statistics.
+
+    Every frame holds all 25 registers, so the accuracies are the share of
+    frames in which a voice's frequency, its control register, a register or
+    the filter registers match. Also keeps 'frames', 'first_diff' (-1 if
+    none) and 'register_mismatches' (frames per register $D400-$D418).
+    """
+    frames = stats['frames']
+
+    def share(mismatches):
+        return (frames - mismatches) / frames * 100 if frames else 0.0
+
+    registers = stats['registers']
+    results = {
+        'frame_accuracy': share(frames - stats['matching']),
+        'voice_accuracy': {},
+        'register_accuracy': {},
+        'filter_accuracy': share(stats['channels']['filter']),
+        'overall_accuracy': 0.0,
+        'frames': frames,
+        'first_diff': stats['first_diff'],
+        'register_mismatches': registers,
+    }
+    for voice in range(1, 4):
+        results['voice_accuracy'][f'voice{voice}'] = {
+            'frequency': share(stats['frequency'][voice - 1]),
+            'waveform': share(registers[0x04 + (voice - 1) * 7])
+        }
+    for reg, mismatches in enumerate(registers):
+        results['register_accuracy'][SIDRegisterCapture.REGISTER_NAMES[reg]] = share(mismatches)
+    results['overall_accuracy'] = overall_accuracy(results)
+    return results
+
+
+def compare_with_sidcompare(original: str, exported: str, duration: int = 30,
+                            subtune: int = 0, timeout: float = 600) -> Optional[Dict]:
+    """Accuracy of exported against original from one run of tools/sidcompare.
+
+    Both are SID files, played in lockstep for `duration` seconds, or both
+    siddump -b binary dumps. Returns accuracy_from_sidcompare() metrics, or
+    None if sidcompare isn't built, can't run or fails on the input.
+    """
+    if not SIDCOMPARE_EXE.exists():
+        return None
+    try:
+        result = subprocess.run(
+            [str(SIDCOMPARE_EXE), str(original), str(exported), f'-t{duration}',
+             f'-a{subtune}', '-json'],
+            capture_output=True,
+            text=True,
+            timeout=timeout
+        )
+    except (OSError, subprocess.SubprocessError):
+        return None
+    # Exit code 0 identical, 1 different, 2 an error
+    if result.returncode not in (0, 1):
+        logger.debug(f"sidcompare failed: {result.stderr.strip()}")
+        return None
+    try:
+        return accuracy_from_sidcompare(json.loads(result.stdout))
+    except (ValueError, KeyError, IndexError):
+        return None
+
+
+def _is_binary_dump_file(path: str) -> bool:
+    try:
+        with open(path, 'rb') as f:
+            return f.read(4) == b'SDMP'
+    except OSError:
+        return False
+
+
 def calculate_accuracy_from_dumps(original_dump: str, exported_dump: str) -> Optional[Dict]:
     """Calculate accuracy from existing siddump files.
 
@@ -465,6 +582,12 @@ def calculate_accuracy_from_dumps(original_dump: str, exported_dump: str) -> Opt
     Returns:
         Dict with accuracy metrics, or None if failed
     """
+    # Two -b dumps: sidcompare reads them without the Python diff
+    if _is_binary_dump_file(original_dump) and _is_binary_dump_file(exported_dump):
+        native = compare_with_sidcompare(original_dump, exported_dump)
+        if native is not None:
+            return native
+
     try:
         original_capture = SIDRegisterCapture()
         if not original_capture.capture_from_file(original_dump):
@@ -483,7 +606,7 @@ def calculate_accuracy_from_dumps(original_dump: str, exported_dump: str) -> Opt
 
 def calculate_accuracy_from_sids(original_sid: str, exported_sid: str,
                                  duration: int = 30) -> Optional[Dict]:
-    """Calculate accuracy by running siddump on SID files.
+    """Calculate accuracy by running sidcompare, or siddump twice, on SID files.
 
     Args:
         original_sid: Path to original SID file
@@ -493,6 +616,11 @@ def calculate_accuracy_from_sids(original_sid: str, exported_sid: str,
     Returns:
         Dict with accuracy metrics, or None if failed
     """
+    # Both tunes in lockstep in one native run, no text dumps in between
+    native = compare_with_sidcompare(original_sid, exported_sid, duration)
+    if native is not None:
+        return native
+
     try:
         original_capture = SIDRegisterCapture(sid_path=original_sid, duration=duration)
         if not original_capture.capture_from_sid():
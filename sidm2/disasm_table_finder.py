@@ -192,3 +192,42 @@ def find_tables_in_disassembly(sid_path: str) -> Dict[str, Tuple[int, int, int]]
         logger.debug(f"Cluster {idx}: ${start:04X}-${end:04X} ({length} bytes)")
 
     return tables
+
+
+def find_tables_in_coverage(coverage: Dict, max_gap: int = 64,
+                            include_init: bool = False) -> Dict[str, Tuple[int, int, int]]:
+    """Find music data tables from siddump -coverage bitmaps.
+
+    Tables are the bytes the player reads but never executes or writes, which
+    the core records exactly, so no disassembly or text trace is needed. Zero
+    page, the stack and I/O are left out.
+
+    Args:
+        coverage: Result of sidm2.siddump.read_coverage()
+        max_gap: Maximum gap between addresses to consider them in same cluster
+        include_init: Also count the initroutine's accesses (snapshot 0)
+
+    Returns:
+        Dict mapping table_name -> (start_addr, end_addr, length), as
+        find_tables_in_disassembly()
+    """
+    from sidm2.siddump import coverage_addresses
+
+    snapshots = coverage['snapshots'] if include_init else coverage['snapshots'][1:]
+    # The maps are little-endian bit strings, so whole maps combine as integers
+    union = {'exec': 0, 'read': 0, 'write': 0}
+    for snapshot in snapshots:
+        for kind in union:
+            union[kind] |= int.from_bytes(snapshot[kind], 'little')
+
+    data_only = (union['read'] & ~(union['exec'] | union['write'])).to_bytes(8192, 'little')
+    addresses = [addr for addr in coverage_addresses(data_only)
+                 if addr >= 0x0200 and not 0xD000 <= addr <= 0xDFFF]
+
+    tables = {}
+    for idx, (start, end) in enumerate(cluster_addresses(addresses, max_gap=max_gap)):
+        length = end - start + 1
+        tables[f"table_{idx}_${start:04X}"] = (start, end, length)
+        logger.debug(f"Cluster {idx}: ${start:04X}-${end:04X} ({length} bytes)")
+
+    return tables
@@ -7,13 +7,33 @@ Provides comprehensive player type identification for SID files including:
 - Laxity NewPlayer variants
 - Custom and unknown players
 
-Uses player-id.exe for reliable detection of known player types.
+Uses the native signature scanner (tools/sidid/) or player-id.exe for
+reliable detection of known player types.
 """
 
+import os
 import struct
 import subprocess
+import tempfile
 from pathlib import Path
-from typing import Dict, Optional, Tuple
+from typing import Dict, Iterable, List, Optional, Tuple
+
+TOOLS_DIR = Path(__file__).resolve().parent.parent / 'tools'
+
+
+def parse_sidid_output(text: str) -> Dict[str, List[str]]:
+    """Map each file to the signatures found, from `sidid -n` output
+
+    Unidentified files map to an empty list, files that couldn't be read
+    are left out.
+    """
+    results = {}
+    for line in text.splitlines():
+        fields = line.split('\t')
+        if len(fields) < 2 or fields[1].startswith('*Error*'):
+            continue
+        results[fields[0]] = [] if fields[1] == '*Unidentified*' else fields[1:]
+    return results
 
 
 class EnhancedPlayerDetector:
@@ -70,6 +90,15 @@ class EnhancedPlayerDetector:
 
     def __init__(self):
         """Initialize detector"""
+        # Native scanner, with its compiled index next to the signatures
+        self.sidid_exe = None
+        self.sidid_cfg = TOOLS_DIR / 'sidid.cfg'
+        self.sidid_index = TOOLS_DIR / 'sidid.idx'
+        for name in ('sidid.exe', 'sidid'):
+            if (TOOLS_DIR / 'sidid' / name).exists():
+                self.sidid_exe = str(TOOLS_DIR / 'sidid' / name)
+                break
+
         # Try to find player-id.exe
         self.player_id_exe = None
         for potential_path in [
@@ -95,7 +124,12 @@ class EnhancedPlayerDetector:
             return "Unknown", 0.0
 
         try:
-            # Try player-id.exe first (most reliable)
+            # Signature scanners first (most reliable)
+            if self.sidid_exe:
+                found = self.identify_signatures([sid_file]).get(str(sid_file))
+                if found:
+                    return found[0], 0.95
+
             if self.player_id_exe:
                 player, confidence = self._detect_with_player_id_exe(sid_file)
                 if player != "Unknown":
@@ -144,6 +178,33 @@ class EnhancedPlayerDetector:
         except Exception as e:
             return "Unknown", 0.0
 
+    def identify_signatures(self, sid_files: Iterable[Path], jobs: int = 1,
+                            timeout: float = 600) -> Dict[str, List[str]]:
+        """Signatures found in many SID files, with one run of tools/sidid
+
+        Returns {path: [signature, ...]} with paths as given ([] if none
+        matched); empty if the scanner isn't built or fails to run.
+        """
+        files = [str(f) for f in sid_files]
+        if not self.sidid_exe or not files:
+            return {}
+        # Paths go in a list file, there can be more than a command line holds
+        with tempfile.NamedTemporaryFile('w', suffix='.txt', delete=False) as listfile:
+            listfile.write('\n'.join(files) + '\n')
+        try:
+            result = subprocess.run(
+                [self.sidid_exe, '-c', str(self.sidid_cfg), '-i', str(self.sidid_index),
+                 '-j', str(jobs), '-n', '@' + listfile.name],
+                capture_output=True,
+                text=True,
+                timeout=timeout
+            )
+        except (OSError, subprocess.SubprocessError):
+            return {}
+        finally:
+            os.unlink(listfile.name)
+        return parse_sidid_output(result.stdout)
+
     def _detect_with_player_id_exe(self, sid_file: Path) -> Tuple[str, float]:
         """Detect using player-id.exe tool"""
         try:
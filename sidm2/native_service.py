@@ -0,0 +1,143 @@
+"""
+Clients for the service modes of the native tools: `siddump.exe -serve` and
+`sf2pack.exe --serve`.
+
+One process stays up and answers newline-delimited JSON requests, so the
+tune, its play position and its in-memory checkpoints are kept between
+requests. Seeking replays at most 250 frames from the nearest checkpoint.
+Interactive callers such as the cockpit's scrubbing get replies in
+milliseconds, without paying for process start and reload every time.
+
+    with SiddumpService() as service:
+        service.load('tune.sid')
+        regs, cycles = service.frames(50, frame=1500)   # 25 bytes per frame
+
+    with Sf2PackService() as packer:
+        packer.pack('song.sf2', 'song_2000.sid', address=0x2000, zp=0x20)
+
+The protocol is documented in tools/sidserve.c and tools/sf2pack/README.md.
+"""
+
+import json
+import logging
+import subprocess
+from pathlib import Path
+from typing import Dict, List, Optional, Sequence, Tuple
+
+logger = logging.getLogger(__name__)
+
+TOOLS_DIR = Path(__file__).resolve().parent.parent / 'tools'
+DEFAULT_SIDDUMP = TOOLS_DIR / 'siddump.exe'
+DEFAULT_SF2PACK = TOOLS_DIR / 'sf2pack' / 'sf2pack.exe'
+
+
+class NativeServiceError(RuntimeError):
+    """A request the service answered with "ok": false, or a dead service."""
+
+
+class NativeService:
+    """A service process and its request/reply channel."""
+
+    def __init__(self, command: Sequence[str]):
+        self.command = [str(part) for part in command]
+        self._next_id = 1
+        self._process = subprocess.Popen(self.command, stdin=subprocess.PIPE,
+                                         stdout=subprocess.PIPE, text=True, bufsize=1)
+
+    def request(self, cmd: str, **fields) -> Dict:
+        """Send one request and return its reply; raise NativeServiceError if it failed."""
+        request_id = self._next_id
+        self._next_id += 1
+        message = dict(fields, id=request_id, cmd=cmd)
+        try:
+            self._process.stdin.write(json.dumps(message) + '\n')
+            self._process.stdin.flush()
+            line = self._process.stdout.readline()
+        except (BrokenPipeError, OSError) as e:
+            raise NativeServiceError(f"{self.command[0]} is not running: {e}") from e
+        if not line:
+            raise NativeServiceError(f"{self.command[0]} exited (code {self._process.poll()})")
+
+        reply = json.loads(line)
+        if reply.get('id') != request_id:
+            raise NativeServiceError(f"Reply {reply.get('id')} to request {request_id}")
+        if not reply.get('ok'):
+            raise NativeServiceError(reply.get('error', 'request failed'))
+        return reply
+
+    def close(self):
+        if self._process.poll() is None:
+            try:
+                self.request('quit')
+            except NativeServiceError:
+                pass
+            try:
+                self._process.wait(timeout=5)
+            except subprocess.TimeoutExpired:
+                self._process.kill()
+                self._process.wait()
+        for stream in (self._process.stdin, self._process.stdout):
+            if stream:
+                stream.close()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+
+class SiddumpService(NativeService):
+    """`siddump.exe -serve`: tunes played frame by frame on the siddump core."""
+
+    def __init__(self, siddump_path=None):
+        super().__init__([siddump_path or DEFAULT_SIDDUMP, '-serve'])
+
+    def load(self, sid_path, subtune: int = 0) -> Dict:
+        """Open a tune (or select it again, without replaying); returns the tune handle and addresses."""
+        return self.request('load', file=str(sid_path), subtune=subtune)
+
+    def seek(self, frame: int, tune: Optional[int] = None) -> int:
+        return self.request('seek', frame=frame, **_tune(tune))['frame']
+
+    def frames(self, count: int, frame: Optional[int] = None,
+               tune: Optional[int] = None) -> Tuple[List[bytes], List[int]]:
+        """Play count frames (from frame if given): $D400-$D418 after each call, and its cycles."""
+        fields = _tune(tune)
+        if frame is not None:
+            fields['frame'] = frame
+        reply = self.request('frames', count=count, **fields)
+        if 'error' in reply:
+            logger.warning(f"Playback stopped after {len(reply['regs'])} frames: {reply['error']}")
+        return [bytes.fromhex(regs) for regs in reply['regs']], reply['cycles']
+
+    def peek(self, address: int, length: int = 1, tune: Optional[int] = None) -> bytes:
+        return bytes.fromhex(self.request('peek', address=address, length=length, **_tune(tune))['data'])
+
+    def unload(self, tune: Optional[int] = None):
+        self.request('unload', **_tune(tune))
+
+
+class Sf2PackService(NativeService):
+    """`sf2pack.exe --serve`: SF2 files kept loaded and analyzed, packed on request."""
+
+    def __init__(self, sf2pack_path=None, reloc_cache=None):
+        command = [sf2pack_path or DEFAULT_SF2PACK, '--serve']
+        if reloc_cache:
+            command += ['--reloc-cache', reloc_cache]
+        super().__init__(command)
+
+    def load(self, sf2_path) -> Dict:
+        return self.request('load', file=str(sf2_path))
+
+    def pack(self, sf2_path, output_path, address: int = 0x1000, zp: int = 0x02, **metadata) -> Dict:
+        """Pack for address/zp; metadata: title, author, copyright. Returns sizes and relocation counts."""
+        return self.request('pack', file=str(sf2_path), output=str(output_path),
+                            address=address, zp=zp, **metadata)
+
+    def unload(self, sf2_path):
+        self.request('unload', file=str(sf2_path))
+
+
+def _tune(tune: Optional[int]) -> Dict:
+    return {} if tune is None else {'tune': tune}
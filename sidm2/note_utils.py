@@ -59,17 +59,41 @@ def note_name_to_laxity(note_name: str) -> int:
         return -1
 
 
-def extract_notes_from_siddump(dump_content: str) -> Dict[int, List[Tuple[str, str, str]]]:
+def siddump_note_name(note: int) -> str:
+    """Name siddump gives a note number (0-95): 'C-0' to 'B-7'."""
+    return f"{NOTE_NAMES[note % 12]}{note // 12}"
+
+
+def notes_by_frame_from_events(stream: Dict) -> Dict[int, Tuple[str, str, str]]:
+    """
+    The extract_notes_from_siddump() result for a siddump -notes event file, as read by
+    sidm2.siddump.read_note_events(): every analyzed frame, with the key ons and note
+    changes named.
+    """
+    from .siddump import NOTE_KEYOFF
+
+    frames = {frame: ['---', '---', '---'] for frame in range(stream['frame_count'])}
+    for frame, voice, kind, note, *_ in stream['events']:
+        if kind != NOTE_KEYOFF:
+            frames.setdefault(frame, ['---', '---', '---'])[voice] = siddump_note_name(note)
+    return {frame: tuple(notes) for frame, notes in sorted(frames.items())}
+
+
+def extract_notes_from_siddump(dump_content) -> Dict[int, List[Tuple[str, str, str]]]:
     """
     Extract notes from siddump output.
 
     Args:
-        dump_content: Raw siddump file content
+        dump_content: Raw siddump file content, or a read_note_events() dict (siddump
+            -notes), which gives the same notes without parsing the table
 
     Returns:
         Dict mapping frame number to list of (ch1_note, ch2_note, ch3_note) tuples
         Note names like 'G-5', '---' for no note
     """
+    if isinstance(dump_content, dict):
+        return notes_by_frame_from_events(dump_content)
+
     notes_by_frame = {}
 
     for line in dump_content.split('\n'):
@@ -11,6 +11,7 @@ import subprocess
 import re
 import sys
 import io
+import struct
 from typing import Dict, List, Optional, Tuple
 from pathlib import Path
 
@@ -31,7 +32,18 @@ def extract_from_siddump(sid_path: str, playback_time: int = 60, use_python: boo
     - waveforms: list of waveform bytes actually used
     - pulse_range: (min, max) pulse width range
     - instruments: list of instrument dicts built from actual usage
+
+    The in-process native player (sidm2.sidplay_native) is used when its
+    library is built; use_python only picks the fallback.
     """
+    from sidm2 import sidplay_native
+
+    if sidplay_native.is_available():
+        frames = sidplay_native.capture_frames(sid_path, playback_time * 50)
+        if frames:
+            return summarize_register_frames(frames)
+        logger.warning("Native siddump failed, falling back")
+
     # Try Python version first (if requested)
     if use_python:
         output = _run_python_siddump(sid_path, playback_time)
@@ -46,62 +58,82 @@ def extract_from_siddump(sid_path: str, playback_time: int = 60, use_python: boo
             return None
 
     # Parse siddump output (same format for both Python and C versions)
+    return summarize_siddump_text(output or '')
+
+
+def summarize_siddump_text(output: str) -> Dict:
+    """
+    extract_from_siddump() result from a siddump text table. A value is printed
+    whenever it changes, so this collects the same values from all three voices as
+    summarize_register_frames() does from the raw frames of the same tune.
+    """
     adsr_set = set()
     waveform_set = set()
     pulse_values = set()
 
-    if output:
-        for line in output.split('\n'):
-            if not line.startswith('|') or line.startswith('| Frame'):
-                continue
+    for line in output.split('\n'):
+        if not line.startswith('|') or line.startswith('| Frame'):
+            continue
 
-            parts = line.split('|')
-            if len(parts) < 5:
+        parts = line.split('|')
+        if len(parts) < 5:
+            continue
+
+        # Each channel column ends in waveform, ADSR and pulse, "..", "...." and
+        # "..." when unchanged: "1167  C-4 B0  41 0A0F 800"
+        for ch in range(3):
+            fields = parts[ch + 2].split()
+            if len(fields) < 3:
                 continue
+            wf, adsr, pulse = fields[-3:]
+
+            if adsr != '....':
+                adsr_val = int(adsr, 16)
+                ad = (adsr_val >> 8) & 0xFF
+                sr = adsr_val & 0xFF
+                # Skip unset ADSR and hard restart values
+                if (ad or sr) and (ad != 0x0F or sr > 0x01):
+                    adsr_set.add((ad, sr))
+
+            if wf != '..':
+                wf_val = int(wf, 16)
+                if wf_val != 0:
+                    waveform_set.add(wf_val)
+
+            if pulse != '...':
+                pulse_val = int(pulse, 16)
+                if pulse_val != 0:
+                    pulse_values.add(pulse_val)
+
+    return _usage_summary(adsr_set, waveform_set, pulse_values)
+
+
+def summarize_register_frames(frames) -> Dict:
+    """
+    extract_from_siddump() result from raw frames of $D400-$D418 (25 bytes each,
+    as from sidplay_native or read_binary_dump).
+    """
+    adsr_set = set()
+    waveform_set = set()
+    pulse_values = set()
+
+    for regs in frames:
+        for ch in range(3):
+            base = ch * 7
+            ad, sr = regs[base + 5], regs[base + 6]
+            # Skip unset ADSR and hard restart values
+            if (ad or sr) and (ad != 0x0F or sr > 0x01):
+                adsr_set.add((ad, sr))
+            if regs[base + 4]:
+                waveform_set.add(regs[base + 4])
+            pulse = (regs[base + 2] | (regs[base + 3] << 8)) & 0xFFF
+            if pulse:
+                pulse_values.add(pulse)
 
-            # Parse each of 3 channels
-            for ch in range(3):
-                if ch + 2 >= len(parts):
-                    break
-
-                ch_data = parts[ch + 2].strip()
-
-                # Extract ADSR (4 hex digits)
-                adsr_match = re.search(r'([0-9A-Fa-f]{4})\s+[0-9A-Fa-f]{3}\s*$', ch_data)
-                if not adsr_match:
-                    adsr_match = re.search(r'\s([0-9A-Fa-f]{4})\s', ch_data)
-
-                if adsr_match:
-                    adsr = adsr_match.group(1)
-                    if adsr != '....' and adsr != '0000':
-                        adsr_val = int(adsr, 16)
-                        ad = (adsr_val >> 8) & 0xFF
-                        sr = adsr_val & 0xFF
-                        # Filter out hard restart values
-                        if ad != 0x0F or sr > 0x01:
-                            adsr_set.add((ad, sr))
-
-                # Extract waveform
-                wf_match = re.search(r'\)\s*([0-9A-Fa-f]{2})\s', ch_data)
-                if not wf_match:
-                    wf_match = re.search(r'\s([0-9A-Fa-f]{2})\s+[0-9A-Fa-f\.]{4}', ch_data)
-
-                if wf_match:
-                    wf = wf_match.group(1)
-                    if wf != '..':
-                        wf_val = int(wf, 16)
-                        if wf_val != 0:
-                            waveform_set.add(wf_val)
-
-            # Extract pulse width
-            pulse_match = re.search(r'([0-9A-Fa-f]{3})\s*$', ch_data)
-            if pulse_match:
-                pulse = pulse_match.group(1)
-                if pulse != '...':
-                    pulse_val = int(pulse, 16)
-                    if pulse_val != 0:
-                        pulse_values.add(pulse_val)
+    return _usage_summary(adsr_set, waveform_set, pulse_values)
 
+
+def _usage_summary(adsr_set, waveform_set, pulse_values) -> Dict:
     # Build instrument list from unique ADSR values
     instruments = []
     for i, (ad, sr) in enumerate(sorted(adsr_set)):
@@ -257,3 +289,298 @@ def _run_exe_siddump(sid_path: str, playback_time: int) -> Optional[str]:
             f"  See: docs/guides/TROUBLESHOOTING.md#siddump-unexpected-errors"
         )
         return None
+
+
+# siddump -b binary frame dump (layout: tools/dumpformat.h)
+BINARY_DUMP_MAGIC = b'SDMP'
+_BINARY_HEADER = struct.Struct('<4sHHHHHHHHIII')
+_BINARY_RECORD = struct.Struct('<I25s3x')
+
+
+def is_binary_dump(data: bytes) -> bool:
+    """True if `data` starts with the siddump -b header magic."""
+    return data[:4] == BINARY_DUMP_MAGIC
+
+
+def read_binary_dump(path_or_data) -> Optional[Dict]:
+    """
+    Read a siddump -b binary frame dump.
+
+    Args:
+        path_or_data: Path to a .sdb file, or its contents as bytes
+
+    Returns dict with:
+    - load_address, init_address, play_address, subtune, first_frame
+    - frames: list of (cycles, registers) tuples, registers = 25 bytes $D400-$D418
+    or None if the data is not a valid binary dump.
+    """
+    if isinstance(path_or_data, (bytes, bytearray)):
+        data = bytes(path_or_data)
+    else:
+        data = Path(path_or_data).read_bytes()
+
+    if len(data) < _BINARY_HEADER.size or not is_binary_dump(data):
+        return None
+
+    (_, version, header_size, record_size, load_address, init_address, play_address,
+     subtune, _, first_frame, frame_count, _) = _BINARY_HEADER.unpack_from(data, 0)
+    if version != 1 or record_size < _BINARY_RECORD.size:
+        logger.warning(f"Unsupported binary dump version {version} (record size {record_size})")
+        return None
+
+    # Trust the file size over the header if the dump was cut short
+    frame_count = min(frame_count, (len(data) - header_size) // record_size)
+    frames = [_BINARY_RECORD.unpack_from(data, header_size + i * record_size)
+              for i in range(frame_count)]
+
+    return {
+        'load_address': load_address,
+        'init_address': init_address,
+        'play_address': play_address,
+        'subtune': subtune,
+        'first_frame': first_frame,
+        'frames': frames,
+    }
+
+
+# siddump -notes note events (layout: tools/dumpformat.h)
+NOTE_EVENTS_MAGIC = b'SNEV'
+NOTE_KEYON = 1
+NOTE_CHANGE = 2
+NOTE_KEYOFF = 3
+_NOTE_EVENTS_HEADER = struct.Struct('<4sHHHHIIIHHI')
+_NOTE_EVENTS_RECORD = struct.Struct('<IBBBBHHHxx')
+
+
+def read_note_events(path_or_data) -> Optional[Dict]:
+    """
+    Read a siddump -notes event file.
+
+    Args:
+        path_or_data: Path to an event file, or its contents as bytes
+
+    Returns dict with:
+    - subtune, first_frame (play call of frame 0), frame_count, middle_c (frequency of C-4
+      after -c recalibration)
+    - events: list of (frame, voice, type, note, wave, freq, adsr, pulse) tuples in frame
+      order; type is NOTE_KEYON, NOTE_CHANGE or NOTE_KEYOFF, note 0-95 (C-0 to B-7)
+    or None if the data is not a valid event file.
+    """
+    if isinstance(path_or_data, (bytes, bytearray)):
+        data = bytes(path_or_data)
+    else:
+        data = Path(path_or_data).read_bytes()
+
+    if len(data) < _NOTE_EVENTS_HEADER.size or data[:4] != NOTE_EVENTS_MAGIC:
+        return None
+
+    (_, version, header_size, record_size, subtune, first_frame, frame_count,
+     event_count, middle_c, _, _) = _NOTE_EVENTS_HEADER.unpack_from(data, 0)
+    if version != 1 or record_size != _NOTE_EVENTS_RECORD.size:
+        logger.warning(f"Unsupported note event file version {version} (record size {record_size})")
+        return None
+
+    # The counts are only patched in on close; fall back to the file size
+    available = (len(data) - header_size) // record_size
+    if event_count == 0 or event_count > available:
+        event_count = available
+    end = header_size + event_count * record_size
+
+    return {
+        'subtune': subtune,
+        'first_frame': first_frame,
+        'frame_count': frame_count,
+        'middle_c': middle_c,
+        'events': list(_NOTE_EVENTS_RECORD.iter_unpack(data[header_size:end])),
+    }
+
+
+# siddump -tracebin memory access trace (layout: tools/dumpformat.h)
+BINARY_TRACE_MAGIC = b'STRC'
+TRACE_READ = 0x01
+TRACE_WRITE = 0x02
+TRACE_INIT_FRAME = 0xFFFFFFFF
+_TRACE_HEADER = struct.Struct('<4sHHHHHHIIII')
+_TRACE_RECORD = struct.Struct('<IHHBBxx')
+
+
+def read_binary_trace(path_or_data) -> Optional[Dict]:
+    """
+    Read a siddump -tracebin memory access trace.
+
+    Args:
+        path_or_data: Path to a trace file, or its contents as bytes
+
+    Returns dict with:
+    - window_start, window_end, subtune, first_frame, last_frame
+    - records: list of (frame, pc, address, value, flags) tuples in execution order;
+      frame is TRACE_INIT_FRAME for the initroutine, flags TRACE_READ or TRACE_WRITE
+    or None if the data is not a valid trace.
+    """
+    if isinstance(path_or_data, (bytes, bytearray)):
+        data = bytes(path_or_data)
+    else:
+        data = Path(path_or_data).read_bytes()
+
+    if len(data) < _TRACE_HEADER.size or data[:4] != BINARY_TRACE_MAGIC:
+        return None
+
+    (_, version, header_size, record_size, window_start, window_end, subtune,
+     first_frame, last_frame, record_count, _) = _TRACE_HEADER.unpack_from(data, 0)
+    if version != 1 or record_size != _TRACE_RECORD.size:
+        logger.warning(f"Unsupported binary trace version {version} (record size {record_size})")
+        return None
+
+    # The count is only patched in on close; fall back to the file size
+    available = (len(data) - header_size) // record_size
+    if record_count == 0 or record_count > available:
+        record_count = available
+    end = header_size + record_count * record_size
+
+    return {
+        'window_start': window_start,
+        'window_end': window_end,
+        'subtune': subtune,
+        'first_frame': first_frame,
+        'last_frame': last_frame,
+        'records': list(_TRACE_RECORD.iter_unpack(data[header_size:end])),
+    }
+
+
+# siddump -sidwrites SID register write stream (layout: tools/dumpformat.h)
+SID_WRITES_MAGIC = b'SWRS'
+_SID_WRITES_HEADER = struct.Struct('<4sHHHHIIIII')
+_SID_WRITES_RECORD = struct.Struct('<IBBxx')
+
+
+def read_sid_writes(path_or_data) -> Optional[Dict]:
+    """
+    Read a siddump -sidwrites register write stream.
+
+    Args:
+        path_or_data: Path to a write stream file, or its contents as bytes
+
+    Returns dict with:
+    - subtune, frame_period (cycles per play call), clock_rate (cycles per second), frame_count
+    - writes: list of (cycle, register, value) tuples in execution order; cycles count from
+      the start of init and play call n starts at (n + 1) * frame_period
+    or None if the data is not a valid write stream.
+    """
+    if isinstance(path_or_data, (bytes, bytearray)):
+        data = bytes(path_or_data)
+    else:
+        data = Path(path_or_data).read_bytes()
+
+    if len(data) < _SID_WRITES_HEADER.size or data[:4] != SID_WRITES_MAGIC:
+        return None
+
+    (_, version, header_size, record_size, subtune, frame_period, clock_rate,
+     frame_count, record_count, _) = _SID_WRITES_HEADER.unpack_from(data, 0)
+    if version != 1 or record_size != _SID_WRITES_RECORD.size:
+        logger.warning(f"Unsupported SID write stream version {version} (record size {record_size})")
+        return None
+
+    # The counts are only patched in on close; fall back to the file size
+    available = (len(data) - header_size) // record_size
+    if record_count == 0 or record_count > available:
+        record_count = available
+    end = header_size + record_count * record_size
+
+    return {
+        'subtune': subtune,
+        'frame_period': frame_period,
+        'clock_rate': clock_rate,
+        'frame_count': frame_count,
+        'writes': list(_SID_WRITES_RECORD.iter_unpack(data[header_size:end])),
+    }
+
+
+def sid_writes_to_frames(stream: Dict) -> List[bytes]:
+    """
+    Replay a read_sid_writes() stream into $D400-$D418 as it stands after each play call,
+    the same 25 bytes per frame as a binary dump samples. Writes made before the next call
+    starts count for the frame, so a call that runs long still lands in its own frame.
+    """
+    period = stream['frame_period']
+    writes = stream['writes']
+    regs = bytearray(25)
+    frames = []
+    i = 0
+    for frame in range(stream['frame_count']):
+        end = (frame + 2) * period
+        while i < len(writes) and writes[i][0] < end:
+            regs[writes[i][1]] = writes[i][2]
+            i += 1
+        frames.append(bytes(regs))
+    return frames
+
+
+# siddump -coverage memory coverage bitmaps (layout: tools/dumpformat.h)
+COVERAGE_MAGIC = b'SCOV'
+COVERAGE_NEVER = 0xFFFFFFFF
+COVERAGE_INIT_FRAME = 0xFFFFFFFE
+COVERAGE_MAP_SIZE = 8192
+_COVERAGE_HEADER = struct.Struct('<4sHHIIHHIII')
+_COVERAGE_FRAMES = struct.Struct('<II')
+
+
+def read_coverage(path_or_data) -> Optional[Dict]:
+    """
+    Read a siddump -coverage file.
+
+    Args:
+        path_or_data: Path to a coverage file, or its contents as bytes
+
+    Returns dict with:
+    - subtune, interval (play calls per snapshot, 0 for one)
+    - first_touch: 65536 frame numbers, the first frame each address was executed, read or
+      written in; COVERAGE_INIT_FRAME for the initroutine, COVERAGE_NEVER if untouched
+    - snapshots: list of dicts with first_frame, last_frame and the 8 KB bitmaps exec, read
+      and write (bit address & 7 of byte address >> 3); snapshot 0 is the initroutine
+    or None if the data is not a valid coverage file.
+    """
+    if isinstance(path_or_data, (bytes, bytearray)):
+        data = bytes(path_or_data)
+    else:
+        data = Path(path_or_data).read_bytes()
+
+    if len(data) < _COVERAGE_HEADER.size or data[:4] != COVERAGE_MAGIC:
+        return None
+
+    (_, version, header_size, snapshot_size, interval, subtune, _, snapshot_count,
+     snapshot_offset, _) = _COVERAGE_HEADER.unpack_from(data, 0)
+    if version != 1 or snapshot_size != _COVERAGE_FRAMES.size + 3 * COVERAGE_MAP_SIZE:
+        logger.warning(f"Unsupported coverage version {version} (snapshot size {snapshot_size})")
+        return None
+    if len(data) < header_size + 0x10000 * 4:
+        return None
+
+    available = max(0, (len(data) - snapshot_offset) // snapshot_size)
+    if snapshot_count == 0 or snapshot_count > available:
+        snapshot_count = available
+
+    snapshots = []
+    for n in range(snapshot_count):
+        offset = snapshot_offset + n * snapshot_size
+        first_frame, last_frame = _COVERAGE_FRAMES.unpack_from(data, offset)
+        maps = offset + _COVERAGE_FRAMES.size
+        snapshots.append({
+            'first_frame': first_frame,
+            'last_frame': last_frame,
+            'exec': data[maps:maps + COVERAGE_MAP_SIZE],
+            'read': data[maps + COVERAGE_MAP_SIZE:maps + 2 * COVERAGE_MAP_SIZE],
+            'write': data[maps + 2 * COVERAGE_MAP_SIZE:maps + 3 * COVERAGE_MAP_SIZE],
+        })
+
+    return {
+        'subtune': subtune,
+        'interval': interval,
+        'first_touch': struct.unpack_from('<65536I', data, header_size),
+        'snapshots': snapshots,
+    }
+
+
+def coverage_addresses(bitmap: bytes) -> List[int]:
+    """Addresses whose bit is set in a read_coverage() bitmap, ascending."""
+    return [(index << 3) | bit for index, byte in enumerate(bitmap) if byte
+            for bit in range(8) if byte & (1 << bit)]
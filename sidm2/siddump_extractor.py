@@ -50,6 +50,61 @@ def run_siddump(sid_file: str, seconds: int = 30) -> Optional[str]:
         return None
 
 
+def run_siddump_notes(sid_file: str, seconds: int = 30) -> Optional[Dict]:
+    """
+    Run siddump with -notes on a SID file and read the note events.
+
+    Args:
+        sid_file: Path to SID file
+        seconds: Number of seconds to capture
+
+    Returns:
+        read_note_events() dict, or None if siddump failed or doesn't write events
+    """
+    import os
+    import tempfile
+    from pathlib import Path
+    from .siddump import read_note_events
+
+    fd, events_path = tempfile.mkstemp(suffix='.snev')
+    os.close(fd)
+    try:
+        siddump_path = Path('tools') / 'siddump.exe'
+        cmd = [str(siddump_path), sid_file, f'-t{seconds}', f'-notes={events_path}']
+        result = subprocess.run(cmd, capture_output=True, timeout=60)
+        if result.returncode != 0:
+            return None
+        return read_note_events(events_path)
+
+    except (subprocess.TimeoutExpired, OSError):
+        return None
+    finally:
+        os.remove(events_path)
+
+
+def voices_from_note_events(stream: Dict) -> Dict[int, List]:
+    """
+    Voice events as parse_siddump_output() gives them, from a siddump -notes event file.
+
+    Key ons and note changes carry the note name; a key off is a '...' event, whose
+    cleared gate bit convert_pattern_to_sequence() turns into a gate off.
+    """
+    from .siddump import NOTE_KEYOFF
+    from .note_utils import siddump_note_name
+
+    voices = {0: [], 1: [], 2: []}
+    for frame, voice, kind, note, wave, freq, adsr, pulse in stream['events']:
+        voices[voice].append({
+            'frame': frame,
+            'freq': freq,
+            'note': '...' if kind == NOTE_KEYOFF else siddump_note_name(note),
+            'wave': wave,
+            'adsr': adsr,
+            'pulse': pulse
+        })
+    return voices
+
+
 def parse_voice_column(column_text: str) -> Optional[Tuple]:
     """
     Parse a single voice column from siddump output.
@@ -482,14 +537,18 @@ def extract_sequences_from_siddump(sid_file: str, seconds: int = 30, max_sequenc
     """
     print(f"Running siddump on {sid_file}...")
 
-    # Run siddump
-    siddump_output = run_siddump(sid_file, seconds)
-    if not siddump_output:
-        print("Failed to get siddump output")
-        return [], [], {}
+    # Note events straight from siddump; parse the text table if it can't write them
+    stream = run_siddump_notes(sid_file, seconds)
+    if stream is not None:
+        voices = voices_from_note_events(stream)
+    else:
+        siddump_output = run_siddump(sid_file, seconds)
+        if not siddump_output:
+            print("Failed to get siddump output")
+            return [], [], {}
 
-    # Parse output
-    voices = parse_siddump_output(siddump_output)
+        # Parse output
+        voices = parse_siddump_output(siddump_output)
 
     print(f"Parsed {sum(len(v) for v in voices.values())} total events")
     for voice_num, events in voices.items():
@@ -0,0 +1,173 @@
+"""
+In-process SID playback through the siddump 6502 core (tools/sidplaylib.c).
+
+Loads tools/libsidplay.so (sidplay.dll on Windows, built by `make` in tools/)
+with ctypes. No process is spawned and no text table is parsed: frames come
+back as raw $D400-$D418 bytes, 25 per frame, plus the cycles of each play
+call. Both buffers support the buffer protocol, so
+`numpy.frombuffer(regs, numpy.uint8).reshape(-1, 25)` works without a copy.
+
+    with NativeSIDPlayer('tune.sid') as player:
+        player.init(0)
+        regs, cycles = player.run(3000)
+"""
+
+import array
+import ctypes
+import logging
+import os
+import sys
+from pathlib import Path
+from typing import List, Optional, Tuple
+
+logger = logging.getLogger(__name__)
+
+NUM_REGS = 25
+SIDLIB_VERSION = 1
+
+_LIBRARY_NAME = 'sidplay.dll' if sys.platform == 'win32' else 'libsidplay.so'
+_library = None
+_library_error = None
+
+
+def find_library() -> Optional[Path]:
+    """Path of the player library: $SIDM2_SIDPLAY_LIB, else tools/, or None."""
+    env = os.environ.get('SIDM2_SIDPLAY_LIB')
+    if env:
+        return Path(env) if Path(env).is_file() else None
+    path = Path(__file__).resolve().parent.parent / 'tools' / _LIBRARY_NAME
+    return path if path.is_file() else None
+
+
+def _load_library():
+    global _library, _library_error
+    if _library is not None or _library_error is not None:
+        return _library
+
+    path = find_library()
+    if path is None:
+        _library_error = f"{_LIBRARY_NAME} not found (run make in tools/)"
+        return None
+    try:
+        lib = ctypes.CDLL(str(path))
+    except OSError as e:
+        _library_error = f"couldn't load {path}: {e}"
+        return None
+    if lib.sidlib_version() != SIDLIB_VERSION:
+        _library_error = f"{path} is version {lib.sidlib_version()}, expected {SIDLIB_VERSION}"
+        return None
+
+    lib.sidlib_load.argtypes = [ctypes.c_char_p, ctypes.c_char_p, ctypes.c_int]
+    lib.sidlib_load.restype = ctypes.c_void_p
+    lib.sidlib_free.argtypes = [ctypes.c_void_p]
+    lib.sidlib_free.restype = None
+    lib.sidlib_error.argtypes = [ctypes.c_void_p]
+    lib.sidlib_error.restype = ctypes.c_char_p
+    lib.sidlib_info.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_uint)]
+    lib.sidlib_info.restype = None
+    lib.sidlib_init.argtypes = [ctypes.c_void_p, ctypes.c_int]
+    lib.sidlib_init.restype = ctypes.c_int
+    lib.sidlib_run.argtypes = [ctypes.c_void_p, ctypes.c_int, ctypes.c_void_p, ctypes.c_void_p]
+    lib.sidlib_run.restype = ctypes.c_int
+    lib.sidlib_peek.argtypes = [ctypes.c_void_p, ctypes.c_uint, ctypes.c_uint, ctypes.c_void_p]
+    lib.sidlib_peek.restype = None
+    _library = lib
+    return lib
+
+
+def is_available() -> bool:
+    """True if the player library can be loaded."""
+    return _load_library() is not None
+
+
+def unavailable_reason() -> Optional[str]:
+    """Why is_available() is False, or None."""
+    _load_library()
+    return _library_error
+
+
+class NativeSIDError(RuntimeError):
+    """Raised when the native player fails to load, init or play a tune."""
+
+
+class NativeSIDPlayer:
+    """One emulated C64 playing one SID file. Not shared between threads."""
+
+    def __init__(self, sid_path: str):
+        lib = _load_library()
+        if lib is None:
+            raise NativeSIDError(_library_error)
+        self._lib = lib
+        error = ctypes.create_string_buffer(128)
+        self._handle = lib.sidlib_load(str(sid_path).encode(), error, len(error))
+        if not self._handle:
+            raise NativeSIDError(f"{error.value.decode(errors='replace')} ({sid_path})")
+
+    def close(self):
+        if self._handle:
+            self._lib.sidlib_free(self._handle)
+            self._handle = None
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+    def __del__(self):
+        self.close()
+
+    def _error(self) -> str:
+        return self._lib.sidlib_error(self._handle).decode(errors='replace')
+
+    def info(self) -> dict:
+        """load_address, init_address, play_address (resolved by init), load_size, songs, frame."""
+        values = (ctypes.c_uint * 6)()
+        self._lib.sidlib_info(self._handle, values)
+        keys = ('load_address', 'init_address', 'play_address', 'load_size', 'songs', 'frame')
+        return dict(zip(keys, values))
+
+    def init(self, subtune: int = 0):
+        """Reset the machine and call the initroutine."""
+        if self._lib.sidlib_init(self._handle, subtune):
+            raise NativeSIDError(self._error())
+
+    def run(self, frames: int, strict: bool = True) -> Tuple[bytearray, array.array]:
+        """
+        Play `frames` frames.
+
+        Returns (regs, cycles): regs holds 25 bytes of $D400-$D418 per frame,
+        cycles the CPU cycles of each play call. If the playroutine fails,
+        NativeSIDError is raised, or with strict=False the frames played so far
+        are returned.
+        """
+        regs = bytearray(frames * NUM_REGS)
+        cycles = array.array('I', bytes(4 * frames))
+        regs_buf = (ctypes.c_ubyte * len(regs)).from_buffer(regs) if frames else None
+        cycles_buf = (ctypes.c_uint * frames).from_buffer(cycles) if frames else None
+        done = self._lib.sidlib_run(self._handle, frames, regs_buf, cycles_buf)
+        del regs_buf, cycles_buf
+        if done < frames:
+            if strict:
+                raise NativeSIDError(self._error())
+            del regs[done * NUM_REGS:]
+            del cycles[done:]
+        return regs, cycles
+
+    def peek(self, address: int, length: int = 1) -> bytes:
+        """C64 memory from `address` on, wrapping at $FFFF."""
+        buffer = ctypes.create_string_buffer(length)
+        self._lib.sidlib_peek(self._handle, address, length, buffer)
+        return buffer.raw
+
+
+def capture_frames(sid_path: str, frames: int, subtune: int = 0) -> List[bytes]:
+    """Registers of `frames` frames as a list of 25-byte strings, or [] on failure."""
+    try:
+        with NativeSIDPlayer(sid_path) as player:
+            player.init(subtune)
+            regs, _ = player.run(frames, strict=False)
+    except NativeSIDError as e:
+        logger.warning(f"Native SID playback failed: {e}")
+        return []
+    return [bytes(regs[i:i + NUM_REGS]) for i in range(0, len(regs), NUM_REGS)]
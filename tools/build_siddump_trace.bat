@@ -1,39 +1,14 @@
 @echo off
-REM Build modified siddump with memory tracing
-REM This script automates the patching and compilation process
+REM Build siddump with memory tracing
+REM -trace is built into siddump.c/cpu.c; no patching is needed any more.
 
 echo ========================================
 echo Building siddump_trace.exe
 echo ========================================
 echo.
 
-REM Check if backup exists
-if not exist siddump.c.orig (
-    echo Creating backups...
-    copy siddump.c siddump.c.orig
-    copy cpu.c cpu.c.orig
-    copy cpu.h cpu.h.orig
-    echo Backups created.
-    echo.
-)
-
-echo Applying modifications...
-echo.
-
-REM Create modified cpu.c
-echo Modifying cpu.c...
-python ../apply_siddump_trace_patch.py
-
-if errorlevel 1 (
-    echo ERROR: Patch application failed!
-    echo Try manual patching - see BUILD_SIDDUMP_TRACE.md
-    pause
-    exit /b 1
-)
-
-echo.
 echo Compiling...
-gcc -o siddump_trace.exe siddump.c cpu.c -lm -O2
+gcc -o siddump_trace.exe siddump.c cpu.c -lm -O2 -pthread
 
 if errorlevel 1 (
     echo ERROR: Compilation failed!
@@ -50,13 +25,8 @@ echo.
 echo siddump_trace.exe created successfully!
 echo.
 echo Usage:
-echo   siddump_trace.exe -trace SID/file.sid -t1
+echo   siddump_trace.exe SID/file.sid -trace -t1
 echo.
 echo Output will be written to: siddump_trace.txt
 echo.
-echo To restore original files:
-echo   copy siddump.c.orig siddump.c
-echo   copy cpu.c.orig cpu.c
-echo   copy cpu.h.orig cpu.h
-echo.
 pause
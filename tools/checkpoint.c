@@ -0,0 +1,167 @@
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#endif
+#include "checkpoint.h"
+#include "sidfile.h"
+
+#define MAX_PATH_LEN 1024
+
+// FNV-1a over the whole file, 0 if it can't be read
+unsigned long long checkpoint_hashfile(const char *sidname)
+{
+  unsigned long long hash = 0xcbf29ce484222325ULL;
+  SIDFILEMAP map;
+  size_t c;
+
+  if (sidfile_map(sidname, &map)) return 0;
+  for (c = 0; c < map.size; c++)
+  {
+    hash ^= map.data[c];
+    hash *= 0x100000001b3ULL;
+  }
+  sidfile_unmap(&map);
+  return hash;
+}
+
+static void initheader(CHECKPOINTHEADER *header, unsigned long long sidhash, int subtune, unsigned short playaddress, unsigned interval)
+{
+  memset(header, 0, sizeof *header);
+  memcpy(header->magic, CHECKPOINT_MAGIC, 4);
+  header->version = CHECKPOINT_VERSION;
+  header->headersize = sizeof(CHECKPOINTHEADER);
+  header->checkpointsize = sizeof(CHECKPOINT);
+  header->interval = interval;
+  header->sidhash = sidhash;
+  header->subtune = subtune;
+  header->playaddress = playaddress;
+}
+
+static void writeheader(CHECKPOINTFILE *ck)
+{
+  fseek(ck->file, 0, SEEK_SET);
+  fwrite(&ck->header, sizeof ck->header, 1, ck->file);
+  fflush(ck->file);
+}
+
+// Open (or create) <cachedir>/<hash>_<subtune>.sdc. Existing checkpoints
+// are kept only if they were made with the same interval and play address.
+// Returns 0 on success.
+int checkpoint_open(CHECKPOINTFILE *ck, const char *cachedir, unsigned long long sidhash, int subtune, unsigned short playaddress, unsigned interval)
+{
+  char name[MAX_PATH_LEN];
+  CHECKPOINTHEADER wanted;
+  struct stat st;
+  FILE *f;
+
+  ck->file = NULL;
+  if (stat(cachedir, &st))
+  {
+#ifdef _WIN32
+    _mkdir(cachedir);
+#else
+    mkdir(cachedir, 0777);
+#endif
+  }
+  snprintf(name, sizeof name, "%s/%016llx_%d.sdc", cachedir, sidhash, subtune);
+
+  initheader(&wanted, sidhash, subtune, playaddress, interval);
+  f = fopen(name, "r+b");
+  if (f)
+  {
+    CHECKPOINTHEADER header;
+    if ((fread(&header, sizeof header, 1, f) == 1) &&
+        (!memcmp(header.magic, wanted.magic, 4)) &&
+        (header.version == wanted.version) &&
+        (header.headersize == wanted.headersize) &&
+        (header.checkpointsize == wanted.checkpointsize) &&
+        (header.interval == wanted.interval) &&
+        (header.sidhash == wanted.sidhash) &&
+        (header.subtune == wanted.subtune) &&
+        (header.playaddress == wanted.playaddress))
+    {
+      // Trust the file size over the header if a write was cut short
+      fseek(f, 0, SEEK_END);
+      if ((unsigned long)ftell(f) < sizeof header + (unsigned long)header.count * sizeof(CHECKPOINT))
+        header.count = (ftell(f) - sizeof header) / sizeof(CHECKPOINT);
+      ck->file = f;
+      ck->header = header;
+      return 0;
+    }
+    fclose(f);
+  }
+
+  // Missing or stale: start over
+  f = fopen(name, "w+b");
+  if (!f) return 1;
+  ck->file = f;
+  ck->header = wanted;
+  writeheader(ck);
+  return 0;
+}
+
+// Load the latest checkpoint at or before frame into the CPU context and
+// its memory. Returns the frame restored, 0 if there is none.
+unsigned checkpoint_restore(CHECKPOINTFILE *ck, unsigned frame, CPUCONTEXT *cpu)
+{
+  CHECKPOINT *cp;
+  unsigned n = frame / ck->header.interval;
+
+  if (n > ck->header.count) n = ck->header.count;
+  if (!n) return 0;
+  cp = malloc(sizeof *cp);
+  if (!cp) return 0;
+  fseek(ck->file, sizeof ck->header + (long)(n - 1) * sizeof *cp, SEEK_SET);
+  if ((fread(cp, sizeof *cp, 1, ck->file) != 1) || (cp->frame != n * ck->header.interval))
+  {
+    free(cp);
+    return 0;
+  }
+  memcpy(cpu->mem, cp->mem, 0x10000);
+  cpu->cpucycles = cp->cpucycles;
+  cpu->pc = cp->pc;
+  cpu->a = cp->a;
+  cpu->x = cp->x;
+  cpu->y = cp->y;
+  cpu->flags = cp->flags;
+  cpu->sp = cp->sp;
+  frame = cp->frame;
+  free(cp);
+  return frame;
+}
+
+// Store the state before play call frame, if it is the next checkpoint
+// the file is missing
+void checkpoint_save(CHECKPOINTFILE *ck, unsigned frame, const CPUCONTEXT *cpu)
+{
+  CHECKPOINT *cp;
+
+  if ((!frame) || (frame != (ck->header.count + 1) * ck->header.interval)) return;
+  cp = malloc(sizeof *cp);
+  if (!cp) return;
+  memset(cp, 0, sizeof *cp);
+  cp->frame = frame;
+  cp->cpucycles = cpu->cpucycles;
+  cp->pc = cpu->pc;
+  cp->a = cpu->a;
+  cp->x = cpu->x;
+  cp->y = cpu->y;
+  cp->flags = cpu->flags;
+  cp->sp = cpu->sp;
+  memcpy(cp->mem, cpu->mem, 0x10000);
+  fseek(ck->file, sizeof ck->header + (long)ck->header.count * sizeof *cp, SEEK_SET);
+  if (fwrite(cp, sizeof *cp, 1, ck->file) == 1)
+  {
+    ck->header.count++;
+    writeheader(ck);
+  }
+  free(cp);
+}
+
+void checkpoint_close(CHECKPOINTFILE *ck)
+{
+  if (ck->file) fclose(ck->file);
+  ck->file = NULL;
+}
@@ -0,0 +1,24 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stdio.h>
+#include "cpu.h"
+#include "dumpformat.h"
+
+// Default frames between checkpoints (10 seconds)
+#define CHECKPOINT_INTERVAL 500
+
+// Open checkpoint cache for one SID file and subtune
+typedef struct
+{
+  FILE *file;
+  CHECKPOINTHEADER header;
+} CHECKPOINTFILE;
+
+unsigned long long checkpoint_hashfile(const char *sidname);
+int checkpoint_open(CHECKPOINTFILE *ck, const char *cachedir, unsigned long long sidhash, int subtune, unsigned short playaddress, unsigned interval);
+unsigned checkpoint_restore(CHECKPOINTFILE *ck, unsigned frame, CPUCONTEXT *cpu);
+void checkpoint_save(CHECKPOINTFILE *ck, unsigned frame, const CPUCONTEXT *cpu);
+void checkpoint_close(CHECKPOINTFILE *ck);
+
+#endif
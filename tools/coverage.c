@@ -0,0 +1,89 @@
+#include <stdlib.h>
+#include <string.h>
+#include "coverage.h"
+
+static void coverage_reset(COVERAGE *cov, uint32_t frame)
+{
+  memset(cov->snap, 0, sizeof *cov->snap);
+  cov->snap->firstframe = frame;
+  cov->snap->lastframe = frame;
+}
+
+static void coverage_write(COVERAGE *cov)
+{
+  if (fwrite(cov->snap, sizeof *cov->snap, 1, cov->out) != 1) cov->error = 1;
+  cov->header.snapshotcount++;
+}
+
+// Create the coverage file, leaving room for the header and the first-touch
+// array, and start the init snapshot. Returns 0 on success.
+int coverage_open(COVERAGE *cov, const char *filename, int subtune, unsigned interval)
+{
+  unsigned c;
+
+  memset(cov, 0, sizeof *cov);
+  memcpy(cov->header.magic, COVERAGE_MAGIC, 4);
+  cov->header.version = COVERAGE_VERSION;
+  cov->header.headersize = sizeof(COVERAGEHEADER);
+  cov->header.snapshotsize = sizeof(COVERAGESNAPSHOT);
+  cov->header.interval = interval;
+  cov->header.subtune = subtune;
+  cov->header.snapshotoffset = sizeof(COVERAGEHEADER) + 0x10000 * sizeof(uint32_t);
+
+  cov->snap = malloc(sizeof(COVERAGESNAPSHOT));
+  cov->firsttouch = malloc(0x10000 * sizeof(uint32_t));
+  if ((!cov->snap) || (!cov->firsttouch)) goto fail;
+  for (c = 0; c < 0x10000; c++) cov->firsttouch[c] = COVERAGE_NEVER;
+  cov->out = fopen(filename, "wb");
+  if (!cov->out) goto fail;
+  if (fwrite(&cov->header, sizeof cov->header, 1, cov->out) != 1) cov->error = 1;
+  if (fwrite(cov->firsttouch, sizeof(uint32_t), 0x10000, cov->out) != 0x10000) cov->error = 1;
+  cov->frame = COVERAGE_INITFRAME;
+  coverage_reset(cov, COVERAGE_INITFRAME);
+  return 0;
+
+fail:
+  free(cov->snap);
+  free(cov->firsttouch);
+  memset(cov, 0, sizeof *cov);
+  return 1;
+}
+
+// Start play call frame: the init snapshot, or a snapshot whose interval
+// frame leaves, is written out first
+void coverage_frame(COVERAGE *cov, unsigned frame)
+{
+  unsigned interval = cov->header.interval;
+
+  if ((cov->snap->firstframe == COVERAGE_INITFRAME) ||
+    ((interval) && (frame / interval != cov->snap->firstframe / interval)))
+  {
+    coverage_write(cov);
+    coverage_reset(cov, frame);
+  }
+  cov->snap->lastframe = frame;
+  cov->frame = frame;
+}
+
+// Write the last snapshot, the first-touch array and the header and close
+// the file. Returns 0 if everything was written.
+int coverage_close(COVERAGE *cov)
+{
+  int error;
+
+  if (!cov->out) return 1;
+  coverage_write(cov);
+  if (!fseek(cov->out, 0, SEEK_SET))
+  {
+    if (fwrite(&cov->header, sizeof cov->header, 1, cov->out) != 1) cov->error = 1;
+    if (fwrite(cov->firsttouch, sizeof(uint32_t), 0x10000, cov->out) != 0x10000) cov->error = 1;
+  }
+  else
+    cov->error = 1;
+  if (fclose(cov->out)) cov->error = 1;
+  free(cov->snap);
+  free(cov->firsttouch);
+  error = cov->error;
+  memset(cov, 0, sizeof *cov);
+  return error;
+}
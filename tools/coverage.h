@@ -0,0 +1,32 @@
+#ifndef COVERAGE_H
+#define COVERAGE_H
+
+#include <stdio.h>
+#include "dumpformat.h"
+
+// Memory coverage sink. The accesses of the current snapshot are collected
+// in snap and written out when the next one starts; firsttouch is kept in
+// memory for the whole run and written by coverage_close(), which also
+// fills in the header snapshot count.
+typedef struct
+{
+  FILE *out;
+  COVERAGEHEADER header;
+  COVERAGESNAPSHOT *snap;
+  uint32_t *firsttouch;
+  uint32_t frame;
+  int error;
+} COVERAGE;
+
+int coverage_open(COVERAGE *cov, const char *filename, int subtune, unsigned interval);
+void coverage_frame(COVERAGE *cov, unsigned frame);
+int coverage_close(COVERAGE *cov);
+
+// Mark an access in one of the current snapshot's maps
+static inline void coverage_mark(COVERAGE *cov, uint8_t *map, unsigned short address)
+{
+  map[address >> 3] |= 1 << (address & 7);
+  if (cov->firsttouch[address] == COVERAGE_NEVER) cov->firsttouch[address] = cov->frame;
+}
+
+#endif
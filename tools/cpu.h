@@ -1,5 +1,92 @@
+#ifndef CPU_H
+#define CPU_H
+
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct CPUCONTEXT;
+
+// Memory-access observer for runcpu_ctx_observed(). exec is called with the
+// address of each instruction before it executes, read after each data read
+// and write after each store (value is the byte read or written). Any of the
+// callbacks may be NULL.
+typedef struct CPUOBSERVER
+{
+  void (*exec)(void *user, const struct CPUCONTEXT *ctx, unsigned short address);
+  void (*read)(void *user, const struct CPUCONTEXT *ctx, unsigned short address, unsigned char value);
+  void (*write)(void *user, const struct CPUCONTEXT *ctx, unsigned short address, unsigned char value);
+  void *user;
+} CPUOBSERVER;
+
+// Emulated machine state. Each context is independent, so several tunes can
+// be emulated in one process (one context per thread). mem must point to
+// 64KB of C64 memory owned by the caller.
+typedef struct CPUCONTEXT
+{
+  unsigned char *mem;
+  unsigned int cpucycles;
+  unsigned short pc;
+  unsigned char a;
+  unsigned char x;
+  unsigned char y;
+  unsigned char flags;
+  unsigned char sp;
+  int error;
+  unsigned char errorop;
+  unsigned short errorpc;
+  const CPUOBSERVER *observer;
+} CPUCONTEXT;
+
+// CPUCONTEXT.error values, set when runcpu_ctx() returns -1
+#define CPUERR_NONE 0
+#define CPUERR_HALT 1
+#define CPUERR_ILLEGAL 2
+
+void initcpu_ctx(CPUCONTEXT *ctx, unsigned short newpc, unsigned char newa, unsigned char newx, unsigned char newy);
+int runcpu_ctx(CPUCONTEXT *ctx);
+// As runcpu_ctx(), reporting memory accesses to ctx->observer. runcpu_ctx()
+// itself has no hooks, so the plain core pays nothing for them.
+int runcpu_ctx_observed(CPUCONTEXT *ctx);
+
+// runcpu_ctx_run() results besides 0 (routine returned) and -1 (CPU error)
+#define CPURUN_STOP 1
+#define CPURUN_LIMIT 2
+
+// Run until the routine returns: the same instructions and cycle counts
+// as calling runcpu_ctx() until it returns <= 0, without a call per
+// instruction. *instr counts the instructions that didn't return; the run
+// stops with CPURUN_LIMIT once it exceeds maxinstr, and with CPURUN_STOP
+// after an instruction that leaves pc at stop1 or stop2. A stopped run can
+// be resumed by calling again.
+int runcpu_ctx_run(CPUCONTEXT *ctx, unsigned *instr, unsigned maxinstr, unsigned short stop1, unsigned short stop2);
+
+// Cache of decoded basic blocks for runcpu_ctx_blocks(), one per context.
+// Writes made by runcpu_ctx_blocks() invalidate the affected blocks; after
+// changing memory any other way (initroutine, loading a snapshot) call
+// cpublocks_flush().
+typedef struct CPUBLOCKCACHE CPUBLOCKCACHE;
+
+CPUBLOCKCACHE *cpublocks_create(void);
+void cpublocks_flush(CPUBLOCKCACHE *cache);
+void cpublocks_free(CPUBLOCKCACHE *cache);
+
+// As runcpu_ctx_run(), executing decoded blocks from the cache
+int runcpu_ctx_blocks(CPUCONTEXT *ctx, CPUBLOCKCACHE *cache, unsigned *instr, unsigned maxinstr, unsigned short stop1, unsigned short stop2);
+void printcpuerror(FILE *out, const CPUCONTEXT *ctx);
+
+// Single-machine API on a process-wide context. runcpu() exits the process
+// on a CPU error, as it always has.
 extern unsigned char mem[];
 extern unsigned int cpucycles;
 extern unsigned short pc;
 void initcpu(unsigned short newpc, unsigned char newa, unsigned char newx, unsigned char newy);
 int runcpu(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,1603 @@
+/*
+ * cpu_core.h - 6502 instruction core
+ *
+ * Included once per observer policy to generate a run function. Before
+ * including, define:
+ *
+ *   CPU_CORE                               name of the generated function
+ *   CPU_OBSERVE_EXEC(ctx, address)         before each instruction
+ *   CPU_OBSERVE_READ(ctx, address, value)  after each data read
+ *   CPU_OBSERVE_WRITE(ctx, address, value) after each write
+ *
+ * and optionally CPU_CORE_RUN to generate the run-until-return form
+ * (see runcpu_ctx_run() in cpu.h) instead of a single-instruction step.
+ * The run form keeps the registers in locals and, with GCC, dispatches
+ * through a computed-goto table instead of the switch. CPU_CORE_BLOCKS
+ * in addition makes the run form execute decoded basic blocks from a
+ * CPUBLOCKCACHE (see cpu.c) instead of fetching from memory; the write
+ * observer must then invalidate blocks that are written to and set
+ * cpu_invalidated if it did.
+ *
+ * With empty observer macros the generated core accesses memory as a bare
+ * ctx->mem[] index. The macros are undefined again at the end of this file.
+ */
+
+#ifndef CPU_CORE_COMMON
+#define CPU_CORE_COMMON
+
+#define CPU_CORE_CONCAT2(a, b) a##b
+#define CPU_CORE_CONCAT(a, b) CPU_CORE_CONCAT2(a, b)
+#define CPU_CORE_READFN CPU_CORE_CONCAT(CPU_CORE, _read)
+
+#define FN 0x80
+#define FV 0x40
+#define FB 0x10
+#define FD 0x08
+#define FI 0x04
+#define FZ 0x02
+#define FC 0x01
+
+
+// Memory access. MEM() is the raw lvalue; data reads go through READ() and
+// stores are followed by WRITE() so the observer hooks see them. Operand
+// bytes and the zeropage pointers of (zp,x)/(zp),y are fetched with MEM()
+// and are not reported. CPU_MEMORY is the memory pointer of the core,
+// CPU_OPERAND_LO/HI the operand bytes of the current instruction.
+#define MEM(address) (CPU_MEMORY[address])
+#define READ(address) (CPU_CORE_READFN(ctx, CPU_MEMORY, address))
+#define LO() (CPU_OPERAND_LO)
+#define HI() (CPU_OPERAND_HI)
+#define FETCH() (MEM(pc++))
+#define SETPC(newpc) (pc = (newpc))
+#define PUSH(data) {MEM(0x100 + sp) = (data); WRITE(0x100 + sp); sp--;}
+#define POP() (READ(0x100 + (++sp)))
+
+#define IMMEDIATE() (LO())
+#define ABSOLUTE() (LO() | (HI() << 8))
+#define ABSOLUTEX() (((LO() | (HI() << 8)) + x) & 0xffff)
+#define ABSOLUTEY() (((LO() | (HI() << 8)) + y) & 0xffff)
+#define ZEROPAGE() (LO() & 0xff)
+#define ZEROPAGEX() ((LO() + x) & 0xff)
+#define ZEROPAGEY() ((LO() + y) & 0xff)
+#define INDIRECTX() (MEM((LO() + x) & 0xff) | (MEM((LO() + x + 1) & 0xff) << 8))
+#define INDIRECTY() (((MEM(LO()) | (MEM((LO() + 1) & 0xff) << 8)) + y) & 0xffff)
+#define INDIRECTZP() (((MEM(LO()) | (MEM((LO() + 1) & 0xff) << 8)) + 0) & 0xffff)
+
+#define WRITE(address) CPU_OBSERVE_WRITE(ctx, address, MEM(address))
+#define RMWREAD(address) CPU_OBSERVE_READ(ctx, address, MEM(address))
+
+#define EVALPAGECROSSING(baseaddr, realaddr) ((((baseaddr) ^ (realaddr)) & 0xff00) ? 1 : 0)
+#define EVALPAGECROSSING_ABSOLUTEX() (EVALPAGECROSSING(ABSOLUTE(), ABSOLUTEX()))
+#define EVALPAGECROSSING_ABSOLUTEY() (EVALPAGECROSSING(ABSOLUTE(), ABSOLUTEY()))
+#define EVALPAGECROSSING_INDIRECTY() (EVALPAGECROSSING(INDIRECTZP(), INDIRECTY()))
+
+#define BRANCH()                                          \
+{                                                         \
+  ++cpucycles;                                            \
+  temp = LO();                                            \
+  pc++;                                                   \
+  if (temp < 0x80)                                        \
+  {                                                       \
+    cpucycles += EVALPAGECROSSING(pc, pc + temp);         \
+    SETPC(pc + temp);                                     \
+  }                                                       \
+  else                                                    \
+  {                                                       \
+    cpucycles += EVALPAGECROSSING(pc, pc + temp - 0x100); \
+    SETPC(pc + temp - 0x100);                             \
+  }                                                       \
+}
+
+#define SETFLAGS(data)                  \
+{                                       \
+  if (!(data))                          \
+    flags = (flags & ~FN) | FZ;         \
+  else                                  \
+    flags = (flags & ~(FN|FZ)) |        \
+    ((data) & FN);                      \
+}
+
+#define ASSIGNSETFLAGS(dest, data)      \
+{                                       \
+  dest = data;                          \
+  if (!dest)                            \
+    flags = (flags & ~FN) | FZ;         \
+  else                                  \
+    flags = (flags & ~(FN|FZ)) |        \
+    (dest & FN);                        \
+}
+
+#define ADC(data)                                                        \
+{                                                                        \
+    unsigned tempval = data;                                             \
+                                                                         \
+    if (flags & FD)                                                      \
+    {                                                                    \
+        temp = (a & 0xf) + (tempval & 0xf) + (flags & FC);               \
+        if (temp > 0x9)                                                  \
+            temp += 0x6;                                                 \
+        if (temp <= 0x0f)                                                \
+            temp = (temp & 0xf) + (a & 0xf0) + (tempval & 0xf0);         \
+        else                                                             \
+            temp = (temp & 0xf) + (a & 0xf0) + (tempval & 0xf0) + 0x10;  \
+        if (!((a + tempval + (flags & FC)) & 0xff))                      \
+            flags |= FZ;                                                 \
+        else                                                             \
+            flags &= ~FZ;                                                \
+        if (temp & 0x80)                                                 \
+            flags |= FN;                                                 \
+        else                                                             \
+            flags &= ~FN;                                                \
+        if (((a ^ temp) & 0x80) && !((a ^ tempval) & 0x80))              \
+            flags |= FV;                                                 \
+        else                                                             \
+            flags &= ~FV;                                                \
+        if ((temp & 0x1f0) > 0x90) temp += 0x60;                         \
+        if ((temp & 0xff0) > 0xf0)                                       \
+            flags |= FC;                                                 \
+        else                                                             \
+            flags &= ~FC;                                                \
+    }                                                                    \
+    else                                                                 \
+    {                                                                    \
+        temp = tempval + a + (flags & FC);                               \
+        SETFLAGS(temp & 0xff);                                           \
+        if (!((a ^ tempval) & 0x80) && ((a ^ temp) & 0x80))              \
+            flags |= FV;                                                 \
+        else                                                             \
+            flags &= ~FV;                                                \
+        if (temp > 0xff)                                                 \
+            flags |= FC;                                                 \
+        else                                                             \
+            flags &= ~FC;                                                \
+    }                                                                    \
+    a = temp;                                                            \
+}
+
+#define SBC(data)                                                        \
+{                                                                        \
+    unsigned tempval = data;                                             \
+    temp = a - tempval - ((flags & FC) ^ FC);                            \
+                                                                         \
+    if (flags & FD)                                                      \
+    {                                                                    \
+        unsigned tempval2;                                               \
+        tempval2 = (a & 0xf) - (tempval & 0xf) - ((flags & FC) ^ FC);    \
+        if (tempval2 & 0x10)                                             \
+            tempval2 = ((tempval2 - 6) & 0xf) | ((a & 0xf0) - (tempval   \
+            & 0xf0) - 0x10);                                             \
+        else                                                             \
+            tempval2 = (tempval2 & 0xf) | ((a & 0xf0) - (tempval         \
+            & 0xf0));                                                    \
+        if (tempval2 & 0x100)                                            \
+            tempval2 -= 0x60;                                            \
+        if (temp < 0x100)                                                \
+            flags |= FC;                                                 \
+        else                                                             \
+            flags &= ~FC;                                                \
+        SETFLAGS(temp & 0xff);                                           \
+        if (((a ^ temp) & 0x80) && ((a ^ tempval) & 0x80))               \
+            flags |= FV;                                                 \
+        else                                                             \
+            flags &= ~FV;                                                \
+        a = tempval2;                                                    \
+    }                                                                    \
+    else                                                                 \
+    {                                                                    \
+        SETFLAGS(temp & 0xff);                                           \
+        if (temp < 0x100)                                                \
+            flags |= FC;                                                 \
+        else                                                             \
+            flags &= ~FC;                                                \
+        if (((a ^ temp) & 0x80) && ((a ^ tempval) & 0x80))               \
+            flags |= FV;                                                 \
+        else                                                             \
+            flags &= ~FV;                                                \
+        a = temp;                                                        \
+    }                                                                    \
+}
+
+#define CMP(src, data)                  \
+{                                       \
+  unsigned tempval = data;              \
+  temp = (src - tempval) & 0xff;        \
+                                        \
+  flags = (flags & ~(FC|FN|FZ)) |       \
+          (temp & FN);                  \
+                                        \
+  if (!temp) flags |= FZ;               \
+  if (src >= tempval) flags |= FC;      \
+}
+
+#define ASL(data)                       \
+{                                       \
+  temp = data;                          \
+  temp <<= 1;                           \
+  if (temp & 0x100) flags |= FC;        \
+  else flags &= ~FC;                    \
+  ASSIGNSETFLAGS(data, temp);           \
+}
+
+#define LSR(data)                       \
+{                                       \
+  temp = data;                          \
+  if (temp & 1) flags |= FC;            \
+  else flags &= ~FC;                    \
+  temp >>= 1;                           \
+  ASSIGNSETFLAGS(data, temp);           \
+}
+
+#define ROL(data)                       \
+{                                       \
+  temp = data;                          \
+  temp <<= 1;                           \
+  if (flags & FC) temp |= 1;            \
+  if (temp & 0x100) flags |= FC;        \
+  else flags &= ~FC;                    \
+  ASSIGNSETFLAGS(data, temp);           \
+}
+
+#define ROR(data)                       \
+{                                       \
+  temp = data;                          \
+  if (flags & FC) temp |= 0x100;        \
+  if (temp & 1) flags |= FC;            \
+  else flags &= ~FC;                    \
+  temp >>= 1;                           \
+  ASSIGNSETFLAGS(data, temp);           \
+}
+
+#define DEC(data)                       \
+{                                       \
+  temp = data - 1;                      \
+  ASSIGNSETFLAGS(data, temp);           \
+}
+
+#define INC(data)                       \
+{                                       \
+  temp = data + 1;                      \
+  ASSIGNSETFLAGS(data, temp);           \
+}
+
+#define EOR(data)                       \
+{                                       \
+  a ^= data;                            \
+  SETFLAGS(a);                          \
+}
+
+#define ORA(data)                       \
+{                                       \
+  a |= data;                            \
+  SETFLAGS(a);                          \
+}
+
+#define AND(data)                       \
+{                                       \
+  a &= data;                            \
+  SETFLAGS(a)                           \
+}
+
+#define BIT(data)                       \
+{                                       \
+  unsigned tempval = data;              \
+  flags = (flags & ~(FN|FV)) |          \
+          (tempval & (FN|FV));          \
+  if (!(tempval & a)) flags |= FZ;      \
+  else flags &= ~FZ;                    \
+}
+
+static const int cpucycles_table[] = 
+{
+  7,  6,  0,  8,  3,  3,  5,  5,  3,  2,  2,  2,  4,  4,  6,  6, 
+  2,  5,  0,  8,  4,  4,  6,  6,  2,  4,  2,  7,  4,  4,  7,  7, 
+  6,  6,  0,  8,  3,  3,  5,  5,  4,  2,  2,  2,  4,  4,  6,  6, 
+  2,  5,  0,  8,  4,  4,  6,  6,  2,  4,  2,  7,  4,  4,  7,  7, 
+  6,  6,  0,  8,  3,  3,  5,  5,  3,  2,  2,  2,  3,  4,  6,  6, 
+  2,  5,  0,  8,  4,  4,  6,  6,  2,  4,  2,  7,  4,  4,  7,  7, 
+  6,  6,  0,  8,  3,  3,  5,  5,  4,  2,  2,  2,  5,  4,  6,  6, 
+  2,  5,  0,  8,  4,  4,  6,  6,  2,  4,  2,  7,  4,  4,  7,  7, 
+  2,  6,  2,  6,  3,  3,  3,  3,  2,  2,  2,  2,  4,  4,  4,  4, 
+  2,  6,  0,  6,  4,  4,  4,  4,  2,  5,  2,  5,  5,  5,  5,  5, 
+  2,  6,  2,  6,  3,  3,  3,  3,  2,  2,  2,  2,  4,  4,  4,  4, 
+  2,  5,  0,  5,  4,  4,  4,  4,  2,  4,  2,  4,  4,  4,  4,  4, 
+  2,  6,  2,  8,  3,  3,  5,  5,  2,  2,  2,  2,  4,  4,  6,  6, 
+  2,  5,  0,  8,  4,  4,  6,  6,  2,  4,  2,  7,  4,  4,  7,  7, 
+  2,  6,  2,  8,  3,  3,  5,  5,  2,  2,  2,  2,  4,  4,  6,  6, 
+  2,  5,  0,  8,  4,  4,  6,  6,  2,  4,  2,  7,  4,  4,  7,  7
+};
+
+#endif
+
+// Data read with observer
+static inline unsigned char CPU_CORE_READFN(CPUCONTEXT *ctx, const unsigned char *memory, unsigned short address)
+{
+  unsigned char value = memory[address];
+  CPU_OBSERVE_READ(ctx, address, value);
+  return value;
+}
+
+#if defined(CPU_CORE_RUN) && defined(__GNUC__) && !defined(CPU_NO_THREADED)
+#define CPU_THREADED
+#endif
+
+// Opcode labels and the end of an instruction. The step core is a plain
+// switch that returns 1 after each instruction; the run core counts the
+// instruction, checks the stop conditions and goes on with the next one.
+#ifdef CPU_CORE_BLOCKS
+// Next decoded instruction; look up the block at pc after a block end
+#define CPU_FETCHOP                                                           \
+{                                                                             \
+  if (cpu_ins == cpu_end)                                                     \
+  {                                                                           \
+    const CPUBLOCK *block = cache->blocks[pc];                                \
+    if (!block) block = cpublock_decode(cache, cpumem, pc);                   \
+    cpu_ins = block->ins;                                                     \
+    cpu_end = cpu_ins + block->count;                                         \
+  }                                                                           \
+  op = cpu_ins->op;                                                           \
+  pc++;                                                                       \
+  cpucycles += cpu_ins->cycles;                                               \
+}
+// A write into decoded code may have changed the rest of this block
+#define CPU_ENDOP                                                             \
+{                                                                             \
+  cpu_ins++;                                                                  \
+  if (cpu_invalidated)                                                        \
+  {                                                                           \
+    cpu_invalidated = 0;                                                      \
+    cpu_end = cpu_ins;                                                        \
+  }                                                                           \
+}
+#else
+#define CPU_FETCHOP                                                           \
+{                                                                             \
+  op = FETCH();                                                               \
+  cpucycles += cpucycles_table[op];                                           \
+}
+#define CPU_ENDOP
+#endif
+
+#ifdef CPU_THREADED
+#define CPU_SWITCH(op)
+#define CPU_OP(n) cpu_op_##n:
+#define CPU_OP_DEFAULT cpu_op_default:
+#define CPU_NEXT                                                              \
+{                                                                             \
+  CPU_ENDOP;                                                                  \
+  if (++count > maxinstr) CPU_RETURN(CPURUN_LIMIT);                           \
+  if ((pc == stop1) || (pc == stop2)) CPU_RETURN(CPURUN_STOP);                \
+  CPU_OBSERVE_EXEC(ctx, pc);                                                  \
+  CPU_FETCHOP;                                                                \
+  goto *cpu_dispatch[op];                                                     \
+}
+#else
+#define CPU_SWITCH(op) switch(op)
+#define CPU_OP(n) case n:
+#define CPU_OP_DEFAULT default:
+#define CPU_NEXT break
+#endif
+
+#ifdef CPU_CORE_BLOCKS
+#define CPU_OPERAND_LO (cpu_ins->operand & 0xff)
+#define CPU_OPERAND_HI (cpu_ins->operand >> 8)
+#else
+#define CPU_OPERAND_LO (MEM(pc))
+#define CPU_OPERAND_HI (MEM(pc+1))
+#endif
+
+#ifdef CPU_CORE_RUN
+#define CPU_RETURN(value) {result = (value); goto cpu_done;}
+#define CPU_MEMORY cpumem
+
+#ifdef CPU_CORE_BLOCKS
+int CPU_CORE(CPUCONTEXT *ctx, CPUBLOCKCACHE *cache, unsigned *instr, unsigned maxinstr, unsigned short stop1, unsigned short stop2)
+#else
+int CPU_CORE(CPUCONTEXT *ctx, unsigned *instr, unsigned maxinstr, unsigned short stop1, unsigned short stop2)
+#endif
+{
+  unsigned char *cpumem = ctx->mem;
+  unsigned short cpu_pc = ctx->pc;
+  unsigned char cpu_a = ctx->a;
+  unsigned char cpu_x = ctx->x;
+  unsigned char cpu_y = ctx->y;
+  unsigned char cpu_flags = ctx->flags;
+  unsigned char cpu_sp = ctx->sp;
+  unsigned int cpu_cycles = ctx->cpucycles;
+  unsigned count = *instr;
+  int result;
+  unsigned temp;
+  unsigned char op;
+#ifdef CPU_CORE_BLOCKS
+  const CPUINSTR *cpu_ins = NULL;
+  const CPUINSTR *cpu_end = NULL;
+  int cpu_invalidated = 0;
+#endif
+#ifdef CPU_THREADED
+  static void *const cpu_dispatch[256] = {
+    [0 ... 255] = &&cpu_op_default,
+    [0x00] = &&cpu_op_0x00,
+    [0x01] = &&cpu_op_0x01,
+    [0x02] = &&cpu_op_0x02,
+    [0x04] = &&cpu_op_0x04,
+    [0x05] = &&cpu_op_0x05,
+    [0x06] = &&cpu_op_0x06,
+    [0x08] = &&cpu_op_0x08,
+    [0x09] = &&cpu_op_0x09,
+    [0x0a] = &&cpu_op_0x0a,
+    [0x0c] = &&cpu_op_0x0c,
+    [0x0d] = &&cpu_op_0x0d,
+    [0x0e] = &&cpu_op_0x0e,
+    [0x10] = &&cpu_op_0x10,
+    [0x11] = &&cpu_op_0x11,
+    [0x14] = &&cpu_op_0x14,
+    [0x15] = &&cpu_op_0x15,
+    [0x16] = &&cpu_op_0x16,
+    [0x18] = &&cpu_op_0x18,
+    [0x19] = &&cpu_op_0x19,
+    [0x1a] = &&cpu_op_0x1a,
+    [0x1c] = &&cpu_op_0x1c,
+    [0x1d] = &&cpu_op_0x1d,
+    [0x1e] = &&cpu_op_0x1e,
+    [0x20] = &&cpu_op_0x20,
+    [0x21] = &&cpu_op_0x21,
+    [0x24] = &&cpu_op_0x24,
+    [0x25] = &&cpu_op_0x25,
+    [0x26] = &&cpu_op_0x26,
+    [0x28] = &&cpu_op_0x28,
+    [0x29] = &&cpu_op_0x29,
+    [0x2a] = &&cpu_op_0x2a,
+    [0x2c] = &&cpu_op_0x2c,
+    [0x2d] = &&cpu_op_0x2d,
+    [0x2e] = &&cpu_op_0x2e,
+    [0x30] = &&cpu_op_0x30,
+    [0x31] = &&cpu_op_0x31,
+    [0x34] = &&cpu_op_0x34,
+    [0x35] = &&cpu_op_0x35,
+    [0x36] = &&cpu_op_0x36,
+    [0x38] = &&cpu_op_0x38,
+    [0x39] = &&cpu_op_0x39,
+    [0x3a] = &&cpu_op_0x3a,
+    [0x3c] = &&cpu_op_0x3c,
+    [0x3d] = &&cpu_op_0x3d,
+    [0x3e] = &&cpu_op_0x3e,
+    [0x40] = &&cpu_op_0x40,
+    [0x41] = &&cpu_op_0x41,
+    [0x44] = &&cpu_op_0x44,
+    [0x45] = &&cpu_op_0x45,
+    [0x46] = &&cpu_op_0x46,
+    [0x48] = &&cpu_op_0x48,
+    [0x49] = &&cpu_op_0x49,
+    [0x4a] = &&cpu_op_0x4a,
+    [0x4c] = &&cpu_op_0x4c,
+    [0x4d] = &&cpu_op_0x4d,
+    [0x4e] = &&cpu_op_0x4e,
+    [0x50] = &&cpu_op_0x50,
+    [0x51] = &&cpu_op_0x51,
+    [0x54] = &&cpu_op_0x54,
+    [0x55] = &&cpu_op_0x55,
+    [0x56] = &&cpu_op_0x56,
+    [0x58] = &&cpu_op_0x58,
+    [0x59] = &&cpu_op_0x59,
+    [0x5a] = &&cpu_op_0x5a,
+    [0x5c] = &&cpu_op_0x5c,
+    [0x5d] = &&cpu_op_0x5d,
+    [0x5e] = &&cpu_op_0x5e,
+    [0x60] = &&cpu_op_0x60,
+    [0x61] = &&cpu_op_0x61,
+    [0x64] = &&cpu_op_0x64,
+    [0x65] = &&cpu_op_0x65,
+    [0x66] = &&cpu_op_0x66,
+    [0x68] = &&cpu_op_0x68,
+    [0x69] = &&cpu_op_0x69,
+    [0x6a] = &&cpu_op_0x6a,
+    [0x6c] = &&cpu_op_0x6c,
+    [0x6d] = &&cpu_op_0x6d,
+    [0x6e] = &&cpu_op_0x6e,
+    [0x70] = &&cpu_op_0x70,
+    [0x71] = &&cpu_op_0x71,
+    [0x74] = &&cpu_op_0x74,
+    [0x75] = &&cpu_op_0x75,
+    [0x76] = &&cpu_op_0x76,
+    [0x78] = &&cpu_op_0x78,
+    [0x79] = &&cpu_op_0x79,
+    [0x7a] = &&cpu_op_0x7a,
+    [0x7c] = &&cpu_op_0x7c,
+    [0x7d] = &&cpu_op_0x7d,
+    [0x7e] = &&cpu_op_0x7e,
+    [0x80] = &&cpu_op_0x80,
+    [0x81] = &&cpu_op_0x81,
+    [0x82] = &&cpu_op_0x82,
+    [0x84] = &&cpu_op_0x84,
+    [0x85] = &&cpu_op_0x85,
+    [0x86] = &&cpu_op_0x86,
+    [0x88] = &&cpu_op_0x88,
+    [0x89] = &&cpu_op_0x89,
+    [0x8a] = &&cpu_op_0x8a,
+    [0x8c] = &&cpu_op_0x8c,
+    [0x8d] = &&cpu_op_0x8d,
+    [0x8e] = &&cpu_op_0x8e,
+    [0x90] = &&cpu_op_0x90,
+    [0x91] = &&cpu_op_0x91,
+    [0x94] = &&cpu_op_0x94,
+    [0x95] = &&cpu_op_0x95,
+    [0x96] = &&cpu_op_0x96,
+    [0x98] = &&cpu_op_0x98,
+    [0x99] = &&cpu_op_0x99,
+    [0x9a] = &&cpu_op_0x9a,
+    [0x9d] = &&cpu_op_0x9d,
+    [0xa0] = &&cpu_op_0xa0,
+    [0xa1] = &&cpu_op_0xa1,
+    [0xa2] = &&cpu_op_0xa2,
+    [0xa3] = &&cpu_op_0xa3,
+    [0xa4] = &&cpu_op_0xa4,
+    [0xa5] = &&cpu_op_0xa5,
+    [0xa6] = &&cpu_op_0xa6,
+    [0xa7] = &&cpu_op_0xa7,
+    [0xa8] = &&cpu_op_0xa8,
+    [0xa9] = &&cpu_op_0xa9,
+    [0xaa] = &&cpu_op_0xaa,
+    [0xac] = &&cpu_op_0xac,
+    [0xad] = &&cpu_op_0xad,
+    [0xae] = &&cpu_op_0xae,
+    [0xaf] = &&cpu_op_0xaf,
+    [0xb0] = &&cpu_op_0xb0,
+    [0xb1] = &&cpu_op_0xb1,
+    [0xb3] = &&cpu_op_0xb3,
+    [0xb4] = &&cpu_op_0xb4,
+    [0xb5] = &&cpu_op_0xb5,
+    [0xb6] = &&cpu_op_0xb6,
+    [0xb7] = &&cpu_op_0xb7,
+    [0xb8] = &&cpu_op_0xb8,
+    [0xb9] = &&cpu_op_0xb9,
+    [0xba] = &&cpu_op_0xba,
+    [0xbc] = &&cpu_op_0xbc,
+    [0xbd] = &&cpu_op_0xbd,
+    [0xbe] = &&cpu_op_0xbe,
+    [0xc0] = &&cpu_op_0xc0,
+    [0xc1] = &&cpu_op_0xc1,
+    [0xc2] = &&cpu_op_0xc2,
+    [0xc4] = &&cpu_op_0xc4,
+    [0xc5] = &&cpu_op_0xc5,
+    [0xc6] = &&cpu_op_0xc6,
+    [0xc8] = &&cpu_op_0xc8,
+    [0xc9] = &&cpu_op_0xc9,
+    [0xca] = &&cpu_op_0xca,
+    [0xcc] = &&cpu_op_0xcc,
+    [0xcd] = &&cpu_op_0xcd,
+    [0xce] = &&cpu_op_0xce,
+    [0xd0] = &&cpu_op_0xd0,
+    [0xd1] = &&cpu_op_0xd1,
+    [0xd4] = &&cpu_op_0xd4,
+    [0xd5] = &&cpu_op_0xd5,
+    [0xd6] = &&cpu_op_0xd6,
+    [0xd8] = &&cpu_op_0xd8,
+    [0xd9] = &&cpu_op_0xd9,
+    [0xda] = &&cpu_op_0xda,
+    [0xdc] = &&cpu_op_0xdc,
+    [0xdd] = &&cpu_op_0xdd,
+    [0xde] = &&cpu_op_0xde,
+    [0xe0] = &&cpu_op_0xe0,
+    [0xe1] = &&cpu_op_0xe1,
+    [0xe2] = &&cpu_op_0xe2,
+    [0xe4] = &&cpu_op_0xe4,
+    [0xe5] = &&cpu_op_0xe5,
+    [0xe6] = &&cpu_op_0xe6,
+    [0xe8] = &&cpu_op_0xe8,
+    [0xe9] = &&cpu_op_0xe9,
+    [0xea] = &&cpu_op_0xea,
+    [0xeb] = &&cpu_op_0xeb,
+    [0xec] = &&cpu_op_0xec,
+    [0xed] = &&cpu_op_0xed,
+    [0xee] = &&cpu_op_0xee,
+    [0xf0] = &&cpu_op_0xf0,
+    [0xf1] = &&cpu_op_0xf1,
+    [0xf4] = &&cpu_op_0xf4,
+    [0xf5] = &&cpu_op_0xf5,
+    [0xf6] = &&cpu_op_0xf6,
+    [0xf8] = &&cpu_op_0xf8,
+    [0xf9] = &&cpu_op_0xf9,
+    [0xfa] = &&cpu_op_0xfa,
+    [0xfc] = &&cpu_op_0xfc,
+    [0xfd] = &&cpu_op_0xfd,
+    [0xfe] = &&cpu_op_0xfe,
+  };
+#endif
+
+// The instruction macros refer to the registers by name; map them onto the
+// locals for the duration of the core.
+#define pc cpu_pc
+#define a cpu_a
+#define x cpu_x
+#define y cpu_y
+#define flags cpu_flags
+#define sp cpu_sp
+#define cpucycles cpu_cycles
+
+  for (;;)
+  {
+#else
+#define CPU_RETURN(value) return (value)
+#define CPU_MEMORY (ctx->mem)
+
+int CPU_CORE(CPUCONTEXT *ctx)
+{
+  unsigned temp;
+  unsigned char op;
+
+// The instruction macros refer to the registers by name; map them onto the
+// context for the duration of the core.
+#define pc (ctx->pc)
+#define a (ctx->a)
+#define x (ctx->x)
+#define y (ctx->y)
+#define flags (ctx->flags)
+#define sp (ctx->sp)
+#define cpucycles (ctx->cpucycles)
+
+  {
+#endif
+  CPU_OBSERVE_EXEC(ctx, pc);
+  /* printf("PC: %04x OP: %02x A:%02x X:%02x Y:%02x\n", pc, MEM(pc), a, x, y); */
+  CPU_FETCHOP;
+#ifdef CPU_THREADED
+  goto *cpu_dispatch[op];
+#endif
+  CPU_SWITCH(op)
+  {
+    CPU_OP(0xa7)
+    ASSIGNSETFLAGS(a, READ(ZEROPAGE()));
+    x = a;
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0xb7)
+    ASSIGNSETFLAGS(a, READ(ZEROPAGEY()));
+    x = a;
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0xaf)
+    ASSIGNSETFLAGS(a, READ(ABSOLUTE()));
+    x = a;
+    pc += 2;
+    CPU_NEXT;
+
+    CPU_OP(0xa3)
+    ASSIGNSETFLAGS(a, READ(INDIRECTX()));
+    x = a;
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0xb3)
+    cpucycles += EVALPAGECROSSING_INDIRECTY();
+    ASSIGNSETFLAGS(a, READ(INDIRECTY()));
+    x = a;
+    pc++;
+    CPU_NEXT;
+    
+    CPU_OP(0x1a)
+    CPU_OP(0x3a)
+    CPU_OP(0x5a)
+    CPU_OP(0x7a)
+    CPU_OP(0xda)
+    CPU_OP(0xfa)
+    CPU_NEXT;
+    
+    CPU_OP(0x80)
+    CPU_OP(0x82)
+    CPU_OP(0x89)
+    CPU_OP(0xc2)
+    CPU_OP(0xe2)
+    CPU_OP(0x04)
+    CPU_OP(0x44)
+    CPU_OP(0x64)
+    CPU_OP(0x14)
+    CPU_OP(0x34)
+    CPU_OP(0x54)
+    CPU_OP(0x74)
+    CPU_OP(0xd4)
+    CPU_OP(0xf4)
+    pc++;
+    CPU_NEXT;
+    
+    CPU_OP(0x0c)
+    CPU_OP(0x1c)
+    CPU_OP(0x3c)
+    CPU_OP(0x5c)
+    CPU_OP(0x7c)
+    CPU_OP(0xdc)
+    CPU_OP(0xfc)
+    cpucycles += EVALPAGECROSSING_ABSOLUTEX();
+    pc += 2;
+    CPU_NEXT;
+
+    CPU_OP(0x69)
+    ADC(IMMEDIATE());
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0x65)
+    ADC(READ(ZEROPAGE()));
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0x75)
+    ADC(READ(ZEROPAGEX()));
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0x6d)
+    ADC(READ(ABSOLUTE()));
+    pc += 2;
+    CPU_NEXT;
+
+    CPU_OP(0x7d)
+    cpucycles += EVALPAGECROSSING_ABSOLUTEX();
+    ADC(READ(ABSOLUTEX()));
+     pc += 2;
+    CPU_NEXT;
+
+    CPU_OP(0x79)
+    cpucycles += EVALPAGECROSSING_ABSOLUTEY();
+    ADC(READ(ABSOLUTEY()));
+    pc += 2;
+    CPU_NEXT;
+
+    CPU_OP(0x61)
+    ADC(READ(INDIRECTX()));
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0x71)
+    cpucycles += EVALPAGECROSSING_INDIRECTY();
+    ADC(READ(INDIRECTY()));
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0x29)
+    AND(IMMEDIATE());
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0x25)
+    AND(READ(ZEROPAGE()));
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0x35)
+    AND(READ(ZEROPAGEX()));
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0x2d)
+    AND(READ(ABSOLUTE()));
+    pc += 2;
+    CPU_NEXT;
+
+    CPU_OP(0x3d)
+    cpucycles += EVALPAGECROSSING_ABSOLUTEX();
+    AND(READ(ABSOLUTEX()));
+    pc += 2;
+    CPU_NEXT;
+
+    CPU_OP(0x39)
+    cpucycles += EVALPAGECROSSING_ABSOLUTEY();
+    AND(READ(ABSOLUTEY()));
+    pc += 2;
+    CPU_NEXT;
+
+    CPU_OP(0x21)
+    AND(READ(INDIRECTX()));
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0x31)
+    cpucycles += EVALPAGECROSSING_INDIRECTY();
+    AND(READ(INDIRECTY()));
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0x0a)
+    ASL(a);
+    CPU_NEXT;
+
+    CPU_OP(0x06)
+    RMWREAD(ZEROPAGE());
+    ASL(MEM(ZEROPAGE()));
+    WRITE(ZEROPAGE());
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0x16)
+    RMWREAD(ZEROPAGEX());
+    ASL(MEM(ZEROPAGEX()));
+    WRITE(ZEROPAGEX());
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0x0e)
+    RMWREAD(ABSOLUTE());
+    ASL(MEM(ABSOLUTE()));
+    WRITE(ABSOLUTE());
+    pc += 2;
+    CPU_NEXT;
+
+    CPU_OP(0x1e)
+    RMWREAD(ABSOLUTEX());
+    ASL(MEM(ABSOLUTEX()));
+    WRITE(ABSOLUTEX());
+    pc += 2;
+    CPU_NEXT;
+
+    CPU_OP(0x90)
+    if (!(flags & FC)) BRANCH()
+    else pc++;
+    CPU_NEXT;
+
+    CPU_OP(0xb0)
+    if (flags & FC) BRANCH()
+    else pc++;
+    CPU_NEXT;
+
+    CPU_OP(0xf0)
+    if (flags & FZ) BRANCH()
+    else pc++;
+    CPU_NEXT;
+
+    CPU_OP(0x24)
+    BIT(READ(ZEROPAGE()));
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0x2c)
+    BIT(READ(ABSOLUTE()));
+    pc += 2;
+    CPU_NEXT;
+
+    CPU_OP(0x30)
+    if (flags & FN) BRANCH()
+    else pc++;
+    CPU_NEXT;
+
+    CPU_OP(0xd0)
+    if (!(flags & FZ)) BRANCH()
+    else pc++;
+    CPU_NEXT;
+
+    CPU_OP(0x10)
+    if (!(flags & FN)) BRANCH()
+    else pc++;
+    CPU_NEXT;
+
+    CPU_OP(0x50)
+    if (!(flags & FV)) BRANCH()
+    else pc++;
+    CPU_NEXT;
+
+    CPU_OP(0x70)
+    if (flags & FV) BRANCH()
+    else pc++;
+    CPU_NEXT;
+
+    CPU_OP(0x18)
+    flags &= ~FC;
+    CPU_NEXT;
+
+    CPU_OP(0xd8)
+    flags &= ~FD;
+    CPU_NEXT;
+
+    CPU_OP(0x58)
+    flags &= ~FI;
+    CPU_NEXT;
+
+    CPU_OP(0xb8)
+    flags &= ~FV;
+    CPU_NEXT;
+
+    CPU_OP(0xc9)
+    CMP(a, IMMEDIATE());
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0xc5)
+    CMP(a, READ(ZEROPAGE()));
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0xd5)
+    CMP(a, READ(ZEROPAGEX()));
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0xcd)
+    CMP(a, READ(ABSOLUTE()));
+    pc += 2;
+    CPU_NEXT;
+
+    CPU_OP(0xdd)
+    cpucycles += EVALPAGECROSSING_ABSOLUTEX();
+    CMP(a, READ(ABSOLUTEX()));
+    pc += 2;
+    CPU_NEXT;
+
+    CPU_OP(0xd9)
+    cpucycles += EVALPAGECROSSING_ABSOLUTEY();
+    CMP(a, READ(ABSOLUTEY()));
+    pc += 2;
+    CPU_NEXT;
+
+    CPU_OP(0xc1)
+    CMP(a, READ(INDIRECTX()));
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0xd1)
+    cpucycles += EVALPAGECROSSING_INDIRECTY();
+    CMP(a, READ(INDIRECTY()));
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0xe0)
+    CMP(x, IMMEDIATE());
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0xe4)
+    CMP(x, READ(ZEROPAGE()));
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0xec)
+    CMP(x, READ(ABSOLUTE()));
+    pc += 2;
+    CPU_NEXT;
+
+    CPU_OP(0xc0)
+    CMP(y, IMMEDIATE());
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0xc4)
+    CMP(y, READ(ZEROPAGE()));
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0xcc)
+    CMP(y, READ(ABSOLUTE()));
+    pc += 2;
+    CPU_NEXT;
+
+    CPU_OP(0xc6)
+    RMWREAD(ZEROPAGE());
+    DEC(MEM(ZEROPAGE()));
+    WRITE(ZEROPAGE());
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0xd6)
+    RMWREAD(ZEROPAGEX());
+    DEC(MEM(ZEROPAGEX()));
+    WRITE(ZEROPAGEX());
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0xce)
+    RMWREAD(ABSOLUTE());
+    DEC(MEM(ABSOLUTE()));
+    WRITE(ABSOLUTE());
+    pc += 2;
+    CPU_NEXT;
+
+    CPU_OP(0xde)
+    RMWREAD(ABSOLUTEX());
+    DEC(MEM(ABSOLUTEX()));
+    WRITE(ABSOLUTEX());
+    pc += 2;
+    CPU_NEXT;
+
+    CPU_OP(0xca)
+    x--;
+    SETFLAGS(x);
+    CPU_NEXT;
+
+    CPU_OP(0x88)
+    y--;
+    SETFLAGS(y);
+    CPU_NEXT;
+
+    CPU_OP(0x49)
+    EOR(IMMEDIATE());
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0x45)
+    EOR(READ(ZEROPAGE()));
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0x55)
+    EOR(READ(ZEROPAGEX()));
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0x4d)
+    EOR(READ(ABSOLUTE()));
+    pc += 2;
+    CPU_NEXT;
+
+    CPU_OP(0x5d)
+    cpucycles += EVALPAGECROSSING_ABSOLUTEX();
+    EOR(READ(ABSOLUTEX()));
+    pc += 2;
+    CPU_NEXT;
+
+    CPU_OP(0x59)
+    cpucycles += EVALPAGECROSSING_ABSOLUTEY();
+    EOR(READ(ABSOLUTEY()));
+    pc += 2;
+    CPU_NEXT;
+
+    CPU_OP(0x41)
+    EOR(READ(INDIRECTX()));
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0x51)
+    cpucycles += EVALPAGECROSSING_INDIRECTY();
+    EOR(READ(INDIRECTY()));
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0xe6)
+    RMWREAD(ZEROPAGE());
+    INC(MEM(ZEROPAGE()));
+    WRITE(ZEROPAGE());
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0xf6)
+    RMWREAD(ZEROPAGEX());
+    INC(MEM(ZEROPAGEX()));
+    WRITE(ZEROPAGEX());
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0xee)
+    RMWREAD(ABSOLUTE());
+    INC(MEM(ABSOLUTE()));
+    WRITE(ABSOLUTE());
+    pc += 2;
+    CPU_NEXT;
+
+    CPU_OP(0xfe)
+    RMWREAD(ABSOLUTEX());
+    INC(MEM(ABSOLUTEX()));
+    WRITE(ABSOLUTEX());
+    pc += 2;
+    CPU_NEXT;
+
+    CPU_OP(0xe8)
+    x++;
+    SETFLAGS(x);
+    CPU_NEXT;
+
+    CPU_OP(0xc8)
+    y++;
+    SETFLAGS(y);
+    CPU_NEXT;
+
+    CPU_OP(0x20)
+    PUSH((pc+1) >> 8);
+    PUSH((pc+1) & 0xff);
+    pc = ABSOLUTE();
+    CPU_NEXT;
+
+    CPU_OP(0x4c)
+    pc = ABSOLUTE();
+    CPU_NEXT;
+
+    CPU_OP(0x6c)
+    {
+      unsigned short adr = ABSOLUTE();
+      pc = (READ(adr) | (READ(((adr + 1) & 0xff) | (adr & 0xff00)) << 8));
+    }
+    CPU_NEXT;
+
+    CPU_OP(0xa9)
+    ASSIGNSETFLAGS(a, IMMEDIATE());
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0xa5)
+    ASSIGNSETFLAGS(a, READ(ZEROPAGE()));
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0xb5)
+    ASSIGNSETFLAGS(a, READ(ZEROPAGEX()));
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0xad)
+    ASSIGNSETFLAGS(a, READ(ABSOLUTE()));
+    pc += 2;
+    CPU_NEXT;
+
+    CPU_OP(0xbd)
+    cpucycles += EVALPAGECROSSING_ABSOLUTEX();
+    ASSIGNSETFLAGS(a, READ(ABSOLUTEX()));
+    pc += 2;
+    CPU_NEXT;
+
+    CPU_OP(0xb9)
+    cpucycles += EVALPAGECROSSING_ABSOLUTEY();
+    ASSIGNSETFLAGS(a, READ(ABSOLUTEY()));
+    pc += 2;
+    CPU_NEXT;
+
+    CPU_OP(0xa1)
+    ASSIGNSETFLAGS(a, READ(INDIRECTX()));
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0xb1)
+    cpucycles += EVALPAGECROSSING_INDIRECTY();
+    ASSIGNSETFLAGS(a, READ(INDIRECTY()));
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0xa2)
+    ASSIGNSETFLAGS(x, IMMEDIATE());
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0xa6)
+    ASSIGNSETFLAGS(x, READ(ZEROPAGE()));
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0xb6)
+    ASSIGNSETFLAGS(x, READ(ZEROPAGEY()));
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0xae)
+    ASSIGNSETFLAGS(x, READ(ABSOLUTE()));
+    pc += 2;
+    CPU_NEXT;
+
+    CPU_OP(0xbe)
+    cpucycles += EVALPAGECROSSING_ABSOLUTEY();
+    ASSIGNSETFLAGS(x, READ(ABSOLUTEY()));
+    pc += 2;
+    CPU_NEXT;
+
+    CPU_OP(0xa0)
+    ASSIGNSETFLAGS(y, IMMEDIATE());
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0xa4)
+    ASSIGNSETFLAGS(y, READ(ZEROPAGE()));
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0xb4)
+    ASSIGNSETFLAGS(y, READ(ZEROPAGEX()));
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0xac)
+    ASSIGNSETFLAGS(y, READ(ABSOLUTE()));
+    pc += 2;
+    CPU_NEXT;
+
+    CPU_OP(0xbc)
+    cpucycles += EVALPAGECROSSING_ABSOLUTEX();
+    ASSIGNSETFLAGS(y, READ(ABSOLUTEX()));
+    pc += 2;
+    CPU_NEXT;
+
+    CPU_OP(0x4a)
+    LSR(a);
+    CPU_NEXT;
+
+    CPU_OP(0x46)
+    RMWREAD(ZEROPAGE());
+    LSR(MEM(ZEROPAGE()));
+    WRITE(ZEROPAGE());
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0x56)
+    RMWREAD(ZEROPAGEX());
+    LSR(MEM(ZEROPAGEX()));
+    WRITE(ZEROPAGEX());
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0x4e)
+    RMWREAD(ABSOLUTE());
+    LSR(MEM(ABSOLUTE()));
+    WRITE(ABSOLUTE());
+    pc += 2;
+    CPU_NEXT;
+
+    CPU_OP(0x5e)
+    RMWREAD(ABSOLUTEX());
+    LSR(MEM(ABSOLUTEX()));
+    WRITE(ABSOLUTEX());
+    pc += 2;
+    CPU_NEXT;
+
+    CPU_OP(0xea)
+    CPU_NEXT;
+
+    CPU_OP(0x09)
+    ORA(IMMEDIATE());
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0x05)
+    ORA(READ(ZEROPAGE()));
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0x15)
+    ORA(READ(ZEROPAGEX()));
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0x0d)
+    ORA(READ(ABSOLUTE()));
+    pc += 2;
+    CPU_NEXT;
+
+    CPU_OP(0x1d)
+    cpucycles += EVALPAGECROSSING_ABSOLUTEX();
+    ORA(READ(ABSOLUTEX()));
+    pc += 2;
+    CPU_NEXT;
+
+    CPU_OP(0x19)
+    cpucycles += EVALPAGECROSSING_ABSOLUTEY();
+    ORA(READ(ABSOLUTEY()));
+    pc += 2;
+    CPU_NEXT;
+
+    CPU_OP(0x01)
+    ORA(READ(INDIRECTX()));
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0x11)
+    cpucycles += EVALPAGECROSSING_INDIRECTY();
+    ORA(READ(INDIRECTY()));
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0x48)
+    PUSH(a);
+    CPU_NEXT;
+
+    CPU_OP(0x08)
+    PUSH(flags | 0x30);
+    CPU_NEXT;
+
+    CPU_OP(0x68)
+    ASSIGNSETFLAGS(a, POP());
+    CPU_NEXT;
+
+    CPU_OP(0x28)
+    flags = POP();
+    CPU_NEXT;
+
+    CPU_OP(0x2a)
+    ROL(a);
+    CPU_NEXT;
+
+    CPU_OP(0x26)
+    RMWREAD(ZEROPAGE());
+    ROL(MEM(ZEROPAGE()));
+    WRITE(ZEROPAGE());
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0x36)
+    RMWREAD(ZEROPAGEX());
+    ROL(MEM(ZEROPAGEX()));
+    WRITE(ZEROPAGEX());
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0x2e)
+    RMWREAD(ABSOLUTE());
+    ROL(MEM(ABSOLUTE()));
+    WRITE(ABSOLUTE());
+    pc += 2;
+    CPU_NEXT;
+
+    CPU_OP(0x3e)
+    RMWREAD(ABSOLUTEX());
+    ROL(MEM(ABSOLUTEX()));
+    WRITE(ABSOLUTEX());
+    pc += 2;
+    CPU_NEXT;
+
+    CPU_OP(0x6a)
+    ROR(a);
+    CPU_NEXT;
+
+    CPU_OP(0x66)
+    RMWREAD(ZEROPAGE());
+    ROR(MEM(ZEROPAGE()));
+    WRITE(ZEROPAGE());
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0x76)
+    RMWREAD(ZEROPAGEX());
+    ROR(MEM(ZEROPAGEX()));
+    WRITE(ZEROPAGEX());
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0x6e)
+    RMWREAD(ABSOLUTE());
+    ROR(MEM(ABSOLUTE()));
+    WRITE(ABSOLUTE());
+    pc += 2;
+    CPU_NEXT;
+
+    CPU_OP(0x7e)
+    RMWREAD(ABSOLUTEX());
+    ROR(MEM(ABSOLUTEX()));
+    WRITE(ABSOLUTEX());
+    pc += 2;
+    CPU_NEXT;
+
+    CPU_OP(0x40)
+    if (sp == 0xff) CPU_RETURN(0);
+    flags = POP();
+    pc = POP();
+    pc |= POP() << 8;
+    CPU_NEXT;
+
+    CPU_OP(0x60)
+    if (sp == 0xff) CPU_RETURN(0);
+    pc = POP();
+    pc |= POP() << 8;
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0xe9)
+    CPU_OP(0xeb)
+    SBC(IMMEDIATE());
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0xe5)
+    SBC(READ(ZEROPAGE()));
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0xf5)
+    SBC(READ(ZEROPAGEX()));
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0xed)
+    SBC(READ(ABSOLUTE()));
+    pc += 2;
+    CPU_NEXT;
+
+    CPU_OP(0xfd)
+    cpucycles += EVALPAGECROSSING_ABSOLUTEX();
+    SBC(READ(ABSOLUTEX()));
+    pc += 2;
+    CPU_NEXT;
+
+    CPU_OP(0xf9)
+    cpucycles += EVALPAGECROSSING_ABSOLUTEY();
+    SBC(READ(ABSOLUTEY()));
+    pc += 2;
+    CPU_NEXT;
+
+    CPU_OP(0xe1)
+    SBC(READ(INDIRECTX()));
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0xf1)
+    cpucycles += EVALPAGECROSSING_INDIRECTY();
+    SBC(READ(INDIRECTY()));
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0x38)
+    flags |= FC;
+    CPU_NEXT;
+
+    CPU_OP(0xf8)
+    flags |= FD;
+    CPU_NEXT;
+
+    CPU_OP(0x78)
+    flags |= FI;
+    CPU_NEXT;
+
+    CPU_OP(0x85)
+    MEM(ZEROPAGE()) = a;
+    WRITE(ZEROPAGE());
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0x95)
+    MEM(ZEROPAGEX()) = a;
+    WRITE(ZEROPAGEX());
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0x8d)
+    MEM(ABSOLUTE()) = a;
+    WRITE(ABSOLUTE());
+    pc += 2;
+    CPU_NEXT;
+
+    CPU_OP(0x9d)
+    MEM(ABSOLUTEX()) = a;
+    WRITE(ABSOLUTEX());
+    pc += 2;
+    CPU_NEXT;
+
+    CPU_OP(0x99)
+    MEM(ABSOLUTEY()) = a;
+    WRITE(ABSOLUTEY());
+    pc += 2;
+    CPU_NEXT;
+
+    CPU_OP(0x81)
+    MEM(INDIRECTX()) = a;
+    WRITE(INDIRECTX());
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0x91)
+    MEM(INDIRECTY()) = a;
+    WRITE(INDIRECTY());
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0x86)
+    MEM(ZEROPAGE()) = x;
+    WRITE(ZEROPAGE());
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0x96)
+    MEM(ZEROPAGEY()) = x;
+    WRITE(ZEROPAGEY());
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0x8e)
+    MEM(ABSOLUTE()) = x;
+    WRITE(ABSOLUTE());
+    pc += 2;
+    CPU_NEXT;
+
+    CPU_OP(0x84)
+    MEM(ZEROPAGE()) = y;
+    WRITE(ZEROPAGE());
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0x94)
+    MEM(ZEROPAGEX()) = y;
+    WRITE(ZEROPAGEX());
+    pc++;
+    CPU_NEXT;
+
+    CPU_OP(0x8c)
+    MEM(ABSOLUTE()) = y;
+    WRITE(ABSOLUTE());
+    pc += 2;
+    CPU_NEXT;
+
+    CPU_OP(0xaa)
+    ASSIGNSETFLAGS(x, a);
+    CPU_NEXT;
+
+    CPU_OP(0xba)
+    ASSIGNSETFLAGS(x, sp);
+    CPU_NEXT;
+
+    CPU_OP(0x8a)
+    ASSIGNSETFLAGS(a, x);
+    CPU_NEXT;
+
+    CPU_OP(0x9a)
+    sp = x;
+    CPU_NEXT;
+
+    CPU_OP(0x98)
+    ASSIGNSETFLAGS(a, y);
+    CPU_NEXT;
+
+    CPU_OP(0xa8)
+    ASSIGNSETFLAGS(y, a);
+    CPU_NEXT;
+
+    CPU_OP(0x00)
+    CPU_RETURN(0);
+
+    CPU_OP(0x02)
+    ctx->error = CPUERR_HALT;
+    ctx->errorop = op;
+    ctx->errorpc = pc-1;
+    CPU_RETURN(-1);
+          
+    CPU_OP_DEFAULT
+    ctx->error = CPUERR_ILLEGAL;
+    ctx->errorop = op;
+    ctx->errorpc = pc-1;
+    CPU_RETURN(-1);
+  }
+#ifdef CPU_CORE_RUN
+  CPU_ENDOP;
+  if (++count > maxinstr) CPU_RETURN(CPURUN_LIMIT);
+  if ((pc == stop1) || (pc == stop2)) CPU_RETURN(CPURUN_STOP);
+  }
+
+#undef pc
+#undef a
+#undef x
+#undef y
+#undef flags
+#undef sp
+#undef cpucycles
+
+cpu_done:
+  ctx->pc = cpu_pc;
+  ctx->a = cpu_a;
+  ctx->x = cpu_x;
+  ctx->y = cpu_y;
+  ctx->flags = cpu_flags;
+  ctx->sp = cpu_sp;
+  ctx->cpucycles = cpu_cycles;
+  *instr = count;
+  return result;
+}
+#else
+  }
+  return 1;
+}
+
+#undef pc
+#undef a
+#undef x
+#undef y
+#undef flags
+#undef sp
+#undef cpucycles
+#endif
+
+#undef CPU_THREADED
+#undef CPU_SWITCH
+#undef CPU_OP
+#undef CPU_OP_DEFAULT
+#undef CPU_NEXT
+#undef CPU_RETURN
+#undef CPU_MEMORY
+#undef CPU_OPERAND_LO
+#undef CPU_FETCHOP
+#undef CPU_ENDOP
+#undef CPU_OPERAND_HI
+
+#undef CPU_CORE
+#undef CPU_CORE_RUN
+#undef CPU_CORE_BLOCKS
+#undef CPU_OBSERVE_EXEC
+#undef CPU_OBSERVE_READ
+#undef CPU_OBSERVE_WRITE
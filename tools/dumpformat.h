@@ -0,0 +1,239 @@
+#ifndef DUMPFORMAT_H
+#define DUMPFORMAT_H
+
+#include <stdint.h>
+
+// siddump binary frame dump (-b). A DUMPHEADER followed by framecount
+// DUMPRECORDs, all fields little-endian. Both structs have no implicit
+// padding, so a file can be mmapped and indexed directly:
+//   record n is at headersize + n * recordsize
+
+#define DUMP_MAGIC "SDMP"
+#define DUMP_VERSION 1
+#define DUMP_NUMREGS 25
+
+typedef struct
+{
+  char magic[4];          // "SDMP"
+  uint16_t version;       // DUMP_VERSION
+  uint16_t headersize;    // sizeof(DUMPHEADER), offset of the first record
+  uint16_t recordsize;    // sizeof(DUMPRECORD)
+  uint16_t loadaddress;
+  uint16_t initaddress;
+  uint16_t playaddress;   // After the play address 0 interrupt vector lookup
+  uint16_t subtune;       // Accumulator value passed to init
+  uint16_t reserved;
+  uint32_t firstframe;    // Frame number of record 0
+  uint32_t framecount;    // Number of records that follow
+  uint32_t reserved2;
+} DUMPHEADER;
+
+typedef struct
+{
+  uint32_t cycles;              // CPU cycles used by the playroutine this frame
+  uint8_t regs[DUMP_NUMREGS];   // $D400-$D418 after the playroutine returned
+  uint8_t reserved[3];
+} DUMPRECORD;
+
+// siddump memory access trace (-tracebin=). A TRACEHEADER followed by
+// recordcount TRACERECORDs in execution order, same layout rules as above:
+//   record n is at headersize + n * recordsize
+
+#define TRACE_MAGIC "STRC"
+#define TRACE_VERSION 1
+
+// TRACERECORD.flags
+#define TRACE_READ 0x01
+#define TRACE_WRITE 0x02
+
+// TRACERECORD.frame of accesses made by the initroutine
+#define TRACE_INITFRAME 0xffffffff
+
+typedef struct
+{
+  char magic[4];          // "STRC"
+  uint16_t version;       // TRACE_VERSION
+  uint16_t headersize;    // sizeof(TRACEHEADER), offset of the first record
+  uint16_t recordsize;    // sizeof(TRACERECORD)
+  uint16_t windowstart;   // Traced address window, inclusive
+  uint16_t windowend;
+  uint16_t subtune;
+  uint32_t firstframe;    // Traced frame range, inclusive
+  uint32_t lastframe;
+  uint32_t recordcount;   // Number of records that follow (0 if not seekable)
+  uint32_t reserved;
+} TRACEHEADER;
+
+typedef struct
+{
+  uint32_t frame;         // Play call number, or TRACE_INITFRAME
+  uint16_t pc;            // Address of the accessing instruction
+  uint16_t address;
+  uint8_t value;          // Byte read or written
+  uint8_t flags;          // TRACE_READ or TRACE_WRITE
+  uint16_t reserved;
+} TRACERECORD;
+
+// siddump SID register write stream (-sidwrites=). A SIDWRITEHEADER
+// followed by recordcount SIDWRITERECORDs, one per write to a SID register
+// in execution order, same layout rules as above:
+//   record n is at headersize + n * recordsize
+// SIDWRITERECORD.cycle counts CPU cycles from the start of init. Play call
+// n (0 = the first) starts at (n + 1) * frameperiod, so a renderer clocks
+// the SID by the difference between consecutive records. A write is
+// stamped with the last cycle of its instruction, which is where a store
+// writes. Cycles never go backwards: a call running past the start of the
+// next frame pushes that frame's writes later. The 32-bit stamps reach
+// SIDWRITE_MAXFRAMES play calls, about 72 minutes; siddump refuses longer
+// runs rather than let them wrap.
+
+#define SIDWRITE_MAGIC "SWRS"
+#define SIDWRITE_VERSION 1
+#define SIDWRITE_PALPERIOD 19656   // 312 raster lines of 63 cycles
+#define SIDWRITE_PALCLOCK 985248
+// (SIDWRITE_MAXFRAMES + 1) * SIDWRITE_PALPERIOD leaves room below 2^32 for
+// a last call of 0x100000 instructions of up to 8 cycles
+#define SIDWRITE_MAXFRAMES 218000
+
+typedef struct
+{
+  char magic[4];          // "SWRS"
+  uint16_t version;       // SIDWRITE_VERSION
+  uint16_t headersize;    // sizeof(SIDWRITEHEADER), offset of the first record
+  uint16_t recordsize;    // sizeof(SIDWRITERECORD)
+  uint16_t subtune;
+  uint32_t frameperiod;   // CPU cycles per play call
+  uint32_t clockrate;     // CPU cycles per second
+  uint32_t framecount;    // Number of play calls recorded
+  uint32_t recordcount;   // Number of records that follow (0 if not seekable)
+  uint32_t reserved;
+} SIDWRITEHEADER;
+
+typedef struct
+{
+  uint32_t cycle;         // CPU cycles since the start of init
+  uint8_t reg;            // SID register, $00-$18 ($D400-$D418 and mirrors)
+  uint8_t value;
+  uint16_t reserved;
+} SIDWRITERECORD;
+
+// siddump memory coverage (-coverage=). A COVERAGEHEADER, the first-touch
+// array (65536 uint32, at headersize: the frame each address was first
+// executed, read or written in) and snapshotcount COVERAGESNAPSHOTs:
+//   snapshot n is at snapshotoffset + n * snapshotsize
+// Snapshot 0 is the initroutine, then one per interval play calls (all of
+// them with interval 0). Bit (address & 7) of byte address >> 3 is set if
+// the address was accessed; exec marks the opcode byte of each instruction.
+
+#define COVERAGE_MAGIC "SCOV"
+#define COVERAGE_VERSION 1
+#define COVERAGE_MAPSIZE 8192
+
+// First-touch and COVERAGESNAPSHOT frame values
+#define COVERAGE_NEVER 0xffffffff
+#define COVERAGE_INITFRAME 0xfffffffe
+
+typedef struct
+{
+  char magic[4];          // "SCOV"
+  uint16_t version;       // COVERAGE_VERSION
+  uint16_t headersize;    // sizeof(COVERAGEHEADER), offset of the first-touch array
+  uint32_t snapshotsize;  // sizeof(COVERAGESNAPSHOT)
+  uint32_t interval;      // Play calls per snapshot, 0 for one snapshot
+  uint16_t subtune;
+  uint16_t reserved;
+  uint32_t snapshotcount; // Number of snapshots that follow (0 if not seekable)
+  uint32_t snapshotoffset;// Offset of snapshot 0
+  uint32_t reserved2;
+} COVERAGEHEADER;
+
+typedef struct
+{
+  uint32_t firstframe;    // Play calls covered, inclusive; COVERAGE_INITFRAME for init
+  uint32_t lastframe;
+  uint8_t exec[COVERAGE_MAPSIZE];
+  uint8_t read[COVERAGE_MAPSIZE];
+  uint8_t write[COVERAGE_MAPSIZE];
+} COVERAGESNAPSHOT;
+
+// siddump note events (-notes=). A NOTESHEADER followed by eventcount
+// NOTERECORDs in frame order, voices in order within a frame, same layout
+// rules as above:
+//   record n is at headersize + n * recordsize
+// The events are the notes the text table prints: a key on (note without
+// parentheses) and a note change without one (in parentheses), plus the
+// gate bit clearing, which the table doesn't mark. frame counts from the
+// first displayed frame, as the table's Frame column.
+
+#define NOTES_MAGIC "SNEV"
+#define NOTES_VERSION 1
+
+// NOTERECORD.type
+#define NOTES_KEYON 1
+#define NOTES_CHANGE 2
+#define NOTES_KEYOFF 3
+
+typedef struct
+{
+  char magic[4];          // "SNEV"
+  uint16_t version;       // NOTES_VERSION
+  uint16_t headersize;    // sizeof(NOTESHEADER), offset of the first record
+  uint16_t recordsize;    // sizeof(NOTERECORD)
+  uint16_t subtune;
+  uint32_t firstframe;    // Play call of frame 0 (-f)
+  uint32_t framecount;    // Number of frames analyzed
+  uint32_t eventcount;    // Number of records that follow (0 if not seekable)
+  uint16_t middlec;       // Frequency of note $B0 ($30), after -c recalibration
+  uint16_t reserved;
+  uint32_t reserved2;
+} NOTESHEADER;
+
+typedef struct
+{
+  uint32_t frame;
+  uint8_t voice;          // 0-2
+  uint8_t type;           // NOTES_KEYON, NOTES_CHANGE or NOTES_KEYOFF
+  uint8_t note;           // 0-95 (C-0 to B-7); the voice's last note for a key off
+  uint8_t wave;           // $D404 of the voice
+  uint16_t freq;
+  uint16_t adsr;          // AD in the high byte, SR in the low byte
+  uint16_t pulse;         // 12 bits
+  uint16_t reserved;
+} NOTERECORD;
+
+// siddump frame checkpoint cache (-cache=). One file per SID file and
+// subtune: a CHECKPOINTHEADER followed by count CHECKPOINTs, where
+// checkpoint n is the machine state before play call (n + 1) * interval:
+//   checkpoint n is at headersize + n * checkpointsize
+
+#define CHECKPOINT_MAGIC "SDCK"
+#define CHECKPOINT_VERSION 1
+
+typedef struct
+{
+  char magic[4];          // "SDCK"
+  uint16_t version;       // CHECKPOINT_VERSION
+  uint16_t headersize;    // sizeof(CHECKPOINTHEADER)
+  uint32_t checkpointsize;// sizeof(CHECKPOINT)
+  uint32_t interval;      // Frames between checkpoints
+  uint64_t sidhash;       // FNV-1a of the whole SID file
+  uint16_t subtune;
+  uint16_t playaddress;   // After the play address 0 interrupt vector lookup
+  uint32_t count;         // Number of checkpoints that follow
+} CHECKPOINTHEADER;
+
+typedef struct
+{
+  uint32_t frame;
+  uint32_t cpucycles;     // CPU state after the previous play call
+  uint16_t pc;
+  uint8_t a;
+  uint8_t x;
+  uint8_t y;
+  uint8_t flags;
+  uint8_t sp;
+  uint8_t reserved;
+  uint8_t mem[0x10000];
+} CHECKPOINT;
+
+#endif
@@ -0,0 +1,90 @@
+#include <stdlib.h>
+#include <string.h>
+#include "loopdetect.h"
+
+// FNV-1a of one page, seeded with the page number so that equal pages at
+// different addresses don't cancel out in the XOR of all pages
+static unsigned long long hashpage(const unsigned char *page, int pagenum)
+{
+  unsigned long long hash = 0xcbf29ce484222325ULL ^ (unsigned long long)pagenum;
+  int c;
+
+  for (c = 0; c < 256; c++)
+  {
+    hash ^= page[c];
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+// Detector for up to maxframes frames, NULL if out of memory
+LOOPDETECT *loopdetect_create(unsigned maxframes)
+{
+  LOOPDETECT *ld = calloc(1, sizeof *ld);
+
+  if (!ld) return NULL;
+  ld->tablesize = 1024;
+  while (ld->tablesize < maxframes * 2) ld->tablesize *= 2;
+  ld->hashes = malloc(ld->tablesize * sizeof *ld->hashes);
+  ld->frames = malloc(ld->tablesize * sizeof *ld->frames);
+  if ((!ld->hashes) || (!ld->frames))
+  {
+    loopdetect_free(ld);
+    return NULL;
+  }
+  memset(ld->frames, 0xff, ld->tablesize * sizeof *ld->frames);
+  return ld;
+}
+
+// Record the state before play call frame. Returns the earlier frame with
+// the same state (the loop start), or -1. Frames must be checked in order.
+int loopdetect_check(LOOPDETECT *ld, const unsigned char *mem, int frame)
+{
+  unsigned mask = ld->tablesize - 1;
+  unsigned slot;
+  int p;
+
+  if (!ld->started)
+  {
+    ld->hash = 0;
+    for (p = 0; p < 256; p++)
+    {
+      ld->pagehash[p] = hashpage(&mem[p << 8], p);
+      ld->hash ^= ld->pagehash[p];
+    }
+    memcpy(ld->prev, mem, 0x10000);
+    ld->started = 1;
+  }
+  else
+  {
+    for (p = 0; p < 256; p++)
+    {
+      if (memcmp(&ld->prev[p << 8], &mem[p << 8], 256))
+      {
+        ld->hash ^= ld->pagehash[p];
+        ld->pagehash[p] = hashpage(&mem[p << 8], p);
+        ld->hash ^= ld->pagehash[p];
+        memcpy(&ld->prev[p << 8], &mem[p << 8], 256);
+      }
+    }
+  }
+
+  // Open addressing on the state hash
+  slot = (unsigned)(ld->hash ^ (ld->hash >> 32)) & mask;
+  while (ld->frames[slot] >= 0)
+  {
+    if (ld->hashes[slot] == ld->hash) return ld->frames[slot];
+    slot = (slot + 1) & mask;
+  }
+  ld->hashes[slot] = ld->hash;
+  ld->frames[slot] = frame;
+  return -1;
+}
+
+void loopdetect_free(LOOPDETECT *ld)
+{
+  if (!ld) return;
+  free(ld->hashes);
+  free(ld->frames);
+  free(ld);
+}
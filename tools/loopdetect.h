@@ -0,0 +1,24 @@
+#ifndef LOOPDETECT_H
+#define LOOPDETECT_H
+
+// Song-loop detection. The machine state before each play call (all 64KB,
+// which includes the SID registers; the CPU registers are reset for every
+// call) is hashed, and a repeated hash means the tune loops from the frame
+// it was first seen at. Only the pages that changed since the previous
+// frame are rehashed.
+typedef struct
+{
+  unsigned char prev[0x10000];
+  unsigned long long pagehash[256];
+  unsigned long long hash;
+  int started;
+  unsigned long long *hashes;
+  int *frames;
+  unsigned tablesize;
+} LOOPDETECT;
+
+LOOPDETECT *loopdetect_create(unsigned maxframes);
+int loopdetect_check(LOOPDETECT *ld, const unsigned char *mem, int frame);
+void loopdetect_free(LOOPDETECT *ld);
+
+#endif
@@ -0,0 +1,232 @@
+#include <ctype.h>
+#include <errno.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ndjson.h"
+
+static const char *skipspace(const char *p)
+{
+  while ((*p == ' ') || (*p == '\t') || (*p == '\r') || (*p == '\n')) p++;
+  return p;
+}
+
+// Parse a string at p (after the opening quote) into dest. Returns the
+// position after the closing quote, NULL if it is malformed or too long.
+// \u escapes outside ASCII become '?'.
+static const char *parsestring(const char *p, char *dest, int size)
+{
+  int len = 0;
+
+  while (*p != '"')
+  {
+    char c = *p++;
+
+    if ((unsigned char)c < 0x20) return NULL;
+    if (c == '\\')
+    {
+      c = *p++;
+      switch (c)
+      {
+        case 'n': c = '\n'; break;
+        case 't': c = '\t'; break;
+        case 'r': c = '\r'; break;
+        case 'b': c = '\b'; break;
+        case 'f': c = '\f'; break;
+        case '"': case '\\': case '/': break;
+        case 'u':
+        {
+          char hex[5];
+          unsigned long code;
+          int d;
+
+          for (d = 0; d < 4; d++)
+          {
+            if (!isxdigit((unsigned char)p[d])) return NULL;
+            hex[d] = p[d];
+          }
+          hex[4] = 0;
+          code = strtoul(hex, NULL, 16);
+          c = ((code > 0) && (code < 0x80)) ? (char)code : '?';
+          p += 4;
+          break;
+        }
+        default: return NULL;
+      }
+    }
+    if (len == size - 1) return NULL;
+    dest[len++] = c;
+  }
+  dest[len] = 0;
+  return p + 1;
+}
+
+// A bare value must be a JSON number, true, false or null; it is echoed
+// as is, so anything else would make the reply invalid JSON
+static int validbare(const char *s)
+{
+  if ((!strcmp(s, "true")) || (!strcmp(s, "false")) || (!strcmp(s, "null"))) return 1;
+  if (*s == '-') s++;
+  if (*s == '0') s++;
+  else if ((*s >= '1') && (*s <= '9'))
+  {
+    while (isdigit((unsigned char)*s)) s++;
+  }
+  else return 0;
+  if (*s == '.')
+  {
+    s++;
+    if (!isdigit((unsigned char)*s)) return 0;
+    while (isdigit((unsigned char)*s)) s++;
+  }
+  if ((*s == 'e') || (*s == 'E'))
+  {
+    s++;
+    if ((*s == '+') || (*s == '-')) s++;
+    if (!isdigit((unsigned char)*s)) return 0;
+    while (isdigit((unsigned char)*s)) s++;
+  }
+  return !*s;
+}
+
+// Parse one request line. Returns 0 on success.
+int ndjson_parse(const char *line, NDJSONREQUEST *req)
+{
+  const char *p = skipspace(line);
+
+  memset(req, 0, sizeof *req);
+  if (*p++ != '{') return 1;
+  p = skipspace(p);
+  if (*p == '}') return *skipspace(p + 1) ? 1 : 0;
+  for (;;)
+  {
+    NDJSONFIELD *field;
+
+    if (req->count == NDJSON_MAXFIELDS) return 1;
+    field = &req->field[req->count++];
+    if (*p++ != '"') return 1;
+    if (!(p = parsestring(p, field->key, sizeof field->key))) return 1;
+    p = skipspace(p);
+    if (*p++ != ':') return 1;
+    p = skipspace(p);
+    if (*p == '"')
+    {
+      if (!(p = parsestring(p + 1, field->value, sizeof field->value))) return 1;
+      field->string = 1;
+    }
+    else
+    {
+      int len = strcspn(p, ",} \t\r\n");
+
+      if ((!len) || (len >= NDJSON_VALUESIZE)) return 1;
+      memcpy(field->value, p, len);
+      if (!validbare(field->value)) return 1;
+      p += len;
+    }
+    p = skipspace(p);
+    if (*p == '}') break;
+    if (*p++ != ',') return 1;
+    p = skipspace(p);
+  }
+  return *skipspace(p + 1) ? 1 : 0;
+}
+
+const NDJSONFIELD *ndjson_field(const NDJSONREQUEST *req, const char *key)
+{
+  int c;
+
+  for (c = 0; c < req->count; c++)
+  {
+    if (!strcmp(req->field[c].key, key)) return &req->field[c];
+  }
+  return NULL;
+}
+
+// String value of key, NULL if missing or not a string
+const char *ndjson_string(const NDJSONREQUEST *req, const char *key)
+{
+  const NDJSONFIELD *field = ndjson_field(req, key);
+
+  return ((field) && (field->string)) ? field->value : NULL;
+}
+
+// Integer value of key: a number, or a string in C notation ("0x1000").
+// Returns 0 and sets *value if present and valid, NDJSON_MISSING if absent
+// or null and NDJSON_INVALID for anything else (1.5, true, "abc", overflow).
+int ndjson_number(const NDJSONREQUEST *req, const char *key, long *value)
+{
+  const NDJSONFIELD *field = ndjson_field(req, key);
+  char *end;
+  long result;
+
+  if ((!field) || ((!field->string) && (!strcmp(field->value, "null")))) return NDJSON_MISSING;
+  if (!field->value[0]) return NDJSON_INVALID;
+  errno = 0;
+  result = strtol(field->value, &end, 0);
+  if ((*end) || (errno == ERANGE)) return NDJSON_INVALID;
+  *value = result;
+  return 0;
+}
+
+void ndjson_writestring(FILE *out, const char *s)
+{
+  fputc('"', out);
+  for (; *s; s++)
+  {
+    if ((*s == '"') || (*s == '\\'))
+    {
+      fputc('\\', out);
+      fputc(*s, out);
+    }
+    else if (*s == '\n')
+      fputs("\\n", out);
+    else if (*s == '\t')
+      fputs("\\t", out);
+    else if (*s == '\r')
+      fputs("\\r", out);
+    else if ((unsigned char)*s < 0x20)
+      fprintf(out, "\\u%04x", (unsigned char)*s);
+    else
+      fputc(*s, out);
+  }
+  fputc('"', out);
+}
+
+// Start a reply: {"id": <the request's id, as given>, "ok": true|false
+void ndjson_begin(FILE *out, const NDJSONREQUEST *req, int ok)
+{
+  const NDJSONFIELD *id = req ? ndjson_field(req, "id") : NULL;
+
+  fputc('{', out);
+  if (id)
+  {
+    fputs("\"id\": ", out);
+    if (id->string)
+      ndjson_writestring(out, id->value);
+    else
+      fputs(id->value, out);
+    fputs(", ", out);
+  }
+  fprintf(out, "\"ok\": %s", ok ? "true" : "false");
+}
+
+// End a reply and send it
+void ndjson_end(FILE *out)
+{
+  fputs("}\n", out);
+  fflush(out);
+}
+
+void ndjson_error(FILE *out, const NDJSONREQUEST *req, const char *fmt, ...)
+{
+  char message[512];
+  va_list ap;
+
+  va_start(ap, fmt);
+  vsnprintf(message, sizeof message, fmt, ap);
+  va_end(ap);
+  ndjson_begin(out, req, 0);
+  fputs(", \"error\": ", out);
+  ndjson_writestring(out, message);
+  ndjson_end(out);
+}
@@ -0,0 +1,49 @@
+#ifndef NDJSON_H
+#define NDJSON_H
+
+// Newline-delimited JSON requests and replies for the service modes of
+// siddump and sf2pack. A request is one flat JSON object per line: string,
+// number, true, false or null values, no nesting. Replies are built with
+// ndjson_begin(), fields printed by the caller and ndjson_end().
+
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NDJSON_MAXFIELDS 16
+#define NDJSON_KEYSIZE 32
+#define NDJSON_VALUESIZE 1024
+
+// ndjson_number() results besides 0
+#define NDJSON_MISSING 1
+#define NDJSON_INVALID 2
+
+typedef struct
+{
+  char key[NDJSON_KEYSIZE];
+  char value[NDJSON_VALUESIZE];  // Unescaped string, or the literal token
+  int string;
+} NDJSONFIELD;
+
+typedef struct
+{
+  NDJSONFIELD field[NDJSON_MAXFIELDS];
+  int count;
+} NDJSONREQUEST;
+
+int ndjson_parse(const char *line, NDJSONREQUEST *req);
+const NDJSONFIELD *ndjson_field(const NDJSONREQUEST *req, const char *key);
+const char *ndjson_string(const NDJSONREQUEST *req, const char *key);
+int ndjson_number(const NDJSONREQUEST *req, const char *key, long *value);
+void ndjson_writestring(FILE *out, const char *s);
+void ndjson_begin(FILE *out, const NDJSONREQUEST *req, int ok);
+void ndjson_end(FILE *out);
+void ndjson_error(FILE *out, const NDJSONREQUEST *req, const char *fmt, ...);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,306 @@
+#include <stdlib.h>
+#include <string.h>
+#include "notetrack.h"
+
+// Build the lookup for the frequency table. A rising table (the default,
+// and any sensible -c recalibration) takes one sweep: the nearest note
+// only moves up as the frequency does. Anything else is searched per
+// frequency, as the display loop did.
+void notetable_build(NOTETABLE *table, const unsigned char *freqlo, const unsigned char *freqhi)
+{
+  int rising = 1;
+  unsigned f;
+  int d;
+
+  for (d = 0; d < NOTE_NUMNOTES; d++)
+  {
+    table->freq[d] = freqlo[d] | (freqhi[d] << 8);
+    if ((d) && (table->freq[d] <= table->freq[d - 1])) rising = 0;
+  }
+
+  if (rising)
+  {
+    d = 0;
+    for (f = 0; f < 0x10000; f++)
+    {
+      while ((d < NOTE_NUMNOTES - 1) && (abs((int)f - table->freq[d + 1]) < abs((int)f - table->freq[d]))) d++;
+      table->nearest[f] = d;
+    }
+    return;
+  }
+
+  for (f = 0; f < 0x10000; f++)
+  {
+    int dist = 0x7fffffff;
+    int note = 0;
+
+    for (d = 0; d < NOTE_NUMNOTES; d++)
+    {
+      if (abs((int)f - table->freq[d]) < dist)
+      {
+        dist = abs((int)f - table->freq[d]);
+        note = d;
+      }
+    }
+    table->nearest[f] = note;
+  }
+}
+
+// The note the display loop's search picks with the old note favored,
+// given the nearest one: in that search the old note's distance is divided
+// by oldnotefactor once it is the closest so far, so it only keeps a nearer
+// note above it out, and only if no lower note was as close.
+static int favorold(const NOTETABLE *table, unsigned freq, int note, int oldnote, int oldnotefactor)
+{
+  int olddist;
+  int d;
+
+  if ((oldnotefactor <= 1) || (oldnote < 0) || (oldnote >= note)) return note;
+  olddist = abs((int)freq - table->freq[oldnote]);
+  for (d = 0; d < oldnote; d++)
+  {
+    if (abs((int)freq - table->freq[d]) <= olddist) return note;
+  }
+  if (abs((int)freq - table->freq[note]) < olddist / oldnotefactor) return note;
+  return oldnote;
+}
+
+int notetable_find(const NOTETABLE *table, unsigned freq, int oldnote, int oldnotefactor)
+{
+  return favorold(table, freq, table->nearest[freq], oldnote, oldnotefactor);
+}
+
+void notetrack_init(NOTETRACK *track, const NOTETABLE *table, int oldnotefactor, int lowres, int spacing)
+{
+  memset(track, 0, sizeof *track);
+  track->table = table;
+  track->oldnotefactor = oldnotefactor;
+  track->lowres = (lowres) && (spacing);
+  track->spacing = spacing;
+}
+
+// Per frame edges, against the previous frame
+#define EDGE_FREQ 0x01
+#define EDGE_WAVE 0x02
+#define EDGE_ADSR 0x04
+#define EDGE_PULSE 0x08
+#define EDGE_KEYON 0x10
+#define EDGE_KEYOFF 0x20
+
+// Column passes of one voice. Each loop only looks at frame i and i - 1,
+// with no branches, so the compiler can vectorize them.
+static void analyzecolumns(NOTETRACK *track, int c, int count)
+{
+  const unsigned char *nearest = track->table->nearest;
+  unsigned short *freq = track->freq[c];
+  unsigned short *pulse = track->pulse[c];
+  unsigned short *adsr = track->adsr[c];
+  unsigned char *wave = track->wave[c];
+  unsigned char *edges = track->edges[c];
+  int *delta = track->delta[c];
+  const NOTEVOICE *last = &track->last[c];
+  int i;
+
+  for (i = 0; i < count; i++) track->nearest[c][i] = nearest[freq[i]];
+
+  delta[0] = (int)freq[0] - (int)last->freq;
+  for (i = 1; i < count; i++) delta[i] = (int)freq[i] - (int)freq[i - 1];
+
+  edges[0] = ((freq[0] != last->freq) ? EDGE_FREQ : 0) |
+    ((wave[0] != last->wave) ? EDGE_WAVE : 0) |
+    ((adsr[0] != last->adsr) ? EDGE_ADSR : 0) |
+    ((pulse[0] != last->pulse) ? EDGE_PULSE : 0) |
+    (((wave[0] >= 0x10) & (wave[0] & 1) & ((!(last->wave & 1)) | (last->wave < 0x10))) ? EDGE_KEYON : 0) |
+    (((last->wave & 1) & (!(wave[0] & 1))) ? EDGE_KEYOFF : 0);
+  for (i = 1; i < count; i++)
+  {
+    edges[i] = ((freq[i] != freq[i - 1]) ? EDGE_FREQ : 0) |
+      ((wave[i] != wave[i - 1]) ? EDGE_WAVE : 0) |
+      ((adsr[i] != adsr[i - 1]) ? EDGE_ADSR : 0) |
+      ((pulse[i] != pulse[i - 1]) ? EDGE_PULSE : 0) |
+      (((wave[i] >= 0x10) & (wave[i] & 1) & ((!(wave[i - 1] & 1)) | (wave[i - 1] < 0x10))) ? EDGE_KEYON : 0) |
+      (((wave[i - 1] & 1) & (!(wave[i] & 1))) ? EDGE_KEYOFF : 0);
+  }
+}
+
+void notetrack_analyze(NOTETRACK *track, const DUMPRECORD *records, int count, NOTEFRAME *out)
+{
+  int i;
+  int c;
+
+  if (count <= 0) return;
+
+  // Registers into columns
+  for (i = 0; i < count; i++)
+  {
+    const uint8_t *regs = records[i].regs;
+
+    for (c = 0; c < 3; c++)
+    {
+      track->freq[c][i] = regs[7*c] | (regs[7*c + 1] << 8);
+      track->pulse[c][i] = (regs[7*c + 2] | (regs[7*c + 3] << 8)) & 0xfff;
+      track->wave[c][i] = regs[7*c + 4];
+      track->adsr[c][i] = regs[7*c + 6] | (regs[7*c + 5] << 8);
+    }
+  }
+
+  for (c = 0; c < 3; c++)
+  {
+    NOTEVOICE *shown = &track->shown[c];
+    unsigned frame = track->frame;
+
+    analyzecolumns(track, c, count);
+
+    // Against the last printed row. Without lowres that is the previous
+    // frame, whose edges are already known.
+    for (i = 0; i < count; i++, frame++)
+    {
+      NOTEVOICE v;
+      int edges = track->edges[c][i];
+      int first = (frame == 0);
+      int printed = (!track->lowres) || (!(frame % track->spacing));
+      int newnote = 0;
+      int flags = 0;
+
+      v.freq = track->freq[c][i];
+      v.pulse = track->pulse[c][i];
+      v.adsr = track->adsr[c][i];
+      v.wave = track->wave[c][i];
+      if (track->lowres)
+      {
+        edges = (edges & (EDGE_KEYON | EDGE_KEYOFF)) |
+          ((v.freq != shown->freq) ? EDGE_FREQ : 0) |
+          ((v.wave != shown->wave) ? EDGE_WAVE : 0) |
+          ((v.adsr != shown->adsr) ? EDGE_ADSR : 0) |
+          ((v.pulse != shown->pulse) ? EDGE_PULSE : 0);
+      }
+
+      // Keyoff-keyon sequence: whatever note follows is new
+      if (edges & EDGE_KEYON) shown->note = -1;
+
+      if ((first) || (shown->note == -1) || (edges & EDGE_FREQ))
+      {
+        flags |= NOTE_FREQ;
+        if (v.wave >= 0x10)
+        {
+          int note = favorold(track->table, v.freq, track->nearest[c][i], shown->note, track->oldnotefactor);
+
+          track->note[c] = note;
+          if (note != shown->note)
+          {
+            if (shown->note == -1)
+            {
+              flags |= NOTE_KEYON;
+              if (track->lowres) newnote = 1;
+            }
+            else flags |= NOTE_CHANGE;
+          }
+          else if (track->delta[c][i]) flags |= NOTE_SLIDE;
+        }
+      }
+      if ((first) || (newnote) || (edges & EDGE_WAVE)) flags |= NOTE_WAVE;
+      if ((first) || (newnote) || (edges & EDGE_ADSR)) flags |= NOTE_ADSR;
+      if ((first) || (newnote) || (edges & EDGE_PULSE)) flags |= NOTE_PULSE;
+      if (edges & EDGE_KEYOFF) flags |= NOTE_KEYOFF;
+
+      out[i].note[c] = track->note[c];
+      out[i].flags[c] = flags;
+      out[i].delta[c] = track->delta[c][i];
+
+      v.note = track->note[c];
+      if (printed) *shown = v;
+      if (i == count - 1) track->last[c] = v;
+    }
+  }
+  track->frame += count;
+}
+
+// Create the event file and write the header. Returns 0 on success.
+int notefile_open(NOTEFILE *file, const char *filename, int subtune, unsigned firstframe, unsigned middlec)
+{
+  memset(file, 0, sizeof *file);
+  memcpy(file->header.magic, NOTES_MAGIC, 4);
+  file->header.version = NOTES_VERSION;
+  file->header.headersize = sizeof(NOTESHEADER);
+  file->header.recordsize = sizeof(NOTERECORD);
+  file->header.subtune = subtune;
+  file->header.firstframe = firstframe;
+  file->header.middlec = middlec;
+
+  file->records = malloc(NOTEFILE_RECORDS * sizeof(NOTERECORD));
+  if (!file->records) return 1;
+  file->out = fopen(filename, "wb");
+  if (!file->out)
+  {
+    free(file->records);
+    file->records = NULL;
+    return 1;
+  }
+  if (fwrite(&file->header, sizeof file->header, 1, file->out) != 1) file->error = 1;
+  return 0;
+}
+
+static void notefile_flush(NOTEFILE *file)
+{
+  if (!file->numrecords) return;
+  if (fwrite(file->records, sizeof(NOTERECORD), file->numrecords, file->out) != file->numrecords)
+    file->error = 1;
+  file->header.eventcount += file->numrecords;
+  file->numrecords = 0;
+}
+
+static void notefile_event(NOTEFILE *file, const DUMPRECORD *rec, int c, int type, int note)
+{
+  NOTERECORD *ev = &file->records[file->numrecords++];
+  const uint8_t *regs = rec->regs + 7*c;
+
+  ev->frame = file->header.framecount;
+  ev->voice = c;
+  ev->type = type;
+  ev->note = note;
+  ev->wave = regs[4];
+  ev->freq = regs[0] | (regs[1] << 8);
+  ev->adsr = regs[6] | (regs[5] << 8);
+  ev->pulse = (regs[2] | (regs[3] << 8)) & 0xfff;
+  ev->reserved = 0;
+  if (file->numrecords == NOTEFILE_RECORDS) notefile_flush(file);
+}
+
+// Add the events of count analyzed frames, following the last added ones
+void notefile_add(NOTEFILE *file, const DUMPRECORD *records, const NOTEFRAME *frames, int count)
+{
+  int i;
+  int c;
+
+  for (i = 0; i < count; i++)
+  {
+    for (c = 0; c < 3; c++)
+    {
+      int flags = frames[i].flags[c];
+
+      if (flags & NOTE_KEYON) notefile_event(file, &records[i], c, NOTES_KEYON, frames[i].note[c]);
+      else if (flags & NOTE_CHANGE) notefile_event(file, &records[i], c, NOTES_CHANGE, frames[i].note[c]);
+      if (flags & NOTE_KEYOFF) notefile_event(file, &records[i], c, NOTES_KEYOFF, frames[i].note[c]);
+    }
+    file->header.framecount++;
+  }
+}
+
+// Flush, patch the counts into the header and close the file.
+// Returns 0 if everything was written.
+int notefile_close(NOTEFILE *file)
+{
+  int error;
+
+  if (!file->out) return 1;
+  notefile_flush(file);
+  if (!fseek(file->out, 0, SEEK_SET))
+  {
+    if (fwrite(&file->header, sizeof file->header, 1, file->out) != 1) file->error = 1;
+  }
+  if (fclose(file->out)) file->error = 1;
+  free(file->records);
+  error = file->error;
+  memset(file, 0, sizeof *file);
+  return error;
+}
@@ -0,0 +1,109 @@
+#ifndef NOTETRACK_H
+#define NOTETRACK_H
+
+#include <stdio.h>
+#include "dumpformat.h"
+
+// siddump note analysis. The frames of a dump are recorded as DUMPRECORDs
+// (the -b registers) and analyzed a block at a time: the registers are
+// split into per voice columns, the frame-to-frame passes (nearest note,
+// key on/off edges, frequency deltas, register changes) run over whole
+// columns, and one scalar pass applies the old note bias and the state of
+// the last printed row. The result drives both the text table and the
+// -notes event file.
+
+#define NOTE_NUMNOTES 96
+
+// Frames analyzed per notetrack_analyze() call
+#define NOTETRACK_FRAMES 256
+
+// Events buffered in memory before a block is written
+#define NOTEFILE_RECORDS 16384
+
+// NOTEFRAME.flags, per voice. NOTE_FREQ to NOTE_PULSE are the columns the
+// text table fills in rather than dots.
+#define NOTE_FREQ 0x01      // Frequency shown
+#define NOTE_KEYON 0x02     // New note after a key off/key on sequence
+#define NOTE_CHANGE 0x04    // Note changed without a key on
+#define NOTE_SLIDE 0x08     // Same note, frequency moved by delta
+#define NOTE_WAVE 0x10
+#define NOTE_ADSR 0x20
+#define NOTE_PULSE 0x40
+#define NOTE_KEYOFF 0x80    // Gate bit cleared since the previous frame
+
+// Frequency to note lookup for a (possibly recalibrated) frequency table.
+// nearest[freq] is the closest note, the lower one on a tie, as the linear
+// search finds it with no old note to favor.
+typedef struct
+{
+  unsigned short freq[NOTE_NUMNOTES];
+  unsigned char nearest[0x10000];
+} NOTETABLE;
+
+// Analysis of one frame
+typedef struct
+{
+  unsigned char note[3];  // Note of each voice after the frame
+  unsigned char flags[3];
+  int delta[3];           // Frequency change from the previous frame
+} NOTEFRAME;
+
+// Voice registers as of a frame
+typedef struct
+{
+  unsigned short freq;
+  unsigned short pulse;
+  unsigned short adsr;
+  unsigned char wave;
+  int note;
+} NOTEVOICE;
+
+// Analysis state carried from block to block. shown is the last printed
+// row (every frame unless lowres), last the previous frame; note is each
+// voice's current note.
+typedef struct
+{
+  const NOTETABLE *table;
+  int oldnotefactor;
+  int lowres;
+  int spacing;
+  unsigned frame;
+  NOTEVOICE shown[3];
+  NOTEVOICE last[3];
+  int note[3];
+
+  // Columns of the block being analyzed
+  unsigned short freq[3][NOTETRACK_FRAMES];
+  unsigned short pulse[3][NOTETRACK_FRAMES];
+  unsigned short adsr[3][NOTETRACK_FRAMES];
+  unsigned char wave[3][NOTETRACK_FRAMES];
+  unsigned char nearest[3][NOTETRACK_FRAMES];
+  unsigned char edges[3][NOTETRACK_FRAMES];
+  int delta[3][NOTETRACK_FRAMES];
+} NOTETRACK;
+
+// -notes event file sink, written in blocks like SIDWRITEBUF
+typedef struct
+{
+  FILE *out;
+  NOTESHEADER header;
+  NOTERECORD *records;
+  unsigned numrecords;
+  int error;
+} NOTEFILE;
+
+void notetable_build(NOTETABLE *table, const unsigned char *freqlo, const unsigned char *freqhi);
+int notetable_find(const NOTETABLE *table, unsigned freq, int oldnote, int oldnotefactor);
+
+// Start the analysis of a dump; frame 0 is the first displayed frame.
+// lowres with a spacing only carries state over from every spacing'th row.
+void notetrack_init(NOTETRACK *track, const NOTETABLE *table, int oldnotefactor, int lowres, int spacing);
+
+// Analyze the next count (at most NOTETRACK_FRAMES) frames into out
+void notetrack_analyze(NOTETRACK *track, const DUMPRECORD *records, int count, NOTEFRAME *out);
+
+int notefile_open(NOTEFILE *file, const char *filename, int subtune, unsigned firstframe, unsigned middlec);
+void notefile_add(NOTEFILE *file, const DUMPRECORD *records, const NOTEFRAME *frames, int count);
+int notefile_close(NOTEFILE *file);
+
+#endif
@@ -6,6 +6,8 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <dirent.h>
+#include <pthread.h>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -28,7 +30,7 @@
 #define P_FREEPAGE 0x78
 #define P_FREEPMAX 0x79
 #define P_STEREOAD 0x7a
-unsigned char psidh[0x7c]={
+const unsigned char psidhdef[0x7c]={
 0x50,0x53,0x49,0x44,0x00,0x02,0x00,0x7C,0x00,0x00,0x10,0x00,0x10,0x03,0x00,0x01,
 0x00,0x01,0x00,0x00,0x00,0x00,0x3C,0x3F,0x3E,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
 0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
@@ -38,7 +40,6 @@ unsigned char psidh[0x7c]={
 0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
 0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x14,0x00,0x00,0x00,0x00
 };
-unsigned char extrabytes[128];
 unsigned char aPatchSndmon[]={0xa9,0x01,0x8d,0x0f,0xc0,0xa9,0x00,0x8d,0xc6,0x02,0x60};
 unsigned char aPatchRckmon[]={0xa9,0x01,0x8d,0x0f,0xc0,0x4c,0x12,0xc0};
 unsigned char aPatchPolly1[]={0xa9,0x7f,0x8d,0x0d,0xdc,0xad,0x0d,0xdc,0xa0,0x00,0xea};
@@ -51,9 +52,6 @@ unsigned char aPatchMssiah[]={0x78,0xA9,0x35,0x85,0x01,0x20,0x1C,0x5F,0x20,0xF3,
 unsigned char aPatchArneDD[]={0xa9,0x00,0xea,0xc9,0x01,0xf0,0x05};
 unsigned char aPatchDMC4f9[]={0xC8,0xB1,0xF8,0x9D,0x26,0x17,0x60};
 unsigned char aPatchDblTrk[]={0xA9,0x63,0x8D,0x04,0xDC,0xA9,0x26,0x8D,0x05,0xDC,0xA9,0x00,0x8D,0xEB,0x0F,0x4C,0x48,0x10,0xA9,0x00,0x29,0x01,0xAA,0xEE,0xEB,0x0F,0xBD,0xFB,0x0F,0x8D,0xF9,0x0F,0x4C,0x21,0x10,0x21,0x00,0x00,0x00,0x00};
-char ids[30]="Generic";
-unsigned char *p;
-int fsiz,initaddr,playaddr,loadaddr,i,j,k,extra=0;
 typedef struct {
     int offset;
     unsigned char checkbyte;
@@ -86,114 +84,268 @@ AOF sld0[]=
 };
 
 AOF *afall[2]={af40,af41};
-AOF *af;
-int afsize[3];
+
+/* checks with a signature index entry, see SigScan() */
+enum {SIG_MASTERCOMP,SIG_UBIK,SIG_GRGTINY2,SIG_GRGTINY4,SIG_FLEXSID,SIG_CHECKS};
+
+/* Everything identifying and converting one file works on: the rip
+   (p/fsiz, advanced past a skipped part), the header being built, the
+   bytes to insert before the rip and the id found. i, j and k are the
+   checks' shared scratch variables. */
+typedef struct {
+    unsigned char psidh[0x7c];
+    unsigned char extrabytes[128];
+    char ids[30];
+    unsigned char *realp;   /* allocation p points into */
+    unsigned char *p;
+    int fsiz,initaddr,playaddr,loadaddr,i,j,k,extra;
+    int *sigcand[SIG_CHECKS];           /* candidate offsets, ascending */
+    int signum[SIG_CHECKS],sigmax[SIG_CHECKS];
+} P2S;
 
 /*****************************************************************************/
-int fixfc4stack(unsigned char *buffer,int lenbuff)
+int fixfc4stack(P2S *ctx,unsigned char *buffer,int lenbuff)
 {
-    int z=0;
+    int z=0,afsize[3];
+    AOF *af=NULL;
     if(lenbuff<0x600)
     {
         return -1;
     }
-    i=0;
-    j=0;
+    ctx->i=0;
+    ctx->j=0;
     afsize[0]=sizeof(af40)/sizeof(*af40);
     afsize[1]=sizeof(af41)/sizeof(*af41);
     afsize[2]=sizeof(af4 )/sizeof(*af4 );
     // 1st check common bytes
-    for(i=0;i<afsize[2];i++)
+    for(ctx->i=0;ctx->i<afsize[2];ctx->i++)
     {
-        if(buffer[af4[i].offset]!=af4[i].checkbyte)
+        if(buffer[af4[ctx->i].offset]!=af4[ctx->i].checkbyte)
         {
-            j=-1;
+            ctx->j=-1;
             break;
         }
     }
     // then determine subversion
-    if(j!=-1)
+    if(ctx->j!=-1)
     {
         for(z=0;z<2;z++)
         {
-            j=z;
+            ctx->j=z;
             af=afall[z];
-            for(i=0;i<afsize[z];i++)
+            for(ctx->i=0;ctx->i<afsize[z];ctx->i++)
             {
-                if(buffer[af[i].offset]!=af[i].checkbyte)
+                if(buffer[af[ctx->i].offset]!=af[ctx->i].checkbyte)
                 {
                     // Zyron's hack doesn't have 05a7 offset
-                    if((z==1)&&(i==afsize[z]-1))
+                    if((z==1)&&(ctx->i==afsize[z]-1))
                     {
                         break;
                     }
-                    j=-1;
+                    ctx->j=-1;
                     break;
                 }
             }
-            if(j!=-1)
+            if(ctx->j!=-1)
             {
                 break;
             }
         }
     }
     // now patch lda $0100 -> lda $0200
-    if(j!=-1)
+    if(ctx->j!=-1)
     {
-        for(i=0;i<afsize[2];i++)
+        for(ctx->i=0;ctx->i<afsize[2];ctx->i++)
         {
-            if(buffer[af4[i].offset+2]==0x1)
+            if(buffer[af4[ctx->i].offset+2]==0x1)
             {
-                buffer[af4[i].offset+2]=0x2;
-                j|=0x100;
+                buffer[af4[ctx->i].offset+2]=0x2;
+                ctx->j|=0x100;
             }
         }
-        for(i=0;i<afsize[z];i++)
+        for(ctx->i=0;ctx->i<afsize[z];ctx->i++)
         {
-            if((z==1)&&(i==afsize[z]-1))
+            if((z==1)&&(ctx->i==afsize[z]-1))
             {
                break;
             }
-            if(buffer[af[i].offset+2]==0x1)
+            if(buffer[af[ctx->i].offset+2]==0x1)
             {
-                buffer[af[i].offset+2]=0x2;
-                j|=0x100;
+                buffer[af[ctx->i].offset+2]=0x2;
+                ctx->j|=0x100;
             }
         }
     }
-return j;
+return ctx->j;
 }
 /*****************************************************************************/
-int fixsklstack(unsigned char *buffer,int lenbuff)
+int fixsklstack(P2S *ctx,unsigned char *buffer,int lenbuff)
 {
     int z=0;
     if(lenbuff<0x600)
     {
         return -1;
     }
-    i=0;
-    j=0;
+    ctx->i=0;
+    ctx->j=0;
     z=sizeof(sld0)/sizeof(*sld0);
-    for(i=0;i<z;i++)
+    for(ctx->i=0;ctx->i<z;ctx->i++)
     {
-        if(buffer[sld0[i].offset]!=sld0[i].checkbyte)
+        if(buffer[sld0[ctx->i].offset]!=sld0[ctx->i].checkbyte)
         {
-            j=-1;
+            ctx->j=-1;
             break;
         }
     }
-    if(j!=-1)
+    if(ctx->j!=-1)
+    {
+        for(ctx->i=0;ctx->i<z;ctx->i++)
+        {
+            if(buffer[sld0[ctx->i].offset+2]==0x1)
+            {
+                buffer[sld0[ctx->i].offset+2]=0x2;
+                ctx->j|=0x100;
+            }
+        }
+    }
+return ctx->j;
+}
+/***** Signature index *******************************************************/
+/* The checks that search the whole file for their player (Master Composer,
+   Ubik, GRG Tiny2/4, FlexSid) each rescanned it byte by byte. Their fixed
+   byte sequences are compiled once into an Aho-Corasick automaton, one
+   pass over the file collects the candidate offsets of every such check,
+   and the checks then run their full test only there, in the same order. */
+typedef struct {
+    int check;
+    int offset;  /* of the bytes from the candidate offset */
+    int len;
+    unsigned char bytes[8];
+} SIGPATTERN;
+SIGPATTERN sigpat[]=
+{{SIG_MASTERCOMP,0x02,8,{0xad,0x04,0xd4,0x29,0xfe,0x8d,0x04,0xd4}}
+,{SIG_UBIK      ,0x03,8,{0x30,0x03,0xd0,0x22,0x60,0x18,0x29,0x7f}}
+,{SIG_GRGTINY2  ,0x00,3,{0xa2,0x0e,0x86}}
+,{SIG_GRGTINY2  ,0x00,2,{0xa9,0x60}}
+,{SIG_GRGTINY4  ,0x00,3,{0xa2,0x0e,0xb5}}
+,{SIG_GRGTINY4  ,0x00,3,{0xa2,0x0e,0xb4}}
+,{SIG_GRGTINY4  ,0x00,3,{0xa9,0x00,0xa2}}
+,{SIG_FLEXSID   ,0x00,4,{0xab,0x00,0x95,0xc1}}
+,{SIG_FLEXSID   ,0x00,4,{0xa2,0x3f,0xa9,0x00}}
+};
+#define SIG_PATTERNS ((int)(sizeof(sigpat)/sizeof(*sigpat)))
+#define SIG_MAXSTATES 64
+int sigdelta[SIG_MAXSTATES][256];
+unsigned int sigout[SIG_MAXSTATES]; /* bit x: sigpat[x] ends here */
+
+/* once, before any file is scanned; the automaton is shared read-only */
+void SigBuild(void)
+{
+    int fail[SIG_MAXSTATES],queue[SIG_MAXSTATES];
+    int nstates=1,head=0,tail=0,x,y,c,s,t;
+
+    memset(sigdelta,-1,sizeof(sigdelta));
+    memset(sigout,0,sizeof(sigout));
+    /* trie of all patterns */
+    for(x=0;x<SIG_PATTERNS;x++)
+    {
+        s=0;
+        for(y=0;y<sigpat[x].len;y++)
+        {
+            c=sigpat[x].bytes[y];
+            if(sigdelta[s][c]<0)
+            {
+                sigdelta[s][c]=nstates++;
+            }
+            s=sigdelta[s][c];
+        }
+        sigout[s]|=1u<<x;
+    }
+    /* breadth first: failure links, completing the transitions into a DFA */
+    for(c=0;c<256;c++)
+    {
+        t=sigdelta[0][c];
+        if(t<0)
+        {
+            sigdelta[0][c]=0;
+        }
+        else
+        {
+            fail[t]=0;
+            queue[tail++]=t;
+        }
+    }
+    while(head<tail)
+    {
+        s=queue[head++];
+        for(c=0;c<256;c++)
+        {
+            t=sigdelta[s][c];
+            if(t<0)
+            {
+                sigdelta[s][c]=sigdelta[fail[s]][c];
+            }
+            else
+            {
+                fail[t]=sigdelta[fail[s]][c];
+                sigout[t]|=sigout[fail[t]];
+                queue[tail++]=t;
+            }
+        }
+    }
+}
+
+void SigAdd(P2S *ctx,int check,int offset)
+{
+    if(ctx->signum[check]==ctx->sigmax[check])
+    {
+        ctx->sigmax[check]=ctx->sigmax[check]?ctx->sigmax[check]*2:256;
+        ctx->sigcand[check]=realloc(ctx->sigcand[check],ctx->sigmax[check]*sizeof(int));
+        if(ctx->sigcand[check]==NULL)
+        {
+            printf("alloc error??\n");
+            exit(3);
+        }
+    }
+    ctx->sigcand[check][ctx->signum[check]++]=offset;
+}
+
+int SigCompare(const void *a,const void *b)
+{
+    return *(const int*)a-*(const int*)b;
+}
+
+/* one pass over p/fsiz, before the checks run */
+void SigScan(P2S *ctx)
+{
+    int x,y,n,s=0;
+    unsigned int out;
+
+    memset(ctx->signum,0,sizeof(ctx->signum));
+    for(x=0;x<ctx->fsiz;x++)
+    {
+        s=sigdelta[s][ctx->p[x]];
+        for(out=sigout[s],y=0;out;out>>=1,y++)
+        {
+            if((out&1)&&(x+1-sigpat[y].len-sigpat[y].offset>=0))
+            {
+                SigAdd(ctx,sigpat[y].check,x+1-sigpat[y].len-sigpat[y].offset);
+            }
+        }
+    }
+    /* matches come by end offset; sort by candidate, drop duplicates */
+    for(y=0;y<SIG_CHECKS;y++)
     {
-        for(i=0;i<z;i++)
+        qsort(ctx->sigcand[y],ctx->signum[y],sizeof(int),SigCompare);
+        for(x=0,n=0;x<ctx->signum[y];x++)
         {
-            if(buffer[sld0[i].offset+2]==0x1)
+            if((n==0)||(ctx->sigcand[y][x]!=ctx->sigcand[y][n-1]))
             {
-                buffer[sld0[i].offset+2]=0x2;
-                j|=0x100;
+                ctx->sigcand[y][n++]=ctx->sigcand[y][x];
             }
         }
+        ctx->signum[y]=n;
     }
-return j;
 }
 /*****************************************************************************/
 int AdjustJ(int x,int la)
@@ -207,373 +359,373 @@ int CheckJ(int x, int fs)
     return ((x<0)||(x>(fs-1)));
 }
 /*****************************************************************************/
-void AdjFC(void)
+void AdjFC(P2S *ctx)
 {
-    if((p[0x48]==0x20) && (p[0x49]==0xd0))
+    if((ctx->p[0x48]==0x20) && (ctx->p[0x49]==0xd0))
     {
-        p[0x47]=0xea;
-        p[0x48]=0xea;
-        p[0x49]=0xea;
+        ctx->p[0x47]=0xea;
+        ctx->p[0x48]=0xea;
+        ctx->p[0x49]=0xea;
     }
 }
 /* FC 1000/1006 **************************************************************/
-int Chk_FC(void)
+int Chk_FC(P2S *ctx)
 {
-    if(fsiz<0x200) return 0;
-    if((p[0x02]==0x4c) &&
-       (p[0x08]==0xad) &&
-       (p[0x0f]==0xc9) &&
-       ((*(unsigned int*)(p+0x0b)&0xfffff0ff)==0x07F000C9))
-    {
-        playaddr=initaddr+6;
-        AdjFC();
-        strcpy(ids,"FutureComposer");
-        i=fixfc4stack(p+2,fsiz-2);
-        if(i!=-1)
+    if(ctx->fsiz<0x200) return 0;
+    if((ctx->p[0x02]==0x4c) &&
+       (ctx->p[0x08]==0xad) &&
+       (ctx->p[0x0f]==0xc9) &&
+       ((*(unsigned int*)(ctx->p+0x0b)&0xfffff0ff)==0x07F000C9))
+    {
+        ctx->playaddr=ctx->initaddr+6;
+        AdjFC(ctx);
+        strcpy(ctx->ids,"FutureComposer");
+        ctx->i=fixfc4stack(ctx,ctx->p+2,ctx->fsiz-2);
+        if(ctx->i!=-1)
         {
-            strcat(ids," 4.");
-            strcat(ids,((i&1)?"1":"0"));
-            if(i&0x100)
-                strcat(ids," (fixed)");
+            strcat(ctx->ids," 4.");
+            strcat(ctx->ids,((ctx->i&1)?"1":"0"));
+            if(ctx->i&0x100)
+                strcat(ctx->ids," (fixed)");
         }
         return 1;
     }
     return 0;
 }
 /***** FC 1000/102a (MS) *****************************************************/
-int Chk_FCAlt(void)
-{
-    if(fsiz<0x200) return 0;
-    if((p[0x02]==0x4c) &&
-       (p[0x03]==0x08) && /*(p[0x08]!=0xad) &&*/
-       (p[0x2c]==0xee) &&
-       (p[0x2d]==0x42) &&
-       (p[0x2f]==0xee) &&
-       (p[0x30]==0x43)
+int Chk_FCAlt(P2S *ctx)
+{
+    if(ctx->fsiz<0x200) return 0;
+    if((ctx->p[0x02]==0x4c) &&
+       (ctx->p[0x03]==0x08) && /*(p[0x08]!=0xad) &&*/
+       (ctx->p[0x2c]==0xee) &&
+       (ctx->p[0x2d]==0x42) &&
+       (ctx->p[0x2f]==0xee) &&
+       (ctx->p[0x30]==0x43)
       )
     {
-        playaddr=initaddr+0x2a;
-        AdjFC();
-        strcpy(ids,"FutureComposer");
-        strcat(ids," (altered)");
+        ctx->playaddr=ctx->initaddr+0x2a;
+        AdjFC(ctx);
+        strcpy(ctx->ids,"FutureComposer");
+        strcat(ctx->ids," (altered)");
         return 1;
     }
     return 0;
 }
 /***** MusicAss 1048/1021 ****************************************************/
-int Chk_MusAss(void)
+int Chk_MusAss(P2S *ctx)
 {
-    if(fsiz<0x200) return 0;
-    j=-1;
-    for (i=2;i<0x25;i++)
+    if(ctx->fsiz<0x200) return 0;
+    ctx->j=-1;
+    for (ctx->i=2;ctx->i<0x25;ctx->i++)
     {
-        if((*(unsigned int*)(p+i)==0x90CE00A2) &&
-           (*(unsigned int*)(p+0x05+i)==0x26200C30) &&
-           (*(unsigned int*)(p+0x31+i)==0x628D0F29))
+        if((*(unsigned int*)(ctx->p+ctx->i)==0x90CE00A2) &&
+           (*(unsigned int*)(ctx->p+0x05+ctx->i)==0x26200C30) &&
+           (*(unsigned int*)(ctx->p+0x31+ctx->i)==0x628D0F29))
         {
-            j=i;
+            ctx->j=ctx->i;
             break;
         }
     }
-    if(j>=0)
+    if(ctx->j>=0)
     {
 /***** DoubleTracker 1048/1021+1000 2x speed *********************************/
-        if((p[2]==0xad) &&
-           (p[3]==0xd2) &&
-           (*(unsigned int*)(p+0x05)==0x00A205F0) &&
-           (*(unsigned int*)(p+0x19)==0x02A205F0)
+        if((ctx->p[2]==0xad) &&
+           (ctx->p[3]==0xd2) &&
+           (*(unsigned int*)(ctx->p+0x05)==0x00A205F0) &&
+           (*(unsigned int*)(ctx->p+0x19)==0x02A205F0)
           )
         {
-            psidh[P_TIMING  ]=1; // CIA timing
-            k=(loadaddr>>8)-1;
-            initaddr=((k<<8)|0xd8); // $0fd8
-            playaddr=((k<<8)|0xea); // $0fea
-            extrabytes[0]=initaddr&0xff;
-            extrabytes[1]=initaddr>>8;
-            extra=sizeof(aPatchDblTrk);
-            memmove(extrabytes+2,aPatchDblTrk,extra);
-            extrabytes[0x10]=k  ;
-            extrabytes[0x13]=k+1;
-            extrabytes[0x1b]=k  ;
-            extrabytes[0x1e]=k  ;
-            extrabytes[0x21]=k  ;
-            extrabytes[0x24]=k+1;
-            p[0]=0;
-            p[1]=0;
-
-            strcpy(ids,"DoubleTracker");
+            ctx->psidh[P_TIMING  ]=1; // CIA timing
+            ctx->k=(ctx->loadaddr>>8)-1;
+            ctx->initaddr=((ctx->k<<8)|0xd8); // $0fd8
+            ctx->playaddr=((ctx->k<<8)|0xea); // $0fea
+            ctx->extrabytes[0]=ctx->initaddr&0xff;
+            ctx->extrabytes[1]=ctx->initaddr>>8;
+            ctx->extra=sizeof(aPatchDblTrk);
+            memmove(ctx->extrabytes+2,aPatchDblTrk,ctx->extra);
+            ctx->extrabytes[0x10]=ctx->k  ;
+            ctx->extrabytes[0x13]=ctx->k+1;
+            ctx->extrabytes[0x1b]=ctx->k  ;
+            ctx->extrabytes[0x1e]=ctx->k  ;
+            ctx->extrabytes[0x21]=ctx->k  ;
+            ctx->extrabytes[0x24]=ctx->k+1;
+            ctx->p[0]=0;
+            ctx->p[1]=0;
+
+            strcpy(ctx->ids,"DoubleTracker");
             return 1;
         }
         else
         {
-            initaddr=loadaddr+0x48-0x23+i;
-            playaddr=loadaddr+0x21-0x23+i;
-            if( (p[2]==0x4c) &&
-                (p[5]==0x4c) &&
-                (*(unsigned short int*)(p+3)==initaddr) &&
-                (*(unsigned short int*)(p+6)==playaddr) )
+            ctx->initaddr=ctx->loadaddr+0x48-0x23+ctx->i;
+            ctx->playaddr=ctx->loadaddr+0x21-0x23+ctx->i;
+            if( (ctx->p[2]==0x4c) &&
+                (ctx->p[5]==0x4c) &&
+                (*(unsigned short int*)(ctx->p+3)==ctx->initaddr) &&
+                (*(unsigned short int*)(ctx->p+6)==ctx->playaddr) )
             {
-                initaddr=loadaddr  ;
-                playaddr=loadaddr+3;
+                ctx->initaddr=ctx->loadaddr  ;
+                ctx->playaddr=ctx->loadaddr+3;
             }
-            strcpy(ids,"MusicAssembler");
+            strcpy(ctx->ids,"MusicAssembler");
             return 1;
         }
     }
     return 0;
 }
 /***** MusicMixer 1041/107a **************************************************/
-int Chk_MusMix(void)
+int Chk_MusMix(P2S *ctx)
 {
-    if(fsiz<0x200) return 0;
-    j=-1;
-    for (i=2;i<0x2d;i++)
-    {
-        if(p[0x43-0x2b+i]==0xa9&&
-           (*(unsigned int*)(p+0x4b-0x2b+i)==0x0F29D417) &&
-           (*(unsigned int*)(p+0xD4-0x2b+i)==0x2030FAB1) &&
-           (*(unsigned int*)(p+0x7b-0x2b+i)==0xCE00A260))
+    if(ctx->fsiz<0x200) return 0;
+    ctx->j=-1;
+    for (ctx->i=2;ctx->i<0x2d;ctx->i++)
+    {
+        if(ctx->p[0x43-0x2b+ctx->i]==0xa9&&
+           (*(unsigned int*)(ctx->p+0x4b-0x2b+ctx->i)==0x0F29D417) &&
+           (*(unsigned int*)(ctx->p+0xD4-0x2b+ctx->i)==0x2030FAB1) &&
+           (*(unsigned int*)(ctx->p+0x7b-0x2b+ctx->i)==0xCE00A260))
         {
-            j=i;
+            ctx->j=ctx->i;
             break;
         }
     }
-    if(j>=0)
+    if(ctx->j>=0)
     {
-        initaddr=loadaddr+0x41-0x2b+i;
-        playaddr=loadaddr+0x7a-0x2b+i;
-        if( (p[2]==0x4c) &&
-            (p[5]==0x4c) &&
-            (*(unsigned short int*)(p+3)==initaddr) &&
-            (*(unsigned short int*)(p+6)==playaddr) )
+        ctx->initaddr=ctx->loadaddr+0x41-0x2b+ctx->i;
+        ctx->playaddr=ctx->loadaddr+0x7a-0x2b+ctx->i;
+        if( (ctx->p[2]==0x4c) &&
+            (ctx->p[5]==0x4c) &&
+            (*(unsigned short int*)(ctx->p+3)==ctx->initaddr) &&
+            (*(unsigned short int*)(ctx->p+6)==ctx->playaddr) )
         {
-            initaddr=loadaddr  ;
-            playaddr=loadaddr+3;
+            ctx->initaddr=ctx->loadaddr  ;
+            ctx->playaddr=ctx->loadaddr+3;
         }
-        strcpy(ids,"MusicMixer");
+        strcpy(ctx->ids,"MusicMixer");
         return 1;
     }
     return 0;
 }
 /***** GMC 18ea/14ea *********************************************************/
-int Chk_GMC(void)
+int Chk_GMC(P2S *ctx)
 {
-    if(fsiz<0x900) return 0;
-    j=-1;
-    for (i=2;i<0x18;i++)
+    if(ctx->fsiz<0x900) return 0;
+    ctx->j=-1;
+    for (ctx->i=2;ctx->i<0x18;ctx->i++)
     {
-        if((*(unsigned int*)(p+0x0d0-0x16+i)==0x18FADDC3) &&
-           (*(unsigned int*)(p+0x0e0-0x16+i)==0x47FBB470) &&
-           (*(unsigned int*)(p+0x1a4-0x16+i)==0x0a0a0a0a))
+        if((*(unsigned int*)(ctx->p+0x0d0-0x16+ctx->i)==0x18FADDC3) &&
+           (*(unsigned int*)(ctx->p+0x0e0-0x16+ctx->i)==0x47FBB470) &&
+           (*(unsigned int*)(ctx->p+0x1a4-0x16+ctx->i)==0x0a0a0a0a))
         {
-            j=i;
+            ctx->j=ctx->i;
             break;
         }
     }
-    if(j>=0)
+    if(ctx->j>=0)
     {
-        initaddr=loadaddr+0x8ea-0x16+i;
-        playaddr=loadaddr+0x4ea-0x16+i;
-        strcpy(ids,"GMC/Superiors");
+        ctx->initaddr=ctx->loadaddr+0x8ea-0x16+ctx->i;
+        ctx->playaddr=ctx->loadaddr+0x4ea-0x16+ctx->i;
+        strcpy(ctx->ids,"GMC/Superiors");
         return 1;
     }
     return 0;
 }
 /***** Bappalander 1000/1018 *************************************************/
-int Chk_Bappalander(void)
+int Chk_Bappalander(P2S *ctx)
 {
-    if(fsiz<0x400) return 0;
-    if((*(unsigned int*)(p+0x002)==0x7DA200A9) &&
-       (*(unsigned int*)(p+0x017)==0xCE60B185) &&
-       (*(unsigned int*)(p+0x215)==0x0a0a0a0a))
-    {
-        initaddr=loadaddr      ;
-        playaddr=loadaddr+0x18;
-        strcpy(ids,"Bappalander");
+    if(ctx->fsiz<0x400) return 0;
+    if((*(unsigned int*)(ctx->p+0x002)==0x7DA200A9) &&
+       (*(unsigned int*)(ctx->p+0x017)==0xCE60B185) &&
+       (*(unsigned int*)(ctx->p+0x215)==0x0a0a0a0a))
+    {
+        ctx->initaddr=ctx->loadaddr      ;
+        ctx->playaddr=ctx->loadaddr+0x18;
+        strcpy(ctx->ids,"Bappalander");
         return 1;
     }
-    if((p[2]==0x4c) &&
-       (*(unsigned int*)(p+0x00c)==0xA9FA10CA) &&
-       (*(unsigned int*)(p+0x084)==0xBDAAB0B1) &&
-       (*(unsigned int*)(p+0x25a)==0x0a0a0a0a))
+    if((ctx->p[2]==0x4c) &&
+       (*(unsigned int*)(ctx->p+0x00c)==0xA9FA10CA) &&
+       (*(unsigned int*)(ctx->p+0x084)==0xBDAAB0B1) &&
+       (*(unsigned int*)(ctx->p+0x25a)==0x0a0a0a0a))
     {
-        initaddr=loadaddr+3   ;
-        playaddr=loadaddr+0   ;
-        strcpy(ids,"Bappalander");
-        strcat(ids,"/SpaceLab");
+        ctx->initaddr=ctx->loadaddr+3   ;
+        ctx->playaddr=ctx->loadaddr+0   ;
+        strcpy(ctx->ids,"Bappalander");
+        strcat(ctx->ids,"/SpaceLab");
         return 1;
     }
     return 0;
 }
 /***** Trackplayer 1140/1287 *************************************************/
-int Chk_TrkPl3(void)
+int Chk_TrkPl3(P2S *ctx)
 {
-    if(fsiz<0x500) return 0;
-    if((*(unsigned int*)(p+0x142)==0x00A900A2) &&
-       (*(unsigned int*)(p+0x148)==0x20E0E8D4) &&
-       (*(unsigned int*)(p+0x289)==0xCA2000A2) &&
-       (*(unsigned int*)(p+0x491)==0x0a0a0a0a))
-    {
-        initaddr=loadaddr+0x140;
-        playaddr=loadaddr+0x287;
-        strcpy(ids,"TrackPlayer");
+    if(ctx->fsiz<0x500) return 0;
+    if((*(unsigned int*)(ctx->p+0x142)==0x00A900A2) &&
+       (*(unsigned int*)(ctx->p+0x148)==0x20E0E8D4) &&
+       (*(unsigned int*)(ctx->p+0x289)==0xCA2000A2) &&
+       (*(unsigned int*)(ctx->p+0x491)==0x0a0a0a0a))
+    {
+        ctx->initaddr=ctx->loadaddr+0x140;
+        ctx->playaddr=ctx->loadaddr+0x287;
+        strcpy(ctx->ids,"TrackPlayer");
         return 1;
     }
     return 0;
 }
 /***** Groovy bits 1003/1000 *************************************************/
-int Chk_Groovy(void)
+int Chk_Groovy(P2S *ctx)
 {
-    if(fsiz<0x200) return 0;
-    if((p[2]==0x4c) &&
-       (*(unsigned int*)(p+0x005)==0x9D8A00A2) )
+    if(ctx->fsiz<0x200) return 0;
+    if((ctx->p[2]==0x4c) &&
+       (*(unsigned int*)(ctx->p+0x005)==0x9D8A00A2) )
     {
-        j=0;
-        k=(p[4]<<8)+p[3]-loadaddr+2;
-        if((*(unsigned int*)(p+k)&0xfffff0ff)==0xAD0330EE)
+        ctx->j=0;
+        ctx->k=(ctx->p[4]<<8)+ctx->p[3]-ctx->loadaddr+2;
+        if((*(unsigned int*)(ctx->p+ctx->k)&0xfffff0ff)==0xAD0330EE)
         {
-            j=1;
+            ctx->j=1;
         }
-        else if((p[k     ]==0xe6)&&
-                (p[k+0x02]==0xa5)&&
-                (p[k+0x01]==p[k+0x03])&&
-                (p[k+0x04]==0xc9))
+        else if((ctx->p[ctx->k     ]==0xe6)&&
+                (ctx->p[ctx->k+0x02]==0xa5)&&
+                (ctx->p[ctx->k+0x01]==ctx->p[ctx->k+0x03])&&
+                (ctx->p[ctx->k+0x04]==0xc9))
         {
-            j=2;
+            ctx->j=2;
         }
-        if(j>0)
+        if(ctx->j>0)
         {
-            initaddr=loadaddr+3;
-            playaddr=loadaddr+0;
-            sprintf(ids,"GroovyBits v%d",j);
+            ctx->initaddr=ctx->loadaddr+3;
+            ctx->playaddr=ctx->loadaddr+0;
+            sprintf(ctx->ids,"GroovyBits v%d",ctx->j);
             return 1;
         }
     }
     return 0;
 }
 /***** Parsec (LoS) 1003/1000 ************************************************/
-int Chk_Parsec(void)
+int Chk_Parsec(P2S *ctx)
 {
-    if(fsiz<0x200) return 0;
-    if((*(unsigned int*)(p+0x0d8)==0x06ADF4F2) &&
-       (*(unsigned int*)(p+0x0e0)==0xD002C974) &&
-       (*(unsigned int*)(p+0x0f4)==0x180A0A00) )
-    {
-        initaddr=loadaddr+3;
-        playaddr=loadaddr+0;
-        strcpy(ids,"Parsec/LoS");
+    if(ctx->fsiz<0x200) return 0;
+    if((*(unsigned int*)(ctx->p+0x0d8)==0x06ADF4F2) &&
+       (*(unsigned int*)(ctx->p+0x0e0)==0xD002C974) &&
+       (*(unsigned int*)(ctx->p+0x0f4)==0x180A0A00) )
+    {
+        ctx->initaddr=ctx->loadaddr+3;
+        ctx->playaddr=ctx->loadaddr+0;
+        strcpy(ctx->ids,"Parsec/LoS");
         return 1;
     }
-    if((*(unsigned int*)(p+0x0db)==0x06ADF4F2) &&
-       (*(unsigned int*)(p+0x0e3)==0xD002C977) &&
-       (*(unsigned int*)(p+0x0fa)==0x180A0A00) )
+    if((*(unsigned int*)(ctx->p+0x0db)==0x06ADF4F2) &&
+       (*(unsigned int*)(ctx->p+0x0e3)==0xD002C977) &&
+       (*(unsigned int*)(ctx->p+0x0fa)==0x180A0A00) )
     {
-        initaddr=loadaddr+3;
-        playaddr=loadaddr+0;
-        strcpy(ids,"Parsec/LoS");
+        ctx->initaddr=ctx->loadaddr+3;
+        ctx->playaddr=ctx->loadaddr+0;
+        strcpy(ctx->ids,"Parsec/LoS");
         return 1;
     }
     return 0;
 }
 /***** Sosperec: TAX+1103/1100 ***********************************************/
-int Chk_Sosperec(void)
-{
-    if(fsiz<0x200) return 0;
-    if((*(unsigned int*)(p+0x010)==0x02020202) &&
-      ((*(unsigned int*)(p+0x102)&0xff00ffff)==0x8E00AA4C) &&
-       (*(unsigned int*)(p+0x132)==0xD4168ED4))
-    {
-        initaddr=loadaddr+0xfc;
-        playaddr=loadaddr+0x100;
-        p[0x0fe]=0xaa;
-        p[0x0ff]=0x4c;
-        p[0x100]=0x03;
-        p[0x101]=(loadaddr+0x100)>>8;
-        strcpy(ids,"Sosperec");
+int Chk_Sosperec(P2S *ctx)
+{
+    if(ctx->fsiz<0x200) return 0;
+    if((*(unsigned int*)(ctx->p+0x010)==0x02020202) &&
+      ((*(unsigned int*)(ctx->p+0x102)&0xff00ffff)==0x8E00AA4C) &&
+       (*(unsigned int*)(ctx->p+0x132)==0xD4168ED4))
+    {
+        ctx->initaddr=ctx->loadaddr+0xfc;
+        ctx->playaddr=ctx->loadaddr+0x100;
+        ctx->p[0x0fe]=0xaa;
+        ctx->p[0x0ff]=0x4c;
+        ctx->p[0x100]=0x03;
+        ctx->p[0x101]=(ctx->loadaddr+0x100)>>8;
+        strcpy(ctx->ids,"Sosperec");
         return 1;
     }
     return 0;
 }
 /***** Soedesoft+hacks *******************************************************/
-int Chk_SoedeSoft(void)
+int Chk_SoedeSoft(P2S *ctx)
 {
-    if(fsiz<0x200) return 0;
-    if(((*(unsigned int*)(p+0x02b)&0xfffff0ff)==0x3399A0A0) &&
-        (*(unsigned int*)(p+0x02f)==0xFAD08803) &&
-        (*(unsigned int*)(p+0x107)==(0x00DA2060|((loadaddr>>8)<<24))) )
+    if(ctx->fsiz<0x200) return 0;
+    if(((*(unsigned int*)(ctx->p+0x02b)&0xfffff0ff)==0x3399A0A0) &&
+        (*(unsigned int*)(ctx->p+0x02f)==0xFAD08803) &&
+        (*(unsigned int*)(ctx->p+0x107)==(0x00DA2060|((ctx->loadaddr>>8)<<24))) )
     {
-        if(p[2]==0x4c)
+        if(ctx->p[2]==0x4c)
         {
-            initaddr=loadaddr;
-            p[3]=0x29;
-            p[4]=loadaddr>>8;
+            ctx->initaddr=ctx->loadaddr;
+            ctx->p[3]=0x29;
+            ctx->p[4]=ctx->loadaddr>>8;
         }
         else
-            initaddr=loadaddr+0x29;
+            ctx->initaddr=ctx->loadaddr+0x29;
 
-        playaddr=loadaddr+0x106;
-        p[0xda]=0x60;
-        if(p[0x142]==0xa9)/* end of irq d019/ea31 */
+        ctx->playaddr=ctx->loadaddr+0x106;
+        ctx->p[0xda]=0x60;
+        if(ctx->p[0x142]==0xa9)/* end of irq d019/ea31 */
         {
-            for(j=0x142;j<0x14a;j++)
-                p[j]=0x60;
+            for(ctx->j=0x142;ctx->j<0x14a;ctx->j++)
+                ctx->p[ctx->j]=0x60;
         }
-        strcpy(ids,"Soedesoft");strcat(ids," v1");
+        strcpy(ctx->ids,"Soedesoft");strcat(ctx->ids," v1");
         return 1;
     }
-    if((p[2]==0x4c) &&
-       (p[5]==0x4c) &&
-       (p[8]==0x4c) &&
-       (*(unsigned int*)(p+0x01a)==0x88033399) &&
-       (*(unsigned int*)(p+0x01e)==0x00A9FAD0))
-    {
-        initaddr=loadaddr;
-        if(p[0x6]==0x7b)
-            playaddr=loadaddr+3;
-        else if(p[0x9]==0x7b)
-            playaddr=loadaddr+6;
+    if((ctx->p[2]==0x4c) &&
+       (ctx->p[5]==0x4c) &&
+       (ctx->p[8]==0x4c) &&
+       (*(unsigned int*)(ctx->p+0x01a)==0x88033399) &&
+       (*(unsigned int*)(ctx->p+0x01e)==0x00A9FAD0))
+    {
+        ctx->initaddr=ctx->loadaddr;
+        if(ctx->p[0x6]==0x7b)
+            ctx->playaddr=ctx->loadaddr+3;
+        else if(ctx->p[0x9]==0x7b)
+            ctx->playaddr=ctx->loadaddr+6;
         else
-            playaddr=loadaddr+0x7b;
-        p[0x5c]=0x60;
-        strcpy(ids,"Soedesoft");strcat(ids," v2");
+            ctx->playaddr=ctx->loadaddr+0x7b;
+        ctx->p[0x5c]=0x60;
+        strcpy(ctx->ids,"Soedesoft");strcat(ctx->ids," v2");
         return 1;
     }
-    if((p[2]==0x4c) &&
-       (p[5]==0x4c) &&
-       (p[6]==0x35) &&
-       (p[8]==0x4c) &&
-       (p[9]==0x7c) &&
-       (*(unsigned int*)(p+0x03b)==0x88033399) &&
-       (*(unsigned int*)(p+0x07d)==0x037CEE60))
-    {
-        initaddr=loadaddr+3;
-        playaddr=loadaddr+6;
-        strcpy(ids,"Soedesoft");strcat(ids," v3");
+    if((ctx->p[2]==0x4c) &&
+       (ctx->p[5]==0x4c) &&
+       (ctx->p[6]==0x35) &&
+       (ctx->p[8]==0x4c) &&
+       (ctx->p[9]==0x7c) &&
+       (*(unsigned int*)(ctx->p+0x03b)==0x88033399) &&
+       (*(unsigned int*)(ctx->p+0x07d)==0x037CEE60))
+    {
+        ctx->initaddr=ctx->loadaddr+3;
+        ctx->playaddr=ctx->loadaddr+6;
+        strcpy(ctx->ids,"Soedesoft");strcat(ctx->ids," v3");
         return 1;
     }
     return 0;
 }
 /***** Prosonix 1000/1009 ****************************************************/
-int Chk_Prosonix1(void)
-{
-    if(fsiz<0x200) return 0;
-    if((p[2]==0x4c) &&
-       (p[5]==0x4c) &&
-       (p[8]==0x4c) &&
-      ((*(unsigned int*)(p+0x00b)&0x00ffffff)==0x00F000A9) &&
-      ((*(unsigned int*)(p+0x00f)&0x00ff00ff)==0x00600010))
-    {
-        j=AdjustJ(p[3]|p[4]<<8,loadaddr);
-        if( !CheckJ(j,fsiz) )
-        {
-            if((p[j+0x00]==0xa9) &&
-               (p[j+0x01]==0x01) &&
-               (p[j+0x02]==0x8d) &&
-               (p[j+0x05]==0xa2) )
-            {
-                initaddr=loadaddr+0;
-                playaddr=loadaddr+9;
-                strcpy(ids,"Prosonix");strcat(ids," v1");
+int Chk_Prosonix1(P2S *ctx)
+{
+    if(ctx->fsiz<0x200) return 0;
+    if((ctx->p[2]==0x4c) &&
+       (ctx->p[5]==0x4c) &&
+       (ctx->p[8]==0x4c) &&
+      ((*(unsigned int*)(ctx->p+0x00b)&0x00ffffff)==0x00F000A9) &&
+      ((*(unsigned int*)(ctx->p+0x00f)&0x00ff00ff)==0x00600010))
+    {
+        ctx->j=AdjustJ(ctx->p[3]|ctx->p[4]<<8,ctx->loadaddr);
+        if( !CheckJ(ctx->j,ctx->fsiz) )
+        {
+            if((ctx->p[ctx->j+0x00]==0xa9) &&
+               (ctx->p[ctx->j+0x01]==0x01) &&
+               (ctx->p[ctx->j+0x02]==0x8d) &&
+               (ctx->p[ctx->j+0x05]==0xa2) )
+            {
+                ctx->initaddr=ctx->loadaddr+0;
+                ctx->playaddr=ctx->loadaddr+9;
+                strcpy(ctx->ids,"Prosonix");strcat(ctx->ids," v1");
                 return 1;
             }
         }
@@ -581,83 +733,83 @@ int Chk_Prosonix1(void)
     return 0;
 }
 /* 4 JMPS ********************************************************************/
-int Chk_4JMPS(void)
+int Chk_4JMPS(P2S *ctx)
 {
-    if(fsiz<0x800) return 0;
-    if((p[0x2]==0x4c) &&
-       (p[0x5]==0x4c) &&
-       (p[0x8]==0x4c) &&
-       (p[0xb]==0x4c))
-    {
-        j=AdjustJ(p[3]|p[4]<<8,loadaddr);
-        if( !CheckJ(j,fsiz) )
+    if(ctx->fsiz<0x800) return 0;
+    if((ctx->p[0x2]==0x4c) &&
+       (ctx->p[0x5]==0x4c) &&
+       (ctx->p[0x8]==0x4c) &&
+       (ctx->p[0xb]==0x4c))
+    {
+        ctx->j=AdjustJ(ctx->p[3]|ctx->p[4]<<8,ctx->loadaddr);
+        if( !CheckJ(ctx->j,ctx->fsiz) )
         {
-            if(*(unsigned int*)(p+j)==0x0C8D03A9)
+            if(*(unsigned int*)(ctx->p+ctx->j)==0x0C8D03A9)
             {
-                j=AdjustJ(p[0xc]|p[0xd]<<8,loadaddr);
-                if( !CheckJ(j,fsiz) )
+                ctx->j=AdjustJ(ctx->p[0xc]|ctx->p[0xd]<<8,ctx->loadaddr);
+                if( !CheckJ(ctx->j,ctx->fsiz) )
                 {
-                    if((p[j+0]==0xad) &&
-                       (p[j+1]==0x0c) &&
-                       (p[j+3]==0xf0) &&
-                       (p[j+8]==0x4c))
+                    if((ctx->p[ctx->j+0]==0xad) &&
+                       (ctx->p[ctx->j+1]==0x0c) &&
+                       (ctx->p[ctx->j+3]==0xf0) &&
+                       (ctx->p[ctx->j+8]==0x4c))
                     {
-                        initaddr=loadaddr+0;
-                        playaddr=loadaddr+9;
-                        strcpy(ids,"Prosonix");strcat(ids," v2");
+                        ctx->initaddr=ctx->loadaddr+0;
+                        ctx->playaddr=ctx->loadaddr+9;
+                        strcpy(ctx->ids,"Prosonix");strcat(ctx->ids," v2");
                         return 1;
                     }
                 }
             }
 /***** TFMX/Huelsbeck 1009/1000 **********************************************/
-            if((p[j+0x00]==0xad)&&
-               (p[j+0x03]==0x30)&&
-               (p[j+0x05]==0x20))
-            {
-                j=AdjustJ(p[0xc]|p[0xd]<<8,loadaddr);
-                if((p[j+0x00]==0x8d) &&
-                   (p[j+0x03]==0x8e) &&
-                   (p[j+0x06]==0x60) &&
-                   ((p[j+0x07]==0x18) ||(p[j+0x0c]==0x18)) )
+            if((ctx->p[ctx->j+0x00]==0xad)&&
+               (ctx->p[ctx->j+0x03]==0x30)&&
+               (ctx->p[ctx->j+0x05]==0x20))
+            {
+                ctx->j=AdjustJ(ctx->p[0xc]|ctx->p[0xd]<<8,ctx->loadaddr);
+                if((ctx->p[ctx->j+0x00]==0x8d) &&
+                   (ctx->p[ctx->j+0x03]==0x8e) &&
+                   (ctx->p[ctx->j+0x06]==0x60) &&
+                   ((ctx->p[ctx->j+0x07]==0x18) ||(ctx->p[ctx->j+0x0c]==0x18)) )
                 {
-                    initaddr=loadaddr+9;
-                    playaddr=loadaddr+0;
-                    strcpy(ids,"TFMX/Huelsbeck");
+                    ctx->initaddr=ctx->loadaddr+9;
+                    ctx->playaddr=ctx->loadaddr+0;
+                    strcpy(ctx->ids,"TFMX/Huelsbeck");
                     return 1;
                 }
             }
 /***** Heathcliff/DigitalArts 1009/1000 **************************************/
 /***** "Forgot to give a name player Rene Lergner"****************************/
-            if(((*(unsigned int*)(p+j+0   )&0xffff00ff)==0xFBF000A9)&&
-               ((*(unsigned int*)(p+j+0x04)&0x00fff0ff)==0x008d00a9)&&
-               ((*(unsigned int*)(p+j+0x09)&0x00ffffff)==0x002000a2)&&
-               ((*(unsigned int*)(p+j+0x0e)&0x00ffffff)==0x002007a2)
+            if(((*(unsigned int*)(ctx->p+ctx->j+0   )&0xffff00ff)==0xFBF000A9)&&
+               ((*(unsigned int*)(ctx->p+ctx->j+0x04)&0x00fff0ff)==0x008d00a9)&&
+               ((*(unsigned int*)(ctx->p+ctx->j+0x09)&0x00ffffff)==0x002000a2)&&
+               ((*(unsigned int*)(ctx->p+ctx->j+0x0e)&0x00ffffff)==0x002007a2)
               )
             {
-                initaddr=loadaddr+9;
-                playaddr=loadaddr+0;
-                strcpy(ids,"Heathcliff");strcat(ids," v1");
+                ctx->initaddr=ctx->loadaddr+9;
+                ctx->playaddr=ctx->loadaddr+0;
+                strcpy(ctx->ids,"Heathcliff");strcat(ctx->ids," v1");
                 return 1;
             }
 /***** DMC 4.x with patch at $0ff9 1000/1003 *********************************/
-            k=loadaddr>>8;
-            if(((*(unsigned int*)(p+2+0   )&0xff00ffff)==0x4C001d4c)&&
-               ((*(unsigned int*)(p+2+0x04)&0xffff00ff)==0x2F4C0085)&&
-               ((*(unsigned int*)(p+2+0xdf)&0xff00ffff)==0x4C00F920)&&
-               (p[2+0xe1]==k-1)
+            ctx->k=ctx->loadaddr>>8;
+            if(((*(unsigned int*)(ctx->p+2+0   )&0xff00ffff)==0x4C001d4c)&&
+               ((*(unsigned int*)(ctx->p+2+0x04)&0xffff00ff)==0x2F4C0085)&&
+               ((*(unsigned int*)(ctx->p+2+0xdf)&0xff00ffff)==0x4C00F920)&&
+               (ctx->p[2+0xe1]==ctx->k-1)
               )
             {
-                initaddr=loadaddr+0;
-                playaddr=loadaddr+3;
-                j=((k-1)<<8)|0xf9;
-                extrabytes[0]=j&0xff;
-                extrabytes[1]=j>>8;
-                memmove(extrabytes+2,aPatchDMC4f9,sizeof(aPatchDMC4f9));
-                extrabytes[2+5] = (k+7);
-                extra=sizeof(aPatchDMC4f9);
-                p[0]=extrabytes[2+5] = (k+7);
-                p[1]=aPatchDMC4f9[sizeof(aPatchDMC4f9)-1];
-                sprintf(ids,"DMC 4.x + patch @ $%02xf9",k-1);
+                ctx->initaddr=ctx->loadaddr+0;
+                ctx->playaddr=ctx->loadaddr+3;
+                ctx->j=((ctx->k-1)<<8)|0xf9;
+                ctx->extrabytes[0]=ctx->j&0xff;
+                ctx->extrabytes[1]=ctx->j>>8;
+                memmove(ctx->extrabytes+2,aPatchDMC4f9,sizeof(aPatchDMC4f9));
+                ctx->extrabytes[2+5] = (ctx->k+7);
+                ctx->extra=sizeof(aPatchDMC4f9);
+                ctx->p[0]=ctx->extrabytes[2+5] = (ctx->k+7);
+                ctx->p[1]=aPatchDMC4f9[sizeof(aPatchDMC4f9)-1];
+                sprintf(ctx->ids,"DMC 4.x + patch @ $%02xf9",ctx->k-1);
                 return 1;
 
             }
@@ -666,24 +818,24 @@ int Chk_4JMPS(void)
     return 0;
 }
 /***** Heathcliff/DigitalArts v3 1003/1000 ***********************************/
-int Chk_Heathcliff(void)
+int Chk_Heathcliff(P2S *ctx)
 {
-    if(fsiz<0x800) return 0;
-    if((p[0x2]==0x4c) &&
-       (p[0x5]==0xa9) &&
-       (p[0xa]==0xa2) )
+    if(ctx->fsiz<0x800) return 0;
+    if((ctx->p[0x2]==0x4c) &&
+       (ctx->p[0x5]==0xa9) &&
+       (ctx->p[0xa]==0xa2) )
     {
-        j=AdjustJ(p[3]|p[4]<<8,loadaddr);
-        if( !CheckJ(j,fsiz) )
+        ctx->j=AdjustJ(ctx->p[3]|ctx->p[4]<<8,ctx->loadaddr);
+        if( !CheckJ(ctx->j,ctx->fsiz) )
         {
-            if(((*(unsigned int*)(p+j+0   )&0x00ffffff)==0x00F015A9) &&
-               ((*(unsigned int*)(p+j+0x04)&0x00ffffff)==0x002000a2)&&
-               ((*(unsigned int*)(p+j+0x09)&0x00ffffff)==0x002007a2)
+            if(((*(unsigned int*)(ctx->p+ctx->j+0   )&0x00ffffff)==0x00F015A9) &&
+               ((*(unsigned int*)(ctx->p+ctx->j+0x04)&0x00ffffff)==0x002000a2)&&
+               ((*(unsigned int*)(ctx->p+ctx->j+0x09)&0x00ffffff)==0x002007a2)
               )
             {
-                initaddr=loadaddr+3;
-                playaddr=loadaddr+0;
-                strcpy(ids,"Heathcliff");strcat(ids," v3");
+                ctx->initaddr=ctx->loadaddr+3;
+                ctx->playaddr=ctx->loadaddr+0;
+                strcpy(ctx->ids,"Heathcliff");strcat(ctx->ids," v3");
                 return 1;
             }
         }
@@ -691,56 +843,56 @@ int Chk_Heathcliff(void)
     return 0;
 }
 /***** Prosonix v3 1000/1006 *************************************************/
-int Chk_3JMPs1(void)
+int Chk_3JMPs1(P2S *ctx)
 {
-    if(fsiz<0x400) return 0;
-    if((p[0x2]==0x4c) &&
-       (p[0x5]==0x4c) &&
-       (p[0x8]==0x4c) &&
-       (p[0xb]!=0x4c))
-    {
-        j=AdjustJ(p[3]|p[4]<<8,loadaddr);
-        if( !CheckJ(j,fsiz) )
+    if(ctx->fsiz<0x400) return 0;
+    if((ctx->p[0x2]==0x4c) &&
+       (ctx->p[0x5]==0x4c) &&
+       (ctx->p[0x8]==0x4c) &&
+       (ctx->p[0xb]!=0x4c))
+    {
+        ctx->j=AdjustJ(ctx->p[3]|ctx->p[4]<<8,ctx->loadaddr);
+        if( !CheckJ(ctx->j,ctx->fsiz) )
         {
-            if((*(unsigned short int*)(p+j)==0x03A9) &&(p[j+2]==0x8d))
+            if((*(unsigned short int*)(ctx->p+ctx->j)==0x03A9) &&(ctx->p[ctx->j+2]==0x8d))
             {
-                k=p[j+3];
-                j=AdjustJ(p[0x9]|p[0xa]<<8,loadaddr);
-                if( !CheckJ(j,fsiz) )
+                ctx->k=ctx->p[ctx->j+3];
+                ctx->j=AdjustJ(ctx->p[0x9]|ctx->p[0xa]<<8,ctx->loadaddr);
+                if( !CheckJ(ctx->j,ctx->fsiz) )
                 {
-                    if((p[j+0]==0xad) &&
-                       (p[j+1]==k   ) &&
-                       (p[j+3]==0xf0) &&
-                       (p[j+8]==0x4c))
+                    if((ctx->p[ctx->j+0]==0xad) &&
+                       (ctx->p[ctx->j+1]==ctx->k   ) &&
+                       (ctx->p[ctx->j+3]==0xf0) &&
+                       (ctx->p[ctx->j+8]==0x4c))
                     {
-                        initaddr=loadaddr+0;
-                        playaddr=loadaddr+6;
-                        strcpy(ids,"Prosonix");strcat(ids," v3");
+                        ctx->initaddr=ctx->loadaddr+0;
+                        ctx->playaddr=ctx->loadaddr+6;
+                        strcpy(ctx->ids,"Prosonix");strcat(ctx->ids," v3");
                         return 1;
                     }
                 }
             }
 /***** Heathcliff/DigitalArts v2 1006/1000 ***********************************/
-            if(((*(unsigned int*)(p+j+0   )&0x00ff00ff)==0x00F000A9) &&
-               ((*(unsigned int*)(p+j+0x04)&0x00ffffff)==0x002000a2) &&
-               ((*(unsigned int*)(p+j+0x09)&0x00ffffff)==0x002007a2)
+            if(((*(unsigned int*)(ctx->p+ctx->j+0   )&0x00ff00ff)==0x00F000A9) &&
+               ((*(unsigned int*)(ctx->p+ctx->j+0x04)&0x00ffffff)==0x002000a2) &&
+               ((*(unsigned int*)(ctx->p+ctx->j+0x09)&0x00ffffff)==0x002007a2)
               )
             {
-                initaddr=loadaddr+6;
-                playaddr=loadaddr+0;
-                strcpy(ids,"Heathcliff");strcat(ids," v2");
+                ctx->initaddr=ctx->loadaddr+6;
+                ctx->playaddr=ctx->loadaddr+0;
+                strcpy(ctx->ids,"Heathcliff");strcat(ctx->ids," v2");
                 return 1;
             }
 /***** Frank Hammer/Sharon 1000/1006 *****************************************/
-            if( (*(unsigned short int*)(p + j) == 0x10AD) &&
-                (p[j + 0x03] == 0x8d) &&
-                (p[j + 0x32] == 0x60) &&
-                (*(unsigned int*)(p + j + 0x33) == 0x18F003C0)
+            if( (*(unsigned short int*)(ctx->p + ctx->j) == 0x10AD) &&
+                (ctx->p[ctx->j + 0x03] == 0x8d) &&
+                (ctx->p[ctx->j + 0x32] == 0x60) &&
+                (*(unsigned int*)(ctx->p + ctx->j + 0x33) == 0x18F003C0)
               )
             {
-                initaddr = loadaddr + 0;
-                playaddr = loadaddr + 6;
-                strcpy(ids, "Frank Hammer");
+                ctx->initaddr = ctx->loadaddr + 0;
+                ctx->playaddr = ctx->loadaddr + 6;
+                strcpy(ctx->ids, "Frank Hammer");
                 return 1;
             }
         }
@@ -748,35 +900,35 @@ int Chk_3JMPs1(void)
     return 0;
 }
 /***** Arne/AFL 1000/1009 ****************************************************/
-int Chk_ArneAFL(void)
+int Chk_ArneAFL(P2S *ctx)
 {
-    if(fsiz<0x400) return 0;
-    if((p[0x2]==0x4c) &&
-       (p[0x5]==0x4c) &&
-       (p[0x8]==0x4c) &&
-       (p[0xb]==0x4c))
-    {
-        j=AdjustJ(p[3]|p[4]<<8,loadaddr);
-        if( !CheckJ(j,fsiz) )
+    if(ctx->fsiz<0x400) return 0;
+    if((ctx->p[0x2]==0x4c) &&
+       (ctx->p[0x5]==0x4c) &&
+       (ctx->p[0x8]==0x4c) &&
+       (ctx->p[0xb]==0x4c))
+    {
+        ctx->j=AdjustJ(ctx->p[3]|ctx->p[4]<<8,ctx->loadaddr);
+        if( !CheckJ(ctx->j,ctx->fsiz) )
         {
-            if(*(unsigned int*)(p+j)==0x40093F29)
+            if(*(unsigned int*)(ctx->p+ctx->j)==0x40093F29)
             {
-                j=AdjustJ(p[0xc]|p[0xd]<<8,loadaddr);
-                if( !CheckJ(j,fsiz) )
+                ctx->j=AdjustJ(ctx->p[0xc]|ctx->p[0xd]<<8,ctx->loadaddr);
+                if( !CheckJ(ctx->j,ctx->fsiz) )
                 {
-                    if((p[j+0]==0x2c) &&
-                       (p[j+3]==0x30) &&
-                       (p[j+5]==0x70) &&
-                       (p[j+7]==0xa9))
+                    if((ctx->p[ctx->j+0]==0x2c) &&
+                       (ctx->p[ctx->j+3]==0x30) &&
+                       (ctx->p[ctx->j+5]==0x70) &&
+                       (ctx->p[ctx->j+7]==0xa9))
                     {
-                        initaddr=loadaddr+0;
-                        playaddr=loadaddr+9;
-                        strcpy(ids,"Arne/AFL");
-                        k=0x5b;
-                        if(*(unsigned int*)(p+k)==0xc9dd0ead)
+                        ctx->initaddr=ctx->loadaddr+0;
+                        ctx->playaddr=ctx->loadaddr+9;
+                        strcpy(ctx->ids,"Arne/AFL");
+                        ctx->k=0x5b;
+                        if(*(unsigned int*)(ctx->p+ctx->k)==0xc9dd0ead)
                         {
-                            memmove(p+k,aPatchArneDD,sizeof(aPatchArneDD));
-                            strcat(ids," (fixed)");
+                            memmove(ctx->p+ctx->k,aPatchArneDD,sizeof(aPatchArneDD));
+                            strcat(ctx->ids," (fixed)");
                         }
                         return 1;
                     }
@@ -787,193 +939,193 @@ int Chk_ArneAFL(void)
     return 0;
 }
 /***** Arne/SoundMaker v4 1000/1006 or 1020/1026 *****************************/
-int Chk_ArneSndMk(void)
+int Chk_ArneSndMk(P2S *ctx)
 {
-    if(fsiz<0x400) return 0;
-    i=0;
-    for(k=0;k<=0x20;k+=0x20)
+    if(ctx->fsiz<0x400) return 0;
+    ctx->i=0;
+    for(ctx->k=0;ctx->k<=0x20;ctx->k+=0x20)
     {
-        if((p[2+k]==0x4c) &&
-           (p[5+k]!=0x4c) &&
-           (p[8+k]==0x4c) )
+        if((ctx->p[2+ctx->k]==0x4c) &&
+           (ctx->p[5+ctx->k]!=0x4c) &&
+           (ctx->p[8+ctx->k]==0x4c) )
         {
-            j=AdjustJ( p[9+k]|p[10+k]<<8,loadaddr);
-            if( CheckJ(j,fsiz) )
+            ctx->j=AdjustJ( ctx->p[9+ctx->k]|ctx->p[10+ctx->k]<<8,ctx->loadaddr);
+            if( CheckJ(ctx->j,ctx->fsiz) )
             {
                 break;
             }
-            if((p[j  ]==0xad) &&
-               (*(unsigned int*)(p+j+3)==0x60F001C9))
+            if((ctx->p[ctx->j  ]==0xad) &&
+               (*(unsigned int*)(ctx->p+ctx->j+3)==0x60F001C9))
             {
-                initaddr=loadaddr+k+0;
-                playaddr=loadaddr+k+6;
-                strcpy(ids,"SoundMaker");strcat(ids," v4/Arne");
-                i=1;
+                ctx->initaddr=ctx->loadaddr+ctx->k+0;
+                ctx->playaddr=ctx->loadaddr+ctx->k+6;
+                strcpy(ctx->ids,"SoundMaker");strcat(ctx->ids," v4/Arne");
+                ctx->i=1;
                 break;
             }
         }
     }
-    return i;
+    return ctx->i;
 }
 /***** Digitalizer 2.x by Olav/PD 1003/1006 (normal version is 1000/1003) ****/
-int Chk_Digitalizer(void)
-{
-    if(fsiz<0x200) return 0;
-    if((p[2]==0x4c) &&
-       (p[5]==0x4c) &&
-       (p[8]==0x20) &&
-       (*(unsigned int*)(p+0x0B)==0x10033DCE) &&
-       (*(unsigned int*)(p+0x1B)==0xADFAD0CA))
-    {
-        initaddr=loadaddr+3;
-        playaddr=loadaddr+6;
-        strcpy(ids,"Digitalizer 2.x");
+int Chk_Digitalizer(P2S *ctx)
+{
+    if(ctx->fsiz<0x200) return 0;
+    if((ctx->p[2]==0x4c) &&
+       (ctx->p[5]==0x4c) &&
+       (ctx->p[8]==0x20) &&
+       (*(unsigned int*)(ctx->p+0x0B)==0x10033DCE) &&
+       (*(unsigned int*)(ctx->p+0x1B)==0xADFAD0CA))
+    {
+        ctx->initaddr=ctx->loadaddr+3;
+        ctx->playaddr=ctx->loadaddr+6;
+        strcpy(ctx->ids,"Digitalizer 2.x");
         return 1;
     }
     return 0;
 }
 /***** Soundmon c000/c020 + patch ********************************************/
-int Chk_Soundmon(void)
+int Chk_Soundmon(P2S *ctx)
 {
-    if((fsiz+loadaddr>0xcb00) &&
-       (fsiz>0x2b00) &&
-       (loadaddr<=0xa000) )
+    if((ctx->fsiz+ctx->loadaddr>0xcb00) &&
+       (ctx->fsiz>0x2b00) &&
+       (ctx->loadaddr<=0xa000) )
     {
-        if((*(unsigned int*)(p+0xc000-loadaddr+2)==0x4cc0124c) &&
-           (*(unsigned int*)(p+0xc020-loadaddr+2)==0xC58D01A5))
+        if((*(unsigned int*)(ctx->p+0xc000-ctx->loadaddr+2)==0x4cc0124c) &&
+           (*(unsigned int*)(ctx->p+0xc020-ctx->loadaddr+2)==0xC58D01A5))
         {
-            if( (*(unsigned int*)(p+0xc029-loadaddr+2)==0xADCBE120) )
+            if( (*(unsigned int*)(ctx->p+0xc029-ctx->loadaddr+2)==0xADCBE120) )
             {
-                initaddr=0xce30;
-                playaddr=0;
-                psidh[P_MARKER  ]='R';
-                psidh[P_FREEPAGE]=8; // freepages
-                psidh[P_FREEPMAX]=(loadaddr>>8)-8;
-                sprintf(ids,"DUSAT/RockMon%s","3h");
+                ctx->initaddr=0xce30;
+                ctx->playaddr=0;
+                ctx->psidh[P_MARKER  ]='R';
+                ctx->psidh[P_FREEPAGE]=8; // freepages
+                ctx->psidh[P_FREEPMAX]=(ctx->loadaddr>>8)-8;
+                sprintf(ctx->ids,"DUSAT/RockMon%s","3h");
             }
-            else if( (*(unsigned int*)(p+0xc029-loadaddr+2)==0xAD80a020) )
+            else if( (*(unsigned int*)(ctx->p+0xc029-ctx->loadaddr+2)==0xAD80a020) )
             {
-                initaddr=0xc000;
-                playaddr=0;
-                psidh[P_MARKER  ]='R';
-                psidh[P_FREEPAGE]=8; // freepages
-                psidh[P_FREEPMAX]=(loadaddr>>8)-8;
-                j=initaddr-loadaddr+2;
-                memmove(p+j,aPatchRckmon,sizeof(aPatchRckmon));
-                sprintf(ids,"DUSAT/RockMon%s","2");
+                ctx->initaddr=0xc000;
+                ctx->playaddr=0;
+                ctx->psidh[P_MARKER  ]='R';
+                ctx->psidh[P_FREEPAGE]=8; // freepages
+                ctx->psidh[P_FREEPMAX]=(ctx->loadaddr>>8)-8;
+                ctx->j=ctx->initaddr-ctx->loadaddr+2;
+                memmove(ctx->p+ctx->j,aPatchRckmon,sizeof(aPatchRckmon));
+                sprintf(ctx->ids,"DUSAT/RockMon%s","2");
             }
             else
             {
-                initaddr=0xc000;
-                playaddr=0xc020;
-                j=initaddr-loadaddr+2;
-                memmove(p+j,aPatchSndmon,sizeof(aPatchSndmon));
-                p[0xc031-loadaddr+2]=0x60;
-                psidh[P_TIMING  ]=1; // CIA timing, not always needed
-                psidh[P_FREEPAGE]=8; // freepages
-                psidh[P_FREEPMAX]=(loadaddr>>8)-8;
-                strcpy(ids,"SoundMonitor");
+                ctx->initaddr=0xc000;
+                ctx->playaddr=0xc020;
+                ctx->j=ctx->initaddr-ctx->loadaddr+2;
+                memmove(ctx->p+ctx->j,aPatchSndmon,sizeof(aPatchSndmon));
+                ctx->p[0xc031-ctx->loadaddr+2]=0x60;
+                ctx->psidh[P_TIMING  ]=1; // CIA timing, not always needed
+                ctx->psidh[P_FREEPAGE]=8; // freepages
+                ctx->psidh[P_FREEPMAX]=(ctx->loadaddr>>8)-8;
+                strcpy(ctx->ids,"SoundMonitor");
             }
             return 1;
         }
-        if((*(unsigned int*)(p+0xc000-loadaddr+2)==0x4cc0124c) &&
-           (*(unsigned int*)(p+0xc01d-loadaddr+2)==0x0E8E00a2))
-        {
-            if((*(unsigned int*)(p+0x9fd0-loadaddr+2)==0x018536a9) &&
-               (*(unsigned int*)(p+0x9fdb-loadaddr+2)==0x8D9FA99F) )
-            {
-                initaddr=0x9fd0;
-                playaddr=0;
-                psidh[P_MARKER  ]='R';
-                psidh[P_FREEPAGE]=8; // freepages
-                psidh[P_FREEPMAX]=(loadaddr>>8)-8;
-                j=0x9fe1-loadaddr+2;
-                p[j++]=0x20; // some have this nopped, restored.
-                p[j++]=0x12;
-                p[j++]=0xc0;
-                sprintf(ids,"DUSAT/RockMon%s","4");
+        if((*(unsigned int*)(ctx->p+0xc000-ctx->loadaddr+2)==0x4cc0124c) &&
+           (*(unsigned int*)(ctx->p+0xc01d-ctx->loadaddr+2)==0x0E8E00a2))
+        {
+            if((*(unsigned int*)(ctx->p+0x9fd0-ctx->loadaddr+2)==0x018536a9) &&
+               (*(unsigned int*)(ctx->p+0x9fdb-ctx->loadaddr+2)==0x8D9FA99F) )
+            {
+                ctx->initaddr=0x9fd0;
+                ctx->playaddr=0;
+                ctx->psidh[P_MARKER  ]='R';
+                ctx->psidh[P_FREEPAGE]=8; // freepages
+                ctx->psidh[P_FREEPMAX]=(ctx->loadaddr>>8)-8;
+                ctx->j=0x9fe1-ctx->loadaddr+2;
+                ctx->p[ctx->j++]=0x20; // some have this nopped, restored.
+                ctx->p[ctx->j++]=0x12;
+                ctx->p[ctx->j++]=0xc0;
+                sprintf(ctx->ids,"DUSAT/RockMon%s","4");
                 return 1;
             }
-            if((*(unsigned int*)(p+0x9f00-loadaddr+2)==0x8D02C0AD) &&
-               (*(unsigned int*)(p+0x9f04-loadaddr+2)==0x75209F0A) )
-            {
-                initaddr=0xc000;
-                playaddr=0;
-                j=initaddr-loadaddr+2;
-                memmove(p+j,aPatchRckmon,sizeof(aPatchRckmon));
-                psidh[P_MARKER  ]='R';
-                psidh[P_FREEPAGE]=8; // freepages
-                psidh[P_FREEPMAX]=(loadaddr>>8)-8;
-                sprintf(ids,"DUSAT/RockMon%s","3");
+            if((*(unsigned int*)(ctx->p+0x9f00-ctx->loadaddr+2)==0x8D02C0AD) &&
+               (*(unsigned int*)(ctx->p+0x9f04-ctx->loadaddr+2)==0x75209F0A) )
+            {
+                ctx->initaddr=0xc000;
+                ctx->playaddr=0;
+                ctx->j=ctx->initaddr-ctx->loadaddr+2;
+                memmove(ctx->p+ctx->j,aPatchRckmon,sizeof(aPatchRckmon));
+                ctx->psidh[P_MARKER  ]='R';
+                ctx->psidh[P_FREEPAGE]=8; // freepages
+                ctx->psidh[P_FREEPMAX]=(ctx->loadaddr>>8)-8;
+                sprintf(ctx->ids,"DUSAT/RockMon%s","3");
                 return 1;
             }
         }
-        if((*(unsigned int*)(p+0xc000-loadaddr+2)==0x4cc0124c) &&
-           (*(unsigned int*)(p+0xc020-loadaddr+2)==0x4CA90295))
+        if((*(unsigned int*)(ctx->p+0xc000-ctx->loadaddr+2)==0x4cc0124c) &&
+           (*(unsigned int*)(ctx->p+0xc020-ctx->loadaddr+2)==0x4CA90295))
         {
-            initaddr=0xc000;
-            playaddr=0;
-            j=initaddr-loadaddr+2;
-            memmove(p+j,aPatchRckmon,sizeof(aPatchRckmon));
-            psidh[P_MARKER  ]='R';
-            psidh[P_FREEPAGE]=8; // freepages
-            psidh[P_FREEPMAX]=(loadaddr>>8)-8;
-            sprintf(ids,"DUSAT/RockMon%s","5");
+            ctx->initaddr=0xc000;
+            ctx->playaddr=0;
+            ctx->j=ctx->initaddr-ctx->loadaddr+2;
+            memmove(ctx->p+ctx->j,aPatchRckmon,sizeof(aPatchRckmon));
+            ctx->psidh[P_MARKER  ]='R';
+            ctx->psidh[P_FREEPAGE]=8; // freepages
+            ctx->psidh[P_FREEPMAX]=(ctx->loadaddr>>8)-8;
+            sprintf(ctx->ids,"DUSAT/RockMon%s","5");
             return 1;
         }
-        if((*(unsigned int*)(p+0xc000-loadaddr+2)==0x4cc0124c) &&
-           (*(unsigned int*)(p+0xc01d-loadaddr+2)==0x589B0020) &&
-           (*(unsigned int*)(p+0xc02c-loadaddr+2)==0xAD9BA020))
-        {
-            initaddr=0xc000;
-            playaddr=0;
-            j=initaddr-loadaddr+2;
-            memmove(p+j,aPatchRckmon,sizeof(aPatchRckmon));
-            psidh[P_MARKER  ]='R';
-            psidh[P_FREEPAGE]=8; // freepages
-            psidh[P_FREEPMAX]=(loadaddr>>8)-8;
-            strcpy(ids,"MusicMaster 1.3/BB");
+        if((*(unsigned int*)(ctx->p+0xc000-ctx->loadaddr+2)==0x4cc0124c) &&
+           (*(unsigned int*)(ctx->p+0xc01d-ctx->loadaddr+2)==0x589B0020) &&
+           (*(unsigned int*)(ctx->p+0xc02c-ctx->loadaddr+2)==0xAD9BA020))
+        {
+            ctx->initaddr=0xc000;
+            ctx->playaddr=0;
+            ctx->j=ctx->initaddr-ctx->loadaddr+2;
+            memmove(ctx->p+ctx->j,aPatchRckmon,sizeof(aPatchRckmon));
+            ctx->psidh[P_MARKER  ]='R';
+            ctx->psidh[P_FREEPAGE]=8; // freepages
+            ctx->psidh[P_FREEPMAX]=(ctx->loadaddr>>8)-8;
+            strcpy(ctx->ids,"MusicMaster 1.3/BB");
             return 1;
         }
-        if((*(unsigned int*)(p+0xc000-loadaddr+2)==0x4cc0124c) &&
-           (*(unsigned int*)(p+0xc01d-loadaddr+2)==0x589B0020) &&
-           (*(unsigned int*)(p+0xc02c-loadaddr+2)==0xadc47820))
-        {
-            initaddr=0xc000;
-            playaddr=0;
-            j=initaddr-loadaddr+2;
-            memmove(p+j,aPatchRckmon,sizeof(aPatchRckmon));
-            psidh[P_MARKER  ]='R';
-            psidh[P_FREEPAGE]=8; // freepages
-            psidh[P_FREEPMAX]=(loadaddr>>8)-8;
-            strcpy(ids,"BeatBox/KarlXII");
+        if((*(unsigned int*)(ctx->p+0xc000-ctx->loadaddr+2)==0x4cc0124c) &&
+           (*(unsigned int*)(ctx->p+0xc01d-ctx->loadaddr+2)==0x589B0020) &&
+           (*(unsigned int*)(ctx->p+0xc02c-ctx->loadaddr+2)==0xadc47820))
+        {
+            ctx->initaddr=0xc000;
+            ctx->playaddr=0;
+            ctx->j=ctx->initaddr-ctx->loadaddr+2;
+            memmove(ctx->p+ctx->j,aPatchRckmon,sizeof(aPatchRckmon));
+            ctx->psidh[P_MARKER  ]='R';
+            ctx->psidh[P_FREEPAGE]=8; // freepages
+            ctx->psidh[P_FREEPMAX]=(ctx->loadaddr>>8)-8;
+            strcpy(ctx->ids,"BeatBox/KarlXII");
             return 1;
         }
-        if((*(unsigned int*)(p+0xc000-loadaddr+2)==0x4cc0124c) &&
-           (*(unsigned int*)(p+0xc025-loadaddr+2)==0x03148DD4) &&
-           (*(unsigned int*)(p+0xcbdd-loadaddr+2)==0xAD9F0020))
-        {
-            initaddr=0xc000;
-            playaddr=0;
-            j=initaddr-loadaddr+2;
-            memmove(p+j,aPatchRckmon,sizeof(aPatchRckmon));
-            psidh[P_MARKER  ]='R';
-            psidh[P_FREEPAGE]=8; // freepages
-            psidh[P_FREEPMAX]=(loadaddr>>8)-8;
-            strcpy(ids,"Digitronix");
+        if((*(unsigned int*)(ctx->p+0xc000-ctx->loadaddr+2)==0x4cc0124c) &&
+           (*(unsigned int*)(ctx->p+0xc025-ctx->loadaddr+2)==0x03148DD4) &&
+           (*(unsigned int*)(ctx->p+0xcbdd-ctx->loadaddr+2)==0xAD9F0020))
+        {
+            ctx->initaddr=0xc000;
+            ctx->playaddr=0;
+            ctx->j=ctx->initaddr-ctx->loadaddr+2;
+            memmove(ctx->p+ctx->j,aPatchRckmon,sizeof(aPatchRckmon));
+            ctx->psidh[P_MARKER  ]='R';
+            ctx->psidh[P_FREEPAGE]=8; // freepages
+            ctx->psidh[P_FREEPMAX]=(ctx->loadaddr>>8)-8;
+            strcpy(ctx->ids,"Digitronix");
             return 1;
         }
     }
     return 0;
 }
 /***** AMP 2.x 157e/14ce->1000/1003 ******************************************/
-int Chk_AMP2(void)
+int Chk_AMP2(P2S *ctx)
 {
-    if(fsiz<0x600) return 0;
-    if((*(unsigned int*)(p+0x0dc)==0x5F4B3827) &&
-       (*(unsigned int*)(p+0x1A3)==0x5EDE04F0) &&
-       (*(unsigned int*)(p+0x1e8)==0x4a4a4a4a) &&
-       (*(unsigned int*)(p+0x224)==0x0a0a0a0a))
+    if(ctx->fsiz<0x600) return 0;
+    if((*(unsigned int*)(ctx->p+0x0dc)==0x5F4B3827) &&
+       (*(unsigned int*)(ctx->p+0x1A3)==0x5EDE04F0) &&
+       (*(unsigned int*)(ctx->p+0x1e8)==0x4a4a4a4a) &&
+       (*(unsigned int*)(ctx->p+0x224)==0x0a0a0a0a))
     {
         /* found mixed cases:
         internalplayer/init/play
@@ -982,803 +1134,803 @@ int Chk_AMP2(void)
         Better replace the correct ones at 1000/1003
         fix: there are versions using init=$1568 others $157e
         */
-        j=0;
-        if((p[2+0x568]==0xad) &&
-           (p[2+0x569]==0x09))
+        ctx->j=0;
+        if((ctx->p[2+0x568]==0xad) &&
+           (ctx->p[2+0x569]==0x09))
         {
-            j=0x68;
+            ctx->j=0x68;
         }
         else
-        if ((p[2+0x57e]==0xa5) &&
-            (p[2+0x588]==0xad) &&
-            (p[2+0x589]==0x09))
+        if ((ctx->p[2+0x57e]==0xa5) &&
+            (ctx->p[2+0x588]==0xad) &&
+            (ctx->p[2+0x589]==0x09))
         {
-            j=0x7e;
+            ctx->j=0x7e;
         }
-        if(j)
+        if(ctx->j)
         {
-            p[2]=0x4c;
-            p[3]=j;
-            p[4]=(loadaddr>>8)+5;
-            p[5]=0x4c;
-            p[6]=0xce;
-            p[7]=(loadaddr>>8)+4;
-            strcpy(ids,"AMP 2.x");
+            ctx->p[2]=0x4c;
+            ctx->p[3]=ctx->j;
+            ctx->p[4]=(ctx->loadaddr>>8)+5;
+            ctx->p[5]=0x4c;
+            ctx->p[6]=0xce;
+            ctx->p[7]=(ctx->loadaddr>>8)+4;
+            strcpy(ctx->ids,"AMP 2.x");
             return 1;
         }
     }
     return 0;
 }
 /***** FC 3.x ****************************************************************/
-int Chk_FC3x(void)
+int Chk_FC3x(P2S *ctx)
 {
-    if(fsiz<0x200) return 0;
-    if((*(unsigned int*)(p+0x08a)==0x7AA200A9) &&
-       (*(unsigned int*)(p+0x0af)==0x8DF110CA) &&
-       (*(unsigned int*)(p+0x15e)==0x16D0FFC9) &&
-       (p[0x104]==0xAD))
-    {
-        playaddr=loadaddr+6;
-        initaddr=loadaddr;
-        if(p[0x10a]==0x07)
+    if(ctx->fsiz<0x200) return 0;
+    if((*(unsigned int*)(ctx->p+0x08a)==0x7AA200A9) &&
+       (*(unsigned int*)(ctx->p+0x0af)==0x8DF110CA) &&
+       (*(unsigned int*)(ctx->p+0x15e)==0x16D0FFC9) &&
+       (ctx->p[0x104]==0xAD))
+    {
+        ctx->playaddr=ctx->loadaddr+6;
+        ctx->initaddr=ctx->loadaddr;
+        if(ctx->p[0x10a]==0x07)
         {
-            initaddr=loadaddr-2;
-            extrabytes[0]=initaddr&0xff;
-            extrabytes[1]=initaddr>>8;
-            extra=2;
-            p[0]=0xa9;
-            p[1]=0x02;
+            ctx->initaddr=ctx->loadaddr-2;
+            ctx->extrabytes[0]=ctx->initaddr&0xff;
+            ctx->extrabytes[1]=ctx->initaddr>>8;
+            ctx->extra=2;
+            ctx->p[0]=0xa9;
+            ctx->p[1]=0x02;
         }
         /* fix pointers, found wrong ones */
-        j=2;
-        p[j++]=0x4c;
-        p[j++]=0xb4;
-        p[j++]=loadaddr>>8;
-        j=8;
-        p[j++]=0x4c;
-        p[j++]=0x02;
-        p[j++]=(loadaddr>>8)+1;
-        strcpy(ids,"FutureComposer");
-        strcat(ids," 3.x");
+        ctx->j=2;
+        ctx->p[ctx->j++]=0x4c;
+        ctx->p[ctx->j++]=0xb4;
+        ctx->p[ctx->j++]=ctx->loadaddr>>8;
+        ctx->j=8;
+        ctx->p[ctx->j++]=0x4c;
+        ctx->p[ctx->j++]=0x02;
+        ctx->p[ctx->j++]=(ctx->loadaddr>>8)+1;
+        strcpy(ctx->ids,"FutureComposer");
+        strcat(ctx->ids," 3.x");
         return 1;
     }
     return 0;
 }
 /***** Deenen JTS/TC 110a/112c (patch at $1000) ******************************/
-int Chk_MoN_JTS(void)
-{
-    if(fsiz<0x200) return 0;
-    if((p[0x05]==0x4c) &&
-       (p[0x06]==0x2c) &&
-       (*(unsigned int*)(p+0xe2)==0x70A200A9)&&
-       (*(unsigned int*)(p+0xe9)==0xA9FA10CA) )
-    {
-        initaddr=loadaddr+0;
-        playaddr=loadaddr+3;
-        p[2]=0x4c;
-        p[3]=0x0a;
-        p[4]=(loadaddr>>8)+1;
-        strcpy(ids,"MoN/JTS");
+int Chk_MoN_JTS(P2S *ctx)
+{
+    if(ctx->fsiz<0x200) return 0;
+    if((ctx->p[0x05]==0x4c) &&
+       (ctx->p[0x06]==0x2c) &&
+       (*(unsigned int*)(ctx->p+0xe2)==0x70A200A9)&&
+       (*(unsigned int*)(ctx->p+0xe9)==0xA9FA10CA) )
+    {
+        ctx->initaddr=ctx->loadaddr+0;
+        ctx->playaddr=ctx->loadaddr+3;
+        ctx->p[2]=0x4c;
+        ctx->p[3]=0x0a;
+        ctx->p[4]=(ctx->loadaddr>>8)+1;
+        strcpy(ctx->ids,"MoN/JTS");
         return 1;
     }
     return 0;
 }
 /***** 3 JMPs ****************************************************************/
-int Chk_3JMPs2(void)
+int Chk_3JMPs2(P2S *ctx)
 {
-    if(fsiz<0x200) return 0;
-    if((p[2]==0x4c) &&
-       (p[5]==0x4c) &&
-       (p[8]==0x4c))
+    if(ctx->fsiz<0x200) return 0;
+    if((ctx->p[2]==0x4c) &&
+       (ctx->p[5]==0x4c) &&
+       (ctx->p[8]==0x4c))
     {
-        j=AdjustJ( p[6]|p[7]<<8,loadaddr);
-        if( !CheckJ(j,fsiz) )
+        ctx->j=AdjustJ( ctx->p[6]|ctx->p[7]<<8,ctx->loadaddr);
+        if( !CheckJ(ctx->j,ctx->fsiz) )
         {
         /* SIDduzzit 2.07: TAX+1000/1003 *************************************/
-            if((p[j+0x00]==0xa2) &&
-               (p[j+0x02]==0x8e) &&
-               (p[j+0x05]==0xbd) &&
-               (*(unsigned int*)(p+j+0x30)==0xF0F07F29))
+            if((ctx->p[ctx->j+0x00]==0xa2) &&
+               (ctx->p[ctx->j+0x02]==0x8e) &&
+               (ctx->p[ctx->j+0x05]==0xbd) &&
+               (*(unsigned int*)(ctx->p+ctx->j+0x30)==0xF0F07F29))
             {
-                j=AdjustJ(p[3]|p[4]<<8,loadaddr);
-                if( !CheckJ(j,fsiz) )
+                ctx->j=AdjustJ(ctx->p[3]|ctx->p[4]<<8,ctx->loadaddr);
+                if( !CheckJ(ctx->j,ctx->fsiz) )
                 {
-                    if(p[j]!=0xaa)
+                    if(ctx->p[ctx->j]!=0xaa)
                     {
-                        initaddr=loadaddr-1;
-                        extrabytes[0]=initaddr&0xff;
-                        extra=1;
-                        p[0]=initaddr>>8;
-                        p[1]=0xaa;
+                        ctx->initaddr=ctx->loadaddr-1;
+                        ctx->extrabytes[0]=ctx->initaddr&0xff;
+                        ctx->extra=1;
+                        ctx->p[0]=ctx->initaddr>>8;
+                        ctx->p[1]=0xaa;
                     }
-                    sprintf(ids,"SidDuzzIt %s","2.07");
+                    sprintf(ctx->ids,"SidDuzzIt %s","2.07");
                     return 1;
                 }
             }
         /* Anvil 1003/1006 ***************************************************/
-            if ((p[j + 0x00] == 0xa9) &&
-                (p[j + 0x01] == 0x01) &&
-                (p[j + 0x02] == 0x8d) &&
-                (p[j + 0x08] == 0x8d) &&
-                (p[j + 0x0b] == 0xa9)    )
-            {
-                j = AdjustJ(p[9] | p[0xa] << 8, loadaddr);
-                if (!CheckJ(j, fsiz))
+            if ((ctx->p[ctx->j + 0x00] == 0xa9) &&
+                (ctx->p[ctx->j + 0x01] == 0x01) &&
+                (ctx->p[ctx->j + 0x02] == 0x8d) &&
+                (ctx->p[ctx->j + 0x08] == 0x8d) &&
+                (ctx->p[ctx->j + 0x0b] == 0xa9)    )
+            {
+                ctx->j = AdjustJ(ctx->p[9] | ctx->p[0xa] << 8, ctx->loadaddr);
+                if (!CheckJ(ctx->j, ctx->fsiz))
                 {
-                    if(*(unsigned int*)(p + j - 4) == 0x60EE10CA)
+                    if(*(unsigned int*)(ctx->p + ctx->j - 4) == 0x60EE10CA)
                     {
-                        initaddr = loadaddr + 3;
-                        playaddr = loadaddr + 6;
-                        strcpy(ids, "Anvil");
+                        ctx->initaddr = ctx->loadaddr + 3;
+                        ctx->playaddr = ctx->loadaddr + 6;
+                        strcpy(ctx->ids, "Anvil");
                         return 1;
                     }
                 }
             }
         }
-        j=AdjustJ( p[9]|p[0xa]<<8,loadaddr);
-        if( !CheckJ(j,fsiz) )
+        ctx->j=AdjustJ( ctx->p[9]|ctx->p[0xa]<<8,ctx->loadaddr);
+        if( !CheckJ(ctx->j,ctx->fsiz) )
         {
         /* Zardax 1000/1006 **************************************************/
-            if((p[j+0x00]==0xad) &&
-               (*(unsigned int*)(p+j+0x03)==0xCE6001F0) &&
-               (*(unsigned int*)(p+j+0x0a)==0x2002A209))
+            if((ctx->p[ctx->j+0x00]==0xad) &&
+               (*(unsigned int*)(ctx->p+ctx->j+0x03)==0xCE6001F0) &&
+               (*(unsigned int*)(ctx->p+ctx->j+0x0a)==0x2002A209))
             {
-                initaddr=loadaddr;
-                playaddr=loadaddr+6;
-                strcpy(ids,"Zardax");strcat(ids," v1");
+                ctx->initaddr=ctx->loadaddr;
+                ctx->playaddr=ctx->loadaddr+6;
+                strcpy(ctx->ids,"Zardax");strcat(ctx->ids," v1");
                 return 1;
             }
-            if((p[j+0x00]==0xad) &&
-               (p[j-0x01]==0x60) &&
-               (p[j+0x08]==0x8d) &&
-               (p[j+0x0b]==0xa5) &&
-               (*(unsigned int*)(p+j+0x03)==0xa56001F0))
+            if((ctx->p[ctx->j+0x00]==0xad) &&
+               (ctx->p[ctx->j-0x01]==0x60) &&
+               (ctx->p[ctx->j+0x08]==0x8d) &&
+               (ctx->p[ctx->j+0x0b]==0xa5) &&
+               (*(unsigned int*)(ctx->p+ctx->j+0x03)==0xa56001F0))
             {
-                initaddr=loadaddr;
-                playaddr=loadaddr+6;
-                strcpy(ids,"Zardax");strcat(ids," v2");
+                ctx->initaddr=ctx->loadaddr;
+                ctx->playaddr=ctx->loadaddr+6;
+                strcpy(ctx->ids,"Zardax");strcat(ctx->ids," v2");
                 return 1;
             }
         /* Deenen RWE Intro/TC 1000/1006 *************************************/
-            if((p[j+0x00]==0xad) &&
-               (p[j-0x01]==0x60) &&
-               (*(unsigned int*)(p+j+0x03)==0x07f002c9) &&
-               (*(unsigned int*)(p+j+0x08)==0x4c04d001))
-            {
-                initaddr=loadaddr;
-                playaddr=loadaddr+6;
-                strcpy(ids,"MoN/RWE");
+            if((ctx->p[ctx->j+0x00]==0xad) &&
+               (ctx->p[ctx->j-0x01]==0x60) &&
+               (*(unsigned int*)(ctx->p+ctx->j+0x03)==0x07f002c9) &&
+               (*(unsigned int*)(ctx->p+ctx->j+0x08)==0x4c04d001))
+            {
+                ctx->initaddr=ctx->loadaddr;
+                ctx->playaddr=ctx->loadaddr+6;
+                strcpy(ctx->ids,"MoN/RWE");
                 return 1;
             }
         /* Deenen Cyb2 1000/1006 *********************************************/
-            if((p[j+0x00]==0xa9) &&
-               (p[j+0x02]==0xf0) &&
-               (p[j+0x04]==0x60) )
+            if((ctx->p[ctx->j+0x00]==0xa9) &&
+               (ctx->p[ctx->j+0x02]==0xf0) &&
+               (ctx->p[ctx->j+0x04]==0x60) )
             {
-                k=AdjustJ( p[3]|p[4]<<8,loadaddr);
-                if( !CheckJ(k,fsiz) )
+                ctx->k=AdjustJ( ctx->p[3]|ctx->p[4]<<8,ctx->loadaddr);
+                if( !CheckJ(ctx->k,ctx->fsiz) )
                 {
-                    if((((p[k+0x00]==0xa9)&&(p[k+0x02]==0x8d))||
-                        ((p[k+0x00]==0xa2)&&(p[k+0x02]==0x8e)))&&
-                       (p[k+0x01]==0x01)&&
-                       (*(unsigned short int*)(p+k+3)==(unsigned short)((loadaddr+j-1)&0xffff)) )
+                    if((((ctx->p[ctx->k+0x00]==0xa9)&&(ctx->p[ctx->k+0x02]==0x8d))||
+                        ((ctx->p[ctx->k+0x00]==0xa2)&&(ctx->p[ctx->k+0x02]==0x8e)))&&
+                       (ctx->p[ctx->k+0x01]==0x01)&&
+                       (*(unsigned short int*)(ctx->p+ctx->k+3)==(unsigned short)((ctx->loadaddr+ctx->j-1)&0xffff)) )
                     {
-                       initaddr=loadaddr;
-                       playaddr=loadaddr+6;
-                       strcpy(ids,"MoN/Cyb2");
+                       ctx->initaddr=ctx->loadaddr;
+                       ctx->playaddr=ctx->loadaddr+6;
+                       strcpy(ctx->ids,"MoN/Cyb2");
                        return 1;
                     }
                 }
             }
         /* Laxity v4 1000/1006 ***********************************************/
-            if((p[j+0x00]==0xad) &&
-               (p[j-0x01]==0x60) &&
-               (p[j-0x0f]==0x8d) &&
-               (p[j-0x3e]==0xa2) &&
-               (*(unsigned int*)(p+j+0x03)==0xa26001d0))
-            {
-                initaddr=loadaddr;
-                playaddr=loadaddr+6;
-                p[2]=0x4c;
-                i=(j-0x3e -2 + loadaddr);
-                p[3]=i&0xff;
-                p[4]=i>>8;
-                strcpy(ids,"Laxity");strcat(ids," v4");
+            if((ctx->p[ctx->j+0x00]==0xad) &&
+               (ctx->p[ctx->j-0x01]==0x60) &&
+               (ctx->p[ctx->j-0x0f]==0x8d) &&
+               (ctx->p[ctx->j-0x3e]==0xa2) &&
+               (*(unsigned int*)(ctx->p+ctx->j+0x03)==0xa26001d0))
+            {
+                ctx->initaddr=ctx->loadaddr;
+                ctx->playaddr=ctx->loadaddr+6;
+                ctx->p[2]=0x4c;
+                ctx->i=(ctx->j-0x3e -2 + ctx->loadaddr);
+                ctx->p[3]=ctx->i&0xff;
+                ctx->p[4]=ctx->i>>8;
+                strcpy(ctx->ids,"Laxity");strcat(ctx->ids," v4");
                 return 1;
             }
         /* Roland Hermans special case 1006/1000 *****************************/
-            if( (p[j+0x03]==0x8d) &&
-                (p[j+0x12]==0x8d) &&
-                (*(unsigned int*)(p+j+0x06)==0x690a0a0a) &&
-                (*(unsigned int*)(p+j+0x28)==0xA9D4178D))
-            {
-                initaddr=loadaddr+6;
-                playaddr=loadaddr;
-                strcpy(ids,"Roland Hermans");
+            if( (ctx->p[ctx->j+0x03]==0x8d) &&
+                (ctx->p[ctx->j+0x12]==0x8d) &&
+                (*(unsigned int*)(ctx->p+ctx->j+0x06)==0x690a0a0a) &&
+                (*(unsigned int*)(ctx->p+ctx->j+0x28)==0xA9D4178D))
+            {
+                ctx->initaddr=ctx->loadaddr+6;
+                ctx->playaddr=ctx->loadaddr;
+                strcpy(ctx->ids,"Roland Hermans");
                 return 1;
             }
         }
         /* SIDduzzit 0.98: TAX+1000/1003 *************************************/
-        j=AdjustJ( p[3]|p[4]<<8,loadaddr);
-        if( !CheckJ(j,fsiz) )
-        {
-            if((p[j+0x00]==0xbd) &&
-               (p[j+0x03]==0x8d) &&
-               (p[j+0x06]==0x8d) &&
-               (p[j+0x09]==0xbd) )
-            {
-                initaddr=loadaddr-1;
-                extrabytes[0]=initaddr&0xff;
-                extra=1;
-                p[0]=initaddr>>8;
-                p[1]=0xaa;
-                sprintf(ids,"SidDuzzIt %s","0.98");
+        ctx->j=AdjustJ( ctx->p[3]|ctx->p[4]<<8,ctx->loadaddr);
+        if( !CheckJ(ctx->j,ctx->fsiz) )
+        {
+            if((ctx->p[ctx->j+0x00]==0xbd) &&
+               (ctx->p[ctx->j+0x03]==0x8d) &&
+               (ctx->p[ctx->j+0x06]==0x8d) &&
+               (ctx->p[ctx->j+0x09]==0xbd) )
+            {
+                ctx->initaddr=ctx->loadaddr-1;
+                ctx->extrabytes[0]=ctx->initaddr&0xff;
+                ctx->extra=1;
+                ctx->p[0]=ctx->initaddr>>8;
+                ctx->p[1]=0xaa;
+                sprintf(ctx->ids,"SidDuzzIt %s","0.98");
                 return 1;
             }
         /* Laxity v1 1000/1006 ***********************************************/
-            if((*(unsigned int*)(p+j+0x00)==0xA98A00A2) &&
-               (*(unsigned int*)(p+j+0x1b)==0xE49003E0))
+            if((*(unsigned int*)(ctx->p+ctx->j+0x00)==0xA98A00A2) &&
+               (*(unsigned int*)(ctx->p+ctx->j+0x1b)==0xE49003E0))
             {
-                initaddr=loadaddr+0;
-                playaddr=loadaddr+6;
-                strcpy(ids,"Laxity");strcat(ids," v1");
+                ctx->initaddr=ctx->loadaddr+0;
+                ctx->playaddr=ctx->loadaddr+6;
+                strcpy(ctx->ids,"Laxity");strcat(ctx->ids," v1");
                 return 1;
             }
         /* Deenen special case 1006/1000 *************************************/
-            if(((*(unsigned int*)(p+j+0x00)&0xffff00ff)==0x013000A9)&&
-               (p[j+0x04]==0x60)&&
-               (p[j+0x05]==0xad)&&
-               (p[j+0x08]==0xf0))
-            {
-                initaddr=loadaddr+6;
-                playaddr=loadaddr+0;
-                strcpy(ids,"Deenen");
+            if(((*(unsigned int*)(ctx->p+ctx->j+0x00)&0xffff00ff)==0x013000A9)&&
+               (ctx->p[ctx->j+0x04]==0x60)&&
+               (ctx->p[ctx->j+0x05]==0xad)&&
+               (ctx->p[ctx->j+0x08]==0xf0))
+            {
+                ctx->initaddr=ctx->loadaddr+6;
+                ctx->playaddr=ctx->loadaddr+0;
+                strcpy(ctx->ids,"Deenen");
                 return 1;
             }
         }
         /* JO v1, variable 3/4 jmps ******************************************/
-        for(i=2,k=0;i<=2+(4*3);i+=3)
+        for(ctx->i=2,ctx->k=0;ctx->i<=2+(4*3);ctx->i+=3)
         {
-            if(p[i]==0x4c)
+            if(ctx->p[ctx->i]==0x4c)
             {
-                j=AdjustJ( p[i+1]|p[i+2]<<8,loadaddr);
-                if( CheckJ(j,fsiz) )
+                ctx->j=AdjustJ( ctx->p[ctx->i+1]|ctx->p[ctx->i+2]<<8,ctx->loadaddr);
+                if( CheckJ(ctx->j,ctx->fsiz) )
                 {
                     continue;
                 }
-                if( (p[j+0x00]==0xbd) &&
-                    (p[j+0x03]==0x8d) &&
-                    (p[j+0x06]==0xbd) &&
-                    (p[j+0x09]==0x8d) )
+                if( (ctx->p[ctx->j+0x00]==0xbd) &&
+                    (ctx->p[ctx->j+0x03]==0x8d) &&
+                    (ctx->p[ctx->j+0x06]==0xbd) &&
+                    (ctx->p[ctx->j+0x09]==0x8d) )
                 {
-                    k|=1;
-                    initaddr=loadaddr+i-2;
+                    ctx->k|=1;
+                    ctx->initaddr=ctx->loadaddr+ctx->i-2;
                 }
-                else if( (p[j+0x00]==0xa9) &&
-                         (p[j+0x02]==0xd0) &&
-                         (p[j+0x03]==0x01) &&
-                         (p[j+0x04]==0x60) )
+                else if( (ctx->p[ctx->j+0x00]==0xa9) &&
+                         (ctx->p[ctx->j+0x02]==0xd0) &&
+                         (ctx->p[ctx->j+0x03]==0x01) &&
+                         (ctx->p[ctx->j+0x04]==0x60) )
                 {
-                    k|=2;
-                    playaddr=loadaddr+i-2;
+                    ctx->k|=2;
+                    ctx->playaddr=ctx->loadaddr+ctx->i-2;
                 }
             }
         }
-        if(k!=3)
+        if(ctx->k!=3)
         {
-            initaddr=loadaddr;
-            playaddr=initaddr+3;
+            ctx->initaddr=ctx->loadaddr;
+            ctx->playaddr=ctx->initaddr+3;
         }
         else
         {
             /* add TAX */
-            if(initaddr==loadaddr)
+            if(ctx->initaddr==ctx->loadaddr)
             {
-                initaddr--;
-                extrabytes[0]=initaddr&0xff;
-                extra=1;
-                p[0]=initaddr>>8;
-                p[1]=0xaa;
+                ctx->initaddr--;
+                ctx->extrabytes[0]=ctx->initaddr&0xff;
+                ctx->extra=1;
+                ctx->p[0]=ctx->initaddr>>8;
+                ctx->p[1]=0xaa;
             }
             else
             {
-                extra=4;
-                extrabytes[0]=(loadaddr-extra)&0xff;
-                extrabytes[1]=(loadaddr-extra)>>8;
-                extrabytes[2]=0xaa;
-                extrabytes[3]=0x4c;
-                p[0]=initaddr&0xff;
-                p[1]=initaddr>>8;
-                initaddr=loadaddr-extra;
+                ctx->extra=4;
+                ctx->extrabytes[0]=(ctx->loadaddr-ctx->extra)&0xff;
+                ctx->extrabytes[1]=(ctx->loadaddr-ctx->extra)>>8;
+                ctx->extrabytes[2]=0xaa;
+                ctx->extrabytes[3]=0x4c;
+                ctx->p[0]=ctx->initaddr&0xff;
+                ctx->p[1]=ctx->initaddr>>8;
+                ctx->initaddr=ctx->loadaddr-ctx->extra;
             }
-            strcpy(ids,"JO/Vibrants");strcat(ids," v1");
+            strcpy(ctx->ids,"JO/Vibrants");strcat(ctx->ids," v1");
             return 1;
         }
     }
     return 0;
 }
 /***** JO v2, variable 1/3 JMPs but 1st if present is IRQ install ************/
-int Chk_JOv2(void)
+int Chk_JOv2(P2S *ctx)
 {
-    if(fsiz<0x200) return 0;
-    for(i=2,k=0;i<=2+(2*3);i+=3)
+    if(ctx->fsiz<0x200) return 0;
+    for(ctx->i=2,ctx->k=0;ctx->i<=2+(2*3);ctx->i+=3)
     {
-        if(p[i]==0x4c)
+        if(ctx->p[ctx->i]==0x4c)
         {
-            j=AdjustJ( p[i+1]|p[i+2]<<8,loadaddr);
-            if( CheckJ(j,fsiz) )
+            ctx->j=AdjustJ( ctx->p[ctx->i+1]|ctx->p[ctx->i+2]<<8,ctx->loadaddr);
+            if( CheckJ(ctx->j,ctx->fsiz) )
             {
                 continue;
             }
-            if( (p[j+0x00]==0x8d) &&
-                (p[j+0x03]==0x8d) &&
-                (*(unsigned int*)(p+j+0x06)==0xA9A80A0A))
+            if( (ctx->p[ctx->j+0x00]==0x8d) &&
+                (ctx->p[ctx->j+0x03]==0x8d) &&
+                (*(unsigned int*)(ctx->p+ctx->j+0x06)==0xA9A80A0A))
             {
-                k|=1;
-                initaddr=loadaddr+i-2;
+                ctx->k|=1;
+                ctx->initaddr=ctx->loadaddr+ctx->i-2;
                 break;
             }
-            else if((p[j+0x00]==0x8d) &&
-                    (*(unsigned int*)(p+j+0x03)==0xA9A80A0A))
+            else if((ctx->p[ctx->j+0x00]==0x8d) &&
+                    (*(unsigned int*)(ctx->p+ctx->j+0x03)==0xA9A80A0A))
             {
-                k|=1;
-                initaddr=loadaddr+i-2;
+                ctx->k|=1;
+                ctx->initaddr=ctx->loadaddr+ctx->i-2;
                 break;
             }
         }
     }
-    if( k )
+    if( ctx->k )
     {
-        for(j=0;j<0x10;j++)
+        for(ctx->j=0;ctx->j<0x10;ctx->j++)
         {
-            if( (p[i+j+0x03]==0xad) &&
-                (p[i+j+0x06]==0xc9) &&
-                (p[i+j+0x07]==0x01) &&
-                (p[i+j+0x08]==0xf0) &&
-                (p[i+j+0x0a]==0xc9) )
+            if( (ctx->p[ctx->i+ctx->j+0x03]==0xad) &&
+                (ctx->p[ctx->i+ctx->j+0x06]==0xc9) &&
+                (ctx->p[ctx->i+ctx->j+0x07]==0x01) &&
+                (ctx->p[ctx->i+ctx->j+0x08]==0xf0) &&
+                (ctx->p[ctx->i+ctx->j+0x0a]==0xc9) )
             {
-                k|=2;
-                playaddr=initaddr+3;
+                ctx->k|=2;
+                ctx->playaddr=ctx->initaddr+3;
                 break;
             }
         }
     }
-    if(k!=3)
+    if(ctx->k!=3)
     {
-        initaddr=loadaddr;
-        playaddr=initaddr+3;
+        ctx->initaddr=ctx->loadaddr;
+        ctx->playaddr=ctx->initaddr+3;
     }
     else
     {
-        strcpy(ids,"JO/Vibrants");strcat(ids," v2");
+        strcpy(ctx->ids,"JO/Vibrants");strcat(ctx->ids," v2");
         return 1;
     }
     return 0;
 }
 /***** 2 JMPs ****************************************************************/
-int Chk_2JMPs(void)
+int Chk_2JMPs(P2S *ctx)
 {
-    if(fsiz<0x200) return 0;
-    if((p[2]==0x4c) &&
-       (p[5]==0x4c) )
+    if(ctx->fsiz<0x200) return 0;
+    if((ctx->p[2]==0x4c) &&
+       (ctx->p[5]==0x4c) )
     {
-        j=AdjustJ( p[6]|p[7]<<8,loadaddr);
-        if( !CheckJ(j,fsiz) )
+        ctx->j=AdjustJ( ctx->p[6]|ctx->p[7]<<8,ctx->loadaddr);
+        if( !CheckJ(ctx->j,ctx->fsiz) )
         {
         /* XTracker_V4.x 1003/1000 *******************************************/
-            if((p[j+0x00]==0xaa) &&
-               (p[j+0x01]==0xbd) &&
-               (p[j+0x04]==0x8d) )
+            if((ctx->p[ctx->j+0x00]==0xaa) &&
+               (ctx->p[ctx->j+0x01]==0xbd) &&
+               (ctx->p[ctx->j+0x04]==0x8d) )
             {
-                initaddr=loadaddr+3;
-                playaddr=loadaddr+0;
-                sprintf(ids,"XTracker_V4.1%s/LoS","c");
+                ctx->initaddr=ctx->loadaddr+3;
+                ctx->playaddr=ctx->loadaddr+0;
+                sprintf(ctx->ids,"XTracker_V4.1%s/LoS","c");
                 return 1;
             }
         /* Nordicbeat: TAX+1000/1003 *****************************************/
-            if((p[j+0x00]==0xa2) &&
-               (p[j+0x01]==0x00) &&
-               (p[j+0x02]==0xce) &&
-               (p[j+0x05]==0x30) &&
-               (p[j+0x06]==0x09) &&
-               (p[j+0x07]==0x20) &&
-               (p[j+0x0a]==0x20) &&
-               (p[j+0x0d]==0x4c) )
-            {
-                initaddr=loadaddr+6;
-                playaddr=loadaddr+3;
-                k=8;
-                p[k++]=0xaa;
-                p[k++]=0x4c;
-                p[k++]=loadaddr&0xff;
-                p[k++]=loadaddr>>8;
-                strcpy(ids,"NordicBeat");
+            if((ctx->p[ctx->j+0x00]==0xa2) &&
+               (ctx->p[ctx->j+0x01]==0x00) &&
+               (ctx->p[ctx->j+0x02]==0xce) &&
+               (ctx->p[ctx->j+0x05]==0x30) &&
+               (ctx->p[ctx->j+0x06]==0x09) &&
+               (ctx->p[ctx->j+0x07]==0x20) &&
+               (ctx->p[ctx->j+0x0a]==0x20) &&
+               (ctx->p[ctx->j+0x0d]==0x4c) )
+            {
+                ctx->initaddr=ctx->loadaddr+6;
+                ctx->playaddr=ctx->loadaddr+3;
+                ctx->k=8;
+                ctx->p[ctx->k++]=0xaa;
+                ctx->p[ctx->k++]=0x4c;
+                ctx->p[ctx->k++]=ctx->loadaddr&0xff;
+                ctx->p[ctx->k++]=ctx->loadaddr>>8;
+                strcpy(ctx->ids,"NordicBeat");
                 return 1;
             }
         /* ICC/The Voice $1003/$1000 *****************************************/
-            if((*(unsigned int*)(p+j+0x00)==0x00A918A2)&&
-               (*(unsigned int*)(p+j+0x04)==0xCAD4009D)&&
-               (*(unsigned int*)(p+j+0x43)==0x06F0F029)&&
-               (*(unsigned int*)(p+j+0x53)==0x06F0F029)&&
-               (*(unsigned int*)(p+j+0xa9)==0x4A4A4A4A))
-            {
-                initaddr=loadaddr+3;
-                playaddr=loadaddr+0;
-                strcpy(ids,"ICC/The Voice");
+            if((*(unsigned int*)(ctx->p+ctx->j+0x00)==0x00A918A2)&&
+               (*(unsigned int*)(ctx->p+ctx->j+0x04)==0xCAD4009D)&&
+               (*(unsigned int*)(ctx->p+ctx->j+0x43)==0x06F0F029)&&
+               (*(unsigned int*)(ctx->p+ctx->j+0x53)==0x06F0F029)&&
+               (*(unsigned int*)(ctx->p+ctx->j+0xa9)==0x4A4A4A4A))
+            {
+                ctx->initaddr=ctx->loadaddr+3;
+                ctx->playaddr=ctx->loadaddr+0;
+                strcpy(ctx->ids,"ICC/The Voice");
                 return 1;
             }
         /* Bernhard Burgstaller 1003/1000 ************************************/
-            if((*(unsigned int*)(p+j-0x01)==0x8d00a960)&&
-               (*(unsigned int*)(p+j+0x07)==0xA2D4188D)&&
-               (p[j+0x0c]==0x20)&&
-               (p[j+0x0f]==0x20))
-            {
-                initaddr=loadaddr+3;
-                playaddr=loadaddr+0;
-                strcpy(ids,"Burgstaller");strcat(ids," v1");
+            if((*(unsigned int*)(ctx->p+ctx->j-0x01)==0x8d00a960)&&
+               (*(unsigned int*)(ctx->p+ctx->j+0x07)==0xA2D4188D)&&
+               (ctx->p[ctx->j+0x0c]==0x20)&&
+               (ctx->p[ctx->j+0x0f]==0x20))
+            {
+                ctx->initaddr=ctx->loadaddr+3;
+                ctx->playaddr=ctx->loadaddr+0;
+                strcpy(ctx->ids,"Burgstaller");strcat(ctx->ids," v1");
                 return 1;
             }
-            if((*(unsigned int*)(p+j+0x00)==0x00A917A2)&&
-               (*(unsigned int*)(p+j+0x04)==0xCAD4009D)&&
-               (*(unsigned int*)(p+j+0x0f)==0xA2D4188D)&&
-               (p[j+0x14]==0x20)&&
-               (p[j+0x17]==0x20))
+            if((*(unsigned int*)(ctx->p+ctx->j+0x00)==0x00A917A2)&&
+               (*(unsigned int*)(ctx->p+ctx->j+0x04)==0xCAD4009D)&&
+               (*(unsigned int*)(ctx->p+ctx->j+0x0f)==0xA2D4188D)&&
+               (ctx->p[ctx->j+0x14]==0x20)&&
+               (ctx->p[ctx->j+0x17]==0x20))
             {
-                initaddr=loadaddr+3;
-                playaddr=loadaddr+0;
-                strcpy(ids,"Burgstaller");strcat(ids," v2");
+                ctx->initaddr=ctx->loadaddr+3;
+                ctx->playaddr=ctx->loadaddr+0;
+                strcpy(ctx->ids,"Burgstaller");strcat(ctx->ids," v2");
                 return 1;
             }
-            if((p[j     ]==0x8d)&&
-               (p[j+0x03]==0xa2)&&
-               (p[j+0x04]==0x00)&&
-               (p[j+0x05]==0x20)&&
-               (p[j+0x08]==0x20)&&
-               ((*(unsigned int*)(p+j+0x10)==0x00690A8A)||
-                (*(unsigned int*)(p+j+0x16)==0x00690A8A))
+            if((ctx->p[ctx->j     ]==0x8d)&&
+               (ctx->p[ctx->j+0x03]==0xa2)&&
+               (ctx->p[ctx->j+0x04]==0x00)&&
+               (ctx->p[ctx->j+0x05]==0x20)&&
+               (ctx->p[ctx->j+0x08]==0x20)&&
+               ((*(unsigned int*)(ctx->p+ctx->j+0x10)==0x00690A8A)||
+                (*(unsigned int*)(ctx->p+ctx->j+0x16)==0x00690A8A))
               )
             {
-                initaddr=loadaddr+3;
-                playaddr=loadaddr+0;
-                strcpy(ids,"Burgstaller");strcat(ids," v3");
+                ctx->initaddr=ctx->loadaddr+3;
+                ctx->playaddr=ctx->loadaddr+0;
+                strcpy(ctx->ids,"Burgstaller");strcat(ctx->ids," v3");
                 return 1;
             }
-            if((p[j     ]==0x8d)&&
-               (*(unsigned int*)(p+j+0x05)==0xA2D4188D)&&
-               (p[j+0x09]==0x00)&&
-               (p[j+0x0a]==0x20)&&
-               (p[j+0x0d]==0x20)&&
-               (*(unsigned int*)(p+j+0x1b)==0x00690A8A)
+            if((ctx->p[ctx->j     ]==0x8d)&&
+               (*(unsigned int*)(ctx->p+ctx->j+0x05)==0xA2D4188D)&&
+               (ctx->p[ctx->j+0x09]==0x00)&&
+               (ctx->p[ctx->j+0x0a]==0x20)&&
+               (ctx->p[ctx->j+0x0d]==0x20)&&
+               (*(unsigned int*)(ctx->p+ctx->j+0x1b)==0x00690A8A)
               )
             {
-                initaddr=loadaddr+3;
-                playaddr=loadaddr+0;
-                strcpy(ids,"Burgstaller");strcat(ids," v4");
+                ctx->initaddr=ctx->loadaddr+3;
+                ctx->playaddr=ctx->loadaddr+0;
+                strcpy(ctx->ids,"Burgstaller");strcat(ctx->ids," v4");
                 return 1;
             }
         }
-        j=AdjustJ( p[3]|p[4]<<8,loadaddr);
-        if( !CheckJ(j,fsiz) )
+        ctx->j=AdjustJ( ctx->p[3]|ctx->p[4]<<8,ctx->loadaddr);
+        if( !CheckJ(ctx->j,ctx->fsiz) )
         {
         /* XTracker_V4.x 1003/1000 *******************************************/
-            if((p[j+0x00]==0xa0) &&
-               (p[j+0x01]==0x00) &&
-               (p[j+0x02]==0xf0) &&
-               (p[j+0x04]==0x60) )
-            {
-                initaddr=loadaddr+3;
-                playaddr=loadaddr+0;
-                sprintf(ids,"XTracker_V4.1%s/LoS","a");
+            if((ctx->p[ctx->j+0x00]==0xa0) &&
+               (ctx->p[ctx->j+0x01]==0x00) &&
+               (ctx->p[ctx->j+0x02]==0xf0) &&
+               (ctx->p[ctx->j+0x04]==0x60) )
+            {
+                ctx->initaddr=ctx->loadaddr+3;
+                ctx->playaddr=ctx->loadaddr+0;
+                sprintf(ctx->ids,"XTracker_V4.1%s/LoS","a");
                 return 1;
             }
-            if((p[j+0x00]==0xce) &&
-               (p[j+0x02]==(loadaddr>>8)) &&
-               (p[j+0x03]==0x10) )
+            if((ctx->p[ctx->j+0x00]==0xce) &&
+               (ctx->p[ctx->j+0x02]==(ctx->loadaddr>>8)) &&
+               (ctx->p[ctx->j+0x03]==0x10) )
             {
-                initaddr=loadaddr+3;
-                playaddr=loadaddr+0;
-                sprintf(ids,"XTracker_V4.1%s/LoS","b");
+                ctx->initaddr=ctx->loadaddr+3;
+                ctx->playaddr=ctx->loadaddr+0;
+                sprintf(ctx->ids,"XTracker_V4.1%s/LoS","b");
                 return 1;
             }
-            if((p[j+0x00]==0x2c) &&
-               (p[j+0x02]==(loadaddr>>8)) &&
-               (p[j+0x03]==0x30) &&
-               (*(unsigned int*)(p+j+5)==0xA2600170))
+            if((ctx->p[ctx->j+0x00]==0x2c) &&
+               (ctx->p[ctx->j+0x02]==(ctx->loadaddr>>8)) &&
+               (ctx->p[ctx->j+0x03]==0x30) &&
+               (*(unsigned int*)(ctx->p+ctx->j+5)==0xA2600170))
             {
-                initaddr=loadaddr+3;
-                playaddr=loadaddr+0;
-                strcpy(ids,"LordsOfSonics/MS");
+                ctx->initaddr=ctx->loadaddr+3;
+                ctx->playaddr=ctx->loadaddr+0;
+                strcpy(ctx->ids,"LordsOfSonics/MS");
                 return 1;
             }
         /* Guy Shavitt 1000/1006 *********************************************/
-            if((p[j+0x00]==0xa2) &&
-               (p[j+0x01]==0x00) &&
-               (p[0x08  ]==0xad) &&
-               (p[0x0b  ]==0x10))
-            {
-                initaddr=loadaddr+0;
-                playaddr=loadaddr+6;
-                strcpy(ids,"Guy Shavitt");
+            if((ctx->p[ctx->j+0x00]==0xa2) &&
+               (ctx->p[ctx->j+0x01]==0x00) &&
+               (ctx->p[0x08  ]==0xad) &&
+               (ctx->p[0x0b  ]==0x10))
+            {
+                ctx->initaddr=ctx->loadaddr+0;
+                ctx->playaddr=ctx->loadaddr+6;
+                strcpy(ctx->ids,"Guy Shavitt");
                 return 1;
             }
         /* Audial Arts: TAY+1000/1003 ****************************************/
-            if((*(unsigned int*)(p+j+0x00)==0x00A978A2) &&
-               (*(unsigned int*)(p+j+0x07)==0x20FA10CA) &&
-               (*(unsigned int*)(p+j+0x21)==0xA9F710CA) &&
-               (p[j+0x0d ]==0xb9) )
-            {
-                initaddr=loadaddr-1;
-                extrabytes[0]=initaddr&0xff;
-                extra=1;
-                p[0]=initaddr>>8;
-                p[1]=0xa8;
-                strcpy(ids,"Audial Arts");
+            if((*(unsigned int*)(ctx->p+ctx->j+0x00)==0x00A978A2) &&
+               (*(unsigned int*)(ctx->p+ctx->j+0x07)==0x20FA10CA) &&
+               (*(unsigned int*)(ctx->p+ctx->j+0x21)==0xA9F710CA) &&
+               (ctx->p[ctx->j+0x0d ]==0xb9) )
+            {
+                ctx->initaddr=ctx->loadaddr-1;
+                ctx->extrabytes[0]=ctx->initaddr&0xff;
+                ctx->extra=1;
+                ctx->p[0]=ctx->initaddr>>8;
+                ctx->p[1]=0xa8;
+                strcpy(ctx->ids,"Audial Arts");
                 return 1;
             }
         /* TFMX/MasterComposer 1003/1000 *************************************/
-            if((*(unsigned int*)(p+j-0x03)==0xAD60FA10) &&
-               (*(unsigned int*)(p+j+0x03)==0x0EAE12F0) &&
-               (*(unsigned int*)(p+j+0x0e)==0x8EE8FA10) )
+            if((*(unsigned int*)(ctx->p+ctx->j-0x03)==0xAD60FA10) &&
+               (*(unsigned int*)(ctx->p+ctx->j+0x03)==0x0EAE12F0) &&
+               (*(unsigned int*)(ctx->p+ctx->j+0x0e)==0x8EE8FA10) )
             {
-                initaddr=loadaddr+3;
-                playaddr=loadaddr+0;
-                strcpy(ids,"TFMX/MasterComposer");
+                ctx->initaddr=ctx->loadaddr+3;
+                ctx->playaddr=ctx->loadaddr+0;
+                strcpy(ctx->ids,"TFMX/MasterComposer");
                 return 1;
             }
         /* SIDduzzit 2.1: TAX+1000/1003 **************************************/
-            if((p[j+0x00]==0xbd) &&
-               (p[j+0x03]==0x8d) &&
-               (p[j+0x06]==0xa9) &&
-               (p[j+0x08]==0x8d) &&
-               ((p[j+0x18]==0x4a)||(p[j+0x18]==0xa9))
+            if((ctx->p[ctx->j+0x00]==0xbd) &&
+               (ctx->p[ctx->j+0x03]==0x8d) &&
+               (ctx->p[ctx->j+0x06]==0xa9) &&
+               (ctx->p[ctx->j+0x08]==0x8d) &&
+               ((ctx->p[ctx->j+0x18]==0x4a)||(ctx->p[ctx->j+0x18]==0xa9))
               )
             {
-                initaddr=loadaddr-1;
-                extrabytes[0]=initaddr&0xff;
-                extra=1;
-                p[0]=initaddr>>8;
-                p[1]=0xaa;
-                sprintf(ids,"SidDuzzIt %s","2.1");
+                ctx->initaddr=ctx->loadaddr-1;
+                ctx->extrabytes[0]=ctx->initaddr&0xff;
+                ctx->extra=1;
+                ctx->p[0]=ctx->initaddr>>8;
+                ctx->p[1]=0xaa;
+                sprintf(ctx->ids,"SidDuzzIt %s","2.1");
                 return 1;
             }
         }
         /* Laxity v3 1000/1006 ***********************************************/
-        if((p[8]==0x2c) &&
-           (*(unsigned int*)(p+0xb)==0xA9600130) )
+        if((ctx->p[8]==0x2c) &&
+           (*(unsigned int*)(ctx->p+0xb)==0xA9600130) )
         {
-            initaddr=loadaddr+0;
-            playaddr=loadaddr+6;
-            strcpy(ids,"Laxity");strcat(ids," v3");
+            ctx->initaddr=ctx->loadaddr+0;
+            ctx->playaddr=ctx->loadaddr+6;
+            strcpy(ctx->ids,"Laxity");strcat(ctx->ids," v3");
             return 1;
         }
         /***** SidFactory II/Laxity: $1000/$1006-1009 ************************/
-        if((p[0x08]==0xa9) &&
-           (p[0x09]==0x00) &&
-           (p[0x0a]==0x2c) &&
-           (p[0x11]==0xa2) &&
-           ( (*(unsigned int*)(p+0x0d) == 0x38704430) ||
-             (*(unsigned int*)(p+0x0d) == 0x3e704A30) ||
-             (*(unsigned int*)(p+0x0d) == 0x3a704630) ||
-             (*(unsigned int*)(p+0x0d) == 0x4A705630) ||
-             (*(unsigned int*)(p+0x0d) == 0x30703c30) )
+        if((ctx->p[0x08]==0xa9) &&
+           (ctx->p[0x09]==0x00) &&
+           (ctx->p[0x0a]==0x2c) &&
+           (ctx->p[0x11]==0xa2) &&
+           ( (*(unsigned int*)(ctx->p+0x0d) == 0x38704430) ||
+             (*(unsigned int*)(ctx->p+0x0d) == 0x3e704A30) ||
+             (*(unsigned int*)(ctx->p+0x0d) == 0x3a704630) ||
+             (*(unsigned int*)(ctx->p+0x0d) == 0x4A705630) ||
+             (*(unsigned int*)(ctx->p+0x0d) == 0x30703c30) )
           )
         {
-            initaddr=loadaddr+0;
-            playaddr=loadaddr+6;
-            strcpy(ids,"SidFactory");strcat(ids, " II");strcat(ids, " v1");
+            ctx->initaddr=ctx->loadaddr+0;
+            ctx->playaddr=ctx->loadaddr+6;
+            strcpy(ctx->ids,"SidFactory");strcat(ctx->ids, " II");strcat(ctx->ids, " v1");
             return 1;
         }
-        if((p[0x0b]==0xa9) &&
-           (p[0x0c]==0x00) &&
-           (p[0x0d]==0x2c) &&
-           (p[0x14]==0xa2) &&
-           ( (*(unsigned int*)(p+0x10) == 0x38704430) ||
-             (*(unsigned int*)(p+0x10) == 0x46705230) ||
-             (*(unsigned int*)(p+0x10) == 0x49705530) )
+        if((ctx->p[0x0b]==0xa9) &&
+           (ctx->p[0x0c]==0x00) &&
+           (ctx->p[0x0d]==0x2c) &&
+           (ctx->p[0x14]==0xa2) &&
+           ( (*(unsigned int*)(ctx->p+0x10) == 0x38704430) ||
+             (*(unsigned int*)(ctx->p+0x10) == 0x46705230) ||
+             (*(unsigned int*)(ctx->p+0x10) == 0x49705530) )
           )
         {
-            initaddr=loadaddr+0;
-            playaddr=loadaddr+9;
-            strcpy(ids,"SidFactory");strcat(ids, " II");strcat(ids, " v2");
+            ctx->initaddr=ctx->loadaddr+0;
+            ctx->playaddr=ctx->loadaddr+9;
+            strcpy(ctx->ids,"SidFactory");strcat(ctx->ids, " II");strcat(ctx->ids, " v2");
             return 1;
         }
-        if((p[0x08]==0xa9) &&
-           (p[0x09]==0x00) &&
-           (p[0x0a]==0x24) &&
-           ( (*(unsigned int*)(p+0x0c) == 0x1c702830) ||
-             (*(unsigned int*)(p+0x0c) == 0x1A702630) )
+        if((ctx->p[0x08]==0xa9) &&
+           (ctx->p[0x09]==0x00) &&
+           (ctx->p[0x0a]==0x24) &&
+           ( (*(unsigned int*)(ctx->p+0x0c) == 0x1c702830) ||
+             (*(unsigned int*)(ctx->p+0x0c) == 0x1A702630) )
           )
         {
-            initaddr=loadaddr+0;
-            playaddr=loadaddr+6;
-            strcpy(ids,"SidFactory");strcat(ids, " II");strcat(ids, " v3");
+            ctx->initaddr=ctx->loadaddr+0;
+            ctx->playaddr=ctx->loadaddr+6;
+            strcpy(ctx->ids,"SidFactory");strcat(ctx->ids, " II");strcat(ctx->ids, " v3");
             return 1;
         }
-        if((p[0x0b]==0xa9) &&
-           (p[0x0c]==0x00) &&
-           (p[0x0d]==0x8d) &&
-           (p[0x10]==0x2c) &&
-           (p[0x17]==0xa2) &&
-           (*(unsigned int*)(p+0x13) == 0x38704430)
+        if((ctx->p[0x0b]==0xa9) &&
+           (ctx->p[0x0c]==0x00) &&
+           (ctx->p[0x0d]==0x8d) &&
+           (ctx->p[0x10]==0x2c) &&
+           (ctx->p[0x17]==0xa2) &&
+           (*(unsigned int*)(ctx->p+0x13) == 0x38704430)
           )
         {
-            initaddr=loadaddr+0;
-            playaddr=loadaddr+9;
-            strcpy(ids,"SidFactory");strcat(ids, " II");strcat(ids, " v4");
+            ctx->initaddr=ctx->loadaddr+0;
+            ctx->playaddr=ctx->loadaddr+9;
+            strcpy(ctx->ids,"SidFactory");strcat(ctx->ids, " II");strcat(ctx->ids, " v4");
             return 1;
         }
     }
     return 0;
 }
 /***** Laxity v2 1000/1006 ***************************************************/
-int Chk_LaxityV2(void)
+int Chk_LaxityV2(P2S *ctx)
 {
-    if(fsiz<0x200) return 0;
-    for(k=0;k<=0x100;k+=0x100)
+    if(ctx->fsiz<0x200) return 0;
+    for(ctx->k=0;ctx->k<=0x100;ctx->k+=0x100)
     {
-        if((p[2+k]==0x4c) &&
-           (p[5+k]==0x4c) &&
-           (*(unsigned int*)(p+0xa+k)==0x2CD4188D) )
+        if((ctx->p[2+ctx->k]==0x4c) &&
+           (ctx->p[5+ctx->k]==0x4c) &&
+           (*(unsigned int*)(ctx->p+0xa+ctx->k)==0x2CD4188D) )
         {
-            initaddr=loadaddr+0+k;
-            playaddr=loadaddr+6+k;
-            strcpy(ids,"Laxity");strcat(ids," v2");
+            ctx->initaddr=ctx->loadaddr+0+ctx->k;
+            ctx->playaddr=ctx->loadaddr+6+ctx->k;
+            strcpy(ctx->ids,"Laxity");strcat(ctx->ids," v2");
             return 1;
         }
     }
     return 0;
 }
 /***** Rob Hubbard 1000/1012 *************************************************/
-int Chk_HubbardV2(void)
-{
-    if(fsiz<0x200) return 0;
-    i=0;
-    if((p[0x02]==0x4c) &&
-       (p[0x05]==0x4c) &&
-       (p[0x08]==0x4c) &&
-       (p[0x0b]==0x4c) &&
-       (p[0x0e]==0x4c) &&
-       (p[0x11]==0x4c) )
-    {
-        for(j=0x14;j<0x30;j++)
-        {
-            if((p[0+j]==0x2c) &&
-               (p[3+j]==0x30) &&
-               (p[5+j]==0x50))
-            {
-                initaddr=loadaddr+0;
-                playaddr=loadaddr+0x12;
-                strcpy(ids,"Hubbard");strcat(ids," v2");
-                i=1;
+int Chk_HubbardV2(P2S *ctx)
+{
+    if(ctx->fsiz<0x200) return 0;
+    ctx->i=0;
+    if((ctx->p[0x02]==0x4c) &&
+       (ctx->p[0x05]==0x4c) &&
+       (ctx->p[0x08]==0x4c) &&
+       (ctx->p[0x0b]==0x4c) &&
+       (ctx->p[0x0e]==0x4c) &&
+       (ctx->p[0x11]==0x4c) )
+    {
+        for(ctx->j=0x14;ctx->j<0x30;ctx->j++)
+        {
+            if((ctx->p[0+ctx->j]==0x2c) &&
+               (ctx->p[3+ctx->j]==0x30) &&
+               (ctx->p[5+ctx->j]==0x50))
+            {
+                ctx->initaddr=ctx->loadaddr+0;
+                ctx->playaddr=ctx->loadaddr+0x12;
+                strcpy(ctx->ids,"Hubbard");strcat(ctx->ids," v2");
+                ctx->i=1;
                 break;
             }
         }
     }
-    return i;
+    return ctx->i;
 }
 /***** Rob Hubbard 1000/1006 *************************************************/
-int Chk_HubbardV1(void)
+int Chk_HubbardV1(P2S *ctx)
 {
-    if(fsiz<0x200) return 0;
-    i=0;
-    for(k=0;k<=0x100;k++)
+    if(ctx->fsiz<0x200) return 0;
+    ctx->i=0;
+    for(ctx->k=0;ctx->k<=0x100;ctx->k++)
     {
-        if((p[0x02+k]==0x4c) &&
-           (p[0x05+k]==0x4c) )
+        if((ctx->p[0x02+ctx->k]==0x4c) &&
+           (ctx->p[0x05+ctx->k]==0x4c) )
         {
-            for(j=k+8;j<k+0x20;j++)
+            for(ctx->j=ctx->k+8;ctx->j<ctx->k+0x20;ctx->j++)
             {
-                if(p[0+j]==0x60)
+                if(ctx->p[0+ctx->j]==0x60)
                     break;
-                if((p[0+j]==0x2c) &&
-                   (p[3+j]==0x30) &&
-                   (p[5+j]==0x50))
+                if((ctx->p[0+ctx->j]==0x2c) &&
+                   (ctx->p[3+ctx->j]==0x30) &&
+                   (ctx->p[5+ctx->j]==0x50))
                 {
-                    initaddr=loadaddr+0+k;
-                    playaddr=loadaddr+6+k;
-                    strcpy(ids,"Hubbard");strcat(ids," v1");
-                    i=1;
+                    ctx->initaddr=ctx->loadaddr+0+ctx->k;
+                    ctx->playaddr=ctx->loadaddr+6+ctx->k;
+                    strcpy(ctx->ids,"Hubbard");strcat(ctx->ids," v1");
+                    ctx->i=1;
                     break;
                 }
             }
         }
     }
-    return i;
+    return ctx->i;
 }
 /***** Rob Hubbard 155f/103f (ACE_II hacks) **********************************/
-int Chk_HubbardV3(void)
-{
-    if(fsiz<0x600) return 0;
-    if((p[0x41]==0xa9) &&
-       (p[0x46]==0x2c) &&
-       (p[0x561]==0xa9) &&
-       (p[0x562]==0x40) &&
-       (p[0x566]==0x60) &&
-       (*(unsigned int*)(p+0x49)==0x40502A30)&&
-       (*(unsigned int*)(p+0x55)==0x9DD40499))
-    {
-        initaddr=loadaddr+0x55f;
-        playaddr=loadaddr+0x3f;
-        strcpy(ids,"Hubbard");strcat(ids," v3");
+int Chk_HubbardV3(P2S *ctx)
+{
+    if(ctx->fsiz<0x600) return 0;
+    if((ctx->p[0x41]==0xa9) &&
+       (ctx->p[0x46]==0x2c) &&
+       (ctx->p[0x561]==0xa9) &&
+       (ctx->p[0x562]==0x40) &&
+       (ctx->p[0x566]==0x60) &&
+       (*(unsigned int*)(ctx->p+0x49)==0x40502A30)&&
+       (*(unsigned int*)(ctx->p+0x55)==0x9DD40499))
+    {
+        ctx->initaddr=ctx->loadaddr+0x55f;
+        ctx->playaddr=ctx->loadaddr+0x3f;
+        strcpy(ctx->ids,"Hubbard");strcat(ctx->ids," v3");
         return 1;
     }
     return 0;
 }
 /***** Rob Hubbard 1xxx/1xxx (simpler version of v5) *************************/
-int Chk_HubbardV4(void)
-{
-    if(fsiz<0x700) return 0;
-    i=0;
-    for(k=0;k<=0x100;k++)
-    {
-        if((p[0x00 + k]==0xa2) &&
-           (p[0x01 + k]==0x02) &&
-           (p[0x02 + k]==0xce) &&
-           (p[0x05 + k]==0x10) &&
-           (p[0x06 + k]==0x06) &&
-           (p[0x07 + k]==0xad) &&
-           (p[0x2b + k]==0x30) &&
-           (p[0x2d + k]==0x4c) &&
-           (p[0x30 + k]==0x4c) )
-        {
-            i=k;
+int Chk_HubbardV4(P2S *ctx)
+{
+    if(ctx->fsiz<0x700) return 0;
+    ctx->i=0;
+    for(ctx->k=0;ctx->k<=0x100;ctx->k++)
+    {
+        if((ctx->p[0x00 + ctx->k]==0xa2) &&
+           (ctx->p[0x01 + ctx->k]==0x02) &&
+           (ctx->p[0x02 + ctx->k]==0xce) &&
+           (ctx->p[0x05 + ctx->k]==0x10) &&
+           (ctx->p[0x06 + ctx->k]==0x06) &&
+           (ctx->p[0x07 + ctx->k]==0xad) &&
+           (ctx->p[0x2b + ctx->k]==0x30) &&
+           (ctx->p[0x2d + ctx->k]==0x4c) &&
+           (ctx->p[0x30 + ctx->k]==0x4c) )
+        {
+            ctx->i=ctx->k;
             break;
         }
     }
-    if(i>0)
+    if(ctx->i>0)
     {
         // play addr
-        j=AdjustJ( p[k+3]|p[k+4]<<8,loadaddr);
-        if( !CheckJ(j,fsiz) )
+        ctx->j=AdjustJ( ctx->p[ctx->k+3]|ctx->p[ctx->k+4]<<8,ctx->loadaddr);
+        if( !CheckJ(ctx->j,ctx->fsiz) )
         {
-            j-=0xf0;
-            for(k=0;k<=0x100;k++)
+            ctx->j-=0xf0;
+            for(ctx->k=0;ctx->k<=0x100;ctx->k++)
             {
-                if((p[j+k+0x00]==0xad)&&
-                   (p[j+k+0x03]==0xd0)&&
-                   (((p[j+k+0x05]==0xee)&&(p[j+k+0x08]==0xee))||
-                    ((p[j+k+0x05]==0xe6)&&(p[j+k+0x07]==0xe6)))
+                if((ctx->p[ctx->j+ctx->k+0x00]==0xad)&&
+                   (ctx->p[ctx->j+ctx->k+0x03]==0xd0)&&
+                   (((ctx->p[ctx->j+ctx->k+0x05]==0xee)&&(ctx->p[ctx->j+ctx->k+0x08]==0xee))||
+                    ((ctx->p[ctx->j+ctx->k+0x05]==0xe6)&&(ctx->p[ctx->j+ctx->k+0x07]==0xe6)))
                     )
                 {
-                    playaddr=loadaddr+j+k-2;
+                    ctx->playaddr=ctx->loadaddr+ctx->j+ctx->k-2;
                     break;
                 }
             }
             // init
-            for(   ;k<=0x100;k++)
-            {
-                if((p[j+k+0x00]==0xaa)&&
-                   (p[j+k+0x01]==0xbd)&&
-                   (p[j+k+0x06]==0xbd)&&
-                   (p[j+k+0x04]==0x85)&&
-                   (p[j+k+0x09]==0x85)&&
-                   (p[j+k+0x18]==0xa2))
+            for(   ;ctx->k<=0x100;ctx->k++)
+            {
+                if((ctx->p[ctx->j+ctx->k+0x00]==0xaa)&&
+                   (ctx->p[ctx->j+ctx->k+0x01]==0xbd)&&
+                   (ctx->p[ctx->j+ctx->k+0x06]==0xbd)&&
+                   (ctx->p[ctx->j+ctx->k+0x04]==0x85)&&
+                   (ctx->p[ctx->j+ctx->k+0x09]==0x85)&&
+                   (ctx->p[ctx->j+ctx->k+0x18]==0xa2))
                 {
-                    initaddr=loadaddr+j+k-2;
+                    ctx->initaddr=ctx->loadaddr+ctx->j+ctx->k-2;
                     break;
                 }
             }
-            if(k==0x101)
+            if(ctx->k==0x101)
             {
-                initaddr=loadaddr;
-                playaddr=initaddr+3;
+                ctx->initaddr=ctx->loadaddr;
+                ctx->playaddr=ctx->initaddr+3;
                 return 0;
             }
             else
             {
-                if(i>=6)
+                if(ctx->i>=6)
                 {
-                    k=2;
-                    p[k++]=0x4c;
-                    p[k++]=initaddr&0xff;
-                    p[k++]=initaddr>>8;
-                    p[k++]=0x4c;
-                    p[k++]=playaddr&0xff;
-                    p[k++]=playaddr>>8;
-                    initaddr=loadaddr;
-                    playaddr=initaddr+3;
+                    ctx->k=2;
+                    ctx->p[ctx->k++]=0x4c;
+                    ctx->p[ctx->k++]=ctx->initaddr&0xff;
+                    ctx->p[ctx->k++]=ctx->initaddr>>8;
+                    ctx->p[ctx->k++]=0x4c;
+                    ctx->p[ctx->k++]=ctx->playaddr&0xff;
+                    ctx->p[ctx->k++]=ctx->playaddr>>8;
+                    ctx->initaddr=ctx->loadaddr;
+                    ctx->playaddr=ctx->initaddr+3;
                 }
-                strcpy(ids,"Hubbard");strcat(ids," v4");
+                strcpy(ctx->ids,"Hubbard");strcat(ctx->ids," v4");
                 return 1;
             }
         }
@@ -1786,83 +1938,83 @@ int Chk_HubbardV4(void)
     return 0;
 }
 /***** Rob Hubbard 1xxx/1xxx (FC probably based on this) *********************/
-int Chk_HubbardV5(void)
-{
-    if(fsiz<0x700) return 0;
-    i=0;
-    for(k=0;k<=0x100;k++)
-    {
-        if((p[0x00 + k]==0xa2) &&
-           (p[0x01 + k]==0x02) &&
-           (p[0x02 + k]==0xce) &&
-           (p[0x05 + k]==0x10) &&
-           (p[0x06 + k]==0x06) &&
-           (p[0x07 + k]==0xad) &&
-           (p[0x2e + k]==0x30) &&
-           (p[0x30 + k]==0x4c) &&
-           (p[0x33 + k]==0x4c) )
-        {
-            i=k;
+int Chk_HubbardV5(P2S *ctx)
+{
+    if(ctx->fsiz<0x700) return 0;
+    ctx->i=0;
+    for(ctx->k=0;ctx->k<=0x100;ctx->k++)
+    {
+        if((ctx->p[0x00 + ctx->k]==0xa2) &&
+           (ctx->p[0x01 + ctx->k]==0x02) &&
+           (ctx->p[0x02 + ctx->k]==0xce) &&
+           (ctx->p[0x05 + ctx->k]==0x10) &&
+           (ctx->p[0x06 + ctx->k]==0x06) &&
+           (ctx->p[0x07 + ctx->k]==0xad) &&
+           (ctx->p[0x2e + ctx->k]==0x30) &&
+           (ctx->p[0x30 + ctx->k]==0x4c) &&
+           (ctx->p[0x33 + ctx->k]==0x4c) )
+        {
+            ctx->i=ctx->k;
             break;
         }
     }
-    if(i>0)
+    if(ctx->i>0)
     {
         // play addr
-        j=AdjustJ( p[k+3]|p[k+4]<<8,loadaddr);
-        if( !CheckJ(j,fsiz) )
-        {
-            j-=0xf0;
-            for(k=0;k<=0x100;k++)
-            {
-                if((p[j+k+0x00]==0xad)&&
-                   (p[j+k+0x03]==0xc9)&&
-                   (p[j+k+0x07]==0xc9)&&
-                   (p[j+k+0x0b]==0xee)&&
-                   (p[j+k+0x0e]==0xee)&&
-                   (p[j+k+0x11]==0xee)
+        ctx->j=AdjustJ( ctx->p[ctx->k+3]|ctx->p[ctx->k+4]<<8,ctx->loadaddr);
+        if( !CheckJ(ctx->j,ctx->fsiz) )
+        {
+            ctx->j-=0xf0;
+            for(ctx->k=0;ctx->k<=0x100;ctx->k++)
+            {
+                if((ctx->p[ctx->j+ctx->k+0x00]==0xad)&&
+                   (ctx->p[ctx->j+ctx->k+0x03]==0xc9)&&
+                   (ctx->p[ctx->j+ctx->k+0x07]==0xc9)&&
+                   (ctx->p[ctx->j+ctx->k+0x0b]==0xee)&&
+                   (ctx->p[ctx->j+ctx->k+0x0e]==0xee)&&
+                   (ctx->p[ctx->j+ctx->k+0x11]==0xee)
                     )
                 {
-                    playaddr=loadaddr+j+k-2;
+                    ctx->playaddr=ctx->loadaddr+ctx->j+ctx->k-2;
                     break;
                 }
             }
             // init
-            for(   ;k<=0x100;k++)
-            {
-                if((p[j+k+0x00]==0x48)&&
-                   (p[j+k+0x01]==0xa9)&&
-                   (p[j+k+0x02]==0x01)&&
-                   (p[j+k+0x03]==0x8d)&&
-                   (p[j+k+0x07]==0xaa)&&
-                   (p[j+k+0x0b]==0x85)&&
-                   (p[j+k+0x1f]==0xa2))
+            for(   ;ctx->k<=0x100;ctx->k++)
+            {
+                if((ctx->p[ctx->j+ctx->k+0x00]==0x48)&&
+                   (ctx->p[ctx->j+ctx->k+0x01]==0xa9)&&
+                   (ctx->p[ctx->j+ctx->k+0x02]==0x01)&&
+                   (ctx->p[ctx->j+ctx->k+0x03]==0x8d)&&
+                   (ctx->p[ctx->j+ctx->k+0x07]==0xaa)&&
+                   (ctx->p[ctx->j+ctx->k+0x0b]==0x85)&&
+                   (ctx->p[ctx->j+ctx->k+0x1f]==0xa2))
                 {
-                    initaddr=loadaddr+j+k-2;
+                    ctx->initaddr=ctx->loadaddr+ctx->j+ctx->k-2;
                     break;
                 }
             }
-            if(k==0x101)
+            if(ctx->k==0x101)
             {
-                initaddr=loadaddr;
-                playaddr=initaddr+3;
+                ctx->initaddr=ctx->loadaddr;
+                ctx->playaddr=ctx->initaddr+3;
                 return 0;
             }
             else
             {
-                if(i>=6)
+                if(ctx->i>=6)
                 {
-                    k=2;
-                    p[k++]=0x4c;
-                    p[k++]=initaddr&0xff;
-                    p[k++]=initaddr>>8;
-                    p[k++]=0x4c;
-                    p[k++]=playaddr&0xff;
-                    p[k++]=playaddr>>8;
-                    initaddr=loadaddr;
-                    playaddr=initaddr+3;
+                    ctx->k=2;
+                    ctx->p[ctx->k++]=0x4c;
+                    ctx->p[ctx->k++]=ctx->initaddr&0xff;
+                    ctx->p[ctx->k++]=ctx->initaddr>>8;
+                    ctx->p[ctx->k++]=0x4c;
+                    ctx->p[ctx->k++]=ctx->playaddr&0xff;
+                    ctx->p[ctx->k++]=ctx->playaddr>>8;
+                    ctx->initaddr=ctx->loadaddr;
+                    ctx->playaddr=ctx->initaddr+3;
                 }
-                strcpy(ids,"Hubbard");strcat(ids," v5");
+                strcpy(ctx->ids,"Hubbard");strcat(ctx->ids," v5");
                 return 1;
             }
         }
@@ -1870,54 +2022,54 @@ int Chk_HubbardV5(void)
     return 0;
 }
 /***** Mike/LSD 1006/1003 ****************************************************/
-int Chk_MikeLSD(void)
-{
-    if(fsiz<0x200) return 0;
-    if((p[0x02]==0x4c) &&
-       (p[0x05]==0x4c) &&
-       (p[0x08]==0x4c) &&
-       (p[0x0b]==0x4c) &&
-       (p[0x0e]==0x4c) &&
-       (*(unsigned int*)(p+0x15)==0xA90001C9)&&
-       (*(unsigned int*)(p+0x61)==0x07E93898))
-    {
-        initaddr=loadaddr+6;
-        playaddr=loadaddr+3;
-        strcpy(ids,"Mike/LSD");strcat(ids," v1");
+int Chk_MikeLSD(P2S *ctx)
+{
+    if(ctx->fsiz<0x200) return 0;
+    if((ctx->p[0x02]==0x4c) &&
+       (ctx->p[0x05]==0x4c) &&
+       (ctx->p[0x08]==0x4c) &&
+       (ctx->p[0x0b]==0x4c) &&
+       (ctx->p[0x0e]==0x4c) &&
+       (*(unsigned int*)(ctx->p+0x15)==0xA90001C9)&&
+       (*(unsigned int*)(ctx->p+0x61)==0x07E93898))
+    {
+        ctx->initaddr=ctx->loadaddr+6;
+        ctx->playaddr=ctx->loadaddr+3;
+        strcpy(ctx->ids,"Mike/LSD");strcat(ctx->ids," v1");
         return 1;
     }
-    if((p[0x02]==0x4c) &&
-       (p[0x05]==0x4c) &&
-       (p[0x08]==0xa9) &&
-       (p[0x0b]==0x4c) &&
-       (p[0x11]==0x4c) &&
-       (*(unsigned int*)(p+0x14)==0xA96080A9)&&
-       (*(unsigned int*)(p+0xfe)==0x07E9388A))
-    {
-        initaddr=loadaddr+6;
-        playaddr=loadaddr+3;
-        strcpy(ids,"Mike/LSD");strcat(ids," v2");
+    if((ctx->p[0x02]==0x4c) &&
+       (ctx->p[0x05]==0x4c) &&
+       (ctx->p[0x08]==0xa9) &&
+       (ctx->p[0x0b]==0x4c) &&
+       (ctx->p[0x11]==0x4c) &&
+       (*(unsigned int*)(ctx->p+0x14)==0xA96080A9)&&
+       (*(unsigned int*)(ctx->p+0xfe)==0x07E9388A))
+    {
+        ctx->initaddr=ctx->loadaddr+6;
+        ctx->playaddr=ctx->loadaddr+3;
+        strcpy(ctx->ids,"Mike/LSD");strcat(ctx->ids," v2");
         return 1;
     }
     return 0;
 }
 /***** Comptech 1003/1000 ****************************************************/
-int Chk_Comptech(void)
+int Chk_Comptech(P2S *ctx)
 {
-    if(fsiz<0x200) return 0;
-    if((p[2]==0x4c) &&
-       (p[5]==0x8d) &&
-       (p[8]==0x60) )
+    if(ctx->fsiz<0x200) return 0;
+    if((ctx->p[2]==0x4c) &&
+       (ctx->p[5]==0x8d) &&
+       (ctx->p[8]==0x60) )
     {
-        j=AdjustJ(p[3]|p[4]<<8,loadaddr);
-        if( !CheckJ(j,fsiz) )
+        ctx->j=AdjustJ(ctx->p[3]|ctx->p[4]<<8,ctx->loadaddr);
+        if( !CheckJ(ctx->j,ctx->fsiz) )
         {
-            if((p[j]==0xad) &&
-               (*(unsigned int*)(p+j+0x3)==0xF6F0FFC9))
+            if((ctx->p[ctx->j]==0xad) &&
+               (*(unsigned int*)(ctx->p+ctx->j+0x3)==0xF6F0FFC9))
             {
-                initaddr=loadaddr+3;
-                playaddr=loadaddr+0;
-                strcpy(ids,"Comptech 2.x/LoS");
+                ctx->initaddr=ctx->loadaddr+3;
+                ctx->playaddr=ctx->loadaddr+0;
+                strcpy(ctx->ids,"Comptech 2.x/LoS");
                 return 1;
             }
         }
@@ -1925,24 +2077,24 @@ int Chk_Comptech(void)
     return 0;
 }
 /***** SoundMaker v3 & 5_Dimension 1000/1006 *********************************/
-int Chk_SoundMaker(void)
+int Chk_SoundMaker(P2S *ctx)
 {
-    if(fsiz<0x200) return 0;
-    if((p[2]==0x4c) &&
-       (p[5]!=0x4c) &&
-       (p[8]==0x4c) )
+    if(ctx->fsiz<0x200) return 0;
+    if((ctx->p[2]==0x4c) &&
+       (ctx->p[5]!=0x4c) &&
+       (ctx->p[8]==0x4c) )
     {
-        j=AdjustJ(p[3]|p[4]<<8,loadaddr);
-        if( !CheckJ(j,fsiz) )
+        ctx->j=AdjustJ(ctx->p[3]|ctx->p[4]<<8,ctx->loadaddr);
+        if( !CheckJ(ctx->j,ctx->fsiz) )
         {
-            if((p[j  ]==0xaa) &&
-               (p[j+1]==0xbd) &&
-               (p[j+4]==0x8d) &&
-               (p[j+7]==0x8a) )
+            if((ctx->p[ctx->j  ]==0xaa) &&
+               (ctx->p[ctx->j+1]==0xbd) &&
+               (ctx->p[ctx->j+4]==0x8d) &&
+               (ctx->p[ctx->j+7]==0x8a) )
             {
-                initaddr=loadaddr+0;
-                playaddr=loadaddr+6;
-                strcpy(ids,"SoundMaker");strcat(ids," v3/UA");
+                ctx->initaddr=ctx->loadaddr+0;
+                ctx->playaddr=ctx->loadaddr+6;
+                strcpy(ctx->ids,"SoundMaker");strcat(ctx->ids," v3/UA");
                 return 1;
             }
         }
@@ -1950,1084 +2102,1097 @@ int Chk_SoundMaker(void)
     return 0;
 }
 /***** Electrosound **********************************************************/
-int Chk_Electrosound(void)
-{
-    if(fsiz<0xc00) return 0;
-    if((*(unsigned int*)(p+0x02 )==0x05D0B0C9) &&
-       (*(unsigned int*)(p+0x06 )==0x154C30A9) &&
-       (*(unsigned int*)(p+0x18a)==0x0a0a0a0a))
-    {
-        memset(p+0xa8a,0,0x278);
-        p[0xa64]=0x60;
-        p[0xa7d]=0x60;
-        p[0xa86]=0x60;
-        k=0xb02;
-        memmove(p+k,aPatchElcSnd,sizeof(aPatchElcSnd));
-        p[0xb05]=(loadaddr>>8)+5;
-        p[0xb0d]=(loadaddr>>8)+0xb;
-        initaddr=loadaddr+0xb00;
-        playaddr=loadaddr+0xa65;
-        psidh[P_TIMING  ]=1; // CIA timing
-        strcpy(ids,"Electrosound");
+int Chk_Electrosound(P2S *ctx)
+{
+    if(ctx->fsiz<0xc00) return 0;
+    if((*(unsigned int*)(ctx->p+0x02 )==0x05D0B0C9) &&
+       (*(unsigned int*)(ctx->p+0x06 )==0x154C30A9) &&
+       (*(unsigned int*)(ctx->p+0x18a)==0x0a0a0a0a))
+    {
+        memset(ctx->p+0xa8a,0,0x278);
+        ctx->p[0xa64]=0x60;
+        ctx->p[0xa7d]=0x60;
+        ctx->p[0xa86]=0x60;
+        ctx->k=0xb02;
+        memmove(ctx->p+ctx->k,aPatchElcSnd,sizeof(aPatchElcSnd));
+        ctx->p[0xb05]=(ctx->loadaddr>>8)+5;
+        ctx->p[0xb0d]=(ctx->loadaddr>>8)+0xb;
+        ctx->initaddr=ctx->loadaddr+0xb00;
+        ctx->playaddr=ctx->loadaddr+0xa65;
+        ctx->psidh[P_TIMING  ]=1; // CIA timing
+        strcpy(ctx->ids,"Electrosound");
         return 1;
     }
     return 0;
 }
 /***** PollyTracker **********************************************************/
-int Chk_PollyTracker(void)
-{
-    if(fsiz<0x400) return 0;
-    if((loadaddr>=0x0800) &&
-       (loadaddr<=0x080d) &&
-       (*(unsigned int*)(p-loadaddr+2+0x819)==0x8D02A6AD) &&
-       (*(unsigned int*)(p-loadaddr+2+0x81d)==0x38A9080C) &&
-       (*(unsigned int*)(p-loadaddr+2+0x89f)==0x4a4a4a4a))
-    {
-        psidh[P_MARKER  ]='R';
-        initaddr=0x80d;
-        playaddr=0;
-        psidh[P_FREEPAGE]=4;
-        psidh[P_FREEPMAX]=4;
-        k=0x80e - loadaddr+2;
-        memmove(p+k,aPatchPolly1,sizeof(aPatchPolly1));
-        k=0x873 - loadaddr+2;
-        memmove(p+k,aPatchPolly2,sizeof(aPatchPolly2));
-        k=0x8b7 - loadaddr+2;
-        p[k++]=0xa9;
-        k=0x8c8 - loadaddr+2;
-        memset(p+k,0xea,3);
-        k=0x9a4 - loadaddr+2;
-        memset(p+k,0xea,3);
-        strcpy(ids,"PollyTracker");
+int Chk_PollyTracker(P2S *ctx)
+{
+    if(ctx->fsiz<0x400) return 0;
+    if((ctx->loadaddr>=0x0800) &&
+       (ctx->loadaddr<=0x080d) &&
+       (*(unsigned int*)(ctx->p-ctx->loadaddr+2+0x819)==0x8D02A6AD) &&
+       (*(unsigned int*)(ctx->p-ctx->loadaddr+2+0x81d)==0x38A9080C) &&
+       (*(unsigned int*)(ctx->p-ctx->loadaddr+2+0x89f)==0x4a4a4a4a))
+    {
+        ctx->psidh[P_MARKER  ]='R';
+        ctx->initaddr=0x80d;
+        ctx->playaddr=0;
+        ctx->psidh[P_FREEPAGE]=4;
+        ctx->psidh[P_FREEPMAX]=4;
+        ctx->k=0x80e - ctx->loadaddr+2;
+        memmove(ctx->p+ctx->k,aPatchPolly1,sizeof(aPatchPolly1));
+        ctx->k=0x873 - ctx->loadaddr+2;
+        memmove(ctx->p+ctx->k,aPatchPolly2,sizeof(aPatchPolly2));
+        ctx->k=0x8b7 - ctx->loadaddr+2;
+        ctx->p[ctx->k++]=0xa9;
+        ctx->k=0x8c8 - ctx->loadaddr+2;
+        memset(ctx->p+ctx->k,0xea,3);
+        ctx->k=0x9a4 - ctx->loadaddr+2;
+        memset(ctx->p+ctx->k,0xea,3);
+        strcpy(ctx->ids,"PollyTracker");
         return 1;
     }
     return 0;
 }
 /***** Polyanna **************************************************************/
-int Chk_Polyanna(void)
-{
-    if(fsiz<0x1000) return 0;
-    if((loadaddr>=0x0800) &&
-       (loadaddr<=0x080d) &&
-       (*(unsigned int*)(p-loadaddr+2+0x80d)==0xFFA2D878) &&
-       (*(unsigned int*)(p-loadaddr+2+0x81b)==0xD02005AD) &&
-       (*(unsigned int*)(p-loadaddr+2+0x100c)==0xA9FFFB8D))
-    {
-        psidh[P_MARKER  ]='R';
-        initaddr=0x154d;
-        playaddr=0;
-        k=initaddr - loadaddr+2;
-        memmove(p+k,aPatchPolyAn,sizeof(aPatchPolyAn));
-        strcpy(ids,"Polyanna");
+int Chk_Polyanna(P2S *ctx)
+{
+    if(ctx->fsiz<0x1000) return 0;
+    if((ctx->loadaddr>=0x0800) &&
+       (ctx->loadaddr<=0x080d) &&
+       (*(unsigned int*)(ctx->p-ctx->loadaddr+2+0x80d)==0xFFA2D878) &&
+       (*(unsigned int*)(ctx->p-ctx->loadaddr+2+0x81b)==0xD02005AD) &&
+       (*(unsigned int*)(ctx->p-ctx->loadaddr+2+0x100c)==0xA9FFFB8D))
+    {
+        ctx->psidh[P_MARKER  ]='R';
+        ctx->initaddr=0x154d;
+        ctx->playaddr=0;
+        ctx->k=ctx->initaddr - ctx->loadaddr+2;
+        memmove(ctx->p+ctx->k,aPatchPolyAn,sizeof(aPatchPolyAn));
+        strcpy(ctx->ids,"Polyanna");
         return 1;
     }
     return 0;
 }
 /***** Master Composer *******************************************************/
-int Chk_MasterComp(void)
+int Chk_MasterComp(P2S *ctx)
 {
-    if(fsiz<0x400) return 0;
-    j = -1;
-    for(k=0;k<fsiz-0x300;k++)
-    {
-        if((*(unsigned int*)(p+k+0x02)==0x29D404AD) &&
-           (*(unsigned int*)(p+k+0x06)==0xD4048DFE) &&
-           (*(unsigned int*)(p+k+0x12)==0x29D412AD) &&
-           ((*(unsigned int*)(p+k+0x16)&0xff00ffff)==0xD4008DFE) &&
-           (*(unsigned short int*)(p+k+0x9c)==(unsigned short int)(k+loadaddr))) /* JMP to k */
+    int x;
+    if(ctx->fsiz<0x400) return 0;
+    ctx->j = -1;
+    for(x=0;x<ctx->signum[SIG_MASTERCOMP];x++)
+    {
+        ctx->k=ctx->sigcand[SIG_MASTERCOMP][x];
+        if(ctx->k>=ctx->fsiz-0x300) break;
+        if((*(unsigned int*)(ctx->p+ctx->k+0x02)==0x29D404AD) &&
+           (*(unsigned int*)(ctx->p+ctx->k+0x06)==0xD4048DFE) &&
+           (*(unsigned int*)(ctx->p+ctx->k+0x12)==0x29D412AD) &&
+           ((*(unsigned int*)(ctx->p+ctx->k+0x16)&0xff00ffff)==0xD4008DFE) &&
+           (*(unsigned short int*)(ctx->p+ctx->k+0x9c)==(unsigned short int)(ctx->k+ctx->loadaddr))) /* JMP to k */
         {
-            j=k;
+            ctx->j=ctx->k;
             break;
         }
     }
-    if(j != -1)
-    {
-        p+=j;
-        fsiz-=j;
-        loadaddr+=j;
-        initaddr=(loadaddr - 0x0d);
-        playaddr=(loadaddr - 0x06);
-        extrabytes[0]=initaddr&0xff;
-        extrabytes[1]=initaddr>>8;
-        memmove(extrabytes+2,aPatchMastCm,sizeof(aPatchMastCm));
-        extrabytes[5]=(loadaddr - 0x05)&0xff;
-        extrabytes[6]=(loadaddr - 0x05)>>8;
-        p[0]=0x60;
-        p[1]=0x00;
-        extra=13;
-        j=0;
-        psidh[P_TIMING  ]=1; // CIA timing
+    if(ctx->j != -1)
+    {
+        ctx->p+=ctx->j;
+        ctx->fsiz-=ctx->j;
+        ctx->loadaddr+=ctx->j;
+        ctx->initaddr=(ctx->loadaddr - 0x0d);
+        ctx->playaddr=(ctx->loadaddr - 0x06);
+        ctx->extrabytes[0]=ctx->initaddr&0xff;
+        ctx->extrabytes[1]=ctx->initaddr>>8;
+        memmove(ctx->extrabytes+2,aPatchMastCm,sizeof(aPatchMastCm));
+        ctx->extrabytes[5]=(ctx->loadaddr - 0x05)&0xff;
+        ctx->extrabytes[6]=(ctx->loadaddr - 0x05)>>8;
+        ctx->p[0]=0x60;
+        ctx->p[1]=0x00;
+        ctx->extra=13;
+        ctx->j=0;
+        ctx->psidh[P_TIMING  ]=1; // CIA timing
         // fix by Professor Chaos, should write to $d412 not $d404, it will
         // silence end of tunes correctly
-        k=j+0x18;
-        if (p[k]==0x04)
-           p[k]=0x12;
-        k=j+0x1a;
-        memset(p+k,0x60,3);
-        k=j+0x36;
-        memset(p+k,0x60,3);
-        k=j+0x85;
-        p[k]=0xea;
-        k=j+0x90;
-        memset(p+k,0xea,0x0b);
-        p[k++]=0xa9;
-        p[k++]=0x00;
-        p[k++]=0x8d;
-        p[k++]=(loadaddr - 0x05)&0xff;
-        p[k++]=(loadaddr - 0x05)>>8;
-        k=j+0x24c;
-        memset(p+k,0x60,3);
-        k=j+0x25a;
-        p[k++]=0xea;
-        p[k++]=0x4c;
-        p[k++]=(loadaddr+0x26b)&0xff;
-        p[k++]=(loadaddr+0x26b)>>8;
-        k=j+0x265;
-        p[k]=0xea;
-        k=j+0x289;
-        memset(p+k,0xea,0x0c);
-        strcpy(ids,"Master Composer");
+        ctx->k=ctx->j+0x18;
+        if (ctx->p[ctx->k]==0x04)
+           ctx->p[ctx->k]=0x12;
+        ctx->k=ctx->j+0x1a;
+        memset(ctx->p+ctx->k,0x60,3);
+        ctx->k=ctx->j+0x36;
+        memset(ctx->p+ctx->k,0x60,3);
+        ctx->k=ctx->j+0x85;
+        ctx->p[ctx->k]=0xea;
+        ctx->k=ctx->j+0x90;
+        memset(ctx->p+ctx->k,0xea,0x0b);
+        ctx->p[ctx->k++]=0xa9;
+        ctx->p[ctx->k++]=0x00;
+        ctx->p[ctx->k++]=0x8d;
+        ctx->p[ctx->k++]=(ctx->loadaddr - 0x05)&0xff;
+        ctx->p[ctx->k++]=(ctx->loadaddr - 0x05)>>8;
+        ctx->k=ctx->j+0x24c;
+        memset(ctx->p+ctx->k,0x60,3);
+        ctx->k=ctx->j+0x25a;
+        ctx->p[ctx->k++]=0xea;
+        ctx->p[ctx->k++]=0x4c;
+        ctx->p[ctx->k++]=(ctx->loadaddr+0x26b)&0xff;
+        ctx->p[ctx->k++]=(ctx->loadaddr+0x26b)>>8;
+        ctx->k=ctx->j+0x265;
+        ctx->p[ctx->k]=0xea;
+        ctx->k=ctx->j+0x289;
+        memset(ctx->p+ctx->k,0xea,0x0c);
+        strcpy(ctx->ids,"Master Composer");
         return 1;
     }
     return 0;
 }
 /***** Ubik's music **********************************************************/
-int Chk_Ubik(void)
+int Chk_Ubik(P2S *ctx)
 {
-    if(fsiz<0x400) return 0;
-    j = -1;
-    for(k=0x68;k<fsiz-0x300;k++)
-    {
-        if((p[k]==0xad) &&
-           (*(unsigned int*)(p+k+0x03)==0x22D00330) &&
-           (*(unsigned int*)(p+k+0x07)==0x7F291860) &&
-           (*(unsigned int*)(p+k+0x30)==0xA8306918))
+    int x;
+    if(ctx->fsiz<0x400) return 0;
+    ctx->j = -1;
+    for(x=0;x<ctx->signum[SIG_UBIK];x++)
+    {
+        ctx->k=ctx->sigcand[SIG_UBIK][x];
+        if(ctx->k<0x68) continue;
+        if(ctx->k>=ctx->fsiz-0x300) break;
+        if((ctx->p[ctx->k]==0xad) &&
+           (*(unsigned int*)(ctx->p+ctx->k+0x03)==0x22D00330) &&
+           (*(unsigned int*)(ctx->p+ctx->k+0x07)==0x7F291860) &&
+           (*(unsigned int*)(ctx->p+ctx->k+0x30)==0xA8306918))
         {
-            j=k;
+            ctx->j=ctx->k;
             break;
         }
     }
-    if(j != -1)
-    {
-        k=j-0x66;
-        initaddr=k+loadaddr-2;
-        playaddr=initaddr+3;
-        memset(p+k,0,0x66);
-        memmove(p+k,aPatchUbiksM,sizeof(aPatchUbiksM));
-        k++;
-        p[k++]=(playaddr+3)&0xff;
-        p[k++]=(playaddr+3)>>8;
-        k++;
-        p[k++]=(playaddr+22)&0xff;
-        p[k++]=(playaddr+22)>>8;
-        k+=4;
-        p[k++]=p[j+1];
-        p[k++]=p[j+2];
-        k+=21;
-        p[k++]=(j+loadaddr-2)&0xff;
-        p[k++]=(j+loadaddr-2)>>8;
-        psidh[P_SUBTUNES]=9; // there can be subtunes
-        strcpy(ids,"Ubik's Music");
+    if(ctx->j != -1)
+    {
+        ctx->k=ctx->j-0x66;
+        ctx->initaddr=ctx->k+ctx->loadaddr-2;
+        ctx->playaddr=ctx->initaddr+3;
+        memset(ctx->p+ctx->k,0,0x66);
+        memmove(ctx->p+ctx->k,aPatchUbiksM,sizeof(aPatchUbiksM));
+        ctx->k++;
+        ctx->p[ctx->k++]=(ctx->playaddr+3)&0xff;
+        ctx->p[ctx->k++]=(ctx->playaddr+3)>>8;
+        ctx->k++;
+        ctx->p[ctx->k++]=(ctx->playaddr+22)&0xff;
+        ctx->p[ctx->k++]=(ctx->playaddr+22)>>8;
+        ctx->k+=4;
+        ctx->p[ctx->k++]=ctx->p[ctx->j+1];
+        ctx->p[ctx->k++]=ctx->p[ctx->j+2];
+        ctx->k+=21;
+        ctx->p[ctx->k++]=(ctx->j+ctx->loadaddr-2)&0xff;
+        ctx->p[ctx->k++]=(ctx->j+ctx->loadaddr-2)>>8;
+        ctx->psidh[P_SUBTUNES]=9; // there can be subtunes
+        strcpy(ctx->ids,"Ubik's Music");
         return 1;
     }
     return 0;
 }
 /***** AMP 1.x variable around $13xx *****************************************/
-int Chk_AMP1(void)
+int Chk_AMP1(P2S *ctx)
 {
-    if(fsiz<0x600) return 0;
-    j = -1;
-    for(k=0x300;k<0x400;k++)
-    {
-        if((*(unsigned int*)(p+k)==0x0BB015E0) &&
-           (p[k+0x4]==0xad) &&
-           (p[k+0x7]==0x3d) &&
-           (p[k+0xa]==0xf0) )
+    if(ctx->fsiz<0x600) return 0;
+    ctx->j = -1;
+    for(ctx->k=0x300;ctx->k<0x400;ctx->k++)
+    {
+        if((*(unsigned int*)(ctx->p+ctx->k)==0x0BB015E0) &&
+           (ctx->p[ctx->k+0x4]==0xad) &&
+           (ctx->p[ctx->k+0x7]==0x3d) &&
+           (ctx->p[ctx->k+0xa]==0xf0) )
         {
-            playaddr=k;
-            j=8;
-            while(j>0&&p[playaddr]!=0x60)
+            ctx->playaddr=ctx->k;
+            ctx->j=8;
+            while(ctx->j>0&&ctx->p[ctx->playaddr]!=0x60)
             {
-                playaddr--;
-                j--;
+                ctx->playaddr--;
+                ctx->j--;
             }
-            if(j>0)
+            if(ctx->j>0)
             {
-                j = -1;
-                for(;k<0x400;k++)
+                ctx->j = -1;
+                for(;ctx->k<0x400;ctx->k++)
                 {
-                    if((p[k  ]==0x60) &&
-                       (p[k+1]==0xa9))
+                    if((ctx->p[ctx->k  ]==0x60) &&
+                       (ctx->p[ctx->k+1]==0xa9))
                     {
-                        j=k+1;
+                        ctx->j=ctx->k+1;
                         break;
                     }
                 }
-                if(j>0)
+                if(ctx->j>0)
                 {
-                    playaddr++;
-                    playaddr+=loadaddr-2;
-                    initaddr=j;
-                    initaddr+=loadaddr-2;
+                    ctx->playaddr++;
+                    ctx->playaddr+=ctx->loadaddr-2;
+                    ctx->initaddr=ctx->j;
+                    ctx->initaddr+=ctx->loadaddr-2;
                 }
                 else
                 {
-                    playaddr=initaddr+3;
+                    ctx->playaddr=ctx->initaddr+3;
                 }
             }
             break;
         }
     }
-    if(j>0)
+    if(ctx->j>0)
     {
-        strcpy(ids,"AMP 1.x");
+        strcpy(ctx->ids,"AMP 1.x");
         return 1;
     }
     return 0;
 }
 /***** Boogaloo **************************************************************/
-int Chk_Boogaloo(void)
+int Chk_Boogaloo(P2S *ctx)
 {
-    if(fsiz<0x200) return 0;
-    if((p[0x2]==0x4c) &&
-       (p[0xd]==0xd4) &&
-       (*(unsigned int*)(p+0x05)==0x9DAA0029))
-    {
-        initaddr=loadaddr+3;
-        playaddr=loadaddr+0;
-        strcpy(ids,"Boogaloo");
+    if(ctx->fsiz<0x200) return 0;
+    if((ctx->p[0x2]==0x4c) &&
+       (ctx->p[0xd]==0xd4) &&
+       (*(unsigned int*)(ctx->p+0x05)==0x9DAA0029))
+    {
+        ctx->initaddr=ctx->loadaddr+3;
+        ctx->playaddr=ctx->loadaddr+0;
+        strcpy(ctx->ids,"Boogaloo");
         return 1;
     }
     return 0;
 }
 /***** Bjerregaard: TAX+$1000, variable play around $10xx ********************/
-int Chk_Bjerregaard1(void)
+int Chk_Bjerregaard1(P2S *ctx)
 {
-    if(fsiz<0x200) return 0;
-    j = -1;
-    if(p[2]==0x4c)
+    if(ctx->fsiz<0x200) return 0;
+    ctx->j = -1;
+    if(ctx->p[2]==0x4c)
     {
-        for(k=0x00;k<0x100;k++)
+        for(ctx->k=0x00;ctx->k<0x100;ctx->k++)
         {
-            if((p[k    ]==0xad) &&
-               (*(unsigned int*)(p+k+3)==0xCE600110) &&
-               (p[k+0x9]==0x10) )
+            if((ctx->p[ctx->k    ]==0xad) &&
+               (*(unsigned int*)(ctx->p+ctx->k+3)==0xCE600110) &&
+               (ctx->p[ctx->k+0x9]==0x10) )
             {
-                j=k;
+                ctx->j=ctx->k;
                 break;
             }
         }
     }
-    if(j>0)
+    if(ctx->j>0)
     {
-        initaddr=loadaddr-1;
-        extrabytes[0]=initaddr&0xff;
-        extra=1;
-        p[0]=initaddr>>8;
-        p[1]=0xaa;
-        j=k+loadaddr-2;
-        if(p[5]==0x4c)
+        ctx->initaddr=ctx->loadaddr-1;
+        ctx->extrabytes[0]=ctx->initaddr&0xff;
+        ctx->extra=1;
+        ctx->p[0]=ctx->initaddr>>8;
+        ctx->p[1]=0xaa;
+        ctx->j=ctx->k+ctx->loadaddr-2;
+        if(ctx->p[5]==0x4c)
         {
-            k=p[6]|p[7]<<8;
-            if(j!=k)
+            ctx->k=ctx->p[6]|ctx->p[7]<<8;
+            if(ctx->j!=ctx->k)
             {
-                playaddr=j;
+                ctx->playaddr=ctx->j;
             }
         }
         else
         {
-            playaddr=j;
+            ctx->playaddr=ctx->j;
         }
-        strcpy(ids,"Bjerregaard");strcat(ids," v1");
+        strcpy(ctx->ids,"Bjerregaard");strcat(ctx->ids," v1");
         return 1;
     }
     return 0;
 }
 /***** Bjerregaard v2: $109b/10a1 ********************************************/
-int Chk_Bjerregaard2(void)
+int Chk_Bjerregaard2(P2S *ctx)
 {
-    if(fsiz<0x200) return 0;
-    j = -1;
-    for(k=0;k<=0xff;k++)
-    {
-        if((p[k+0x00]==0x4c) &&
-           (p[k+0x03]==0x4c) &&
-           (p[k+0x06]==0x4c) &&
-           (p[k+0x1b]==0xa9) &&
-           (*(unsigned int*)(p+k+0x1d)==0xA26001D0) &&
-           (*(unsigned int*)(p+k+0x21)==0xA5DDC602) )
+    if(ctx->fsiz<0x200) return 0;
+    ctx->j = -1;
+    for(ctx->k=0;ctx->k<=0xff;ctx->k++)
+    {
+        if((ctx->p[ctx->k+0x00]==0x4c) &&
+           (ctx->p[ctx->k+0x03]==0x4c) &&
+           (ctx->p[ctx->k+0x06]==0x4c) &&
+           (ctx->p[ctx->k+0x1b]==0xa9) &&
+           (*(unsigned int*)(ctx->p+ctx->k+0x1d)==0xA26001D0) &&
+           (*(unsigned int*)(ctx->p+ctx->k+0x21)==0xA5DDC602) )
         {
-            j=k;
+            ctx->j=ctx->k;
             break;
         }
     }
-    if (j>0)
+    if (ctx->j>0)
     {
-        initaddr=loadaddr+k-2;
-        playaddr=initaddr+6;
-        strcpy(ids,"Bjerregaard");strcat(ids," v2");
+        ctx->initaddr=ctx->loadaddr+ctx->k-2;
+        ctx->playaddr=ctx->initaddr+6;
+        strcpy(ctx->ids,"Bjerregaard");strcat(ctx->ids," v2");
         return 1;
     }
     return 0;
 }
 /***** Reflextracker *********************************************************/
-int Chk_ReflexTrk(void)
+int Chk_ReflexTrk(P2S *ctx)
 {
-    if((fsiz+loadaddr > 0xc500) && (fsiz+loadaddr < 0xd000))
+    if((ctx->fsiz+ctx->loadaddr > 0xc500) && (ctx->fsiz+ctx->loadaddr < 0xd000))
     {
-        if((*(unsigned int*)(p+0xc000-loadaddr+2)==0x4CC02C4C) &&
-           (*(unsigned short int*)(p+0xc004-loadaddr+2)==0xC016) &&
-           (*(unsigned int*)(p+0xc00a-loadaddr+2)==0xC02C2001) )
+        if((*(unsigned int*)(ctx->p+0xc000-ctx->loadaddr+2)==0x4CC02C4C) &&
+           (*(unsigned short int*)(ctx->p+0xc004-ctx->loadaddr+2)==0xC016) &&
+           (*(unsigned int*)(ctx->p+0xc00a-ctx->loadaddr+2)==0xC02C2001) )
         {
-            initaddr=0xc006;
-            playaddr=0;
-            psidh[P_MARKER  ]='R';
-            strcpy(ids,"ReflexTracker");
+            ctx->initaddr=0xc006;
+            ctx->playaddr=0;
+            ctx->psidh[P_MARKER  ]='R';
+            strcpy(ctx->ids,"ReflexTracker");
             return 1;
         }
     }
     return 0;
 }
 /***** FAME ******************************************************************/
-int Chk_FAME(void)
-{
-    if(fsiz<0x300) return 0;
-    j = -1;
-    for(k=0;k<0x80;k++)
-    {
-        if((p[k+0x00]==0xaa) &&
-           (p[k+0x01]==0xbd) &&
-           (p[k+0x04]==0x8d) &&
-           (p[k+0x35]==0x4c) &&
-           (p[k+0x38]==0xa2) &&
-           (*(unsigned int*)(p+k+0x07)==0x50850A8A) &&
-           (*(unsigned int*)(p+k+0x0b)==0x5065180A))
-        {
-            j=k;
-            initaddr=j+loadaddr-2;
-            playaddr=j+loadaddr-2+0x38;
+int Chk_FAME(P2S *ctx)
+{
+    if(ctx->fsiz<0x300) return 0;
+    ctx->j = -1;
+    for(ctx->k=0;ctx->k<0x80;ctx->k++)
+    {
+        if((ctx->p[ctx->k+0x00]==0xaa) &&
+           (ctx->p[ctx->k+0x01]==0xbd) &&
+           (ctx->p[ctx->k+0x04]==0x8d) &&
+           (ctx->p[ctx->k+0x35]==0x4c) &&
+           (ctx->p[ctx->k+0x38]==0xa2) &&
+           (*(unsigned int*)(ctx->p+ctx->k+0x07)==0x50850A8A) &&
+           (*(unsigned int*)(ctx->p+ctx->k+0x0b)==0x5065180A))
+        {
+            ctx->j=ctx->k;
+            ctx->initaddr=ctx->j+ctx->loadaddr-2;
+            ctx->playaddr=ctx->j+ctx->loadaddr-2+0x38;
             break;
         }
     }
-    if (j>0)
+    if (ctx->j>0)
     {
-        strcpy(ids,"FAME");strcat(ids," v1");
+        strcpy(ctx->ids,"FAME");strcat(ctx->ids," v1");
         return 1;
     }
-    j = -1;
-    for(k=0;k<0xff;k++)
+    ctx->j = -1;
+    for(ctx->k=0;ctx->k<0xff;ctx->k++)
     {
-        if(*(unsigned int*)(p+k+0x00)==0xA959A2A8)
+        if(*(unsigned int*)(ctx->p+ctx->k+0x00)==0xA959A2A8)
         {
-            j=k;
-            for(;k<0x200;k++)
+            ctx->j=ctx->k;
+            for(;ctx->k<0x200;ctx->k++)
             {
-                if((*(unsigned int*)(p+k+0x00)== 0x7D1898C8) &&
-                   (p[k+0x0e]==0x4c) &&
-                   (p[k+0x11]==0x4c) &&
-                   (p[k+0x14]==0xa2))
+                if((*(unsigned int*)(ctx->p+ctx->k+0x00)== 0x7D1898C8) &&
+                   (ctx->p[ctx->k+0x0e]==0x4c) &&
+                   (ctx->p[ctx->k+0x11]==0x4c) &&
+                   (ctx->p[ctx->k+0x14]==0xa2))
                 {
-                    initaddr=j+loadaddr-2;
-                    playaddr=k+loadaddr-2+0x14;
+                    ctx->initaddr=ctx->j+ctx->loadaddr-2;
+                    ctx->playaddr=ctx->k+ctx->loadaddr-2+0x14;
                     break;
                 }
             }
-            if(k==0x200)
+            if(ctx->k==0x200)
             {
-                j = -1;
+                ctx->j = -1;
             }
             break;
         }
     }
-    if (j>0)
+    if (ctx->j>0)
     {
-        strcpy(ids,"FAME");strcat(ids," v2");
+        strcpy(ctx->ids,"FAME");strcat(ctx->ids," v2");
         return 1;
     }
-    if((p[0x2]==0x4c) &&
-       (p[0x9]==0x8d) &&
-       (*(unsigned int*)(p+0x05)==0x00A959A2))
+    if((ctx->p[0x2]==0x4c) &&
+       (ctx->p[0x9]==0x8d) &&
+       (*(unsigned int*)(ctx->p+0x05)==0x00A959A2))
     {
-        initaddr=loadaddr+3;
-        playaddr=loadaddr+0;
-        strcpy(ids,"FAME");strcat(ids," v3");
+        ctx->initaddr=ctx->loadaddr+3;
+        ctx->playaddr=ctx->loadaddr+0;
+        strcpy(ctx->ids,"FAME");strcat(ctx->ids," v3");
         return 1;
     }
     return 0;
 }
 /***** 20CC ******************************************************************/
-int Chk_20CC(void)
-{
-    if(fsiz<0x300) return 0;
-    j = -1;
-    for(k=0;k<=0xff;k++)
-    {
-        if((p[k+0x00]==0xa9) &&
-           (p[k+0x02]==0x30) &&
-           (p[k+0x04]==0xf0) &&
-           (p[k+0x0a]==0xb9) &&
-           (p[k+0x10]==0xb9) &&
-           (p[k+0x0d]==0x8d) &&
-           (p[k+0x13]==0x8d) &&
-           (*(unsigned int*)(p+k+0x06)==0xa80a0a0a) )
-        {
-            j=k;
+int Chk_20CC(P2S *ctx)
+{
+    if(ctx->fsiz<0x300) return 0;
+    ctx->j = -1;
+    for(ctx->k=0;ctx->k<=0xff;ctx->k++)
+    {
+        if((ctx->p[ctx->k+0x00]==0xa9) &&
+           (ctx->p[ctx->k+0x02]==0x30) &&
+           (ctx->p[ctx->k+0x04]==0xf0) &&
+           (ctx->p[ctx->k+0x0a]==0xb9) &&
+           (ctx->p[ctx->k+0x10]==0xb9) &&
+           (ctx->p[ctx->k+0x0d]==0x8d) &&
+           (ctx->p[ctx->k+0x13]==0x8d) &&
+           (*(unsigned int*)(ctx->p+ctx->k+0x06)==0xa80a0a0a) )
+        {
+            ctx->j=ctx->k;
             break;
         }
-        if((p[k+0x00]==0xa0) &&
-           (p[k+0x02]==0x30) &&
-           (p[k+0x04]==0xf0) &&
-           (p[k+0x06]==0x88) &&
-           (p[k+0x07]==0x98) &&
-           (p[k+0x0c]==0xb9) &&
-           (*(unsigned int*)(p+k+0x08)==0xa80a0a0a) )
+        if((ctx->p[ctx->k+0x00]==0xa0) &&
+           (ctx->p[ctx->k+0x02]==0x30) &&
+           (ctx->p[ctx->k+0x04]==0xf0) &&
+           (ctx->p[ctx->k+0x06]==0x88) &&
+           (ctx->p[ctx->k+0x07]==0x98) &&
+           (ctx->p[ctx->k+0x0c]==0xb9) &&
+           (*(unsigned int*)(ctx->p+ctx->k+0x08)==0xa80a0a0a) )
         {
-            j=k;
+            ctx->j=ctx->k;
             break;
         }
-        if((p[k+0x00]==0xa0) &&
-           (p[k+0x02]==0x30) &&
-           (p[k+0x04]==0xf0) &&
-           (p[k+0x06]==0xA2) &&
-           (p[k+0x07]==0x17) &&
-           (p[k+0x15]==0x8E) &&
-           (p[k+0x22]==0xb9))
+        if((ctx->p[ctx->k+0x00]==0xa0) &&
+           (ctx->p[ctx->k+0x02]==0x30) &&
+           (ctx->p[ctx->k+0x04]==0xf0) &&
+           (ctx->p[ctx->k+0x06]==0xA2) &&
+           (ctx->p[ctx->k+0x07]==0x17) &&
+           (ctx->p[ctx->k+0x15]==0x8E) &&
+           (ctx->p[ctx->k+0x22]==0xb9))
         {
-            j=k;
+            ctx->j=ctx->k;
             break;
         }
     }
-    if (j>0)
-    {
-        extra=6;
-        initaddr=loadaddr-extra;
-        playaddr=j+loadaddr-2;
-        k=0;
-        extrabytes[k++]=initaddr&0xff;
-        extrabytes[k++]=initaddr>>8;
-        extrabytes[k++]=0xa9;
-        extrabytes[k++]=0x01;
-        extrabytes[k++]=0x8d;
-        extrabytes[k++]=(playaddr+1)&0xff;
-        p[0]=(playaddr+1)>>8;
-        p[1]=0x60;
-        strcpy(ids,"20CC");strcat(ids," v1");
+    if (ctx->j>0)
+    {
+        ctx->extra=6;
+        ctx->initaddr=ctx->loadaddr-ctx->extra;
+        ctx->playaddr=ctx->j+ctx->loadaddr-2;
+        ctx->k=0;
+        ctx->extrabytes[ctx->k++]=ctx->initaddr&0xff;
+        ctx->extrabytes[ctx->k++]=ctx->initaddr>>8;
+        ctx->extrabytes[ctx->k++]=0xa9;
+        ctx->extrabytes[ctx->k++]=0x01;
+        ctx->extrabytes[ctx->k++]=0x8d;
+        ctx->extrabytes[ctx->k++]=(ctx->playaddr+1)&0xff;
+        ctx->p[0]=(ctx->playaddr+1)>>8;
+        ctx->p[1]=0x60;
+        strcpy(ctx->ids,"20CC");strcat(ctx->ids," v1");
         return 1;
     }
-    if((p[2]==0xa4)&&
-       (p[8]==0x4c)&&
-       (*(unsigned int*)(p+0x04)==0x03F00930) &&
-       (*(unsigned int*)(p+0x0c)==0xA260D418) )
-    {
-        extra=5;
-        initaddr=loadaddr-extra;
-        playaddr=loadaddr;
-        k=0;
-        extrabytes[k++]=initaddr&0xff;
-        extrabytes[k++]=initaddr>>8;
-        extrabytes[k++]=0xa9;
-        extrabytes[k++]=0x01;
-        extrabytes[k++]=0x85;
-        p[0]=p[3];
-        p[1]=0x60;
-        strcpy(ids,"20CC");strcat(ids," v2");
+    if((ctx->p[2]==0xa4)&&
+       (ctx->p[8]==0x4c)&&
+       (*(unsigned int*)(ctx->p+0x04)==0x03F00930) &&
+       (*(unsigned int*)(ctx->p+0x0c)==0xA260D418) )
+    {
+        ctx->extra=5;
+        ctx->initaddr=ctx->loadaddr-ctx->extra;
+        ctx->playaddr=ctx->loadaddr;
+        ctx->k=0;
+        ctx->extrabytes[ctx->k++]=ctx->initaddr&0xff;
+        ctx->extrabytes[ctx->k++]=ctx->initaddr>>8;
+        ctx->extrabytes[ctx->k++]=0xa9;
+        ctx->extrabytes[ctx->k++]=0x01;
+        ctx->extrabytes[ctx->k++]=0x85;
+        ctx->p[0]=ctx->p[3];
+        ctx->p[1]=0x60;
+        strcpy(ctx->ids,"20CC");strcat(ctx->ids," v2");
         return 1;
     }
     return 0;
 }
 /***** Cybertracker/EXE ******************************************************/
-int Chk_CTExe(void)
-{
-    if((loadaddr == 0x800)&&(fsiz>0x4000)&&
-       (*(unsigned int*)(p+0x3ee1)==0x9AFFA278) &&
-       (*(unsigned int*)(p+0x4001)==0x4C4A7D4C) &&
-       (*(unsigned int*)(p+0x40dc)==0x4a4a4a4a) )
-    {
-        initaddr=0x53A2;
-        playaddr=0x53E2;
-        if(p[0x4be7]==0x20) /* rasterbar */
-           p[0x4be7]=0x2c;
-        strcpy(ids,"Cybertracker/EXE");
+int Chk_CTExe(P2S *ctx)
+{
+    if((ctx->loadaddr == 0x800)&&(ctx->fsiz>0x4000)&&
+       (*(unsigned int*)(ctx->p+0x3ee1)==0x9AFFA278) &&
+       (*(unsigned int*)(ctx->p+0x4001)==0x4C4A7D4C) &&
+       (*(unsigned int*)(ctx->p+0x40dc)==0x4a4a4a4a) )
+    {
+        ctx->initaddr=0x53A2;
+        ctx->playaddr=0x53E2;
+        if(ctx->p[0x4be7]==0x20) /* rasterbar */
+           ctx->p[0x4be7]=0x2c;
+        strcpy(ctx->ids,"Cybertracker/EXE");
         return 1;
     }
     return 0;
 }
 /***** System6581 LDA#2+JSR$1000/LDA#1+JSR$1000 ******************************/
-int Chk_System6581(void)
-{
-    if(fsiz<0x200) return 0;
-    j = -1;
-    if(((*(unsigned int*)(p+0x02)&0x0fffffff)==0x092CF0AA)&&
-        (*(unsigned int*)(p+0x17)==0xD4009DAA) &&
-        (*(unsigned int*)(p+0x22)==0x8E01A2F5) )
-    {
-        j = 7;
-        strcpy(ids,"System6581");strcat(ids," v1");
-    }
-    else if((*(unsigned int*)(p+0x02)==0xC930F0A8) &&
-            (*(unsigned int*)(p+0x06)==0x4C35D001) &&
-           ((*(unsigned int*)(p+0x43)&0xff1fffff)==0xD4009DAA) &&
-            (*(unsigned int*)(p+0x4d)==0x3898F5D0) )
-    {
-        j = 7;
-        strcpy(ids,"System6581");strcat(ids," v2");
-    }
-    if(j>0)
-    {
-        extra=j;
-        initaddr=loadaddr-extra;
-        playaddr=loadaddr-2;
-        k=0;
-        extrabytes[k++]=initaddr&0xff;
-        extrabytes[k++]=initaddr>>8;
-        extrabytes[k++]=0x18;
-        extrabytes[k++]=0x69;
-        extrabytes[k++]=0x02;
-        extrabytes[k++]=0xd0;
-        extrabytes[k++]=0x02;
-        p[0]=0xa9;
-        p[1]=0x01;
+int Chk_System6581(P2S *ctx)
+{
+    if(ctx->fsiz<0x200) return 0;
+    ctx->j = -1;
+    if(((*(unsigned int*)(ctx->p+0x02)&0x0fffffff)==0x092CF0AA)&&
+        (*(unsigned int*)(ctx->p+0x17)==0xD4009DAA) &&
+        (*(unsigned int*)(ctx->p+0x22)==0x8E01A2F5) )
+    {
+        ctx->j = 7;
+        strcpy(ctx->ids,"System6581");strcat(ctx->ids," v1");
+    }
+    else if((*(unsigned int*)(ctx->p+0x02)==0xC930F0A8) &&
+            (*(unsigned int*)(ctx->p+0x06)==0x4C35D001) &&
+           ((*(unsigned int*)(ctx->p+0x43)&0xff1fffff)==0xD4009DAA) &&
+            (*(unsigned int*)(ctx->p+0x4d)==0x3898F5D0) )
+    {
+        ctx->j = 7;
+        strcpy(ctx->ids,"System6581");strcat(ctx->ids," v2");
+    }
+    if(ctx->j>0)
+    {
+        ctx->extra=ctx->j;
+        ctx->initaddr=ctx->loadaddr-ctx->extra;
+        ctx->playaddr=ctx->loadaddr-2;
+        ctx->k=0;
+        ctx->extrabytes[ctx->k++]=ctx->initaddr&0xff;
+        ctx->extrabytes[ctx->k++]=ctx->initaddr>>8;
+        ctx->extrabytes[ctx->k++]=0x18;
+        ctx->extrabytes[ctx->k++]=0x69;
+        ctx->extrabytes[ctx->k++]=0x02;
+        ctx->extrabytes[ctx->k++]=0xd0;
+        ctx->extrabytes[ctx->k++]=0x02;
+        ctx->p[0]=0xa9;
+        ctx->p[1]=0x01;
         return 1;
     }
     return 0;
 }
 /***** Matt Gray: LDA #01 STA $1000/$1002 ************************************/
-int Chk_MattGray(void)
-{
-    if(fsiz<0x200) return 0;
-    if((p[0x04]==0xa2)&&
-       (p[0x05]==0x00)&&
-       (p[0x06]==0x20)&&
-       (p[0x13]==0x60)&&
-       (p[0x14]==0xad)&&
-       (p[0x15]==(loadaddr&0xff))&&
-       (p[0x16]==(loadaddr>>8)  )&&
-       (p[0x1d]==0xc9)&&
-       (p[0x1e]==0xab) )
-    {
-        extra=6;
-        initaddr=loadaddr-extra;
-        playaddr=loadaddr+2;
-        k=0;
-        extrabytes[k++]=initaddr&0xff;
-        extrabytes[k++]=initaddr>>8;
-        extrabytes[k++]=0xa9;
-        extrabytes[k++]=0x01;
-        extrabytes[k++]=0x8d;
-        extrabytes[k++]=(loadaddr&0xff);
-        p[0]=(loadaddr>>8)  ;
-        p[1]=0x60;
-        strcpy(ids,"Matt Gray");
+int Chk_MattGray(P2S *ctx)
+{
+    if(ctx->fsiz<0x200) return 0;
+    if((ctx->p[0x04]==0xa2)&&
+       (ctx->p[0x05]==0x00)&&
+       (ctx->p[0x06]==0x20)&&
+       (ctx->p[0x13]==0x60)&&
+       (ctx->p[0x14]==0xad)&&
+       (ctx->p[0x15]==(ctx->loadaddr&0xff))&&
+       (ctx->p[0x16]==(ctx->loadaddr>>8)  )&&
+       (ctx->p[0x1d]==0xc9)&&
+       (ctx->p[0x1e]==0xab) )
+    {
+        ctx->extra=6;
+        ctx->initaddr=ctx->loadaddr-ctx->extra;
+        ctx->playaddr=ctx->loadaddr+2;
+        ctx->k=0;
+        ctx->extrabytes[ctx->k++]=ctx->initaddr&0xff;
+        ctx->extrabytes[ctx->k++]=ctx->initaddr>>8;
+        ctx->extrabytes[ctx->k++]=0xa9;
+        ctx->extrabytes[ctx->k++]=0x01;
+        ctx->extrabytes[ctx->k++]=0x8d;
+        ctx->extrabytes[ctx->k++]=(ctx->loadaddr&0xff);
+        ctx->p[0]=(ctx->loadaddr>>8)  ;
+        ctx->p[1]=0x60;
+        strcpy(ctx->ids,"Matt Gray");
         return 1;
     }
     return 0;
 }
 /***** Power Music: LDA #subtune+1 STA $1000/$1001 ***************************/
-int Chk_PowerMus(void)
-{
-    if(fsiz<0x200) return 0;
-    if((p[0x03]==0xad)&&
-       (p[0x04]==0x00)&&
-       (p[0x05]==(loadaddr>>8))&&
-       (*(unsigned int*)(p+0x06)==0x01103AF0) &&
-       (*(unsigned int*)(p+0x0a)==0x01E93860) )
-    {
-        extra=7;
-        initaddr=loadaddr-extra;
-        playaddr=loadaddr+1;
-        k=0;
-        extrabytes[k++]=initaddr&0xff;
-        extrabytes[k++]=initaddr>>8;
-        extrabytes[k++]=0x18;
-        extrabytes[k++]=0x69;
-        extrabytes[k++]=0x01;
-        extrabytes[k++]=0x8d;
-        extrabytes[k++]=(loadaddr&0xff);
-        p[0]=(loadaddr>>8)  ;
-        p[1]=0x60;
-        strcpy(ids,"Power Music");
+int Chk_PowerMus(P2S *ctx)
+{
+    if(ctx->fsiz<0x200) return 0;
+    if((ctx->p[0x03]==0xad)&&
+       (ctx->p[0x04]==0x00)&&
+       (ctx->p[0x05]==(ctx->loadaddr>>8))&&
+       (*(unsigned int*)(ctx->p+0x06)==0x01103AF0) &&
+       (*(unsigned int*)(ctx->p+0x0a)==0x01E93860) )
+    {
+        ctx->extra=7;
+        ctx->initaddr=ctx->loadaddr-ctx->extra;
+        ctx->playaddr=ctx->loadaddr+1;
+        ctx->k=0;
+        ctx->extrabytes[ctx->k++]=ctx->initaddr&0xff;
+        ctx->extrabytes[ctx->k++]=ctx->initaddr>>8;
+        ctx->extrabytes[ctx->k++]=0x18;
+        ctx->extrabytes[ctx->k++]=0x69;
+        ctx->extrabytes[ctx->k++]=0x01;
+        ctx->extrabytes[ctx->k++]=0x8d;
+        ctx->extrabytes[ctx->k++]=(ctx->loadaddr&0xff);
+        ctx->p[0]=(ctx->loadaddr>>8)  ;
+        ctx->p[1]=0x60;
+        strcpy(ctx->ids,"Power Music");
         return 1;
     }
     return 0;
 }
 /***** GRG tiny2:variable entry points ***************************************/
-int Chk_GRGTiny2(void)
+int Chk_GRGTiny2(P2S *ctx)
 {
-    if(fsiz<0x100) return 0;
-    j = 0;
-    for(k=0;k<fsiz-0x20;k++)
-    {
-        if((p[k  ]==0xa2) &&
-           (p[k+1]==0x0e) &&
-           (p[k+2]==0x86) )
+    int x;
+    if(ctx->fsiz<0x100) return 0;
+    ctx->j = 0;
+    for(x=0;x<ctx->signum[SIG_GRGTINY2];x++)
+    {
+        ctx->k=ctx->sigcand[SIG_GRGTINY2][x];
+        if(ctx->k>=ctx->fsiz-0x20) break;
+        if((ctx->p[ctx->k  ]==0xa2) &&
+           (ctx->p[ctx->k+1]==0x0e) &&
+           (ctx->p[ctx->k+2]==0x86) )
         {
-            playaddr=k+loadaddr-2;
-            j|=1;
+            ctx->playaddr=ctx->k+ctx->loadaddr-2;
+            ctx->j|=1;
         }
-        if((p[k  ]==0xa9) &&
-           (p[k+1]==0x60) )
+        if((ctx->p[ctx->k  ]==0xa9) &&
+           (ctx->p[ctx->k+1]==0x60) )
         {
-            if(((p[k+2]==0x8d)&&(p[k+5]==0xa2))||
-               ((p[k+2]==0x85)&&(p[k+4]==0xa2)))
+            if(((ctx->p[ctx->k+2]==0x8d)&&(ctx->p[ctx->k+5]==0xa2))||
+               ((ctx->p[ctx->k+2]==0x85)&&(ctx->p[ctx->k+4]==0xa2)))
             {
-                initaddr=k+loadaddr-2;
+                ctx->initaddr=ctx->k+ctx->loadaddr-2;
                 // there could be a AD 86 02 D0 some bytes before this
                 // it's a self mod code to play the tune in ntsc
-                for(i=k-4;i>k-0x20;i--)
+                for(ctx->i=ctx->k-4;ctx->i>ctx->k-0x20;ctx->i--)
                 {
-                    if((*(unsigned int*)(p+i)&0xffffffac)==0xD002A6Ac)
+                    if((*(unsigned int*)(ctx->p+ctx->i)&0xffffffac)==0xD002A6Ac)
                     {
-                        initaddr=i+loadaddr-2;
+                        ctx->initaddr=ctx->i+ctx->loadaddr-2;
                         break;
                     }
                 }
-                j|=2;
+                ctx->j|=2;
             }
         }
-        if(j==3)
+        if(ctx->j==3)
         {
             break;
         }
     }
-    if(j==3)
+    if(ctx->j==3)
     {
-        strcpy(ids,"GRG Tiny2");
+        strcpy(ctx->ids,"GRG Tiny2");
         return 1;
     }
-    initaddr=loadaddr;
-    playaddr=initaddr+3;
+    ctx->initaddr=ctx->loadaddr;
+    ctx->playaddr=ctx->initaddr+3;
     return 0;
 }
 /***** GRG tiny4:variable entry points ***************************************/
-int Chk_GRGTiny4(void)
+int Chk_GRGTiny4(P2S *ctx)
 {
-    if(fsiz<0x100) return 0;
-    j = 0;
-    for(k=0;k<fsiz-0x20;k++)
+    int x;
+    if(ctx->fsiz<0x100) return 0;
+    ctx->j = 0;
+    for(x=0;x<ctx->signum[SIG_GRGTINY4];x++)
     {
+        ctx->k=ctx->sigcand[SIG_GRGTINY4][x];
+        if(ctx->k>=ctx->fsiz-0x20) break;
         // variant 1
-        if((p[k  ]==0xa2) &&
-           (p[k+1]==0x0e) &&
-           (p[k+2]==0xb5) &&
-           (p[k+4]==0xf0) &&
-           (p[k+6]==0xd6) &&
-           (p[k+8]==0xd0) )
+        if((ctx->p[ctx->k  ]==0xa2) &&
+           (ctx->p[ctx->k+1]==0x0e) &&
+           (ctx->p[ctx->k+2]==0xb5) &&
+           (ctx->p[ctx->k+4]==0xf0) &&
+           (ctx->p[ctx->k+6]==0xd6) &&
+           (ctx->p[ctx->k+8]==0xd0) )
         {
-            playaddr=k+loadaddr-2;
-            j|=1;
+            ctx->playaddr=ctx->k+ctx->loadaddr-2;
+            ctx->j|=1;
         }
         // variant 2
-        if((p[k  ]==0xa2) &&
-           (p[k+1]==0x0e) &&
-           (p[k+2]==0xb4) &&
-           (p[k+4]==0xb5) &&
-           (p[k+6]==0x10) &&
-           (p[k+8]==0xa5) )
+        if((ctx->p[ctx->k  ]==0xa2) &&
+           (ctx->p[ctx->k+1]==0x0e) &&
+           (ctx->p[ctx->k+2]==0xb4) &&
+           (ctx->p[ctx->k+4]==0xb5) &&
+           (ctx->p[ctx->k+6]==0x10) &&
+           (ctx->p[ctx->k+8]==0xa5) )
         {
-            playaddr=k+loadaddr-2;
-            j|=1;
+            ctx->playaddr=ctx->k+ctx->loadaddr-2;
+            ctx->j|=1;
         }
-        if((p[k  ]==0xa9) &&
-           (p[k+1]==0x00) &&
-           (p[k+2]==0xa2) &&
-           ((p[k+3]==0x14)||(p[k+3]==0x16)) &&
-           (p[k+6]==0xd4) )
+        if((ctx->p[ctx->k  ]==0xa9) &&
+           (ctx->p[ctx->k+1]==0x00) &&
+           (ctx->p[ctx->k+2]==0xa2) &&
+           ((ctx->p[ctx->k+3]==0x14)||(ctx->p[ctx->k+3]==0x16)) &&
+           (ctx->p[ctx->k+6]==0xd4) )
         {
-            initaddr=k+loadaddr-2;
-            j|=2;
+            ctx->initaddr=ctx->k+ctx->loadaddr-2;
+            ctx->j|=2;
 
         }
-        if(j==3)
+        if(ctx->j==3)
         {
             break;
         }
     }
-    if(j==3)
+    if(ctx->j==3)
     {
-        strcpy(ids,"GRG Tiny4");
+        strcpy(ctx->ids,"GRG Tiny4");
         return 1;
     }
-    initaddr=loadaddr;
-    playaddr=initaddr+3;
+    ctx->initaddr=ctx->loadaddr;
+    ctx->playaddr=ctx->initaddr+3;
     return 0;
 }
 /***** Yip Megasound: $1000/$102e or $10xx/$10xx+$2e *************************/
-int Chk_Yip(void)
-{
-    if(fsiz<0x200) return 0;
-    j = 0;
-    for(k=0;k<0x4f;k++)
-    {
-        if((p[k     ]==0xa9) &&
-           (p[k+0x01]==0x01) &&
-           (p[k+0x02]==0x8d) &&
-           (p[k+0x28]==0xa9) &&
-           (p[k+0x2e]==0xad) &&
-           (p[k+0x31]==0xd0) &&
-           (p[k+0x32]==0x20) &&
-           (p[k+0x33]==0x60)
+int Chk_Yip(P2S *ctx)
+{
+    if(ctx->fsiz<0x200) return 0;
+    ctx->j = 0;
+    for(ctx->k=0;ctx->k<0x4f;ctx->k++)
+    {
+        if((ctx->p[ctx->k     ]==0xa9) &&
+           (ctx->p[ctx->k+0x01]==0x01) &&
+           (ctx->p[ctx->k+0x02]==0x8d) &&
+           (ctx->p[ctx->k+0x28]==0xa9) &&
+           (ctx->p[ctx->k+0x2e]==0xad) &&
+           (ctx->p[ctx->k+0x31]==0xd0) &&
+           (ctx->p[ctx->k+0x32]==0x20) &&
+           (ctx->p[ctx->k+0x33]==0x60)
           )
         {
-            j=1;
-            initaddr=k+loadaddr-2;
-            playaddr=initaddr+0x2e;
+            ctx->j=1;
+            ctx->initaddr=ctx->k+ctx->loadaddr-2;
+            ctx->playaddr=ctx->initaddr+0x2e;
             break;
         }
     }
-    if(j==1)
+    if(ctx->j==1)
     {
-        strcpy(ids,"Yip Megasound");
+        strcpy(ctx->ids,"Yip Megasound");
     }
-    return j;
+    return ctx->j;
 }
 /***** TFX 1.0 : $1106/$1100 *************************************************/
-int Chk_TFX1(void)
-{
-    if(fsiz<0x200) return 0;
-    if((p[0x102]==0x4c)&&
-       (p[0x105]==0x4c)&&
-       (p[0x10e]==0xa8)&&
-       (p[0x10f]==0xb9)&&
-       (*(unsigned int*)(p+0x108)==0x8d0a0a0a)
+int Chk_TFX1(P2S *ctx)
+{
+    if(ctx->fsiz<0x200) return 0;
+    if((ctx->p[0x102]==0x4c)&&
+       (ctx->p[0x105]==0x4c)&&
+       (ctx->p[0x10e]==0xa8)&&
+       (ctx->p[0x10f]==0xb9)&&
+       (*(unsigned int*)(ctx->p+0x108)==0x8d0a0a0a)
       )
     {
-        initaddr=loadaddr+0x106;
-        playaddr=loadaddr+0x100;
-        strcpy(ids,"TFX 1.0");
+        ctx->initaddr=ctx->loadaddr+0x106;
+        ctx->playaddr=ctx->loadaddr+0x100;
+        strcpy(ctx->ids,"TFX 1.0");
         return 1;
     }
     return 0;
 }
 /***** Griff v1: TAY+$1048/$10e0 *********************************************/
-int Chk_Griff1(void)
+int Chk_Griff1(P2S *ctx)
 {
-    if(fsiz<0x200) return 0;
-    if((*(unsigned int*)(p+0x48 +0x02)==0x00A900A2) &&
-       (*(unsigned int*)(p+0x4E +0x02)==0x033C9DD4) &&
-       (*(unsigned int*)(p+0x92 +0x02)==0x6003808D) &&
-       (*(unsigned int*)(p+0xe0 +0x02)==0xF0039CAD)
+    if(ctx->fsiz<0x200) return 0;
+    if((*(unsigned int*)(ctx->p+0x48 +0x02)==0x00A900A2) &&
+       (*(unsigned int*)(ctx->p+0x4E +0x02)==0x033C9DD4) &&
+       (*(unsigned int*)(ctx->p+0x92 +0x02)==0x6003808D) &&
+       (*(unsigned int*)(ctx->p+0xe0 +0x02)==0xF0039CAD)
       )
     {
-        k=2;
-        p[k++]=0x4c;
-        p[k++]=(loadaddr+0x47)&0xff;
-        p[k++]=(loadaddr+0x47)>>8;
-        p[k++]=0x4c;
-        p[k++]=(loadaddr+0xe0)&0xff;
-        p[k++]=(loadaddr+0xe0)>>8;
-        p[0x47+2]=0xa8;
-        initaddr=loadaddr;
-        playaddr=loadaddr+3;
-        strcpy(ids,"Griff");
+        ctx->k=2;
+        ctx->p[ctx->k++]=0x4c;
+        ctx->p[ctx->k++]=(ctx->loadaddr+0x47)&0xff;
+        ctx->p[ctx->k++]=(ctx->loadaddr+0x47)>>8;
+        ctx->p[ctx->k++]=0x4c;
+        ctx->p[ctx->k++]=(ctx->loadaddr+0xe0)&0xff;
+        ctx->p[ctx->k++]=(ctx->loadaddr+0xe0)>>8;
+        ctx->p[0x47+2]=0xa8;
+        ctx->initaddr=ctx->loadaddr;
+        ctx->playaddr=ctx->loadaddr+3;
+        strcpy(ctx->ids,"Griff");
         return 1;
     }
     return 0;
 }
 /***** Griff v2/LightVoices: TAY+$1000/$1003 *********************************/
-int Chk_Griff2(void)
-{
-    if(fsiz<0x200) return 0;
-    if((p[2]==0x4c)&&
-       (*(unsigned int*)(p+0x00+0x05)==0xF003A8AD) &&
-       (*(unsigned int*)(p+0x04+0x05)==0x50AD6001) &&
-       (*(unsigned int*)(p+0x08+0x05)==0xD4188D03) &&
-       (*(unsigned int*)(p+0x0C+0x05)==0x8D0351AD)
+int Chk_Griff2(P2S *ctx)
+{
+    if(ctx->fsiz<0x200) return 0;
+    if((ctx->p[2]==0x4c)&&
+       (*(unsigned int*)(ctx->p+0x00+0x05)==0xF003A8AD) &&
+       (*(unsigned int*)(ctx->p+0x04+0x05)==0x50AD6001) &&
+       (*(unsigned int*)(ctx->p+0x08+0x05)==0xD4188D03) &&
+       (*(unsigned int*)(ctx->p+0x0C+0x05)==0x8D0351AD)
       )
     {
-        initaddr=loadaddr-1;
-        extrabytes[0]=initaddr&0xff;
-        extra=1;
-        p[0]=initaddr>>8;
-        p[1]=0xa8;
-        strcpy(ids,"Griff");
-        strcat(ids,"/LightVoices");
+        ctx->initaddr=ctx->loadaddr-1;
+        ctx->extrabytes[0]=ctx->initaddr&0xff;
+        ctx->extra=1;
+        ctx->p[0]=ctx->initaddr>>8;
+        ctx->p[1]=0xa8;
+        strcpy(ctx->ids,"Griff");
+        strcat(ctx->ids,"/LightVoices");
         return 1;
     }
     return 0;
 }
 /***** Ariston TAX+INX+STX $1000/$1001 ***************************************/
-int Chk_Ariston(void)
+int Chk_Ariston(P2S *ctx)
 {
-    if(fsiz<0x200) return 0;
-    j=-1;
+    if(ctx->fsiz<0x200) return 0;
+    ctx->j=-1;
 
-    for(k=0;k<5;k++)
-    {
-        if((p[k+0x03]==0xad)&&
-           ((p[k+0x04]|(p[k+0x05]<<8))==(loadaddr+k))&&
-           (p[k+0x06]==0xd0)&&
-           (p[k+0x07]==0x09)&&
-           (p[k+0x08]==0x8d)&&
-           (p[k+0x0b]==0x20)&&
-           (p[k+0x0e]==0x4c)&&
-           (p[k+0x0d]==p[k+0x10])
+    for(ctx->k=0;ctx->k<5;ctx->k++)
+    {
+        if((ctx->p[ctx->k+0x03]==0xad)&&
+           ((ctx->p[ctx->k+0x04]|(ctx->p[ctx->k+0x05]<<8))==(ctx->loadaddr+ctx->k))&&
+           (ctx->p[ctx->k+0x06]==0xd0)&&
+           (ctx->p[ctx->k+0x07]==0x09)&&
+           (ctx->p[ctx->k+0x08]==0x8d)&&
+           (ctx->p[ctx->k+0x0b]==0x20)&&
+           (ctx->p[ctx->k+0x0e]==0x4c)&&
+           (ctx->p[ctx->k+0x0d]==ctx->p[ctx->k+0x10])
           )
         {
-            j=k;
+            ctx->j=ctx->k;
             break;
         }
-        if((p[k+0x03]==0xad)&&
-           ((p[k+0x04]|(p[k+0x05]<<8))==(loadaddr+k))&&
-           (p[k+0x06]==0xc9)&&
-           (p[k+0x07]==0xff)&&
-           (p[k+0x08]==0xf0)&&
-           (p[k+0x09]==0x3c)&&
-           (p[k+0x17]==0x20)&&
-           (p[k+0x1a]==0x4c)&&
-           (p[k+0x1c]==p[k+0x19])
+        if((ctx->p[ctx->k+0x03]==0xad)&&
+           ((ctx->p[ctx->k+0x04]|(ctx->p[ctx->k+0x05]<<8))==(ctx->loadaddr+ctx->k))&&
+           (ctx->p[ctx->k+0x06]==0xc9)&&
+           (ctx->p[ctx->k+0x07]==0xff)&&
+           (ctx->p[ctx->k+0x08]==0xf0)&&
+           (ctx->p[ctx->k+0x09]==0x3c)&&
+           (ctx->p[ctx->k+0x17]==0x20)&&
+           (ctx->p[ctx->k+0x1a]==0x4c)&&
+           (ctx->p[ctx->k+0x1c]==ctx->p[ctx->k+0x19])
           )
         {
-            j=k;
+            ctx->j=ctx->k;
             break;
         }
     }
-    if(j>=0)
-    {
-        playaddr=loadaddr+k+1;
-        initaddr=loadaddr-6;
-        extrabytes[0]=initaddr&0xff;
-        extrabytes[1]=initaddr>>8;
-        extrabytes[2]=0xaa;
-        extrabytes[3]=0xe8;
-        extrabytes[4]=0x8e;
-        extrabytes[5]=p[k+0x04];
-        extra=6;
-        p[0]=p[k+0x05];
-        p[1]=0x60;
-        strcpy(ids,"Ariston");
+    if(ctx->j>=0)
+    {
+        ctx->playaddr=ctx->loadaddr+ctx->k+1;
+        ctx->initaddr=ctx->loadaddr-6;
+        ctx->extrabytes[0]=ctx->initaddr&0xff;
+        ctx->extrabytes[1]=ctx->initaddr>>8;
+        ctx->extrabytes[2]=0xaa;
+        ctx->extrabytes[3]=0xe8;
+        ctx->extrabytes[4]=0x8e;
+        ctx->extrabytes[5]=ctx->p[ctx->k+0x04];
+        ctx->extra=6;
+        ctx->p[0]=ctx->p[ctx->k+0x05];
+        ctx->p[1]=0x60;
+        strcpy(ctx->ids,"Ariston");
         return 1;
     }
     return 0;
 }
 /***** Winterberg $102a/$105a ************************************************/
-int Chk_Winterberg(void)
+int Chk_Winterberg(P2S *ctx)
 {
-    if(fsiz<0x200) return 0;
-    j=-1;
-    for (i=2;i<0x30;i++)
-    {
-        if((*(unsigned int*)(p+i)==0x9D8A00A2) &&
-           (*(unsigned short int*)(p+0x04+i)==(loadaddr&0xff00)) &&
-           (*(unsigned int*)(p+0x06+i)==0xD02AE0E8) &&
-           (*(unsigned int*)(p+0x37+i)==0x4C03F000)
+    if(ctx->fsiz<0x200) return 0;
+    ctx->j=-1;
+    for (ctx->i=2;ctx->i<0x30;ctx->i++)
+    {
+        if((*(unsigned int*)(ctx->p+ctx->i)==0x9D8A00A2) &&
+           (*(unsigned short int*)(ctx->p+0x04+ctx->i)==(ctx->loadaddr&0xff00)) &&
+           (*(unsigned int*)(ctx->p+0x06+ctx->i)==0xD02AE0E8) &&
+           (*(unsigned int*)(ctx->p+0x37+ctx->i)==0x4C03F000)
           )
         {
-            j=i;
+            ctx->j=ctx->i;
             break;
         }
     }
-    if(j>=0)
-    {
-        initaddr=loadaddr+i-2;
-        playaddr=initaddr+0x30;
-        psidh[P_TIMING  ]=1; // CIA timing
-        j=i+0x10;
-        memset(p+j,0xea,10);
-        p[j+ 0]=0xa9;
-        p[j+ 1]=0x25;
-        p[j+ 2]=0x8d;
-        p[j+ 3]=0x04;
-        p[j+ 4]=0xdc;
-        p[0x143+i]=0x60;
-        strcpy(ids,"Winterberg");
+    if(ctx->j>=0)
+    {
+        ctx->initaddr=ctx->loadaddr+ctx->i-2;
+        ctx->playaddr=ctx->initaddr+0x30;
+        ctx->psidh[P_TIMING  ]=1; // CIA timing
+        ctx->j=ctx->i+0x10;
+        memset(ctx->p+ctx->j,0xea,10);
+        ctx->p[ctx->j+ 0]=0xa9;
+        ctx->p[ctx->j+ 1]=0x25;
+        ctx->p[ctx->j+ 2]=0x8d;
+        ctx->p[ctx->j+ 3]=0x04;
+        ctx->p[ctx->j+ 4]=0xdc;
+        ctx->p[0x143+ctx->i]=0x60;
+        strcpy(ctx->ids,"Winterberg");
         return 1;
     }
     return 0;
 }
 /***** Henrik Jensen $100f/$1015 *********************************************/
-int Chk_Jensen(void)
+int Chk_Jensen(P2S *ctx)
 {
-    if(fsiz<0x800) return 0;
-    k=-1;
-    for (i=0;i<0x10;i++)
-    {
-        if((p[0x0e +i]==0x4c)&&
-           (p[0x11 +i]==0x4c)&&
-           (p[0x14 +i]==0x4c)&&
-           (p[0x17 +i]==0xce)&&
-           (p[0x1a +i]==0xce)&&
-           (p[0x20 +i]==0xa9)&&
-           (*(unsigned int*)(p+0x5b +i)==0x0AD00F30) )
+    if(ctx->fsiz<0x800) return 0;
+    ctx->k=-1;
+    for (ctx->i=0;ctx->i<0x10;ctx->i++)
+    {
+        if((ctx->p[0x0e +ctx->i]==0x4c)&&
+           (ctx->p[0x11 +ctx->i]==0x4c)&&
+           (ctx->p[0x14 +ctx->i]==0x4c)&&
+           (ctx->p[0x17 +ctx->i]==0xce)&&
+           (ctx->p[0x1a +ctx->i]==0xce)&&
+           (ctx->p[0x20 +ctx->i]==0xa9)&&
+           (*(unsigned int*)(ctx->p+0x5b +ctx->i)==0x0AD00F30) )
         {
-            k=i;
+            ctx->k=ctx->i;
             break;
         }
     }
-    if(k>=0)
+    if(ctx->k>=0)
     {
-        initaddr=loadaddr+0x0f+k;
-        playaddr=loadaddr+0x15+k;
-        strcpy(ids,"Henrik Jensen");
+        ctx->initaddr=ctx->loadaddr+0x0f+ctx->k;
+        ctx->playaddr=ctx->loadaddr+0x15+ctx->k;
+        strcpy(ctx->ids,"Henrik Jensen");
         return 1;
     }
     return 0;
 }
 /***** MegaVision lda #$80+$1000/$103e ***************************************/
-int Chk_MegaVision(void)
-{
-    if(fsiz<0xb00) return 0;
-    if((p[0x0f]==0xad)&&
-       (p[0x10]==0x2d)&&
-       (*(unsigned int*)(p+0x05c)==0xD40099A8) &&
-       (*(unsigned int*)(p+0x060)==0xD018C0C8) &&
-       (*(unsigned int*)(p+0x1e0)==0x60E93809) )
-    {
-        k=2;
-        p[k++]=0xa9;
-        p[k++]=0x80;
-        p[k++]=0x8d;
-        p[k++]=0x28;
-        p[k++]=loadaddr>>8;
-        memset(p+7,0xea,8);
-        p[0x26]=0x60;
-        p[0x36]=0x60;
-        p[0x904]=0x60; // 4c31ea
-        psidh[P_TIMING  ]=1; // CIA timing, not always needed
-        initaddr=loadaddr;
-        playaddr=loadaddr+0x3e;
-        strcpy(ids,"MegaVision");
+int Chk_MegaVision(P2S *ctx)
+{
+    if(ctx->fsiz<0xb00) return 0;
+    if((ctx->p[0x0f]==0xad)&&
+       (ctx->p[0x10]==0x2d)&&
+       (*(unsigned int*)(ctx->p+0x05c)==0xD40099A8) &&
+       (*(unsigned int*)(ctx->p+0x060)==0xD018C0C8) &&
+       (*(unsigned int*)(ctx->p+0x1e0)==0x60E93809) )
+    {
+        ctx->k=2;
+        ctx->p[ctx->k++]=0xa9;
+        ctx->p[ctx->k++]=0x80;
+        ctx->p[ctx->k++]=0x8d;
+        ctx->p[ctx->k++]=0x28;
+        ctx->p[ctx->k++]=ctx->loadaddr>>8;
+        memset(ctx->p+7,0xea,8);
+        ctx->p[0x26]=0x60;
+        ctx->p[0x36]=0x60;
+        ctx->p[0x904]=0x60; // 4c31ea
+        ctx->psidh[P_TIMING  ]=1; // CIA timing, not always needed
+        ctx->initaddr=ctx->loadaddr;
+        ctx->playaddr=ctx->loadaddr+0x3e;
+        strcpy(ctx->ids,"MegaVision");
         return 1;
     }
     return 0;
 }
 /***** SkylineTech/Danne: $1003/$1000 (usually $a83/$a80) ********************/
-int Chk_SkylineTech_Danne(void)
+int Chk_SkylineTech_Danne(P2S *ctx)
 {
-    if(fsiz<0x600) return 0;
-    i=loadaddr+0x5d;
-    i<<=8;
-    i|=0xad00004c;
+    if(ctx->fsiz<0x600) return 0;
+    ctx->i=ctx->loadaddr+0x5d;
+    ctx->i<<=8;
+    ctx->i|=0xad00004c;
     if(
-       (*(unsigned int*)(p+0x02)==i) &&
-       (*(unsigned int*)(p+0x08)==0xA903418D) &&
-       (*(unsigned int*)(p+0x4a)==0xD4009DAA) &&
-       (*(unsigned int*)(p+0x90)==0x0341AD03)
+       (*(unsigned int*)(ctx->p+0x02)==ctx->i) &&
+       (*(unsigned int*)(ctx->p+0x08)==0xA903418D) &&
+       (*(unsigned int*)(ctx->p+0x4a)==0xD4009DAA) &&
+       (*(unsigned int*)(ctx->p+0x90)==0x0341AD03)
       )
     {
-        initaddr=loadaddr+3;
-        playaddr=loadaddr+0;
-        strcpy(ids,"SkylineTech/Danne");
-        i=fixsklstack(p+2,fsiz-2);
-        if(i==0x100)
+        ctx->initaddr=ctx->loadaddr+3;
+        ctx->playaddr=ctx->loadaddr+0;
+        strcpy(ctx->ids,"SkylineTech/Danne");
+        ctx->i=fixsklstack(ctx,ctx->p+2,ctx->fsiz-2);
+        if(ctx->i==0x100)
         {
-            strcat(ids," (fixed)");
+            strcat(ctx->ids," (fixed)");
         }
         return 1;
     }
     return 0;
 }
 /***** Deflemask v2/v12 ******************************************************/
-int Chk_Deflemask(void)
+int Chk_Deflemask(P2S *ctx)
 {
     // loadaddr can be $1000 or $1006 if already cut by sidclean
-    if(fsiz<0x200) return 0;
+    if(ctx->fsiz<0x200) return 0;
     // v2 until v11
-    for (i=2;i<=8;i+=6)
+    for (ctx->i=2;ctx->i<=8;ctx->i+=6)
     {
-        if((*(unsigned int*)(p+0x00c-6+i)==0x02D013E6) &&
-           (*(unsigned int*)(p+0x010-6+i)==0x84AD14E6) &&
-           (*(unsigned int*)(p+0x049-6+i)==0xCAD40099) )
+        if((*(unsigned int*)(ctx->p+0x00c-6+ctx->i)==0x02D013E6) &&
+           (*(unsigned int*)(ctx->p+0x010-6+ctx->i)==0x84AD14E6) &&
+           (*(unsigned int*)(ctx->p+0x049-6+ctx->i)==0xCAD40099) )
         {
-            initaddr=loadaddr&0xff00;
-            playaddr=initaddr+3;
-            j=((initaddr>>8)&0xff)+1;
-            if(i==8)
+            ctx->initaddr=ctx->loadaddr&0xff00;
+            ctx->playaddr=ctx->initaddr+3;
+            ctx->j=((ctx->initaddr>>8)&0xff)+1;
+            if(ctx->i==8)
             {
-                i=2;
-                p[i++]=0x4c;
-                p[i++]=0x0f;
-                p[i++]=j;
-                p[i++]=0x4c;
-                p[i++]=0x17;
-                p[i++]=j;
+                ctx->i=2;
+                ctx->p[ctx->i++]=0x4c;
+                ctx->p[ctx->i++]=0x0f;
+                ctx->p[ctx->i++]=ctx->j;
+                ctx->p[ctx->i++]=0x4c;
+                ctx->p[ctx->i++]=0x17;
+                ctx->p[ctx->i++]=ctx->j;
             }
             else
             {
-                extra=6;
-                extrabytes[0]=initaddr&0xff;
-                extrabytes[1]=initaddr>>8;
-                extrabytes[2]=0x4c;
-                extrabytes[3]=0x0f;
-                extrabytes[4]=j;
-                extrabytes[5]=0x4c;
-                p[0]         =0x17;
-                p[1]         =j;
+                ctx->extra=6;
+                ctx->extrabytes[0]=ctx->initaddr&0xff;
+                ctx->extrabytes[1]=ctx->initaddr>>8;
+                ctx->extrabytes[2]=0x4c;
+                ctx->extrabytes[3]=0x0f;
+                ctx->extrabytes[4]=ctx->j;
+                ctx->extrabytes[5]=0x4c;
+                ctx->p[0]         =0x17;
+                ctx->p[1]         =ctx->j;
 
             }
-            strcpy(ids,"Deflemask v2");
+            strcpy(ctx->ids,"Deflemask v2");
             return 1;
         }
     }
     // v12
-    for (i=2;i<=8;i+=6)
+    for (ctx->i=2;ctx->i<=8;ctx->i+=6)
     {
-        if(((*(unsigned int*)(p+0x006-6+i)&0x00ffffff)==0x00B518A2) &&
-           (*(unsigned int*)(p+0x00a-6+i)==0xCAD4009D) &&
-           (*(unsigned int*)(p+0x05d-6+i)==0xA500FF60) )
+        if(((*(unsigned int*)(ctx->p+0x006-6+ctx->i)&0x00ffffff)==0x00B518A2) &&
+           (*(unsigned int*)(ctx->p+0x00a-6+ctx->i)==0xCAD4009D) &&
+           (*(unsigned int*)(ctx->p+0x05d-6+ctx->i)==0xA500FF60) )
         {
-            initaddr=loadaddr&0xff00;
-            playaddr=initaddr+6;
-            j=((initaddr>>8)&0xff)+1;
-            if(i==8)
+            ctx->initaddr=ctx->loadaddr&0xff00;
+            ctx->playaddr=ctx->initaddr+6;
+            ctx->j=((ctx->initaddr>>8)&0xff)+1;
+            if(ctx->i==8)
             {
-                i=2;
-                p[i++]=0x4c;
-                p[i++]=0x03;
-                p[i++]=j;
-                p[i++]=0x4c;
-                p[i++]=playaddr&0xff;
-                p[i++]=playaddr>>8;
+                ctx->i=2;
+                ctx->p[ctx->i++]=0x4c;
+                ctx->p[ctx->i++]=0x03;
+                ctx->p[ctx->i++]=ctx->j;
+                ctx->p[ctx->i++]=0x4c;
+                ctx->p[ctx->i++]=ctx->playaddr&0xff;
+                ctx->p[ctx->i++]=ctx->playaddr>>8;
             }
             else
             {
-                extra=6;
-                extrabytes[0]=initaddr&0xff;
-                extrabytes[1]=initaddr>>8;
-                extrabytes[2]=0x4c;
-                extrabytes[3]=0x03;
-                extrabytes[4]=j;
-                extrabytes[5]=0x4c;
-                p[0]         =playaddr&0xff;
-                p[1]         =playaddr>>8;
+                ctx->extra=6;
+                ctx->extrabytes[0]=ctx->initaddr&0xff;
+                ctx->extrabytes[1]=ctx->initaddr>>8;
+                ctx->extrabytes[2]=0x4c;
+                ctx->extrabytes[3]=0x03;
+                ctx->extrabytes[4]=ctx->j;
+                ctx->extrabytes[5]=0x4c;
+                ctx->p[0]         =ctx->playaddr&0xff;
+                ctx->p[1]         =ctx->playaddr>>8;
 
             }
-            strcpy(ids,"Deflemask v12");
+            strcpy(ctx->ids,"Deflemask v12");
             return 1;
         }
     }
     // v12 large mem
-    if(((*(unsigned int*)(p+0x002)&0x00ffffff)==0x00B518A2) &&
-       (*(unsigned int*)(p+0x06)==0xCAD4009D) &&
-       (*(unsigned int*)(p+0x60)==0xA500FF60) )
-    {
-        initaddr=loadaddr+0x106;
-        playaddr=loadaddr;
-        strcpy(ids,"Deflemask v12");
-        strcat(ids,"/bank-switched");
+    if(((*(unsigned int*)(ctx->p+0x002)&0x00ffffff)==0x00B518A2) &&
+       (*(unsigned int*)(ctx->p+0x06)==0xCAD4009D) &&
+       (*(unsigned int*)(ctx->p+0x60)==0xA500FF60) )
+    {
+        ctx->initaddr=ctx->loadaddr+0x106;
+        ctx->playaddr=ctx->loadaddr;
+        strcpy(ctx->ids,"Deflemask v12");
+        strcat(ctx->ids,"/bank-switched");
         return 1;
     }
     return 0;
 }
 
 /***** SidFactory: $1000/$1006-1009 ******************************************/
-int Chk_SidFactory(void)
+int Chk_SidFactory(P2S *ctx)
 {
-    if(fsiz<0x200) return 0;
-    if(p[0x2]==0x4c)
+    if(ctx->fsiz<0x200) return 0;
+    if(ctx->p[0x2]==0x4c)
     {
-        for (k=6;k<=9;k+=3)
+        for (ctx->k=6;ctx->k<=9;ctx->k+=3)
         {
-            if((p[k+2+0x00]==0x2c)&&
-               (p[k+2+0x03]==0x30)&&
-               (p[k+2+0x05]==0x70)&&
-               (p[k+2+0x07]==0xa9)&&
-               (p[k+2+0x08]==0x00)&&
-               (p[k+2+0x09]==0xa2)&&
-               (p[k+2+0x0b]==0xca))
+            if((ctx->p[ctx->k+2+0x00]==0x2c)&&
+               (ctx->p[ctx->k+2+0x03]==0x30)&&
+               (ctx->p[ctx->k+2+0x05]==0x70)&&
+               (ctx->p[ctx->k+2+0x07]==0xa9)&&
+               (ctx->p[ctx->k+2+0x08]==0x00)&&
+               (ctx->p[ctx->k+2+0x09]==0xa2)&&
+               (ctx->p[ctx->k+2+0x0b]==0xca))
             {
-                initaddr=loadaddr;
-                playaddr=loadaddr+k;
-                strcpy(ids,"SidFactory");
+                ctx->initaddr=ctx->loadaddr;
+                ctx->playaddr=ctx->loadaddr+ctx->k;
+                strcpy(ctx->ids,"SidFactory");
                 return 1;
             }
         }
@@ -3069,349 +3234,352 @@ at $7186 (offset from 5c7c=0x150a)
 
 save as RSID from 5C20
 */
-int Chk_Mssiah(void)
-{
-    if(fsiz<0x5000) return 0;
-    if(loadaddr>0x5c7c) return 0;
-    j=0x5c7c-loadaddr+2;
-    if((*(unsigned int*)(p+j+0x0)==0x5A8D80A9) &&
-       (*(unsigned int*)(p+j+0x4)==0x5EF32071) &&
-       (*(unsigned int*)(p+j+0x8)==0x205F1C20) &&
-       (*(unsigned int*)(p+j+0xc)==0xF6A25E9B) )
-    {
-        psidh[P_MARKER  ]='R';
-        initaddr=0x5c20;
-        playaddr=0;
-
-        p+=j;
-        fsiz-=j;
-        loadaddr+=j;
-        p[0x02aa]=0x60;
-        p[0x030d]=0xA2;
+int Chk_Mssiah(P2S *ctx)
+{
+    if(ctx->fsiz<0x5000) return 0;
+    if(ctx->loadaddr>0x5c7c) return 0;
+    ctx->j=0x5c7c-ctx->loadaddr+2;
+    if((*(unsigned int*)(ctx->p+ctx->j+0x0)==0x5A8D80A9) &&
+       (*(unsigned int*)(ctx->p+ctx->j+0x4)==0x5EF32071) &&
+       (*(unsigned int*)(ctx->p+ctx->j+0x8)==0x205F1C20) &&
+       (*(unsigned int*)(ctx->p+ctx->j+0xc)==0xF6A25E9B) )
+    {
+        ctx->psidh[P_MARKER  ]='R';
+        ctx->initaddr=0x5c20;
+        ctx->playaddr=0;
+
+        ctx->p+=ctx->j;
+        ctx->fsiz-=ctx->j;
+        ctx->loadaddr+=ctx->j;
+        ctx->p[0x02aa]=0x60;
+        ctx->p[0x030d]=0xA2;
         // screen writes
-        j=0x0503;
-        p[j++]=0xea;
-        p[j++]=0xea;
-        p[j++]=0xea;
-        j=0x0509;
-        p[j++]=0xea;
-        p[j++]=0xea;
-        p[j++]=0xea;
+        ctx->j=0x0503;
+        ctx->p[ctx->j++]=0xea;
+        ctx->p[ctx->j++]=0xea;
+        ctx->p[ctx->j++]=0xea;
+        ctx->j=0x0509;
+        ctx->p[ctx->j++]=0xea;
+        ctx->p[ctx->j++]=0xea;
+        ctx->p[ctx->j++]=0xea;
 
         // buffer $1200->$5b00
-        p[0x028A]=0x5B;
-        p[0x0979]=0x5B;
-        p[0x097F]=0x5B;
-        p[0x0FAF]=0x5B;
-        p[0x0FB5]=0x5B;
-        p[0x10E6]=0x5B;
-        p[0x10EF]=0x5B;
-        psidh[P_FREEPAGE]=0x04;
-        psidh[P_FREEPMAX]=0x57;
+        ctx->p[0x028A]=0x5B;
+        ctx->p[0x0979]=0x5B;
+        ctx->p[0x097F]=0x5B;
+        ctx->p[0x0FAF]=0x5B;
+        ctx->p[0x0FB5]=0x5B;
+        ctx->p[0x10E6]=0x5B;
+        ctx->p[0x10EF]=0x5B;
+        ctx->psidh[P_FREEPAGE]=0x04;
+        ctx->psidh[P_FREEPMAX]=0x57;
 
         // 2sid?
-        j=0x150a;
-        if( p[j] > 0 )
+        ctx->j=0x150a;
+        if( ctx->p[ctx->j] > 0 )
         {
-            p[j] = 3; // force d500, fuck de00/df00
-            psidh[P_SIDVER  ]=3;
-            psidh[P_STEREOAD]=0x50;
-            k=(psidh[P_SIDMODEL]&0x30)<<2;
-            psidh[P_SIDMODEL]|=k;
+            ctx->p[ctx->j] = 3; // force d500, fuck de00/df00
+            ctx->psidh[P_SIDVER  ]=3;
+            ctx->psidh[P_STEREOAD]=0x50;
+            ctx->k=(ctx->psidh[P_SIDMODEL]&0x30)<<2;
+            ctx->psidh[P_SIDMODEL]|=ctx->k;
         }
 
-        extrabytes[0]=initaddr&0xff;
-        extrabytes[1]=initaddr>>8;
-        memmove(extrabytes+2,aPatchMssiah,sizeof(aPatchMssiah));
-        extra=2+sizeof(aPatchMssiah);
+        ctx->extrabytes[0]=ctx->initaddr&0xff;
+        ctx->extrabytes[1]=ctx->initaddr>>8;
+        memmove(ctx->extrabytes+2,aPatchMssiah,sizeof(aPatchMssiah));
+        ctx->extra=2+sizeof(aPatchMssiah);
 
-        strcpy(ids,"Mssiah");
+        strcpy(ctx->ids,"Mssiah");
         return 1;
     }
     return 0;
 }
 /***** GoatTracker+MultiSpeed: $0ff6/$1003 ***********************************/
-int Chk_GoatMultispeed(void)
+int Chk_GoatMultispeed(P2S *ctx)
 {
     double speed=0;
     char pspeed[32]={0};
-    if(fsiz<0x500) return 0;
-    k=2;
-    if((p[k+0x00]==0xa2)&&
-       (p[k+0x0D]==0x4C)&&
-       (*(unsigned int*)(p+k+0x02)==0xA2DC048E)&&
-       (*(unsigned int*)(p+k+0x07)==0x4CDC058E)
+    if(ctx->fsiz<0x500) return 0;
+    ctx->k=2;
+    if((ctx->p[ctx->k+0x00]==0xa2)&&
+       (ctx->p[ctx->k+0x0D]==0x4C)&&
+       (*(unsigned int*)(ctx->p+ctx->k+0x02)==0xA2DC048E)&&
+       (*(unsigned int*)(ctx->p+ctx->k+0x07)==0x4CDC058E)
       )
     {
-        psidh[P_TIMING  ]=1; // CIA timing
-        playaddr=initaddr+0xd;
-        speed=(1.0*0x4cc8) / (p[k+1]|(p[k+6]<<8));
+        ctx->psidh[P_TIMING  ]=1; // CIA timing
+        ctx->playaddr=ctx->initaddr+0xd;
+        speed=(1.0*0x4cc8) / (ctx->p[ctx->k+1]|(ctx->p[ctx->k+6]<<8));
         sprintf(pspeed,"GoatTracker+MultiSpeed: %2.1fx",speed);
-        strcpy(ids,pspeed);
+        strcpy(ctx->ids,pspeed);
         return 1;
     }
     return 0;
 }
 /***** FlexSid $1000/$1010 (normal) $1000/$100a (bare) ***********************/
-int Chk_FlexSid(void)
+int Chk_FlexSid(P2S *ctx)
 {
-    if(fsiz<0x100) return 0;
-    j = 0;
-    for(k=0;k<fsiz-0x20;k++)
-    {
-        if((*(unsigned int*)(p+k+0x00)==0xC19500AB)&&
-           (*(unsigned int*)(p+k+0x0C)==0x60D4188E)&&
-           (*(unsigned int*)(p+k+0x10)==0xFF860EA2))
+    int x;
+    if(ctx->fsiz<0x100) return 0;
+    ctx->j = 0;
+    for(x=0;x<ctx->signum[SIG_FLEXSID];x++)
+    {
+        ctx->k=ctx->sigcand[SIG_FLEXSID][x];
+        if(ctx->k>=ctx->fsiz-0x20) break;
+        if((*(unsigned int*)(ctx->p+ctx->k+0x00)==0xC19500AB)&&
+           (*(unsigned int*)(ctx->p+ctx->k+0x0C)==0x60D4188E)&&
+           (*(unsigned int*)(ctx->p+ctx->k+0x10)==0xFF860EA2))
         {
-            j=1;
-            initaddr=k+loadaddr-2;
-            playaddr=k+loadaddr-2+0x10;
-            strcpy(ids,"FlexSid");
+            ctx->j=1;
+            ctx->initaddr=ctx->k+ctx->loadaddr-2;
+            ctx->playaddr=ctx->k+ctx->loadaddr-2+0x10;
+            strcpy(ctx->ids,"FlexSid");
             break;
         }
-        if((*(unsigned int*)(p+k+0x00)==0x00A93FA2)&&
-           (*(unsigned int*)(p+k+0x06)==0x60FB10CA)&&
-           (*(unsigned int*)(p+k+0x0a)==0xFF860EA2))
+        if((*(unsigned int*)(ctx->p+ctx->k+0x00)==0x00A93FA2)&&
+           (*(unsigned int*)(ctx->p+ctx->k+0x06)==0x60FB10CA)&&
+           (*(unsigned int*)(ctx->p+ctx->k+0x0a)==0xFF860EA2))
         {
-            j=2;
-            initaddr=k+loadaddr-2;
-            playaddr=k+loadaddr-2+0x0a;
-            strcpy(ids,"FlexSid-Bare");
+            ctx->j=2;
+            ctx->initaddr=ctx->k+ctx->loadaddr-2;
+            ctx->playaddr=ctx->k+ctx->loadaddr-2+0x0a;
+            strcpy(ctx->ids,"FlexSid-Bare");
             break;
         }
     }
-    if(j!=0)
+    if(ctx->j!=0)
     {
         return 1;
     }
     return 0;
 }
 /***** StarBars **************************************************************/
-int Chk_StarBars(void)
+int Chk_StarBars(P2S *ctx)
 {
-    if(fsiz<0x1000) return 0;
-    if((loadaddr>=0x0800) &&
-       (loadaddr<=0x080d) )
+    if(ctx->fsiz<0x1000) return 0;
+    if((ctx->loadaddr>=0x0800) &&
+       (ctx->loadaddr<=0x080d) )
     {
-        if((*(unsigned int*)(p-loadaddr+2+0x80d)==0x0009BB4C) &&
-           (*(unsigned int*)(p-loadaddr+2+0x89c)==0x4E494541) &&
-           (*(unsigned int*)(p-loadaddr+2+0x1000)==0x8D1504AD))
+        if((*(unsigned int*)(ctx->p-ctx->loadaddr+2+0x80d)==0x0009BB4C) &&
+           (*(unsigned int*)(ctx->p-ctx->loadaddr+2+0x89c)==0x4E494541) &&
+           (*(unsigned int*)(ctx->p-ctx->loadaddr+2+0x1000)==0x8D1504AD))
         {
-            j=*(unsigned char*)(p-loadaddr+2+0x9be);
-            if((j==0x42) || (j==0x49))
+            ctx->j=*(unsigned char*)(ctx->p-ctx->loadaddr+2+0x9be);
+            if((ctx->j==0x42) || (ctx->j==0x49))
             {
-                psidh[P_MARKER  ]='R';
-                psidh[P_SIDMODEL]=0x34; // fixed PAL & Any model
-                strcpy(ids,"StarBars ");
-                initaddr=0x09bb;
-                playaddr=0;
+                ctx->psidh[P_MARKER  ]='R';
+                ctx->psidh[P_SIDMODEL]=0x34; // fixed PAL & Any model
+                strcpy(ctx->ids,"StarBars ");
+                ctx->initaddr=0x09bb;
+                ctx->playaddr=0;
                 // common patches between 1.1 and 1.2
-                k=0x08B1 - loadaddr+2;
-                memset(p+k,0, 0x99);
-                k=0x09c0 - loadaddr+2;
-                memset(p+k,0xea, 0x6b);
-                k=0x0a5b - loadaddr+2;
-                p[k++]=0x60;
-                memset(p+k,0, 0x05a4);
-                k=0x1300 - loadaddr+2;
-                memset(p+k,00, 0x100);
+                ctx->k=0x08B1 - ctx->loadaddr+2;
+                memset(ctx->p+ctx->k,0, 0x99);
+                ctx->k=0x09c0 - ctx->loadaddr+2;
+                memset(ctx->p+ctx->k,0xea, 0x6b);
+                ctx->k=0x0a5b - ctx->loadaddr+2;
+                ctx->p[ctx->k++]=0x60;
+                memset(ctx->p+ctx->k,0, 0x05a4);
+                ctx->k=0x1300 - ctx->loadaddr+2;
+                memset(ctx->p+ctx->k,00, 0x100);
                 // now deal with different versions offsets
-                if(j==0x42)
+                if(ctx->j==0x42)
                 {
-                    k=0x10b1 - loadaddr+2;
-                    memset(p+k,0x60, 0x1e);
-                    k=0x11e1 - loadaddr+2;
-                    memset(p+k,0xea, 0x29);
-                    k=0x122b - loadaddr+2;
-                    memset(p+k,0x60, 0x17);
-                    k=0x1271 - loadaddr+2;
-                    memset(p+k,0x60, 0x12);
-                    k=0x129c - loadaddr+2;
-                    memset(p+k,0x60, 0x20);
-
-                    strcat(ids,"v1.1");
+                    ctx->k=0x10b1 - ctx->loadaddr+2;
+                    memset(ctx->p+ctx->k,0x60, 0x1e);
+                    ctx->k=0x11e1 - ctx->loadaddr+2;
+                    memset(ctx->p+ctx->k,0xea, 0x29);
+                    ctx->k=0x122b - ctx->loadaddr+2;
+                    memset(ctx->p+ctx->k,0x60, 0x17);
+                    ctx->k=0x1271 - ctx->loadaddr+2;
+                    memset(ctx->p+ctx->k,0x60, 0x12);
+                    ctx->k=0x129c - ctx->loadaddr+2;
+                    memset(ctx->p+ctx->k,0x60, 0x20);
+
+                    strcat(ctx->ids,"v1.1");
                 }
                 else
                 {
-                    k=0x10a1 - loadaddr+2;
-                    memset(p+k,0x60, 0x1e);
-                    k=0x11e8 - loadaddr+2;
-                    memset(p+k,0xea, 0x29);
-                    k=0x1232 - loadaddr+2;
-                    memset(p+k,0x60, 0x17);
-                    k=0x1278 - loadaddr+2;
-                    memset(p+k,0x60, 0x12);
-                    k=0x12a3 - loadaddr+2;
-                    memset(p+k,0x60, 0x20);
-
-                    strcat(ids,"v1.2");
+                    ctx->k=0x10a1 - ctx->loadaddr+2;
+                    memset(ctx->p+ctx->k,0x60, 0x1e);
+                    ctx->k=0x11e8 - ctx->loadaddr+2;
+                    memset(ctx->p+ctx->k,0xea, 0x29);
+                    ctx->k=0x1232 - ctx->loadaddr+2;
+                    memset(ctx->p+ctx->k,0x60, 0x17);
+                    ctx->k=0x1278 - ctx->loadaddr+2;
+                    memset(ctx->p+ctx->k,0x60, 0x12);
+                    ctx->k=0x12a3 - ctx->loadaddr+2;
+                    memset(ctx->p+ctx->k,0x60, 0x20);
+
+                    strcat(ctx->ids,"v1.2");
                 }
                 return 1;
             }
         }
-        if((*(unsigned int*)(p-loadaddr+2+0x80d)==0x0920D878) &&
-           (*(unsigned int*)(p-loadaddr+2+0xb0b)==0x4E494541) &&
-           (*(unsigned int*)(p-loadaddr+2+0x930)==0x8D1504AD))
-        {
-            j=*(unsigned char*)(p-loadaddr+2+0x0810);
-            if(j==0x09)
-            {
-                psidh[P_MARKER  ]='R';
-                psidh[P_SIDMODEL]=0x34; // fixed PAL & Any model
-                strcpy(ids,"StarBars ");
-                initaddr=0x080d;
-                playaddr=0;
-
-                k=0x0812 - loadaddr+2;
-                memset(p+k,0xea, 0x90);
-                k=0x08d8 - loadaddr+2;
-                p[k++]=0x60;
-                memset(p+k,0, 0x057);
-                k=0x09d1 - loadaddr+2;
-                memset(p+k,0x60, 0x1e);
-                k=0x0b20 - loadaddr+2;
-                memset(p+k,0, 0x4e0);
-                k=0x10a5 - loadaddr+2;
-                memset(p+k,0xea, 0x29);
-                k=0x10f2 - loadaddr+2;
-                memset(p+k,0x60, 0x17);
-                k=0x1138 - loadaddr+2;
-                memset(p+k,0x60, 0x98);
-                k=0x11e8 - loadaddr+2;
-                memset(p+k,0x60, 0x21);
-                k=0x120a - loadaddr+2;
-                memset(p+k,0, 0x1f6);
-                k=0x141c - loadaddr+2;
-                memset(p+k,0, 0xe4);
-
-                strcat(ids,"v1.3");
-                strcat(ids,"beta");
+        if((*(unsigned int*)(ctx->p-ctx->loadaddr+2+0x80d)==0x0920D878) &&
+           (*(unsigned int*)(ctx->p-ctx->loadaddr+2+0xb0b)==0x4E494541) &&
+           (*(unsigned int*)(ctx->p-ctx->loadaddr+2+0x930)==0x8D1504AD))
+        {
+            ctx->j=*(unsigned char*)(ctx->p-ctx->loadaddr+2+0x0810);
+            if(ctx->j==0x09)
+            {
+                ctx->psidh[P_MARKER  ]='R';
+                ctx->psidh[P_SIDMODEL]=0x34; // fixed PAL & Any model
+                strcpy(ctx->ids,"StarBars ");
+                ctx->initaddr=0x080d;
+                ctx->playaddr=0;
+
+                ctx->k=0x0812 - ctx->loadaddr+2;
+                memset(ctx->p+ctx->k,0xea, 0x90);
+                ctx->k=0x08d8 - ctx->loadaddr+2;
+                ctx->p[ctx->k++]=0x60;
+                memset(ctx->p+ctx->k,0, 0x057);
+                ctx->k=0x09d1 - ctx->loadaddr+2;
+                memset(ctx->p+ctx->k,0x60, 0x1e);
+                ctx->k=0x0b20 - ctx->loadaddr+2;
+                memset(ctx->p+ctx->k,0, 0x4e0);
+                ctx->k=0x10a5 - ctx->loadaddr+2;
+                memset(ctx->p+ctx->k,0xea, 0x29);
+                ctx->k=0x10f2 - ctx->loadaddr+2;
+                memset(ctx->p+ctx->k,0x60, 0x17);
+                ctx->k=0x1138 - ctx->loadaddr+2;
+                memset(ctx->p+ctx->k,0x60, 0x98);
+                ctx->k=0x11e8 - ctx->loadaddr+2;
+                memset(ctx->p+ctx->k,0x60, 0x21);
+                ctx->k=0x120a - ctx->loadaddr+2;
+                memset(ctx->p+ctx->k,0, 0x1f6);
+                ctx->k=0x141c - ctx->loadaddr+2;
+                memset(ctx->p+ctx->k,0, 0xe4);
+
+                strcat(ctx->ids,"v1.3");
+                strcat(ctx->ids,"beta");
                 return 1;
             }
         }
-        if((*(unsigned int*)(p-loadaddr+2+0x80d)==0x00A9D878) &&
-           (*(unsigned int*)(p-loadaddr+2+0xb1d)==0x4E494541) &&
-           (*(unsigned int*)(p-loadaddr+2+0x92f)==0x8D1504AD))
-        {
-            j=*(unsigned char*)(p-loadaddr+2+0x0819);
-            if(j==0x04)
-            {
-                psidh[P_MARKER  ]='R';
-                psidh[P_SIDMODEL]=0x34; // fixed PAL & Any model
-                strcpy(ids,"StarBars ");
-                initaddr=0x080d;
-                playaddr=0;
-                k=0x0818 - loadaddr+2;
-                memset(p+k,0xea, 0x7b);
-                k=0x08e6 - loadaddr+2;
-                memset(p+k,0x60, 0x49);
-                k=0x09E3 - loadaddr+2;
-                memset(p+k,0x60, 0x1e);
-                k=0x0b32 - loadaddr+2;
-                memset(p+k,0, 0x4ce);
-                k=0x10b4 - loadaddr+2;
-                memset(p+k,0xea, 0x1c);
-                k=0x10d7 - loadaddr+2;
-                memset(p+k,0x60, 0x3e);
-                k=0x111c - loadaddr+2;
-                memset(p+k,0x60, 0x10);
-                k=0x113f - loadaddr+2;
-                memset(p+k,0x60, 0x92);
-                k=0x1204 - loadaddr+2;
-                memset(p+k,0x60, 0x20);
-                k=0x128d - loadaddr+2;
-                memset(p+k,0, 0x173);
-                k=0x141c - loadaddr+2;
-                memset(p+k,0, 0xe4);
-
-                strcat(ids,"v1.3");
+        if((*(unsigned int*)(ctx->p-ctx->loadaddr+2+0x80d)==0x00A9D878) &&
+           (*(unsigned int*)(ctx->p-ctx->loadaddr+2+0xb1d)==0x4E494541) &&
+           (*(unsigned int*)(ctx->p-ctx->loadaddr+2+0x92f)==0x8D1504AD))
+        {
+            ctx->j=*(unsigned char*)(ctx->p-ctx->loadaddr+2+0x0819);
+            if(ctx->j==0x04)
+            {
+                ctx->psidh[P_MARKER  ]='R';
+                ctx->psidh[P_SIDMODEL]=0x34; // fixed PAL & Any model
+                strcpy(ctx->ids,"StarBars ");
+                ctx->initaddr=0x080d;
+                ctx->playaddr=0;
+                ctx->k=0x0818 - ctx->loadaddr+2;
+                memset(ctx->p+ctx->k,0xea, 0x7b);
+                ctx->k=0x08e6 - ctx->loadaddr+2;
+                memset(ctx->p+ctx->k,0x60, 0x49);
+                ctx->k=0x09E3 - ctx->loadaddr+2;
+                memset(ctx->p+ctx->k,0x60, 0x1e);
+                ctx->k=0x0b32 - ctx->loadaddr+2;
+                memset(ctx->p+ctx->k,0, 0x4ce);
+                ctx->k=0x10b4 - ctx->loadaddr+2;
+                memset(ctx->p+ctx->k,0xea, 0x1c);
+                ctx->k=0x10d7 - ctx->loadaddr+2;
+                memset(ctx->p+ctx->k,0x60, 0x3e);
+                ctx->k=0x111c - ctx->loadaddr+2;
+                memset(ctx->p+ctx->k,0x60, 0x10);
+                ctx->k=0x113f - ctx->loadaddr+2;
+                memset(ctx->p+ctx->k,0x60, 0x92);
+                ctx->k=0x1204 - ctx->loadaddr+2;
+                memset(ctx->p+ctx->k,0x60, 0x20);
+                ctx->k=0x128d - ctx->loadaddr+2;
+                memset(ctx->p+ctx->k,0, 0x173);
+                ctx->k=0x141c - ctx->loadaddr+2;
+                memset(ctx->p+ctx->k,0, 0xe4);
+
+                strcat(ctx->ids,"v1.3");
                 return 1;
             }
         }
-        if((*(unsigned int*)(p-loadaddr+2+0x80d)==0x00A9D878) &&
-           (*(unsigned int*)(p-loadaddr+2+0xb21)==0x4E494541) &&
-           (*(unsigned int*)(p-loadaddr+2+0x929)==0x8D1504AD))
-        {
-            j=*(unsigned char*)(p-loadaddr+2+0x0819);
-            if(j==0x04)
-            {
-                psidh[P_MARKER  ]='R';
-                psidh[P_SIDMODEL]=0x34; // fixed PAL & Any model
-                strcpy(ids,"StarBars ");
-                initaddr=0x080d;
-                playaddr=0;
-                k=0x0818 - loadaddr+2;
-                memset(p+k,0xea, 0x75);
-
-                k=0x08e0 - loadaddr+2;
-                memset(p+k,0x60, 0x48);
-
-                k=0x09E7 - loadaddr+2;
-                memset(p+k,0x60, 0x1e);
-
-                k=0x0b36 - loadaddr+2;
-                memset(p+k,0, 0x4ca);
-
-                k=0x10b4 - loadaddr+2;
-                memset(p+k,0xea, 0x1c);
-                k=0x10d7 - loadaddr+2;
-                memset(p+k,0x60, 0x3e);
-                k=0x111c - loadaddr+2;
-                memset(p+k,0x60, 0x10);
-                k=0x113f - loadaddr+2;
-                memset(p+k,0x60, 0x92);
-                k=0x1204 - loadaddr+2;
-                memset(p+k,0x60, 0x20);
-                k=0x128d - loadaddr+2;
-                memset(p+k,0, 0x173);
-                k=0x141c - loadaddr+2;
-                memset(p+k,0, 0xe4);
-
-                strcat(ids,"v1.4");
-                strcat(ids,"beta");
+        if((*(unsigned int*)(ctx->p-ctx->loadaddr+2+0x80d)==0x00A9D878) &&
+           (*(unsigned int*)(ctx->p-ctx->loadaddr+2+0xb21)==0x4E494541) &&
+           (*(unsigned int*)(ctx->p-ctx->loadaddr+2+0x929)==0x8D1504AD))
+        {
+            ctx->j=*(unsigned char*)(ctx->p-ctx->loadaddr+2+0x0819);
+            if(ctx->j==0x04)
+            {
+                ctx->psidh[P_MARKER  ]='R';
+                ctx->psidh[P_SIDMODEL]=0x34; // fixed PAL & Any model
+                strcpy(ctx->ids,"StarBars ");
+                ctx->initaddr=0x080d;
+                ctx->playaddr=0;
+                ctx->k=0x0818 - ctx->loadaddr+2;
+                memset(ctx->p+ctx->k,0xea, 0x75);
+
+                ctx->k=0x08e0 - ctx->loadaddr+2;
+                memset(ctx->p+ctx->k,0x60, 0x48);
+
+                ctx->k=0x09E7 - ctx->loadaddr+2;
+                memset(ctx->p+ctx->k,0x60, 0x1e);
+
+                ctx->k=0x0b36 - ctx->loadaddr+2;
+                memset(ctx->p+ctx->k,0, 0x4ca);
+
+                ctx->k=0x10b4 - ctx->loadaddr+2;
+                memset(ctx->p+ctx->k,0xea, 0x1c);
+                ctx->k=0x10d7 - ctx->loadaddr+2;
+                memset(ctx->p+ctx->k,0x60, 0x3e);
+                ctx->k=0x111c - ctx->loadaddr+2;
+                memset(ctx->p+ctx->k,0x60, 0x10);
+                ctx->k=0x113f - ctx->loadaddr+2;
+                memset(ctx->p+ctx->k,0x60, 0x92);
+                ctx->k=0x1204 - ctx->loadaddr+2;
+                memset(ctx->p+ctx->k,0x60, 0x20);
+                ctx->k=0x128d - ctx->loadaddr+2;
+                memset(ctx->p+ctx->k,0, 0x173);
+                ctx->k=0x141c - ctx->loadaddr+2;
+                memset(ctx->p+ctx->k,0, 0xe4);
+
+                strcat(ctx->ids,"v1.4");
+                strcat(ctx->ids,"beta");
                 return 1;
             }
         }
-        if((*(unsigned int*)(p-loadaddr+2+0x80d)==0xAA00A978) &&
-           (*(unsigned int*)(p-loadaddr+2+0xb20)==0x4E494541) &&
-           (*(unsigned int*)(p-loadaddr+2+0x901)==0x8D1504AD))
-        {
-            j=*(unsigned char*)(p-loadaddr+2+0x0818);
-            if(j==0x04)
-            {
-                psidh[P_MARKER  ]='R';
-                psidh[P_SIDMODEL]=0x34; // fixed PAL & Any model
-                strcpy(ids,"StarBars ");
-                initaddr=0x080d;
-                playaddr=0;
-                k=0x0817 - loadaddr+2;
-                memset(p+k,0xea, 0x4e);
-
-                k=0x08b8 - loadaddr+2;
-                memset(p+k,0x60, 0x48);
-
-                k=0x09D6 - loadaddr+2;
-                memset(p+k,0x60, 0x1e);
-
-                k=0x0b35 - loadaddr+2;
-                memset(p+k,0, 0x4cb);
-
-                k=0x10b4 - loadaddr+2;
-                memset(p+k,0xea, 0x1c);
-                k=0x10d7 - loadaddr+2;
-                memset(p+k,0x60, 0x3e);
-                k=0x111c - loadaddr+2;
-                memset(p+k,0x60, 0x10);
-                k=0x113f - loadaddr+2;
-                memset(p+k,0x60, 0x92);
-                k=0x1204 - loadaddr+2;
-                memset(p+k,0x60, 0x20);
-                k=0x128d - loadaddr+2;
-                memset(p+k,0, 0x173);
-                k=0x141c - loadaddr+2;
-                memset(p+k,0, 0x95);
-
-                strcat(ids,"v1.4");
+        if((*(unsigned int*)(ctx->p-ctx->loadaddr+2+0x80d)==0xAA00A978) &&
+           (*(unsigned int*)(ctx->p-ctx->loadaddr+2+0xb20)==0x4E494541) &&
+           (*(unsigned int*)(ctx->p-ctx->loadaddr+2+0x901)==0x8D1504AD))
+        {
+            ctx->j=*(unsigned char*)(ctx->p-ctx->loadaddr+2+0x0818);
+            if(ctx->j==0x04)
+            {
+                ctx->psidh[P_MARKER  ]='R';
+                ctx->psidh[P_SIDMODEL]=0x34; // fixed PAL & Any model
+                strcpy(ctx->ids,"StarBars ");
+                ctx->initaddr=0x080d;
+                ctx->playaddr=0;
+                ctx->k=0x0817 - ctx->loadaddr+2;
+                memset(ctx->p+ctx->k,0xea, 0x4e);
+
+                ctx->k=0x08b8 - ctx->loadaddr+2;
+                memset(ctx->p+ctx->k,0x60, 0x48);
+
+                ctx->k=0x09D6 - ctx->loadaddr+2;
+                memset(ctx->p+ctx->k,0x60, 0x1e);
+
+                ctx->k=0x0b35 - ctx->loadaddr+2;
+                memset(ctx->p+ctx->k,0, 0x4cb);
+
+                ctx->k=0x10b4 - ctx->loadaddr+2;
+                memset(ctx->p+ctx->k,0xea, 0x1c);
+                ctx->k=0x10d7 - ctx->loadaddr+2;
+                memset(ctx->p+ctx->k,0x60, 0x3e);
+                ctx->k=0x111c - ctx->loadaddr+2;
+                memset(ctx->p+ctx->k,0x60, 0x10);
+                ctx->k=0x113f - ctx->loadaddr+2;
+                memset(ctx->p+ctx->k,0x60, 0x92);
+                ctx->k=0x1204 - ctx->loadaddr+2;
+                memset(ctx->p+ctx->k,0x60, 0x20);
+                ctx->k=0x128d - ctx->loadaddr+2;
+                memset(ctx->p+ctx->k,0, 0x173);
+                ctx->k=0x141c - ctx->loadaddr+2;
+                memset(ctx->p+ctx->k,0, 0x95);
+
+                strcat(ctx->ids,"v1.4");
                 return 1;
             }
         }
@@ -3419,69 +3587,69 @@ int Chk_StarBars(void)
     return 0;
 }
 /***** Quantum SoundTracker **************************************************/
-int Chk_QuantumSndTrk(void)
+int Chk_QuantumSndTrk(P2S *ctx)
 {   // if there are enough bytes to patch, ok, else don't identify
     // else it will write outside the read memory.
-    if(fsiz<(0xdd8f+0x3c+2-loadaddr)) return 0;
-    if((loadaddr>=0x0800) &&
-       (loadaddr<=0x080d) )
+    if(ctx->fsiz<(0xdd8f+0x3c+2-ctx->loadaddr)) return 0;
+    if((ctx->loadaddr>=0x0800) &&
+       (ctx->loadaddr<=0x080d) )
     {
-        if((*(unsigned int*)(p-loadaddr+2+0x80f)==0x8534A90D) &&
-           (*(unsigned int*)(p-loadaddr+2+0x89b)==0x4A4A4A8A) &&
-           (*(unsigned int*)(p-loadaddr+2+0x9AF)==0xEDF0DD0D))
+        if((*(unsigned int*)(ctx->p-ctx->loadaddr+2+0x80f)==0x8534A90D) &&
+           (*(unsigned int*)(ctx->p-ctx->loadaddr+2+0x89b)==0x4A4A4A8A) &&
+           (*(unsigned int*)(ctx->p-ctx->loadaddr+2+0x9AF)==0xEDF0DD0D))
         {
-            j=*(unsigned char*)(p-loadaddr+2+0x80e);
-            if((j==0x6a) || (j==0x6c))
+            ctx->j=*(unsigned char*)(ctx->p-ctx->loadaddr+2+0x80e);
+            if((ctx->j==0x6a) || (ctx->j==0x6c))
             {
-                psidh[P_MARKER  ]='R';
+                ctx->psidh[P_MARKER  ]='R';
                 //psidh[P_SIDMODEL]=0x14; // fixed PAL & 6581
-                psidh[P_FREEPAGE]=4;
-                psidh[P_FREEPMAX]=4;
-                strcpy(ids,"Quantum SoundTracker 1.0");
+                ctx->psidh[P_FREEPAGE]=4;
+                ctx->psidh[P_FREEPMAX]=4;
+                strcpy(ctx->ids,"Quantum SoundTracker 1.0");
 
                 // common patches
-                k=0x0821 - loadaddr+2;
-                memset(p+k,0xea, 0x03);
+                ctx->k=0x0821 - ctx->loadaddr+2;
+                memset(ctx->p+ctx->k,0xea, 0x03);
 
-                k=0x082c - loadaddr+2;
-                memset(p+k,0x78, 0x0c);
+                ctx->k=0x082c - ctx->loadaddr+2;
+                memset(ctx->p+ctx->k,0x78, 0x0c);
 
-                k=0x08e7 - loadaddr+2;
-                memset(p+k,0x60, 0x56);
+                ctx->k=0x08e7 - ctx->loadaddr+2;
+                memset(ctx->p+ctx->k,0x60, 0x56);
 
-                k=0x0fc0 - loadaddr+2;
-                memset(p+k,0x60, 0x3f);
+                ctx->k=0x0fc0 - ctx->loadaddr+2;
+                memset(ctx->p+ctx->k,0x60, 0x3f);
 
-                k=0xdd6d - loadaddr+2;
-                memset(p+k,0xea, 0x03);
+                ctx->k=0xdd6d - ctx->loadaddr+2;
+                memset(ctx->p+ctx->k,0xea, 0x03);
 
-                k=0xdd73 - loadaddr+2;
-                memset(p+k,0xea, 0x03);
+                ctx->k=0xdd73 - ctx->loadaddr+2;
+                memset(ctx->p+ctx->k,0xea, 0x03);
 
-                k=0xdd8f - loadaddr+2;
-                memset(p+k,0x60, 0x3c);
+                ctx->k=0xdd8f - ctx->loadaddr+2;
+                memset(ctx->p+ctx->k,0x60, 0x3c);
 
                 // the "no limit" demo track has 2 byte offset
                 // compared to the actual generated binaries in 1.0
-                if (j==0x6c)
+                if (ctx->j==0x6c)
                 {
-                	strcat(ids,"/demo");
-                    k=0x0a3e - loadaddr+2;
-                    memset(p+k,0x60, 0x2e6);
+                	strcat(ctx->ids,"/demo");
+                    ctx->k=0x0a3e - ctx->loadaddr+2;
+                    memset(ctx->p+ctx->k,0x60, 0x2e6);
 
-                    k=0x0d8a - loadaddr+2;
-                    memset(p+k,0x60, 0xb9);
+                    ctx->k=0x0d8a - ctx->loadaddr+2;
+                    memset(ctx->p+ctx->k,0x60, 0xb9);
                 }
                 else
                 {
-                    k=0x0a3e - loadaddr+2;
-                    memset(p+k,0x60, 0x2e4);
+                    ctx->k=0x0a3e - ctx->loadaddr+2;
+                    memset(ctx->p+ctx->k,0x60, 0x2e4);
 
-                    k=0x0d88 - loadaddr+2;
-                    memset(p+k,0x60, 0xb9);
+                    ctx->k=0x0d88 - ctx->loadaddr+2;
+                    memset(ctx->p+ctx->k,0x60, 0xb9);
                 }
-                initaddr=0x080d;
-                playaddr=0;
+                ctx->initaddr=0x080d;
+                ctx->playaddr=0;
                 return 1;
             }
         }
@@ -3489,47 +3657,47 @@ int Chk_QuantumSndTrk(void)
     return 0;
 }
 /***** Whittaker *************************************************************/
-int Chk_Whittaker(void)
+int Chk_Whittaker(P2S *ctx)
 {
-    if(fsiz<0x800) return 0;
-    i=0;
-    for(k=0;k<0x800;k++)
+    if(ctx->fsiz<0x800) return 0;
+    ctx->i=0;
+    for(ctx->k=0;ctx->k<0x800;ctx->k++)
     {
-        if(*(unsigned int*)(p+k)==0x8D00A9AA)
+        if(*(unsigned int*)(ctx->p+ctx->k)==0x8D00A9AA)
         {
-            i=k;
+            ctx->i=ctx->k;
             break;
         }
     }
-    if (i>0)
+    if (ctx->i>0)
     {
-        for(j=i;j<0x800;j++)
+        for(ctx->j=ctx->i;ctx->j<0x800;ctx->j++)
         {
-            if((*(unsigned int*)(p+j )==0xA548F8A5) &&
-               (p[j+0x06]==0xCE) &&
-               (p[j+0x09]==0xD0) &&
-               (p[j+0x10]==0xD0) &&
-               (p[j+0x12]==0x20)
+            if((*(unsigned int*)(ctx->p+ctx->j )==0xA548F8A5) &&
+               (ctx->p[ctx->j+0x06]==0xCE) &&
+               (ctx->p[ctx->j+0x09]==0xD0) &&
+               (ctx->p[ctx->j+0x10]==0xD0) &&
+               (ctx->p[ctx->j+0x12]==0x20)
               )
             {
-                initaddr=loadaddr+k-2;
-                playaddr=loadaddr+j-2;
-                strcpy(ids,"Whittaker");
-                strcat(ids," v1");
+                ctx->initaddr=ctx->loadaddr+ctx->k-2;
+                ctx->playaddr=ctx->loadaddr+ctx->j-2;
+                strcpy(ctx->ids,"Whittaker");
+                strcat(ctx->ids," v1");
                 return 1;
             }
-            if((*(unsigned int*)(p+j )==0xA548F8A5) &&
-               (p[j+0x06]==0x20) &&
-               (p[j+0x0f]==0x60) &&
-               (p[j+0x15]==0xCE) &&
-               (p[j+0x18]==0xD0) &&
-               (p[j+0x1C]==0x20)
+            if((*(unsigned int*)(ctx->p+ctx->j )==0xA548F8A5) &&
+               (ctx->p[ctx->j+0x06]==0x20) &&
+               (ctx->p[ctx->j+0x0f]==0x60) &&
+               (ctx->p[ctx->j+0x15]==0xCE) &&
+               (ctx->p[ctx->j+0x18]==0xD0) &&
+               (ctx->p[ctx->j+0x1C]==0x20)
               )
             {
-                initaddr=loadaddr+k-2;
-                playaddr=loadaddr+j-2;
-                strcpy(ids,"Whittaker");
-                strcat(ids," v2");
+                ctx->initaddr=ctx->loadaddr+ctx->k-2;
+                ctx->playaddr=ctx->loadaddr+ctx->j-2;
+                strcpy(ctx->ids,"Whittaker");
+                strcat(ctx->ids," v2");
                 return 1;
             }
         }
@@ -3538,7 +3706,7 @@ int Chk_Whittaker(void)
 }
 /*****************************************************************************/
 
-typedef int(*Scnptr)(void);
+typedef int(*Scnptr)(P2S *ctx);
 
 Scnptr ScanFunc[]=
 {Chk_FC
@@ -3613,25 +3781,442 @@ Scnptr ScanFunc[]=
 };
 
 /*****************************************************************************/
-int Scanners(void)
+int Scanners(P2S *ctx)
 {
     int x,y,z=0;
     y=sizeof(ScanFunc)/sizeof(*ScanFunc);
+    SigScan(ctx);
     for (x=0;x<y;x++)
     {
-        z=(ScanFunc[x])();
+        z=(ScanFunc[x])(ctx);
         if( z )
             break;
     }
     return z;
 }
 
+/***** Per file ************************************************************/
+/* P2SLoad() results, and what main() returns for them */
+enum {P2S_OK,P2S_EOPEN,P2S_ENOMEM,P2S_ISSID,P2S_ECREATE};
+int p2sexit[]={0,2,3,2,4};
+
+void P2SInit(P2S *ctx)
+{
+    memset(ctx,0,sizeof(*ctx));
+    memcpy(ctx->psidh,psidhdef,sizeof(ctx->psidh));
+    strcpy(ctx->ids,"Generic");
+}
+
+void P2SFree(P2S *ctx)
+{
+    int x;
+    free(ctx->realp);
+    for(x=0;x<SIG_CHECKS;x++)
+    {
+        free(ctx->sigcand[x]);
+    }
+    P2SInit(ctx);
+}
+
+/* <name>.prg -> <name>.sid */
+void P2SSidName(char *newfile,const char *prgname)
+{
+    char *z,*q;
+    strcpy(newfile,prgname);
+    z=strrchr(newfile,'\\');
+    if(z)
+    {
+        q=strrchr(z,'.');
+    }
+    else
+    {
+        q=strrchr(newfile,'.');
+    }
+    if(q)
+        *q=0;
+    strcat(newfile,".sid");
+}
+
+int P2SLoad(P2S *ctx,const char *prgname)
+{
+    FILE *h;
+    h=fopen(prgname,"rb");
+    if(h==NULL)
+    {
+        return P2S_EOPEN;
+    }
+    fseek(h,0,SEEK_END);
+    ctx->fsiz=ftell(h);
+    fseek(h,0,SEEK_SET);
+    ctx->realp=calloc(ctx->fsiz,1);
+    ctx->p=ctx->realp;
+    if(ctx->realp==NULL)
+    {
+        fclose(h);
+        return P2S_ENOMEM;
+    }
+    fread(ctx->p,ctx->fsiz,1,h);
+    fclose(h);
+    if(((ctx->p[P_MARKER+0]==psidhdef[P_MARKER+0])||(ctx->p[P_MARKER+0]=='R')) &&
+        (ctx->p[P_MARKER+1]==psidhdef[P_MARKER+1]) &&
+        (ctx->p[P_MARKER+2]==psidhdef[P_MARKER+2]) &&
+        (ctx->p[P_MARKER+3]==psidhdef[P_MARKER+3]))
+    {
+        return P2S_ISSID;
+    }
+    ctx->loadaddr=ctx->p[0]|ctx->p[1]<<8;
+    return P2S_OK;
+}
+
+/* start ripping from addr, if it's inside the file */
+void P2SSkipTo(P2S *ctx,int addr)
+{
+    int skip;
+    if((addr>ctx->loadaddr) && (addr<(ctx->loadaddr+ctx->fsiz-2)))
+    {
+        skip=addr-ctx->loadaddr;
+        ctx->p+=skip;
+        ctx->fsiz-=skip;
+        ctx->loadaddr=addr;
+        ctx->p[0]=addr&0xff;
+        ctx->p[1]=addr>>8;
+    }
+}
+
+void P2SIdentify(P2S *ctx)
+{
+    /* default for classic 1000/1003 */
+    ctx->initaddr=ctx->loadaddr;
+    ctx->playaddr=ctx->initaddr+3;
+    /* briefly id some particular players */
+    Scanners(ctx);
+}
+
+void P2SWrite(P2S *ctx,FILE *hout)
+{
+    int end;
+    ctx->psidh[P_INITADDR+0]=ctx->initaddr>>8;
+    ctx->psidh[P_INITADDR+1]=ctx->initaddr&0xff;
+    ctx->psidh[P_PLAYADDR+0]=ctx->playaddr>>8;
+    ctx->psidh[P_PLAYADDR+1]=ctx->playaddr&0xff;
+    fwrite(ctx->psidh,sizeof(ctx->psidh),1,hout);
+    if(ctx->extra)
+    {
+        fwrite(ctx->extrabytes,ctx->extra,1,hout);
+        if(ctx->extra==1)
+        {
+            ctx->loadaddr=ctx->extrabytes[0]|ctx->p[0]<<8;
+        }
+        else
+        {
+            ctx->loadaddr=ctx->extrabytes[0]|ctx->extrabytes[1]<<8;
+        }
+    }
+
+    end=ctx->fsiz+ctx->loadaddr+ctx->extra-2;
+    if (end>0xffff)
+    {
+        ctx->fsiz-=(end-0x10000);
+    }
+    fwrite(ctx->p,ctx->fsiz,1,hout);
+}
+
+/***** Batch mode ************************************************************/
+/* One PRG of a directory. patched counts the bytes of the rip a check
+   changed, extra the bytes it inserted before it. */
+typedef struct {
+    char prgname[MAX_PATH];
+    char sidname[MAX_PATH];
+    int status;
+    char ids[30];
+    int loadaddr,initaddr,playaddr;
+    int patched,extra;
+    int rsid,ciatiming;
+} P2SJOB;
+
+typedef struct {
+    P2SJOB *jobs;
+    int numjobs,nextjob;
+    pthread_mutex_t lock;
+} P2SQUEUE;
+
+void P2SConvert(P2SJOB *job)
+{
+    P2S ctx;
+    FILE *hout;
+    unsigned char *orig;
+    int size,x;
+
+    P2SInit(&ctx);
+    P2SSidName(job->sidname,job->prgname);
+    job->status=P2SLoad(&ctx,job->prgname);
+    if(job->status==P2S_OK)
+    {
+        size=ctx.fsiz;
+        orig=malloc(size);
+        hout=orig?fopen(job->sidname,"wb"):NULL;
+        if(orig==NULL)
+        {
+            job->status=P2S_ENOMEM;
+        }
+        else if(hout==NULL)
+        {
+            job->status=P2S_ECREATE;
+        }
+        else
+        {
+            memcpy(orig,ctx.realp,size);
+            P2SIdentify(&ctx);
+            for(x=0;x<size;x++)
+            {
+                job->patched+=(orig[x]!=ctx.realp[x]);
+            }
+            P2SWrite(&ctx,hout);
+            strcpy(job->ids,ctx.ids);
+            job->loadaddr=ctx.loadaddr;
+            job->initaddr=ctx.initaddr;
+            job->playaddr=ctx.playaddr;
+            job->extra=ctx.extra;
+            job->rsid=(ctx.psidh[P_MARKER]=='R');
+            job->ciatiming=ctx.psidh[P_TIMING]&1;
+        }
+        if(hout)
+            fclose(hout);
+        free(orig);
+    }
+    P2SFree(&ctx);
+}
+
+void *P2SWorker(void *arg)
+{
+    P2SQUEUE *queue=arg;
+    P2SJOB *job;
+    for(;;)
+    {
+        pthread_mutex_lock(&queue->lock);
+        if(queue->nextjob>=queue->numjobs)
+        {
+            pthread_mutex_unlock(&queue->lock);
+            break;
+        }
+        job=&queue->jobs[queue->nextjob++];
+        pthread_mutex_unlock(&queue->lock);
+        P2SConvert(job);
+    }
+    return NULL;
+}
+
+int P2SJobCompare(const void *a,const void *b)
+{
+    return strcmp(((const P2SJOB*)a)->prgname,((const P2SJOB*)b)->prgname);
+}
+
+const char *P2SError(int status)
+{
+    static const char *msg[]={"ok","error opening","alloc error","already a .SID","error creating"};
+    return msg[status];
+}
+
+/* s as a quoted CSV field or JSON string */
+void P2SQuote(FILE *h,const char *s,int json)
+{
+    fputc('"',h);
+    for(;*s;s++)
+    {
+        if(json)
+        {
+            if((*s=='"')||(*s=='\\'))
+                fputc('\\',h);
+            if((unsigned char)*s<0x20)
+            {
+                fprintf(h,"\\u%04x",*s);
+                continue;
+            }
+        }
+        else if(*s=='"')
+        {
+            fputc('"',h);
+        }
+        fputc(*s,h);
+    }
+    fputc('"',h);
+}
+
+/* summary in input (name) order, JSON if the name ends in .json, else CSV */
+int P2SSummary(const char *name,P2SJOB *jobs,int numjobs)
+{
+    FILE *h;
+    const char *q;
+    int json,x;
+    P2SJOB *job;
+
+    q=strrchr(name,'.');
+    json=(q!=NULL)&&((strcmp(q,".json")==0)||(strcmp(q,".JSON")==0));
+    h=fopen(name,"w");
+    if(h==NULL)
+    {
+        printf("error creating %s\n",name);
+        return 4;
+    }
+    if(json)
+        fprintf(h,"[\n");
+    else
+        fprintf(h,"prg,sid,status,id,load,init,play,type,timing,patched,extra\n");
+    for(x=0;x<numjobs;x++)
+    {
+        job=&jobs[x];
+        if(json)
+        {
+            fprintf(h,"  {\"prg\": ");
+            P2SQuote(h,job->prgname,1);
+            fprintf(h,", \"sid\": ");
+            P2SQuote(h,job->sidname,1);
+            fprintf(h,", \"status\": ");
+            P2SQuote(h,P2SError(job->status),1);
+            if(job->status==P2S_OK)
+            {
+                fprintf(h,", \"id\": ");
+                P2SQuote(h,job->ids,1);
+                fprintf(h,", \"load\": \"$%04x\", \"init\": \"$%04x\", \"play\": \"$%04x\""
+                    ", \"type\": \"%s\", \"timing\": \"%s\", \"patched\": %d, \"extra\": %d",
+                    job->loadaddr,job->initaddr,job->playaddr,
+                    job->rsid?"RSID":"PSID",job->ciatiming?"CIA":"VBI",job->patched,job->extra);
+            }
+            fprintf(h,"}%s\n",(x<numjobs-1)?",":"");
+        }
+        else
+        {
+            P2SQuote(h,job->prgname,0);
+            fputc(',',h);
+            P2SQuote(h,job->sidname,0);
+            fprintf(h,",%s,",P2SError(job->status));
+            if(job->status==P2S_OK)
+            {
+                P2SQuote(h,job->ids,0);
+                fprintf(h,",$%04x,$%04x,$%04x,%s,%s,%d,%d",
+                    job->loadaddr,job->initaddr,job->playaddr,
+                    job->rsid?"RSID":"PSID",job->ciatiming?"CIA":"VBI",job->patched,job->extra);
+            }
+            else
+            {
+                fprintf(h,",,,,,,,");
+            }
+            fputc('\n',h);
+        }
+    }
+    if(json)
+        fprintf(h,"]\n");
+    fclose(h);
+    return 0;
+}
+
+/* Convert every .prg of a directory, each to its .sid, on a pool of
+   worker threads. A file that fails doesn't stop the others. */
+int P2SBatch(const char *dirname,int workers,const char *summary)
+{
+    P2SQUEUE queue;
+    P2SJOB *jobs=NULL,*more;
+    pthread_t *threads;
+    DIR *dir;
+    struct dirent *entry;
+    int numjobs=0,maxjobs=0,failed=0,started,len,x;
+
+    dir=opendir(dirname);
+    if(dir==NULL)
+    {
+        printf("error opening %s\n",dirname);
+        return 2;
+    }
+    while((entry=readdir(dir))!=NULL)
+    {
+        len=strlen(entry->d_name);
+        if((len<5)||(strlen(dirname)+len+2>MAX_PATH))
+            continue;
+        if((entry->d_name[len-4]!='.')||
+            ((entry->d_name[len-3]&0xdf)!='P')||
+            ((entry->d_name[len-2]&0xdf)!='R')||
+            ((entry->d_name[len-1]&0xdf)!='G'))
+            continue;
+        if(numjobs==maxjobs)
+        {
+            maxjobs=maxjobs?maxjobs*2:256;
+            more=realloc(jobs,maxjobs*sizeof(P2SJOB));
+            if(more==NULL)
+            {
+                printf("alloc error??\n");
+                closedir(dir);
+                free(jobs);
+                return 3;
+            }
+            jobs=more;
+        }
+        memset(&jobs[numjobs],0,sizeof(P2SJOB));
+        sprintf(jobs[numjobs].prgname,"%s/%s",dirname,entry->d_name);
+        numjobs++;
+    }
+    closedir(dir);
+    if(numjobs==0)
+    {
+        printf("no .prg files in %s\n",dirname);
+        free(jobs);
+        return 2;
+    }
+    qsort(jobs,numjobs,sizeof(P2SJOB),P2SJobCompare);
+
+    if(workers<1)
+        workers=1;
+    if(workers>numjobs)
+        workers=numjobs;
+    queue.jobs=jobs;
+    queue.numjobs=numjobs;
+    queue.nextjob=0;
+    pthread_mutex_init(&queue.lock,NULL);
+    threads=malloc(workers*sizeof(pthread_t));
+    started=0;
+    if(threads!=NULL)
+    {
+        while((started<workers)&&(pthread_create(&threads[started],NULL,P2SWorker,&queue)==0))
+            started++;
+    }
+    if(started<workers)
+        printf("started %d of %d worker threads\n",started,workers);
+    if(started==0)
+    {
+        /* no pool, do them here */
+        P2SWorker(&queue);
+    }
+    for(x=0;x<started;x++)
+        pthread_join(threads[x],NULL);
+    free(threads);
+    pthread_mutex_destroy(&queue.lock);
+
+    for(x=0;x<numjobs;x++)
+    {
+        if(jobs[x].status==P2S_OK)
+        {
+            printf("%s: ID=%s Init=$%04x Play=$%04x\n",jobs[x].sidname,jobs[x].ids,jobs[x].initaddr,jobs[x].playaddr);
+        }
+        else
+        {
+            printf("%s: %s\n",jobs[x].prgname,P2SError(jobs[x].status));
+            failed++;
+        }
+    }
+    printf("%d of %d converted, %d failed\n",numjobs-failed,numjobs,failed);
+    x=0;
+    if(summary)
+        x=P2SSummary(summary,jobs,numjobs);
+    free(jobs);
+    return x?x:(failed?1:0);
+}
+
 /*****************************************************************************/
 int main(int argc, char *argv[])
 {
-    char newfile[MAX_PATH],*z,*q, tempstr[40]={0};
-    unsigned char *realp;
-    FILE *h,*hout;
+    char newfile[MAX_PATH],*q, tempstr[40]={0};
+    FILE *hout;
+    P2S ctx;
+    int j,r;
 
     if(argc<2)
     {
@@ -3639,6 +4224,7 @@ int main(int argc, char *argv[])
         "PRG2SID "VERSION" (/) iAN CooG/HVSC\n"
         "Usage: p2s <filename.prg> [load_addr] [6/8] [P/N]"
         " [Title] [Author] [Release] [Songs] [Startsong]\n"
+        "       p2s -dir <directory> [threads] [summary.csv/.json]\n"
         "A filename.sid will be created.\n"
         "Optional parameters\n"
         "load_addr: start ripping from this address ($ or 0x for hex)\n"
@@ -3646,58 +4232,48 @@ int main(int argc, char *argv[])
         "P for PAL  (default) or N for NTSC\n"
         "Title, Author, Release must be 32 chars or less\n"
         "Songs and startsong between 1 (default) and 255\n"
+        "-dir converts every .prg in directory, with threads workers (default 1),\n"
+        "and writes a summary of ids, addresses and patches if a name is given\n"
         );
         return 1;
     }
-    strcpy(newfile,argv[1]);
-    z=strrchr(newfile,'\\');
-    if(z)
-    {
-        q=strrchr(z,'.');
-    }
-    else
+    SigBuild();
+    if(strcmp(argv[1],"-dir")==0)
     {
-        q=strrchr(newfile,'.');
+        if(argc<3)
+        {
+            printf("-dir needs a directory\n");
+            return 1;
+        }
+        return P2SBatch(argv[2],(argc>3)?atoi(argv[3]):1,(argc>4)?argv[4]:NULL);
     }
-    if(q)
-        *q=0;
-    strcat(newfile,".sid");
-    h=fopen(argv[1],"rb");
-    if(h==NULL)
+    P2SSidName(newfile,argv[1]);
+    P2SInit(&ctx);
+    r=P2SLoad(&ctx,argv[1]);
+    if(r==P2S_EOPEN)
     {
         printf("error opening %s\n",argv[1]);
-        return 2;
+        return p2sexit[r];
     }
-    fseek(h,0,SEEK_END);
-    fsiz=ftell(h);
-    fseek(h,0,SEEK_SET);
-    realp=calloc(fsiz,1);
-    p=realp;
-    if(realp==NULL)
+    if(r==P2S_ENOMEM)
     {
         printf("alloc error??\n");
-        fclose(h);
-        return 3;
+        P2SFree(&ctx);
+        return p2sexit[r];
     }
-    fread(p,fsiz,1,h);
-    fclose(h);
-    if(((p[P_MARKER+0]==psidh[P_MARKER+0])||(p[P_MARKER+0]=='R')) &&
-        (p[P_MARKER+1]==psidh[P_MARKER+1]) &&
-        (p[P_MARKER+2]==psidh[P_MARKER+2]) &&
-        (p[P_MARKER+3]==psidh[P_MARKER+3]))
+    if(r==P2S_ISSID)
     {
         printf("%s is already a .SID\n",argv[1]);
-        free(realp);
-        return 2;
+        P2SFree(&ctx);
+        return p2sexit[r];
     }
     hout=fopen(newfile,"wb");
     if(hout==NULL)
     {
-        free(realp);
+        P2SFree(&ctx);
         printf("error creating %s\n",newfile);
-        return 4;
+        return p2sexit[P2S_ECREATE];
     }
-    loadaddr=p[0]|p[1]<<8;
     if( (argc>2) && (strlen(argv[2])>2) )
     {
         j=0;
@@ -3707,32 +4283,24 @@ int main(int argc, char *argv[])
             j=strtol(argv[2]+2,&q,16);
         else
             j=strtol(argv[2],&q,10);
-        if((j>loadaddr) && (j<(loadaddr+fsiz-2)))
-        {
-            k=j-loadaddr;
-            p+=k;
-            fsiz-=k;
-            loadaddr=j;
-            p[0]=j&0xff;
-            p[1]=j>>8;
-        }
+        P2SSkipTo(&ctx,j);
     }
     if( (argc>3) && (strlen(argv[3])>0) )
     {
         if(argv[3][0]=='8')
         {
-            j=psidh[P_SIDMODEL]&0x0f;
+            j=ctx.psidh[P_SIDMODEL]&0x0f;
             j|=0x20;
-            psidh[P_SIDMODEL]=j;
+            ctx.psidh[P_SIDMODEL]=j;
         }
     }
     if( (argc>4) && (strlen(argv[4])>0) )
     {
         if((argv[4][0]&0x5f)=='N')
         {
-            j=psidh[P_SIDMODEL]&0xf0;
+            j=ctx.psidh[P_SIDMODEL]&0xf0;
             j|=0x8;
-            psidh[P_SIDMODEL]=j;
+            ctx.psidh[P_SIDMODEL]=j;
         }
     }
     if( (argc>5) && (strlen(argv[5])>0) ) /* idea by Wisdom/Crescent */
@@ -3740,28 +4308,28 @@ int main(int argc, char *argv[])
         memset(tempstr,0,sizeof(tempstr));
         strncpy(tempstr,argv[5],32);
         printf("Title   : %s\n", tempstr);
-        memcpy(psidh+P_NAME, tempstr, 32);
+        memcpy(ctx.psidh+P_NAME, tempstr, 32);
     }
     if( (argc>6) && (strlen(argv[6])>0) )
     {
         memset(tempstr,0,sizeof(tempstr));
         strncpy(tempstr,argv[6],32);
         printf("Author  : %s\n", tempstr);
-        memcpy(psidh+P_AUTHOR, tempstr, 32);
+        memcpy(ctx.psidh+P_AUTHOR, tempstr, 32);
     }
     if( (argc>7) && (strlen(argv[7])>0) )
     {
         memset(tempstr,0,sizeof(tempstr));
         strncpy(tempstr,argv[7],32);
         printf("Released: %s\n", tempstr);
-        memcpy(psidh+P_RELEASED, tempstr, 32);
+        memcpy(ctx.psidh+P_RELEASED, tempstr, 32);
     }
     if( (argc>8) && (strlen(argv[8])>0) )
     {
         j=strtol(argv[8],&q,10);
         if((j>0) && (j<256))
         {
-            psidh[P_SUBTUNES]=j&0xff;
+            ctx.psidh[P_SUBTUNES]=j&0xff;
             printf("Subtunes: %d\n", j);
         }
     }
@@ -3770,41 +4338,14 @@ int main(int argc, char *argv[])
         j=strtol(argv[9],&q,10);
         if((j>0) && (j<256))
         {
-            psidh[P_STARTSNG]=j&0xff;
+            ctx.psidh[P_STARTSNG]=j&0xff;
             printf("StartSng: %d\n", j);
         }
     }
-    /* default for classic 1000/1003 */
-    initaddr=loadaddr;
-    playaddr=initaddr+3;
-    /* briefly id some particular players */
-    Scanners();
-    printf("%s: ID=%s Init=$%04x Play=$%04x\n",newfile,ids,initaddr,playaddr);
-    psidh[P_INITADDR+0]=initaddr>>8;
-    psidh[P_INITADDR+1]=initaddr&0xff;
-    psidh[P_PLAYADDR+0]=playaddr>>8;
-    psidh[P_PLAYADDR+1]=playaddr&0xff;
-    fwrite(psidh,sizeof(psidh),1,hout);
-    if(extra)
-    {
-        fwrite(extrabytes,extra,1,hout);
-        if(extra==1)
-        {
-            loadaddr=extrabytes[0]|p[0]<<8;
-        }
-        else
-        {
-            loadaddr=extrabytes[0]|extrabytes[1]<<8;
-        }
-    }
-
-    j=fsiz+loadaddr+extra-2;
-    if (j>0xffff)
-    {
-        fsiz-=(j-0x10000);
-    }
-    fwrite(p,fsiz,1,hout);
+    P2SIdentify(&ctx);
+    printf("%s: ID=%s Init=$%04x Play=$%04x\n",newfile,ctx.ids,ctx.initaddr,ctx.playaddr);
+    P2SWrite(&ctx,hout);
     fclose(hout);
-    free(realp);
+    P2SFree(&ctx);
     return 0;
 }
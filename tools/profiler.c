@@ -0,0 +1,325 @@
+#include <stdlib.h>
+#include <string.h>
+#include "profiler.h"
+
+typedef struct
+{
+  unsigned address;
+  unsigned long long key;
+} PROFILEENTRY;
+
+PROFILER *profiler_create(void)
+{
+  PROFILER *prof = calloc(1, sizeof *prof);
+
+  if (!prof) return NULL;
+  prof->tablesize = 1024;
+  prof->stacks = calloc(prof->tablesize, sizeof(PROFILESTACK));
+  if (!prof->stacks)
+  {
+    free(prof);
+    return NULL;
+  }
+  prof->maxframe = -1;
+  return prof;
+}
+
+void profiler_free(PROFILER *prof)
+{
+  if (!prof) return;
+  free(prof->stacks);
+  free(prof);
+}
+
+static PROFILESTACK *findstack(PROFILESTACK *table, unsigned tablesize, unsigned long long hash, const unsigned short *stack, int depth)
+{
+  unsigned mask = tablesize - 1;
+  unsigned slot = (unsigned)(hash ^ (hash >> 32)) & mask;
+
+  while (table[slot].depth)
+  {
+    if ((table[slot].hash == hash) && (table[slot].depth == depth) &&
+      (!memcmp(table[slot].stack, stack, depth * sizeof *stack)))
+      break;
+    slot = (slot + 1) & mask;
+  }
+  return &table[slot];
+}
+
+// Entry of the current call stack, created on first use. Falls back to the
+// previous entry if the table can't grow.
+static PROFILESTACK *lookupstack(PROFILER *prof)
+{
+  unsigned long long hash = 0xcbf29ce484222325ULL;
+  PROFILESTACK *entry;
+  int c;
+
+  for (c = 0; c < prof->depth; c++)
+  {
+    hash ^= prof->stack[c];
+    hash *= 0x100000001b3ULL;
+  }
+  entry = findstack(prof->stacks, prof->tablesize, hash, prof->stack, prof->depth);
+  if (entry->depth) return entry;
+
+  if ((prof->numstacks + 1) * 2 > prof->tablesize)
+  {
+    unsigned newsize = prof->tablesize * 2;
+    PROFILESTACK *newtable = calloc(newsize, sizeof(PROFILESTACK));
+    unsigned s;
+
+    if (!newtable) return prof->current;
+    for (s = 0; s < prof->tablesize; s++)
+    {
+      if (prof->stacks[s].depth)
+        *findstack(newtable, newsize, prof->stacks[s].hash, prof->stacks[s].stack, prof->stacks[s].depth) = prof->stacks[s];
+    }
+    free(prof->stacks);
+    prof->stacks = newtable;
+    prof->tablesize = newsize;
+    entry = findstack(prof->stacks, prof->tablesize, hash, prof->stack, prof->depth);
+  }
+  entry->hash = hash;
+  entry->depth = prof->depth;
+  memcpy(entry->stack, prof->stack, prof->depth * sizeof *prof->stack);
+  prof->numstacks++;
+  return entry;
+}
+
+// returnsp is the stack pointer the call's RTS will leave behind
+static void pushcall(PROFILER *prof, unsigned short address, unsigned char returnsp)
+{
+  prof->calls[address]++;
+  if (prof->depth + prof->overflow == PROFILE_MAXCALLS) return;
+  prof->returnsp[prof->depth + prof->overflow] = returnsp;
+  if (prof->depth == PROFILE_MAXDEPTH)
+  {
+    prof->overflow++;
+    return;
+  }
+  prof->stack[prof->depth] = address;
+  prof->entered[prof->depth] = prof->total;
+  prof->depth++;
+  prof->current = lookupstack(prof);
+}
+
+// Unwind to the innermost call returning to this stack pointer, calls it
+// skips left through stack tricks. The play address itself is never left.
+static void popcall(PROFILER *prof, unsigned char sp)
+{
+  int level = prof->depth + prof->overflow;
+
+  while ((--level > 0) && (prof->returnsp[level] != sp))
+    ;
+  if (level <= 0) return;
+  if (level >= prof->depth)
+  {
+    prof->overflow = level - prof->depth;
+    return;
+  }
+  prof->overflow = 0;
+  while (prof->depth > level)
+  {
+    prof->depth--;
+    prof->inclcycles[prof->stack[prof->depth]] += prof->total - prof->entered[prof->depth];
+  }
+  prof->current = lookupstack(prof);
+}
+
+// Charge the previous instruction with the cycles it took
+static void account(PROFILER *prof, const CPUCONTEXT *ctx)
+{
+  unsigned cycles = ctx->cpucycles - prof->lastcycles;
+
+  prof->pccount[prof->lastpc]++;
+  prof->pccycles[prof->lastpc] += cycles;
+  prof->selfcycles[prof->overflow ? prof->stack[PROFILE_MAXDEPTH - 1] : prof->stack[prof->depth - 1]] += cycles;
+  if (prof->current) prof->current->cycles += cycles;
+  prof->total += cycles;
+  prof->lastcycles = ctx->cpucycles;
+}
+
+void profiler_beginframe(PROFILER *prof, unsigned short playaddress)
+{
+  prof->depth = 0;
+  prof->overflow = 0;
+  prof->running = 0;
+  prof->lastcycles = 0;
+  prof->framestart = prof->total;
+  pushcall(prof, playaddress, 0);
+}
+
+// CPUOBSERVER exec callback, user is the PROFILER
+void profiler_exec(void *user, const CPUCONTEXT *ctx, unsigned short address)
+{
+  PROFILER *prof = user;
+
+  if (prof->running)
+  {
+    account(prof, ctx);
+    if (prof->lastop == 0x20) pushcall(prof, address, ctx->sp + 2);
+    else if (prof->lastop == 0x60) popcall(prof, ctx->sp);
+  }
+  prof->running = 1;
+  prof->lastpc = address;
+  prof->lastop = ctx->mem[address];
+}
+
+// Account the last instruction of the play call and unwind the stack
+void profiler_endframe(PROFILER *prof, const CPUCONTEXT *ctx, int frame)
+{
+  unsigned framecycles;
+
+  if (prof->running) account(prof, ctx);
+  prof->running = 0;
+  prof->overflow = 0;
+  while (prof->depth > 0)
+  {
+    prof->depth--;
+    prof->inclcycles[prof->stack[prof->depth]] += prof->total - prof->entered[prof->depth];
+  }
+  prof->current = NULL;
+  framecycles = prof->total - prof->framestart;
+  if ((prof->maxframe < 0) || (framecycles > prof->maxframecycles))
+  {
+    prof->maxframecycles = framecycles;
+    prof->maxframe = frame;
+  }
+  prof->frames++;
+}
+
+static int compareentries(const void *a, const void *b)
+{
+  const PROFILEENTRY *ea = a;
+  const PROFILEENTRY *eb = b;
+
+  if (ea->key != eb->key) return (ea->key < eb->key) ? 1 : -1;
+  return (int)ea->address - (int)eb->address;
+}
+
+// Addresses with a nonzero key, sorted by key, descending. NULL if out of memory.
+static PROFILEENTRY *sortedentries(const unsigned long long *keys, int *count)
+{
+  PROFILEENTRY *entries = malloc(0x10000 * sizeof *entries);
+  int c;
+
+  *count = 0;
+  if (!entries) return NULL;
+  for (c = 0; c < 0x10000; c++)
+  {
+    if (keys[c])
+    {
+      entries[*count].address = c;
+      entries[*count].key = keys[c];
+      (*count)++;
+    }
+  }
+  qsort(entries, *count, sizeof *entries, compareentries);
+  return entries;
+}
+
+static double share(unsigned long long part, unsigned long long total)
+{
+  return total ? (double)part * 100.0 / total : 0.0;
+}
+
+// Hot-spot report: the top routines and instruction addresses by cycles
+void profiler_report(const PROFILER *prof, FILE *out, int top)
+{
+  PROFILEENTRY *entries;
+  int count;
+  int c;
+
+  fprintf(out, "\nProfile: %u frames, %llu cycles, average %llu per frame, maximum %u at frame %d\n",
+    prof->frames, prof->total, prof->frames ? prof->total / prof->frames : 0, prof->maxframecycles, prof->maxframe);
+
+  entries = sortedentries(prof->inclcycles, &count);
+  if (!entries) return;
+  fprintf(out, "\nRoutines by cycles including callees:\n");
+  fprintf(out, " Addr     Calls     Inclusive      %%          Self      %%\n");
+  for (c = 0; (c < count) && (c < top); c++)
+  {
+    unsigned a = entries[c].address;
+
+    fprintf(out, " $%04X %9u %13llu %6.2f %13llu %6.2f\n", a, prof->calls[a],
+      prof->inclcycles[a], share(prof->inclcycles[a], prof->total),
+      prof->selfcycles[a], share(prof->selfcycles[a], prof->total));
+  }
+  free(entries);
+
+  entries = sortedentries(prof->pccycles, &count);
+  if (!entries) return;
+  fprintf(out, "\nHot spots by instruction address:\n");
+  fprintf(out, " Addr  Executed        Cycles      %%\n");
+  for (c = 0; (c < count) && (c < top); c++)
+  {
+    unsigned a = entries[c].address;
+
+    fprintf(out, " $%04X %9u %13llu %6.2f\n", a, prof->pccount[a], prof->pccycles[a], share(prof->pccycles[a], prof->total));
+  }
+  free(entries);
+}
+
+static int writejson(const PROFILER *prof, FILE *out)
+{
+  int first = 1;
+  int c;
+
+  fprintf(out, "{\"frames\": %u, \"cycles\": %llu, \"max_frame_cycles\": %u, \"max_frame\": %d,\n \"routines\": [",
+    prof->frames, prof->total, prof->maxframecycles, prof->maxframe);
+  for (c = 0; c < 0x10000; c++)
+  {
+    if (!prof->calls[c]) continue;
+    fprintf(out, "%s\n  {\"address\": %d, \"calls\": %u, \"inclusive\": %llu, \"self\": %llu}", first ? "" : ",",
+      c, prof->calls[c], prof->inclcycles[c], prof->selfcycles[c]);
+    first = 0;
+  }
+  fprintf(out, "],\n \"pcs\": [");
+  first = 1;
+  for (c = 0; c < 0x10000; c++)
+  {
+    if (!prof->pccount[c]) continue;
+    fprintf(out, "%s\n  {\"pc\": %d, \"executed\": %u, \"cycles\": %llu}", first ? "" : ",",
+      c, prof->pccount[c], prof->pccycles[c]);
+    first = 0;
+  }
+  fprintf(out, "]}\n");
+  return 0;
+}
+
+// One "addr;addr;addr cycles" line per call stack, for flamegraph.pl and
+// compatible viewers
+static int writefolded(const PROFILER *prof, FILE *out)
+{
+  unsigned s;
+  int c;
+
+  for (s = 0; s < prof->tablesize; s++)
+  {
+    const PROFILESTACK *entry = &prof->stacks[s];
+
+    if ((!entry->depth) || (!entry->cycles)) continue;
+    for (c = 0; c < entry->depth; c++)
+      fprintf(out, "%s%04X", c ? ";" : "", entry->stack[c]);
+    fprintf(out, " %llu\n", entry->cycles);
+  }
+  return 0;
+}
+
+// Write the profile to a file: JSON if the name ends in .json, otherwise
+// folded stacks. Returns 0 on success.
+int profiler_write(const PROFILER *prof, const char *filename)
+{
+  int len = strlen(filename);
+  FILE *out = fopen(filename, "w");
+  int result;
+
+  if (!out) return 1;
+  if ((len > 5) && (!strcmp(&filename[len - 5], ".json")))
+    result = writejson(prof, out);
+  else
+    result = writefolded(prof, out);
+  if (ferror(out)) result = 1;
+  if (fclose(out)) result = 1;
+  return result;
+}
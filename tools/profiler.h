@@ -0,0 +1,69 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdio.h>
+#include "cpu.h"
+
+// Playroutine profiler, fed by a CPUOBSERVER exec callback. Cycles are
+// counted per instruction address and per routine: a shadow call stack
+// follows JSR/RTS, so every routine (JSR target, plus the play address
+// itself) gets its own cycles, its cycles including callees, and call
+// counts. Cycles per distinct call stack are kept for flamegraphs.
+//
+// Each call remembers the stack pointer its RTS returns to. An RTS unwinds
+// to the call with that stack pointer and one matching no call (PHA/PHA/RTS
+// jump dispatch) is ignored.
+
+#define PROFILE_MAXDEPTH 32
+// The 6502 stack holds at most 128 return addresses
+#define PROFILE_MAXCALLS 128
+
+typedef struct
+{
+  unsigned long long hash;
+  unsigned long long cycles;
+  int depth;
+  unsigned short stack[PROFILE_MAXDEPTH];
+} PROFILESTACK;
+
+typedef struct
+{
+  unsigned pccount[0x10000];
+  unsigned long long pccycles[0x10000];
+  unsigned calls[0x10000];
+  unsigned long long selfcycles[0x10000];
+  unsigned long long inclcycles[0x10000];
+
+  // Shadow call stack of the current play call
+  unsigned short stack[PROFILE_MAXDEPTH];
+  unsigned long long entered[PROFILE_MAXDEPTH];
+  unsigned char returnsp[PROFILE_MAXCALLS];
+  int depth;
+  int overflow;
+  PROFILESTACK *current;
+
+  // Distinct call stacks, open addressing on their hash
+  PROFILESTACK *stacks;
+  unsigned numstacks;
+  unsigned tablesize;
+
+  unsigned short lastpc;
+  unsigned char lastop;
+  unsigned lastcycles;
+  int running;
+  unsigned long long total;
+  unsigned frames;
+  unsigned maxframecycles;
+  int maxframe;
+  unsigned long long framestart;
+} PROFILER;
+
+PROFILER *profiler_create(void);
+void profiler_free(PROFILER *prof);
+void profiler_beginframe(PROFILER *prof, unsigned short playaddress);
+void profiler_exec(void *user, const CPUCONTEXT *ctx, unsigned short address);
+void profiler_endframe(PROFILER *prof, const CPUCONTEXT *ctx, int frame);
+void profiler_report(const PROFILER *prof, FILE *out, int top);
+int profiler_write(const PROFILER *prof, const char *filename);
+
+#endif
@@ -8,9 +8,11 @@
  * License: Same as SID Factory II (GPL)
  */
 
+#include "sf2file.h"
+#include "sidfile.h"
 #include <iostream>
-#include <fstream>
 #include <cstring>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
@@ -50,75 +52,51 @@ void copy_string(const std::string& src, char* dest, size_t size) {
     }
 }
 
-// Read entire file into memory
-std::vector<unsigned char> read_file(const std::string& filename) {
-    std::ifstream file(filename, std::ios::binary);
-    if (!file) {
-        throw std::runtime_error("Cannot open file: " + filename);
+// Map a file into memory (sidfile.h), unmapped on destruction
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& filename) {
+        if (sidfile_map(filename.c_str(), &map_)) {
+            throw std::runtime_error("Cannot open file: " + filename);
+        }
     }
+    ~MappedFile() {
+        sidfile_unmap(&map_);
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
 
-    file.seekg(0, std::ios::end);
-    size_t size = file.tellg();
-    file.seekg(0, std::ios::beg);
-
-    std::vector<unsigned char> data(size);
-    file.read(reinterpret_cast<char*>(data.data()), size);
+    const unsigned char* data() const { return map_.data; }
+    size_t size() const { return map_.size; }
 
-    return data;
-}
+private:
+    SIDFILEMAP map_;
+};
 
-// Write binary data to file
-void write_file(const std::string& filename, const unsigned char* data, size_t size) {
-    std::ofstream file(filename, std::ios::binary);
-    if (!file) {
+// Write header and payload to file in one gathered write
+void write_file(const std::string& filename, const void* header, size_t header_size,
+                const unsigned char* data, size_t size) {
+    if (sidfile_write(filename.c_str(), header, header_size, data, size)) {
         throw std::runtime_error("Cannot write file: " + filename);
     }
-
-    file.write(reinterpret_cast<const char*>(data), size);
 }
 
-// Extract metadata strings from SF2 auxiliary data section
-void extract_metadata(const std::vector<unsigned char>& data,
-                     std::string& title, std::string& author, std::string& copyright) {
-    // SF2 files store metadata as null-terminated strings near the end
-    // Search last 512 bytes for printable strings
-    size_t search_start = (data.size() > 512) ? (data.size() - 512) : 0;
-
-    std::vector<std::string> strings;
-    std::string current;
-
-    for (size_t i = search_start; i < data.size(); ++i) {
-        unsigned char c = data[i];
-
-        if (c == 0) {
-            if (current.length() > 3) {  // Reasonable string length
-                strings.push_back(current);
-            }
-            current.clear();
-        } else if (c >= 0x20 && c <= 0x7E) {  // Printable ASCII
-            current += static_cast<char>(c);
-        } else {
-            current.clear();  // Reset on non-printable
-        }
-    }
-
-    // Take last 3 strings as title/author/copyright
-    if (strings.size() >= 3) {
-        title = strings[strings.size() - 3];
-        author = strings[strings.size() - 2];
-        copyright = strings[strings.size() - 1];
-    } else if (strings.size() >= 2) {
-        title = strings[strings.size() - 2];
-        author = strings[strings.size() - 1];
-    } else if (strings.size() >= 1) {
-        title = strings[strings.size() - 1];
-    }
-}
+// Export options. The entry points come from the SF2 header unless
+// offsets are given; offsets are from the load address.
+struct ExportOptions {
+    bool offsets = false;
+    unsigned short init_offset = 0;
+    unsigned short play_offset = 3;
+    std::string title;
+    std::string author;
+    std::string copyright;
+    bool verbose = false;
+};
 
 // Convert SF2 file to PSID format
 void convert_sf2_to_psid(const std::string& sf2_path, const std::string& sid_path,
-                        unsigned short init_offset, unsigned short play_offset,
-                        bool verbose) {
+                        const ExportOptions& options) {
+    const bool verbose = options.verbose;
     if (verbose) {
         std::cout << "SF2Export v1.0 - SF2 to PSID Converter\n";
         std::cout << "======================================\n";
@@ -127,24 +105,54 @@ void convert_sf2_to_psid(const std::string& sf2_path, const std::string& sid_pat
     }
 
     // Read SF2 file (PRG format: first 2 bytes are load address)
-    std::vector<unsigned char> sf2_data = read_file(sf2_path);
+    MappedFile sf2_data(sf2_path);
 
     if (sf2_data.size() < 2) {
         throw std::runtime_error("SF2 file too small");
     }
 
     // Extract load address (little-endian)
-    unsigned short driver_address = static_cast<unsigned short>(sf2_data[0]) |
-                                   (static_cast<unsigned short>(sf2_data[1]) << 8);
+    unsigned short driver_address = static_cast<unsigned short>(sf2_data.data()[0]) |
+                                   (static_cast<unsigned short>(sf2_data.data()[1]) << 8);
+
+    // Index the SF2 header (sf2file.h). A PRG without one only plays with
+    // offsets for its driver.
+    SF2INDEX index;
+    int result = sf2file_index(sf2_data.data(), sf2_data.size(), &index);
+    if (result != SF2FILE_OK && result != SF2FILE_NOTSF2) {
+        throw std::runtime_error(std::string(sf2file_error(result)) + ": " + sf2_path);
+    }
 
-    // Extract metadata
-    std::string title, author, copyright;
-    extract_metadata(sf2_data, title, author, copyright);
+    unsigned short init_address = driver_address + options.init_offset;
+    unsigned short play_address = driver_address + options.play_offset;
+    if (result == SF2FILE_OK && !options.offsets) {
+        init_address = static_cast<unsigned short>(index.initaddress);
+        play_address = static_cast<unsigned short>(index.updateaddress);
+    }
+
+    // Title from the options or the SF2's first song name; the SF2 has no
+    // author or copyright
+    std::string title = options.title;
+    if (title.empty() && result == SF2FILE_OK) {
+        char name[33];
+        if (sf2file_songname(&index, 0, name, sizeof(name)) == 0) {
+            title = name;
+        }
+    }
+    const std::string& author = options.author;
+    const std::string& copyright = options.copyright;
 
     if (verbose) {
         std::cout << "\nSF2 Analysis:\n";
         std::cout << "  Load address: $" << std::hex << driver_address << std::dec << "\n";
         std::cout << "  Data size:    " << (sf2_data.size() - 2) << " bytes\n";
+        if (result == SF2FILE_OK) {
+            std::cout << "  Driver:       " << std::hex << "code $" << index.codetop << " - $"
+                      << (index.codetop + index.codesize) << ", init $" << index.initaddress
+                      << ", play $" << index.updateaddress << std::dec << "\n";
+        } else {
+            std::cout << "  Driver:       no SF2 header\n";
+        }
         if (!title.empty())
             std::cout << "  Title:        " << title << "\n";
         if (!author.empty())
@@ -165,8 +173,8 @@ void convert_sf2_to_psid(const std::string& sf2_path, const std::string& sid_pat
     header.version = endian_convert(0x0002);
     header.data_offset = endian_convert(0x007C);  // 124 bytes
     header.load_address = 0x0000;  // Use PRG address
-    header.init_address = endian_convert(driver_address + init_offset);
-    header.play_address = endian_convert(driver_address + play_offset);
+    header.init_address = endian_convert(init_address);
+    header.play_address = endian_convert(play_address);
     header.song_count = endian_convert(1);
     header.default_song = endian_convert(1);
     header.speed_flags = 0;  // 50Hz PAL
@@ -183,20 +191,14 @@ void convert_sf2_to_psid(const std::string& sf2_path, const std::string& sid_pat
     header.second_sid = 0;
     header.third_sid = 0;
 
-    // Build PSID file: [header][PRG data]
+    // Write PSID file: [header][PRG data], the PRG data straight from the input mapping
     size_t psid_size = sizeof(header) + sf2_data.size();
-    std::vector<unsigned char> psid_data(psid_size);
-
-    memcpy(psid_data.data(), &header, sizeof(header));
-    memcpy(psid_data.data() + sizeof(header), sf2_data.data(), sf2_data.size());
-
-    // Write PSID file
-    write_file(sid_path, psid_data.data(), psid_size);
+    write_file(sid_path, &header, sizeof(header), sf2_data.data(), sf2_data.size());
 
     if (verbose) {
         std::cout << "\nPSID Export:\n";
-        std::cout << "  Init address: $" << std::hex << (driver_address + init_offset) << std::dec << "\n";
-        std::cout << "  Play address: $" << std::hex << (driver_address + play_offset) << std::dec << "\n";
+        std::cout << "  Init address: $" << std::hex << init_address << std::dec << "\n";
+        std::cout << "  Play address: $" << std::hex << play_address << std::dec << "\n";
         std::cout << "  Total size:   " << psid_size << " bytes\n";
         std::cout << "\nConversion complete!\n";
     }
@@ -208,10 +210,14 @@ int main(int argc, char* argv[]) {
         if (argc < 3) {
             std::cerr << "Usage: sf2export <input.sf2> <output.sid> [options]\n";
             std::cerr << "\nOptions:\n";
-            std::cerr << "  --driver11       Driver 11 offsets (init=0, play=3) [default]\n";
+            std::cerr << "  --driver11       Driver 11 offsets (init=0, play=3)\n";
             std::cerr << "  --np20           NewPlayer 20 offsets (init=0, play=161)\n";
             std::cerr << "  --init <offset>  Custom init offset (hex or decimal)\n";
             std::cerr << "  --play <offset>  Custom play offset (hex or decimal)\n";
+            std::cerr << "                   (default: init and play from the SF2 header)\n";
+            std::cerr << "  --title <text>   Title (default: the SF2's song name)\n";
+            std::cerr << "  --author <text>  Author\n";
+            std::cerr << "  --copyright <text>  Copyright\n";
             std::cerr << "  -v, --verbose    Verbose output\n";
             std::cerr << "\nExample:\n";
             std::cerr << "  sf2export Angular.sf2 Angular_converted.sid\n";
@@ -222,27 +228,34 @@ int main(int argc, char* argv[]) {
         std::string sf2_path = argv[1];
         std::string sid_path = argv[2];
 
-        // Default: Driver 11 offsets
-        unsigned short init_offset = 0;
-        unsigned short play_offset = 3;
-        bool verbose = false;
+        ExportOptions options;
 
         // Parse options
         for (int i = 3; i < argc; ++i) {
             std::string arg = argv[i];
 
             if (arg == "--driver11") {
-                init_offset = 0;
-                play_offset = 3;
+                options.offsets = true;
+                options.init_offset = 0;
+                options.play_offset = 3;
             } else if (arg == "--np20") {
-                init_offset = 0;
-                play_offset = 0xA1;  // 161 decimal
+                options.offsets = true;
+                options.init_offset = 0;
+                options.play_offset = 0xA1;  // 161 decimal
             } else if (arg == "--init" && i + 1 < argc) {
-                init_offset = static_cast<unsigned short>(std::stoul(argv[++i], nullptr, 0));
+                options.offsets = true;
+                options.init_offset = static_cast<unsigned short>(std::stoul(argv[++i], nullptr, 0));
             } else if (arg == "--play" && i + 1 < argc) {
-                play_offset = static_cast<unsigned short>(std::stoul(argv[++i], nullptr, 0));
+                options.offsets = true;
+                options.play_offset = static_cast<unsigned short>(std::stoul(argv[++i], nullptr, 0));
+            } else if (arg == "--title" && i + 1 < argc) {
+                options.title = argv[++i];
+            } else if (arg == "--author" && i + 1 < argc) {
+                options.author = argv[++i];
+            } else if (arg == "--copyright" && i + 1 < argc) {
+                options.copyright = argv[++i];
             } else if (arg == "-v" || arg == "--verbose") {
-                verbose = true;
+                options.verbose = true;
             } else {
                 std::cerr << "Unknown option: " << arg << "\n";
                 return 1;
@@ -250,7 +263,7 @@ int main(int argc, char* argv[]) {
         }
 
         // Perform conversion
-        convert_sf2_to_psid(sf2_path, sid_path, init_offset, play_offset, verbose);
+        convert_sf2_to_psid(sf2_path, sid_path, options);
 
         return 0;
 
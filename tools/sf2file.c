@@ -0,0 +1,215 @@
+#include <string.h>
+#include "sf2file.h"
+
+static unsigned word(const unsigned char *p)
+{
+  return p[0] | (p[1] << 8);
+}
+
+// Descriptor body: [u8 type][u16 size][name, 0][u16 code top][u16 code size]
+// [u8 major][u8 minor]...
+static void indexdescriptor(SF2INDEX *index, const SF2BLOCK *block)
+{
+  const unsigned char *end;
+  const unsigned char *name;
+
+  if (block->size < 4) return;
+  index->drivertype = block->data[0];
+  index->driversize = word(block->data + 1);
+  name = block->data + 3;
+  end = memchr(name, 0, block->size - 3);
+  if (!end) return;
+  index->drivername = name;
+  index->drivernamelength = (unsigned)(end - name);
+  if ((size_t)(end + 1 - block->data) + 6 > block->size) return;
+  index->codetop = word(end + 1);
+  index->codesize = word(end + 3);
+  index->versionmajor = end[5];
+  index->versionminor = end[6];
+}
+
+// Driver tables body: per table [u8 type][u8 id][u8 text size][name, 0]
+// [u8 layout][u8 flags][3 bytes rules][u16 address][u16 columns][u16 rows]
+// [u8 visible rows], up to type $FF
+static void indexdrivertables(SF2INDEX *index, const SF2BLOCK *block)
+{
+  const unsigned char *p = block->data;
+  const unsigned char *end = block->data + block->size;
+
+  while ((p + 3 <= end) && (*p != 0xff) && (index->numtables < SF2FILE_MAXTABLES))
+  {
+    SF2TABLE *table = &index->tables[index->numtables];
+    const unsigned char *nameend = memchr(p + 3, 0, end - (p + 3));
+
+    if ((!nameend) || (nameend + 13 > end)) break;
+    table->type = p[0];
+    table->id = p[1];
+    table->name = p + 3;
+    table->namelength = (unsigned)(nameend - (p + 3));
+    table->layout = nameend[1];
+    table->flags = nameend[2];
+    table->address = word(nameend + 6);
+    table->columns = word(nameend + 8);
+    table->rows = word(nameend + 10);
+    index->numtables++;
+    p = nameend + 13;
+  }
+}
+
+// Music data body: [u8 tracks][u16 orderlist low][u16 orderlist high]
+// [u8 sequences][u16 sequence low][u16 sequence high]...
+static void indexmusicdata(SF2INDEX *index, const SF2BLOCK *block)
+{
+  if (block->size < 10) return;
+  index->numtracks = block->data[0];
+  index->orderlistlow = word(block->data + 1);
+  index->orderlisthigh = word(block->data + 3);
+  index->numsequences = block->data[5];
+  index->sequencelow = word(block->data + 6);
+  index->sequencehigh = word(block->data + 8);
+}
+
+// Auxiliary chain through the $0FFB pointer. The pointer is only set by
+// the editor, so a chain that doesn't parse is ignored rather than an error.
+static void indexaux(SF2INDEX *index)
+{
+  unsigned address;
+  const unsigned char *p;
+  const unsigned char *end = index->image + (index->endaddress - index->loadaddress);
+
+  if ((SF2FILE_AUXPOINTER < index->loadaddress) || (SF2FILE_AUXPOINTER + 2 > index->endaddress)) return;
+  address = word(index->image + (SF2FILE_AUXPOINTER - index->loadaddress));
+  if ((address < index->loadaddress) || (address >= index->endaddress)) return;
+
+  p = index->image + (address - index->loadaddress);
+  while (p + 5 <= end)
+  {
+    SF2AUXBLOCK *block;
+    unsigned size = word(p + 3);
+
+    if (!p[0])
+    {
+      index->auxaddress = address;
+      index->auxend = index->loadaddress + (unsigned)(p + 5 - index->image);
+      return;
+    }
+    if ((p[0] > SF2AUX_SONGS) || (index->numaux == SF2FILE_MAXAUX) || (p + 5 + size > end)) break;
+    block = &index->aux[index->numaux++];
+    block->id = p[0];
+    block->version = word(p + 1);
+    block->address = index->loadaddress + (unsigned)(p + 5 - index->image);
+    block->size = size;
+    block->data = p + 5;
+    p += 5 + size;
+  }
+  index->numaux = 0;
+}
+
+int sf2file_index(const unsigned char *prg, size_t size, SF2INDEX *index)
+{
+  const unsigned char *p;
+  const unsigned char *end = prg + size;
+  const SF2BLOCK *block;
+
+  memset(index, 0, sizeof *index);
+  if ((size < 4) || (word(prg + 2) != SF2FILE_ID)) return SF2FILE_NOTSF2;
+  index->loadaddress = word(prg);
+  if (index->loadaddress + (size - 2) > 0x10000) return SF2FILE_TRUNCATED;
+  index->endaddress = index->loadaddress + (unsigned)(size - 2);
+  index->image = prg + 2;
+
+  p = prg + 4;
+  for (;;)
+  {
+    SF2BLOCK *b;
+
+    if (p >= end) return SF2FILE_TRUNCATED;
+    if (*p == SF2BLOCK_END) break;
+    if ((p + 2 > end) || (p + 2 + p[1] > end)) return SF2FILE_TRUNCATED;
+    if (index->numblocks == SF2FILE_MAXBLOCKS) return SF2FILE_TRUNCATED;
+    b = &index->blocks[index->numblocks++];
+    b->id = p[0];
+    b->size = p[1];
+    b->data = p + 2;
+    b->address = index->loadaddress + (unsigned)(p + 2 - index->image);
+    p += 2 + p[1];
+  }
+
+  if ((block = sf2file_block(index, SF2BLOCK_DESCRIPTOR)) != NULL) indexdescriptor(index, block);
+  if ((block = sf2file_block(index, SF2BLOCK_DRIVERCOMMON)) != NULL && (block->size >= 6))
+  {
+    index->initaddress = word(block->data);
+    index->stopaddress = word(block->data + 2);
+    index->updateaddress = word(block->data + 4);
+  }
+  if ((block = sf2file_block(index, SF2BLOCK_DRIVERTABLES)) != NULL) indexdrivertables(index, block);
+  if ((block = sf2file_block(index, SF2BLOCK_MUSICDATA)) != NULL) indexmusicdata(index, block);
+  indexaux(index);
+
+  if ((!index->codesize) || (!index->initaddress) || (!index->updateaddress)) return SF2FILE_NODRIVER;
+  return SF2FILE_OK;
+}
+
+const char *sf2file_error(int result)
+{
+  switch (result)
+  {
+    case SF2FILE_OK:
+    return "no error";
+
+    case SF2FILE_NOTSF2:
+    return "not an SF2 file (no $1337 header)";
+
+    case SF2FILE_NODRIVER:
+    return "SF2 header has no driver descriptor or entry points";
+
+    default:
+    return "SF2 header is truncated";
+  }
+}
+
+const SF2BLOCK *sf2file_block(const SF2INDEX *index, unsigned id)
+{
+  int c;
+
+  for (c = 0; c < index->numblocks; c++)
+  {
+    if (index->blocks[c].id == id) return &index->blocks[c];
+  }
+  return NULL;
+}
+
+const SF2AUXBLOCK *sf2file_aux(const SF2INDEX *index, unsigned id)
+{
+  int c;
+
+  for (c = 0; c < index->numaux; c++)
+  {
+    if (index->aux[c].id == id) return &index->aux[c];
+  }
+  return NULL;
+}
+
+// Songs body: [u8 count][u8 selected], then from version 2 on a Pascal
+// string per song
+int sf2file_songname(const SF2INDEX *index, unsigned song, char *name, size_t size)
+{
+  const SF2AUXBLOCK *block = sf2file_aux(index, SF2AUX_SONGS);
+  const unsigned char *p;
+  const unsigned char *end;
+  unsigned c;
+
+  if ((!block) || (block->version < 2) || (block->size < 2) || (song >= block->data[0]) || (!size)) return -1;
+  p = block->data + 2;
+  end = block->data + block->size;
+  for (c = 0; c < song; c++)
+  {
+    if (p >= end) return -1;
+    p += 1 + p[0];
+  }
+  if ((p >= end) || (p + 1 + p[0] > end)) return -1;
+  for (c = 0; (c < p[0]) && (c + 1 < size); c++)
+    name[c] = ((p[1 + c] >= 0x20) && (p[1 + c] < 0x7f)) ? p[1 + c] : '?';
+  name[c] = 0;
+  return 0;
+}
@@ -0,0 +1,145 @@
+#ifndef SF2FILE_H
+#define SF2FILE_H
+
+// SID Factory II (SF2) container index for sf2pack and sf2export. An SF2 is
+// a PRG whose first bytes, at the load address, are the file ID $1337 and
+// a chain of header blocks ([u8 id][u8 size][body], up to id $FF): the
+// driver descriptor, its entry points, table definitions and music data
+// layout. Editor state is a second, auxiliary chain ([u8 id][u16 version]
+// [u16 size][body], up to 5 zero bytes) found through the pointer at $0FFB.
+// sf2file_index() walks both chains once; the index points into the
+// caller's data, nothing is copied.
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SF2FILE_ID 0x1337
+#define SF2FILE_AUXPOINTER 0x0ffb
+
+// Header block ids
+#define SF2BLOCK_DESCRIPTOR 0x01
+#define SF2BLOCK_DRIVERCOMMON 0x02
+#define SF2BLOCK_DRIVERTABLES 0x03
+#define SF2BLOCK_INSTRUMENTDESC 0x04
+#define SF2BLOCK_MUSICDATA 0x05
+#define SF2BLOCK_END 0xff
+
+// Auxiliary block ids
+#define SF2AUX_EDITINGPREFS 1
+#define SF2AUX_HARDWAREPREFS 2
+#define SF2AUX_PLAYMARKERS 3
+#define SF2AUX_TABLETEXT 4
+#define SF2AUX_SONGS 5
+
+#define SF2FILE_MAXBLOCKS 16
+#define SF2FILE_MAXTABLES 16
+#define SF2FILE_MAXAUX 8
+
+typedef struct
+{
+  unsigned id;
+  unsigned address;
+  unsigned size;
+  const unsigned char *data;
+} SF2BLOCK;
+
+// Auxiliary block: version is the block's data version
+typedef struct
+{
+  unsigned id;
+  unsigned version;
+  unsigned address;
+  unsigned size;
+  const unsigned char *data;
+} SF2AUXBLOCK;
+
+// A table defined in the driver tables block. name is not terminated.
+typedef struct
+{
+  unsigned type;
+  unsigned id;
+  const unsigned char *name;
+  unsigned namelength;
+  unsigned layout;
+  unsigned flags;
+  unsigned address;
+  unsigned columns;
+  unsigned rows;
+} SF2TABLE;
+
+// Addresses are C64 addresses, the image runs from loadaddress to
+// endaddress (exclusive). Fields of a missing block are 0; name fields
+// are C64 screen codes, not terminated.
+typedef struct
+{
+  unsigned loadaddress;
+  unsigned endaddress;
+  const unsigned char *image;
+
+  int numblocks;
+  SF2BLOCK blocks[SF2FILE_MAXBLOCKS];
+
+  // Descriptor: the driver code is codetop to codetop + codesize
+  unsigned drivertype;
+  unsigned driversize;
+  const unsigned char *drivername;
+  unsigned drivernamelength;
+  unsigned codetop;
+  unsigned codesize;
+  unsigned versionmajor;
+  unsigned versionminor;
+
+  // Driver common: entry points
+  unsigned initaddress;
+  unsigned stopaddress;
+  unsigned updateaddress;
+
+  int numtables;
+  SF2TABLE tables[SF2FILE_MAXTABLES];
+
+  // Music data: split (low and high byte) address tables of the track
+  // orderlists and the sequences
+  unsigned numtracks;
+  unsigned orderlistlow;
+  unsigned orderlisthigh;
+  unsigned numsequences;
+  unsigned sequencelow;
+  unsigned sequencehigh;
+
+  // Auxiliary chain, auxaddress 0 if there is none or it doesn't parse.
+  // auxend is the address after its end marker.
+  unsigned auxaddress;
+  unsigned auxend;
+  int numaux;
+  SF2AUXBLOCK aux[SF2FILE_MAXAUX];
+} SF2INDEX;
+
+// sf2file_index() results
+#define SF2FILE_OK 0
+#define SF2FILE_NOTSF2 1
+#define SF2FILE_TRUNCATED 2
+#define SF2FILE_NODRIVER 3
+
+// Index a PRG (load address bytes, then the image). Returns SF2FILE_OK, or
+// an error for sf2file_error(); SF2FILE_NODRIVER means the header chain is
+// there but without descriptor or entry points.
+int sf2file_index(const unsigned char *prg, size_t size, SF2INDEX *index);
+const char *sf2file_error(int result);
+
+// Header or auxiliary block by id, NULL if the file has none
+const SF2BLOCK *sf2file_block(const SF2INDEX *index, unsigned id);
+const SF2AUXBLOCK *sf2file_aux(const SF2INDEX *index, unsigned id);
+
+// Name of song number song from the songs auxiliary block, copied as
+// ASCII into name (size bytes, terminated). Returns 0, or -1 if there is
+// no such song.
+int sf2file_songname(const SF2INDEX *index, unsigned song, char *name, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
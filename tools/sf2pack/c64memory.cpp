@@ -5,10 +5,20 @@
  */
 
 #include "c64memory.h"
+#include <algorithm>
 #include <stdexcept>
 
 namespace SF2Pack {
 
+// The page every unused page points to. Held here as well, so it always
+// looks shared and is copied before a write.
+static const std::shared_ptr<std::array<unsigned char, 0x100> >& ZeroPage() {
+    static const std::shared_ptr<std::array<unsigned char, 0x100> > zero_page =
+        std::make_shared<std::array<unsigned char, 0x100> >();
+    return zero_page;
+}
+
+
 C64Memory::C64Memory() {
     Clear();
 }
@@ -33,7 +43,7 @@ bool C64Memory::LoadFromPRG(const unsigned char* prg_data, unsigned int prg_size
     }
 
     // Copy data to memory
-    std::memcpy(&data_[load_address], &prg_data[2], data_size);
+    Write(load_address, &prg_data[2], data_size);
 
     return true;
 }
@@ -50,7 +60,7 @@ bool C64Memory::LoadFromData(unsigned short load_address, const unsigned char* d
     }
 
     // Copy data to memory
-    std::memcpy(&data_[load_address], data, data_size);
+    Write(load_address, data, data_size);
 
     return true;
 }
@@ -69,57 +79,147 @@ std::vector<unsigned char> C64Memory::ExportToPRG(unsigned short top_address, un
     prg_data[1] = (top_address >> 8) & 0xFF;
 
     // Write data
-    std::memcpy(&prg_data[2], &data_[top_address], data_size);
+    Read(top_address, &prg_data[2], data_size);
+
+    return prg_data;
+}
+
+
+std::vector<unsigned char> C64Memory::ExportToPRG() const {
+    if (used_start_ >= used_end_) {
+        throw std::runtime_error("Nothing loaded to export as PRG");
+    }
+
+    // The used range may end at $10000, which doesn't fit the range overload
+    unsigned int data_size = used_end_ - used_start_;
+    std::vector<unsigned char> prg_data(data_size + 2);
+    prg_data[0] = used_start_ & 0xFF;
+    prg_data[1] = (used_start_ >> 8) & 0xFF;
+    Read(static_cast<unsigned short>(used_start_), &prg_data[2], data_size);
 
     return prg_data;
 }
 
 
 unsigned char& C64Memory::operator[](unsigned short address) {
-    return data_[address];
+    MarkUsed(address, 1);
+    return WritablePage(address >> 8)[address & 0xFF];
 }
 
 
 unsigned char C64Memory::operator[](unsigned short address) const {
-    return data_[address];
+    return GetByte(address);
 }
 
 
 unsigned char C64Memory::GetByte(unsigned short address) const {
-    return data_[address];
+    return (*pages_[address >> 8])[address & 0xFF];
 }
 
 
 unsigned short C64Memory::GetWord(unsigned short address) const {
-    // Little-endian word read
-    return data_[address] | (data_[address + 1] << 8);
+    // Little-endian word read, wrapping at $FFFF
+    return GetByte(address) | (GetByte(static_cast<unsigned short>(address + 1)) << 8);
 }
 
 
 void C64Memory::SetByte(unsigned short address, unsigned char value) {
-    data_[address] = value;
+    MarkUsed(address, 1);
+    WritablePage(address >> 8)[address & 0xFF] = value;
 }
 
 
 void C64Memory::SetWord(unsigned short address, unsigned short value) {
     // Little-endian word write
-    data_[address] = value & 0xFF;
-    data_[address + 1] = (value >> 8) & 0xFF;
+    SetByte(address, value & 0xFF);
+    SetByte(static_cast<unsigned short>(address + 1), (value >> 8) & 0xFF);
 }
 
 
-unsigned char* C64Memory::GetRawData() {
-    return data_;
+void C64Memory::Read(unsigned short address, unsigned char* dest, unsigned int size) const {
+    unsigned int from = address;
+    while (size > 0) {
+        unsigned int offset = from & 0xFF;
+        unsigned int count = std::min(size, 0x100 - offset);
+        std::memcpy(dest, pages_[from >> 8]->data() + offset, count);
+        dest += count;
+        from += count;
+        size -= count;
+    }
 }
 
 
-const unsigned char* C64Memory::GetRawData() const {
-    return data_;
+void C64Memory::Write(unsigned short address, const unsigned char* src, unsigned int size) {
+    if (address + size > 0x10000) {
+        throw std::runtime_error("Write past the end of C64 memory");
+    }
+    MarkUsed(address, size);
+
+    unsigned int to = address;
+    while (size > 0) {
+        unsigned int offset = to & 0xFF;
+        unsigned int count = std::min(size, 0x100 - offset);
+        std::memcpy(WritablePage(to >> 8).data() + offset, src, count);
+        src += count;
+        to += count;
+        size -= count;
+    }
+}
+
+
+void C64Memory::Move(unsigned short dest_address, unsigned short src_address, unsigned int size) {
+    if (dest_address + size > 0x10000 || src_address + size > 0x10000) {
+        throw std::runtime_error("Move past the end of C64 memory");
+    }
+
+    // Through a buffer: pages make an in-place overlapping copy fiddly
+    std::vector<unsigned char> buffer(size);
+    Read(src_address, buffer.data(), size);
+    Write(dest_address, buffer.data(), size);
+}
+
+
+unsigned int C64Memory::GetUsedStart() const {
+    return used_start_ < used_end_ ? used_start_ : 0;
+}
+
+
+unsigned int C64Memory::GetUsedEnd() const {
+    return used_end_;
+}
+
+
+const std::bitset<256>& C64Memory::GetUsedPages() const {
+    return used_pages_;
 }
 
 
 void C64Memory::Clear() {
-    std::memset(data_, 0, 0x10000);
+    pages_.fill(ZeroPage());
+    used_pages_.reset();
+    used_start_ = 0x10000;
+    used_end_ = 0;
+}
+
+
+C64Memory::Page& C64Memory::WritablePage(unsigned int page) {
+    std::shared_ptr<Page>& entry = pages_[page];
+    if (entry.use_count() > 1) {
+        entry = std::make_shared<Page>(*entry);
+    }
+    return *entry;
+}
+
+
+void C64Memory::MarkUsed(unsigned int address, unsigned int size) {
+    if (size == 0) {
+        return;
+    }
+    used_start_ = std::min(used_start_, address);
+    used_end_ = std::max(used_end_, address + size);
+    for (unsigned int page = address >> 8; page <= (address + size - 1) >> 8; ++page) {
+        used_pages_.set(page);
+    }
 }
 
 } // namespace SF2Pack
@@ -3,11 +3,20 @@
  *
  * Minimal 64KB memory container for SF2 packing
  * Simplified from SID Factory II C64File class
+ *
+ * Memory is 256 pages of 256 bytes, shared between copies and copied on
+ * the first write: a copy is a cheap snapshot, and a packer working on a
+ * copy of a loaded SF2 only duplicates the pages it patches. Pages and
+ * the address range that were loaded or written are tracked, so the
+ * extent of the data is known without scanning for non-zero bytes.
  */
 
 #pragma once
 
+#include <array>
+#include <bitset>
 #include <cstring>
+#include <memory>
 #include <vector>
 
 namespace SF2Pack {
@@ -17,6 +26,12 @@ public:
     C64Memory();
     ~C64Memory();
 
+    // Copies share all pages (snapshot); either side copies a page before
+    // writing to it. Copies of one memory may be made and used on
+    // different threads.
+    C64Memory(const C64Memory& other) = default;
+    C64Memory& operator=(const C64Memory& other) = default;
+
     // Load from PRG format (2-byte load address + data)
     bool LoadFromPRG(const unsigned char* prg_data, unsigned int prg_size);
 
@@ -26,7 +41,10 @@ public:
     // Export to PRG format
     std::vector<unsigned char> ExportToPRG(unsigned short top_address, unsigned short bottom_address) const;
 
-    // Memory access
+    // Export the used range (GetUsedStart() - GetUsedEnd()) to PRG format
+    std::vector<unsigned char> ExportToPRG() const;
+
+    // Memory access. The non-const operator[] counts as a write.
     unsigned char& operator[](unsigned short address);
     unsigned char operator[](unsigned short address) const;
 
@@ -36,15 +54,35 @@ public:
     void SetByte(unsigned short address, unsigned char value);
     void SetWord(unsigned short address, unsigned short value);  // Little-endian
 
-    // Get raw data pointer (use with caution)
-    unsigned char* GetRawData();
-    const unsigned char* GetRawData() const;
+    // Block access, size bytes from address on (address + size <= 0x10000)
+    void Read(unsigned short address, unsigned char* dest, unsigned int size) const;
+    void Write(unsigned short address, const unsigned char* src, unsigned int size);
+
+    // Copy size bytes within memory; the ranges may overlap
+    void Move(unsigned short dest_address, unsigned short src_address, unsigned int size);
+
+    // Lowest loaded or written address and the address after the highest;
+    // both 0 if nothing was
+    unsigned int GetUsedStart() const;
+    unsigned int GetUsedEnd() const;
+
+    // Pages holding loaded or written bytes
+    const std::bitset<256>& GetUsedPages() const;
 
     // Clear memory
     void Clear();
 
 private:
-    unsigned char data_[0x10000];  // 64KB C64 memory space
+    typedef std::array<unsigned char, 0x100> Page;
+
+    // Page for writing: unshared first if another copy still uses it
+    Page& WritablePage(unsigned int page);
+    void MarkUsed(unsigned int address, unsigned int size);
+
+    std::array<std::shared_ptr<Page>, 0x100> pages_;  // 64KB C64 memory space
+    std::bitset<256> used_pages_;
+    unsigned int used_start_;
+    unsigned int used_end_;
 };
 
 } // namespace SF2Pack
@@ -7,13 +7,14 @@
 
 #include "packer_simple.h"
 #include "opcodes.h"
+#include <algorithm>
 #include <stdexcept>
 #include <iostream>
 
 namespace SF2Pack {
 
 PackerSimple::PackerSimple(const DriverConfig& config)
-    : config_(config) {
+    : config_(config), log_(&std::cout) {
 }
 
 
@@ -21,39 +22,52 @@ PackerSimple::~PackerSimple() {
 }
 
 
+void PackerSimple::SetLog(std::ostream* log) {
+    log_ = log;
+}
+
+
 std::vector<unsigned char> PackerSimple::Pack(const C64Memory& input_memory) {
-    // Make a working copy of the memory
-    C64Memory memory;
-    for (unsigned int i = 0; i < 0x10000; ++i) {
-        memory[i] = input_memory[i];
+    return Pack(input_memory, AnalyzeDriverCode(input_memory, config_.driver_code_top,
+                                                config_.driver_code_size));
+}
+
+
+std::vector<unsigned char> PackerSimple::Pack(const C64Memory& input_memory,
+                                              const RelocationTable& table) {
+    if (table.driver_code_top != config_.driver_code_top ||
+        table.driver_code_size != config_.driver_code_size) {
+        throw std::runtime_error("Relocation table is for a different driver range");
     }
 
-    // Step 1: Process driver code with relocation
-    ProcessDriverCode(memory);
+    // Make a working copy of the memory. Pages are shared until written,
+    // so only the patched driver pages and the destination get copied.
+    C64Memory memory(input_memory);
 
-    // Step 2: Find the end of data
-    unsigned short data_start = config_.driver_code_top;
-    unsigned short data_end = config_.driver_code_top + config_.driver_code_size;
+    // Step 1: Find the end of data: the end the SF2 header gives or
+    // everything the SF2 loaded, including tables that end in zero bytes,
+    // and at least the driver code
+    unsigned int data_start = config_.driver_code_top;
+    unsigned int data_end = std::max<unsigned int>(data_start + config_.driver_code_size,
+                                                   config_.data_end ? config_.data_end :
+                                                   input_memory.GetUsedEnd());
 
-    // Extend to include all data tables (scan up to 0x3000 for safety)
-    for (unsigned short addr = data_end; addr < 0x3000; ++addr) {
-        if (memory[addr] != 0) {
-            data_end = addr + 1;
-        }
-    }
+    // Step 2: Process driver code and music data pointers with relocation
+    ProcessDriverCode(memory, table);
+    ProcessPointerTables(memory, data_end);
 
     unsigned int data_size = data_end - data_start;
+    MarkUsedPages(memory, table, data_size);
 
     // Step 3: Move data to destination address
-    // This is critical! We've patched the CODE, now we need to MOVE the data
+    // This is critical! We've patched the CODE, now we need to MOVE the data.
+    // Source and destination usually overlap ($0D7E -> $1000), which Move() handles.
+    // Only the destination range is exported, so the old location is left as is.
     if (config_.destination_address != config_.driver_code_top) {
-        for (unsigned int i = 0; i < data_size; ++i) {
-            memory[config_.destination_address + i] = memory[config_.driver_code_top + i];
-        }
-        // Clear old location
-        for (unsigned short addr = config_.driver_code_top; addr < data_end; ++addr) {
-            memory[addr] = 0;
+        if (config_.destination_address + data_size > 0x10000) {
+            throw std::runtime_error("Packed data doesn't fit below $10000 at the target address");
         }
+        memory.Move(config_.destination_address, config_.driver_code_top, data_size);
     }
 
     // Step 4: Export as PRG from destination address
@@ -66,85 +80,105 @@ std::vector<unsigned char> PackerSimple::Pack(const C64Memory& input_memory) {
 }
 
 
-void PackerSimple::ProcessDriverCode(C64Memory& memory) {
+void PackerSimple::ProcessDriverCode(C64Memory& memory, const RelocationTable& table) {
     // This is the CRITICAL function that performs 6502 code relocation
-    // Extracted from packer.cpp:429-509
+    // Extracted from packer.cpp:429-509. The instruction walk is done once,
+    // by AnalyzeDriverCode(); here only the listed operands are patched.
 
     const unsigned short driver_top = config_.driver_code_top;
     const unsigned short driver_size = config_.driver_code_size;
     const unsigned short driver_bottom = driver_top + driver_size;
     const unsigned short address_delta = GetAddressDelta();
 
-    std::cout << "Processing driver code:\n";
-    std::cout << "  Driver: $" << std::hex << driver_top
+    if (log_) {
+        *log_ << "Processing driver code:\n";
+        *log_ << "  Driver: $" << std::hex << driver_top
               << " - $" << driver_bottom << std::dec << "\n";
-    std::cout << "  Address delta: " << std::hex << address_delta << std::dec << "\n";
-    std::cout << "  ZP: $" << std::hex << (int)config_.current_lowest_zp
+        *log_ << "  Address delta: " << std::hex << address_delta << std::dec << "\n";
+        *log_ << "  ZP: $" << std::hex << (int)config_.current_lowest_zp
               << " -> $" << (int)config_.target_lowest_zp << std::dec << "\n";
+    }
 
-    unsigned int relocations_abs = 0;
-    unsigned int relocations_zp = 0;
-
-    // Scan through driver code instruction by instruction
-    unsigned short address = driver_top;
-
-    while (address < driver_bottom) {
-        unsigned char opcode = memory[address];
-        unsigned char opcode_size = GetOpcodeSize(opcode);
-        AddressingMode mode = GetOpcodeAddressingMode(opcode);
+    // Relocate absolute addresses (ABS, ABX, ABY, IND), ROM addresses
+    // already left out of the table
+    if (address_delta != 0) {
+        for (unsigned short operand : table.absolute) {
+            memory.SetWord(operand, memory.GetWord(operand) + address_delta);
+        }
+    }
+    relocation_counts_.absolute = (address_delta != 0) ? table.absolute.size() : 0;
 
-        // Relocate absolute addresses (ABS, ABX, ABY, IND)
-        if (RequiresRelocation(mode)) {
-            if (opcode_size != 3) {
-                throw std::runtime_error("Expected 3-byte instruction for absolute addressing");
-            }
+    // Relocate zero page addresses (ZP, ZPX, ZPY, IZX, IZY): the offset from
+    // the current ZP base applied to the new base
+    for (unsigned short operand : table.zero_page) {
+        unsigned char zp_offset = memory.GetByte(operand) - config_.current_lowest_zp;
+        memory.SetByte(operand, config_.target_lowest_zp + zp_offset);
+    }
+    relocation_counts_.zero_page = table.zero_page.size();
 
-            // Read the 16-bit address (little-endian)
-            unsigned short vector = memory.GetWord(address + 1);
+    if (log_) {
+        *log_ << "  Relocations: " << relocation_counts_.absolute << " absolute, "
+              << relocation_counts_.zero_page << " zero page\n";
+    }
+}
 
-            // Determine relocated address
-            unsigned short relocated_vector;
 
-            // Don't relocate ROM addresses ($D000-$DFFF contains SID chip, I/O, ROM)
-            if (vector >= 0xD000 && vector <= 0xDFFF) {
-                relocated_vector = vector;  // Keep ROM addresses unchanged
-            } else {
-                // Apply relocation delta
-                relocated_vector = vector + address_delta;
-            }
+void PackerSimple::ProcessPointerTables(C64Memory& memory, unsigned int data_end) {
+    // The driver reaches orderlists and sequences through these tables, so
+    // they move with the data. Addresses outside the packed range stay.
+    const unsigned short address_delta = GetAddressDelta();
+    relocation_counts_.pointers = 0;
+    if (address_delta == 0) {
+        return;
+    }
 
-            // Patch the instruction if address changed
-            if (vector != relocated_vector) {
-                memory.SetWord(address + 1, relocated_vector);
-                relocations_abs++;
+    for (const PointerTable& pointers : config_.pointers) {
+        for (unsigned int i = 0; i < pointers.count; ++i) {
+            unsigned short low = pointers.low + i;
+            unsigned short high = pointers.high + i;
+            unsigned int address = memory.GetByte(low) | (memory.GetByte(high) << 8);
+            if (address < config_.driver_code_top || address >= data_end) {
+                continue;
             }
+            address = (address + address_delta) & 0xFFFF;
+            memory.SetByte(low, address & 0xFF);
+            memory.SetByte(high, address >> 8);
+            ++relocation_counts_.pointers;
         }
+    }
 
-        // Relocate zero page addresses (ZP, ZPX, ZPY, IZX, IZY)
-        if (RequiresZeroPageAdjustment(mode)) {
-            if (opcode_size != 2) {
-                throw std::runtime_error("Expected 2-byte instruction for zero page addressing");
-            }
+    if (log_) {
+        *log_ << "  Music data: " << relocation_counts_.pointers << " pointers\n";
+    }
+}
 
-            unsigned char zp = memory.GetByte(address + 1);
 
-            // Calculate relative offset from current ZP base
-            unsigned char zp_offset = zp - config_.current_lowest_zp;
+void PackerSimple::MarkUsedPages(const C64Memory& memory, const RelocationTable& table,
+                                 unsigned int data_size) {
+    used_pages_.reset();
+    for (unsigned int page = config_.destination_address >> 8;
+         page <= (config_.destination_address + data_size - 1) >> 8 && page < 256; ++page) {
+        used_pages_.set(page);
+    }
+
+    // Called before the move: the patched operands are still at their
+    // table addresses. Indexed operands can reach into the next page.
+    for (unsigned short operand : table.absolute) {
+        used_pages_.set(memory.GetWord(operand) >> 8);
+    }
+    for (unsigned short operand : table.indexed) {
+        used_pages_.set(((memory.GetWord(operand) >> 8) + 1) & 0xFF);
+    }
+}
 
-            // Apply new ZP base
-            unsigned char zp_relocated = config_.target_lowest_zp + zp_offset;
 
-            // Patch the instruction
-            memory.SetByte(address + 1, zp_relocated);
-            relocations_zp++;
-        }
+const std::bitset<256>& PackerSimple::GetUsedPages() const {
+    return used_pages_;
+}
 
-        // Move to next instruction
-        address += opcode_size;
-    }
 
-    std::cout << "  Relocations: " << relocations_abs << " absolute, "
-              << relocations_zp << " zero page\n";
+const RelocationCounts& PackerSimple::GetRelocationCounts() const {
+    return relocation_counts_;
 }
 
 
@@ -8,17 +8,39 @@
 #pragma once
 
 #include "c64memory.h"
+#include "reloctable.h"
+#include <bitset>
+#include <ostream>
 #include <vector>
 
 namespace SF2Pack {
 
-// Driver 11 configuration (hardcoded)
+// Split address table in the music data: count low bytes at low, the high
+// bytes at high
+struct PointerTable {
+    unsigned short low;
+    unsigned short high;
+    unsigned short count;
+};
+
+
+// Driver configuration, from the SF2 header or the Driver 11 defaults
 struct DriverConfig {
     unsigned short driver_code_top;     // Where driver code starts (e.g., 0x1000)
     unsigned short driver_code_size;    // Size of driver code region
     unsigned char current_lowest_zp;    // Current zero page base in driver
     unsigned char target_lowest_zp;     // Target zero page base for export
     unsigned short destination_address; // Target load address for SID
+    unsigned int data_end;              // End of the data to move, 0 for everything the SF2 loaded
+    std::vector<PointerTable> pointers; // Orderlist and sequence addresses, relocated with the code
+};
+
+
+// Operands patched by the last Pack()
+struct RelocationCounts {
+    unsigned int absolute = 0;
+    unsigned int zero_page = 0;
+    unsigned int pointers = 0;
 };
 
 
@@ -32,9 +54,32 @@ public:
     // Output: Packed PRG data ready for PSID export
     std::vector<unsigned char> Pack(const C64Memory& memory);
 
+    // Same, with the driver's relocation table from AnalyzeDriverCode() or
+    // the cache, so packing one driver for many targets analyzes it once
+    std::vector<unsigned char> Pack(const C64Memory& memory, const RelocationTable& table);
+
+    // Pages the last packed tune occupies or addresses absolutely, for the
+    // PSID free page range
+    const std::bitset<256>& GetUsedPages() const;
+
+    // Relocation counts of the last packed tune, as in the report
+    const RelocationCounts& GetRelocationCounts() const;
+
+    // Where the relocation report goes (default std::cout, nullptr for none).
+    // Pack() touches nothing shared, so packers with separate logs can run
+    // on separate threads.
+    void SetLog(std::ostream* log);
+
 private:
     // Process driver code with address relocation
-    void ProcessDriverCode(C64Memory& memory);
+    void ProcessDriverCode(C64Memory& memory, const RelocationTable& table);
+
+    // Relocate the music data's orderlist and sequence addresses
+    void ProcessPointerTables(C64Memory& memory, unsigned int data_end);
+
+    // Mark the packed range and every relocated absolute operand's page
+    void MarkUsedPages(const C64Memory& memory, const RelocationTable& table,
+                       unsigned int data_size);
 
     // Calculate address delta for relocation
     unsigned short GetAddressDelta() const;
@@ -43,6 +88,9 @@ private:
     unsigned short RelocateVector(unsigned short vector) const;
 
     DriverConfig config_;
+    std::ostream* log_;
+    std::bitset<256> used_pages_;
+    RelocationCounts relocation_counts_;
 };
 
 } // namespace SF2Pack
@@ -5,7 +5,7 @@
  */
 
 #include "psidfile.h"
-#include <fstream>
+#include "sidfile.h"
 #include <cstring>
 #include <stdexcept>
 
@@ -57,21 +57,41 @@ void PSIDFile::SetCopyright(const std::string& copyright) {
 }
 
 
-bool PSIDFile::WriteToFile(const std::string& filename) const {
-    std::ofstream file(filename, std::ios::binary);
-    if (!file) {
-        return false;
+void PSIDFile::SetFreePages(const std::bitset<256>& used_pages) {
+    unsigned int best_start = 0;
+    unsigned int best_length = 0;
+    unsigned int start = 0;
+    unsigned int length = 0;
+
+    for (unsigned int page = 0x04; page <= 0xD0; ++page) {
+        bool usable = page < 0xD0 && (page < 0xA0 || page > 0xBF) && !used_pages.test(page);
+        if (usable) {
+            if (length++ == 0) {
+                start = page;
+            }
+        } else {
+            if (length > best_length) {
+                best_start = start;
+                best_length = length;
+            }
+            length = 0;
+        }
     }
 
-    // Write header
-    file.write(reinterpret_cast<const char*>(&header_), sizeof(header_));
+    header_.start_page = best_length ? static_cast<unsigned char>(best_start) : 0xFF;
+    header_.page_length = static_cast<unsigned char>(best_length);
+}
+
+
+bool PSIDFile::WriteToFile(const std::string& filename) const {
+    // Header and PRG data in one gathered write, without joining them first
+    return sidfile_write(filename.c_str(), &header_, sizeof(header_),
+                         prg_data_.data(), prg_data_.size()) == 0;
+}
 
-    // Write PRG data
-    if (!prg_data_.empty()) {
-        file.write(reinterpret_cast<const char*>(prg_data_.data()), prg_data_.size());
-    }
 
-    return file.good();
+size_t PSIDFile::GetFileSize() const {
+    return sizeof(header_) + prg_data_.size();
 }
 
 
@@ -112,7 +132,7 @@ void PSIDFile::InitializeHeader() {
     // Flags: 6581 SID (0x10) + PAL (0x04)
     header_.flags = EndianConvert(0x0014);
 
-    // Relocation info (not used)
+    // Relocation info: 0 = tune writes only inside its load range (SetFreePages() is exact)
     header_.start_page = 0;
     header_.page_length = 0;
     header_.second_sid = 0;
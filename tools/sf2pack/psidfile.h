@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <bitset>
 #include <string>
 #include <vector>
 
@@ -50,9 +51,17 @@ public:
     void SetAuthor(const std::string& author);
     void SetCopyright(const std::string& copyright);
 
+    // Fill start_page/page_length with the largest range of pages the tune
+    // doesn't use, where a player may put its own code ($04-$CF without
+    // BASIC ROM $A0-$BF). No free page gives $FF/0.
+    void SetFreePages(const std::bitset<256>& used_pages);
+
     // Export to file
     bool WriteToFile(const std::string& filename) const;
 
+    // Size of the file WriteToFile() writes: header plus PRG data
+    size_t GetFileSize() const;
+
     // Get PSID data
     std::vector<unsigned char> GetPSIDData() const;
 
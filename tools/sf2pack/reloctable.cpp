@@ -0,0 +1,219 @@
+/*
+ * reloctable.cpp - Precomputed Driver Relocation Table Implementation
+ *
+ * Same walk and ROM exclusion as SID Factory II's packer, done once
+ */
+
+#include "reloctable.h"
+#include "opcodes.h"
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+
+namespace SF2Pack {
+
+// Sidecar file: "SRLT", version, top, size, hash, three counts, then the
+// operand addresses. All little-endian.
+static const char RELOC_MAGIC[4] = {'S', 'R', 'L', 'T'};
+static const unsigned short RELOC_VERSION = 1;
+
+
+RelocationTable AnalyzeDriverCode(const C64Memory& memory,
+                                  unsigned short driver_code_top,
+                                  unsigned short driver_code_size) {
+    RelocationTable table;
+    table.driver_code_top = driver_code_top;
+    table.driver_code_size = driver_code_size;
+    table.driver_hash = HashDriverCode(memory, driver_code_top, driver_code_size);
+
+    const unsigned int driver_bottom = driver_code_top + driver_code_size;
+    unsigned int address = driver_code_top;
+
+    while (address < driver_bottom) {
+        unsigned char opcode = memory[address];
+        unsigned char opcode_size = GetOpcodeSize(opcode);
+        AddressingMode mode = GetOpcodeAddressingMode(opcode);
+        unsigned short operand = static_cast<unsigned short>(address + 1);
+
+        if (RequiresRelocation(mode)) {
+            if (opcode_size != 3) {
+                throw std::runtime_error("Expected 3-byte instruction for absolute addressing");
+            }
+
+            // Don't relocate ROM addresses ($D000-$DFFF contains SID chip, I/O, ROM)
+            unsigned short vector = memory.GetWord(operand);
+            if (vector < 0xD000 || vector > 0xDFFF) {
+                table.absolute.push_back(operand);
+                if (mode == am_ABX || mode == am_ABY) {
+                    table.indexed.push_back(operand);
+                }
+            }
+        }
+
+        if (RequiresZeroPageAdjustment(mode)) {
+            if (opcode_size != 2) {
+                throw std::runtime_error("Expected 2-byte instruction for zero page addressing");
+            }
+            table.zero_page.push_back(operand);
+        }
+
+        address += opcode_size;
+    }
+
+    return table;
+}
+
+
+unsigned long long HashDriverCode(const C64Memory& memory,
+                                  unsigned short driver_code_top,
+                                  unsigned short driver_code_size) {
+    unsigned int end = driver_code_top + driver_code_size + 2;
+    if (end > 0x10000) {
+        end = 0x10000;
+    }
+
+    unsigned long long hash = 0xcbf29ce484222325ULL;
+    for (unsigned int address = driver_code_top; address < end; ++address) {
+        hash ^= memory.GetByte(static_cast<unsigned short>(address));
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+
+std::string RelocationCacheName(const std::string& dir, unsigned long long hash) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.srt", hash);
+    return dir + "/" + name;
+}
+
+
+static void WriteValue(std::ostream& out, unsigned long long value, int bytes) {
+    for (int i = 0; i < bytes; ++i) {
+        out.put(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+
+static bool ReadValue(std::istream& in, unsigned long long& value, int bytes) {
+    value = 0;
+    for (int i = 0; i < bytes; ++i) {
+        int c = in.get();
+        if (c == EOF) {
+            return false;
+        }
+        value |= static_cast<unsigned long long>(c) << (8 * i);
+    }
+    return true;
+}
+
+
+static bool ReadList(std::istream& in, unsigned long long count, std::vector<unsigned short>& list) {
+    if (count > 0x10000) {
+        return false;
+    }
+    list.resize(static_cast<size_t>(count));
+    for (unsigned short& operand : list) {
+        unsigned long long value;
+        if (!ReadValue(in, value, 2)) {
+            return false;
+        }
+        operand = static_cast<unsigned short>(value);
+    }
+    return true;
+}
+
+
+bool LoadRelocationTable(const std::string& filename, unsigned short driver_code_top,
+                         unsigned short driver_code_size, unsigned long long hash,
+                         RelocationTable& table) {
+    std::ifstream in(filename, std::ios::binary);
+    if (!in) {
+        return false;
+    }
+
+    char magic[4];
+    unsigned long long version, top, size, file_hash, absolute, indexed, zero_page;
+    if (!in.read(magic, 4) || std::string(magic, 4) != std::string(RELOC_MAGIC, 4) ||
+        !ReadValue(in, version, 2) || version != RELOC_VERSION ||
+        !ReadValue(in, top, 2) || !ReadValue(in, size, 2) || !ReadValue(in, file_hash, 8) ||
+        !ReadValue(in, absolute, 4) || !ReadValue(in, indexed, 4) || !ReadValue(in, zero_page, 4)) {
+        return false;
+    }
+    if (top != driver_code_top || size != driver_code_size || file_hash != hash) {
+        return false;
+    }
+
+    RelocationTable loaded;
+    loaded.driver_code_top = driver_code_top;
+    loaded.driver_code_size = driver_code_size;
+    loaded.driver_hash = hash;
+    if (!ReadList(in, absolute, loaded.absolute) || !ReadList(in, indexed, loaded.indexed) ||
+        !ReadList(in, zero_page, loaded.zero_page)) {
+        return false;
+    }
+    table = loaded;
+    return true;
+}
+
+
+bool SaveRelocationTable(const std::string& filename, const RelocationTable& table) {
+    // Write a temporary file and rename it, so concurrent runs sharing a
+    // cache never read a half-written table
+    std::string temp = filename + ".tmp";
+    {
+        std::ofstream out(temp, std::ios::binary);
+        if (!out) {
+            return false;
+        }
+        out.write(RELOC_MAGIC, 4);
+        WriteValue(out, RELOC_VERSION, 2);
+        WriteValue(out, table.driver_code_top, 2);
+        WriteValue(out, table.driver_code_size, 2);
+        WriteValue(out, table.driver_hash, 8);
+        WriteValue(out, table.absolute.size(), 4);
+        WriteValue(out, table.indexed.size(), 4);
+        WriteValue(out, table.zero_page.size(), 4);
+        for (unsigned short operand : table.absolute) {
+            WriteValue(out, operand, 2);
+        }
+        for (unsigned short operand : table.indexed) {
+            WriteValue(out, operand, 2);
+        }
+        for (unsigned short operand : table.zero_page) {
+            WriteValue(out, operand, 2);
+        }
+        if (!out.good()) {
+            return false;
+        }
+    }
+    if (std::rename(temp.c_str(), filename.c_str()) != 0) {
+        std::remove(temp.c_str());
+        return false;
+    }
+    return true;
+}
+
+
+RelocationTable GetRelocationTable(const C64Memory& memory,
+                                   unsigned short driver_code_top,
+                                   unsigned short driver_code_size,
+                                   const std::string& cache_dir) {
+    if (cache_dir.empty()) {
+        return AnalyzeDriverCode(memory, driver_code_top, driver_code_size);
+    }
+
+    unsigned long long hash = HashDriverCode(memory, driver_code_top, driver_code_size);
+    std::string filename = RelocationCacheName(cache_dir, hash);
+    RelocationTable table;
+    if (LoadRelocationTable(filename, driver_code_top, driver_code_size, hash, table)) {
+        return table;
+    }
+
+    // A cache that can't be written only costs the next run an analysis
+    table = AnalyzeDriverCode(memory, driver_code_top, driver_code_size);
+    SaveRelocationTable(filename, table);
+    return table;
+}
+
+} // namespace SF2Pack
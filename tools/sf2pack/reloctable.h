@@ -0,0 +1,53 @@
+/*
+ * reloctable.h - Precomputed Driver Relocation Table
+ *
+ * The operand addresses PackerSimple patches, found once per driver
+ * and applied to any number of target addresses and ZP bases
+ */
+
+#pragma once
+
+#include "c64memory.h"
+#include <string>
+#include <vector>
+
+namespace SF2Pack {
+
+struct RelocationTable {
+    unsigned short driver_code_top = 0;
+    unsigned short driver_code_size = 0;
+    unsigned long long driver_hash = 0;     // HashDriverCode() of the analyzed bytes
+
+    std::vector<unsigned short> absolute;   // ABS/ABX/ABY/IND operands outside $D000-$DFFF
+    std::vector<unsigned short> indexed;    // The ABX/ABY subset of absolute (may touch the next page)
+    std::vector<unsigned short> zero_page;  // ZP/ZPX/ZPY/IZX/IZY operands
+};
+
+// Walk the driver code instruction by instruction and collect its operands.
+// Throws if an absolute or zero page opcode has an unexpected size.
+RelocationTable AnalyzeDriverCode(const C64Memory& memory,
+                                  unsigned short driver_code_top,
+                                  unsigned short driver_code_size);
+
+// FNV-1a of the driver range plus the two bytes a last instruction can
+// reach past it: two drivers with the same hash relocate the same way
+unsigned long long HashDriverCode(const C64Memory& memory,
+                                  unsigned short driver_code_top,
+                                  unsigned short driver_code_size);
+
+// Sidecar cache: <dir>/<hash>.srt. Load returns false if the file is
+// missing or doesn't describe this driver; Save returns false on a write error.
+std::string RelocationCacheName(const std::string& dir, unsigned long long hash);
+bool LoadRelocationTable(const std::string& filename, unsigned short driver_code_top,
+                         unsigned short driver_code_size, unsigned long long hash,
+                         RelocationTable& table);
+bool SaveRelocationTable(const std::string& filename, const RelocationTable& table);
+
+// The table for the driver in memory: from cache_dir if it has one,
+// otherwise analyzed (and stored there). An empty cache_dir only analyzes.
+RelocationTable GetRelocationTable(const C64Memory& memory,
+                                   unsigned short driver_code_top,
+                                   unsigned short driver_code_size,
+                                   const std::string& cache_dir);
+
+} // namespace SF2Pack
@@ -5,20 +5,38 @@
  * with full 6502 code relocation support.
  *
  * Usage: sf2pack input.sf2 output.sid [options]
+ *        sf2pack --batch <inputs...> --target ADDR[:ZP]... [options]
+ *        sf2pack --serve [options]
  */
 
 #include "c64memory.h"
 #include "packer_simple.h"
 #include "psidfile.h"
+#include "reloctable.h"
+#include "verifier.h"
+#include "ndjson.h"
+#include "sidfile.h"
+#include "sf2file.h"
+#include <sys/stat.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <iostream>
 #include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
 #include <vector>
 #include <string>
+#include <cstdio>
 #include <cstring>
 
 using namespace SF2Pack;
 
-// Default Driver 11 configuration
+// Driver 11 configuration for a PRG without an SF2 header
 struct DefaultDriverConfig {
     static const unsigned short DRIVER_CODE_TOP = 0x0D7E;   // From Angular.sf2 analysis
     static const unsigned short DRIVER_CODE_SIZE = 0x0800;  // ~2KB driver code
@@ -28,25 +46,127 @@ struct DefaultDriverConfig {
 };
 
 
-// Read entire file into memory
-std::vector<unsigned char> ReadFile(const std::string& filename) {
-    std::ifstream file(filename, std::ios::binary | std::ios::ate);
-    if (!file) {
-        throw std::runtime_error("Cannot open file: " + filename);
+// Where the driver of an SF2 is and how it is entered. The packed data runs
+// from code_top (the driver code, or a lower entry point) to data_end,
+// before the editor's auxiliary data; code_size bytes from code_top are
+// relocated as code, and the music data's address tables with it.
+struct DriverLayout {
+    unsigned short code_top;
+    unsigned short code_size;
+    unsigned int data_end;
+    std::vector<PointerTable> pointers;
+    unsigned short init_address;
+    unsigned short play_address;
+    std::string name;
+};
+
+
+// Read the layout from the SF2 header block chain (sf2file.h). A PRG
+// without one gets the Driver 11 defaults; a header that doesn't parse
+// is an error.
+DriverLayout GetDriverLayout(const unsigned char* prg, size_t size) {
+    SF2INDEX index;
+    int result = sf2file_index(prg, size, &index);
+    DriverLayout layout;
+    if (result == SF2FILE_NOTSF2) {
+        layout.code_top = DefaultDriverConfig::DRIVER_CODE_TOP;
+        layout.code_size = DefaultDriverConfig::DRIVER_CODE_SIZE;
+        layout.data_end = 0;
+        layout.init_address = layout.code_top + DefaultDriverConfig::INIT_OFFSET;
+        layout.play_address = layout.code_top + DefaultDriverConfig::PLAY_OFFSET;
+        layout.name = "Driver 11 (default)";
+        return layout;
+    }
+    if (result != SF2FILE_OK) {
+        throw std::runtime_error(sf2file_error(result));
+    }
+
+    // Some drivers have their entry points in front of the code top
+    unsigned int top = std::min(index.codetop, std::min(index.initaddress, index.updateaddress));
+    unsigned int code_end = index.codetop + index.codesize;
+    if (top < index.loadaddress || code_end > index.endaddress) {
+        throw std::runtime_error("SF2 driver code lies outside the file");
+    }
+    layout.code_top = static_cast<unsigned short>(top);
+    layout.code_size = static_cast<unsigned short>(code_end - top);
+    layout.data_end = (index.auxaddress && index.auxend == index.endaddress) ? index.auxaddress :
+        index.endaddress;
+    layout.init_address = static_cast<unsigned short>(index.initaddress);
+    layout.play_address = static_cast<unsigned short>(index.updateaddress);
+    if (index.numtracks) {
+        layout.pointers.push_back(PointerTable{static_cast<unsigned short>(index.orderlistlow),
+                                               static_cast<unsigned short>(index.orderlisthigh),
+                                               static_cast<unsigned short>(index.numtracks)});
+    }
+    if (index.numsequences) {
+        layout.pointers.push_back(PointerTable{static_cast<unsigned short>(index.sequencelow),
+                                               static_cast<unsigned short>(index.sequencehigh),
+                                               static_cast<unsigned short>(index.numsequences)});
+    }
+
+    // Screen codes to ASCII
+    for (unsigned int i = 0; i < index.drivernamelength; ++i) {
+        unsigned char c = index.drivername[i];
+        layout.name += static_cast<char>((c >= 1 && c <= 26) ? c + 0x40 : (c >= 0x20 && c < 0x7F) ? c : '?');
     }
+    return layout;
+}
 
-    std::streamsize size = file.tellg();
-    file.seekg(0, std::ios::beg);
 
-    std::vector<unsigned char> data(size);
-    if (!file.read(reinterpret_cast<char*>(data.data()), size)) {
-        throw std::runtime_error("Cannot read file: " + filename);
+// Input file mapped into memory (sidfile.h), unmapped on destruction.
+// Loading from it copies the data once, straight into C64 memory.
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& filename) {
+        if (sidfile_map(filename.c_str(), &map_)) {
+            throw std::runtime_error("Cannot open file: " + filename);
+        }
     }
+    ~MappedFile() {
+        sidfile_unmap(&map_);
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const unsigned char* data() const { return map_.data; }
+    size_t size() const { return map_.size; }
 
-    return data;
+private:
+    SIDFILEMAP map_;
+};
+
+
+typedef std::chrono::steady_clock Clock;
+
+double Seconds(Clock::time_point from, Clock::time_point to) {
+    return std::chrono::duration<double>(to - from).count();
 }
 
 
+// Run statistics for --stats-json, filled in as the phases finish. Times
+// are wall clock seconds: load is mapping the SF2 into C64 memory, analyze
+// the driver relocation table (or its cache sidecar), pack relocating and
+// building the PSID, verify the --verify run, output writing it.
+struct PackStats {
+    double load = 0;
+    double analyze = 0;
+    double pack = 0;
+    double verify = 0;
+    double output = 0;
+    RelocationCounts relocations;
+    size_t bytes_read = 0;
+    size_t bytes_packed = 0;
+    size_t bytes_written = 0;
+};
+
+
+// Load address and zero page base of one packed output
+struct PackTarget {
+    unsigned short address;
+    unsigned char zp;
+};
+
+
 // Parse command line arguments
 struct Options {
     std::string input_file;
@@ -57,21 +177,65 @@ struct Options {
     std::string author;
     std::string copyright;
     bool verbose = false;
+    std::string reloc_cache;          // Directory of relocation table sidecars
+    std::string stats_json;           // --stats-json file, "-" for stderr
+    bool verify = false;              // Run original and packed tune in lockstep
+    unsigned int verify_frames = 1500;
+
+    // Batch mode: every input packed for every target
+    bool batch = false;
+    std::vector<std::string> inputs;
+    std::vector<PackTarget> targets;
+    std::string outdir;
+    unsigned int jobs = 1;
+
+    // Service mode: requests on stdin, the options above are the defaults
+    bool serve = false;
 };
 
 
+// "ADDR" or "ADDR:ZP", hex or decimal like --address and --zp
+PackTarget ParseTarget(const std::string& text, unsigned char default_zp) {
+    PackTarget target;
+    size_t colon = text.find(':');
+    target.address = static_cast<unsigned short>(std::stoul(text.substr(0, colon), nullptr, 0));
+    target.zp = (colon == std::string::npos) ? default_zp :
+        static_cast<unsigned char>(std::stoul(text.substr(colon + 1), nullptr, 0));
+    return target;
+}
+
+
 bool ParseArguments(int argc, char* argv[], Options& options) {
-    if (argc < 3) {
+    if (argc < 2) {
         return false;
     }
 
-    options.input_file = argv[1];
-    options.output_file = argv[2];
+    int first = 3;
+    if (std::string(argv[1]) == "--serve") {
+        options.serve = true;
+        first = 2;
+    } else if (argc < 3) {
+        return false;
+    } else if (std::string(argv[1]) == "--batch") {
+        options.batch = true;
+        first = 2;
+    } else {
+        options.input_file = argv[1];
+        options.output_file = argv[2];
+    }
 
-    for (int i = 3; i < argc; ++i) {
+    for (int i = first; i < argc; ++i) {
         std::string arg = argv[i];
 
-        if (arg == "--address" && i + 1 < argc) {
+        if (options.batch && arg == "--target" && i + 1 < argc) {
+            options.targets.push_back(ParseTarget(argv[++i], options.zp));
+        } else if (options.batch && arg == "--outdir" && i + 1 < argc) {
+            options.outdir = argv[++i];
+        } else if (options.batch && arg == "-j" && i + 1 < argc) {
+            options.jobs = std::max(1, std::stoi(argv[++i]));
+        } else if (options.batch && !arg.empty() && arg[0] != '-') {
+            options.inputs.push_back(arg);
+        } else if (arg == "--address" && i + 1 < argc) {
             options.address = static_cast<unsigned short>(std::stoul(argv[++i], nullptr, 0));
         } else if (arg == "--zp" && i + 1 < argc) {
             options.zp = static_cast<unsigned char>(std::stoul(argv[++i], nullptr, 0));
@@ -81,6 +245,15 @@ bool ParseArguments(int argc, char* argv[], Options& options) {
             options.author = argv[++i];
         } else if (arg == "--copyright" && i + 1 < argc) {
             options.copyright = argv[++i];
+        } else if (arg == "--reloc-cache" && i + 1 < argc) {
+            options.reloc_cache = argv[++i];
+        } else if (arg == "--stats-json" && i + 1 < argc) {
+            options.stats_json = argv[++i];
+        } else if (arg == "--verify") {
+            options.verify = true;
+        } else if (arg == "--verify-frames" && i + 1 < argc) {
+            options.verify = true;
+            options.verify_frames = static_cast<unsigned int>(std::stoul(argv[++i], nullptr, 0));
         } else if (arg == "-v" || arg == "--verbose") {
             options.verbose = true;
         } else if (arg == "--help" || arg == "-h") {
@@ -91,6 +264,12 @@ bool ParseArguments(int argc, char* argv[], Options& options) {
         }
     }
 
+    if (options.batch) {
+        if (options.targets.empty()) {
+            options.targets.push_back(PackTarget{options.address, options.zp});
+        }
+        return !options.inputs.empty();
+    }
     return true;
 }
 
@@ -98,19 +277,536 @@ bool ParseArguments(int argc, char* argv[], Options& options) {
 void PrintUsage(const char* program_name) {
     std::cout << "SF2Pack - SF2 to SID Packer with Full Code Relocation\n";
     std::cout << "======================================================\n\n";
-    std::cout << "Usage: " << program_name << " <input.sf2> <output.sid> [options]\n\n";
+    std::cout << "Usage: " << program_name << " <input.sf2> <output.sid> [options]\n";
+    std::cout << "       " << program_name << " --batch <input.sf2|directory|@listfile>... [--target ADDR[:ZP]]... [options]\n";
+    std::cout << "       " << program_name << " --serve [options] (JSON requests on stdin, see README)\n\n";
     std::cout << "Options:\n";
     std::cout << "  --address ADDR    Target load address (hex or decimal, default: 0x1000)\n";
     std::cout << "  --zp ZP           Target zero page base (hex or decimal, default: 0x02)\n";
     std::cout << "  --title TITLE     Set song title\n";
     std::cout << "  --author AUTHOR   Set author name\n";
     std::cout << "  --copyright TEXT  Set copyright text\n";
+    std::cout << "  --reloc-cache DIR Keep driver relocation tables in DIR\n";
+    std::cout << "  --stats-json FILE Write timings, relocation counts and bytes read/written\n";
+    std::cout << "                    as JSON to FILE (- for stderr)\n";
+    std::cout << "  --verify          Play the original and the packed tune side by side and fail\n";
+    std::cout << "                    on the first different path or SID register write\n";
+    std::cout << "  --verify-frames N Play calls to compare (implies --verify, default: 1500)\n";
     std::cout << "  -v, --verbose     Verbose output\n";
     std::cout << "  -h, --help        Show this help\n\n";
+    std::cout << "Batch options:\n";
+    std::cout << "  --target ADDR[:ZP] Pack every input for this address (and ZP base, default --zp);\n";
+    std::cout << "                    repeat for more targets. Default: --address/--zp\n";
+    std::cout << "  --outdir DIR      Output directory, default next to each input\n";
+    std::cout << "  -j N              Worker threads, default 1\n";
+    std::cout << "  Outputs are named <name>_<ADDR>_zp<ZP>.sid\n\n";
     std::cout << "Examples:\n";
     std::cout << "  " << program_name << " Angular.sf2 Angular.sid\n";
     std::cout << "  " << program_name << " file.sf2 file.sid --address 0x1000 --zp 0x02\n";
     std::cout << "  " << program_name << " file.sf2 file.sid --title \"My Song\" --author \"Me\"\n";
+    std::cout << "  " << program_name << " --batch sf2dir --target 0x1000 --target 0x2000:0x20 -j 8 --outdir out\n";
+}
+
+
+// Packer configuration for a driver and target
+DriverConfig MakeDriverConfig(const DriverLayout& layout, const PackTarget& target) {
+    DriverConfig config;
+    config.driver_code_top = layout.code_top;
+    config.driver_code_size = layout.code_size;
+    config.current_lowest_zp = DefaultDriverConfig::CURRENT_LOWEST_ZP;
+    config.target_lowest_zp = target.zp;
+    config.destination_address = target.address;
+    config.data_end = layout.data_end;
+    config.pointers = layout.pointers;
+    return config;
+}
+
+
+// PSID header for packed data, with the packer's free pages and the
+// metadata options applied
+PSIDFile MakePSID(const std::vector<unsigned char>& packed_data, const PackerSimple& packer,
+                  const DriverLayout& layout, const Options& options) {
+    PSIDFile psid;
+    if (!psid.CreateFromPRG(packed_data.data(), packed_data.size(),
+                            layout.init_address - layout.code_top,
+                            layout.play_address - layout.code_top)) {
+        throw std::runtime_error("Failed to create PSID file");
+    }
+    psid.SetFreePages(packer.GetUsedPages());
+
+    // Set metadata
+    if (!options.title.empty()) {
+        psid.SetTitle(options.title);
+    }
+    if (!options.author.empty()) {
+        psid.SetAuthor(options.author);
+    }
+    if (!options.copyright.empty()) {
+        psid.SetCopyright(options.copyright);
+    }
+    return psid;
+}
+
+
+// --verify: play the original image and the packed tune in lockstep (verifier.h).
+// Throws on the first divergence.
+void VerifyPacked(const C64Memory& memory, const DriverLayout& layout, const DriverConfig& config,
+                  const std::vector<unsigned char>& packed_data, const Options& options,
+                  std::ostream* log) {
+    VerifyResult result = VerifyRelocation(memory, config, packed_data, layout.init_address,
+                                           layout.play_address, options.verify_frames);
+    if (!result.ok) {
+        throw std::runtime_error(DescribeVerifyFailure(result));
+    }
+    if (log) {
+        *log << "  Verified " << result.frames << " frames (" << result.instructions
+             << " instructions) against the original\n";
+    }
+}
+
+
+// Escaped the way ndjson_writestring() does it
+void WriteJsonString(std::ostream& out, const std::string& text) {
+    out << '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (c == '\n') {
+            out << "\\n";
+        } else if (c == '\t') {
+            out << "\\t";
+        } else if (c == '\r') {
+            out << "\\r";
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escape[8];
+            std::snprintf(escape, sizeof(escape), "\\u%04x", static_cast<unsigned char>(c));
+            out << escape;
+        } else {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+
+void WritePackStats(std::ostream& out, const std::string& input, const std::string& output,
+                    const std::string& error, const PackStats& stats) {
+    out << "{\"input\": ";
+    WriteJsonString(out, input);
+    out << ", \"output\": ";
+    WriteJsonString(out, output);
+    out << ", \"status\": \"" << (error.empty() ? "ok" : "error") << "\"";
+    if (!error.empty()) {
+        out << ", \"error\": ";
+        WriteJsonString(out, error);
+    }
+    char times[192];
+    std::snprintf(times, sizeof(times),
+                  "{\"load\": %.6f, \"analyze\": %.6f, \"pack\": %.6f, \"verify\": %.6f, \"output\": %.6f, \"total\": %.6f}",
+                  stats.load, stats.analyze, stats.pack, stats.verify, stats.output,
+                  stats.load + stats.analyze + stats.pack + stats.verify + stats.output);
+    out << ",\n  \"time\": " << times << ",\n";
+    out << "  \"relocations\": {\"absolute\": " << stats.relocations.absolute
+        << ", \"zero_page\": " << stats.relocations.zero_page
+        << ", \"pointers\": " << stats.relocations.pointers << "},\n";
+    out << "  \"bytes\": {\"read\": " << stats.bytes_read << ", \"packed\": " << stats.bytes_packed
+        << ", \"written\": " << stats.bytes_written << "}}";
+}
+
+
+// Write --stats-json output, built by write, to its file or stderr
+template <typename Writer>
+void WriteStatsFile(const std::string& filename, Writer write) {
+    if (filename == "-") {
+        write(std::cerr);
+        std::cerr << "\n";
+        return;
+    }
+    std::ofstream file(filename);
+    write(file);
+    file << "\n";
+    if (!file) {
+        throw std::runtime_error("Cannot write statistics file: " + filename);
+    }
+}
+
+
+// One input of a batch, loaded and analyzed once and shared read-only by its jobs
+struct BatchInput {
+    std::string filename;
+    std::unique_ptr<C64Memory> memory;
+    DriverLayout layout;
+    RelocationTable relocations;
+    std::string error;
+    PackStats stats;                  // load, analyze and bytes read
+};
+
+
+// One input packed for one target
+struct BatchJob {
+    const BatchInput* input;
+    PackTarget target;
+    std::string output_file;
+    std::string log;
+    std::string error;
+    size_t packed_size = 0;
+    bool ok = false;
+    PackStats stats;                  // pack, output, relocations and bytes written
+};
+
+
+bool IsDirectory(const std::string& path) {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+
+// Expand a batch argument: a file, a directory (every *.sf2, sorted) or
+// @listfile (one path per line, # comments)
+void ExpandInput(const std::string& arg, std::vector<std::string>& files) {
+    if (!arg.empty() && arg[0] == '@') {
+        std::ifstream list(arg.substr(1));
+        if (!list) {
+            throw std::runtime_error("Cannot open list file: " + arg.substr(1));
+        }
+        std::string line;
+        while (std::getline(list, line)) {
+            line.erase(line.find_last_not_of(" \t\r\n") + 1);
+            if (!line.empty() && line[0] != '#') {
+                files.push_back(line);
+            }
+        }
+    } else if (IsDirectory(arg)) {
+        SIDFILEDIR* dir = sidfile_diropen(arg.c_str(), ".sf2");
+        if (!dir) {
+            throw std::runtime_error("Cannot open directory: " + arg);
+        }
+        std::vector<std::string> names;
+        while (const char* path = sidfile_dirnext(dir)) {
+            names.push_back(path);
+        }
+        sidfile_dirclose(dir);
+        std::sort(names.begin(), names.end());
+        files.insert(files.end(), names.begin(), names.end());
+    } else {
+        files.push_back(arg);
+    }
+}
+
+
+// <outdir or input directory>/<name>_<ADDR>_zp<ZP>.sid
+std::string MakeOutputName(const std::string& input, const std::string& outdir, const PackTarget& target) {
+    size_t slash = input.find_last_of("/\\");
+    std::string dir = (slash == std::string::npos) ? "" : input.substr(0, slash + 1);
+    std::string name = (slash == std::string::npos) ? input : input.substr(slash + 1);
+    size_t dot = name.find_last_of('.');
+    if (dot != std::string::npos) {
+        name.erase(dot);
+    }
+    if (!outdir.empty()) {
+        dir = outdir + "/";
+    }
+    char suffix[16];
+    std::snprintf(suffix, sizeof(suffix), "_%04X_zp%02X.sid", target.address, target.zp);
+    return dir + name + suffix;
+}
+
+
+void RunBatchJob(BatchJob& job, const Options& options) {
+    if (!job.input->memory) {
+        job.error = job.input->error;
+        return;
+    }
+    try {
+        std::ostringstream log;
+        Clock::time_point start = Clock::now();
+        DriverConfig config = MakeDriverConfig(job.input->layout, job.target);
+        PackerSimple packer(config);
+        packer.SetLog(options.verbose ? &log : nullptr);
+        std::vector<unsigned char> packed_data = packer.Pack(*job.input->memory, job.input->relocations);
+        PSIDFile psid = MakePSID(packed_data, packer, job.input->layout, options);
+        job.stats.relocations = packer.GetRelocationCounts();
+        Clock::time_point packed = Clock::now();
+        job.stats.pack = Seconds(start, packed);
+        if (options.verify) {
+            VerifyPacked(*job.input->memory, job.input->layout, config, packed_data, options,
+                         options.verbose ? &log : nullptr);
+            Clock::time_point verified = Clock::now();
+            job.stats.verify = Seconds(packed, verified);
+            packed = verified;
+        }
+        if (!psid.WriteToFile(job.output_file)) {
+            throw std::runtime_error("Failed to write output file");
+        }
+        job.stats.output = Seconds(packed, Clock::now());
+        job.stats.bytes_packed = packed_data.size() - 2;
+        job.stats.bytes_written = psid.GetFileSize();
+        job.packed_size = packed_data.size() - 2;
+        job.log = log.str();
+        job.ok = true;
+    } catch (const std::exception& e) {
+        job.error = e.what();
+    }
+}
+
+
+// Read an SF2 into C64 memory and get its driver's relocation table. A
+// failure is kept in input.error.
+void LoadInput(BatchInput& input, const std::string& filename, const Options& options) {
+    input.filename = filename;
+    try {
+        Clock::time_point start = Clock::now();
+        MappedFile sf2_data(filename);
+        std::unique_ptr<C64Memory> memory(new C64Memory());
+        if (sf2_data.size() < 3 || !memory->LoadFromPRG(sf2_data.data(), sf2_data.size())) {
+            throw std::runtime_error("Failed to load SF2 data into memory");
+        }
+        input.layout = GetDriverLayout(sf2_data.data(), sf2_data.size());
+        input.stats.bytes_read = sf2_data.size();
+        Clock::time_point loaded = Clock::now();
+        input.stats.load = Seconds(start, loaded);
+        input.relocations = GetRelocationTable(*memory, input.layout.code_top, input.layout.code_size,
+                                               options.reloc_cache);
+        input.stats.analyze = Seconds(loaded, Clock::now());
+        input.memory = std::move(memory);
+    } catch (const std::exception& e) {
+        input.error = e.what();
+    }
+}
+
+
+// Pack every input for every target. Each SF2 is read, loaded into C64
+// memory and its driver analyzed once; the input x target jobs then run on
+// a pool of threads, each packer working on its own copy.
+int RunBatch(const Options& options) {
+    std::vector<std::string> files;
+    for (const std::string& arg : options.inputs) {
+        ExpandInput(arg, files);
+    }
+
+    std::vector<BatchInput> inputs(files.size());
+    for (size_t i = 0; i < files.size(); ++i) {
+        LoadInput(inputs[i], files[i], options);
+    }
+
+    std::vector<BatchJob> jobs;
+    for (const BatchInput& input : inputs) {
+        for (const PackTarget& target : options.targets) {
+            BatchJob job;
+            job.input = &input;
+            job.target = target;
+            job.output_file = MakeOutputName(input.filename, options.outdir, target);
+            jobs.push_back(job);
+        }
+    }
+
+    unsigned int workers = std::min<size_t>(options.jobs, std::max<size_t>(jobs.size(), 1));
+    std::cout << "Packing " << inputs.size() << " files for " << options.targets.size()
+              << " targets with " << workers << " worker threads\n";
+
+    std::atomic<size_t> next(0);
+    std::vector<std::thread> threads;
+    for (unsigned int t = 0; t < workers; ++t) {
+        threads.emplace_back([&]() {
+            for (size_t j = next++; j < jobs.size(); j = next++) {
+                RunBatchJob(jobs[j], options);
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    int failed = 0;
+    for (const BatchJob& job : jobs) {
+        if (job.ok) {
+            std::cout << "OK   " << job.input->filename << " -> " << job.output_file
+                      << " (" << job.packed_size << " bytes)\n";
+            std::cout << job.log;
+        } else {
+            std::cout << "FAIL " << job.input->filename << " -> " << job.output_file
+                      << ": " << job.error << "\n";
+            failed++;
+        }
+    }
+    std::cout << (jobs.size() - failed) << " of " << jobs.size() << " outputs packed, "
+              << failed << " failed\n";
+
+    // Load and analyze are per input, so they are reported with the
+    // input's first job only and the totals add up
+    if (!options.stats_json.empty()) {
+        WriteStatsFile(options.stats_json, [&](std::ostream& out) {
+            out << "{\"jobs\": [\n";
+            const BatchInput* previous = nullptr;
+            for (size_t j = 0; j < jobs.size(); ++j) {
+                PackStats stats = jobs[j].stats;
+                if (jobs[j].input != previous) {
+                    stats.load = jobs[j].input->stats.load;
+                    stats.analyze = jobs[j].input->stats.analyze;
+                    stats.bytes_read = jobs[j].input->stats.bytes_read;
+                    previous = jobs[j].input;
+                }
+                WritePackStats(out, jobs[j].input->filename, jobs[j].output_file,
+                               jobs[j].ok ? "" : jobs[j].error, stats);
+                out << (j + 1 < jobs.size() ? ",\n" : "\n");
+            }
+            out << "]}";
+        });
+    }
+    return failed ? 1 : 0;
+}
+
+
+void ReplyError(const NDJSONREQUEST* request, const std::string& error) {
+    ndjson_error(stdout, request, "%s", error.c_str());
+}
+
+
+// Integer field of a request in low-high, fallback when it is left out
+long RequestNumber(const NDJSONREQUEST* request, const char* key, long fallback, long low, long high) {
+    long value = fallback;
+    if (ndjson_number(request, key, &value) == NDJSON_INVALID || value < low || value > high) {
+        throw std::runtime_error(std::string(key) + " must be an integer " + std::to_string(low) + "-" +
+                                 std::to_string(high));
+    }
+    return value;
+}
+
+
+// The loaded input for a request's "file", loading it on first use
+const BatchInput* GetServiceInput(std::map<std::string, std::unique_ptr<BatchInput>>& loaded,
+                                  const std::string& filename, const Options& options, bool& cached) {
+    auto found = loaded.find(filename);
+    cached = found != loaded.end();
+    if (!cached) {
+        std::unique_ptr<BatchInput> input(new BatchInput());
+        LoadInput(*input, filename, options);
+        if (!input->memory) {
+            std::string error = input->error;
+            throw std::runtime_error(error);
+        }
+        found = loaded.emplace(filename, std::move(input)).first;
+    }
+    return found->second.get();
+}
+
+
+// --serve: newline-delimited JSON requests on stdin (ndjson.h), one reply
+// line each on stdout. A loaded SF2 stays in memory with its relocation
+// table, so packing it again for another target only costs the patching.
+//   {"cmd": "load", "file": "x.sf2"}
+//   {"cmd": "pack", "file": "x.sf2", "output": "x.sid", "address": "0x1000", "zp": 2,
+//    "title": ..., "author": ..., "copyright": ..., "verify": 1500}
+//   {"cmd": "unload", "file": "x.sf2"}, {"cmd": "quit"}
+int RunService(const Options& defaults) {
+    std::map<std::string, std::unique_ptr<BatchInput>> loaded;
+    std::string line;
+    NDJSONREQUEST request;
+
+    while (std::getline(std::cin, line)) {
+        if (line.find_first_not_of(" \t\r") == std::string::npos) {
+            continue;
+        }
+        if (ndjson_parse(line.c_str(), &request)) {
+            ReplyError(nullptr, "Malformed request");
+            continue;
+        }
+        const char* cmd = ndjson_string(&request, "cmd");
+        const char* file = ndjson_string(&request, "file");
+        if (!cmd) {
+            ReplyError(&request, "Request has no cmd");
+            continue;
+        }
+
+        std::string command = cmd;
+        if (command == "quit") {
+            ndjson_begin(stdout, &request, 1);
+            ndjson_end(stdout);
+            break;
+        }
+        if (command != "load" && command != "pack" && command != "unload") {
+            ReplyError(&request, "Unknown cmd " + command);
+            continue;
+        }
+        if (!file) {
+            ReplyError(&request, command + " needs a file");
+            continue;
+        }
+        if (command == "unload") {
+            loaded.erase(file);
+            ndjson_begin(stdout, &request, 1);
+            ndjson_end(stdout);
+            continue;
+        }
+
+        try {
+            bool cached;
+            const BatchInput* input = GetServiceInput(loaded, file, defaults, cached);
+            if (command == "load") {
+                ndjson_begin(stdout, &request, 1);
+                std::printf(", \"cached\": %s, \"size\": %lu, \"absolute\": %lu, \"zero_page\": %lu",
+                            cached ? "true" : "false", static_cast<unsigned long>(input->stats.bytes_read),
+                            static_cast<unsigned long>(input->relocations.absolute.size()),
+                            static_cast<unsigned long>(input->relocations.zero_page.size()));
+                ndjson_end(stdout);
+                continue;
+            }
+
+            const char* output = ndjson_string(&request, "output");
+            if (!output) {
+                throw std::runtime_error("pack needs an output");
+            }
+            Options options = defaults;
+            BatchJob job;
+            job.input = input;
+            job.target.address = static_cast<unsigned short>(
+                RequestNumber(&request, "address", options.address, 0, 0xFFFF));
+            job.target.zp = static_cast<unsigned char>(RequestNumber(&request, "zp", options.zp, 0, 0xFF));
+            job.output_file = output;
+            const char* title = ndjson_string(&request, "title");
+            const char* author = ndjson_string(&request, "author");
+            const char* copyright = ndjson_string(&request, "copyright");
+            if (title) {
+                options.title = title;
+            }
+            if (author) {
+                options.author = author;
+            }
+            if (copyright) {
+                options.copyright = copyright;
+            }
+            // true or false switch --verify for this request, a number gives the frames
+            const NDJSONFIELD* verify = ndjson_field(&request, "verify");
+            std::string literal = verify && !verify->string ? verify->value : "";
+            long frames;
+            if (literal == "true" || literal == "false") {
+                options.verify = literal == "true";
+            } else if (ndjson_number(&request, "verify", &frames) != NDJSON_MISSING) {
+                frames = RequestNumber(&request, "verify", 0, 0, 0x7FFFFFFF);
+                options.verify = frames > 0;
+                options.verify_frames = static_cast<unsigned int>(frames);
+            }
+            options.verbose = false;
+
+            RunBatchJob(job, options);
+            if (!job.ok) {
+                throw std::runtime_error(job.error);
+            }
+            ndjson_begin(stdout, &request, 1);
+            std::printf(", \"output\": ");
+            ndjson_writestring(stdout, output);
+            std::printf(", \"address\": %u, \"zp\": %u, \"packed\": %lu, \"written\": %lu, "
+                        "\"absolute\": %u, \"zero_page\": %u, \"pointers\": %u, \"seconds\": %.6f",
+                        job.target.address, job.target.zp, static_cast<unsigned long>(job.stats.bytes_packed),
+                        static_cast<unsigned long>(job.stats.bytes_written),
+                        job.stats.relocations.absolute, job.stats.relocations.zero_page,
+                        job.stats.relocations.pointers, job.stats.pack + job.stats.verify + job.stats.output);
+            ndjson_end(stdout);
+        } catch (const std::exception& e) {
+            ReplyError(&request, e.what());
+        }
+    }
+    return 0;
 }
 
 
@@ -123,6 +819,13 @@ int main(int argc, char* argv[]) {
             return 1;
         }
 
+        if (options.serve) {
+            return RunService(options);
+        }
+        if (options.batch) {
+            return RunBatch(options);
+        }
+
         if (options.verbose) {
             std::cout << "SF2Pack v1.0 - SF2 to SID Packer\n";
             std::cout << "=================================\n";
@@ -137,7 +840,9 @@ int main(int argc, char* argv[]) {
             std::cout << "Loading SF2 file...\n";
         }
 
-        std::vector<unsigned char> sf2_data = ReadFile(options.input_file);
+        PackStats stats;
+        Clock::time_point start = Clock::now();
+        MappedFile sf2_data(options.input_file);
 
         if (sf2_data.size() < 3) {
             throw std::runtime_error("SF2 file too small");
@@ -148,30 +853,37 @@ int main(int argc, char* argv[]) {
         if (!memory.LoadFromPRG(sf2_data.data(), sf2_data.size())) {
             throw std::runtime_error("Failed to load SF2 data into memory");
         }
+        DriverLayout layout = GetDriverLayout(sf2_data.data(), sf2_data.size());
+        stats.bytes_read = sf2_data.size();
+        Clock::time_point loaded = Clock::now();
+        stats.load = Seconds(start, loaded);
 
         // Extract load address for info
-        unsigned short sf2_load_address = sf2_data[0] | (sf2_data[1] << 8);
+        unsigned short sf2_load_address = sf2_data.data()[0] | (sf2_data.data()[1] << 8);
 
         if (options.verbose) {
             std::cout << "  SF2 load address: $" << std::hex << sf2_load_address << std::dec << "\n";
-            std::cout << "  Data size: " << (sf2_data.size() - 2) << " bytes\n\n";
+            std::cout << "  Data size: " << (sf2_data.size() - 2) << " bytes\n";
+            std::cout << "  Driver: " << layout.name << ", code $" << std::hex << layout.code_top
+                      << " - $" << (layout.code_top + layout.code_size) << ", init $" << layout.init_address
+                      << ", play $" << layout.play_address << std::dec << "\n\n";
         }
 
         // Step 3: Configure packer
-        DriverConfig config;
-        config.driver_code_top = DefaultDriverConfig::DRIVER_CODE_TOP;
-        config.driver_code_size = DefaultDriverConfig::DRIVER_CODE_SIZE;
-        config.current_lowest_zp = DefaultDriverConfig::CURRENT_LOWEST_ZP;
-        config.target_lowest_zp = options.zp;
-        config.destination_address = options.address;
+        DriverConfig config = MakeDriverConfig(layout, PackTarget{options.address, options.zp});
 
         // Step 4: Pack with relocation
         if (options.verbose) {
             std::cout << "Packing with relocation...\n";
         }
 
+        RelocationTable relocations = GetRelocationTable(memory, config.driver_code_top,
+                                                         config.driver_code_size,
+                                                         options.reloc_cache);
+        Clock::time_point analyzed = Clock::now();
+        stats.analyze = Seconds(loaded, analyzed);
         PackerSimple packer(config);
-        std::vector<unsigned char> packed_data = packer.Pack(memory);
+        std::vector<unsigned char> packed_data = packer.Pack(memory, relocations);
 
         if (options.verbose) {
             std::cout << "  Packed size: " << (packed_data.size() - 2) << " bytes\n\n";
@@ -182,28 +894,34 @@ int main(int argc, char* argv[]) {
             std::cout << "Creating PSID file...\n";
         }
 
-        PSIDFile psid;
-        if (!psid.CreateFromPRG(packed_data.data(), packed_data.size(),
-                                DefaultDriverConfig::INIT_OFFSET,
-                                DefaultDriverConfig::PLAY_OFFSET)) {
-            throw std::runtime_error("Failed to create PSID file");
-        }
-
-        // Set metadata
-        if (!options.title.empty()) {
-            psid.SetTitle(options.title);
-        }
-        if (!options.author.empty()) {
-            psid.SetAuthor(options.author);
-        }
-        if (!options.copyright.empty()) {
-            psid.SetCopyright(options.copyright);
+        PSIDFile psid = MakePSID(packed_data, packer, layout, options);
+        stats.relocations = packer.GetRelocationCounts();
+        stats.bytes_packed = packed_data.size() - 2;
+        Clock::time_point packed = Clock::now();
+        stats.pack = Seconds(analyzed, packed);
+
+        if (options.verify) {
+            if (options.verbose) {
+                std::cout << "Verifying relocation...\n";
+            }
+            VerifyPacked(memory, layout, config, packed_data, options, options.verbose ? &std::cout : nullptr);
+            Clock::time_point verified = Clock::now();
+            stats.verify = Seconds(packed, verified);
+            packed = verified;
         }
 
         // Step 6: Write output
         if (!psid.WriteToFile(options.output_file)) {
             throw std::runtime_error("Failed to write output file");
         }
+        stats.output = Seconds(packed, Clock::now());
+        stats.bytes_written = psid.GetFileSize();
+
+        if (!options.stats_json.empty()) {
+            WriteStatsFile(options.stats_json, [&](std::ostream& out) {
+                WritePackStats(out, options.input_file, options.output_file, "", stats);
+            });
+        }
 
         if (options.verbose) {
             std::cout << "\nConversion complete!\n";
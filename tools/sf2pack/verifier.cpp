@@ -0,0 +1,251 @@
+/*
+ * verifier.cpp - Lockstep Relocation Verifier Implementation
+ *
+ * Both tunes are stepped one instruction at a time on the reentrant core
+ * of tools/cpu.c. Register contents and cycle counts are not compared:
+ * zero page pointers hold relocated addresses, and a moved branch or
+ * indexed access can cross a page where the original didn't.
+ */
+
+#include "verifier.h"
+#include "cpu.h"
+#include <cstdio>
+#include <cstring>
+
+namespace SF2Pack {
+
+namespace {
+
+// Instruction limit for one init or play call, as in sidplay.h
+const unsigned int kMaxInstructions = 0x100000;
+
+struct SidWrite {
+    unsigned char reg;
+    unsigned char value;
+};
+
+
+// One of the two machines: 64KB of memory, a context and the SID register
+// writes of the last instruction
+struct Machine {
+    Machine() : mem(0x10000, 0) {
+        std::memset(&cpu, 0, sizeof(cpu));
+        std::memset(&observer, 0, sizeof(observer));
+        cpu.mem = mem.data();
+        observer.write = ObserveWrite;
+        observer.user = this;
+        cpu.observer = &observer;
+    }
+    Machine(const Machine&) = delete;
+    Machine& operator=(const Machine&) = delete;
+
+    int Step() {
+        writes.clear();
+        return runcpu_ctx_observed(&cpu);
+    }
+
+    // $D400-$D7FF with I/O banked in; the registers repeat every 32 bytes
+    static void ObserveWrite(void* user, const CPUCONTEXT* ctx, unsigned short address,
+                             unsigned char value) {
+        if ((address & 0xFC00) == 0xD400 && (address & 0x1F) <= 0x18 &&
+            (ctx->mem[0x01] & 0x04) && (ctx->mem[0x01] & 0x03)) {
+            static_cast<Machine*>(user)->writes.push_back(
+                SidWrite{static_cast<unsigned char>(address & 0x1F), value});
+        }
+    }
+
+    std::vector<unsigned char> mem;
+    CPUCONTEXT cpu;
+    CPUOBSERVER observer;
+    std::vector<SidWrite> writes;
+};
+
+
+std::string Format(const char* format, unsigned int a, unsigned int b = 0, unsigned int c = 0,
+                   unsigned int d = 0) {
+    char text[160];
+    std::snprintf(text, sizeof(text), format, a, b, c, d);
+    return text;
+}
+
+
+std::string DescribeCpuError(const CPUCONTEXT& cpu) {
+    if (cpu.error == CPUERR_HALT) {
+        return Format("CPU halt at $%04X", cpu.errorpc);
+    }
+    return Format("unknown opcode $%02X at $%04X", cpu.errorop, cpu.errorpc);
+}
+
+
+class Lockstep {
+public:
+    Lockstep(const C64Memory& original, const DriverConfig& config,
+             const std::vector<unsigned char>& packed_data)
+        : top_(config.driver_code_top), dest_(config.destination_address),
+          size_(packed_data.size() - 2) {
+        original.Read(0, original_.mem.data(), 0x10000);
+        if (dest_ + size_ > 0x10000) {
+            size_ = 0x10000 - dest_;
+        }
+        std::memcpy(&packed_.mem[dest_], packed_data.data() + 2, size_);
+        original_.mem[0x01] = 0x37;
+        packed_.mem[0x01] = 0x37;
+    }
+
+    // Run one init (frame -1) or play call on both machines; false with the
+    // divergence in result
+    bool Call(unsigned short address, unsigned char a, int frame, VerifyResult& result) {
+        initcpu_ctx(&original_.cpu, address, a, 0, 0);
+        initcpu_ctx(&packed_.cpu, Map(address), a, 0, 0);
+
+        for (unsigned int instr = 0;; ++instr) {
+            unsigned short original_pc = original_.cpu.pc;
+            unsigned short packed_pc = packed_.cpu.pc;
+            result.frame = frame;
+            result.original_pc = original_pc;
+            result.packed_pc = packed_pc;
+            if (Map(original_pc) != packed_pc) {
+                result.message = Format("packed tune runs at $%04X, expected $%04X",
+                                        packed_pc, Map(original_pc));
+                return false;
+            }
+            if (instr > kMaxInstructions) {
+                if (frame < 0) {
+                    // As sidplay_init(): an initroutine that never returns is cut off
+                    return true;
+                }
+                result.message = "play call doesn't return";
+                return false;
+            }
+
+            int original_result = original_.Step();
+            int packed_result = packed_.Step();
+            ++result.instructions;
+            if (original_result < 0) {
+                // Nothing to compare against: the entry point or driver range
+                // doesn't fit this SF2
+                result.message = "the original image fails too (" + DescribeCpuError(original_.cpu) +
+                                 "), the driver configuration doesn't fit this SF2";
+                return false;
+            }
+            if (packed_result < 0) {
+                result.message = "packed tune: " + DescribeCpuError(packed_.cpu);
+                return false;
+            }
+            if (!CompareWrites(result)) {
+                return false;
+            }
+            if (original_result != packed_result) {
+                result.message = original_result ? "packed tune returned early"
+                                                 : "packed tune didn't return";
+                return false;
+            }
+            if (original_result == 0) {
+                return true;
+            }
+
+            if (frame < 0) {
+                // Let SID model detection (including $D011 waits) terminate,
+                // the same on both machines
+                for (Machine* machine : {&original_, &packed_}) {
+                    unsigned char* mem = machine->mem.data();
+                    ++mem[0xD012];
+                    if (!mem[0xD012] || ((mem[0xD011] & 0x80) && mem[0xD012] >= 0x38)) {
+                        mem[0xD011] ^= 0x80;
+                        mem[0xD012] = 0x00;
+                    }
+                }
+            } else if ((original_.mem[0x01] & 0x07) != 0x05 &&
+                       (original_.cpu.pc == 0xEA31 || original_.cpu.pc == 0xEA81)) {
+                // Jump into the Kernal interrupt handler exit
+                if (packed_.cpu.pc != original_.cpu.pc) {
+                    result.original_pc = original_.cpu.pc;
+                    result.packed_pc = packed_.cpu.pc;
+                    result.message = Format("packed tune runs at $%04X, expected $%04X",
+                                            packed_.cpu.pc, original_.cpu.pc);
+                    return false;
+                }
+                return true;
+            }
+        }
+    }
+
+private:
+    // Where an original address is in the packed tune: moved by the
+    // relocation delta inside the packed range, the same elsewhere
+    unsigned short Map(unsigned short address) const {
+        if (address >= top_ && address < top_ + size_) {
+            return static_cast<unsigned short>(address - top_ + dest_);
+        }
+        return address;
+    }
+
+    bool CompareWrites(VerifyResult& result) const {
+        const std::vector<SidWrite>& a = original_.writes;
+        const std::vector<SidWrite>& b = packed_.writes;
+        for (size_t i = 0; i < a.size() || i < b.size(); ++i) {
+            if (i >= b.size()) {
+                result.message = Format("original writes $%02X to $D4%02X, packed tune doesn't",
+                                        a[i].value, a[i].reg);
+                return false;
+            }
+            if (i >= a.size()) {
+                result.message = Format("packed tune writes $%02X to $D4%02X, original doesn't",
+                                        b[i].value, b[i].reg);
+                return false;
+            }
+            if (a[i].reg != b[i].reg || a[i].value != b[i].value) {
+                result.message = Format("original writes $%02X to $D4%02X, packed tune $%02X to $D4%02X",
+                                        a[i].value, a[i].reg, b[i].value, b[i].reg);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    Machine original_;
+    Machine packed_;
+    unsigned int top_;
+    unsigned int dest_;
+    unsigned int size_;
+};
+
+} // namespace
+
+
+VerifyResult VerifyRelocation(const C64Memory& original, const DriverConfig& config,
+                              const std::vector<unsigned char>& packed_data,
+                              unsigned short init_address, unsigned short play_address,
+                              unsigned int frames) {
+    VerifyResult result;
+    if (packed_data.size() < 2) {
+        result.ok = false;
+        result.message = "nothing packed";
+        return result;
+    }
+
+    Lockstep lockstep(original, config, packed_data);
+    if (!lockstep.Call(init_address, 0, -1, result)) {
+        result.ok = false;
+        return result;
+    }
+    for (unsigned int frame = 0; frame < frames; ++frame) {
+        if (!lockstep.Call(play_address, 0, static_cast<int>(frame), result)) {
+            result.ok = false;
+            return result;
+        }
+        result.frames = frame + 1;
+    }
+    return result;
+}
+
+
+std::string DescribeVerifyFailure(const VerifyResult& result) {
+    std::string where = (result.frame < 0) ? std::string("init")
+                                           : Format("frame %u", static_cast<unsigned int>(result.frame));
+    return "Relocation check failed in " + where +
+           Format(" (original PC $%04X, packed PC $%04X): ", result.original_pc, result.packed_pc) +
+           result.message;
+}
+
+} // namespace SF2Pack
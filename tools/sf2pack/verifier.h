@@ -0,0 +1,47 @@
+/*
+ * verifier.h - Lockstep Relocation Verifier
+ *
+ * Runs the original SF2 image and the packed tune side by side on two
+ * 6502 contexts (tools/cpu.c) and checks that the relocated code takes
+ * the same path and writes the same SID registers, instruction by
+ * instruction, for a number of frames
+ */
+
+#pragma once
+
+#include "c64memory.h"
+#include "packer_simple.h"
+#include <string>
+#include <vector>
+
+namespace SF2Pack {
+
+struct VerifyResult {
+    bool ok = true;
+    unsigned int frames = 0;            // Play calls compared (init not counted)
+    unsigned long long instructions = 0;
+
+    // First divergence when !ok: the frame (-1 for init), the PC of the
+    // diverging instruction in the original and in the packed tune, and
+    // what differed
+    int frame = 0;
+    unsigned short original_pc = 0;
+    unsigned short packed_pc = 0;
+    std::string message;
+};
+
+// Run init (subtune 0) and frames play calls of the original image, with
+// the driver at config.driver_code_top, and of packed_data (PRG from
+// PackerSimple::Pack(), at config.destination_address). init_address and
+// play_address are original addresses. The packed code must be at the
+// original address plus the relocation delta whenever the original is in
+// the packed range, and at the same address elsewhere.
+VerifyResult VerifyRelocation(const C64Memory& original, const DriverConfig& config,
+                              const std::vector<unsigned char>& packed_data,
+                              unsigned short init_address, unsigned short play_address,
+                              unsigned int frames);
+
+// "Relocation check failed in frame 12 (original PC ..., packed PC ...): ..."
+std::string DescribeVerifyFailure(const VerifyResult& result);
+
+} // namespace SF2Pack
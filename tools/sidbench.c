@@ -0,0 +1,248 @@
+// sidbench - measure the siddump 6502 core on a set of tunes
+//
+// Each tune is played the way siddump plays it (sidplay.c: init, then play
+// calls on the run core) for a fixed number of frames. Only the play calls
+// are timed, so the figures are the core's own speed: 6502 instructions and
+// frames per second of host time. pyscript/bench_native.py runs this as
+// part of `make bench`.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include <sys/stat.h>
+#include "sidplay.h"
+
+#define MAX_PATH_LEN 1024
+
+typedef struct
+{
+  char name[MAX_PATH_LEN];
+  unsigned frames;
+  double instructions;
+  double cycles;
+  double seconds;
+  int failed;
+} TUNERESULT;
+
+static double now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int addtune(TUNERESULT **tunes, int *numtunes, int *maxtunes, const char *name)
+{
+  if (*numtunes == *maxtunes)
+  {
+    int newmax = *maxtunes ? *maxtunes * 2 : 64;
+    TUNERESULT *grown = realloc(*tunes, newmax * sizeof(TUNERESULT));
+    if (!grown) return 0;
+    *tunes = grown;
+    *maxtunes = newmax;
+  }
+  memset(&(*tunes)[*numtunes], 0, sizeof(TUNERESULT));
+  snprintf((*tunes)[*numtunes].name, MAX_PATH_LEN, "%s", name);
+  (*numtunes)++;
+  return 1;
+}
+
+// A SID file, every *.sid of a directory, or the lines of an @listfile
+static int addsource(TUNERESULT **tunes, int *numtunes, int *maxtunes, const char *source)
+{
+  struct stat st;
+
+  if (source[0] == '@')
+  {
+    char line[MAX_PATH_LEN];
+    FILE *list = fopen(&source[1], "r");
+    if (!list)
+    {
+      fprintf(stderr, "Error: couldn't open list file %s.\n", &source[1]);
+      return 1;
+    }
+    while (fgets(line, sizeof line, list))
+    {
+      line[strcspn(line, "\r\n")] = 0;
+      if ((!line[0]) || (line[0] == '#')) continue;
+      if (!addtune(tunes, numtunes, maxtunes, line)) break;
+    }
+    fclose(list);
+  }
+  else if ((!stat(source, &st)) && (S_ISDIR(st.st_mode)))
+  {
+    const char *path;
+    SIDFILEDIR *dir = sidfile_diropen(source, ".sid");
+    if (!dir)
+    {
+      fprintf(stderr, "Error: couldn't open directory %s.\n", source);
+      return 1;
+    }
+    while ((path = sidfile_dirnext(dir)))
+    {
+      if (!addtune(tunes, numtunes, maxtunes, path)) break;
+    }
+    sidfile_dirclose(dir);
+  }
+  else
+    addtune(tunes, numtunes, maxtunes, source);
+  return 0;
+}
+
+// Play one tune for frames frames, or until the playroutine fails
+static void runtune(TUNERESULT *tune, SIDPLAYER *sp, unsigned frames)
+{
+  SIDIMAGE image;
+  char error[128];
+  double start;
+
+  if (sidimage_load(tune->name, &image, error, sizeof error))
+  {
+    fprintf(stderr, "%s (%s)\n", error, tune->name);
+    tune->failed = 1;
+    return;
+  }
+  if (sidplay_init(sp, &image, 0))
+  {
+    fprintf(stderr, "Error: CPU error in init at $%04X (%s)\n", sp->cpu.errorpc, tune->name);
+    tune->failed = 1;
+    sidimage_free(&image);
+    return;
+  }
+
+  start = now();
+  while (tune->frames < frames)
+  {
+    if (sidplay_frame(sp))
+    {
+      fprintf(stderr, "Error: playroutine failed in frame %d (%s)\n", sp->frame, tune->name);
+      tune->failed = 1;
+      break;
+    }
+    tune->frames++;
+    tune->instructions += sp->instructions;
+    tune->cycles += sp->cpu.cpucycles;
+  }
+  tune->seconds = now() - start;
+  sidimage_free(&image);
+}
+
+static double rate(double count, double seconds)
+{
+  return (seconds > 0) ? count / seconds : 0;
+}
+
+static void printjsonstring(const char *s)
+{
+  putchar('"');
+  for (; *s; s++)
+  {
+    if ((*s == '"') || (*s == '\\')) putchar('\\');
+    if ((unsigned char)*s >= 0x20) putchar(*s);
+  }
+  putchar('"');
+}
+
+int main(int argc, char **argv)
+{
+  TUNERESULT *tunes = NULL;
+  TUNERESULT total;
+  SIDPLAYER *sp;
+  unsigned seconds = 60;
+  int numtunes = 0;
+  int maxtunes = 0;
+  int json = 0;
+  int usage = 0;
+  int failed = 0;
+  int c;
+
+  for (c = 1; c < argc; c++)
+  {
+    if (argv[c][0] == '-')
+    {
+      if (!strcmp(argv[c], "-json"))
+      {
+        json = 1;
+        continue;
+      }
+      switch(toupper(argv[c][1]))
+      {
+        case 'T':
+        sscanf(&argv[c][2], "%u", &seconds);
+        break;
+
+        default:
+        usage = 1;
+        break;
+      }
+    }
+    else if (addsource(&tunes, &numtunes, &maxtunes, argv[c])) return 2;
+  }
+
+  if ((usage) || (!numtunes) || (!seconds))
+  {
+    printf("Usage: SIDBENCH <sidfile|directory|@listfile>... [options]\n"
+           "Plays each tune's subtune 0 on the siddump core and reports 6502\n"
+           "instructions and frames per second of the play calls.\n\n"
+           "Options:\n"
+           "-t<value> Playback time per tune in seconds, default 60\n"
+           "-json     Results as JSON\n"
+           "Exit code: 0 all tunes played, 1 a tune failed, 2 usage error\n");
+    free(tunes);
+    return 2;
+  }
+
+  sp = malloc(sizeof(SIDPLAYER));
+  if (!sp)
+  {
+    fprintf(stderr, "Error: out of memory.\n");
+    return 2;
+  }
+
+  memset(&total, 0, sizeof total);
+  for (c = 0; c < numtunes; c++)
+  {
+    runtune(&tunes[c], sp, seconds * 50);
+    failed |= tunes[c].failed;
+    total.frames += tunes[c].frames;
+    total.instructions += tunes[c].instructions;
+    total.cycles += tunes[c].cycles;
+    total.seconds += tunes[c].seconds;
+  }
+  free(sp);
+
+  if (json)
+  {
+    printf("{\"tunes\": %d, \"failed\": %d, \"frames\": %u, \"instructions\": %.0f, \"cycles\": %.0f, \"seconds\": %.6f,\n",
+      numtunes, failed, total.frames, total.instructions, total.cycles, total.seconds);
+    printf(" \"instructions_per_sec\": %.0f, \"frames_per_sec\": %.1f,\n",
+      rate(total.instructions, total.seconds), rate(total.frames, total.seconds));
+    printf(" \"per_tune\": [");
+    for (c = 0; c < numtunes; c++)
+    {
+      printf("%s\n  {\"name\": ", c ? "," : "");
+      printjsonstring(tunes[c].name);
+      printf(", \"frames\": %u, \"instructions\": %.0f, \"seconds\": %.6f, \"failed\": %d}",
+        tunes[c].frames, tunes[c].instructions, tunes[c].seconds, tunes[c].failed);
+    }
+    printf("]}\n");
+  }
+  else
+  {
+    for (c = 0; c < numtunes; c++)
+    {
+      printf("%-40s %6u frames %10.0f instr %8.3f ms %7.2f Minstr/s%s\n", tunes[c].name,
+        tunes[c].frames, tunes[c].instructions, tunes[c].seconds * 1000,
+        rate(tunes[c].instructions, tunes[c].seconds) / 1e6, tunes[c].failed ? " FAIL" : "");
+    }
+    printf("Total: %d tunes, %u frames, %.0f instructions in %.3f s\n",
+      numtunes, total.frames, total.instructions, total.seconds);
+    printf("%.2f million instructions/s, %.0f frames/s\n",
+      rate(total.instructions, total.seconds) / 1e6, rate(total.frames, total.seconds));
+  }
+  free(tunes);
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,353 @@
+// sidcompare - compare the SID register output of two tunes frame by frame
+//
+// Each input is either a SID file, emulated with the siddump core, or a
+// siddump -b binary dump. SID files are played in lockstep, so nothing is
+// written to disk and a run can stop at the first divergent frame.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdint.h>
+#include "sidplay.h"
+#include "dumpformat.h"
+
+#define NUMCHANNELS 4
+#define READCHUNK 1024
+
+// Registers 0-24 as four 64-bit words, bytes 25-31 always zero
+typedef union
+{
+  uint64_t w[4];
+  unsigned char regs[32];
+} FRAMEREGS;
+
+// One side of the comparison
+typedef struct
+{
+  const char *name;
+  SIDIMAGE image;
+  SIDPLAYER *player;
+  FILE *dump;
+  DUMPRECORD *records;
+  unsigned count;
+  unsigned pos;
+  unsigned total;
+  unsigned remaining;
+} SOURCE;
+
+typedef struct
+{
+  unsigned frames;
+  unsigned matching;
+  int firstdiff;
+  FRAMEREGS firsta;
+  FRAMEREGS firstb;
+  unsigned regdiffs[DUMP_NUMREGS];
+  unsigned chndiffs[NUMCHANNELS];
+  unsigned freqdiffs[3];
+} COMPARESTATS;
+
+static const char *channelname[NUMCHANNELS] = {"voice1", "voice2", "voice3", "filter"};
+
+static int channelof(int reg)
+{
+  return (reg < 21) ? reg / 7 : 3;
+}
+
+// Open a SID file or binary dump. maxframes limits SID playback. Returns 0
+// on success, otherwise prints the reason.
+static int opensource(SOURCE *src, const char *name, int subtune, unsigned maxframes)
+{
+  DUMPHEADER header;
+  char error[128];
+  FILE *in;
+
+  memset(src, 0, sizeof *src);
+  src->name = name;
+  in = fopen(name, "rb");
+  if (!in)
+  {
+    fprintf(stderr, "Error: couldn't open %s.\n", name);
+    return 1;
+  }
+  if ((fread(&header, sizeof header, 1, in) == 1) && (!memcmp(header.magic, DUMP_MAGIC, 4)))
+  {
+    if ((header.version != DUMP_VERSION) || (header.recordsize != sizeof(DUMPRECORD)))
+    {
+      fprintf(stderr, "Error: %s is an unsupported dump version.\n", name);
+      fclose(in);
+      return 1;
+    }
+    fseek(in, header.headersize, SEEK_SET);
+    src->records = malloc(READCHUNK * sizeof(DUMPRECORD));
+    if (!src->records)
+    {
+      fprintf(stderr, "Error: out of memory.\n");
+      fclose(in);
+      return 1;
+    }
+    src->dump = in;
+    src->total = src->remaining = header.framecount;
+    return 0;
+  }
+  fclose(in);
+
+  if (sidimage_load(name, &src->image, error, sizeof error))
+  {
+    fprintf(stderr, "%s (%s)\n", error, name);
+    return 1;
+  }
+  src->player = malloc(sizeof(SIDPLAYER));
+  if (!src->player)
+  {
+    fprintf(stderr, "Error: out of memory.\n");
+    return 1;
+  }
+  if (sidplay_init(src->player, &src->image, subtune))
+  {
+    fprintf(stderr, "Error: CPU error in init at $%04X (%s)\n", src->player->cpu.errorpc, name);
+    return 1;
+  }
+  src->total = src->remaining = maxframes;
+  return 0;
+}
+
+// Fetch the next frame's registers. Returns 1 for a frame, 0 at the end,
+// -1 on an error.
+static int nextframe(SOURCE *src, FRAMEREGS *frame)
+{
+  if (!src->remaining) return 0;
+  memset(frame, 0, sizeof *frame);
+  if (src->dump)
+  {
+    if (src->pos == src->count)
+    {
+      unsigned want = (src->remaining < READCHUNK) ? src->remaining : READCHUNK;
+
+      src->count = fread(src->records, sizeof(DUMPRECORD), want, src->dump);
+      src->pos = 0;
+      if (!src->count)
+      {
+        fprintf(stderr, "Error: %s is truncated.\n", src->name);
+        return -1;
+      }
+    }
+    memcpy(frame->regs, src->records[src->pos++].regs, DUMP_NUMREGS);
+  }
+  else
+  {
+    int result = sidplay_frame(src->player);
+
+    if (result == SIDPLAY_LIMIT)
+    {
+      fprintf(stderr, "Error: playroutine doesn't return, frame %d (%s)\n", src->player->frame, src->name);
+      return -1;
+    }
+    if (result < 0)
+    {
+      fprintf(stderr, "Error: CPU error in playroutine at $%04X, frame %d (%s)\n", src->player->cpu.errorpc, src->player->frame, src->name);
+      return -1;
+    }
+    memcpy(frame->regs, &src->player->mem[0xd400], DUMP_NUMREGS);
+  }
+  src->remaining--;
+  return 1;
+}
+
+static void closesource(SOURCE *src)
+{
+  if (src->dump) fclose(src->dump);
+  free(src->records);
+  free(src->player);
+  sidimage_free(&src->image);
+}
+
+// Add one frame pair to the statistics. Frames are compared a word at a
+// time; only a frame that differs is broken down per register.
+static int compareframe(COMPARESTATS *stats, const FRAMEREGS *a, const FRAMEREGS *b)
+{
+  FRAMEREGS diff;
+  int chn[NUMCHANNELS] = {0, 0, 0, 0};
+  int c;
+
+  diff.w[0] = a->w[0] ^ b->w[0];
+  diff.w[1] = a->w[1] ^ b->w[1];
+  diff.w[2] = a->w[2] ^ b->w[2];
+  diff.w[3] = a->w[3] ^ b->w[3];
+  stats->frames++;
+  if (!(diff.w[0] | diff.w[1] | diff.w[2] | diff.w[3]))
+  {
+    stats->matching++;
+    return 0;
+  }
+
+  for (c = 0; c < DUMP_NUMREGS; c++)
+  {
+    if (diff.regs[c])
+    {
+      stats->regdiffs[c]++;
+      chn[channelof(c)] = 1;
+    }
+  }
+  for (c = 0; c < NUMCHANNELS; c++) stats->chndiffs[c] += chn[c];
+  for (c = 0; c < 3; c++)
+  {
+    if ((diff.regs[c * 7]) || (diff.regs[c * 7 + 1])) stats->freqdiffs[c]++;
+  }
+  if (stats->firstdiff < 0)
+  {
+    stats->firstdiff = stats->frames - 1;
+    stats->firsta = *a;
+    stats->firstb = *b;
+  }
+  return 1;
+}
+
+static double percent(unsigned part, unsigned total)
+{
+  return total ? (double)part * 100.0 / total : 100.0;
+}
+
+static void printtext(const COMPARESTATS *stats, const SOURCE *a, const SOURCE *b)
+{
+  int c;
+
+  printf("A: %s\nB: %s\n", a->name, b->name);
+  printf("Frames compared: %u", stats->frames);
+  if (a->total != b->total) printf(" (A has %u, B has %u)", a->total, b->total);
+  printf("\nMatching frames: %u (%.2f%%)\n", stats->matching, percent(stats->matching, stats->frames));
+  if (stats->firstdiff < 0)
+  {
+    printf("No divergent frames\n");
+    return;
+  }
+  printf("First divergent frame: %d\n", stats->firstdiff);
+  for (c = 0; c < DUMP_NUMREGS; c++)
+  {
+    if (stats->firsta.regs[c] != stats->firstb.regs[c])
+      printf("  $D4%02X: A=$%02X B=$%02X\n", c, stats->firsta.regs[c], stats->firstb.regs[c]);
+  }
+  printf("Mismatching frames per channel:\n");
+  for (c = 0; c < NUMCHANNELS; c++)
+    printf("  %-7s %7u (%.2f%%)\n", channelname[c], stats->chndiffs[c], percent(stats->chndiffs[c], stats->frames));
+  printf("Mismatching frames per register:\n");
+  for (c = 0; c < DUMP_NUMREGS; c++)
+  {
+    if (stats->regdiffs[c])
+      printf("  $D4%02X  %7u (%.2f%%)\n", c, stats->regdiffs[c], percent(stats->regdiffs[c], stats->frames));
+  }
+}
+
+static void printjson(const COMPARESTATS *stats, const SOURCE *a, const SOURCE *b)
+{
+  int c;
+
+  printf("{\"frames\": %u, \"frames_a\": %u, \"frames_b\": %u, \"matching\": %u, \"first_diff\": %d,\n",
+    stats->frames, a->total, b->total, stats->matching, stats->firstdiff);
+  printf(" \"channels\": {");
+  for (c = 0; c < NUMCHANNELS; c++)
+    printf("%s\"%s\": %u", c ? ", " : "", channelname[c], stats->chndiffs[c]);
+  printf("}, \"frequency\": [%u, %u, %u],\n \"registers\": [", stats->freqdiffs[0], stats->freqdiffs[1], stats->freqdiffs[2]);
+  for (c = 0; c < DUMP_NUMREGS; c++)
+    printf("%s%u", c ? ", " : "", stats->regdiffs[c]);
+  printf("]");
+  if (stats->firstdiff >= 0)
+  {
+    printf(",\n \"first_a\": [");
+    for (c = 0; c < DUMP_NUMREGS; c++) printf("%s%u", c ? ", " : "", stats->firsta.regs[c]);
+    printf("],\n \"first_b\": [");
+    for (c = 0; c < DUMP_NUMREGS; c++) printf("%s%u", c ? ", " : "", stats->firstb.regs[c]);
+    printf("]");
+  }
+  printf("}\n");
+}
+
+int main(int argc, char **argv)
+{
+  COMPARESTATS stats;
+  SOURCE a, b;
+  const char *name[2] = {NULL, NULL};
+  unsigned seconds = 60;
+  unsigned subtune = 0;
+  int json = 0;
+  int stopfirst = 0;
+  int usage = 0;
+  int ra, rb;
+  int c;
+
+  for (c = 1; c < argc; c++)
+  {
+    if (argv[c][0] == '-')
+    {
+      if (!strcmp(argv[c], "-json"))
+      {
+        json = 1;
+        continue;
+      }
+      switch(toupper(argv[c][1]))
+      {
+        case 'A':
+        sscanf(&argv[c][2], "%u", &subtune);
+        break;
+
+        case 'Q':
+        stopfirst = 1;
+        break;
+
+        case 'T':
+        sscanf(&argv[c][2], "%u", &seconds);
+        break;
+
+        default:
+        usage = 1;
+        break;
+      }
+    }
+    else if (!name[0]) name[0] = argv[c];
+    else if (!name[1]) name[1] = argv[c];
+    else usage = 1;
+  }
+
+  if ((usage) || (!name[1]))
+  {
+    printf("Usage: SIDCOMPARE <a.sid|a.sdb> <b.sid|b.sdb> [options]\n"
+           "Compares $D400-$D418 frame by frame. SID files are emulated in lockstep,\n"
+           ".sdb files are siddump -b binary dumps.\n\n"
+           "Options:\n"
+           "-a<value> Subtune of SID inputs, default 0\n"
+           "-t<value> Playback time of SID inputs in seconds, default 60\n"
+           "-q        Stop at the first divergent frame\n"
+           "-json     Statistics as JSON\n"
+           "Exit code: 0 identical, 1 different, 2 error\n");
+    return 2;
+  }
+
+  if (opensource(&a, name[0], subtune, seconds * 50)) return 2;
+  if (opensource(&b, name[1], subtune, seconds * 50))
+  {
+    closesource(&a);
+    return 2;
+  }
+
+  memset(&stats, 0, sizeof stats);
+  stats.firstdiff = -1;
+  for (;;)
+  {
+    FRAMEREGS fa, fb;
+
+    ra = nextframe(&a, &fa);
+    rb = nextframe(&b, &fb);
+    if ((ra <= 0) || (rb <= 0)) break;
+    if ((compareframe(&stats, &fa, &fb)) && (stopfirst)) break;
+  }
+  closesource(&a);
+  closesource(&b);
+  if ((ra < 0) || (rb < 0)) return 2;
+
+  if (json)
+    printjson(&stats, &a, &b);
+  else
+    printtext(&stats, &a, &b);
+  return ((stats.firstdiff >= 0) || (a.total != b.total)) ? 1 : 0;
+}
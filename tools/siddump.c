@@ -3,24 +3,34 @@
 #include <string.h>
 #include <math.h>
 #include <ctype.h>
+#include <stdarg.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <pthread.h>
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#endif
 #include "cpu.h"
-
-// Memory trace globals
-int trace_enabled = 0;
-int trace_frame = -1;
-FILE *trace_log = NULL;
+#include "sidplay.h"
+#include "dumpformat.h"
+#include "tracebuf.h"
+#include "sidwrite.h"
+#include "coverage.h"
+#include "sidserve.h"
+#include "checkpoint.h"
+#include "loopdetect.h"
+#include "profiler.h"
+#include "notetrack.h"
 
 
 #define MAX_INSTR 0x100000
+#define MAX_PATH_LEN 1024
 
-typedef struct
-{
-  unsigned short freq;
-  unsigned short pulse;
-  unsigned short adsr;
-  unsigned char wave;
-  int note;
-} CHANNEL;
+// Playroutine engines (-engine=)
+#define ENGINE_FAST 0
+#define ENGINE_SWITCH 1
+#define ENGINE_BLOCK 2
 
 typedef struct
 {
@@ -29,17 +39,93 @@ typedef struct
   unsigned char type;
 } FILTER;
 
-int main(int argc, char **argv);
-unsigned char readbyte(FILE *f);
-unsigned short readword(FILE *f);
-
-CHANNEL chn[3];
-CHANNEL prevchn[3];
-CHANNEL prevchn2[3];
-FILTER filt;
-FILTER prevfilt;
+// Dump settings shared by every file of a run
+typedef struct
+{
+  int subtune;
+  int seconds;
+  int spacing;
+  int pattspacing;
+  int firstframe;
+  int lowres;
+  int oldnotefactor;
+  int timeseconds;
+  int profiling;
+  int binary;
+  FILE *tracelog;
+  TRACEBUF *tracebuf;
+  unsigned tracestart;
+  unsigned traceend;
+  unsigned tracefirst;
+  unsigned tracelast;
+  SIDWRITEBUF *sidwrites;
+  COVERAGE *coverage;
+  NOTEFILE *notes;
+  const NOTETABLE *notetable;
+  const char *cachedir;
+  unsigned cacheinterval;
+  int loopdetect;
+  int engine;
+  int allsubtunes;
+  int profile;
+  const char *profilefile;
+  int stats;
+  const char *statsfile;
+} DUMPOPTIONS;
+
+// Run statistics for -stats-json. The dump only adds to these; they are
+// formatted once at the end. Times are wall clock seconds: load is reading
+// the SID file, play the play calls themselves and output everything else
+// in the frame loop (register decoding, formatting, writing).
+typedef struct
+{
+  double loadtime;
+  double inittime;
+  double playtime;
+  double outputtime;
+  unsigned initinstr;
+  unsigned long long playinstr;
+  unsigned long long cycles;
+  unsigned maxcycles;
+  unsigned frames;
+  unsigned long long bytesread;
+  unsigned long long byteswritten;
+  int warnings;
+} DUMPSTATS;
+
+// One SID file to dump. status is 0 on success, error holds the reason
+// for a failure so batch mode can report it in the summary. loopstart is
+// -1 unless -loop found the tune repeating. image and subtune are set for
+// -all jobs (image NULL: load sidname; subtune -1: use -a).
+typedef struct
+{
+  char sidname[MAX_PATH_LEN];
+  char outname[MAX_PATH_LEN * 2];
+  const SIDIMAGE *image;
+  int subtune;
+  int status;
+  int frames;
+  int loopstart;
+  int looplength;
+  char error[128];
+  DUMPSTATS stats;
+} DUMPJOB;
+
+// Work queue for batch mode
+typedef struct
+{
+  const DUMPOPTIONS *options;
+  DUMPJOB *jobs;
+  int numjobs;
+  int nextjob;
+  pthread_mutex_t lock;
+} JOBQUEUE;
 
-extern unsigned short pc;
+int main(int argc, char **argv);
+int loadsid(DUMPJOB *job, SIDIMAGE *image, FILE *msg);
+int dumpsid(DUMPJOB *job, const DUMPOPTIONS *opt, FILE *out, FILE *msg);
+int runbatch(const char *source, const char *outdir, int workers, const DUMPOPTIONS *opt);
+int writestats(const char *name, const DUMPJOB *jobs, int numjobs, int subtune, int batch);
 
 const char *notename[] =
  {"C-0", "C#0", "D-0", "D#0", "E-0", "F-0", "F#0", "G-0", "G#0", "A-0", "A#0", "B-0",
@@ -74,40 +160,131 @@ unsigned char freqtblhi[] = {
   0x45,0x49,0x4e,0x52,0x57,0x5c,0x62,0x68,0x6e,0x75,0x7c,0x83,
   0x8b,0x93,0x9c,0xa5,0xaf,0xb9,0xc4,0xd0,0xdd,0xea,0xf8,0xff};
 
+
 int main(int argc, char **argv)
 {
-  int subtune = 0;
-  int seconds = 60;
-  int instr = 0;
-  int frames = 0;
-  int spacing = 0;
-  int pattspacing = 0;
-  int firstframe = 0;
-  int counter = 0;
+  DUMPOPTIONS opt;
+  DUMPJOB job;
   int basefreq = 0;
   int basenote = 0xb0;
-  int lowres = 0;
-  int rows = 0;
-  int oldnotefactor = 1;
-  int timeseconds = 0;
   int usage = 0;
-  int profiling = 0;
-  unsigned loadend;
-  unsigned loadpos;
-  unsigned loadsize;
-  unsigned loadaddress;
-  unsigned initaddress;
-  unsigned playaddress;
-  unsigned dataoffset;
-  FILE *in;
+  int workers = 1;
   char *sidname = 0;
+  char *outdir = 0;
+  char *tracefile = 0;
+  TRACEBUF tracebuf;
+  char *sidwritefile = 0;
+  SIDWRITEBUF sidwrites;
+  char *coveragefile = 0;
+  unsigned coverageinterval = 0;
+  COVERAGE coverage;
+  char *notesfile = 0;
+  NOTEFILE notes;
+  static NOTETABLE notetable;
+  struct stat st;
   int c;
 
+  // Service mode: requests on stdin instead of a dump, see sidserve.c
+  if ((argc == 2) && (!strcmp(argv[1], "-serve"))) return sidserve(stdin, stdout);
+
+  memset(&opt, 0, sizeof opt);
+  opt.seconds = 60;
+  opt.oldnotefactor = 1;
+  opt.traceend = 0xffff;
+  opt.tracelast = TRACE_INITFRAME;
+  opt.cacheinterval = CHECKPOINT_INTERVAL;
+
   // Scan arguments
   for (c = 1; c < argc; c++)
   {
     if (argv[c][0] == '-')
     {
+      if (!strncmp(argv[c], "-outdir=", 8))
+      {
+        outdir = &argv[c][8];
+        continue;
+      }
+      if (!strncmp(argv[c], "-cache=", 7))
+      {
+        opt.cachedir = &argv[c][7];
+        continue;
+      }
+      if (!strncmp(argv[c], "-cacheinterval=", 15))
+      {
+        sscanf(&argv[c][15], "%u", &opt.cacheinterval);
+        if (opt.cacheinterval < 1) opt.cacheinterval = 1;
+        continue;
+      }
+      if (!strncmp(argv[c], "-engine=", 8))
+      {
+        if (!strcmp(&argv[c][8], "fast")) opt.engine = ENGINE_FAST;
+        else if (!strcmp(&argv[c][8], "switch")) opt.engine = ENGINE_SWITCH;
+        else if (!strcmp(&argv[c][8], "block")) opt.engine = ENGINE_BLOCK;
+        else usage = 1;
+        continue;
+      }
+      if ((!strcmp(argv[c], "-profile")) || (!strncmp(argv[c], "-profile=", 9)))
+      {
+        opt.profile = 1;
+        if (argv[c][8] == '=') opt.profilefile = &argv[c][9];
+        continue;
+      }
+      // --stats-json as in sf2pack, but the file still goes after a '='
+      if ((!strcmp(argv[c], "-stats-json")) || (!strncmp(argv[c], "-stats-json=", 12)) ||
+        (!strcmp(argv[c], "--stats-json")) || (!strncmp(argv[c], "--stats-json=", 13)))
+      {
+        const char *name = (argv[c][1] == '-') ? &argv[c][1] : argv[c];
+
+        opt.stats = 1;
+        if (name[11] == '=') opt.statsfile = &name[12];
+        continue;
+      }
+      if (!strcmp(argv[c], "-all"))
+      {
+        opt.allsubtunes = 1;
+        continue;
+      }
+      if (!strcmp(argv[c], "-loop"))
+      {
+        opt.loopdetect = 1;
+        continue;
+      }
+      if (!strncmp(argv[c], "-tracebin=", 10))
+      {
+        tracefile = &argv[c][10];
+        continue;
+      }
+      if (!strncmp(argv[c], "-sidwrites=", 11))
+      {
+        sidwritefile = &argv[c][11];
+        continue;
+      }
+      if (!strncmp(argv[c], "-notes=", 7))
+      {
+        notesfile = &argv[c][7];
+        continue;
+      }
+      if (!strncmp(argv[c], "-coverage=", 10))
+      {
+        coveragefile = &argv[c][10];
+        continue;
+      }
+      if (!strncmp(argv[c], "-coverageinterval=", 18))
+      {
+        sscanf(&argv[c][18], "%u", &coverageinterval);
+        continue;
+      }
+      if (!strncmp(argv[c], "-tracerange=", 12))
+      {
+        sscanf(&argv[c][12], "%x-%x", &opt.tracestart, &opt.traceend);
+        continue;
+      }
+      if (!strncmp(argv[c], "-traceframes=", 13))
+      {
+        sscanf(&argv[c][13], "%u-%u", &opt.tracefirst, &opt.tracelast);
+        continue;
+      }
+
       switch(toupper(argv[c][1]))
       {
         case '?':
@@ -115,7 +292,11 @@ int main(int argc, char **argv)
         break;
 
         case 'A':
-        sscanf(&argv[c][2], "%u", &subtune);
+        sscanf(&argv[c][2], "%u", &opt.subtune);
+        break;
+
+        case 'B':
+        opt.binary = 1;
         break;
 
         case 'C':
@@ -127,36 +308,41 @@ int main(int argc, char **argv)
         break;
 
         case 'F':
-        sscanf(&argv[c][2], "%u", &firstframe);
+        sscanf(&argv[c][2], "%u", &opt.firstframe);
+        break;
+
+        case 'J':
+        sscanf(&argv[c][2], "%u", &workers);
+        if (workers < 1) workers = 1;
         break;
 
         case 'L':
-        lowres = 1;
+        opt.lowres = 1;
         break;
 
         case 'N':
-        sscanf(&argv[c][2], "%u", &spacing);
+        sscanf(&argv[c][2], "%u", &opt.spacing);
         break;
 
         case 'O':
-        sscanf(&argv[c][2], "%u", &oldnotefactor);
-        if (oldnotefactor < 1) oldnotefactor = 1;
+        sscanf(&argv[c][2], "%u", &opt.oldnotefactor);
+        if (opt.oldnotefactor < 1) opt.oldnotefactor = 1;
         break;
 
         case 'P':
-        sscanf(&argv[c][2], "%u", &pattspacing);
+        sscanf(&argv[c][2], "%u", &opt.pattspacing);
         break;
 
         case 'S':
-        timeseconds = 1;
+        opt.timeseconds = 1;
         break;
 
         case 'T':
-        sscanf(&argv[c][2], "%u", &seconds);
+        sscanf(&argv[c][2], "%u", &opt.seconds);
         break;
         
         case 'Z':
-        profiling = 1;
+        opt.profiling = 1;
         break;
       }
     }
@@ -171,14 +357,13 @@ int main(int argc, char **argv)
   // Check for -trace option
   for (c = 1; c < argc; c++)
   {
-    if (!strcmp(argv[c], "-trace"))
+    if ((!strcmp(argv[c], "-trace")) && (!opt.tracelog))
     {
-      trace_log = fopen("siddump_trace.txt", "w");
-      trace_enabled = 1;
-      if (trace_log)
+      opt.tracelog = fopen("siddump_trace.txt", "w");
+      if (opt.tracelog)
       {
-        fprintf(trace_log, "SIDDUMP MEMORY TRACE\n");
-        fprintf(trace_log, "Format: Frame PC MemAddr Value\n\n");
+        fprintf(opt.tracelog, "SIDDUMP MEMORY TRACE\n");
+        fprintf(opt.tracelog, "Format: Frame PC MemAddr Value\n\n");
       }
     }
   }
@@ -186,12 +371,17 @@ int main(int argc, char **argv)
   if ((argc < 2) || (usage))
   {
     printf("Usage: SIDDUMP <sidfile> [options]\n"
+           "       SIDDUMP <directory|@listfile> [options] (batch mode)\n"
+           "       SIDDUMP -serve (JSON requests on stdin, see sidserve.c)\n"
            "Warning: CPU emulation may be buggy/inaccurate, illegals support very limited\n\n"
            "Options:\n"
            "-a<value> Accumulator value on init (subtune number) default = 0\n"
+           "-all      Dump every subtune, in parallel with -j, to <name>_<subtune>.dump\n"
+           "-b        Binary frame dump (raw $D400-$D418 + cycles per frame, see dumpformat.h)\n"
            "-c<value> Frequency recalibration. Give note frequency in hex\n"
            "-d<value> Select calibration note (abs.notation 80-DF). Default middle-C (B0)\n"
            "-f<value> First frame to display, default 0\n"
+           "-j<value> Batch mode worker threads, default 1\n"
            "-l        Low-resolution mode (only display 1 row per note)\n"
            "-n<value> Note spacing, default 0 (none)\n"
            "-o<value> ""Oldnote-sticky"" factor. Default 1, increase for better vibrato display\n"
@@ -199,7 +389,29 @@ int main(int argc, char **argv)
            "-p<value> Pattern spacing, default 0 (none)\n"
            "-s        Display time in minutes:seconds:frame format\n"
            "-t<value> Playback time in seconds, default 60\n"
-           "-z        Include CPU cycles+rastertime (PAL)+rastertime, badline corrected\n");
+           "-z        Include CPU cycles+rastertime (PAL)+rastertime, badline corrected\n"
+           "-outdir=<dir> Batch mode output directory, default next to each SID file\n"
+           "-engine=<fast|block|switch> Playroutine CPU engine, default fast. block runs\n"
+           "          cached decoded basic blocks, switch is the reference\n"
+           "          one-instruction-per-call core\n"
+           "-loop     Stop when the tune loops (state repeats) and report the loop point\n"
+           "-profile[=<file>] Per-routine and per-PC cycle profile of the playroutine.\n"
+           "          Optional file: JSON if it ends in .json, else folded stacks\n"
+           "-stats-json[=<file>] Timings, instruction and cycle counts and bytes\n"
+           "          read/written as JSON, to the file or stderr (also --stats-json)\n"
+           "-cache=<dir> Frame checkpoint cache, makes -f seek without replaying from init\n"
+           "-cacheinterval=<value> Frames between checkpoints, default 500\n"
+           "-trace    Text log of $1800-$1BFF reads in the first 10 frames (siddump_trace.txt)\n"
+           "-tracebin=<file> Binary trace of memory reads/writes (format in dumpformat.h)\n"
+           "-tracerange=<start>-<end> Address window for -tracebin in hex, default 0000-FFFF\n"
+           "-traceframes=<first>-<last> Frame range for -tracebin, default all\n"
+           "-sidwrites=<file> Every SID register write with its cycle, init and play\n"
+           "          (format in dumpformat.h)\n"
+           "-coverage=<file> Execute/read/write bitmaps of init and play and the frame\n"
+           "          each address was first touched (format in dumpformat.h)\n"
+           "-coverageinterval=<value> Play calls per -coverage snapshot, default 0 (all)\n"
+           "-notes=<file> Key on, note change and key off events of the displayed frames\n"
+           "          (format in dumpformat.h)\n");
     return 1;
   }
 
@@ -225,8 +437,11 @@ int main(int argc, char **argv)
     }
   }
 
+  notetable_build(&notetable, freqtbllo, freqtblhi);
+  opt.notetable = &notetable;
+
   // Check other parameters for correctness
-  if ((lowres) && (!spacing)) lowres = 0;
+  if ((opt.lowres) && (!opt.spacing)) opt.lowres = 0;
 
   // Open SID file
   if (!sidname)
@@ -235,312 +450,1097 @@ int main(int argc, char **argv)
     return 1;
   }
 
-  in = fopen(sidname, "rb");
-  if (!in)
+  // A directory or @listfile selects batch mode, as does -all
+  if ((opt.allsubtunes) || (sidname[0] == '@') || ((!stat(sidname, &st)) && (S_ISDIR(st.st_mode))))
   {
-    printf("Error: couldn't open SID file.\n");
+    if ((opt.tracelog) || (tracefile) || (sidwritefile) || (coveragefile) || (notesfile) || (opt.profile))
+    {
+      printf("Warning: -trace, -tracebin, -sidwrites, -coverage, -notes and -profile are ignored in batch mode.\n");
+      if (opt.tracelog) fclose(opt.tracelog);
+      opt.tracelog = NULL;
+      opt.profile = 0;
+    }
+    return runbatch(sidname, outdir, workers, &opt);
+  }
+
+  if ((opt.profile) && ((opt.tracelog) || (tracefile) || (sidwritefile) || (coveragefile)))
+  {
+    printf("Error: -profile can't be combined with -trace, -tracebin, -sidwrites or -coverage.\n");
     return 1;
   }
 
-  // Read interesting parts of the SID header
-  fseek(in, 6, SEEK_SET);
-  dataoffset = readword(in);
-  loadaddress = readword(in);
-  initaddress = readword(in);
-  playaddress = readword(in);
-  fseek(in, dataoffset, SEEK_SET);
-  if (loadaddress == 0)
-    loadaddress = readbyte(in) | (readbyte(in) << 8);
-
-  // Load the C64 data
-  loadpos = ftell(in);
-  fseek(in, 0, SEEK_END);
-  loadend = ftell(in);
-  fseek(in, loadpos, SEEK_SET);
-  loadsize = loadend - loadpos;
-  if (loadsize + loadaddress >= 0x10000)
-  {
-    printf("Error: SID data continues past end of C64 memory.\n");
-    fclose(in);
+  if ((sidwritefile) && (opt.firstframe + opt.seconds*50 > SIDWRITE_MAXFRAMES))
+  {
+    printf("Error: -sidwrites cycle stamps only reach frame %d (%d seconds).\n", SIDWRITE_MAXFRAMES, SIDWRITE_MAXFRAMES / 50);
     return 1;
   }
-  fread(&mem[loadaddress], loadsize, 1, in);
-  fclose(in);
 
-  // Print info & run initroutine
-  printf("Load address: $%04X Init address: $%04X Play address: $%04X\n", loadaddress, initaddress, playaddress);
-  printf("Calling initroutine with subtune %d\n", subtune);
-  mem[0x01] = 0x37;
-  initcpu(initaddress, subtune, 0, 0);
-  instr = 0;
-  while (runcpu())
+  if (tracefile)
   {
-    // Allow SID model detection (including $d011 wait) to eventually terminate
-    ++mem[0xd012];
-    if (!mem[0xd012] || ((mem[0xd011] & 0x80) && mem[0xd012] >= 0x38))
+    TRACEHEADER traceheader;
+
+    if ((opt.traceend > 0xffff) || (opt.tracestart > opt.traceend) || (opt.tracefirst > opt.tracelast))
     {
-        mem[0xd011] ^= 0x80;
-        mem[0xd012] = 0x00;
+      printf("Error: invalid -tracerange or -traceframes.\n");
+      return 1;
     }
-    instr++;
-    if (instr > MAX_INSTR)
+    memset(&traceheader, 0, sizeof traceheader);
+    traceheader.windowstart = opt.tracestart;
+    traceheader.windowend = opt.traceend;
+    traceheader.subtune = opt.subtune;
+    traceheader.firstframe = opt.tracefirst;
+    traceheader.lastframe = opt.tracelast;
+    if (tracebuf_open(&tracebuf, tracefile, &traceheader))
     {
-      printf("Warning: CPU executed a high number of instructions in init, breaking\n");
-      break;
+      printf("Error: couldn't create trace file %s.\n", tracefile);
+      return 1;
     }
+    opt.tracebuf = &tracebuf;
   }
 
-  if (playaddress == 0)
+  if (sidwritefile)
   {
-    printf("Warning: SID has play address 0, reading from interrupt vector instead\n");
-    if ((mem[0x01] & 0x07) == 0x5)
-      playaddress = mem[0xfffe] | (mem[0xffff] << 8);
-    else
-      playaddress = mem[0x314] | (mem[0x315] << 8);
-    printf("New play address is $%04X\n", playaddress);
+    if (sidwrite_open(&sidwrites, sidwritefile, opt.subtune))
+    {
+      printf("Error: couldn't create SID write file %s.\n", sidwritefile);
+      if (opt.tracebuf) tracebuf_close(opt.tracebuf);
+      return 1;
+    }
+    opt.sidwrites = &sidwrites;
   }
 
-  // Clear channelstructures in preparation & print first time info
-  memset(&chn, 0, sizeof chn);
-  memset(&filt, 0, sizeof filt);
-  memset(&prevchn, 0, sizeof prevchn);
-  memset(&prevchn2, 0, sizeof prevchn2);
-  memset(&prevfilt, 0, sizeof prevfilt);
-  printf("Calling playroutine for %d frames, starting from frame %d\n", seconds*50, firstframe);
-  printf("Middle C frequency is $%04X\n\n", freqtbllo[48] | (freqtblhi[48] << 8));
-  printf("| Frame | Freq Note/Abs WF ADSR Pul | Freq Note/Abs WF ADSR Pul | Freq Note/Abs WF ADSR Pul | FCut RC Typ V |");
-  if (profiling)
-  { // CPU cycles, Raster lines, Raster lines with badlines on every 8th line, first line included
-    printf(" Cycl RL RB |");
+  if (coveragefile)
+  {
+    if (coverage_open(&coverage, coveragefile, opt.subtune, coverageinterval))
+    {
+      printf("Error: couldn't create coverage file %s.\n", coveragefile);
+      if (opt.tracebuf) tracebuf_close(opt.tracebuf);
+      if (opt.sidwrites) sidwrite_close(opt.sidwrites);
+      return 1;
+    }
+    opt.coverage = &coverage;
   }
-  printf("\n");
-  printf("+-------+---------------------------+---------------------------+---------------------------+---------------+");
-  if (profiling)
+
+  if (notesfile)
   {
-    printf("------------+");
+    if (notefile_open(&notes, notesfile, opt.subtune, opt.firstframe, notetable.freq[48]))
+    {
+      printf("Error: couldn't create note event file %s.\n", notesfile);
+      if (opt.tracebuf) tracebuf_close(opt.tracebuf);
+      if (opt.sidwrites) sidwrite_close(opt.sidwrites);
+      if (opt.coverage) coverage_close(opt.coverage);
+      return 1;
+    }
+    opt.notes = &notes;
   }
-  printf("\n");
 
-  // Data collection & display loop
-  while (frames < firstframe + seconds*50)
+  memset(&job, 0, sizeof job);
+  snprintf(job.sidname, sizeof job.sidname, "%s", sidname);
+  job.subtune = -1;
+  if (opt.binary)
   {
-    int c;
+#ifdef _WIN32
+    _setmode(_fileno(stdout), _O_BINARY);
+#endif
+    c = dumpsid(&job, &opt, stdout, stderr);
+  }
+  else
+    c = dumpsid(&job, &opt, stdout, stdout);
+  if ((opt.stats) && (writestats(opt.statsfile, &job, 1, opt.subtune, 0)))
+  {
+    fprintf(opt.binary ? stderr : stdout, "Error: writing statistics %s failed.\n", opt.statsfile);
+    c = 1;
+  }
 
-    // Run the playroutine
-    instr = 0;
-    initcpu(playaddress, 0, 0, 0);
-    while (runcpu())
+  if (opt.tracelog)
+  {
+    fclose(opt.tracelog);
+  }
+  if (opt.tracebuf)
+  {
+    if (tracebuf_close(opt.tracebuf))
     {
-      instr++;
-      if (instr > MAX_INSTR)
-      {
-        printf("Error: CPU executed abnormally high amount of instructions in playroutine, exiting\n");
-        return 1;
-      }
-      // Test for jump into Kernal interrupt handler exit
-      if ((mem[0x01] & 0x07) != 0x5 && (pc == 0xea31 || pc == 0xea81))
-        break;
+      fprintf(opt.binary ? stderr : stdout, "Error: writing trace file %s failed.\n", tracefile);
+      c = 1;
     }
-
-    // Get SID parameters from each channel and the filter
-    for (c = 0; c < 3; c++)
+  }
+  if (opt.sidwrites)
+  {
+    if (sidwrite_close(opt.sidwrites))
     {
-      chn[c].freq = mem[0xd400 + 7*c] | (mem[0xd401 + 7*c] << 8);
-      chn[c].pulse = (mem[0xd402 + 7*c] | (mem[0xd403 + 7*c] << 8)) & 0xfff;
-      chn[c].wave = mem[0xd404 + 7*c];
-      chn[c].adsr = mem[0xd406 + 7*c] | (mem[0xd405 + 7*c] << 8);
+      fprintf(opt.binary ? stderr : stdout, "Error: writing SID write file %s failed.\n", sidwritefile);
+      c = 1;
     }
-    filt.cutoff = (mem[0xd415] << 5) | (mem[0xd416] << 8);
-    filt.ctrl = mem[0xd417];
-    filt.type = mem[0xd418];
-
-    // Frame display
-    if (frames >= firstframe)
+  }
+  if (opt.coverage)
+  {
+    if (coverage_close(opt.coverage))
     {
-      char output[512];
-      int time = frames - firstframe;
-      output[0] = 0;      
+      fprintf(opt.binary ? stderr : stdout, "Error: writing coverage file %s failed.\n", coveragefile);
+      c = 1;
+    }
+  }
+  if (opt.notes)
+  {
+    if (notefile_close(opt.notes))
+    {
+      fprintf(opt.binary ? stderr : stdout, "Error: writing note event file %s failed.\n", notesfile);
+      c = 1;
+    }
+  }
 
-      if (!timeseconds)
-        sprintf(&output[strlen(output)], "| %5d | ", time);
-      else
-        sprintf(&output[strlen(output)], "|%01d:%02d.%02d| ", time/3000, (time/50)%60, time%50);
+  return c;
+}
 
-      // Loop for each channel
-      for (c = 0; c < 3; c++)
-      {
-        int newnote = 0;
+// Print an info line or warning, unless messages are suppressed (msg NULL)
+void dumplog(FILE *msg, const char *fmt, ...)
+{
+  va_list ap;
 
-        // Keyoff-keyon sequence detection
-        if (chn[c].wave >= 0x10)
-        {
-          if ((chn[c].wave & 1) && ((!(prevchn2[c].wave & 1)) || (prevchn2[c].wave < 0x10)))
-            prevchn[c].note = -1;
-        }
+  if (!msg) return;
+  va_start(ap, fmt);
+  vfprintf(msg, fmt, ap);
+  va_end(ap);
+}
 
-        // Frequency
-        if ((frames == firstframe) || (prevchn[c].note == -1) || (chn[c].freq != prevchn[c].freq))
-        {
-          int d;
-          int dist = 0x7fffffff;
-          int delta = ((int)chn[c].freq) - ((int)prevchn2[c].freq);
+// Print an error and remember it for the batch summary
+void dumpmessage(DUMPJOB *job, FILE *msg, const char *fmt, ...)
+{
+  va_list ap;
 
-          sprintf(&output[strlen(output)], "%04X ", chn[c].freq);
+  if (msg)
+  {
+    va_start(ap, fmt);
+    vfprintf(msg, fmt, ap);
+    va_end(ap);
+  }
+  va_start(ap, fmt);
+  vsnprintf(job->error, sizeof job->error, fmt, ap);
+  va_end(ap);
+  job->error[strcspn(job->error, "\n")] = 0;
+}
 
-          if (chn[c].wave >= 0x10)
-          {
-            // Get new note number
-            for (d = 0; d < 96; d++)
-            {
-              int cmpfreq = freqtbllo[d] | (freqtblhi[d] << 8);
-              int freq = chn[c].freq;
-
-              if (abs(freq - cmpfreq) < dist)
-              {
-                dist = abs(freq - cmpfreq);
-                // Favor the old note
-                if (d == prevchn[c].note) dist /= oldnotefactor;
-                 chn[c].note = d;
-              }
-            }
-
-            // Print new note
-            if (chn[c].note != prevchn[c].note)
-            {
-              if (prevchn[c].note == -1)
-               {
-                 if (lowres) newnote = 1;
-                 sprintf(&output[strlen(output)], " %s %02X  ", notename[chn[c].note], chn[c].note | 0x80);
-              }
-               else
-                sprintf(&output[strlen(output)], "(%s %02X) ", notename[chn[c].note], chn[c].note | 0x80);
-            }
-            else
-            {
-              // If same note, print frequency change (slide/vibrato)
-              if (delta)
-              {
-                if (delta > 0)
-                   sprintf(&output[strlen(output)], "(+ %04X) ", delta);
-                 else
-                   sprintf(&output[strlen(output)], "(- %04X) ", -delta);
-              }
-              else sprintf(&output[strlen(output)], " ... ..  ");
-            }
-          }
-          else sprintf(&output[strlen(output)], " ... ..  ");
-        }
-        else sprintf(&output[strlen(output)], "....  ... ..  ");
+// Write the binary dump: header, then the frames collected so far.
+// Returns the number of bytes written.
+size_t writebinarydump(FILE *out, DUMPHEADER *header, const DUMPRECORD *records, int numrecords)
+{
+  size_t written;
 
-        // Waveform
-        if ((frames == firstframe) || (newnote) || (chn[c].wave != prevchn[c].wave))
-          sprintf(&output[strlen(output)], "%02X ", chn[c].wave);
-        else sprintf(&output[strlen(output)], ".. ");
+  header->framecount = numrecords;
+  written = fwrite(header, 1, sizeof *header, out);
+  if (numrecords) written += fwrite(records, 1, numrecords * sizeof *records, out);
+  return written;
+}
 
-        // ADSR
-        if ((frames == firstframe) || (newnote) || (chn[c].adsr != prevchn[c].adsr)) sprintf(&output[strlen(output)], "%04X ", chn[c].adsr);
-        else sprintf(&output[strlen(output)], ".... ");
+static double now(void)
+{
+  struct timespec ts;
 
-        // Pulse
-        if ((frames == firstframe) || (newnote) || (chn[c].pulse != prevchn[c].pulse)) sprintf(&output[strlen(output)], "%03X ", chn[c].pulse);
-        else sprintf(&output[strlen(output)], "... ");
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
 
-        sprintf(&output[strlen(output)], "| ");
-      }
+static void writejsonstring(FILE *f, const char *s)
+{
+  fputc('"', f);
+  for (; *s; s++)
+  {
+    if ((*s == '"') || (*s == '\\')) fputc('\\', f);
+    if ((unsigned char)*s >= 0x20) fputc(*s, f);
+  }
+  fputc('"', f);
+}
 
-      // Filter cutoff
-      if ((frames == firstframe) || (filt.cutoff != prevfilt.cutoff)) sprintf(&output[strlen(output)], "%04X ", filt.cutoff);
-      else sprintf(&output[strlen(output)], ".... ");
+static void writejobstats(FILE *f, const DUMPJOB *job, int subtune)
+{
+  const DUMPSTATS *st = &job->stats;
 
-      // Filter control
-      if ((frames == firstframe) || (filt.ctrl != prevfilt.ctrl))
-        sprintf(&output[strlen(output)], "%02X ", filt.ctrl);
-      else sprintf(&output[strlen(output)], ".. ");
+  fprintf(f, "{\"file\": ");
+  writejsonstring(f, job->sidname);
+  fprintf(f, ", \"subtune\": %d, \"status\": \"%s\"", (job->subtune >= 0) ? job->subtune : subtune, job->status ? "error" : "ok");
+  if (job->status)
+  {
+    fprintf(f, ", \"error\": ");
+    writejsonstring(f, job->error);
+  }
+  fprintf(f, ",\n  \"time\": {\"load\": %.6f, \"init\": %.6f, \"play\": %.6f, \"output\": %.6f, \"total\": %.6f},\n",
+    st->loadtime, st->inittime, st->playtime, st->outputtime, st->loadtime + st->inittime + st->playtime + st->outputtime);
+  fprintf(f, "  \"instructions\": {\"init\": %u, \"play\": %llu},\n", st->initinstr, st->playinstr);
+  fprintf(f, "  \"cycles\": {\"frames\": %u, \"max\": %u, \"mean\": %.1f},\n",
+    st->frames, st->maxcycles, st->frames ? (double)st->cycles / st->frames : 0.0);
+  fprintf(f, "  \"bytes\": {\"read\": %llu, \"written\": %llu}, \"warnings\": %d}", st->bytesread, st->byteswritten, st->warnings);
+}
 
-      // Filter passband
-      if ((frames == firstframe) || ((filt.type & 0x70) != (prevfilt.type & 0x70)))
-        sprintf(&output[strlen(output)], "%s ", filtername[(filt.type >> 4) & 0x7]);
-      else sprintf(&output[strlen(output)], "... ");
+// Write -stats-json: one object for a single dump, {"jobs": [...]} for a
+// batch. name NULL writes to stderr. Returns 0 on success.
+int writestats(const char *name, const DUMPJOB *jobs, int numjobs, int subtune, int batch)
+{
+  FILE *f = name ? fopen(name, "w") : stderr;
+  int c;
 
-      // Mastervolume
-      if ((frames == firstframe) || ((filt.type & 0xf) != (prevfilt.type & 0xf))) sprintf(&output[strlen(output)], "%01X ", filt.type & 0xf);
-      else sprintf(&output[strlen(output)], ". ");
-      
-      // Rasterlines / cycle count
-      if (profiling)
-      {
-        int cycles = cpucycles;
-        int rasterlines = (cycles + 62) / 63;
-        int badlines = ((cycles + 503) / 504);
-        int rasterlinesbad = (badlines * 40 + cycles + 62) / 63;
-        sprintf(&output[strlen(output)], "| %4d %02X %02X ", cycles, rasterlines, rasterlinesbad);
-      }
-      
-      // End of frame display, print info so far and copy SID registers to old registers
-      sprintf(&output[strlen(output)], "|\n");
-      if ((!lowres) || (!((frames - firstframe) % spacing)))
+  if (!f) return 1;
+  if (!batch)
+    writejobstats(f, jobs, subtune);
+  else
+  {
+    fprintf(f, "{\"jobs\": [\n");
+    for (c = 0; c < numjobs; c++)
+    {
+      writejobstats(f, &jobs[c], subtune);
+      fprintf(f, (c < numjobs - 1) ? ",\n" : "\n");
+    }
+    fprintf(f, "]}");
+  }
+  fprintf(f, "\n");
+  if (name) return fclose(f) ? 1 : 0;
+  return 0;
+}
+
+// Memory trace observer state. -trace logs reads of $1800-$1BFF during the
+// first 10 played frames as text; -tracebin records reads and writes inside
+// the address window for the selected frames. Both log the address of the
+// instruction doing the access. -sidwrites records every write that reaches
+// the SID and -coverage marks every access, in all frames.
+typedef struct
+{
+  FILE *log;
+  TRACEBUF *buf;
+  SIDWRITEBUF *sidwrites;
+  COVERAGE *coverage;
+  unsigned short start;
+  unsigned short end;
+  unsigned frame;
+  int active;
+  unsigned short pc;
+} TRACESTATE;
+
+// Select the frame (TRACE_INITFRAME for the initroutine) the next accesses belong to
+static void traceframe(TRACESTATE *trace, const DUMPOPTIONS *opt, unsigned frame)
+{
+  trace->frame = frame;
+  if ((trace->sidwrites) && (frame != TRACE_INITFRAME)) sidwrite_frame(trace->sidwrites, frame);
+  if ((trace->coverage) && (frame != TRACE_INITFRAME)) coverage_frame(trace->coverage, frame);
+  if (!trace->buf)
+    trace->active = 0;
+  else if (frame == TRACE_INITFRAME)
+    trace->active = (opt->tracefirst == 0);
+  else
+    trace->active = (frame >= opt->tracefirst) && (frame <= opt->tracelast);
+}
+
+static void traceexec(void *user, const CPUCONTEXT *ctx, unsigned short address)
+{
+  TRACESTATE *trace = user;
+
+  trace->pc = address;
+  if (trace->coverage) coverage_mark(trace->coverage, trace->coverage->snap->exec, address);
+}
+
+static void traceread(void *user, const CPUCONTEXT *ctx, unsigned short address, unsigned char value)
+{
+  TRACESTATE *trace = user;
+
+  if ((trace->log) && (trace->frame < 10) && (address >= 0x1800) && (address < 0x1c00))
+    fprintf(trace->log, "F%02d PC:%04X -> [%04X]=%02X\n", trace->frame, trace->pc, address, value);
+  if ((trace->active) && (address >= trace->start) && (address <= trace->end))
+    tracebuf_add(trace->buf, trace->frame, trace->pc, address, value, TRACE_READ);
+  if (trace->coverage) coverage_mark(trace->coverage, trace->coverage->snap->read, address);
+}
+
+static void tracewrite(void *user, const CPUCONTEXT *ctx, unsigned short address, unsigned char value)
+{
+  TRACESTATE *trace = user;
+
+  if ((trace->active) && (address >= trace->start) && (address <= trace->end))
+    tracebuf_add(trace->buf, trace->frame, trace->pc, address, value, TRACE_WRITE);
+  if (trace->coverage) coverage_mark(trace->coverage, trace->coverage->snap->write, address);
+  // $D400-$D7FF with I/O banked in; the registers repeat every 32 bytes.
+  // cpucycles already includes the whole instruction, whose last cycle
+  // is the write.
+  if ((trace->sidwrites) && ((address & 0xfc00) == 0xd400) && ((address & 0x1f) <= 0x18) &&
+    (ctx->mem[0x01] & 0x04) && (ctx->mem[0x01] & 0x03))
+    sidwrite_add(trace->sidwrites, ctx->cpucycles - 1, address & 0x1f, value);
+}
+
+// Read the addresses and C64 data of a SID file. Returns 0 on success.
+int loadsid(DUMPJOB *job, SIDIMAGE *image, FILE *msg)
+{
+  if (sidimage_load(job->sidname, image, job->error, sizeof job->error))
+  {
+    if (msg) fprintf(msg, "%s\n", job->error);
+    return 1;
+  }
+  return 0;
+}
+
+// Frames of one dump from the first displayed one on, as DUMPRECORDs:
+// all of them for -b, otherwise one NOTETRACK_FRAMES block at a time.
+// analyzed counts the records already through the note analysis, which
+// drives the text table (out) and -notes.
+typedef struct
+{
+  DUMPRECORD *records;
+  int numrecords;
+  int analyzed;
+  int keep;
+  NOTETRACK track;
+  NOTEFRAME notes[NOTETRACK_FRAMES];
+  FILE *out;
+  FILTER prevfilt;
+  unsigned row;
+  int counter;
+  int rows;
+} DUMPFRAMES;
+
+// Print count analyzed frames as table rows. Returns the bytes written.
+static size_t printframes(DUMPFRAMES *df, const DUMPOPTIONS *opt, const DUMPRECORD *records,
+  const NOTEFRAME *notes, int count)
+{
+  size_t written = 0;
+  int i;
+
+  for (i = 0; i < count; i++, df->row++)
+  {
+    const uint8_t *regs = records[i].regs;
+    FILTER filt;
+    char output[512];
+    int time = df->row;
+    int first = (time == 0);
+    int c;
+    output[0] = 0;
+
+    if (!opt->timeseconds)
+      sprintf(&output[strlen(output)], "| %5d | ", time);
+    else
+      sprintf(&output[strlen(output)], "|%01d:%02d.%02d| ", time/3000, (time/50)%60, time%50);
+
+    // Loop for each channel
+    for (c = 0; c < 3; c++)
+    {
+      const uint8_t *v = regs + 7*c;
+      int flags = notes[i].flags[c];
+      int note = notes[i].note[c];
+      int delta = notes[i].delta[c];
+
+      // Frequency and note
+      if (flags & NOTE_FREQ)
       {
-        printf("%s", output);
-        for (c = 0; c < 3; c++)
+        sprintf(&output[strlen(output)], "%04X ", v[0] | (v[1] << 8));
+        if (flags & NOTE_KEYON)
+          sprintf(&output[strlen(output)], " %s %02X  ", notename[note], note | 0x80);
+        else if (flags & NOTE_CHANGE)
+          sprintf(&output[strlen(output)], "(%s %02X) ", notename[note], note | 0x80);
+        else if (flags & NOTE_SLIDE)
         {
-          prevchn[c] = chn[c];
+          // Same note, frequency change (slide/vibrato)
+          if (delta > 0)
+            sprintf(&output[strlen(output)], "(+ %04X) ", delta);
+          else
+            sprintf(&output[strlen(output)], "(- %04X) ", -delta);
         }
-        prevfilt = filt;
+        else sprintf(&output[strlen(output)], " ... ..  ");
       }
-      for (c = 0; c < 3; c++) prevchn2[c] = chn[c];
+      else sprintf(&output[strlen(output)], "....  ... ..  ");
 
-      // Print note/pattern separators
-      if (spacing)
+      // Waveform
+      if (flags & NOTE_WAVE)
+        sprintf(&output[strlen(output)], "%02X ", v[4]);
+      else sprintf(&output[strlen(output)], ".. ");
+
+      // ADSR
+      if (flags & NOTE_ADSR) sprintf(&output[strlen(output)], "%04X ", v[6] | (v[5] << 8));
+      else sprintf(&output[strlen(output)], ".... ");
+
+      // Pulse
+      if (flags & NOTE_PULSE) sprintf(&output[strlen(output)], "%03X ", (v[2] | (v[3] << 8)) & 0xfff);
+      else sprintf(&output[strlen(output)], "... ");
+
+      sprintf(&output[strlen(output)], "| ");
+    }
+
+    filt.cutoff = (regs[0x15] << 5) | (regs[0x16] << 8);
+    filt.ctrl = regs[0x17];
+    filt.type = regs[0x18];
+
+    // Filter cutoff
+    if ((first) || (filt.cutoff != df->prevfilt.cutoff)) sprintf(&output[strlen(output)], "%04X ", filt.cutoff);
+    else sprintf(&output[strlen(output)], ".... ");
+
+    // Filter control
+    if ((first) || (filt.ctrl != df->prevfilt.ctrl))
+      sprintf(&output[strlen(output)], "%02X ", filt.ctrl);
+    else sprintf(&output[strlen(output)], ".. ");
+
+    // Filter passband
+    if ((first) || ((filt.type & 0x70) != (df->prevfilt.type & 0x70)))
+      sprintf(&output[strlen(output)], "%s ", filtername[(filt.type >> 4) & 0x7]);
+    else sprintf(&output[strlen(output)], "... ");
+
+    // Mastervolume
+    if ((first) || ((filt.type & 0xf) != (df->prevfilt.type & 0xf))) sprintf(&output[strlen(output)], "%01X ", filt.type & 0xf);
+    else sprintf(&output[strlen(output)], ". ");
+
+    // Rasterlines / cycle count
+    if (opt->profiling)
+    {
+      int cycles = records[i].cycles;
+      int rasterlines = (cycles + 62) / 63;
+      int badlines = ((cycles + 503) / 504);
+      int rasterlinesbad = (badlines * 40 + cycles + 62) / 63;
+      sprintf(&output[strlen(output)], "| %4d %02X %02X ", cycles, rasterlines, rasterlinesbad);
+    }
+
+    // End of frame display, print info so far and remember the filter
+    sprintf(&output[strlen(output)], "|\n");
+    if ((!df->track.lowres) || (!(time % opt->spacing)))
+    {
+      written += fprintf(df->out, "%s", output);
+      df->prevfilt = filt;
+    }
+
+    // Print note/pattern separators
+    if (opt->spacing)
+    {
+      df->counter++;
+      if (df->counter >= opt->spacing)
       {
-        counter++;
-        if (counter >= spacing)
+        df->counter = 0;
+        if (opt->pattspacing)
         {
-          counter = 0;
-          if (pattspacing)
+          df->rows++;
+          if (df->rows >= opt->pattspacing)
           {
-            rows++;
-            if (rows >= pattspacing)
-            {
-              rows = 0;
-              printf("+=======+===========================+===========================+===========================+===============+\n");
-            }
-            else
-              if (!lowres) printf("+-------+---------------------------+---------------------------+---------------------------+---------------+\n");
+            df->rows = 0;
+            written += fprintf(df->out, "+=======+===========================+===========================+===========================+===============+\n");
           }
           else
-            if (!lowres) printf("+-------+---------------------------+---------------------------+---------------------------+---------------+\n");
+            if (!opt->lowres) written += fprintf(df->out, "+-------+---------------------------+---------------------------+---------------------------+---------------+\n");
+        }
+        else
+          if (!opt->lowres) written += fprintf(df->out, "+-------+---------------------------+---------------------------+---------------------------+---------------+\n");
+      }
+    }
+  }
+  return written;
+}
+
+// Run the note analysis over the records not analyzed yet: print them as
+// table rows and add their events to -notes. Without -b the buffer is
+// then free for the next block. Returns the bytes written to the table.
+static size_t flushframes(DUMPFRAMES *df, const DUMPOPTIONS *opt)
+{
+  size_t written = 0;
+
+  while (df->analyzed < df->numrecords)
+  {
+    const DUMPRECORD *records = &df->records[df->analyzed];
+    int count = df->numrecords - df->analyzed;
+
+    if (count > NOTETRACK_FRAMES) count = NOTETRACK_FRAMES;
+    if ((df->out) || (opt->notes))
+    {
+      notetrack_analyze(&df->track, records, count, df->notes);
+      if (df->out) written += printframes(df, opt, records, df->notes, count);
+      if (opt->notes) notefile_add(opt->notes, records, df->notes, count);
+    }
+    df->analyzed += count;
+  }
+  if (!df->keep) df->numrecords = df->analyzed = 0;
+  return written;
+}
+
+static void freeframes(DUMPFRAMES *df)
+{
+  free(df->records);
+  free(df);
+}
+
+int dumpsid(DUMPJOB *job, const DUMPOPTIONS *opt, FILE *out, FILE *msg)
+{
+  DUMPFRAMES *df;
+  SIDPLAYER *sp;
+  CPUCONTEXT *cpu;
+  CPUOBSERVER observer;
+  CPUOBSERVER *observed = NULL;
+  TRACESTATE trace;
+  CHECKPOINTFILE ck;
+  LOOPDETECT *loop = NULL;
+  CPUBLOCKCACHE *blocks = NULL;
+  PROFILER *prof = NULL;
+  CPUOBSERVER profobserver;
+  int loopstart;
+  int (*run)(CPUCONTEXT *ctx) = runcpu_ctx;
+  unsigned char *mem;
+  SIDIMAGE ownimage;
+  const SIDIMAGE *image = job->image;
+  int subtune = (job->subtune >= 0) ? job->subtune : opt->subtune;
+  int seconds = opt->seconds;
+  int firstframe = opt->firstframe;
+  int profiling = opt->profiling;
+  int binary = opt->binary;
+  DUMPHEADER header;
+  int instr = 0;
+  int frames = 0;
+  unsigned loadaddress;
+  unsigned initaddress;
+  unsigned playaddress;
+  int result;
+  DUMPSTATS *stats = &job->stats;
+  double t0, tloop;
+
+  memset(stats, 0, sizeof *stats);
+  t0 = now();
+  job->status = 1;
+  job->frames = 0;
+  job->loopstart = -1;
+  job->looplength = 0;
+  job->error[0] = 0;
+  memset(&ck, 0, sizeof ck);
+
+  // -all jobs share an image loaded once; otherwise load the file here
+  if (!image)
+  {
+    if (loadsid(job, &ownimage, msg)) return 1;
+    image = &ownimage;
+  }
+  loadaddress = image->loadaddress;
+  initaddress = image->initaddress;
+  playaddress = image->playaddress;
+
+  // C64 memory and CPU, set up from the SID data by the init call
+  sp = malloc(sizeof *sp);
+  if (!sp)
+  {
+    dumpmessage(job, msg, "Error: out of memory.\n");
+    if (image == &ownimage) sidimage_free(&ownimage);
+    return 1;
+  }
+  cpu = &sp->cpu;
+  mem = sp->mem;
+  stats->bytesread = image->map.size;
+  memset(&trace, 0, sizeof trace);
+  if ((opt->tracelog) || (opt->tracebuf) || (opt->sidwrites) || (opt->coverage))
+  {
+    memset(&observer, 0, sizeof observer);
+    trace.log = opt->tracelog;
+    trace.buf = opt->tracebuf;
+    trace.sidwrites = opt->sidwrites;
+    trace.coverage = opt->coverage;
+    trace.start = opt->tracestart;
+    trace.end = opt->traceend;
+    observer.exec = traceexec;
+    observer.read = traceread;
+    if ((opt->tracebuf) || (opt->sidwrites) || (opt->coverage)) observer.write = tracewrite;
+    observer.user = &trace;
+    observed = &observer;
+    run = runcpu_ctx_observed;
+  }
+  traceframe(&trace, opt, TRACE_INITFRAME);
+
+  // Print info & run initroutine
+  stats->loadtime = now() - t0;
+  t0 = now();
+  dumplog(msg, "Load address: $%04X Init address: $%04X Play address: $%04X\n", loadaddress, initaddress, playaddress);
+  dumplog(msg, "Calling initroutine with subtune %d\n", subtune);
+  // The same init call as sidcompare and the other sidplay users
+  result = sidplay_initobserved(sp, image, subtune, observed);
+  if (image == &ownimage) sidimage_free(&ownimage);
+  if (sp->instructions > SIDPLAY_MAXINSTR)
+  {
+    dumplog(msg, "Warning: CPU executed a high number of instructions in init, breaking\n");
+    stats->warnings++;
+  }
+  stats->initinstr = sp->instructions;
+  stats->inittime = now() - t0;
+  if (result < 0)
+  {
+    if (msg) printcpuerror(msg, cpu);
+    snprintf(job->error, sizeof job->error, "CPU error in init at $%04X", cpu->errorpc);
+    free(sp);
+    return 1;
+  }
+
+  if (playaddress == 0)
+  {
+    dumplog(msg, "Warning: SID has play address 0, reading from interrupt vector instead\n");
+    stats->warnings++;
+    playaddress = sp->playaddress;
+    dumplog(msg, "New play address is $%04X\n", playaddress);
+  }
+
+  // Print first time info, set up the frame buffer and note analysis
+  dumplog(msg, "Calling playroutine for %d frames, starting from frame %d\n", seconds*50, firstframe);
+  dumplog(msg, "Middle C frequency is $%04X\n\n", opt->notetable->freq[48]);
+  df = malloc(sizeof *df);
+  if (df)
+  {
+    memset(df, 0, sizeof *df);
+    df->keep = binary;
+    df->out = binary ? NULL : out;
+    df->records = malloc((binary ? seconds*50 + 1 : NOTETRACK_FRAMES) * sizeof(DUMPRECORD));
+    notetrack_init(&df->track, opt->notetable, opt->oldnotefactor, opt->lowres, opt->spacing);
+  }
+  if ((!df) || (!df->records))
+  {
+    dumpmessage(job, msg, "Error: out of memory.\n");
+    free(df);
+    free(sp);
+    return 1;
+  }
+  if (binary)
+  {
+    memset(&header, 0, sizeof header);
+    memcpy(header.magic, DUMP_MAGIC, 4);
+    header.version = DUMP_VERSION;
+    header.headersize = sizeof(DUMPHEADER);
+    header.recordsize = sizeof(DUMPRECORD);
+    header.loadaddress = loadaddress;
+    header.initaddress = initaddress;
+    header.playaddress = playaddress;
+    header.subtune = subtune;
+    header.firstframe = firstframe;
+  }
+  else
+  {
+    stats->byteswritten += fprintf(out, "| Frame | Freq Note/Abs WF ADSR Pul | Freq Note/Abs WF ADSR Pul | Freq Note/Abs WF ADSR Pul | FCut RC Typ V |");
+    if (profiling)
+    { // CPU cycles, Raster lines, Raster lines with badlines on every 8th line, first line included
+      stats->byteswritten += fprintf(out, " Cycl RL RB |");
+    }
+    stats->byteswritten += fprintf(out, "\n");
+    stats->byteswritten += fprintf(out, "+-------+---------------------------+---------------------------+---------------------------+---------------+");
+    if (profiling)
+    {
+      stats->byteswritten += fprintf(out, "------------+");
+    }
+    stats->byteswritten += fprintf(out, "\n");
+  }
+
+  // Checkpoint cache: start from the latest state saved at or before the
+  // first frame. The display state is only updated from firstframe on, so
+  // this gives the same output as replaying from init. Not with tracing,
+  // which has to see every play call, or loop detection, which has to see
+  // every state.
+  if (opt->cachedir)
+  {
+    if (checkpoint_open(&ck, opt->cachedir, checkpoint_hashfile(job->sidname), subtune, playaddress, opt->cacheinterval))
+    {
+      dumplog(msg, "Warning: couldn't open checkpoint cache in %s\n", opt->cachedir);
+      stats->warnings++;
+    }
+    else if ((!opt->tracelog) && (!opt->tracebuf) && (!opt->sidwrites) && (!opt->coverage) && (!opt->loopdetect))
+      frames = checkpoint_restore(&ck, firstframe, cpu);
+  }
+
+  if (opt->loopdetect)
+  {
+    loop = loopdetect_create(firstframe + seconds*50);
+    if (!loop)
+    {
+      dumpmessage(job, msg, "Error: out of memory.\n");
+      checkpoint_close(&ck);
+      freeframes(df);
+      free(sp);
+      return 1;
+    }
+  }
+
+  // The block cache is created after init and any checkpoint restore, so
+  // it never needs a flush: from here on only the CPU writes memory
+  if ((run == runcpu_ctx) && (opt->engine == ENGINE_BLOCK))
+  {
+    blocks = cpublocks_create();
+    if (!blocks)
+    {
+      dumpmessage(job, msg, "Error: out of memory.\n");
+      checkpoint_close(&ck);
+      loopdetect_free(loop);
+      freeframes(df);
+      free(sp);
+      return 1;
+    }
+  }
+
+  // Profiling runs the play calls from firstframe on on the observed core
+  if (opt->profile)
+  {
+    prof = profiler_create();
+    if (!prof)
+    {
+      dumpmessage(job, msg, "Error: out of memory.\n");
+      checkpoint_close(&ck);
+      loopdetect_free(loop);
+      cpublocks_free(blocks);
+      freeframes(df);
+      free(sp);
+      return 1;
+    }
+    memset(&profobserver, 0, sizeof profobserver);
+    profobserver.exec = profiler_exec;
+    profobserver.user = prof;
+    run = runcpu_ctx_observed;
+  }
+
+  // Data collection & display loop
+  tloop = now();
+  while (frames < firstframe + seconds*50)
+  {
+    unsigned count = 0;
+    double tplay = 0;
+
+    if (ck.file) checkpoint_save(&ck, frames, cpu);
+
+    // Same state as before an earlier frame: everything from there repeats
+    if ((loop) && ((loopstart = loopdetect_check(loop, mem, frames)) >= 0))
+    {
+      job->loopstart = loopstart;
+      job->looplength = frames - loopstart;
+      break;
+    }
+
+    // Run the playroutine
+    instr = 0;
+    if (opt->stats) tplay = now();
+    traceframe(&trace, opt, frames);
+    initcpu_ctx(cpu, playaddress, 0, 0, 0);
+    if (prof)
+    {
+      cpu->observer = (frames >= firstframe) ? &profobserver : NULL;
+      if (cpu->observer) profiler_beginframe(prof, playaddress);
+    }
+    if (blocks)
+    {
+      while (((result = runcpu_ctx_blocks(cpu, blocks, &count, MAX_INSTR, 0xea31, 0xea81)) == CPURUN_STOP) &&
+        ((mem[0x01] & 0x07) == 0x5))
+        ;
+    }
+    else if ((run == runcpu_ctx) && (opt->engine == ENGINE_FAST))
+    {
+      // The Kernal interrupt handler exit only ends the playroutine when
+      // the Kernal is banked in; otherwise run on
+      while (((result = runcpu_ctx_run(cpu, &count, MAX_INSTR, 0xea31, 0xea81)) == CPURUN_STOP) &&
+        ((mem[0x01] & 0x07) == 0x5))
+        ;
+    }
+    else
+    {
+      while ((result = run(cpu)) > 0)
+      {
+        instr++;
+        if (instr > MAX_INSTR)
+        {
+          result = CPURUN_LIMIT;
+          break;
         }
+        // Test for jump into Kernal interrupt handler exit
+        if ((mem[0x01] & 0x07) != 0x5 && (cpu->pc == 0xea31 || cpu->pc == 0xea81))
+          break;
       }
+      count = instr;
+    }
+    if (opt->stats) stats->playtime += now() - tplay;
+    stats->playinstr += count;
+    if (result == CPURUN_LIMIT)
+    {
+      stats->byteswritten += flushframes(df, opt);
+      dumpmessage(job, msg, "Error: CPU executed abnormally high amount of instructions in playroutine, exiting\n");
+      job->frames = frames;
+      if (binary) stats->byteswritten += writebinarydump(out, &header, df->records, df->numrecords);
+      stats->outputtime = now() - tloop - stats->playtime;
+      freeframes(df);
+      checkpoint_close(&ck);
+      loopdetect_free(loop);
+      cpublocks_free(blocks);
+      profiler_free(prof);
+      free(sp);
+      return 1;
+    }
+    if (result < 0)
+    {
+      stats->byteswritten += flushframes(df, opt);
+      if (msg) printcpuerror(msg, cpu);
+      snprintf(job->error, sizeof job->error, "CPU error in playroutine at $%04X, frame %d", cpu->errorpc, frames);
+      job->frames = frames;
+      if (binary) stats->byteswritten += writebinarydump(out, &header, df->records, df->numrecords);
+      stats->outputtime = now() - tloop - stats->playtime;
+      freeframes(df);
+      checkpoint_close(&ck);
+      loopdetect_free(loop);
+      cpublocks_free(blocks);
+      profiler_free(prof);
+      free(sp);
+      return 1;
+    }
+    if ((prof) && (cpu->observer)) profiler_endframe(prof, cpu, frames);
+    stats->frames++;
+    stats->cycles += cpu->cpucycles;
+    if (cpu->cpucycles > stats->maxcycles) stats->maxcycles = cpu->cpucycles;
+
+    // Record the registers from the first displayed frame on; the table
+    // is printed a block at a time after the note analysis
+    if (frames >= firstframe)
+    {
+      DUMPRECORD *rec = &df->records[df->numrecords++];
+      rec->cycles = cpu->cpucycles;
+      memcpy(rec->regs, &mem[0xd400], DUMP_NUMREGS);
+      memset(rec->reserved, 0, sizeof rec->reserved);
+      if ((!binary) && (df->numrecords == NOTETRACK_FRAMES)) stats->byteswritten += flushframes(df, opt);
     }
 
     // Advance to next frame
     frames++;
   }
 
-  if (trace_log)
+  stats->byteswritten += flushframes(df, opt);
+  if (binary) stats->byteswritten += writebinarydump(out, &header, df->records, df->numrecords);
+  stats->outputtime = now() - tloop - stats->playtime;
+  if (job->loopstart >= 0)
+    dumplog(msg, "Loop detected: frame %d repeats from frame %d, loop length %d frames\n", frames, job->loopstart, job->looplength);
+  else if (loop)
+    dumplog(msg, "No loop detected in %d frames\n", frames);
+  if (prof)
   {
-    fclose(trace_log);
+    if (msg) profiler_report(prof, msg, 20);
+    if ((opt->profilefile) && (profiler_write(prof, opt->profilefile)))
+      dumplog(msg, "Error: writing profile %s failed.\n", opt->profilefile);
+    profiler_free(prof);
   }
-
+  job->frames = frames;
+  job->status = 0;
+  freeframes(df);
+  checkpoint_close(&ck);
+  loopdetect_free(loop);
+  cpublocks_free(blocks);
+  free(sp);
   return 0;
 }
 
-unsigned char readbyte(FILE *f)
+// Build the output path for a batch job: <outdir or SID directory>/<name>.dump
+// (.sdb for -b), <name>_<subtune>.dump for -all
+void makeoutname(DUMPJOB *job, const char *outdir, int binary)
 {
-  unsigned char res;
+  const char *base = job->sidname;
+  const char *p;
+  char *ext;
 
-  fread(&res, 1, 1, f);
-  return res;
+  for (p = job->sidname; *p; p++)
+  {
+    if ((*p == '/') || (*p == '\\')) base = p + 1;
+  }
+  if (outdir)
+    snprintf(job->outname, sizeof job->outname, "%s/%s", outdir, base);
+  else
+    snprintf(job->outname, sizeof job->outname, "%s", job->sidname);
+
+  // Strip the extension, but never a dot in a directory name
+  ext = strrchr(job->outname, '.');
+  if ((ext) && (!strpbrk(ext, "/\\")))
+    *ext = 0;
+  if (job->subtune >= 0)
+    snprintf(&job->outname[strlen(job->outname)], sizeof job->outname - strlen(job->outname), "_%02d", job->subtune);
+  strncat(job->outname, binary ? ".sdb" : ".dump", sizeof job->outname - strlen(job->outname) - 1);
 }
 
-unsigned short readword(FILE *f)
+int addjob(DUMPJOB **jobs, int *numjobs, int *maxjobs, const char *sidname)
 {
-  unsigned char res[2];
+  if (*numjobs >= *maxjobs)
+  {
+    int newmax = *maxjobs ? *maxjobs * 2 : 256;
+    DUMPJOB *newjobs = realloc(*jobs, newmax * sizeof(DUMPJOB));
+    if (!newjobs) return 0;
+    *jobs = newjobs;
+    *maxjobs = newmax;
+  }
+  memset(&(*jobs)[*numjobs], 0, sizeof(DUMPJOB));
+  snprintf((*jobs)[*numjobs].sidname, MAX_PATH_LEN, "%s", sidname);
+  (*jobs)[*numjobs].subtune = -1;
+  (*numjobs)++;
+  return 1;
+}
 
-  fread(&res, 2, 1, f);
-  return (res[0] << 8) | res[1];
+void *batchworker(void *arg)
+{
+  JOBQUEUE *queue = arg;
+
+  for (;;)
+  {
+    DUMPJOB *job;
+    FILE *out;
+
+    pthread_mutex_lock(&queue->lock);
+    if (queue->nextjob >= queue->numjobs)
+    {
+      pthread_mutex_unlock(&queue->lock);
+      break;
+    }
+    job = &queue->jobs[queue->nextjob++];
+    pthread_mutex_unlock(&queue->lock);
+
+    out = fopen(job->outname, queue->options->binary ? "wb" : "w");
+    if (!out)
+    {
+      job->status = 1;
+      snprintf(job->error, sizeof job->error, "couldn't create output file");
+      continue;
+    }
+    dumpsid(job, queue->options, out, queue->options->binary ? NULL : out);
+    fclose(out);
+  }
+  return NULL;
 }
 
+// Dump every SID of a directory or @listfile, each to its own output file,
+// on a pool of worker threads. A failing file does not stop the others.
+// With -all each file is loaded once and every subtune becomes a job.
+int runbatch(const char *source, const char *outdir, int workers, const DUMPOPTIONS *opt)
+{
+  JOBQUEUE queue;
+  DUMPJOB *jobs = NULL;
+  SIDIMAGE *images = NULL;
+  pthread_t *threads;
+  struct stat st;
+  int numjobs = 0;
+  int maxjobs = 0;
+  int numimages = 0;
+  int failed = 0;
+  int started;
+  int c;
 
+  if (source[0] == '@')
+  {
+    char line[MAX_PATH_LEN];
+    FILE *list = fopen(&source[1], "r");
+    if (!list)
+    {
+      printf("Error: couldn't open list file %s.\n", &source[1]);
+      return 1;
+    }
+    while (fgets(line, sizeof line, list))
+    {
+      line[strcspn(line, "\r\n")] = 0;
+      if ((!line[0]) || (line[0] == '#')) continue;
+      if (!addjob(&jobs, &numjobs, &maxjobs, line)) break;
+    }
+    fclose(list);
+  }
+  else if ((stat(source, &st)) || (!S_ISDIR(st.st_mode)))
+  {
+    // A single file, for -all
+    addjob(&jobs, &numjobs, &maxjobs, source);
+  }
+  else
+  {
+    const char *path;
+    SIDFILEDIR *dir = sidfile_diropen(source, ".sid");
+    if (!dir)
+    {
+      printf("Error: couldn't open directory %s.\n", source);
+      return 1;
+    }
+    while ((path = sidfile_dirnext(dir)))
+    {
+      if (!addjob(&jobs, &numjobs, &maxjobs, path)) break;
+    }
+    sidfile_dirclose(dir);
+  }
 
+  if (!numjobs)
+  {
+    printf("Error: no SID files found in %s.\n", source);
+    free(jobs);
+    return 1;
+  }
+
+  if (opt->allsubtunes)
+  {
+    DUMPJOB *files = jobs;
+    int numfiles = numjobs;
+
+    jobs = NULL;
+    numjobs = 0;
+    maxjobs = 0;
+    images = calloc(numfiles, sizeof(SIDIMAGE));
+    if (!images)
+    {
+      printf("Error: out of memory.\n");
+      free(files);
+      return 1;
+    }
+    for (c = 0; c < numfiles; c++)
+    {
+      int s;
 
+      // A file that doesn't load stays a single job and fails as usual
+      if (loadsid(&files[c], &images[numimages], NULL))
+      {
+        addjob(&jobs, &numjobs, &maxjobs, files[c].sidname);
+        continue;
+      }
+      for (s = 0; s < images[numimages].songs; s++)
+      {
+        if (!addjob(&jobs, &numjobs, &maxjobs, files[c].sidname)) break;
+        jobs[numjobs - 1].image = &images[numimages];
+        jobs[numjobs - 1].subtune = s;
+      }
+      numimages++;
+    }
+    free(files);
+    if (workers > numjobs) workers = numjobs;
+    printf("Dumping %d subtunes of %d files with %d worker threads\n", numjobs, numfiles, workers);
+  }
+  else
+  {
+    if (workers > numjobs) workers = numjobs;
+    printf("Dumping %d files with %d worker threads\n", numjobs, workers);
+  }
+  for (c = 0; c < numjobs; c++) makeoutname(&jobs[c], outdir, opt->binary);
+
+  queue.options = opt;
+  queue.jobs = jobs;
+  queue.numjobs = numjobs;
+  queue.nextjob = 0;
+  pthread_mutex_init(&queue.lock, NULL);
+  // Join only the threads that started; with none the main thread works
+  // the queue by itself
+  threads = malloc(workers * sizeof(pthread_t));
+  started = 0;
+  if (threads)
+  {
+    while ((started < workers) && (!pthread_create(&threads[started], NULL, batchworker, &queue))) started++;
+  }
+  if (started < workers) printf("Warning: started %d of %d worker threads.\n", started, workers);
+  if (!started) batchworker(&queue);
+  for (c = 0; c < started; c++) pthread_join(threads[c], NULL);
+  free(threads);
+  pthread_mutex_destroy(&queue.lock);
+
+  // Summary in input order
+  for (c = 0; c < numjobs; c++)
+  {
+    if (!jobs[c].status)
+    {
+      if (jobs[c].loopstart >= 0)
+        printf("OK   %s -> %s (%d frames, loop at frame %d, length %d)\n", jobs[c].sidname, jobs[c].outname, jobs[c].frames, jobs[c].loopstart, jobs[c].looplength);
+      else
+        printf("OK   %s -> %s (%d frames)\n", jobs[c].sidname, jobs[c].outname, jobs[c].frames);
+    }
+    else
+    {
+      if (jobs[c].subtune >= 0)
+        printf("FAIL %s subtune %d: %s\n", jobs[c].sidname, jobs[c].subtune, jobs[c].error);
+      else
+        printf("FAIL %s: %s\n", jobs[c].sidname, jobs[c].error);
+      failed++;
+    }
+  }
+  printf("%d of %d %s dumped, %d failed\n", numjobs - failed, numjobs, opt->allsubtunes ? "subtunes" : "files", failed);
+  if ((opt->stats) && (writestats(opt->statsfile, jobs, numjobs, opt->subtune, 1)))
+  {
+    printf("Error: writing statistics %s failed.\n", opt->statsfile);
+    failed++;
+  }
+  free(jobs);
+  for (c = 0; c < numimages; c++) sidimage_free(&images[c]);
+  free(images);
+  return failed ? 1 : 0;
+}
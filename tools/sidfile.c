@@ -0,0 +1,289 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <dirent.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#endif
+#include "sidfile.h"
+
+#define MAX_PATH_LEN 1024
+
+struct SIDFILEDIR
+{
+  DIR *dir;
+  char extension[16];
+  char path[MAX_PATH_LEN];
+  size_t dirlen;
+};
+
+// Fallback for files that can't be mapped: read them whole
+static int readwhole(const char *name, SIDFILEMAP *map)
+{
+  FILE *in = fopen(name, "rb");
+  unsigned char *buffer = NULL;
+  size_t size = 0;
+  size_t n;
+
+  if (!in) return -1;
+  for (;;)
+  {
+    unsigned char *grown = realloc(buffer, size + 65536);
+    if (!grown)
+    {
+      free(buffer);
+      fclose(in);
+      return -1;
+    }
+    buffer = grown;
+    n = fread(&buffer[size], 1, 65536, in);
+    size += n;
+    if (n < 65536) break;
+  }
+  fclose(in);
+  map->data = buffer;
+  map->size = size;
+  map->handle = buffer;
+  map->mapped = 0;
+  return 0;
+}
+
+int sidfile_map(const char *name, SIDFILEMAP *map)
+{
+  memset(map, 0, sizeof *map);
+#ifdef _WIN32
+  {
+    HANDLE file = CreateFileA(name, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    LARGE_INTEGER size;
+    HANDLE mapping;
+    void *view;
+
+    if (file == INVALID_HANDLE_VALUE) return -1;
+    if ((!GetFileSizeEx(file, &size)) || (size.QuadPart == 0))
+    {
+      CloseHandle(file);
+      return readwhole(name, map);
+    }
+    mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (!mapping) return readwhole(name, map);
+    view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view)
+    {
+      CloseHandle(mapping);
+      return readwhole(name, map);
+    }
+    map->data = view;
+    map->size = (size_t)size.QuadPart;
+    map->handle = mapping;
+    map->mapped = 1;
+    return 0;
+  }
+#else
+  {
+    struct stat st;
+    void *view;
+    int fd = open(name, O_RDONLY);
+
+    if (fd < 0) return -1;
+    if ((fstat(fd, &st)) || (!S_ISREG(st.st_mode)) || (st.st_size == 0))
+    {
+      close(fd);
+      return readwhole(name, map);
+    }
+    view = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED) return readwhole(name, map);
+    map->data = view;
+    map->size = st.st_size;
+    map->mapped = 1;
+    return 0;
+  }
+#endif
+}
+
+void sidfile_unmap(SIDFILEMAP *map)
+{
+  if (map->mapped)
+  {
+#ifdef _WIN32
+    UnmapViewOfFile(map->data);
+    CloseHandle(map->handle);
+#else
+    munmap((void *)map->data, map->size);
+#endif
+  }
+  else
+    free(map->handle);
+  memset(map, 0, sizeof *map);
+}
+
+static unsigned bigword(const unsigned char *p)
+{
+  return (p[0] << 8) | p[1];
+}
+
+// Parse the PSID/RSID header. Stricter than the original siddump, which
+// read the fields at their offsets from any file: no magic, or less than
+// the $76-byte v1 header, is SIDFILE_NOTSID.
+int sidfile_parse(const unsigned char *data, size_t size, SIDFILEVIEW *view)
+{
+  memset(view, 0, sizeof *view);
+  if ((size < 0x76) || ((memcmp(data, "PSID", 4)) && (memcmp(data, "RSID", 4))))
+    return SIDFILE_NOTSID;
+
+  view->rsid = data[0] == 'R';
+  view->version = bigword(&data[0x04]);
+  view->dataoffset = bigword(&data[0x06]);
+  view->loadaddress = bigword(&data[0x08]);
+  view->initaddress = bigword(&data[0x0a]);
+  view->playaddress = bigword(&data[0x0c]);
+  view->songs = bigword(&data[0x0e]);
+  view->startsong = bigword(&data[0x10]);
+  view->speed = ((unsigned long)bigword(&data[0x12]) << 16) | bigword(&data[0x14]);
+  view->name = (const char *)&data[0x16];
+  view->author = (const char *)&data[0x36];
+  view->released = (const char *)&data[0x56];
+  if ((view->dataoffset >= 0x78) && (size >= 0x78)) view->flags = bigword(&data[0x76]);
+  if (view->dataoffset > size) return SIDFILE_TRUNCATED;
+
+  view->payload = &data[view->dataoffset];
+  view->payloadsize = size - view->dataoffset;
+  if (view->loadaddress == 0)
+  {
+    if (view->payloadsize < 2) return SIDFILE_TRUNCATED;
+    view->loadaddress = view->payload[0] | (view->payload[1] << 8);
+    view->payload += 2;
+    view->payloadsize -= 2;
+  }
+  return SIDFILE_OK;
+}
+
+const char *sidfile_error(int result)
+{
+  switch (result)
+  {
+    case SIDFILE_OK:
+    return "no error";
+
+    case SIDFILE_NOTSID:
+    return "not a PSID/RSID file";
+
+    default:
+    return "SID file is truncated";
+  }
+}
+
+int sidfile_write(const char *name, const void *header, size_t headersize, const void *payload, size_t payloadsize)
+{
+#ifdef _WIN32
+  FILE *out = fopen(name, "wb");
+  int result = 0;
+
+  if (!out) return -1;
+  if ((headersize) && (fwrite(header, headersize, 1, out) != 1)) result = -1;
+  if ((payloadsize) && (fwrite(payload, payloadsize, 1, out) != 1)) result = -1;
+  if (fclose(out)) result = -1;
+  return result;
+#else
+  struct iovec parts[2];
+  int count = 0;
+  int fd = open(name, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+
+  if (fd < 0) return -1;
+  if (headersize)
+  {
+    parts[count].iov_base = (void *)header;
+    parts[count].iov_len = headersize;
+    count++;
+  }
+  if (payloadsize)
+  {
+    parts[count].iov_base = (void *)payload;
+    parts[count].iov_len = payloadsize;
+    count++;
+  }
+  // writev may stop short, so carry on from wherever it got to
+  while (count)
+  {
+    ssize_t n = writev(fd, parts, count);
+
+    if (n < 0)
+    {
+      close(fd);
+      return -1;
+    }
+    while ((count) && ((size_t)n >= parts[0].iov_len))
+    {
+      n -= parts[0].iov_len;
+      parts[0] = parts[1];
+      count--;
+    }
+    if (count)
+    {
+      parts[0].iov_base = (char *)parts[0].iov_base + n;
+      parts[0].iov_len -= n;
+    }
+  }
+  return close(fd) ? -1 : 0;
+#endif
+}
+
+SIDFILEDIR *sidfile_diropen(const char *dir, const char *extension)
+{
+  SIDFILEDIR *d = calloc(1, sizeof *d);
+
+  if (!d) return NULL;
+  d->dir = opendir(dir);
+  if (!d->dir)
+  {
+    free(d);
+    return NULL;
+  }
+  snprintf(d->extension, sizeof d->extension, "%s", extension);
+  snprintf(d->path, sizeof d->path, "%s/", dir);
+  d->dirlen = strlen(d->path);
+  return d;
+}
+
+static int hasextension(const char *name, const char *extension)
+{
+  size_t len = strlen(name);
+  size_t extlen = strlen(extension);
+  size_t c;
+
+  if (len <= extlen) return 0;
+  for (c = 0; c < extlen; c++)
+  {
+    if (tolower((unsigned char)name[len - extlen + c]) != tolower((unsigned char)extension[c])) return 0;
+  }
+  return 1;
+}
+
+const char *sidfile_dirnext(SIDFILEDIR *d)
+{
+  struct dirent *entry;
+
+  while ((entry = readdir(d->dir)))
+  {
+    if (!hasextension(entry->d_name, d->extension)) continue;
+    if (d->dirlen + strlen(entry->d_name) >= sizeof d->path) continue;
+    strcpy(&d->path[d->dirlen], entry->d_name);
+    return d->path;
+  }
+  return NULL;
+}
+
+void sidfile_dirclose(SIDFILEDIR *d)
+{
+  if (!d) return;
+  closedir(d->dir);
+  free(d);
+}
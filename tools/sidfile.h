@@ -0,0 +1,78 @@
+#ifndef SIDFILE_H
+#define SIDFILE_H
+
+// Shared SID/PRG file I/O for siddump, sidcompare, sf2pack and sf2export:
+// input files are memory-mapped and the PSID/RSID header is parsed into a
+// view that points into the mapping, output is written as header plus
+// payload in one gathered write, and directories are streamed by extension.
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SIDFILE_HEADERSIZE 0x7c
+
+// A whole file, mapped read-only (or read into memory where mapping isn't
+// possible, e.g. an empty file)
+typedef struct
+{
+  const unsigned char *data;
+  size_t size;
+  void *handle;
+  int mapped;
+} SIDFILEMAP;
+
+// PSID/RSID header fields, host byte order. payload points into the file
+// and starts after the load address bytes if the header's load address
+// was 0; loadaddress is then the one taken from the payload.
+typedef struct
+{
+  int rsid;
+  unsigned version;
+  unsigned dataoffset;
+  unsigned loadaddress;
+  unsigned initaddress;
+  unsigned playaddress;
+  unsigned songs;
+  unsigned startsong;
+  unsigned long speed;
+  unsigned flags;
+  const char *name;
+  const char *author;
+  const char *released;
+  const unsigned char *payload;
+  size_t payloadsize;
+} SIDFILEVIEW;
+
+// sidfile_parse() results
+#define SIDFILE_OK 0
+#define SIDFILE_NOTSID 1
+#define SIDFILE_TRUNCATED 2
+
+// Returns 0 on success, -1 if the file can't be opened or read
+int sidfile_map(const char *name, SIDFILEMAP *map);
+void sidfile_unmap(SIDFILEMAP *map);
+
+int sidfile_parse(const unsigned char *data, size_t size, SIDFILEVIEW *view);
+const char *sidfile_error(int result);
+
+// Write header and payload to a new file with one gathered write.
+// Returns 0 on success, -1 on an error.
+int sidfile_write(const char *name, const void *header, size_t headersize, const void *payload, size_t payloadsize);
+
+// Files of a directory with a given extension (".sid", case-insensitive),
+// in directory order. sidfile_dirnext() returns "<dir>/<name>" until the
+// end, then NULL; the string is valid until the next call.
+typedef struct SIDFILEDIR SIDFILEDIR;
+
+SIDFILEDIR *sidfile_diropen(const char *dir, const char *extension);
+const char *sidfile_dirnext(SIDFILEDIR *d);
+void sidfile_dirclose(SIDFILEDIR *d);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,253 @@
+/*
+ * sidid.cpp - Player Signature Scanner (Main Entry Point)
+ *
+ * Identifies the players of SID files with the signatures of sidid.cfg,
+ * compiled once and then matched against any number of files on a pool
+ * of threads.
+ *
+ * Usage: sidid [options] <file|directory|@listfile>...
+ */
+
+#include "sigindex.h"
+#include "sidfile.h"
+#include <sys/stat.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace SIDId;
+
+
+// Input file mapped into memory (sidfile.h), unmapped on destruction
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& filename) {
+        if (sidfile_map(filename.c_str(), &map_)) {
+            throw std::runtime_error("Cannot open file: " + filename);
+        }
+    }
+    ~MappedFile() {
+        sidfile_unmap(&map_);
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const unsigned char* data() const { return map_.data; }
+    size_t size() const { return map_.size; }
+
+private:
+    SIDFILEMAP map_;
+};
+
+
+struct Options {
+    std::string signature_file = "sidid.cfg";
+    std::string index_file;
+    unsigned int jobs = 1;
+    bool summary = true;
+    bool verbose = false;
+    std::vector<std::string> inputs;
+};
+
+
+// Result for one input file
+struct ScanJob {
+    std::string filename;
+    std::vector<unsigned int> signatures;
+    std::string error;
+};
+
+
+void PrintUsage(const char* program) {
+    std::cout << "Usage: " << program << " [options] <file|directory|@listfile>...\n\n";
+    std::cout << "Identifies the players of SID files by their code signatures.\n";
+    std::cout << "A directory scans its .sid files, @listfile the files listed, one per line.\n\n";
+    std::cout << "Options:\n";
+    std::cout << "  -c FILE           Signature file, default sidid.cfg\n";
+    std::cout << "  -i FILE           Compiled index: loaded if it was made from the signature\n";
+    std::cout << "                    file, else compiled and written there\n";
+    std::cout << "  -j N              Worker threads, default 1\n";
+    std::cout << "  -n                No summary, only a line per file\n";
+    std::cout << "  -v                Print index and timing information\n";
+    std::cout << "  -h, --help        Show this help\n\n";
+    std::cout << "Each file is printed with the signatures found, in signature file order,\n";
+    std::cout << "or *Unidentified*.\n";
+}
+
+
+bool ParseArguments(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+
+        if (arg == "-h" || arg == "--help") {
+            return false;
+        } else if (arg == "-c" && i + 1 < argc) {
+            options.signature_file = argv[++i];
+        } else if (arg == "-i" && i + 1 < argc) {
+            options.index_file = argv[++i];
+        } else if (arg == "-j" && i + 1 < argc) {
+            long jobs = std::strtol(argv[++i], nullptr, 10);
+            if (jobs < 1) {
+                std::cerr << "Error: -j needs a number of threads\n";
+                return false;
+            }
+            options.jobs = static_cast<unsigned int>(jobs);
+        } else if (arg == "-n") {
+            options.summary = false;
+        } else if (arg == "-v") {
+            options.verbose = true;
+        } else if (!arg.empty() && arg[0] == '-' && arg.size() > 1) {
+            std::cerr << "Error: unknown option " << arg << "\n";
+            return false;
+        } else {
+            options.inputs.push_back(arg);
+        }
+    }
+    return !options.inputs.empty();
+}
+
+
+bool IsDirectory(const std::string& path) {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 && (st.st_mode & S_IFMT) == S_IFDIR;
+}
+
+
+// A directory becomes its .sid files (sorted), @file the files it lists
+void ExpandInput(const std::string& arg, std::vector<std::string>& files) {
+    if (!arg.empty() && arg[0] == '@') {
+        std::ifstream list(arg.substr(1));
+        if (!list) {
+            throw std::runtime_error("Cannot open list file: " + arg.substr(1));
+        }
+        std::string line;
+        while (std::getline(list, line)) {
+            line.erase(line.find_last_not_of(" \t\r\n") + 1);
+            if (!line.empty() && line[0] != '#') {
+                files.push_back(line);
+            }
+        }
+    } else if (IsDirectory(arg)) {
+        SIDFILEDIR* dir = sidfile_diropen(arg.c_str(), ".sid");
+        if (!dir) {
+            throw std::runtime_error("Cannot open directory: " + arg);
+        }
+        std::vector<std::string> names;
+        while (const char* path = sidfile_dirnext(dir)) {
+            names.push_back(path);
+        }
+        sidfile_dirclose(dir);
+        std::sort(names.begin(), names.end());
+        files.insert(files.end(), names.begin(), names.end());
+    } else {
+        files.push_back(arg);
+    }
+}
+
+
+void ScanFile(ScanJob& job, const SignatureIndex& index) {
+    try {
+        MappedFile file(job.filename);
+        job.signatures = index.Scan(file.data(), file.size());
+    } catch (const std::exception& e) {
+        job.error = e.what();
+    }
+}
+
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!ParseArguments(argc, argv, options)) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    try {
+        auto start = std::chrono::steady_clock::now();
+        SignatureIndex index = GetSignatureIndex(options.signature_file, options.index_file);
+        auto loaded = std::chrono::steady_clock::now();
+
+        std::vector<ScanJob> jobs;
+        {
+            std::vector<std::string> files;
+            for (const std::string& arg : options.inputs) {
+                ExpandInput(arg, files);
+            }
+            jobs.resize(files.size());
+            for (size_t i = 0; i < files.size(); ++i) {
+                jobs[i].filename = files[i];
+            }
+        }
+
+        unsigned int workers = std::min<size_t>(options.jobs, std::max<size_t>(jobs.size(), 1));
+        std::atomic<size_t> next(0);
+        std::vector<std::thread> threads;
+        for (unsigned int t = 0; t < workers; ++t) {
+            threads.emplace_back([&]() {
+                for (size_t j = next++; j < jobs.size(); j = next++) {
+                    ScanFile(jobs[j], index);
+                }
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        auto scanned = std::chrono::steady_clock::now();
+
+        // Results in input order, then how often each player was found
+        std::map<std::string, int> counts;
+        int identified = 0;
+        int failed = 0;
+        for (const ScanJob& job : jobs) {
+            std::cout << job.filename;
+            if (!job.error.empty()) {
+                std::cout << "\t*Error* " << job.error << "\n";
+                failed++;
+                continue;
+            }
+            if (job.signatures.empty()) {
+                std::cout << "\t*Unidentified*\n";
+                continue;
+            }
+            for (unsigned int signature : job.signatures) {
+                std::cout << "\t" << index.GetName(signature);
+                counts[index.GetName(signature)]++;
+            }
+            std::cout << "\n";
+            identified++;
+        }
+
+        if (options.summary) {
+            std::cout << "\nDetected players                      Count\n";
+            std::cout << "-------------------------------------------\n";
+            for (const auto& count : counts) {
+                std::printf("%-36s %6d\n", count.first.c_str(), count.second);
+            }
+            std::cout << "\nIdentified files: " << identified << "\n";
+            std::cout << "Unidentified files: " << (jobs.size() - identified - failed) << "\n";
+            if (failed) {
+                std::cout << "Failed files: " << failed << "\n";
+            }
+            std::cout << "Total files: " << jobs.size() << "\n";
+        }
+        if (options.verbose) {
+            typedef std::chrono::duration<double, std::milli> Milliseconds;
+            std::cerr << index.GetSignatureCount() << " signatures, " << index.GetStateCount()
+                      << " automaton states, loaded in " << Milliseconds(loaded - start).count()
+                      << " ms; " << jobs.size() << " files scanned in "
+                      << Milliseconds(scanned - loaded).count() << " ms on " << workers << " threads\n";
+        }
+        return failed ? 1 : 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+}
@@ -0,0 +1,183 @@
+/*
+ * sigfile.cpp - Player Signature File Parser Implementation
+ */
+
+#include "sigfile.h"
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace SIDId {
+
+static bool IsHexDigit(char c) {
+    return (c >= '0' && c <= '9') || (c >= 'A' && c <= 'F') || (c >= 'a' && c <= 'f');
+}
+
+
+static bool IsByteToken(const std::string& token) {
+    return token == "??" || (token.size() == 2 && IsHexDigit(token[0]) && IsHexDigit(token[1]));
+}
+
+
+static bool IsSignatureToken(const std::string& token) {
+    return IsByteToken(token) || token == "AND" || token == "&&" || token == "END";
+}
+
+
+// Definition lines without END are kept back: if a later line of the same
+// signature ends with END, they all make one definition, otherwise each
+// line is one on its own
+class SignatureParser {
+public:
+    SignatureParser(SignatureSet& signatures, const std::string& filename)
+        : signatures_(signatures), filename_(filename) {}
+
+    void ParseLine(const std::string& line, int line_number) {
+        std::istringstream tokens(line);
+        std::vector<std::string> words;
+        std::string word;
+        while (tokens >> word) {
+            words.push_back(word);
+        }
+
+        if (words.empty()) {
+            Flush();
+            return;
+        }
+        if (!IsSignatureToken(words[0])) {
+            // A new signature starts with its name
+            Flush();
+            if (words.size() > 1) {
+                Error(line_number, "expected a signature name (without spaces) or bytes");
+            }
+            signatures_.push_back(Signature());
+            signatures_.back().name = words[0];
+            return;
+        }
+        if (signatures_.empty()) {
+            Error(line_number, "signature bytes before the first signature name");
+        }
+
+        for (const std::string& token : words) {
+            if (token == "END") {
+                Define(line_number);
+            } else if (token == "AND" || token == "&&") {
+                if (group_.empty()) {
+                    Error(line_number, "AND without bytes before it");
+                }
+                pending_.push_back(group_);
+                group_.clear();
+            } else if (IsByteToken(token)) {
+                group_.push_back(token == "??" ? WILDCARD
+                                               : static_cast<short>(std::stoi(token, nullptr, 16)));
+            } else {
+                Error(line_number, "unexpected token \"" + token + "\"");
+            }
+        }
+
+        if (!group_.empty() || !pending_.empty()) {
+            lines_.push_back(HeldLine{pending_, group_, line_number});
+            pending_.clear();
+            group_.clear();
+        }
+    }
+
+    void Finish() {
+        Flush();
+    }
+
+private:
+    struct HeldLine {
+        Pattern groups;
+        ByteGroup last;
+        int line_number;
+    };
+
+    // END: everything held back and this line's bytes are one definition
+    void Define(int line_number) {
+        Pattern pattern;
+        for (const HeldLine& line : lines_) {
+            Append(pattern, line.groups, line.last);
+        }
+        lines_.clear();
+        Append(pattern, pending_, group_);
+        pending_.clear();
+        group_.clear();
+        Add(pattern, line_number);
+    }
+
+    // A line continues the group the line before ended with, like END
+    // joining the lines of one definition
+    static void Append(Pattern& pattern, const Pattern& groups, const ByteGroup& last) {
+        for (const ByteGroup& group : groups) {
+            Join(pattern, group);
+            pattern.push_back(ByteGroup());
+        }
+        Join(pattern, last);
+    }
+
+    static void Join(Pattern& pattern, const ByteGroup& group) {
+        if (pattern.empty()) {
+            pattern.push_back(ByteGroup());
+        }
+        pattern.back().insert(pattern.back().end(), group.begin(), group.end());
+    }
+
+    void Flush() {
+        for (const HeldLine& line : lines_) {
+            Pattern pattern;
+            Append(pattern, line.groups, line.last);
+            Add(pattern, line.line_number);
+        }
+        lines_.clear();
+    }
+
+    void Add(const Pattern& pattern, int line_number) {
+        if (pattern.empty()) {
+            return;
+        }
+        for (const ByteGroup& group : pattern) {
+            if (group.empty()) {
+                Error(line_number, "AND without bytes after it");
+            }
+        }
+        signatures_.back().patterns.push_back(pattern);
+    }
+
+    void Error(int line_number, const std::string& message) const {
+        throw std::runtime_error(filename_ + ":" + std::to_string(line_number) + ": " + message);
+    }
+
+    SignatureSet& signatures_;
+    std::string filename_;
+    std::vector<HeldLine> lines_;
+    Pattern pending_;
+    ByteGroup group_;
+};
+
+
+SignatureSet ParseSignatures(const std::string& text, const std::string& filename) {
+    SignatureSet signatures;
+    SignatureParser parser(signatures, filename);
+    std::istringstream in(text);
+    std::string line;
+    int line_number = 0;
+    while (std::getline(in, line)) {
+        parser.ParseLine(line, ++line_number);
+    }
+    parser.Finish();
+    return signatures;
+}
+
+
+SignatureSet ParseSignatureFile(const std::string& filename) {
+    std::ifstream in(filename, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("Cannot open signature file: " + filename);
+    }
+    std::ostringstream text;
+    text << in.rdbuf();
+    return ParseSignatures(text.str(), filename);
+}
+
+} // namespace SIDId
@@ -0,0 +1,39 @@
+/*
+ * sigfile.h - Player Signature File Parser
+ *
+ * Reads sidid.cfg/tedid.cfg style signature files (format V2.0, see
+ * ../Signature_File_Format.txt) into signatures of byte groups
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace SIDId {
+
+// One run of bytes that has to be found in one piece. WILDCARD is ??.
+static const short WILDCARD = -1;
+typedef std::vector<short> ByteGroup;
+
+// The groups of one definition, separated by AND/&& in the file: each is
+// looked for after the end of the one before
+typedef std::vector<ByteGroup> Pattern;
+
+// A player and every definition given for it; it is reported if any of
+// them is found. Sub signatures keep their brackets, "(Rob_Hubbard_Digi)".
+struct Signature {
+    std::string name;
+    std::vector<Pattern> patterns;
+};
+
+typedef std::vector<Signature> SignatureSet;
+
+// Parse a signature file. Throws std::runtime_error if it can't be read or
+// has a malformed definition.
+SignatureSet ParseSignatureFile(const std::string& filename);
+
+// Parse signature file contents; filename is only used in messages
+SignatureSet ParseSignatures(const std::string& text, const std::string& filename);
+
+} // namespace SIDId
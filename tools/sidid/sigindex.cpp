@@ -0,0 +1,456 @@
+/*
+ * sigindex.cpp - Compiled Player Signature Index Implementation
+ */
+
+#include "sigindex.h"
+#include "sidfile.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+namespace SIDId {
+
+// Index file: "SIDX", version, source hash, then the tables as counted
+// arrays of 32-bit values. All little-endian.
+static const char INDEX_MAGIC[4] = {'S', 'I', 'D', 'X'};
+static const uint32_t INDEX_VERSION = 1;
+
+
+SignatureIndex::SignatureIndex() : source_hash_(0) {
+    Compile(std::vector<std::vector<unsigned char>>());
+}
+
+
+SignatureIndex::SignatureIndex(const SignatureSet& signatures) : source_hash_(0) {
+    std::vector<std::vector<unsigned char>> anchors;
+
+    for (size_t s = 0; s < signatures.size(); ++s) {
+        names_.push_back(signatures[s].name);
+        for (const Pattern& pattern : signatures[s].patterns) {
+            PatternRef ref;
+            ref.signature = static_cast<uint32_t>(s);
+            ref.first_group = static_cast<uint32_t>(groups_.size());
+            ref.groups = static_cast<uint32_t>(pattern.size());
+            patterns_.push_back(ref);
+
+            for (const ByteGroup& bytes : pattern) {
+                Group group;
+                group.start = static_cast<uint32_t>(bytes_.size());
+                group.length = static_cast<uint32_t>(bytes.size());
+                group.anchor_offset = 0;
+                group.anchor_length = 0;
+
+                // Anchor: the longest run without wildcards, the first one
+                // of equally long runs
+                uint32_t run = 0;
+                for (uint32_t i = 0; i <= bytes.size(); ++i) {
+                    if (i < bytes.size() && bytes[i] != WILDCARD) {
+                        run++;
+                        continue;
+                    }
+                    if (run > group.anchor_length) {
+                        group.anchor_offset = i - run;
+                        group.anchor_length = run;
+                    }
+                    run = 0;
+                }
+
+                for (short byte : bytes) {
+                    bytes_.push_back(byte == WILDCARD ? 0 : static_cast<unsigned char>(byte));
+                    mask_.push_back(byte == WILDCARD ? 0 : 0xFF);
+                }
+                anchors.push_back(std::vector<unsigned char>(
+                    bytes_.begin() + group.start + group.anchor_offset,
+                    bytes_.begin() + group.start + group.anchor_offset + group.anchor_length));
+                groups_.push_back(group);
+            }
+        }
+    }
+
+    Compile(anchors);
+}
+
+
+// Build the DFA from the anchors, one per group (empty ones are skipped):
+// a trie of them, completed with failure links breadth first
+void SignatureIndex::Compile(const std::vector<std::vector<unsigned char>>& anchors) {
+    std::vector<std::vector<uint32_t>> outputs(1);
+    std::vector<int64_t> trie(256, -1);
+
+    for (size_t g = 0; g < anchors.size(); ++g) {
+        if (anchors[g].empty()) {
+            continue;
+        }
+        size_t state = 0;
+        for (unsigned char byte : anchors[g]) {
+            int64_t& next = trie[state * 256 + byte];
+            if (next < 0) {
+                next = static_cast<int64_t>(outputs.size());
+                outputs.push_back(std::vector<uint32_t>());
+                trie.resize(trie.size() + 256, -1);
+            }
+            state = static_cast<size_t>(trie[state * 256 + byte]);
+        }
+        outputs[state].push_back(static_cast<uint32_t>(g));
+    }
+
+    size_t states = outputs.size();
+    std::vector<uint32_t> fail(states, 0);
+    std::vector<uint32_t> queue;
+    delta_.assign(states * 256, 0);
+
+    for (unsigned int byte = 0; byte < 256; ++byte) {
+        if (trie[byte] >= 0) {
+            delta_[byte] = static_cast<uint32_t>(trie[byte]);
+            queue.push_back(delta_[byte]);
+        }
+    }
+    for (size_t head = 0; head < queue.size(); ++head) {
+        uint32_t state = queue[head];
+        const std::vector<uint32_t>& inherited = outputs[fail[state]];
+        outputs[state].insert(outputs[state].end(), inherited.begin(), inherited.end());
+        for (unsigned int byte = 0; byte < 256; ++byte) {
+            int64_t next = trie[state * 256 + byte];
+            if (next < 0) {
+                delta_[state * 256 + byte] = delta_[fail[state] * 256 + byte];
+            } else {
+                delta_[state * 256 + byte] = static_cast<uint32_t>(next);
+                fail[next] = delta_[fail[state] * 256 + byte];
+                queue.push_back(static_cast<uint32_t>(next));
+            }
+        }
+    }
+
+    out_start_.clear();
+    out_groups_.clear();
+    for (const std::vector<uint32_t>& output : outputs) {
+        out_start_.push_back(static_cast<uint32_t>(out_groups_.size()));
+        out_groups_.insert(out_groups_.end(), output.begin(), output.end());
+    }
+    out_start_.push_back(static_cast<uint32_t>(out_groups_.size()));
+}
+
+
+bool SignatureIndex::Matches(const Group& group, const unsigned char* data, size_t size, size_t start) const {
+    if (start + group.length > size) {
+        return false;
+    }
+    const unsigned char* bytes = &bytes_[group.start];
+    const unsigned char* mask = &mask_[group.start];
+    for (uint32_t i = 0; i < group.length; ++i) {
+        if ((data[start + i] & mask[i]) != bytes[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+std::vector<unsigned int> SignatureIndex::Scan(const unsigned char* data, size_t size) const {
+    // Every place a group matches, as (group, start). They come in the
+    // order their anchors end, which is ascending start for each group.
+    std::vector<std::pair<uint32_t, uint32_t>> hits;
+    uint32_t state = 0;
+    for (size_t pos = 0; pos < size; ++pos) {
+        state = delta_[state * 256 + data[pos]];
+        for (uint32_t o = out_start_[state]; o < out_start_[state + 1]; ++o) {
+            const Group& group = groups_[out_groups_[o]];
+            size_t anchor_start = pos + 1 - group.anchor_length;
+            if (anchor_start < group.anchor_offset) {
+                continue;
+            }
+            size_t start = anchor_start - group.anchor_offset;
+            if (Matches(group, data, size, start)) {
+                hits.push_back(std::make_pair(out_groups_[o], static_cast<uint32_t>(start)));
+            }
+        }
+    }
+    std::stable_sort(hits.begin(), hits.end(),
+                     [](const std::pair<uint32_t, uint32_t>& a, const std::pair<uint32_t, uint32_t>& b) {
+                         return a.first < b.first;
+                     });
+
+    // Each group of a pattern at its first match after the end of the one
+    // before, as a search from the start of the file would find them
+    std::vector<unsigned int> found;
+    for (const PatternRef& pattern : patterns_) {
+        if (!found.empty() && found.back() == pattern.signature) {
+            continue;
+        }
+        size_t cursor = 0;
+        bool matched = true;
+        for (uint32_t g = pattern.first_group; g < pattern.first_group + pattern.groups && matched; ++g) {
+            const Group& group = groups_[g];
+            if (group.anchor_length == 0) {
+                matched = cursor + group.length <= size;
+                cursor += group.length;
+                continue;
+            }
+            auto hit = std::lower_bound(hits.begin(), hits.end(), std::make_pair(g, static_cast<uint32_t>(cursor)));
+            matched = hit != hits.end() && hit->first == g;
+            if (matched) {
+                cursor = hit->second + group.length;
+            }
+        }
+        if (matched) {
+            found.push_back(pattern.signature);
+        }
+    }
+    return found;
+}
+
+
+static void WriteValue(std::vector<unsigned char>& out, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; ++i) {
+        out.push_back(static_cast<unsigned char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+
+static void WriteArray(std::vector<unsigned char>& out, const std::vector<uint32_t>& values) {
+    WriteValue(out, values.size(), 4);
+    for (uint32_t value : values) {
+        WriteValue(out, value, 4);
+    }
+}
+
+
+// Reads from a mapped index file, failing (and staying failed) at its end
+class IndexReader {
+public:
+    IndexReader(const unsigned char* data, size_t size) : data_(data), size_(size), pos_(0), ok_(true) {}
+
+    bool ok() const { return ok_; }
+    bool AtEnd() const { return pos_ == size_; }
+
+    uint64_t Value(int bytes) {
+        if (!ok_ || size_ - pos_ < static_cast<size_t>(bytes)) {
+            ok_ = false;
+            return 0;
+        }
+        uint64_t value = 0;
+        for (int i = 0; i < bytes; ++i) {
+            value |= static_cast<uint64_t>(data_[pos_++]) << (8 * i);
+        }
+        return value;
+    }
+
+    std::vector<uint32_t> Array() {
+        uint64_t count = Value(4);
+        std::vector<uint32_t> values;
+        if (!ok_ || (size_ - pos_) / 4 < count) {
+            ok_ = false;
+            return values;
+        }
+        values.resize(static_cast<size_t>(count));
+        // The DFA is most of the file: copy it as is where the host is
+        // little-endian too
+        const uint32_t probe = 1;
+        if (*reinterpret_cast<const unsigned char*>(&probe) == 1 && count) {
+            std::memcpy(&values[0], &data_[pos_], values.size() * 4);
+            pos_ += values.size() * 4;
+        } else {
+            for (uint32_t& value : values) {
+                value = static_cast<uint32_t>(Value(4));
+            }
+        }
+        return values;
+    }
+
+    std::vector<unsigned char> Bytes() {
+        uint64_t count = Value(4);
+        std::vector<unsigned char> bytes;
+        if (!ok_ || size_ - pos_ < count) {
+            ok_ = false;
+            return bytes;
+        }
+        bytes.assign(data_ + pos_, data_ + pos_ + static_cast<size_t>(count));
+        pos_ += static_cast<size_t>(count);
+        return bytes;
+    }
+
+private:
+    const unsigned char* data_;
+    size_t size_;
+    size_t pos_;
+    bool ok_;
+};
+
+
+bool SignatureIndex::Save(const std::string& filename) const {
+    std::vector<unsigned char> out(INDEX_MAGIC, INDEX_MAGIC + 4);
+    WriteValue(out, INDEX_VERSION, 4);
+    WriteValue(out, source_hash_, 8);
+
+    WriteValue(out, names_.size(), 4);
+    for (const std::string& name : names_) {
+        WriteValue(out, name.size(), 4);
+        out.insert(out.end(), name.begin(), name.end());
+    }
+    std::vector<uint32_t> patterns;
+    for (const PatternRef& pattern : patterns_) {
+        patterns.push_back(pattern.signature);
+        patterns.push_back(pattern.first_group);
+        patterns.push_back(pattern.groups);
+    }
+    std::vector<uint32_t> groups;
+    for (const Group& group : groups_) {
+        groups.push_back(group.start);
+        groups.push_back(group.length);
+        groups.push_back(group.anchor_offset);
+        groups.push_back(group.anchor_length);
+    }
+    WriteArray(out, patterns);
+    WriteArray(out, groups);
+    WriteValue(out, bytes_.size(), 4);
+    out.insert(out.end(), bytes_.begin(), bytes_.end());
+    WriteValue(out, mask_.size(), 4);
+    out.insert(out.end(), mask_.begin(), mask_.end());
+    WriteArray(out, delta_);
+    WriteArray(out, out_start_);
+    WriteArray(out, out_groups_);
+
+    // Write a temporary file and rename it, so concurrent runs sharing an
+    // index never read a half-written one
+    std::string temp = filename + ".tmp";
+    {
+        std::ofstream file(temp, std::ios::binary);
+        if (!file) {
+            return false;
+        }
+        file.write(reinterpret_cast<const char*>(out.data()), out.size());
+        if (!file.good()) {
+            return false;
+        }
+    }
+    std::remove(filename.c_str());
+    if (std::rename(temp.c_str(), filename.c_str()) != 0) {
+        std::remove(temp.c_str());
+        return false;
+    }
+    return true;
+}
+
+
+bool SignatureIndex::Load(const std::string& filename) {
+    SIDFILEMAP map;
+    if (sidfile_map(filename.c_str(), &map)) {
+        return false;
+    }
+    bool loaded = map.size >= 4 && !std::memcmp(map.data, INDEX_MAGIC, 4) && Load(map.data + 4, map.size - 4);
+    sidfile_unmap(&map);
+    return loaded;
+}
+
+
+bool SignatureIndex::Load(const unsigned char* data, size_t size) {
+    IndexReader in(data, size);
+    if (in.Value(4) != INDEX_VERSION) {
+        return false;
+    }
+    SignatureIndex index;
+    index.source_hash_ = in.Value(8);
+    uint64_t names = in.Value(4);
+    for (uint64_t n = 0; n < names && in.ok(); ++n) {
+        std::vector<unsigned char> name;
+        uint64_t length = in.Value(4);
+        for (uint64_t c = 0; c < length && in.ok(); ++c) {
+            name.push_back(static_cast<unsigned char>(in.Value(1)));
+        }
+        index.names_.push_back(std::string(name.begin(), name.end()));
+    }
+    std::vector<uint32_t> patterns = in.Array();
+    std::vector<uint32_t> groups = in.Array();
+    index.bytes_ = in.Bytes();
+    index.mask_ = in.Bytes();
+    index.delta_ = in.Array();
+    index.out_start_ = in.Array();
+    index.out_groups_ = in.Array();
+    if (!in.ok() || !in.AtEnd() || patterns.size() % 3 || groups.size() % 4) {
+        return false;
+    }
+    for (size_t p = 0; p < patterns.size(); p += 3) {
+        PatternRef pattern = {patterns[p], patterns[p + 1], patterns[p + 2]};
+        index.patterns_.push_back(pattern);
+    }
+    for (size_t g = 0; g < groups.size(); g += 4) {
+        Group group = {groups[g], groups[g + 1], groups[g + 2], groups[g + 3]};
+        index.groups_.push_back(group);
+    }
+
+    // Everything the scan indexes with has to be in range
+    size_t states = index.out_start_.size() - 1;
+    if (index.out_start_.empty() || index.delta_.size() != states * 256 ||
+        index.bytes_.size() != index.mask_.size() || index.out_start_.back() != index.out_groups_.size()) {
+        return false;
+    }
+    for (uint32_t next : index.delta_) {
+        if (next >= states) {
+            return false;
+        }
+    }
+    for (size_t s = 0; s < states; ++s) {
+        if (index.out_start_[s] > index.out_start_[s + 1]) {
+            return false;
+        }
+    }
+    for (uint32_t g : index.out_groups_) {
+        if (g >= index.groups_.size()) {
+            return false;
+        }
+    }
+    for (const Group& group : index.groups_) {
+        if (static_cast<uint64_t>(group.start) + group.length > index.bytes_.size() ||
+            static_cast<uint64_t>(group.anchor_offset) + group.anchor_length > group.length) {
+            return false;
+        }
+    }
+    for (const PatternRef& pattern : index.patterns_) {
+        if (pattern.signature >= index.names_.size() ||
+            static_cast<uint64_t>(pattern.first_group) + pattern.groups > index.groups_.size()) {
+            return false;
+        }
+    }
+    *this = index;
+    return true;
+}
+
+
+unsigned long long HashSignatureText(const std::string& text) {
+    unsigned long long hash = 0xcbf29ce484222325ULL;
+    for (char c : text) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+
+SignatureIndex GetSignatureIndex(const std::string& signature_file, const std::string& index_file) {
+    std::ifstream in(signature_file, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("Cannot open signature file: " + signature_file);
+    }
+    std::ostringstream text;
+    text << in.rdbuf();
+    unsigned long long hash = HashSignatureText(text.str());
+
+    SignatureIndex index;
+    if (!index_file.empty() && index.Load(index_file) && index.GetSourceHash() == hash) {
+        return index;
+    }
+
+    index = SignatureIndex(ParseSignatures(text.str(), signature_file));
+    index.SetSourceHash(hash);
+    // An index that can't be written only costs the next run a compile
+    if (!index_file.empty()) {
+        index.Save(index_file);
+    }
+    return index;
+}
+
+} // namespace SIDId
@@ -0,0 +1,81 @@
+/*
+ * sigindex.h - Compiled Player Signature Index
+ *
+ * All signatures of a signature file compiled into one automaton: the
+ * longest run of fixed bytes of every group goes into an Aho-Corasick
+ * DFA, so one pass over a file finds every place a group may start. Only
+ * there the whole group is compared, wildcards included, and AND
+ * sequences are then resolved from the groups' hits. The compiled index
+ * can be saved and loaded instead of parsing the signature file again.
+ */
+
+#pragma once
+
+#include "sigfile.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace SIDId {
+
+class SignatureIndex {
+public:
+    SignatureIndex();
+    explicit SignatureIndex(const SignatureSet& signatures);
+
+    // Binary index file. Load returns false if the file is missing or not
+    // a valid index, leaving the index unchanged.
+    bool Load(const std::string& filename);
+    bool Save(const std::string& filename) const;
+
+    // Hash of the signature file the index was compiled from, 0 if unknown
+    void SetSourceHash(unsigned long long hash) { source_hash_ = hash; }
+    unsigned long long GetSourceHash() const { return source_hash_; }
+
+    size_t GetSignatureCount() const { return names_.size(); }
+    const std::string& GetName(unsigned int signature) const { return names_[signature]; }
+    size_t GetStateCount() const { return out_start_.empty() ? 0 : out_start_.size() - 1; }
+
+    // Signatures found in data, in signature file order. Doesn't change the
+    // index, so one index can scan on several threads at once.
+    std::vector<unsigned int> Scan(const unsigned char* data, size_t size) const;
+
+private:
+    struct Group {
+        uint32_t start;          // in bytes_/mask_
+        uint32_t length;
+        uint32_t anchor_offset;  // fixed bytes in the DFA, from start
+        uint32_t anchor_length;  // 0: all wildcards, matches anywhere
+    };
+
+    // Groups first_group.. first_group + groups - 1, in order
+    struct PatternRef {
+        uint32_t signature;
+        uint32_t first_group;
+        uint32_t groups;
+    };
+
+    bool Load(const unsigned char* data, size_t size);
+    bool Matches(const Group& group, const unsigned char* data, size_t size, size_t start) const;
+    void Compile(const std::vector<std::vector<unsigned char>>& anchors);
+
+    std::vector<std::string> names_;
+    std::vector<PatternRef> patterns_;
+    std::vector<Group> groups_;
+    std::vector<unsigned char> bytes_;  // group bytes, 0 for wildcards
+    std::vector<unsigned char> mask_;   // 0xFF for fixed bytes, 0 for wildcards
+    std::vector<uint32_t> delta_;       // state * 256 + byte -> state
+    std::vector<uint32_t> out_start_;   // groups whose anchor ends in a state:
+    std::vector<uint32_t> out_groups_;  // out_groups_[out_start_[s] .. out_start_[s + 1])
+    unsigned long long source_hash_;
+};
+
+// FNV-1a of signature file contents, to tell if an index is up to date
+unsigned long long HashSignatureText(const std::string& text);
+
+// Index for a signature file. With an index file name, an index there that
+// was compiled from the same signature file is loaded; otherwise the file
+// is parsed and compiled, and the index saved for the next run.
+SignatureIndex GetSignatureIndex(const std::string& signature_file, const std::string& index_file);
+
+} // namespace SIDId
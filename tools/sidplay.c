@@ -0,0 +1,117 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sidplay.h"
+
+// Read the addresses and C64 data of a SID file. Returns 0 on success,
+// otherwise 1 with the reason in error.
+int sidimage_load(const char *sidname, SIDIMAGE *image, char *error, int errorsize)
+{
+  SIDFILEVIEW view;
+  int result;
+
+  memset(image, 0, sizeof *image);
+  if (sidfile_map(sidname, &image->map))
+  {
+    snprintf(error, errorsize, "Error: couldn't open SID file.");
+    return 1;
+  }
+  result = sidfile_parse(image->map.data, image->map.size, &view);
+  if (result != SIDFILE_OK)
+  {
+    snprintf(error, errorsize, "Error: %s.", sidfile_error(result));
+    sidimage_free(image);
+    return 1;
+  }
+
+  image->loadaddress = view.loadaddress;
+  image->initaddress = view.initaddress;
+  image->playaddress = view.playaddress;
+  image->songs = view.songs;
+  if (image->songs < 1) image->songs = 1;
+  image->loadsize = view.payloadsize;
+  if (image->loadsize + image->loadaddress >= 0x10000)
+  {
+    snprintf(error, errorsize, "Error: SID data continues past end of C64 memory.");
+    sidimage_free(image);
+    return 1;
+  }
+  image->data = view.payload;
+  return 0;
+}
+
+void sidimage_free(SIDIMAGE *image)
+{
+  sidfile_unmap(&image->map);
+  image->data = NULL;
+}
+
+// Reset memory to the image and run the initroutine. A play address of 0
+// is taken from the interrupt vector init left behind. Returns 0, or -1
+// on a CPU error (details in sp->cpu).
+int sidplay_init(SIDPLAYER *sp, const SIDIMAGE *image, int subtune)
+{
+  return sidplay_initobserved(sp, image, subtune, NULL);
+}
+
+// Init with an observer on the init call, on the observed step core. The
+// observer is left in sp->cpu for the caller's own observed play calls;
+// sidplay_frame() doesn't use it. NULL runs as sidplay_init().
+int sidplay_initobserved(SIDPLAYER *sp, const SIDIMAGE *image, int subtune, CPUOBSERVER *observer)
+{
+  int (*run)(CPUCONTEXT *ctx) = observer ? runcpu_ctx_observed : runcpu_ctx;
+  unsigned instr = 0;
+  int result;
+
+  memset(sp->mem, 0, sizeof sp->mem);
+  memcpy(&sp->mem[image->loadaddress], image->data, image->loadsize);
+  memset(&sp->cpu, 0, sizeof sp->cpu);
+  sp->cpu.mem = sp->mem;
+  sp->cpu.observer = observer;
+  sp->frame = 0;
+
+  sp->mem[0x01] = 0x37;
+  initcpu_ctx(&sp->cpu, image->initaddress, subtune, 0, 0);
+  while ((result = run(&sp->cpu)) > 0)
+  {
+    // Allow SID model detection (including $d011 wait) to eventually terminate
+    ++sp->mem[0xd012];
+    if (!sp->mem[0xd012] || ((sp->mem[0xd011] & 0x80) && sp->mem[0xd012] >= 0x38))
+    {
+      sp->mem[0xd011] ^= 0x80;
+      sp->mem[0xd012] = 0x00;
+    }
+    if (++instr > SIDPLAY_MAXINSTR) break;
+  }
+  sp->instructions = instr;
+  if (result < 0) return -1;
+
+  sp->playaddress = image->playaddress;
+  if (sp->playaddress == 0)
+  {
+    if ((sp->mem[0x01] & 0x07) == 0x5)
+      sp->playaddress = sp->mem[0xfffe] | (sp->mem[0xffff] << 8);
+    else
+      sp->playaddress = sp->mem[0x314] | (sp->mem[0x315] << 8);
+  }
+  return 0;
+}
+
+// Run one play call. Returns 0, SIDPLAY_LIMIT when the playroutine never
+// returns, or -1 on a CPU error. sp->cpu.cpucycles is the frame's cycles.
+int sidplay_frame(SIDPLAYER *sp)
+{
+  unsigned count = 0;
+  int result;
+
+  initcpu_ctx(&sp->cpu, sp->playaddress, 0, 0, 0);
+  // The Kernal interrupt handler exit only ends the playroutine when the
+  // Kernal is banked in; otherwise run on
+  while (((result = runcpu_ctx_run(&sp->cpu, &count, SIDPLAY_MAXINSTR, 0xea31, 0xea81)) == CPURUN_STOP) &&
+    ((sp->mem[0x01] & 0x07) == 0x5))
+    ;
+  if (result == CPURUN_STOP) result = 0;
+  if (result == 0) sp->frame++;
+  sp->instructions = count;
+  return result;
+}
@@ -0,0 +1,46 @@
+#ifndef SIDPLAY_H
+#define SIDPLAY_H
+
+#include "cpu.h"
+#include "sidfile.h"
+
+// Instruction limit for one init or play call
+#define SIDPLAY_MAXINSTR 0x100000
+
+// C64 data and addresses of a SID file, as read from the PSID/RSID header.
+// data points into the mapped file; nothing is copied until a player loads it.
+typedef struct
+{
+  unsigned loadaddress;
+  unsigned initaddress;
+  unsigned playaddress;
+  unsigned loadsize;
+  int songs;
+  const unsigned char *data;
+  SIDFILEMAP map;
+} SIDIMAGE;
+
+// A tune being played frame by frame, the same way siddump plays it:
+// init on the step core with the $D012 hack, play calls on the run core
+// until RTS or the Kernal interrupt exit. mem is $D400-$D418 after a frame.
+typedef struct
+{
+  CPUCONTEXT cpu;
+  unsigned char mem[0x10000];
+  unsigned playaddress;
+  int frame;
+  unsigned instructions;
+} SIDPLAYER;
+
+// sidplay_frame() results besides 0 and -1 (CPU error, see cpu).
+// sp->instructions counts the instructions of the call, except the one that
+// returned; after init it is above SIDPLAY_MAXINSTR if init was cut off.
+#define SIDPLAY_LIMIT CPURUN_LIMIT
+
+int sidimage_load(const char *sidname, SIDIMAGE *image, char *error, int errorsize);
+void sidimage_free(SIDIMAGE *image);
+int sidplay_init(SIDPLAYER *sp, const SIDIMAGE *image, int subtune);
+int sidplay_initobserved(SIDPLAYER *sp, const SIDIMAGE *image, int subtune, CPUOBSERVER *observer);
+int sidplay_frame(SIDPLAYER *sp);
+
+#endif
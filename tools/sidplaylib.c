@@ -0,0 +1,152 @@
+// sidplaylib - siddump's SID player as a shared library
+//
+// A C ABI over sidplay.c for in-process callers (sidm2/sidplay_native.py
+// uses it through ctypes): load a SID file, call init, run frames into
+// caller-supplied buffers and peek at C64 memory. Each handle is an
+// independent machine, so handles may be used from different threads.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sidplay.h"
+
+#ifdef _WIN32
+#define SIDLIB_API __declspec(dllexport)
+#else
+#define SIDLIB_API __attribute__((visibility("default")))
+#endif
+
+// Bumped when a function signature changes
+#define SIDLIB_VERSION 1
+
+// sidlib_info() fields
+#define SIDLIB_LOADADDRESS 0
+#define SIDLIB_INITADDRESS 1
+#define SIDLIB_PLAYADDRESS 2
+#define SIDLIB_LOADSIZE 3
+#define SIDLIB_SONGS 4
+#define SIDLIB_FRAME 5
+#define SIDLIB_NUMINFO 6
+
+typedef struct
+{
+  SIDIMAGE image;
+  SIDPLAYER player;
+  int initialized;
+  char error[128];
+} SIDLIB;
+
+SIDLIB_API int sidlib_version(void)
+{
+  return SIDLIB_VERSION;
+}
+
+// Load a SID file. Returns NULL on failure, with the reason in error.
+SIDLIB_API SIDLIB *sidlib_load(const char *sidname, char *error, int errorsize)
+{
+  SIDLIB *lib = calloc(1, sizeof *lib);
+
+  if (!lib)
+  {
+    if (errorsize > 0) snprintf(error, errorsize, "Error: out of memory.");
+    return NULL;
+  }
+  if (sidimage_load(sidname, &lib->image, lib->error, sizeof lib->error))
+  {
+    if (errorsize > 0) snprintf(error, errorsize, "%s", lib->error);
+    free(lib);
+    return NULL;
+  }
+  return lib;
+}
+
+SIDLIB_API void sidlib_free(SIDLIB *lib)
+{
+  if (!lib) return;
+  sidimage_free(&lib->image);
+  free(lib);
+}
+
+SIDLIB_API const char *sidlib_error(const SIDLIB *lib)
+{
+  return lib->error;
+}
+
+// Header addresses, the play address in effect (known after init) and the
+// number of frames played since init
+SIDLIB_API void sidlib_info(const SIDLIB *lib, unsigned *info)
+{
+  info[SIDLIB_LOADADDRESS] = lib->image.loadaddress;
+  info[SIDLIB_INITADDRESS] = lib->image.initaddress;
+  info[SIDLIB_PLAYADDRESS] = lib->initialized ? lib->player.playaddress : lib->image.playaddress;
+  info[SIDLIB_LOADSIZE] = lib->image.loadsize;
+  info[SIDLIB_SONGS] = lib->image.songs;
+  info[SIDLIB_FRAME] = lib->initialized ? lib->player.frame : 0;
+}
+
+// Reset the machine and run the initroutine. Returns 0, or -1 on a CPU error.
+SIDLIB_API int sidlib_init(SIDLIB *lib, int subtune)
+{
+  lib->error[0] = 0;
+  lib->initialized = 0;
+  if (sidplay_init(&lib->player, &lib->image, subtune))
+  {
+    snprintf(lib->error, sizeof lib->error, "CPU error in init at $%04X", lib->player.cpu.errorpc);
+    return -1;
+  }
+  lib->initialized = 1;
+  return 0;
+}
+
+// Play up to frames frames. After each, $D400-$D418 go to regs (25 bytes
+// per frame) and the play call's cycles to cycles; either may be NULL.
+// Returns the number of frames played, fewer than asked on an error.
+SIDLIB_API int sidlib_run(SIDLIB *lib, int frames, unsigned char *regs, unsigned *cycles)
+{
+  int done;
+
+  lib->error[0] = 0;
+  if (!lib->initialized)
+  {
+    snprintf(lib->error, sizeof lib->error, "sidlib_init not called");
+    return 0;
+  }
+  for (done = 0; done < frames; done++)
+  {
+    int result = sidplay_frame(&lib->player);
+
+    if (result == SIDPLAY_LIMIT)
+    {
+      snprintf(lib->error, sizeof lib->error, "Playroutine doesn't return, frame %d", lib->player.frame);
+      break;
+    }
+    if (result < 0)
+    {
+      snprintf(lib->error, sizeof lib->error, "CPU error in playroutine at $%04X, frame %d", lib->player.cpu.errorpc, lib->player.frame);
+      break;
+    }
+    if (regs) memcpy(&regs[done * 25], &lib->player.mem[0xd400], 25);
+    if (cycles) cycles[done] = lib->player.cpu.cpucycles;
+  }
+  return done;
+}
+
+// Copy length bytes of C64 memory from address on, wrapping at $FFFF.
+// Before init this is the freshly loaded image.
+SIDLIB_API void sidlib_peek(const SIDLIB *lib, unsigned address, unsigned length, unsigned char *buffer)
+{
+  unsigned c;
+
+  if (!lib->initialized)
+  {
+    for (c = 0; c < length; c++)
+    {
+      unsigned a = (address + c) & 0xffff;
+
+      buffer[c] = ((a >= lib->image.loadaddress) && (a < lib->image.loadaddress + lib->image.loadsize)) ?
+        lib->image.data[a - lib->image.loadaddress] : 0;
+    }
+    return;
+  }
+  for (c = 0; c < length; c++) buffer[c] = lib->player.mem[(address + c) & 0xffff];
+}
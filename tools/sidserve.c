@@ -0,0 +1,420 @@
+// siddump service mode (-serve)
+//
+// One process answers many requests, so loaded tunes, their play position
+// and in-memory checkpoints survive between them: scrubbing to a frame
+// replays at most SERVE_INTERVAL frames from the nearest checkpoint, and a
+// reload of a tune that is still open costs nothing. Tunes are played on
+// the sidplay.c player, the same init and play calls as a dump.
+//
+// Requests (one JSON object per line; "id" is echoed in the reply):
+//   {"cmd": "load", "file": "x.sid", "subtune": 0}   open, or reuse, a tune
+//   {"cmd": "seek", "frame": 1500}                   move the play position
+//   {"cmd": "frames", "count": 50, "frame": 1500}    play frames, from frame
+//                                                    if given
+//   {"cmd": "peek", "address": "0x1000", "length": 16}
+//   {"cmd": "unload"}, {"cmd": "quit"}
+// All but load act on the last loaded tune, or on "tune": <handle>.
+
+#include <stdlib.h>
+#include <string.h>
+#include "sidplay.h"
+#include "ndjson.h"
+#include "sidserve.h"
+
+#define SERVE_MAXTUNES 8
+#define SERVE_INTERVAL 250
+#define SERVE_MAXFRAMES 30000
+#define SERVE_LINESIZE 4096
+
+typedef struct
+{
+  int handle;
+  char name[NDJSON_VALUESIZE];
+  int subtune;
+  unsigned lastuse;
+  SIDIMAGE image;
+  SIDPLAYER *sp;
+  SIDPLAYER *checkpoints;  // State at frame n * SERVE_INTERVAL
+  int numcheckpoints;
+  int maxcheckpoints;
+} SERVETUNE;
+
+typedef struct
+{
+  SERVETUNE tunes[SERVE_MAXTUNES];
+  int current;
+  int nexthandle;
+  unsigned clock;
+} SERVESTATE;
+
+static void closetune(SERVETUNE *tune)
+{
+  if (!tune->handle) return;
+  sidimage_free(&tune->image);
+  free(tune->sp);
+  free(tune->checkpoints);
+  memset(tune, 0, sizeof *tune);
+}
+
+// Keep the state before frame sp->frame if it is the next checkpoint
+static void savecheckpoint(SERVETUNE *tune)
+{
+  SIDPLAYER *sp = tune->sp;
+
+  if ((sp->frame % SERVE_INTERVAL) || (sp->frame / SERVE_INTERVAL != tune->numcheckpoints)) return;
+  if (tune->numcheckpoints == tune->maxcheckpoints)
+  {
+    int newmax = tune->maxcheckpoints ? tune->maxcheckpoints * 2 : 8;
+    SIDPLAYER *grown = realloc(tune->checkpoints, newmax * sizeof(SIDPLAYER));
+    if (!grown) return;
+    tune->checkpoints = grown;
+    tune->maxcheckpoints = newmax;
+  }
+  memcpy(&tune->checkpoints[tune->numcheckpoints++], sp, sizeof *sp);
+}
+
+// Play one frame, checkpointing on the way. Returns sidplay_frame()'s result.
+static int playframe(SERVETUNE *tune)
+{
+  savecheckpoint(tune);
+  return sidplay_frame(tune->sp);
+}
+
+static void restorecheckpoint(SERVETUNE *tune, int index)
+{
+  memcpy(tune->sp, &tune->checkpoints[index], sizeof *tune->sp);
+  tune->sp->cpu.mem = tune->sp->mem;
+}
+
+// Move to frame: from the nearest checkpoint at or before it, unless
+// playing on from the current position is closer. Returns 0 on success.
+static int seektune(SERVETUNE *tune, int frame, char *error, int errorsize)
+{
+  SIDPLAYER *sp = tune->sp;
+  int index = frame / SERVE_INTERVAL;
+  int result;
+
+  if (index >= tune->numcheckpoints) index = tune->numcheckpoints - 1;
+  if ((frame < sp->frame) || (tune->checkpoints[index].frame > sp->frame)) restorecheckpoint(tune, index);
+  while (sp->frame < frame)
+  {
+    if ((result = playframe(tune)))
+    {
+      snprintf(error, errorsize, "%s in playroutine at frame %d", (result == SIDPLAY_LIMIT) ?
+        "Abnormally high amount of instructions" : "CPU error", sp->frame);
+      return 1;
+    }
+  }
+  return 0;
+}
+
+// Integer field that may be left out: 0 with *value set or kept, 1 with
+// an error reply if it is there but not an integer
+static int optionalnumber(const NDJSONREQUEST *req, FILE *out, const char *key, long *value)
+{
+  if (ndjson_number(req, key, value) != NDJSON_INVALID) return 0;
+  ndjson_error(out, req, "%s must be an integer", key);
+  return 1;
+}
+
+// Integer field that must be there: 0 with *value set, 1 with an error reply
+static int requirednumber(const NDJSONREQUEST *req, FILE *out, const char *key, long *value, const char *cmd)
+{
+  int result = ndjson_number(req, key, value);
+
+  if (!result) return 0;
+  if (result == NDJSON_INVALID) ndjson_error(out, req, "%s must be an integer", key);
+  else ndjson_error(out, req, "%s needs a %s", cmd, key);
+  return 1;
+}
+
+static SERVETUNE *findtune(SERVESTATE *state, const NDJSONREQUEST *req, FILE *out)
+{
+  long handle = state->current;
+  int c;
+
+  if (optionalnumber(req, out, "tune", &handle)) return NULL;
+  for (c = 0; c < SERVE_MAXTUNES; c++)
+  {
+    if ((handle) && (state->tunes[c].handle == handle))
+    {
+      state->tunes[c].lastuse = ++state->clock;
+      return &state->tunes[c];
+    }
+  }
+  ndjson_error(out, req, handle ? "No tune %ld loaded" : "No tune loaded", handle);
+  return NULL;
+}
+
+static void replytune(FILE *out, const NDJSONREQUEST *req, const SERVETUNE *tune, int cached)
+{
+  ndjson_begin(out, req, 1);
+  fprintf(out, ", \"tune\": %d, \"cached\": %s, \"songs\": %d, \"subtune\": %d, \"loadaddress\": %u, "
+    "\"initaddress\": %u, \"playaddress\": %u, \"frame\": %d", tune->handle, cached ? "true" : "false",
+    tune->image.songs, tune->subtune, tune->image.loadaddress, tune->image.initaddress,
+    tune->sp->playaddress, tune->sp->frame);
+  ndjson_end(out);
+}
+
+static void serveload(SERVESTATE *state, const NDJSONREQUEST *req, FILE *out)
+{
+  const char *name = ndjson_string(req, "file");
+  SERVETUNE *tune = NULL;
+  SIDIMAGE image;
+  SIDPLAYER *sp;
+  long subtune = 0;
+  char error[128];
+  int c;
+
+  if (!name)
+  {
+    ndjson_error(out, req, "load needs a file");
+    return;
+  }
+  if (optionalnumber(req, out, "subtune", &subtune)) return;
+  if (subtune < 0)
+  {
+    ndjson_error(out, req, "subtune must not be negative");
+    return;
+  }
+
+  // Still open: reuse it, including its position and checkpoints
+  for (c = 0; c < SERVE_MAXTUNES; c++)
+  {
+    if ((state->tunes[c].handle) && (state->tunes[c].subtune == subtune) && (!strcmp(state->tunes[c].name, name)))
+    {
+      tune = &state->tunes[c];
+      tune->lastuse = ++state->clock;
+      state->current = tune->handle;
+      replytune(out, req, tune, 1);
+      return;
+    }
+  }
+
+  if (sidimage_load(name, &image, error, sizeof error))
+  {
+    ndjson_error(out, req, "%s", error);
+    return;
+  }
+  if (subtune >= image.songs)
+  {
+    ndjson_error(out, req, "subtune must be 0-%d", image.songs - 1);
+    sidimage_free(&image);
+    return;
+  }
+  sp = malloc(sizeof(SIDPLAYER));
+  if (!sp)
+  {
+    sidimage_free(&image);
+    ndjson_error(out, req, "Out of memory");
+    return;
+  }
+  if (sidplay_init(sp, &image, subtune))
+  {
+    ndjson_error(out, req, "CPU error in init at $%04X", sp->cpu.errorpc);
+    sidimage_free(&image);
+    free(sp);
+    return;
+  }
+
+  // A free slot, or the least recently used tune's
+  for (c = 0; c < SERVE_MAXTUNES; c++)
+  {
+    if (!state->tunes[c].handle)
+    {
+      tune = &state->tunes[c];
+      break;
+    }
+    if ((!tune) || (state->tunes[c].lastuse < tune->lastuse)) tune = &state->tunes[c];
+  }
+  closetune(tune);
+  snprintf(tune->name, sizeof tune->name, "%s", name);
+  tune->subtune = subtune;
+  tune->image = image;
+  tune->sp = sp;
+  tune->sp->cpu.mem = tune->sp->mem;
+  tune->handle = ++state->nexthandle;
+  tune->lastuse = ++state->clock;
+  savecheckpoint(tune);
+  state->current = tune->handle;
+  replytune(out, req, tune, 0);
+}
+
+static void serveseek(SERVESTATE *state, const NDJSONREQUEST *req, FILE *out)
+{
+  SERVETUNE *tune = findtune(state, req, out);
+  char error[128];
+  long frame;
+
+  if (!tune) return;
+  if (requirednumber(req, out, "frame", &frame, "seek")) return;
+  if ((frame < 0) || (frame > SERVE_MAXFRAMES))
+  {
+    ndjson_error(out, req, "frame must be 0-%d", SERVE_MAXFRAMES);
+    return;
+  }
+  if (seektune(tune, frame, error, sizeof error))
+  {
+    ndjson_error(out, req, "%s", error);
+    return;
+  }
+  ndjson_begin(out, req, 1);
+  fprintf(out, ", \"frame\": %d", tune->sp->frame);
+  ndjson_end(out);
+}
+
+// Play count frames: $D400-$D418 after each call as 50 hex digits, and the
+// call's cycles. A failing frame ends the lists and is reported as error.
+static void serveframes(SERVESTATE *state, const NDJSONREQUEST *req, FILE *out)
+{
+  SERVETUNE *tune = findtune(state, req, out);
+  unsigned *cycles;
+  char error[128];
+  long count = 1;
+  long frame;
+  int first;
+  int result = 0;
+  int c;
+  int r;
+
+  if (!tune) return;
+  if ((optionalnumber(req, out, "count", &count)) || (optionalnumber(req, out, "frame", &frame))) return;
+  if ((count < 1) || (count > SERVE_MAXFRAMES))
+  {
+    ndjson_error(out, req, "count must be 1-%d", SERVE_MAXFRAMES);
+    return;
+  }
+  if (!ndjson_number(req, "frame", &frame))
+  {
+    if ((frame < 0) || (frame > SERVE_MAXFRAMES))
+    {
+      ndjson_error(out, req, "frame must be 0-%d", SERVE_MAXFRAMES);
+      return;
+    }
+    if (seektune(tune, frame, error, sizeof error))
+    {
+      ndjson_error(out, req, "%s", error);
+      return;
+    }
+  }
+  cycles = malloc(count * sizeof(unsigned));
+  if (!cycles)
+  {
+    ndjson_error(out, req, "Out of memory");
+    return;
+  }
+
+  first = tune->sp->frame;
+  ndjson_begin(out, req, 1);
+  fprintf(out, ", \"frame\": %d, \"regs\": [", first);
+  for (c = 0; c < count; c++)
+  {
+    if ((result = playframe(tune))) break;
+    cycles[c] = tune->sp->cpu.cpucycles;
+    fputs(c ? ", \"" : "\"", out);
+    for (r = 0; r < 25; r++) fprintf(out, "%02x", tune->sp->mem[0xd400 + r]);
+    fputc('"', out);
+  }
+  fputs("], \"cycles\": [", out);
+  for (r = 0; r < c; r++) fprintf(out, r ? ", %u" : "%u", cycles[r]);
+  fputc(']', out);
+  free(cycles);
+  if (result)
+  {
+    fputs(", \"error\": ", out);
+    ndjson_writestring(out, (result == SIDPLAY_LIMIT) ? "Abnormally high amount of instructions in playroutine" :
+      "CPU error in playroutine");
+  }
+  ndjson_end(out);
+}
+
+// C64 memory as it is at the current frame, as hex
+static void servepeek(SERVESTATE *state, const NDJSONREQUEST *req, FILE *out)
+{
+  SERVETUNE *tune = findtune(state, req, out);
+  long address;
+  long length = 1;
+  long c;
+
+  if (!tune) return;
+  if ((optionalnumber(req, out, "length", &length)) || (requirednumber(req, out, "address", &address, "peek"))) return;
+  if ((address < 0) || (length < 1) || (address > 0xffff) || (length > 0x10000 - address))
+  {
+    ndjson_error(out, req, "peek needs an address and length inside $0000-$FFFF");
+    return;
+  }
+  ndjson_begin(out, req, 1);
+  fprintf(out, ", \"address\": %ld, \"data\": \"", address);
+  for (c = 0; c < length; c++) fprintf(out, "%02x", tune->sp->mem[address + c]);
+  fputc('"', out);
+  ndjson_end(out);
+}
+
+static void serveunload(SERVESTATE *state, const NDJSONREQUEST *req, FILE *out)
+{
+  SERVETUNE *tune = findtune(state, req, out);
+
+  if (!tune) return;
+  if (tune->handle == state->current) state->current = 0;
+  closetune(tune);
+  ndjson_begin(out, req, 1);
+  ndjson_end(out);
+}
+
+int sidserve(FILE *in, FILE *out)
+{
+  SERVESTATE *state = calloc(1, sizeof(SERVESTATE));
+  char line[SERVE_LINESIZE];
+  NDJSONREQUEST req;
+  int c;
+
+  if (!state)
+  {
+    ndjson_error(out, NULL, "Out of memory");
+    return 1;
+  }
+  while (fgets(line, sizeof line, in))
+  {
+    const char *cmd;
+
+    if (!line[strspn(line, " \t\r\n")]) continue;
+    if (!strchr(line, '\n') && !feof(in))
+    {
+      // Longer than any valid request: drop the rest of it
+      int ch;
+      while (((ch = fgetc(in)) != EOF) && (ch != '\n'))
+        ;
+      ndjson_error(out, NULL, "Request too long");
+      continue;
+    }
+    if (ndjson_parse(line, &req))
+    {
+      ndjson_error(out, NULL, "Malformed request");
+      continue;
+    }
+    cmd = ndjson_string(&req, "cmd");
+    if (!cmd)
+      ndjson_error(out, &req, "Request has no cmd");
+    else if (!strcmp(cmd, "load"))
+      serveload(state, &req, out);
+    else if (!strcmp(cmd, "seek"))
+      serveseek(state, &req, out);
+    else if (!strcmp(cmd, "frames"))
+      serveframes(state, &req, out);
+    else if (!strcmp(cmd, "peek"))
+      servepeek(state, &req, out);
+    else if (!strcmp(cmd, "unload"))
+      serveunload(state, &req, out);
+    else if (!strcmp(cmd, "quit"))
+    {
+      ndjson_begin(out, &req, 1);
+      ndjson_end(out);
+      break;
+    }
+    else
+      ndjson_error(out, &req, "Unknown cmd %s", cmd);
+  }
+  for (c = 0; c < SERVE_MAXTUNES; c++) closetune(&state->tunes[c]);
+  free(state);
+  return 0;
+}
@@ -0,0 +1,10 @@
+#ifndef SIDSERVE_H
+#define SIDSERVE_H
+
+#include <stdio.h>
+
+// siddump -serve: newline-delimited JSON requests on in, one reply line
+// each on out, until quit or end of input. Returns the exit code.
+int sidserve(FILE *in, FILE *out);
+
+#endif
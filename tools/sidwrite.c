@@ -0,0 +1,64 @@
+#include <stdlib.h>
+#include <string.h>
+#include "sidwrite.h"
+
+// Create the write stream file and write the header. Returns 0 on success.
+int sidwrite_open(SIDWRITEBUF *buf, const char *filename, int subtune)
+{
+  memset(buf, 0, sizeof *buf);
+  memcpy(buf->header.magic, SIDWRITE_MAGIC, 4);
+  buf->header.version = SIDWRITE_VERSION;
+  buf->header.headersize = sizeof(SIDWRITEHEADER);
+  buf->header.recordsize = sizeof(SIDWRITERECORD);
+  buf->header.subtune = subtune;
+  buf->header.frameperiod = SIDWRITE_PALPERIOD;
+  buf->header.clockrate = SIDWRITE_PALCLOCK;
+
+  buf->records = malloc(SIDWRITE_RECORDS * sizeof(SIDWRITERECORD));
+  if (!buf->records) return 1;
+  buf->out = fopen(filename, "wb");
+  if (!buf->out)
+  {
+    free(buf->records);
+    buf->records = NULL;
+    return 1;
+  }
+  if (fwrite(&buf->header, sizeof buf->header, 1, buf->out) != 1) buf->error = 1;
+  return 0;
+}
+
+// Start play call frame: its writes are stamped from (frame + 1) periods on
+void sidwrite_frame(SIDWRITEBUF *buf, unsigned frame)
+{
+  buf->framebase = (frame + 1) * buf->header.frameperiod;
+  buf->header.framecount = frame + 1;
+}
+
+// Write out the buffered records
+void sidwrite_flush(SIDWRITEBUF *buf)
+{
+  if (!buf->numrecords) return;
+  if (fwrite(buf->records, sizeof(SIDWRITERECORD), buf->numrecords, buf->out) != buf->numrecords)
+    buf->error = 1;
+  buf->header.recordcount += buf->numrecords;
+  buf->numrecords = 0;
+}
+
+// Flush, patch the counts into the header and close the file.
+// Returns 0 if everything was written.
+int sidwrite_close(SIDWRITEBUF *buf)
+{
+  int error;
+
+  if (!buf->out) return 1;
+  sidwrite_flush(buf);
+  if (!fseek(buf->out, 0, SEEK_SET))
+  {
+    if (fwrite(&buf->header, sizeof buf->header, 1, buf->out) != 1) buf->error = 1;
+  }
+  if (fclose(buf->out)) buf->error = 1;
+  free(buf->records);
+  error = buf->error;
+  memset(buf, 0, sizeof *buf);
+  return error;
+}
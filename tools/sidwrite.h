@@ -0,0 +1,45 @@
+#ifndef SIDWRITE_H
+#define SIDWRITE_H
+
+#include <stdio.h>
+#include "dumpformat.h"
+
+// Records buffered in memory before a block is written
+#define SIDWRITE_RECORDS 65536
+
+// SID register write stream sink. Writes are collected in a fixed buffer
+// and written in blocks of SIDWRITE_RECORDS; sidwrite_close() fills in the
+// header frame and record counts. framebase is the cycle the current call
+// started at, lastcycle the stamp of the last record.
+typedef struct
+{
+  FILE *out;
+  SIDWRITEHEADER header;
+  SIDWRITERECORD *records;
+  unsigned numrecords;
+  uint32_t framebase;
+  uint32_t lastcycle;
+  int error;
+} SIDWRITEBUF;
+
+int sidwrite_open(SIDWRITEBUF *buf, const char *filename, int subtune);
+void sidwrite_frame(SIDWRITEBUF *buf, unsigned frame);
+void sidwrite_flush(SIDWRITEBUF *buf);
+int sidwrite_close(SIDWRITEBUF *buf);
+
+// Record a write made callcycles into the current init or play call
+static inline void sidwrite_add(SIDWRITEBUF *buf, unsigned callcycles, uint8_t reg, uint8_t value)
+{
+  SIDWRITERECORD *rec = &buf->records[buf->numrecords++];
+  uint32_t cycle = buf->framebase + callcycles;
+
+  if (cycle < buf->lastcycle) cycle = buf->lastcycle;
+  buf->lastcycle = cycle;
+  rec->cycle = cycle;
+  rec->reg = reg;
+  rec->value = value;
+  rec->reserved = 0;
+  if (buf->numrecords == SIDWRITE_RECORDS) sidwrite_flush(buf);
+}
+
+#endif
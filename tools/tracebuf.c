@@ -0,0 +1,56 @@
+#include <stdlib.h>
+#include <string.h>
+#include "tracebuf.h"
+
+// Create the trace file and write the header. Returns 0 on success.
+int tracebuf_open(TRACEBUF *buf, const char *filename, const TRACEHEADER *header)
+{
+  memset(buf, 0, sizeof *buf);
+  buf->header = *header;
+  memcpy(buf->header.magic, TRACE_MAGIC, 4);
+  buf->header.version = TRACE_VERSION;
+  buf->header.headersize = sizeof(TRACEHEADER);
+  buf->header.recordsize = sizeof(TRACERECORD);
+  buf->header.recordcount = 0;
+
+  buf->records = malloc(TRACEBUF_RECORDS * sizeof(TRACERECORD));
+  if (!buf->records) return 1;
+  buf->out = fopen(filename, "wb");
+  if (!buf->out)
+  {
+    free(buf->records);
+    buf->records = NULL;
+    return 1;
+  }
+  if (fwrite(&buf->header, sizeof buf->header, 1, buf->out) != 1) buf->error = 1;
+  return 0;
+}
+
+// Write out the buffered records
+void tracebuf_flush(TRACEBUF *buf)
+{
+  if (!buf->numrecords) return;
+  if (fwrite(buf->records, sizeof(TRACERECORD), buf->numrecords, buf->out) != buf->numrecords)
+    buf->error = 1;
+  buf->header.recordcount += buf->numrecords;
+  buf->numrecords = 0;
+}
+
+// Flush, patch the record count into the header and close the file.
+// Returns 0 if everything was written.
+int tracebuf_close(TRACEBUF *buf)
+{
+  int error;
+
+  if (!buf->out) return 1;
+  tracebuf_flush(buf);
+  if (!fseek(buf->out, 0, SEEK_SET))
+  {
+    if (fwrite(&buf->header, sizeof buf->header, 1, buf->out) != 1) buf->error = 1;
+  }
+  if (fclose(buf->out)) buf->error = 1;
+  free(buf->records);
+  error = buf->error;
+  memset(buf, 0, sizeof *buf);
+  return error;
+}
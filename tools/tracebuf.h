@@ -0,0 +1,39 @@
+#ifndef TRACEBUF_H
+#define TRACEBUF_H
+
+#include <stdio.h>
+#include "dumpformat.h"
+
+// Records buffered in memory before a block is written
+#define TRACEBUF_RECORDS 65536
+
+// Binary memory access trace sink. Records are collected in a fixed buffer
+// and written in blocks of TRACEBUF_RECORDS; tracebuf_close() fills in the
+// header record count.
+typedef struct
+{
+  FILE *out;
+  TRACEHEADER header;
+  TRACERECORD *records;
+  unsigned numrecords;
+  int error;
+} TRACEBUF;
+
+int tracebuf_open(TRACEBUF *buf, const char *filename, const TRACEHEADER *header);
+void tracebuf_flush(TRACEBUF *buf);
+int tracebuf_close(TRACEBUF *buf);
+
+static inline void tracebuf_add(TRACEBUF *buf, uint32_t frame, uint16_t pc, uint16_t address, uint8_t value, uint8_t flags)
+{
+  TRACERECORD *rec = &buf->records[buf->numrecords++];
+
+  rec->frame = frame;
+  rec->pc = pc;
+  rec->address = address;
+  rec->value = value;
+  rec->flags = flags;
+  rec->reserved = 0;
+  if (buf->numrecords == TRACEBUF_RECORDS) tracebuf_flush(buf);
+}
+
+#endif